@@ -52,6 +52,11 @@ size_t dap_enc_decode(dap_enc_key_t *a_key, // Key
                       void * a_buf_out, const size_t a_buf_out_size_max, // Output
                      dap_enc_data_type_t a_data_type_in); // Output data type
 
+// Plaintext is at a_buf + dap_enc_key_get_inplace_headroom(), encrypted data replaces it from a_buf start
+size_t dap_enc_code_inplace(dap_enc_key_t *a_key, void *a_buf, const size_t a_data_size, const size_t a_buf_size);
+// Encrypted data at a_buf is replaced with plaintext from a_buf start
+size_t dap_enc_decode_inplace(dap_enc_key_t *a_key, void *a_buf, const size_t a_buf_size);
+
 #ifdef __cplusplus
 }
 #endif
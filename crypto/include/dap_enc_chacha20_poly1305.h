@@ -0,0 +1,38 @@
+#ifndef _DAP_ENC_CHACHA20_POLY1305_H_
+#define _DAP_ENC_CHACHA20_POLY1305_H_
+
+#include <stddef.h>
+#include "dap_enc_key.h"
+
+// Encrypted data is nonce || ciphertext || tag
+#define DAP_ENC_CHACHA20_POLY1305_NONCE_SIZE    12
+#define DAP_ENC_CHACHA20_POLY1305_TAG_SIZE      16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void dap_enc_chacha20_poly1305_key_new(struct dap_enc_key *a_key);
+void dap_enc_chacha20_poly1305_key_delete(struct dap_enc_key *a_key);
+void dap_enc_chacha20_poly1305_key_generate(struct dap_enc_key *a_key, const void *kex_buf,
+        size_t kex_size, const void *seed, size_t seed_size, size_t key_size);
+
+size_t dap_enc_chacha20_poly1305_calc_encode_size(const size_t size_in);
+size_t dap_enc_chacha20_poly1305_calc_decode_size(const size_t size_in);
+
+size_t dap_enc_chacha20_poly1305_encrypt(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void **a_out);
+size_t dap_enc_chacha20_poly1305_decrypt(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void **a_out);
+
+// Writes result ( out ) in already allocated buffer, a_in could be a_out + DAP_ENC_CHACHA20_POLY1305_NONCE_SIZE for in-place encryption
+size_t dap_enc_chacha20_poly1305_encrypt_fast(struct dap_enc_key *a_key, const void *a_in,
+        size_t a_in_size, void *a_out, size_t a_out_size);
+// Writes result ( out ) in already allocated buffer, returns 0 if authentication tag mismatch.
+// a_out could be a_in or a_in + DAP_ENC_CHACHA20_POLY1305_NONCE_SIZE for in-place decryption
+size_t dap_enc_chacha20_poly1305_decrypt_fast(struct dap_enc_key *a_key, const void *a_in,
+        size_t a_in_size, void *a_out, size_t a_out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
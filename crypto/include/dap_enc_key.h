@@ -117,6 +117,9 @@ typedef enum dap_enc_key_type {
     DAP_ENC_KEY_TYPE_SIG_ECDSA = 26,
     DAP_ENC_KEY_TYPE_SIG_SHIPOVNIK=27,
 
+    DAP_ENC_KEY_TYPE_AES256_GCM = 28, // AEAD, AES-NI and PCLMULQDQ accelerated when CPU supports
+    DAP_ENC_KEY_TYPE_CHACHA20_POLY1305 = 29, // AEAD, RFC 8439
+
     DAP_ENC_KEY_TYPE_SIG_MULTI_ECDSA_DILITHIUM = 99,
     DAP_ENC_KEY_TYPE_SIG_MULTI_CHAINED = 100,
 
@@ -257,6 +260,8 @@ typedef struct dap_enc_key_callbacks{
 
     dap_enc_callback_calc_out_size enc_out_size;
     dap_enc_callback_calc_out_size dec_out_size;
+    // Bytes reserved ahead of plaintext for in-place encryption, 0 if cipher can't work in place
+    size_t inplace_headroom;
 
     dap_enc_gen_bob_shared_key gen_bob_shared_key;
     dap_enc_gen_alice_shared_key gen_alice_shared_key;
@@ -295,6 +300,8 @@ const char *dap_enc_get_type_name(dap_enc_key_type_t a_key_type);
 dap_enc_key_type_t dap_enc_key_type_find_by_name(const char *a_name);
 size_t dap_enc_key_get_enc_size(dap_enc_key_type_t a_key_type, const size_t a_buf_in_size);
 size_t dap_enc_key_get_dec_size(dap_enc_key_type_t a_key_type, const size_t a_buf_in_size);
+size_t dap_enc_key_get_inplace_headroom(dap_enc_key_type_t a_key_type);
+size_t dap_enc_key_get_inplace_tailroom(dap_enc_key_type_t a_key_type);
 size_t dap_enc_calc_signature_unserialized_size(dap_enc_key_t *a_key);
 
 uint8_t* dap_enc_key_serialize_sign(dap_enc_key_type_t a_key_type, uint8_t *a_sign, size_t *a_sign_len);
@@ -5,6 +5,9 @@
 #include "dap_enc_key.h"
 #include "salsa2012/crypto_stream_salsa2012.h"
 
+// Nonce goes ahead of ciphertext, it's the headroom for in-place encryption
+#define DAP_ENC_SALSA2012_NONCE_SIZE 8
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,10 +23,10 @@ size_t dap_enc_salsa2012_calc_encode_size(const size_t size_in);
 size_t dap_enc_salsa2012_decrypt(struct dap_enc_key * a_key, const void * a_in, size_t a_in_size, void ** a_out);
 size_t dap_enc_salsa2012_encrypt(struct dap_enc_key * a_key, const void * a_in, size_t a_in_size, void ** a_out);
 
-// Writes result ( out ) in already allocated buffer
+// Writes result ( out ) in already allocated buffer, a_out could be a_in or a_in + DAP_ENC_SALSA2012_NONCE_SIZE
 size_t dap_enc_salsa2012_decrypt_fast(struct dap_enc_key * a_key, const void * a_in,
         size_t a_in_size, void * buf_out, size_t buf_out_size);
-// Writes result ( out ) in already allocated buffer
+// Writes result ( out ) in already allocated buffer, a_in could be a_out + DAP_ENC_SALSA2012_NONCE_SIZE
 size_t dap_enc_salsa2012_encrypt_fast(struct dap_enc_key * a_key, const void * a_in,
         size_t a_in_size, void * buf_out, size_t buf_out_size);
 
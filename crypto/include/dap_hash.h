@@ -57,6 +57,7 @@ extern "C" {
 int dap_chain_hash_fast_from_str( const char * a_hash_str, dap_hash_fast_t *a_hash);
 int dap_chain_hash_fast_from_hex_str( const char *a_hex_str, dap_chain_hash_fast_t *a_hash);
 int dap_chain_hash_fast_from_base58_str(const char *a_base58_str,  dap_chain_hash_fast_t *a_hash);
+bool dap_hash_fast_batch(const void * const *a_data_in, const size_t *a_data_in_size, dap_hash_fast_t *a_hash_out, size_t a_count);
 /**
  * @brief
  * get SHA3_256 hash for specific data
@@ -0,0 +1,28 @@
+#ifndef _DAP_PQ_IMPL_H_
+#define _DAP_PQ_IMPL_H_
+
+#include <stdbool.h>
+
+// Implementation of Kyber, Dilithium and Falcon inner loops (NTT, polynomial arithmetic, sampling)
+typedef enum dap_pq_impl {
+    DAP_PQ_IMPL_AUTO = 0,   // The fastest one CPU supports
+    DAP_PQ_IMPL_REF,        // Portable C
+    DAP_PQ_IMPL_AVX2        // x86-64 AVX2, BMI2 and POPCNT
+} dap_pq_impl_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool dap_pq_impl_supported(dap_pq_impl_t a_impl);
+// Force the implementation, for tests and benchmarks. Returns -1 if it's not supported by the build or CPU
+int dap_pq_impl_set(dap_pq_impl_t a_impl);
+// Implementation in use, never DAP_PQ_IMPL_AUTO
+dap_pq_impl_t dap_pq_impl_get(void);
+const char *dap_pq_impl_to_str(dap_pq_impl_t a_impl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
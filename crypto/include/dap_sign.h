@@ -89,12 +89,23 @@ typedef struct dap_sign
 typedef struct dap_pkey dap_pkey_t;
 typedef dap_pkey_t *(*dap_sign_callback_t)(const uint8_t *);
 
+// Item of signatures batch verification
+typedef struct dap_sign_verify_item {
+    dap_sign_t *sign;
+    const void *data;
+    size_t data_size;
+    dap_pkey_t *pkey;   // pkey to verify sign, NULL to use one from the sign
+    int result;         // output, 0 valid signature, else error code of dap_sign_verify_by_pkey()
+} dap_sign_verify_item_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
 int dap_sign_init(uint8_t a_sign_hash_type_default);
+void dap_sign_deinit();
+void dap_sign_pkey_cache_set_size(size_t a_size);
 
 uint64_t dap_sign_get_size(dap_sign_t * a_chain_sign);
 int dap_sign_verify_by_pkey(dap_sign_t *a_chain_sign, const void *a_data, const size_t a_data_size, dap_pkey_t *a_pkey);
@@ -102,6 +113,8 @@ DAP_STATIC_INLINE int dap_sign_verify (dap_sign_t *a_chain_sign, const void *a_d
 {
     return dap_sign_verify_by_pkey(a_chain_sign, a_data, a_data_size, NULL);
 }
+size_t dap_sign_verify_batch(dap_sign_verify_item_t *a_items, size_t a_count);
+void dap_sign_verify_batch_set_threads(uint32_t a_threads_count);
 
 /**
  * @brief verify, if a_sign->header.sign_pkey_size and a_sign->header.sign_size bigger, then a_max_key_size
@@ -4,7 +4,7 @@
 #include "indcpa.h"
 #include "poly.h"
 #include "polyvec.h"
-#include "rng.h"
+#include "rand/dap_rand.h"
 #include "ntt.h"
 #include "symmetric.h"
 #include "rejsample.h"
@@ -2,7 +2,7 @@
 #include <stdint.h>
 #include "kem.h"
 #include "params.h"
-#include "rng.h"
+#include "rand/dap_rand.h"
 #include "symmetric.h"
 #include "verify.h"
 #include "indcpa.h"
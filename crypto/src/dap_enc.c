@@ -63,6 +63,7 @@ int dap_enc_init()
 void dap_enc_deinit()
 {
     dap_cert_deinit();
+    dap_sign_deinit();
 }
 
 bool dap_enc_debug_more()
@@ -118,10 +119,12 @@ size_t dap_enc_code(dap_enc_key_t *a_key,
         break;
     case DAP_ENC_DATA_TYPE_B64:
     case DAP_ENC_DATA_TYPE_B64_URLSAFE: {
-        char *l_tmp_buf = DAP_NEW_Z_SIZE(char, l_ret);
-        size_t l_tmp_size = a_key->enc_na(a_key, a_buf_in, a_buf_size, l_tmp_buf, l_ret);
-        l_ret = dap_enc_base64_encode(l_tmp_buf, l_tmp_size, a_buf_out, a_data_type_out);
-        DAP_DELETE(l_tmp_buf);
+        // Encrypted data is put to the tail of output buffer, base64 encoder writes 4 bytes only after 3 bytes are read
+        // so it never overtakes its input moved forward for a third of encrypted size
+        size_t l_enc_size = dap_enc_key_get_enc_size(a_key->type, a_buf_size);
+        char *l_tmp_buf = (char*)a_buf_out + l_ret - l_enc_size;
+        size_t l_tmp_size = a_key->enc_na(a_key, a_buf_in, a_buf_size, l_tmp_buf, l_enc_size);
+        l_ret = l_tmp_size ? dap_enc_base64_encode(l_tmp_buf, l_tmp_size, a_buf_out, a_data_type_out) : 0;
     } break;
     default:
         log_it(L_ERROR, "Unknown enc type %d", (int)a_data_type_out);
@@ -154,6 +157,12 @@ size_t dap_enc_decode(dap_enc_key_t *a_key,
         break;
     case DAP_ENC_DATA_TYPE_B64:
     case DAP_ENC_DATA_TYPE_B64_URLSAFE: {
+        if ( dap_enc_key_get_inplace_headroom(a_key->type) && a_buf_out_size_max >= DAP_ENC_BASE64_DECODE_SIZE(a_buf_in_size) ) {
+            // Decode base64 right to the output and decrypt it there
+            size_t l_tmp_size = dap_enc_base64_decode(a_buf_in, a_buf_in_size, a_buf_out, a_data_type_in);
+            l_ret = dap_enc_decode_inplace(a_key, a_buf_out, l_tmp_size);
+            break;
+        }
         char *l_tmp_buf = DAP_NEW_Z_SIZE(char, DAP_ENC_BASE64_DECODE_SIZE(a_buf_in_size));
         size_t l_tmp_size = dap_enc_base64_decode(a_buf_in, a_buf_in_size, l_tmp_buf, a_data_type_in);
         l_ret = a_key->dec_na(a_key, l_tmp_buf, l_tmp_size, a_buf_out, a_buf_out_size_max);
@@ -165,3 +174,55 @@ size_t dap_enc_decode(dap_enc_key_t *a_key,
     }
     return l_ret;
 }
+
+/**
+ * @brief dap_enc_code_inplace encrypt data without extra buffer. Plaintext must be placed at
+ * a_buf + dap_enc_key_get_inplace_headroom(), a_buf must be large enough for dap_enc_code_out_size() bytes.
+ * Ciphers without in-place support have no headroom and are processed with temporary copy of plaintext
+ * @param a_key key
+ * @param a_buf buffer with plaintext
+ * @param a_data_size plaintext size
+ * @param a_buf_size whole a_buf size
+ * @return encrypted data size, it starts from a_buf
+ */
+size_t dap_enc_code_inplace(dap_enc_key_t *a_key, void *a_buf, const size_t a_data_size, const size_t a_buf_size)
+{
+    dap_return_val_if_fail_err(a_key && a_key->enc_na && a_buf && a_data_size, 0, "Invalid params");
+    size_t l_ret = dap_enc_key_get_enc_size(a_key->type, a_data_size),
+           l_headroom = dap_enc_key_get_inplace_headroom(a_key->type);
+    if ( !l_ret || l_ret > a_buf_size )
+        return log_it(L_ERROR, "Insufficient buffer size: %zu < %zu", a_buf_size, l_ret), 0;
+    if (l_headroom)
+        return a_key->enc_na(a_key, (byte_t*)a_buf + l_headroom, a_data_size, a_buf, a_buf_size);
+    byte_t *l_tmp_buf = DAP_DUP_SIZE(a_buf, a_data_size);
+    if (!l_tmp_buf)
+        return log_it(L_CRITICAL, "%s", c_error_memory_alloc), 0;
+    l_ret = a_key->enc_na(a_key, l_tmp_buf, a_data_size, a_buf, a_buf_size);
+    DAP_DELETE(l_tmp_buf);
+    return l_ret;
+}
+
+/**
+ * @brief dap_enc_decode_inplace decrypt data without extra buffer, plaintext overwrites encrypted data.
+ * Ciphers without in-place support are processed with temporary buffer for plaintext
+ * @param a_key key
+ * @param a_buf buffer with encrypted data
+ * @param a_buf_size encrypted data size
+ * @return plaintext size, it starts from a_buf. 0 if data can't be decrypted
+ */
+size_t dap_enc_decode_inplace(dap_enc_key_t *a_key, void *a_buf, const size_t a_buf_size)
+{
+    dap_return_val_if_fail_err(a_key && a_key->dec_na && a_buf && a_buf_size, 0, "Invalid params");
+    size_t l_ret = dap_enc_key_get_dec_size(a_key->type, a_buf_size);
+    if (!l_ret)
+        return 0;
+    if ( dap_enc_key_get_inplace_headroom(a_key->type) )
+        return a_key->dec_na(a_key, a_buf, a_buf_size, a_buf, a_buf_size);
+    byte_t *l_tmp_buf = DAP_NEW_Z_SIZE(byte_t, l_ret);
+    if (!l_tmp_buf)
+        return log_it(L_CRITICAL, "%s", c_error_memory_alloc), 0;
+    if (( l_ret = a_key->dec_na(a_key, a_buf, a_buf_size, l_tmp_buf, l_ret) ))
+        memcpy(a_buf, l_tmp_buf, l_ret);
+    DAP_DELETE(l_tmp_buf);
+    return l_ret;
+}
@@ -0,0 +1,627 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dap_enc_aes_gcm.h"
+#include "dap_common.h"
+#include "rand/dap_rand.h"
+#include "KeccakHash.h"
+
+#define LOG_TAG "dap_enc_aes_gcm"
+
+#define AES_GCM_KEY_SIZE    32
+#define AES_GCM_NONCE_SIZE  DAP_ENC_AES_GCM_NONCE_SIZE
+#define AES_GCM_TAG_SIZE    DAP_ENC_AES_GCM_TAG_SIZE
+#define AES_GCM_OVERHEAD    (AES_GCM_NONCE_SIZE + AES_GCM_TAG_SIZE)
+#define AES_GCM_ROUNDS      14
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AES_GCM_HW
+#define AES_GCM_HW_TARGET "aes,pclmul,ssse3,sse4.1"
+#include <immintrin.h>
+#endif
+
+typedef struct aes_gcm_ctx {
+    uint8_t round_keys[(AES_GCM_ROUNDS + 1) * 16];
+    uint64_t hl[16], hh[16];        // Shoup's 4-bit GHASH tables, portable path
+    uint8_t h_pow[4][16];           // H^1..H^4 byte reflected, PCLMUL path
+    bool hw;
+} aes_gcm_ctx_t;
+
+static const uint8_t s_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static const uint64_t s_ghash_last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+static inline uint64_t s_get_be64(const uint8_t *a_buf)
+{
+    uint64_t l_ret = 0;
+    for (int i = 0; i < 8; i++)
+        l_ret = (l_ret << 8) | a_buf[i];
+    return l_ret;
+}
+
+static inline void s_put_be64(uint8_t *a_buf, uint64_t a_val)
+{
+    for (int i = 7; i >= 0; i--, a_val >>= 8)
+        a_buf[i] = (uint8_t)a_val;
+}
+
+static inline void s_put_be32(uint8_t *a_buf, uint32_t a_val)
+{
+    a_buf[0] = a_val >> 24; a_buf[1] = a_val >> 16; a_buf[2] = a_val >> 8; a_buf[3] = a_val;
+}
+
+static inline uint8_t s_xtime(uint8_t a_val)
+{
+    return (uint8_t)(a_val << 1) ^ (a_val & 0x80 ? 0x1b : 0);
+}
+
+static void s_aes256_key_expand(const uint8_t *a_key, uint8_t *a_round_keys)
+{
+    uint8_t l_rcon = 1;
+    memcpy(a_round_keys, a_key, AES_GCM_KEY_SIZE);
+    for (unsigned i = AES_GCM_KEY_SIZE; i < (AES_GCM_ROUNDS + 1) * 16; i += 4) {
+        uint8_t l_tmp[4];
+        memcpy(l_tmp, a_round_keys + i - 4, 4);
+        if (i % AES_GCM_KEY_SIZE == 0) {
+            uint8_t l_first = l_tmp[0];
+            l_tmp[0] = s_sbox[l_tmp[1]] ^ l_rcon;
+            l_tmp[1] = s_sbox[l_tmp[2]];
+            l_tmp[2] = s_sbox[l_tmp[3]];
+            l_tmp[3] = s_sbox[l_first];
+            l_rcon = s_xtime(l_rcon);
+        } else if (i % AES_GCM_KEY_SIZE == 16)
+            for (int j = 0; j < 4; j++)
+                l_tmp[j] = s_sbox[l_tmp[j]];
+        for (int j = 0; j < 4; j++)
+            a_round_keys[i + j] = a_round_keys[i + j - AES_GCM_KEY_SIZE] ^ l_tmp[j];
+    }
+}
+
+static void s_aes256_encrypt_block(const uint8_t *a_round_keys, const uint8_t *a_in, uint8_t *a_out)
+{
+    uint8_t l_state[16], l_tmp[16];
+    for (int i = 0; i < 16; i++)
+        l_state[i] = a_in[i] ^ a_round_keys[i];
+    for (int r = 1; r <= AES_GCM_ROUNDS; r++) {
+        // SubBytes and ShiftRows
+        for (int c = 0; c < 4; c++)
+            for (int j = 0; j < 4; j++)
+                l_tmp[c * 4 + j] = s_sbox[l_state[((c + j) % 4) * 4 + j]];
+        // MixColumns, all rounds but the last
+        if (r < AES_GCM_ROUNDS)
+            for (int c = 0; c < 4; c++) {
+                uint8_t *l_col = l_tmp + c * 4, a0 = l_col[0], a1 = l_col[1], a2 = l_col[2], a3 = l_col[3],
+                        l_all = a0 ^ a1 ^ a2 ^ a3;
+                l_col[0] ^= l_all ^ s_xtime(a0 ^ a1);
+                l_col[1] ^= l_all ^ s_xtime(a1 ^ a2);
+                l_col[2] ^= l_all ^ s_xtime(a2 ^ a3);
+                l_col[3] ^= l_all ^ s_xtime(a3 ^ a0);
+            }
+        for (int i = 0; i < 16; i++)
+            l_state[i] = l_tmp[i] ^ a_round_keys[r * 16 + i];
+    }
+    memcpy(a_out, l_state, 16);
+}
+
+static void s_ghash_tables_init(aes_gcm_ctx_t *a_ctx, const uint8_t *a_h)
+{
+    uint64_t l_vh = s_get_be64(a_h), l_vl = s_get_be64(a_h + 8);
+    a_ctx->hl[8] = l_vl;
+    a_ctx->hh[8] = l_vh;
+    a_ctx->hl[0] = a_ctx->hh[0] = 0;
+    for (int i = 4; i > 0; i >>= 1) {
+        uint32_t l_t = (l_vl & 1) * 0xe1000000U;
+        l_vl = (l_vh << 63) | (l_vl >> 1);
+        l_vh = (l_vh >> 1) ^ ((uint64_t)l_t << 32);
+        a_ctx->hl[i] = l_vl;
+        a_ctx->hh[i] = l_vh;
+    }
+    for (int i = 2; i <= 8; i *= 2)
+        for (int j = 1; j < i; j++) {
+            a_ctx->hh[i + j] = a_ctx->hh[i] ^ a_ctx->hh[j];
+            a_ctx->hl[i + j] = a_ctx->hl[i] ^ a_ctx->hl[j];
+        }
+}
+
+// a_x = (a_x ^ a_block) * H
+static void s_ghash_block(const aes_gcm_ctx_t *a_ctx, uint8_t *a_x, const uint8_t *a_block)
+{
+    uint8_t l_x[16];
+    for (int i = 0; i < 16; i++)
+        l_x[i] = a_x[i] ^ a_block[i];
+    uint8_t l_lo = l_x[15] & 0xf;
+    uint64_t l_zh = a_ctx->hh[l_lo], l_zl = a_ctx->hl[l_lo];
+    for (int i = 15; i >= 0; i--) {
+        uint8_t l_hi = l_x[i] >> 4, l_rem;
+        l_lo = l_x[i] & 0xf;
+        if (i != 15) {
+            l_rem = l_zl & 0xf;
+            l_zl = (l_zh << 60) | (l_zl >> 4);
+            l_zh = (l_zh >> 4) ^ (s_ghash_last4[l_rem] << 48) ^ a_ctx->hh[l_lo];
+            l_zl ^= a_ctx->hl[l_lo];
+        }
+        l_rem = l_zl & 0xf;
+        l_zl = (l_zh << 60) | (l_zl >> 4);
+        l_zh = (l_zh >> 4) ^ (s_ghash_last4[l_rem] << 48) ^ a_ctx->hh[l_hi];
+        l_zl ^= a_ctx->hl[l_hi];
+    }
+    s_put_be64(a_x, l_zh);
+    s_put_be64(a_x + 8, l_zl);
+}
+
+static void s_ghash_data(const aes_gcm_ctx_t *a_ctx, uint8_t *a_x, const uint8_t *a_data, size_t a_size)
+{
+    for ( ; a_size >= 16; a_data += 16, a_size -= 16)
+        s_ghash_block(a_ctx, a_x, a_data);
+    if (a_size) {
+        uint8_t l_block[16] = { };
+        memcpy(l_block, a_data, a_size);
+        s_ghash_block(a_ctx, a_x, l_block);
+    }
+}
+
+/**
+ * @brief s_aes_gcm_crypt_soft portable AES-256-GCM, ciphertext is authenticated before it's written or after it's read
+ * so a_out could be the same as a_in or be ahead of it
+ */
+static void s_aes_gcm_crypt_soft(const aes_gcm_ctx_t *a_ctx, const uint8_t *a_nonce, const uint8_t *a_aad, size_t a_aad_size,
+                                 const uint8_t *a_in, size_t a_size, uint8_t *a_out, uint8_t *a_tag, bool a_encrypt)
+{
+    uint8_t l_counter[16], l_stream[16], l_x[16] = { }, l_block[16];
+    memcpy(l_counter, a_nonce, AES_GCM_NONCE_SIZE);
+    if (a_aad_size)
+        s_ghash_data(a_ctx, l_x, a_aad, a_aad_size);
+    uint32_t l_ctr = 2;
+    for (size_t i = 0; i < a_size; i += 16) {
+        size_t l_len = a_size - i < 16 ? a_size - i : 16;
+        s_put_be32(l_counter + 12, l_ctr++);
+        s_aes256_encrypt_block(a_ctx->round_keys, l_counter, l_stream);
+        if (!a_encrypt)
+            s_ghash_data(a_ctx, l_x, a_in + i, l_len);
+        for (size_t j = 0; j < l_len; j++)
+            a_out[i + j] = a_in[i + j] ^ l_stream[j];
+        if (a_encrypt)
+            s_ghash_data(a_ctx, l_x, a_out + i, l_len);
+    }
+    s_put_be64(l_block, (uint64_t)a_aad_size * 8);
+    s_put_be64(l_block + 8, (uint64_t)a_size * 8);
+    s_ghash_block(a_ctx, l_x, l_block);
+    s_put_be32(l_counter + 12, 1);
+    s_aes256_encrypt_block(a_ctx->round_keys, l_counter, l_stream);
+    for (int i = 0; i < AES_GCM_TAG_SIZE; i++)
+        a_tag[i] = l_x[i] ^ l_stream[i];
+}
+
+#ifdef AES_GCM_HW
+
+#define AES_GCM_BSWAP_MASK _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+
+__attribute__((target(AES_GCM_HW_TARGET)))
+static inline void s_clmul_wide(__m128i a_a, __m128i a_b, __m128i *a_lo, __m128i *a_hi)
+{
+    __m128i l_mid = _mm_xor_si128(_mm_clmulepi64_si128(a_a, a_b, 0x10), _mm_clmulepi64_si128(a_a, a_b, 0x01));
+    *a_lo = _mm_xor_si128(_mm_clmulepi64_si128(a_a, a_b, 0x00), _mm_slli_si128(l_mid, 8));
+    *a_hi = _mm_xor_si128(_mm_clmulepi64_si128(a_a, a_b, 0x11), _mm_srli_si128(l_mid, 8));
+}
+
+// Reduction of the 256-bit reflected product modulo GCM polynomial, see Intel's "Carry-Less Multiplication
+// Instruction and its Usage for Computing the GCM Mode" white paper
+__attribute__((target(AES_GCM_HW_TARGET)))
+static inline __m128i s_ghash_reduce(__m128i a_lo, __m128i a_hi)
+{
+    __m128i l_t7 = _mm_srli_epi32(a_lo, 31), l_t8 = _mm_srli_epi32(a_hi, 31), l_t9 = _mm_srli_si128(l_t7, 12);
+    a_lo = _mm_or_si128(_mm_slli_epi32(a_lo, 1), _mm_slli_si128(l_t7, 4));
+    a_hi = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a_hi, 1), _mm_slli_si128(l_t8, 4)), l_t9);
+    l_t7 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(a_lo, 31), _mm_slli_epi32(a_lo, 30)), _mm_slli_epi32(a_lo, 25));
+    l_t8 = _mm_srli_si128(l_t7, 4);
+    a_lo = _mm_xor_si128(a_lo, _mm_slli_si128(l_t7, 12));
+    __m128i l_t2 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(a_lo, 1), _mm_srli_epi32(a_lo, 2)), _mm_srli_epi32(a_lo, 7));
+    a_lo = _mm_xor_si128(a_lo, _mm_xor_si128(l_t2, l_t8));
+    return _mm_xor_si128(a_hi, a_lo);
+}
+
+__attribute__((target(AES_GCM_HW_TARGET)))
+static inline __m128i s_ghash_mul(__m128i a_a, __m128i a_b)
+{
+    __m128i l_lo, l_hi;
+    s_clmul_wide(a_a, a_b, &l_lo, &l_hi);
+    return s_ghash_reduce(l_lo, l_hi);
+}
+
+__attribute__((target(AES_GCM_HW_TARGET)))
+static void s_ghash_hw_init(aes_gcm_ctx_t *a_ctx, const uint8_t *a_h)
+{
+    __m128i l_h = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)a_h), AES_GCM_BSWAP_MASK), l_pow = l_h;
+    _mm_storeu_si128((__m128i *)a_ctx->h_pow[0], l_h);
+    for (int i = 1; i < 4; i++) {
+        l_pow = s_ghash_mul(l_pow, l_h);
+        _mm_storeu_si128((__m128i *)a_ctx->h_pow[i], l_pow);
+    }
+}
+
+__attribute__((target(AES_GCM_HW_TARGET)))
+static inline __m128i s_ghash_hw_data(__m128i a_x, __m128i a_h, const uint8_t *a_data, size_t a_size)
+{
+    for ( ; a_size >= 16; a_data += 16, a_size -= 16)
+        a_x = s_ghash_mul(_mm_xor_si128(a_x, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)a_data), AES_GCM_BSWAP_MASK)), a_h);
+    if (a_size) {
+        uint8_t l_block[16] = { };
+        memcpy(l_block, a_data, a_size);
+        a_x = s_ghash_mul(_mm_xor_si128(a_x, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)l_block), AES_GCM_BSWAP_MASK)), a_h);
+    }
+    return a_x;
+}
+
+/**
+ * @brief s_aes_gcm_crypt_hw AES-NI and PCLMULQDQ AES-256-GCM, four blocks are encrypted in parallel
+ * and GHASH of them is reduced once. Same in-place rules as for the portable one
+ */
+__attribute__((target(AES_GCM_HW_TARGET)))
+static void s_aes_gcm_crypt_hw(const aes_gcm_ctx_t *a_ctx, const uint8_t *a_nonce, const uint8_t *a_aad, size_t a_aad_size,
+                               const uint8_t *a_in, size_t a_size, uint8_t *a_out, uint8_t *a_tag, bool a_encrypt)
+{
+    const __m128i l_bswap = AES_GCM_BSWAP_MASK;
+    __m128i l_rk[AES_GCM_ROUNDS + 1], l_h[4];
+    for (int i = 0; i <= AES_GCM_ROUNDS; i++)
+        l_rk[i] = _mm_loadu_si128((const __m128i *)(a_ctx->round_keys + i * 16));
+    for (int i = 0; i < 4; i++)
+        l_h[i] = _mm_loadu_si128((const __m128i *)a_ctx->h_pow[i]);
+    uint8_t l_nonce_block[16] = { };
+    memcpy(l_nonce_block, a_nonce, AES_GCM_NONCE_SIZE);
+    __m128i l_base = _mm_loadu_si128((const __m128i *)l_nonce_block), l_x = _mm_setzero_si128();
+    if (a_aad_size)
+        l_x = s_ghash_hw_data(l_x, l_h[0], a_aad, a_aad_size);
+    uint32_t l_ctr = 2;
+    size_t i = 0;
+    for ( ; i + 64 <= a_size; i += 64) {
+        __m128i l_b[4], l_d[4], l_c[4], l_lo, l_hi, l_lo1, l_hi1;
+        for (int j = 0; j < 4; j++)
+            l_b[j] = _mm_xor_si128(_mm_insert_epi32(l_base, (int)__builtin_bswap32(l_ctr++), 3), l_rk[0]);
+        for (int r = 1; r < AES_GCM_ROUNDS; r++)
+            for (int j = 0; j < 4; j++)
+                l_b[j] = _mm_aesenc_si128(l_b[j], l_rk[r]);
+        for (int j = 0; j < 4; j++) {
+            l_d[j] = _mm_loadu_si128((const __m128i *)(a_in + i + j * 16));
+            __m128i l_res = _mm_xor_si128(l_d[j], _mm_aesenclast_si128(l_b[j], l_rk[AES_GCM_ROUNDS]));
+            _mm_storeu_si128((__m128i *)(a_out + i + j * 16), l_res);
+            l_c[j] = _mm_shuffle_epi8(a_encrypt ? l_res : l_d[j], l_bswap);
+        }
+        s_clmul_wide(_mm_xor_si128(l_x, l_c[0]), l_h[3], &l_lo, &l_hi);
+        for (int j = 1; j < 4; j++) {
+            s_clmul_wide(l_c[j], l_h[3 - j], &l_lo1, &l_hi1);
+            l_lo = _mm_xor_si128(l_lo, l_lo1);
+            l_hi = _mm_xor_si128(l_hi, l_hi1);
+        }
+        l_x = s_ghash_reduce(l_lo, l_hi);
+    }
+    for ( ; i < a_size; i += 16) {
+        size_t l_len = a_size - i < 16 ? a_size - i : 16;
+        __m128i l_b = _mm_xor_si128(_mm_insert_epi32(l_base, (int)__builtin_bswap32(l_ctr++), 3), l_rk[0]);
+        for (int r = 1; r < AES_GCM_ROUNDS; r++)
+            l_b = _mm_aesenc_si128(l_b, l_rk[r]);
+        l_b = _mm_aesenclast_si128(l_b, l_rk[AES_GCM_ROUNDS]);
+        uint8_t l_stream[16];
+        _mm_storeu_si128((__m128i *)l_stream, l_b);
+        if (!a_encrypt)
+            l_x = s_ghash_hw_data(l_x, l_h[0], a_in + i, l_len);
+        for (size_t j = 0; j < l_len; j++)
+            a_out[i + j] = a_in[i + j] ^ l_stream[j];
+        if (a_encrypt)
+            l_x = s_ghash_hw_data(l_x, l_h[0], a_out + i, l_len);
+    }
+    uint8_t l_block[16];
+    s_put_be64(l_block, (uint64_t)a_aad_size * 8);
+    s_put_be64(l_block + 8, (uint64_t)a_size * 8);
+    l_x = s_ghash_hw_data(l_x, l_h[0], l_block, 16);
+    __m128i l_j0 = _mm_xor_si128(_mm_insert_epi32(l_base, (int)__builtin_bswap32(1), 3), l_rk[0]);
+    for (int r = 1; r < AES_GCM_ROUNDS; r++)
+        l_j0 = _mm_aesenc_si128(l_j0, l_rk[r]);
+    l_j0 = _mm_aesenclast_si128(l_j0, l_rk[AES_GCM_ROUNDS]);
+    _mm_storeu_si128((__m128i *)a_tag, _mm_xor_si128(_mm_shuffle_epi8(l_x, l_bswap), l_j0));
+}
+#endif
+
+/**
+ * @brief dap_enc_aes_gcm_hw_supported check if AES-NI and PCLMULQDQ instructions are used for AES-256-GCM
+ * @return true if CPU has them
+ */
+bool dap_enc_aes_gcm_hw_supported()
+{
+#ifdef AES_GCM_HW
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul")
+            && __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+#else
+    return false;
+#endif
+}
+
+static void s_aes_gcm_ctx_init(aes_gcm_ctx_t *a_ctx, const uint8_t *a_key)
+{
+    uint8_t l_h[16] = { };
+    s_aes256_key_expand(a_key, a_ctx->round_keys);
+    s_aes256_encrypt_block(a_ctx->round_keys, l_h, l_h);
+    s_ghash_tables_init(a_ctx, l_h);
+#ifdef AES_GCM_HW
+    if (( a_ctx->hw = dap_enc_aes_gcm_hw_supported() ))
+        s_ghash_hw_init(a_ctx, l_h);
+#endif
+}
+
+static void s_aes_gcm_crypt(const aes_gcm_ctx_t *a_ctx, const uint8_t *a_nonce, const uint8_t *a_aad, size_t a_aad_size,
+                            const uint8_t *a_in, size_t a_size, uint8_t *a_out, uint8_t *a_tag, bool a_encrypt)
+{
+#ifdef AES_GCM_HW
+    if (a_ctx->hw) {
+        s_aes_gcm_crypt_hw(a_ctx, a_nonce, a_aad, a_aad_size, a_in, a_size, a_out, a_tag, a_encrypt);
+        return;
+    }
+#endif
+    s_aes_gcm_crypt_soft(a_ctx, a_nonce, a_aad, a_aad_size, a_in, a_size, a_out, a_tag, a_encrypt);
+}
+
+/**
+ * @brief s_aes_gcm_ctx_get get expanded key of a_key
+ * @param a_key key
+ * @param a_tmp storage for the expanded key when the key was set without generation (e.g. deserialized)
+ * @return expanded key or NULL if a_key has no key data
+ */
+static const aes_gcm_ctx_t *s_aes_gcm_ctx_get(struct dap_enc_key *a_key, aes_gcm_ctx_t *a_tmp)
+{
+    if (a_key->_inheritor)
+        return a_key->_inheritor;
+    if (!a_key->priv_key_data || a_key->priv_key_data_size != AES_GCM_KEY_SIZE) {
+        log_it(L_ERROR, "AES-256-GCM key is not generated");
+        return NULL;
+    }
+    s_aes_gcm_ctx_init(a_tmp, a_key->priv_key_data);
+    return a_tmp;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_key_generate
+ *
+ * Generate key for AES-256-GCM. Key is stored in a_key->priv_key_data, its expanded
+ * round keys and GHASH tables in a_key->_inheritor
+ *
+ * @param a_key - dap_enc_key key descriptor
+ * @param kex_buf
+ * @param kex_size
+ * @param seed
+ * @param seed_size
+ * @param key_size
+ */
+void dap_enc_aes_gcm_key_generate(struct dap_enc_key *a_key, const void *kex_buf,
+        size_t kex_size, const void *seed, size_t seed_size, size_t key_size)
+{
+    if (key_size < AES_GCM_KEY_SIZE)
+        log_it(L_ERROR, "AES-256-GCM key cannot be less than 32 bytes but got %zu", key_size);
+    a_key->last_used_timestamp = time(NULL);
+
+    a_key->priv_key_data_size = AES_GCM_KEY_SIZE;
+    a_key->priv_key_data = DAP_NEW_SIZE(uint8_t, a_key->priv_key_data_size);
+    aes_gcm_ctx_t *l_ctx = DAP_NEW_Z(aes_gcm_ctx_t);
+    if (!a_key->priv_key_data || !l_ctx) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        DAP_DEL_MULTY(a_key->priv_key_data, l_ctx);
+        a_key->priv_key_data_size = 0;
+        return;
+    }
+
+    Keccak_HashInstance Keccak_ctx;
+    Keccak_HashInitialize(&Keccak_ctx, 1088,  512, a_key->priv_key_data_size * 8, 0x06);
+    Keccak_HashUpdate(&Keccak_ctx, kex_buf, kex_size * 8);
+    if (seed_size)
+        Keccak_HashUpdate(&Keccak_ctx, seed, seed_size * 8);
+    Keccak_HashFinal(&Keccak_ctx, a_key->priv_key_data);
+
+    s_aes_gcm_ctx_init(l_ctx, a_key->priv_key_data);
+    a_key->_inheritor = (uint8_t *)l_ctx;
+    a_key->_inheritor_size = sizeof(aes_gcm_ctx_t);
+}
+
+/**
+ * @brief dap_enc_aes_gcm_key_delete
+ *
+ * @param a_key
+ */
+void dap_enc_aes_gcm_key_delete(struct dap_enc_key *a_key)
+{
+    if (a_key->priv_key_data) {
+        randombytes(a_key->priv_key_data, a_key->priv_key_data_size);
+        DAP_DEL_Z(a_key->priv_key_data);
+    }
+    if (a_key->_inheritor) {
+        memset(a_key->_inheritor, 0, a_key->_inheritor_size);
+        DAP_DEL_Z(a_key->_inheritor);
+    }
+    a_key->priv_key_data_size = 0;
+    a_key->_inheritor_size = 0;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_key_new
+ *
+ * @param a_key
+ */
+void dap_enc_aes_gcm_key_new(struct dap_enc_key *a_key)
+{
+    a_key->_inheritor = NULL;
+    a_key->_inheritor_size = 0;
+    a_key->type = DAP_ENC_KEY_TYPE_AES256_GCM;
+    a_key->enc = dap_enc_aes_gcm_encrypt;
+    a_key->dec = dap_enc_aes_gcm_decrypt;
+    a_key->enc_na = dap_enc_aes_gcm_encrypt_fast;
+    a_key->dec_na = dap_enc_aes_gcm_decrypt_fast;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_calc_encode_size
+ *
+ * @param size_in
+ * @return size_t
+ */
+size_t dap_enc_aes_gcm_calc_encode_size(const size_t size_in)
+{
+    return size_in + AES_GCM_OVERHEAD;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_calc_decode_size
+ *
+ * @param size_in
+ * @return size_t
+ */
+size_t dap_enc_aes_gcm_calc_decode_size(const size_t size_in)
+{
+    if (size_in <= AES_GCM_OVERHEAD) {
+        log_it(L_ERROR, "AES-256-GCM ciphertext with nonce and tag must be more than %d bytes", AES_GCM_OVERHEAD);
+        return 0;
+    }
+    return size_in - AES_GCM_OVERHEAD;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_encrypt_fast
+ *
+ * Output is nonce || ciphertext || tag, nonce is random
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @param a_out_size
+ * @return size_t
+ */
+size_t dap_enc_aes_gcm_encrypt_fast(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void *a_out, size_t a_out_size)
+{
+    size_t l_out_size = a_in_size + AES_GCM_OVERHEAD;
+    if (!a_in_size || l_out_size > a_out_size) {
+        log_it(L_ERROR, "AES-256-GCM fast_encryption too small buf_out_size");
+        return 0;
+    }
+    aes_gcm_ctx_t l_tmp;
+    const aes_gcm_ctx_t *l_ctx = s_aes_gcm_ctx_get(a_key, &l_tmp);
+    if (!l_ctx)
+        return 0;
+    uint8_t *l_out = a_out;
+    if (randombytes(l_out, AES_GCM_NONCE_SIZE) == 1) {
+        log_it(L_ERROR, "failed to get AES_GCM_NONCE_SIZE bytes nonce");
+        return 0;
+    }
+    s_aes_gcm_crypt(l_ctx, l_out, NULL, 0, a_in, a_in_size, l_out + AES_GCM_NONCE_SIZE,
+                    l_out + AES_GCM_NONCE_SIZE + a_in_size, true);
+    if (l_ctx == &l_tmp)
+        memset(&l_tmp, 0, sizeof(l_tmp));
+    return l_out_size;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_decrypt_fast
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @param a_out_size
+ * @return size_t plaintext size, 0 if authentication failed
+ */
+size_t dap_enc_aes_gcm_decrypt_fast(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void *a_out, size_t a_out_size)
+{
+    if (a_in_size <= AES_GCM_OVERHEAD || a_in_size - AES_GCM_OVERHEAD > a_out_size) {
+        log_it(L_ERROR, "AES-256-GCM fast_decryption too small buf_out_size");
+        return 0;
+    }
+    aes_gcm_ctx_t l_tmp;
+    const aes_gcm_ctx_t *l_ctx = s_aes_gcm_ctx_get(a_key, &l_tmp);
+    if (!l_ctx)
+        return 0;
+    size_t l_out_size = a_in_size - AES_GCM_OVERHEAD;
+    const uint8_t *l_in = a_in;
+    uint8_t l_tag[AES_GCM_TAG_SIZE], l_diff = 0;
+    s_aes_gcm_crypt(l_ctx, l_in, NULL, 0, l_in + AES_GCM_NONCE_SIZE, l_out_size, a_out, l_tag, false);
+    if (l_ctx == &l_tmp)
+        memset(&l_tmp, 0, sizeof(l_tmp));
+    for (int i = 0; i < AES_GCM_TAG_SIZE; i++)
+        l_diff |= l_tag[i] ^ l_in[AES_GCM_NONCE_SIZE + l_out_size + i];
+    if (l_diff) {
+        memset(a_out, 0, l_out_size);
+        log_it(L_WARNING, "AES-256-GCM authentication tag mismatch");
+        return 0;
+    }
+    return l_out_size;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_encrypt
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @return size_t
+ */
+size_t dap_enc_aes_gcm_encrypt(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void **a_out)
+{
+    if (!a_in_size) {
+        log_it(L_ERROR, "AES-256-GCM encryption pt cannot be 0 bytes");
+        return 0;
+    }
+    size_t l_out_size = a_in_size + AES_GCM_OVERHEAD;
+    *a_out = DAP_NEW_SIZE(uint8_t, l_out_size);
+    if (!*a_out) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return 0;
+    }
+    l_out_size = dap_enc_aes_gcm_encrypt_fast(a_key, a_in, a_in_size, *a_out, l_out_size);
+    if (!l_out_size)
+        DAP_DEL_Z(*a_out);
+    return l_out_size;
+}
+
+/**
+ * @brief dap_enc_aes_gcm_decrypt
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @return size_t
+ */
+size_t dap_enc_aes_gcm_decrypt(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void **a_out)
+{
+    size_t l_out_size = dap_enc_aes_gcm_calc_decode_size(a_in_size);
+    if (!l_out_size)
+        return 0;
+    *a_out = DAP_NEW_SIZE(uint8_t, l_out_size);
+    if (!*a_out) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return 0;
+    }
+    l_out_size = dap_enc_aes_gcm_decrypt_fast(a_key, a_in, a_in_size, *a_out, l_out_size);
+    if (!l_out_size)
+        DAP_DEL_Z(*a_out);
+    return l_out_size;
+}
@@ -0,0 +1,545 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dap_enc_chacha20_poly1305.h"
+#include "dap_common.h"
+#include "rand/dap_rand.h"
+#include "KeccakHash.h"
+
+#define LOG_TAG "dap_enc_chacha20_poly1305"
+
+#define CHACHA20_KEY_SIZE       32
+#define CHACHA20_NONCE_SIZE     DAP_ENC_CHACHA20_POLY1305_NONCE_SIZE
+#define CHACHA20_BLOCK_SIZE     64
+#define POLY1305_TAG_SIZE       DAP_ENC_CHACHA20_POLY1305_TAG_SIZE
+#define CHACHA20_POLY1305_OVERHEAD (CHACHA20_NONCE_SIZE + POLY1305_TAG_SIZE)
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CHACHA20_X8
+#endif
+
+static inline uint32_t s_get_le32(const uint8_t *a_buf)
+{
+    return (uint32_t)a_buf[0] | ((uint32_t)a_buf[1] << 8) | ((uint32_t)a_buf[2] << 16) | ((uint32_t)a_buf[3] << 24);
+}
+
+static inline void s_put_le32(uint8_t *a_buf, uint32_t a_val)
+{
+    a_buf[0] = a_val; a_buf[1] = a_val >> 8; a_buf[2] = a_val >> 16; a_buf[3] = a_val >> 24;
+}
+
+static inline uint64_t s_get_le64(const uint8_t *a_buf)
+{
+    return (uint64_t)s_get_le32(a_buf) | ((uint64_t)s_get_le32(a_buf + 4) << 32);
+}
+
+static inline void s_put_le64(uint8_t *a_buf, uint64_t a_val)
+{
+    s_put_le32(a_buf, (uint32_t)a_val);
+    s_put_le32(a_buf + 4, (uint32_t)(a_val >> 32));
+}
+
+#define CHACHA20_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define CHACHA20_QR(x, a, b, c, d)                                      \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = CHACHA20_ROTL(x[d], 16);         \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = CHACHA20_ROTL(x[b], 12);         \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = CHACHA20_ROTL(x[d], 8);          \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = CHACHA20_ROTL(x[b], 7);
+#define CHACHA20_DOUBLE_ROUND(x)                                        \
+    CHACHA20_QR(x, 0, 4,  8, 12) CHACHA20_QR(x, 1, 5,  9, 13)           \
+    CHACHA20_QR(x, 2, 6, 10, 14) CHACHA20_QR(x, 3, 7, 11, 15)           \
+    CHACHA20_QR(x, 0, 5, 10, 15) CHACHA20_QR(x, 1, 6, 11, 12)           \
+    CHACHA20_QR(x, 2, 7,  8, 13) CHACHA20_QR(x, 3, 4,  9, 14)
+
+// Constants, key, block counter and nonce as RFC 8439 state layout
+static void s_chacha20_state_init(uint32_t *a_state, const uint8_t *a_key, const uint8_t *a_nonce, uint32_t a_counter)
+{
+    a_state[0] = 0x61707865; a_state[1] = 0x3320646e; a_state[2] = 0x79622d32; a_state[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++)
+        a_state[4 + i] = s_get_le32(a_key + i * 4);
+    a_state[12] = a_counter;
+    for (int i = 0; i < 3; i++)
+        a_state[13 + i] = s_get_le32(a_nonce + i * 4);
+}
+
+static void s_chacha20_block(const uint32_t *a_state, uint8_t *a_out)
+{
+    uint32_t x[16];
+    memcpy(x, a_state, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        CHACHA20_DOUBLE_ROUND(x)
+    }
+    for (int i = 0; i < 16; i++)
+        s_put_le32(a_out + i * 4, x[i] + a_state[i]);
+}
+
+#ifdef CHACHA20_X8
+typedef uint32_t chacha20_x8_vec_t __attribute__((vector_size(32)));
+
+/**
+ * @brief s_chacha20_xor_x8 eight ChaCha20 blocks at once, every AVX2 lane computes its own block.
+ * Processes only whole 512-byte chunks, state counter is moved forward
+ * @return processed bytes count
+ */
+__attribute__((target("avx2")))
+static size_t s_chacha20_xor_x8(uint32_t *a_state, const uint8_t *a_in, uint8_t *a_out, size_t a_size)
+{
+    size_t l_done = 0;
+    for ( ; a_size - l_done >= 8 * CHACHA20_BLOCK_SIZE; l_done += 8 * CHACHA20_BLOCK_SIZE) {
+        chacha20_x8_vec_t x[16], l_init[16];
+        for (int i = 0; i < 16; i++)
+            l_init[i] = (chacha20_x8_vec_t){ } + a_state[i];
+        l_init[12] += (chacha20_x8_vec_t){ 0, 1, 2, 3, 4, 5, 6, 7 };
+        memcpy(x, l_init, sizeof(x));
+        for (int i = 0; i < 10; i++) {
+            CHACHA20_DOUBLE_ROUND(x)
+        }
+        uint32_t l_words[16][8];
+        for (int i = 0; i < 16; i++) {
+            chacha20_x8_vec_t l_sum = x[i] + l_init[i];
+            memcpy(l_words[i], &l_sum, sizeof(l_words[i]));
+        }
+        for (int j = 0; j < 8; j++)
+            for (int i = 0; i < 16; i++) {
+                size_t l_offset = l_done + j * CHACHA20_BLOCK_SIZE + i * 4;
+                uint32_t l_word;
+                memcpy(&l_word, a_in + l_offset, 4);
+                l_word ^= l_words[i][j];
+                memcpy(a_out + l_offset, &l_word, 4);
+            }
+        a_state[12] += 8;
+    }
+    return l_done;
+}
+
+static bool s_chacha20_x8_supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+static void s_chacha20_xor(uint32_t *a_state, const uint8_t *a_in, uint8_t *a_out, size_t a_size)
+{
+    size_t l_done = 0;
+#if defined(CHACHA20_X8) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (a_size >= 8 * CHACHA20_BLOCK_SIZE && s_chacha20_x8_supported())
+        l_done = s_chacha20_xor_x8(a_state, a_in, a_out, a_size);
+#endif
+    uint8_t l_stream[CHACHA20_BLOCK_SIZE];
+    for ( ; l_done < a_size; l_done += CHACHA20_BLOCK_SIZE) {
+        size_t l_len = a_size - l_done < CHACHA20_BLOCK_SIZE ? a_size - l_done : CHACHA20_BLOCK_SIZE;
+        s_chacha20_block(a_state, l_stream);
+        a_state[12]++;
+        for (size_t i = 0; i < l_len; i++)
+            a_out[l_done + i] = a_in[l_done + i] ^ l_stream[i];
+    }
+}
+
+#ifdef __SIZEOF_INT128__
+// poly1305-donna with 44-bit limbs
+typedef struct poly1305_state {
+    uint64_t r[3], h[3], pad[2];
+} poly1305_state_t;
+
+static void s_poly1305_init(poly1305_state_t *a_st, const uint8_t *a_key)
+{
+    uint64_t t0 = s_get_le64(a_key), t1 = s_get_le64(a_key + 8);
+    a_st->r[0] = t0 & 0xffc0fffffff;
+    a_st->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+    a_st->r[2] = (t1 >> 24) & 0x00ffffffc0f;
+    a_st->h[0] = a_st->h[1] = a_st->h[2] = 0;
+    a_st->pad[0] = s_get_le64(a_key + 16);
+    a_st->pad[1] = s_get_le64(a_key + 24);
+}
+
+static void s_poly1305_blocks(poly1305_state_t *a_st, const uint8_t *a_data, size_t a_size)
+{
+    const uint64_t r0 = a_st->r[0], r1 = a_st->r[1], r2 = a_st->r[2], s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+    uint64_t h0 = a_st->h[0], h1 = a_st->h[1], h2 = a_st->h[2], c;
+    for ( ; a_size >= 16; a_data += 16, a_size -= 16) {
+        uint64_t t0 = s_get_le64(a_data), t1 = s_get_le64(a_data + 8);
+        h0 += t0 & 0xfffffffffff;
+        h1 += ((t0 >> 44) | (t1 << 20)) & 0xfffffffffff;
+        h2 += ((t1 >> 24) & 0x3ffffffffff) | ((uint64_t)1 << 40);
+        unsigned __int128 d0 = (unsigned __int128)h0 * r0 + (unsigned __int128)h1 * s2 + (unsigned __int128)h2 * s1,
+                          d1 = (unsigned __int128)h0 * r1 + (unsigned __int128)h1 * r0 + (unsigned __int128)h2 * s2,
+                          d2 = (unsigned __int128)h0 * r2 + (unsigned __int128)h1 * r1 + (unsigned __int128)h2 * r0;
+        c = (uint64_t)(d0 >> 44); h0 = (uint64_t)d0 & 0xfffffffffff;
+        d1 += c; c = (uint64_t)(d1 >> 44); h1 = (uint64_t)d1 & 0xfffffffffff;
+        d2 += c; c = (uint64_t)(d2 >> 42); h2 = (uint64_t)d2 & 0x3ffffffffff;
+        h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffff;
+        h1 += c;
+    }
+    a_st->h[0] = h0; a_st->h[1] = h1; a_st->h[2] = h2;
+}
+
+static void s_poly1305_finish(poly1305_state_t *a_st, uint8_t *a_mac)
+{
+    uint64_t h0 = a_st->h[0], h1 = a_st->h[1], h2 = a_st->h[2], c, g0, g1, g2;
+    c = h1 >> 44; h1 &= 0xfffffffffff;
+    h2 += c; c = h2 >> 42; h2 &= 0x3ffffffffff;
+    h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffff;
+    h1 += c; c = h1 >> 44; h1 &= 0xfffffffffff;
+    h2 += c; c = h2 >> 42; h2 &= 0x3ffffffffff;
+    h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffff;
+    h1 += c;
+    // h + -p
+    g0 = h0 + 5; c = g0 >> 44; g0 &= 0xfffffffffff;
+    g1 = h1 + c; c = g1 >> 44; g1 &= 0xfffffffffff;
+    g2 = h2 + c - ((uint64_t)1 << 42);
+    // select h if h < p, or h + -p if h >= p
+    c = (g2 >> 63) - 1;
+    h0 = (h0 & ~c) | (g0 & c);
+    h1 = (h1 & ~c) | (g1 & c);
+    h2 = (h2 & ~c) | (g2 & c);
+    // h + pad
+    uint64_t t0 = a_st->pad[0], t1 = a_st->pad[1];
+    h0 += t0 & 0xfffffffffff; c = h0 >> 44; h0 &= 0xfffffffffff;
+    h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff) + c; c = h1 >> 44; h1 &= 0xfffffffffff;
+    h2 += ((t1 >> 24) & 0x3ffffffffff) + c; h2 &= 0x3ffffffffff;
+    s_put_le64(a_mac, h0 | (h1 << 44));
+    s_put_le64(a_mac + 8, (h1 >> 20) | (h2 << 24));
+}
+#else
+// poly1305-donna with 26-bit limbs
+typedef struct poly1305_state {
+    uint32_t r[5], h[5], pad[4];
+} poly1305_state_t;
+
+static void s_poly1305_init(poly1305_state_t *a_st, const uint8_t *a_key)
+{
+    a_st->r[0] = s_get_le32(a_key) & 0x3ffffff;
+    a_st->r[1] = (s_get_le32(a_key + 3) >> 2) & 0x3ffff03;
+    a_st->r[2] = (s_get_le32(a_key + 6) >> 4) & 0x3ffc0ff;
+    a_st->r[3] = (s_get_le32(a_key + 9) >> 6) & 0x3f03fff;
+    a_st->r[4] = (s_get_le32(a_key + 12) >> 8) & 0x00fffff;
+    memset(a_st->h, 0, sizeof(a_st->h));
+    for (int i = 0; i < 4; i++)
+        a_st->pad[i] = s_get_le32(a_key + 16 + i * 4);
+}
+
+static void s_poly1305_blocks(poly1305_state_t *a_st, const uint8_t *a_data, size_t a_size)
+{
+    const uint32_t r0 = a_st->r[0], r1 = a_st->r[1], r2 = a_st->r[2], r3 = a_st->r[3], r4 = a_st->r[4],
+                   s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = a_st->h[0], h1 = a_st->h[1], h2 = a_st->h[2], h3 = a_st->h[3], h4 = a_st->h[4], c;
+    for ( ; a_size >= 16; a_data += 16, a_size -= 16) {
+        h0 += s_get_le32(a_data) & 0x3ffffff;
+        h1 += (s_get_le32(a_data + 3) >> 2) & 0x3ffffff;
+        h2 += (s_get_le32(a_data + 6) >> 4) & 0x3ffffff;
+        h3 += (s_get_le32(a_data + 9) >> 6) & 0x3ffffff;
+        h4 += (s_get_le32(a_data + 12) >> 8) | (1 << 24);
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1,
+                 d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2,
+                 d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3,
+                 d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4,
+                 d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+        c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3ffffff;
+        d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3ffffff;
+        d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3ffffff;
+        d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3ffffff;
+        d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+        h1 += c;
+    }
+    a_st->h[0] = h0; a_st->h[1] = h1; a_st->h[2] = h2; a_st->h[3] = h3; a_st->h[4] = h4;
+}
+
+static void s_poly1305_finish(poly1305_state_t *a_st, uint8_t *a_mac)
+{
+    uint32_t h0 = a_st->h[0], h1 = a_st->h[1], h2 = a_st->h[2], h3 = a_st->h[3], h4 = a_st->h[4], c,
+             g0, g1, g2, g3, g4, l_mask;
+    c = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+    // h + -p
+    g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    g4 = h4 + c - (1UL << 26);
+    // select h if h < p, or h + -p if h >= p
+    l_mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~l_mask) | (g0 & l_mask);
+    h1 = (h1 & ~l_mask) | (g1 & l_mask);
+    h2 = (h2 & ~l_mask) | (g2 & l_mask);
+    h3 = (h3 & ~l_mask) | (g3 & l_mask);
+    h4 = (h4 & ~l_mask) | (g4 & l_mask);
+    // h % 2^128 + pad
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+    uint64_t f = (uint64_t)h0 + a_st->pad[0];
+    s_put_le32(a_mac, (uint32_t)f);
+    f = (uint64_t)h1 + a_st->pad[1] + (f >> 32);
+    s_put_le32(a_mac + 4, (uint32_t)f);
+    f = (uint64_t)h2 + a_st->pad[2] + (f >> 32);
+    s_put_le32(a_mac + 8, (uint32_t)f);
+    f = (uint64_t)h3 + a_st->pad[3] + (f >> 32);
+    s_put_le32(a_mac + 12, (uint32_t)f);
+}
+#endif
+
+// AEAD MAC input parts are zero padded to 16 bytes so there is never a partial block
+static void s_poly1305_update_padded(poly1305_state_t *a_st, const uint8_t *a_data, size_t a_size)
+{
+    s_poly1305_blocks(a_st, a_data, a_size & ~(size_t)15);
+    if (a_size & 15) {
+        uint8_t l_block[16] = { };
+        memcpy(l_block, a_data + (a_size & ~(size_t)15), a_size & 15);
+        s_poly1305_blocks(a_st, l_block, 16);
+    }
+}
+
+/**
+ * @brief s_chacha20_poly1305_crypt RFC 8439 AEAD_CHACHA20_POLY1305. Ciphertext is authenticated before it's written
+ * or after it's read, so a_out could be the same as a_in or be ahead of it
+ */
+static void s_chacha20_poly1305_crypt(const uint8_t *a_key, const uint8_t *a_nonce, const uint8_t *a_aad, size_t a_aad_size,
+                                      const uint8_t *a_in, size_t a_size, uint8_t *a_out, uint8_t *a_tag, bool a_encrypt)
+{
+    uint32_t l_state[16];
+    uint8_t l_block[CHACHA20_BLOCK_SIZE];
+    poly1305_state_t l_poly;
+    s_chacha20_state_init(l_state, a_key, a_nonce, 0);
+    s_chacha20_block(l_state, l_block);
+    s_poly1305_init(&l_poly, l_block);
+    l_state[12] = 1;
+    if (a_aad_size)
+        s_poly1305_update_padded(&l_poly, a_aad, a_aad_size);
+    // Go through data with chunks fit to L1 cache for the MAC reading what cipher just wrote. Only the last chunk
+    // could be not multiple of 16, so padding of every chunk is the same as padding of whole ciphertext
+    for (size_t i = 0; i < a_size; i += 8 * 1024) {
+        size_t l_len = a_size - i < 8 * 1024 ? a_size - i : 8 * 1024;
+        if (!a_encrypt)
+            s_poly1305_update_padded(&l_poly, a_in + i, l_len);
+        s_chacha20_xor(l_state, a_in + i, a_out + i, l_len);
+        if (a_encrypt)
+            s_poly1305_update_padded(&l_poly, a_out + i, l_len);
+    }
+    s_put_le64(l_block, a_aad_size);
+    s_put_le64(l_block + 8, a_size);
+    s_poly1305_blocks(&l_poly, l_block, 16);
+    s_poly1305_finish(&l_poly, a_tag);
+    memset(l_state, 0, sizeof(l_state));
+    memset(&l_poly, 0, sizeof(l_poly));
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_key_generate
+ *
+ * Generate key for ChaCha20-Poly1305. Key is stored in a_key->priv_key_data
+ *
+ * @param a_key - dap_enc_key key descriptor
+ * @param kex_buf
+ * @param kex_size
+ * @param seed
+ * @param seed_size
+ * @param key_size
+ */
+void dap_enc_chacha20_poly1305_key_generate(struct dap_enc_key *a_key, const void *kex_buf,
+        size_t kex_size, const void *seed, size_t seed_size, size_t key_size)
+{
+    if (key_size < CHACHA20_KEY_SIZE)
+        log_it(L_ERROR, "ChaCha20 key cannot be less than 32 bytes but got %zu", key_size);
+    a_key->last_used_timestamp = time(NULL);
+
+    a_key->priv_key_data_size = CHACHA20_KEY_SIZE;
+    a_key->priv_key_data = DAP_NEW_SIZE(uint8_t, a_key->priv_key_data_size);
+    if (!a_key->priv_key_data) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        a_key->priv_key_data_size = 0;
+        return;
+    }
+
+    Keccak_HashInstance Keccak_ctx;
+    Keccak_HashInitialize(&Keccak_ctx, 1088,  512, a_key->priv_key_data_size * 8, 0x06);
+    Keccak_HashUpdate(&Keccak_ctx, kex_buf, kex_size * 8);
+    if (seed_size)
+        Keccak_HashUpdate(&Keccak_ctx, seed, seed_size * 8);
+    Keccak_HashFinal(&Keccak_ctx, a_key->priv_key_data);
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_key_delete
+ *
+ * @param a_key
+ */
+void dap_enc_chacha20_poly1305_key_delete(struct dap_enc_key *a_key)
+{
+    if (a_key->priv_key_data) {
+        randombytes(a_key->priv_key_data, a_key->priv_key_data_size);
+        DAP_DEL_Z(a_key->priv_key_data);
+    }
+    a_key->priv_key_data_size = 0;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_key_new
+ *
+ * @param a_key
+ */
+void dap_enc_chacha20_poly1305_key_new(struct dap_enc_key *a_key)
+{
+    a_key->_inheritor = NULL;
+    a_key->_inheritor_size = 0;
+    a_key->type = DAP_ENC_KEY_TYPE_CHACHA20_POLY1305;
+    a_key->enc = dap_enc_chacha20_poly1305_encrypt;
+    a_key->dec = dap_enc_chacha20_poly1305_decrypt;
+    a_key->enc_na = dap_enc_chacha20_poly1305_encrypt_fast;
+    a_key->dec_na = dap_enc_chacha20_poly1305_decrypt_fast;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_calc_encode_size
+ *
+ * @param size_in
+ * @return size_t
+ */
+size_t dap_enc_chacha20_poly1305_calc_encode_size(const size_t size_in)
+{
+    return size_in + CHACHA20_POLY1305_OVERHEAD;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_calc_decode_size
+ *
+ * @param size_in
+ * @return size_t
+ */
+size_t dap_enc_chacha20_poly1305_calc_decode_size(const size_t size_in)
+{
+    if (size_in <= CHACHA20_POLY1305_OVERHEAD) {
+        log_it(L_ERROR, "ChaCha20-Poly1305 ciphertext with nonce and tag must be more than %d bytes", CHACHA20_POLY1305_OVERHEAD);
+        return 0;
+    }
+    return size_in - CHACHA20_POLY1305_OVERHEAD;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_encrypt_fast
+ *
+ * Output is nonce || ciphertext || tag, nonce is random
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @param a_out_size
+ * @return size_t
+ */
+size_t dap_enc_chacha20_poly1305_encrypt_fast(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size,
+                                              void *a_out, size_t a_out_size)
+{
+    size_t l_out_size = a_in_size + CHACHA20_POLY1305_OVERHEAD;
+    if (!a_in_size || l_out_size > a_out_size) {
+        log_it(L_ERROR, "ChaCha20-Poly1305 fast_encryption too small buf_out_size");
+        return 0;
+    }
+    if (!a_key->priv_key_data || a_key->priv_key_data_size != CHACHA20_KEY_SIZE) {
+        log_it(L_ERROR, "ChaCha20-Poly1305 key is not generated");
+        return 0;
+    }
+    uint8_t *l_out = a_out;
+    if (randombytes(l_out, CHACHA20_NONCE_SIZE) == 1) {
+        log_it(L_ERROR, "failed to get CHACHA20_NONCE_SIZE bytes nonce");
+        return 0;
+    }
+    s_chacha20_poly1305_crypt(a_key->priv_key_data, l_out, NULL, 0, a_in, a_in_size, l_out + CHACHA20_NONCE_SIZE,
+                              l_out + CHACHA20_NONCE_SIZE + a_in_size, true);
+    return l_out_size;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_decrypt_fast
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @param a_out_size
+ * @return size_t plaintext size, 0 if authentication failed
+ */
+size_t dap_enc_chacha20_poly1305_decrypt_fast(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size,
+                                              void *a_out, size_t a_out_size)
+{
+    if (a_in_size <= CHACHA20_POLY1305_OVERHEAD || a_in_size - CHACHA20_POLY1305_OVERHEAD > a_out_size) {
+        log_it(L_ERROR, "ChaCha20-Poly1305 fast_decryption too small buf_out_size");
+        return 0;
+    }
+    if (!a_key->priv_key_data || a_key->priv_key_data_size != CHACHA20_KEY_SIZE) {
+        log_it(L_ERROR, "ChaCha20-Poly1305 key is not generated");
+        return 0;
+    }
+    size_t l_out_size = a_in_size - CHACHA20_POLY1305_OVERHEAD;
+    const uint8_t *l_in = a_in;
+    uint8_t l_tag[POLY1305_TAG_SIZE], l_diff = 0;
+    s_chacha20_poly1305_crypt(a_key->priv_key_data, l_in, NULL, 0, l_in + CHACHA20_NONCE_SIZE, l_out_size, a_out, l_tag, false);
+    for (int i = 0; i < POLY1305_TAG_SIZE; i++)
+        l_diff |= l_tag[i] ^ l_in[CHACHA20_NONCE_SIZE + l_out_size + i];
+    if (l_diff) {
+        memset(a_out, 0, l_out_size);
+        log_it(L_WARNING, "ChaCha20-Poly1305 authentication tag mismatch");
+        return 0;
+    }
+    return l_out_size;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_encrypt
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @return size_t
+ */
+size_t dap_enc_chacha20_poly1305_encrypt(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void **a_out)
+{
+    if (!a_in_size) {
+        log_it(L_ERROR, "ChaCha20-Poly1305 encryption pt cannot be 0 bytes");
+        return 0;
+    }
+    size_t l_out_size = a_in_size + CHACHA20_POLY1305_OVERHEAD;
+    *a_out = DAP_NEW_SIZE(uint8_t, l_out_size);
+    if (!*a_out) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return 0;
+    }
+    l_out_size = dap_enc_chacha20_poly1305_encrypt_fast(a_key, a_in, a_in_size, *a_out, l_out_size);
+    if (!l_out_size)
+        DAP_DEL_Z(*a_out);
+    return l_out_size;
+}
+
+/**
+ * @brief dap_enc_chacha20_poly1305_decrypt
+ *
+ * @param a_key
+ * @param a_in
+ * @param a_in_size
+ * @param a_out
+ * @return size_t
+ */
+size_t dap_enc_chacha20_poly1305_decrypt(struct dap_enc_key *a_key, const void *a_in, size_t a_in_size, void **a_out)
+{
+    size_t l_out_size = dap_enc_chacha20_poly1305_calc_decode_size(a_in_size);
+    if (!l_out_size)
+        return 0;
+    *a_out = DAP_NEW_SIZE(uint8_t, l_out_size);
+    if (!*a_out) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return 0;
+    }
+    l_out_size = dap_enc_chacha20_poly1305_decrypt_fast(a_key, a_in, a_in_size, *a_out, l_out_size);
+    if (!l_out_size)
+        DAP_DEL_Z(*a_out);
+    return l_out_size;
+}
@@ -23,7 +23,10 @@ static void s_context_destructor(UNUSED_ARG void *a_context) {
 //    _ecdsa_type = type;
 //}
 
-static ecdsa_context_t *s_context_create() 
+/**
+ * @brief s_context_get get thread context as is, enough for public key and verification operations
+ */
+static ecdsa_context_t *s_context_get()
 {
      if (!s_context) {
         s_context = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
@@ -36,6 +39,16 @@ static ecdsa_context_t *s_context_create()
         pthread_setspecific(s_context_destructor_key, (const void *)s_context);
         log_it(L_DEBUG, "ECDSA context is created @%p", s_context);
     }
+    return s_context;
+}
+
+/**
+ * @brief s_context_create get thread context randomized against side channel attacks, need for secret key operations
+ */
+static ecdsa_context_t *s_context_create()
+{
+    if (!s_context_get())
+        return NULL;
     unsigned char l_random_seed[32];
     randombytes(l_random_seed, sizeof(l_random_seed));
     if (secp256k1_context_randomize(s_context, l_random_seed) != 1) {
@@ -147,7 +160,7 @@ int dap_enc_sig_ecdsa_verify_sign(struct dap_enc_key *l_key, const void *a_msg,
     dap_enc_sig_ecdsa_hash_fast(a_msg, a_msg_size, (dap_hash_fast_t *)l_msghash);
 // context create
     int l_ret = 0;
-    ecdsa_context_t *l_ctx = s_context_create();
+    ecdsa_context_t *l_ctx = s_context_get();
     if (!l_ctx || secp256k1_ecdsa_verify(l_ctx, (const ecdsa_signature_t*)a_sig, l_msghash, (ecdsa_public_key_t *)l_key->pub_key_data) != 1) {
         log_it(L_ERROR, "Failed to verify signature");
         l_ret = -4;
@@ -160,7 +173,7 @@ uint8_t *dap_enc_sig_ecdsa_write_public_key(const void *a_public_key, size_t *a_
     dap_return_val_if_pass(!a_public_key, NULL);
     byte_t *l_buf = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(byte_t, ECDSA_PKEY_SERIALIZED_SIZE, NULL);
 
-    ecdsa_context_t *l_ctx = s_context_create();
+    ecdsa_context_t *l_ctx = s_context_get();
 
     size_t l_len = ECDSA_PKEY_SERIALIZED_SIZE;
     if (
@@ -183,7 +196,7 @@ void *dap_enc_sig_ecdsa_read_public_key(const uint8_t* a_buf, size_t a_buflen) {
     dap_return_val_if_pass(!a_buf || a_buflen != ECDSA_PKEY_SERIALIZED_SIZE, NULL);
 // memory alloc
     ecdsa_public_key_t *l_public_key = DAP_NEW_Z_RET_VAL_IF_FAIL(ecdsa_public_key_t, NULL);
-    ecdsa_context_t *l_ctx = s_context_create();
+    ecdsa_context_t *l_ctx = s_context_get();
     if (!l_ctx || secp256k1_ec_pubkey_parse(l_ctx, l_public_key, a_buf, a_buflen ) != 1) {
         log_it(L_CRITICAL, "Failed to deserialize pkey");
         DAP_DELETE(l_public_key);
@@ -195,7 +208,7 @@ uint8_t *dap_enc_sig_ecdsa_write_signature(const void *a_sign, size_t *a_sign_le
 {
     dap_return_val_if_pass(!a_sign || !a_sign_len, NULL);
     byte_t *l_ret = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(byte_t, sizeof(ecdsa_signature_t), NULL);
-    ecdsa_context_t *l_ctx = s_context_create();
+    ecdsa_context_t *l_ctx = s_context_get();
     if (!l_ctx || secp256k1_ecdsa_signature_serialize_compact(l_ctx, l_ret, (const ecdsa_signature_t*)a_sign) != 1) {
         log_it(L_ERROR, "Failed to serialize sign");
         DAP_DEL_Z(l_ret);  
@@ -207,7 +220,7 @@ void *dap_enc_sig_ecdsa_read_signature(const uint8_t *a_buf, size_t a_buflen)
 {
     dap_return_val_if_pass(!a_buf || a_buflen != sizeof(ecdsa_signature_t), NULL);
     ecdsa_signature_t *l_ret = DAP_NEW_Z_RET_VAL_IF_FAIL(ecdsa_signature_t, NULL);
-    ecdsa_context_t *l_ctx = s_context_create();
+    ecdsa_context_t *l_ctx = s_context_get();
     if (!l_ctx || secp256k1_ecdsa_signature_parse_compact(l_ctx, l_ret, a_buf) != 1) {
         log_it(L_ERROR, "Failed to deserialize sign");
         DAP_DEL_Z(l_ret);
@@ -1,8 +1,23 @@
 #include "dap_enc_falcon.h"
 #include "falcon.h"
+#include "dap_pq_impl.h"
 
 #define LOG_TAG "dap_enc_sig_falcon"
 
+#ifdef DAP_PQ_AVX2
+// AVX2 build from falcon/falcon_avx2.c
+int falcon_avx2_keygen_make(shake256_context *rng, unsigned logn, void *privkey, size_t privkey_len,
+                            void *pubkey, size_t pubkey_len, void *tmp, size_t tmp_len);
+int falcon_avx2_sign_dyn(shake256_context *rng, void *sig, size_t *sig_len, int sig_type, const void *privkey, size_t privkey_len,
+                         const void *data, size_t data_len, void *tmp, size_t tmp_len);
+int falcon_avx2_verify(const void *sig, size_t sig_len, int sig_type, const void *pubkey, size_t pubkey_len,
+                       const void *data, size_t data_len, void *tmp, size_t tmp_len);
+#define FALCON_CALL(func, ...) ( dap_pq_impl_get() == DAP_PQ_IMPL_AVX2 \
+    ? falcon_avx2_##func(__VA_ARGS__) : falcon_##func(__VA_ARGS__) )
+#else
+#define FALCON_CALL(func, ...) falcon_##func(__VA_ARGS__)
+#endif
+
 static falcon_sign_degree_t s_falcon_sign_degree = FALCON_512;
 static falcon_kind_t s_falcon_kind = FALCON_COMPRESSED;
 static falcon_sign_type_t s_falcon_type = FALCON_DYNAMIC;
@@ -108,7 +123,7 @@ void dap_enc_sig_falcon_key_new_generate(dap_enc_key_t *a_key, const void *kex_b
     } else {
         shake256_init_prng_from_seed(&rng, seed, seed_size);
     }
-    l_ret = falcon_keygen_make(
+    l_ret = FALCON_CALL(keygen_make,
             &rng, l_logn,
             l_skey->data, FALCON_PRIVKEY_SIZE(l_logn),
             l_pkey->data, FALCON_PUBKEY_SIZE(l_logn),
@@ -172,7 +187,7 @@ int dap_enc_sig_falcon_get_sign(dap_enc_key_t *a_key, const void *a_msg, const s
     if (l_sig_len)
         l_sig->sig_data = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(byte_t, l_sig_len, -1);
 
-    l_ret = falcon_sign_dyn(
+    l_ret = FALCON_CALL(sign_dyn,
             &l_rng,
             l_sig->sig_data, &l_sig_len, privateKey->kind,
             privateKey->data, FALCON_PRIVKEY_SIZE(privateKey->degree),
@@ -206,7 +221,7 @@ int dap_enc_sig_falcon_verify_sign(dap_enc_key_t *a_key, const void *a_msg, cons
             l_sig->type != l_pkey->type)
         return -1;
 
-    int l_ret = falcon_verify(
+    int l_ret = FALCON_CALL(verify,
             l_sig->sig_data, l_sig->sig_len, l_pkey->kind,
             l_pkey->data, FALCON_PUBKEY_SIZE(l_pkey->degree),
             a_msg, a_msg_size,
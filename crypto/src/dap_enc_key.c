@@ -29,6 +29,8 @@
 #include "dap_enc_GOST.h"
 #include "dap_enc_salsa2012.h"
 #include "dap_enc_SEED.h"
+#include "dap_enc_aes_gcm.h"
+#include "dap_enc_chacha20_poly1305.h"
 
 #include "dap_enc_msrln.h"
 #include "dap_enc_picnic.h"
@@ -170,6 +172,7 @@ dap_enc_key_callbacks_t s_callbacks[]={
         .ser_pub_key_size =                 NULL,
         .enc_out_size =                     dap_enc_salsa2012_calc_encode_size,
         .dec_out_size =                     dap_enc_salsa2012_calc_decode_size,
+        .inplace_headroom =                 DAP_ENC_SALSA2012_NONCE_SIZE,
         .sign_get =                         NULL,
         .sign_verify =                      NULL
     },
@@ -189,6 +192,41 @@ dap_enc_key_callbacks_t s_callbacks[]={
         .sign_get =                         NULL,
         .sign_verify =                      NULL
     },
+    //-AEAD ciphers----------------------
+    [DAP_ENC_KEY_TYPE_AES256_GCM]={
+        .name =                             "AES256_GCM",
+        .enc =                              dap_enc_aes_gcm_encrypt,
+        .enc_na =                           dap_enc_aes_gcm_encrypt_fast,
+        .dec =                              dap_enc_aes_gcm_decrypt,
+        .dec_na =                           dap_enc_aes_gcm_decrypt_fast,
+        .new_callback =                     dap_enc_aes_gcm_key_new,
+        .delete_callback =                  dap_enc_aes_gcm_key_delete,
+        .new_generate_callback =            dap_enc_aes_gcm_key_generate,
+        .gen_key_public =                   NULL,
+        .ser_pub_key_size =                 NULL,
+        .enc_out_size =                     dap_enc_aes_gcm_calc_encode_size,
+        .dec_out_size =                     dap_enc_aes_gcm_calc_decode_size,
+        .inplace_headroom =                 DAP_ENC_AES_GCM_NONCE_SIZE,
+        .sign_get =                         NULL,
+        .sign_verify =                      NULL
+    },
+    [DAP_ENC_KEY_TYPE_CHACHA20_POLY1305]={
+        .name =                             "CHACHA20_POLY1305",
+        .enc =                              dap_enc_chacha20_poly1305_encrypt,
+        .enc_na =                           dap_enc_chacha20_poly1305_encrypt_fast,
+        .dec =                              dap_enc_chacha20_poly1305_decrypt,
+        .dec_na =                           dap_enc_chacha20_poly1305_decrypt_fast,
+        .new_callback =                     dap_enc_chacha20_poly1305_key_new,
+        .delete_callback =                  dap_enc_chacha20_poly1305_key_delete,
+        .new_generate_callback =            dap_enc_chacha20_poly1305_key_generate,
+        .gen_key_public =                   NULL,
+        .ser_pub_key_size =                 NULL,
+        .enc_out_size =                     dap_enc_chacha20_poly1305_calc_encode_size,
+        .dec_out_size =                     dap_enc_chacha20_poly1305_calc_decode_size,
+        .inplace_headroom =                 DAP_ENC_CHACHA20_POLY1305_NONCE_SIZE,
+        .sign_get =                         NULL,
+        .sign_verify =                      NULL
+    },
 
     //-KEMs(Key Exchange Mechanism)----------------------
     [DAP_ENC_KEY_TYPE_MSRLN] = {
@@ -1154,7 +1192,7 @@ void dap_enc_key_delete(dap_enc_key_t * a_key)
         s_callbacks[a_key->type].delete_callback(a_key);
     } else {
         log_it(L_WARNING, "No callback for key delete to %s enc key. LEAKS CAUTION!", dap_enc_get_type_name(a_key->type));
-        DAP_DEL_MULTY(a_key->pub_key_data, a_key->priv_key_data, a_key->_inheritor, a_key->pbk_list_data, a_key);
+        DAP_DEL_MULTY(a_key->pub_key_data, a_key->priv_key_data, a_key->_inheritor, a_key->pbk_list_data);
     }
     DAP_DELETE(a_key);
 }
@@ -1185,9 +1223,32 @@ size_t dap_enc_key_get_dec_size(dap_enc_key_type_t a_key_type, const size_t a_bu
         : ( log_it(L_ERROR, "No dec_out_size() function for key %s", dap_enc_get_type_name(a_key_type)), 0 );
 }
 
+/**
+ * @brief dap_enc_key_get_inplace_headroom bytes to reserve ahead of plaintext for in-place encryption
+ * @param a_key_type key type
+ * @return headroom size or 0 if cipher can't encrypt in place
+ */
+size_t dap_enc_key_get_inplace_headroom(dap_enc_key_type_t a_key_type)
+{
+    return a_key_type >= DAP_ENC_KEY_TYPE_NULL && a_key_type <= DAP_ENC_KEY_TYPE_LAST
+        ? s_callbacks[a_key_type].inplace_headroom : 0;
+}
+
+/**
+ * @brief dap_enc_key_get_inplace_tailroom bytes to reserve after plaintext for in-place encryption
+ * @param a_key_type key type
+ * @return tailroom size, 0 if cipher has no tail or can't encrypt in place
+ */
+size_t dap_enc_key_get_inplace_tailroom(dap_enc_key_type_t a_key_type)
+{
+    size_t l_headroom = dap_enc_key_get_inplace_headroom(a_key_type);
+    return l_headroom ? s_callbacks[a_key_type].enc_out_size(1) - 1 - l_headroom : 0;
+}
+
 const char *dap_enc_get_type_name(dap_enc_key_type_t a_key_type)
 {
-    return a_key_type >= DAP_ENC_KEY_TYPE_NULL && a_key_type <= DAP_ENC_KEY_TYPE_LAST && *s_callbacks[a_key_type].name
+    return a_key_type >= DAP_ENC_KEY_TYPE_NULL && a_key_type <= DAP_ENC_KEY_TYPE_LAST
+            && s_callbacks[a_key_type].name && *s_callbacks[a_key_type].name
         ? s_callbacks[a_key_type].name
         : ( log_it(L_WARNING, "Name was not set for key type %d", a_key_type), "undefined");
 }
@@ -4,6 +4,18 @@
 
 #define LOG_TAG "dap_enc_kyber"
 #include "symmetric.h"
+#include "dap_pq_impl.h"
+
+#ifdef DAP_PQ_AVX2
+// AVX2 implementation from dap_crypto_kyber512_avx2, keys and ciphertexts are the same as the portable one has
+int pqcrystals_kyber512_avx2_keypair(unsigned char *pk, unsigned char *sk);
+int pqcrystals_kyber512_avx2_enc(unsigned char *ct, unsigned char *ss, const unsigned char *pk);
+int pqcrystals_kyber512_avx2_dec(unsigned char *ss, const unsigned char *ct, const unsigned char *sk);
+#define KYBER512_CALL(func, ...) ( dap_pq_impl_get() == DAP_PQ_IMPL_AVX2 \
+    ? pqcrystals_kyber512_avx2_##func(__VA_ARGS__) : crypto_kem_##func(__VA_ARGS__) )
+#else
+#define KYBER512_CALL(func, ...) crypto_kem_##func(__VA_ARGS__)
+#endif
 /**
  * @brief dap_enc_kyber_key_new
  * @param a_key
@@ -50,7 +62,7 @@ void dap_enc_kyber512_key_generate(dap_enc_key_t *a_key, UNUSED_ARG const void *
     dap_return_if_pass(!a_key);
     uint8_t *l_skey = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, CRYPTO_SECRETKEYBYTES),
             *l_pkey = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, CRYPTO_PUBLICKEYBYTES, l_skey);
-    if (crypto_kem_keypair(l_pkey, l_skey)) {
+    if (KYBER512_CALL(keypair, l_pkey, l_skey)) {
         DAP_DEL_MULTY(l_pkey, l_skey);
         return;
     }
@@ -93,7 +105,7 @@ size_t dap_enc_kyber512_gen_bob_shared_key (dap_enc_key_t *a_bob_key, const void
     uint8_t *l_shared_key = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(uint8_t, CRYPTO_BYTES, 0),
             *l_cypher_msg = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(uint8_t, CRYPTO_CIPHERTEXTBYTES, 0, l_shared_key);
 // crypto calc
-    if(crypto_kem_enc(l_cypher_msg, l_shared_key, a_alice_pub)) {
+    if(KYBER512_CALL(enc, l_cypher_msg, l_shared_key, a_alice_pub)) {
         DAP_DEL_MULTY(l_cypher_msg, l_shared_key);
         return 0;
     }
@@ -122,7 +134,7 @@ size_t dap_enc_kyber512_gen_alice_shared_key(dap_enc_key_t *a_alice_key, UNUSED_
 // memory alloc
     uint8_t *l_shared_key = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(uint8_t, CRYPTO_BYTES, 0);
 // crypto calc
-    if ( crypto_kem_dec(l_shared_key, a_cypher_msg, a_alice_key->_inheritor) )
+    if ( KYBER512_CALL(dec, l_shared_key, a_cypher_msg, a_alice_key->_inheritor) )
         return DAP_DELETE(l_shared_key), 0;
 // post func work
     DAP_DEL_Z(a_alice_key->shared_key);
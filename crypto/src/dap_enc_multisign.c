@@ -278,9 +278,10 @@ bool dap_multi_sign_hash_data(dap_multi_sign_t *a_sign, const void *a_data, cons
                                        &a_sign->key_count, (uint64_t)sizeof(uint8_t),
                                        &a_sign->sign_count, (uint64_t)sizeof(uint8_t),
                                        a_sign->key_seq, (uint64_t)(a_sign->sign_count * sizeof(uint8_t)));
-    l_ret ? l_ret &= dap_hash_fast(a_data, a_data_size, (dap_chain_hash_fast_t *)l_concatenated_hash) : 0;  // get data hash
-    l_ret ? l_ret &= dap_hash_fast(l_meta_data, l_meta_data_size, (dap_chain_hash_fast_t*)(l_concatenated_hash + sizeof(dap_chain_hash_fast_t))) : 0;  // get metadata hash
-    l_ret ? l_ret &= dap_hash_fast(a_sign->key_hashes, a_sign->key_count * sizeof(dap_chain_hash_fast_t), (dap_chain_hash_fast_t *)(l_concatenated_hash + 2 * sizeof(dap_chain_hash_fast_t))) : 0;   // get key_hashes hash
+    // get data, metadata and key_hashes hashes
+    const void *l_hashed[] = { a_data, l_meta_data, a_sign->key_hashes };
+    size_t l_hashed_size[] = { a_data_size, l_meta_data_size, a_sign->key_count * sizeof(dap_chain_hash_fast_t) };
+    l_ret ? l_ret &= dap_hash_fast_batch(l_hashed, l_hashed_size, (dap_chain_hash_fast_t *)l_concatenated_hash, 3) : 0;
     l_ret ? l_ret &= dap_hash_fast(l_concatenated_hash, 3 * sizeof(dap_chain_hash_fast_t), a_hash) : 0;  // get out hash of calculated hashes
     return l_ret;
 }
@@ -308,12 +309,16 @@ int dap_enc_sig_multisign_get_sign(dap_enc_key_t *a_key, const void *a_msg_in, c
     l_sign->key_count = l_params->key_count;
     l_sign->sign_count = l_params->sign_count;
 
+    const void *l_pkeys[l_params->key_count];
+    size_t l_pkeys_size[l_params->key_count];
     for (int i = 0; i < l_params->key_count; i++) {
-        if (!dap_hash_fast(l_params->keys[i]->pub_key_data, l_params->keys[i]->pub_key_data_size, &l_sign->key_hashes[i])) {
-            log_it (L_ERROR, "Can't create multi-signature hash");
-            DAP_DEL_MULTY(l_sign->key_hashes, l_sign->key_seq, l_sign->meta);
-            return -3;
-        }
+        l_pkeys[i] = l_params->keys[i]->pub_key_data;
+        l_pkeys_size[i] = l_params->keys[i]->pub_key_data_size;
+    }
+    if (!dap_hash_fast_batch(l_pkeys, l_pkeys_size, l_sign->key_hashes, l_params->key_count)) {
+        log_it (L_ERROR, "Can't create multi-signature hash");
+        DAP_DEL_MULTY(l_sign->key_hashes, l_sign->key_seq, l_sign->meta);
+        return -3;
     }
     // need to forming metadata
     for (int i = 0; i < l_params->sign_count; i++) {
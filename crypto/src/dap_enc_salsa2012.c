@@ -11,7 +11,7 @@
 
 #define LOG_TAG "dap_enc_salsa2012"
 #define SALSA20_KEY_SIZE 32
-#define SALSA20_NONCE_SIZE 8
+#define SALSA20_NONCE_SIZE DAP_ENC_SALSA2012_NONCE_SIZE
 
 /**
  * @brief dap_enc_salsa2012_key_generate
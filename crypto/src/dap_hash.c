@@ -30,6 +30,90 @@
 
 #define LOG_TAG "dap_hash"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DAP_HASH_FAST_MULTI_LANE
+
+#define SHA3_XN_RATE 136    // SHA3-256 rate in bytes
+
+static const uint64_t s_sha3_xn_rc[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+static const unsigned s_sha3_xn_rho[25] = {
+     0,  1, 62, 28, 27,
+    36, 44,  6, 55, 20,
+     3, 10, 43, 25, 39,
+    41, 45, 15, 21,  8,
+    18,  2, 61, 56, 14
+};
+
+#define SHA3_XN_LANES   4
+#define SHA3_XN_VEC_T   sha3_x4_vec_t
+#define SHA3_XN_FUNC    s_sha3_256_x4_avx2
+#define SHA3_XN_TARGET  "avx2"
+#include "sha3/sha3_256_xN.h"
+
+#define SHA3_XN_LANES   8
+#define SHA3_XN_VEC_T   sha3_x8_vec_t
+#define SHA3_XN_FUNC    s_sha3_256_x8_avx512
+#define SHA3_XN_TARGET  "avx512f"
+#include "sha3/sha3_256_xN.h"
+
+typedef void (*sha3_256_multi_func_t)(const void * const *, const size_t *, dap_hash_fast_t *, size_t);
+
+static sha3_256_multi_func_t s_sha3_256_multi_func()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return s_sha3_256_x8_avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return s_sha3_256_x4_avx2;
+    return NULL;
+}
+#endif
+
+/**
+ * @brief dap_hash_fast_batch get SHA3_256 hashes of independent messages,
+ * they are hashed in parallel with SIMD instructions when CPU supports it
+ * @param a_data_in array of input data pointers
+ * @param a_data_in_size array of input data sizes
+ * @param a_hash_out array of output hashes, a_count size
+ * @param a_count messages count
+ * @return false if any input is empty, its hash is zeroed then, all others are hashed anyway
+ */
+bool dap_hash_fast_batch(const void * const *a_data_in, const size_t *a_data_in_size, dap_hash_fast_t *a_hash_out, size_t a_count)
+{
+    dap_return_val_if_fail(a_data_in && a_data_in_size && a_hash_out, false);
+    bool l_ret = true;
+    for (size_t i = 0; i < a_count; i++)
+        if (!a_data_in[i] || !a_data_in_size[i]) {
+            // Not a common case, process it as dap_hash_fast() does
+            l_ret = false;
+            break;
+        }
+    if (!l_ret || a_count < 2) {
+        for (size_t i = 0; i < a_count; i++)
+            if (!dap_hash_fast(a_data_in[i], a_data_in_size[i], a_hash_out + i))
+                memset(a_hash_out + i, 0, sizeof(dap_hash_fast_t));
+        return l_ret;
+    }
+#ifdef DAP_HASH_FAST_MULTI_LANE
+    sha3_256_multi_func_t l_multi_func = s_sha3_256_multi_func();
+    if (l_multi_func) {
+        l_multi_func(a_data_in, a_data_in_size, a_hash_out, a_count);
+        return true;
+    }
+#endif
+    for (size_t i = 0; i < a_count; i++)
+        dap_hash_fast(a_data_in[i], a_data_in_size[i], a_hash_out + i);
+    return true;
+}
+
 /**
  * @brief dap_chain_str_to_hash_fast_to_str
  * @param a_hash_str
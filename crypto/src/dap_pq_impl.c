@@ -0,0 +1,66 @@
+#include "dap_common.h"
+#include "dap_pq_impl.h"
+
+#define LOG_TAG "dap_pq_impl"
+
+static _Atomic dap_pq_impl_t s_pq_impl = DAP_PQ_IMPL_AUTO;
+
+/**
+ * @brief dap_pq_impl_supported check if the implementation is built in and CPU can run it
+ * @param a_impl implementation
+ * @return true if it could be used
+ */
+bool dap_pq_impl_supported(dap_pq_impl_t a_impl)
+{
+    switch (a_impl) {
+    case DAP_PQ_IMPL_AUTO:
+    case DAP_PQ_IMPL_REF:
+        return true;
+    case DAP_PQ_IMPL_AVX2:
+#ifdef DAP_PQ_AVX2
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("popcnt");
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief dap_pq_impl_set force Kyber, Dilithium and Falcon implementation
+ * @param a_impl implementation, DAP_PQ_IMPL_AUTO returns to the CPU detection
+ * @return 0 if ok, -1 if the implementation is not supported
+ */
+int dap_pq_impl_set(dap_pq_impl_t a_impl)
+{
+    if (!dap_pq_impl_supported(a_impl)) {
+        log_it(L_WARNING, "Implementation %s is not supported", dap_pq_impl_to_str(a_impl));
+        return -1;
+    }
+    s_pq_impl = a_impl;
+    return 0;
+}
+
+/**
+ * @brief dap_pq_impl_get implementation in use, CPU is detected on the first call
+ * @return implementation
+ */
+dap_pq_impl_t dap_pq_impl_get(void)
+{
+    dap_pq_impl_t l_impl = s_pq_impl;
+    if (l_impl == DAP_PQ_IMPL_AUTO)
+        s_pq_impl = l_impl = dap_pq_impl_supported(DAP_PQ_IMPL_AVX2) ? DAP_PQ_IMPL_AVX2 : DAP_PQ_IMPL_REF;
+    return l_impl;
+}
+
+const char *dap_pq_impl_to_str(dap_pq_impl_t a_impl)
+{
+    switch (a_impl) {
+    case DAP_PQ_IMPL_AUTO: return "auto";
+    case DAP_PQ_IMPL_REF: return "ref";
+    case DAP_PQ_IMPL_AVX2: return "avx2";
+    default: return "unknown";
+    }
+}
@@ -23,6 +23,7 @@
 */
 
 #include <string.h>
+#include <stdatomic.h>
 
 #include "dap_common.h"
 #include "dap_enc_key.h"
@@ -33,12 +34,57 @@
 #include "dap_json_rpc_errors.h"
 #include "dap_config.h"
 #include "dap_pkey.h"
+#include "dap_enc_dilithium.h"
+#include "uthash.h"
+#include "utlist.h"
 
 #define LOG_TAG "dap_sign"
 
+#define DAP_SIGN_PKEY_CACHE_SHARDS          16
+#define DAP_SIGN_PKEY_CACHE_SIZE_DEFAULT    256
+
+// Deserialized public key shared between verifications with the same signer
+typedef struct sign_pkey_cache_item {
+    dap_enc_key_t *key;
+    unsigned refs;                              // verifications using the key right now
+    bool evicted;                               // removed from cache, freed by the last user
+    struct sign_pkey_cache_item *prev, *next;   // LRU list, head is the most recently used
+    UT_hash_handle hh;
+    size_t pkey_size;
+    byte_t pkey[];
+} sign_pkey_cache_item_t;
+
+typedef struct sign_pkey_cache_shard {
+    pthread_mutex_t mutex;
+    sign_pkey_cache_item_t *items, *lru;
+    size_t count, limit;
+} sign_pkey_cache_shard_t;
+
+// Signatures batch, verified by caller thread together with verification pool threads
+typedef struct sign_verify_batch {
+    dap_sign_verify_item_t *items;
+    size_t count;
+    atomic_size_t taken;                        // items given out for verification
+    size_t done, workers;                       // guarded by pool mutex
+    bool queued;
+    struct sign_verify_batch *prev, *next;
+} sign_verify_batch_t;
+
+static struct sign_verify_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                        // new batch or stop for pool threads
+    pthread_cond_t done_cond;                   // batch items verified, for callers
+    pthread_t *threads;
+    uint32_t threads_count, threads_started;
+    uintptr_t generation;                       // threads of previous generations are stopping
+    sign_verify_batch_t *batches;
+} s_verify_pool = { .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER, .done_cond = PTHREAD_COND_INITIALIZER };
+
 static uint8_t s_sign_hash_type_default = DAP_SIGN_HASH_TYPE_SHA3;
 static bool s_dap_sign_debug_more = false;
 static dap_sign_callback_t s_get_pkey_by_hash_callback = NULL;
+static sign_pkey_cache_shard_t s_pkey_cache[DAP_SIGN_PKEY_CACHE_SHARDS];
+static bool s_pkey_cache_inited = false;
 
 /**
  * @brief dap_sign_init
@@ -49,9 +95,188 @@ int dap_sign_init(uint8_t a_sign_hash_type_default)
 {
     s_sign_hash_type_default = a_sign_hash_type_default;
     s_dap_sign_debug_more = dap_config_get_item_bool_default(g_config, "sign", "debug_more", false);
+    if (!s_pkey_cache_inited) {
+        for (size_t i = 0; i < DAP_SIGN_PKEY_CACHE_SHARDS; ++i)
+            pthread_mutex_init(&s_pkey_cache[i].mutex, NULL);
+        s_pkey_cache_inited = true;
+    }
+    dap_sign_pkey_cache_set_size(dap_config_get_item_uint32_default(g_config, "sign", "pkey_cache_size", DAP_SIGN_PKEY_CACHE_SIZE_DEFAULT));
+#ifdef DAP_OS_WINDOWS
+    SYSTEM_INFO l_sys_info;
+    GetSystemInfo(&l_sys_info);
+    uint32_t l_cpu_count = l_sys_info.dwNumberOfProcessors;
+#else
+    long l_cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    // Caller thread verifies its batch too
+    dap_sign_verify_batch_set_threads(dap_config_get_item_uint32_default(g_config, "sign", "verify_threads",
+                                                                         l_cpu_count > 1 ? l_cpu_count - 1 : 0));
     return 0;
 }
 
+/**
+ * @brief dap_sign_deinit drop all cached public keys
+ */
+void dap_sign_deinit()
+{
+    dap_sign_verify_batch_set_threads(0);
+    if (!s_pkey_cache_inited)
+        return;
+    dap_sign_pkey_cache_set_size(0);
+    for (size_t i = 0; i < DAP_SIGN_PKEY_CACHE_SHARDS; ++i)
+        pthread_mutex_destroy(&s_pkey_cache[i].mutex);
+    s_pkey_cache_inited = false;
+}
+
+static void s_pkey_cache_item_free(sign_pkey_cache_item_t *a_item)
+{
+    dap_enc_key_delete(a_item->key);
+    DAP_DELETE(a_item);
+}
+
+/**
+ * @brief s_pkey_cache_trim evict least recently used keys over the limit, shard must be locked
+ */
+static void s_pkey_cache_trim(sign_pkey_cache_shard_t *a_shard, size_t a_limit)
+{
+    while (a_shard->count > a_limit) {
+        sign_pkey_cache_item_t *l_item = a_shard->lru->prev;
+        DL_DELETE(a_shard->lru, l_item);
+        HASH_DELETE(hh, a_shard->items, l_item);
+        a_shard->count--;
+        if (l_item->refs)
+            l_item->evicted = true;
+        else
+            s_pkey_cache_item_free(l_item);
+    }
+}
+
+/**
+ * @brief dap_sign_pkey_cache_set_size set max number of deserialized public keys kept for verification
+ * @param a_size keys count, 0 disables the cache
+ */
+void dap_sign_pkey_cache_set_size(size_t a_size)
+{
+    if (!s_pkey_cache_inited)
+        return;
+    size_t l_limit = (a_size + DAP_SIGN_PKEY_CACHE_SHARDS - 1) / DAP_SIGN_PKEY_CACHE_SHARDS;
+    for (size_t i = 0; i < DAP_SIGN_PKEY_CACHE_SHARDS; ++i) {
+        pthread_mutex_lock(&s_pkey_cache[i].mutex);
+        s_pkey_cache[i].limit = l_limit;
+        s_pkey_cache_trim(s_pkey_cache + i, l_limit);
+        pthread_mutex_unlock(&s_pkey_cache[i].mutex);
+    }
+    debug_if(s_dap_sign_debug_more, L_DEBUG, "Public keys cache size set to %zu", l_limit * DAP_SIGN_PKEY_CACHE_SHARDS);
+}
+
+static bool s_pkey_cache_type_allowed(dap_enc_key_type_t a_type)
+{
+    // Only keys with stateless and read-only verification could be shared between threads
+    switch (a_type) {
+    case DAP_ENC_KEY_TYPE_SIG_DILITHIUM:
+    case DAP_ENC_KEY_TYPE_SIG_FALCON:
+    case DAP_ENC_KEY_TYPE_SIG_SPHINCSPLUS:
+#ifdef DAP_ECDSA
+    case DAP_ENC_KEY_TYPE_SIG_ECDSA:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
+static dap_enc_key_t *s_enc_key_from_pkey(dap_enc_key_type_t a_type, const uint8_t *a_pkey, size_t a_pkey_size)
+{
+    dap_enc_key_t *l_ret = dap_enc_key_new(a_type);
+    // deserialize public key
+    if (dap_enc_key_deserialize_pub_key(l_ret, a_pkey, a_pkey_size)) {
+        log_it(L_ERROR, "Error in enc pub key deserialize");
+        dap_enc_key_delete(l_ret);
+        l_ret = NULL;
+    }
+    return l_ret;
+}
+
+/**
+ * @brief s_pkey_cache_acquire get key for verification from cache or deserialize and cache it
+ * @param a_item output cache item to release after use, NULL if key isn't cached
+ * @return deserialized key or NULL if error
+ */
+static dap_enc_key_t *s_pkey_cache_acquire(dap_enc_key_type_t a_type, const uint8_t *a_pkey, size_t a_pkey_size, sign_pkey_cache_item_t **a_item)
+{
+    *a_item = NULL;
+    if (!s_pkey_cache_inited || !s_pkey_cache_type_allowed(a_type) || !a_pkey_size)
+        return s_enc_key_from_pkey(a_type, a_pkey, a_pkey_size);
+    unsigned l_hashv;
+    HASH_VALUE(a_pkey, a_pkey_size, l_hashv);
+    sign_pkey_cache_shard_t *l_shard = s_pkey_cache + l_hashv % DAP_SIGN_PKEY_CACHE_SHARDS;
+    sign_pkey_cache_item_t *l_item = NULL;
+    pthread_mutex_lock(&l_shard->mutex);
+    if (!l_shard->limit) {
+        pthread_mutex_unlock(&l_shard->mutex);
+        return s_enc_key_from_pkey(a_type, a_pkey, a_pkey_size);
+    }
+    HASH_FIND_BYHASHVALUE(hh, l_shard->items, a_pkey, a_pkey_size, l_hashv, l_item);
+    if (l_item && l_item->key->type == a_type) {
+        l_item->refs++;
+        DL_DELETE(l_shard->lru, l_item);
+        DL_PREPEND(l_shard->lru, l_item);
+        pthread_mutex_unlock(&l_shard->mutex);
+        *a_item = l_item;
+        return l_item->key;
+    }
+    pthread_mutex_unlock(&l_shard->mutex);
+    if (l_item) // Same pkey data for another key type, don't cache it
+        return s_enc_key_from_pkey(a_type, a_pkey, a_pkey_size);
+
+    dap_enc_key_t *l_key = s_enc_key_from_pkey(a_type, a_pkey, a_pkey_size);
+    if (!l_key)
+        return NULL;
+    // Precompute message independent verification data, it's worth only for long living keys
+    if (a_type == DAP_ENC_KEY_TYPE_SIG_DILITHIUM && dilithium_public_key_expand(l_key->pub_key_data))
+        log_it(L_WARNING, "Can't expand dilithium public key, use it as is");
+    sign_pkey_cache_item_t *l_new = DAP_NEW_Z_SIZE(sign_pkey_cache_item_t, sizeof(sign_pkey_cache_item_t) + a_pkey_size);
+    if (!l_new) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return l_key;
+    }
+    *l_new = (sign_pkey_cache_item_t) { .key = l_key, .refs = 1, .pkey_size = a_pkey_size };
+    memcpy(l_new->pkey, a_pkey, a_pkey_size);
+
+    pthread_mutex_lock(&l_shard->mutex);
+    // Another thread could deserialize the same key meanwhile
+    HASH_FIND_BYHASHVALUE(hh, l_shard->items, a_pkey, a_pkey_size, l_hashv, l_item);
+    if (l_item || !l_shard->limit) {
+        pthread_mutex_unlock(&l_shard->mutex);
+        DAP_DELETE(l_new);
+        return l_key;
+    }
+    HASH_ADD_KEYPTR_BYHASHVALUE(hh, l_shard->items, l_new->pkey, a_pkey_size, l_hashv, l_new);
+    DL_PREPEND(l_shard->lru, l_new);
+    l_shard->count++;
+    s_pkey_cache_trim(l_shard, l_shard->limit);
+    pthread_mutex_unlock(&l_shard->mutex);
+    *a_item = l_new;
+    return l_key;
+}
+
+/**
+ * @brief s_pkey_cache_release return key acquired with s_pkey_cache_acquire()
+ */
+static void s_pkey_cache_release(dap_enc_key_t *a_key, sign_pkey_cache_item_t *a_item)
+{
+    if (!a_item) {
+        dap_enc_key_delete(a_key);
+        return;
+    }
+    sign_pkey_cache_shard_t *l_shard = s_pkey_cache + a_item->hh.hashv % DAP_SIGN_PKEY_CACHE_SHARDS;
+    pthread_mutex_lock(&l_shard->mutex);
+    bool l_free = !--a_item->refs && a_item->evicted;
+    pthread_mutex_unlock(&l_shard->mutex);
+    if (l_free)
+        s_pkey_cache_item_free(a_item);
+}
+
 
 /**
  * @brief get signature size (different for specific crypto algorithm)
@@ -412,13 +637,7 @@ dap_enc_key_t *dap_sign_to_enc_key_by_pkey(dap_sign_t *a_chain_sign, dap_pkey_t
 
     size_t l_pkey_size = a_pkey ? a_pkey->header.size : 0;
     uint8_t *l_pkey = a_pkey ? a_pkey->pkey : dap_sign_get_pkey(a_chain_sign, &l_pkey_size);
-    dap_enc_key_t * l_ret =  dap_enc_key_new(l_type);
-    // deserialize public key
-    if (dap_enc_key_deserialize_pub_key(l_ret, l_pkey, l_pkey_size)) {
-        log_it(L_ERROR, "Error in enc pub key deserialize");
-        DAP_DEL_Z(l_ret);
-    }
-    return l_ret;
+    return s_enc_key_from_pkey(l_type, l_pkey, l_pkey_size);
 }
 
 /**
@@ -433,7 +652,12 @@ int dap_sign_verify_by_pkey(dap_sign_t *a_chain_sign, const void *a_data, const
 {
     dap_return_val_if_pass(!a_chain_sign || !a_data, -2);
 
-    dap_enc_key_t *l_key = dap_sign_to_enc_key_by_pkey(a_chain_sign, a_pkey);
+    dap_enc_key_type_t l_type = dap_sign_type_to_key_type(a_chain_sign->header.type);
+    size_t l_pkey_size = a_pkey ? a_pkey->header.size : 0;
+    uint8_t *l_pkey = a_pkey ? a_pkey->pkey : dap_sign_get_pkey(a_chain_sign, &l_pkey_size);
+    sign_pkey_cache_item_t *l_cache_item = NULL;
+    dap_enc_key_t *l_key = l_type == DAP_ENC_KEY_TYPE_INVALID ? NULL
+                         : s_pkey_cache_acquire(l_type, l_pkey, l_pkey_size, &l_cache_item);
     if ( !l_key ){
         log_it(L_WARNING,"Incorrect signature, can't extract key");
         return -3;
@@ -442,7 +666,7 @@ int dap_sign_verify_by_pkey(dap_sign_t *a_chain_sign, const void *a_data, const
     uint8_t *l_sign_data_ser = dap_sign_get_sign(a_chain_sign, &l_sign_data_ser_size);
 
     if ( !l_sign_data_ser ){
-        dap_enc_key_delete(l_key);
+        s_pkey_cache_release(l_key, l_cache_item);
         log_it(L_WARNING,"Incorrect signature, can't extract serialized signature's data ");
         return -4;
     }
@@ -453,7 +677,7 @@ int dap_sign_verify_by_pkey(dap_sign_t *a_chain_sign, const void *a_data, const
 
     if ( !l_sign_data ){
         log_it(L_WARNING,"Incorrect signature, can't deserialize signature's data");
-        dap_enc_key_delete(l_key);
+        s_pkey_cache_release(l_key, l_cache_item);
         return -5;
     }
 
@@ -475,7 +699,7 @@ int dap_sign_verify_by_pkey(dap_sign_t *a_chain_sign, const void *a_data, const
             case DAP_SIGN_HASH_TYPE_SHA3: dap_hash_fast(a_data,a_data_size,&l_verify_data_hash); break;
             default: log_it(L_CRITICAL, "Incorrect signature: we can't check hash with hash type 0x%02x", s_sign_hash_type_default);
             dap_enc_key_signature_delete(l_key->type, l_sign_data);
-            dap_enc_key_delete(l_key);
+            s_pkey_cache_release(l_key, l_cache_item);
             return -5;
         }
     }
@@ -500,11 +724,138 @@ int dap_sign_verify_by_pkey(dap_sign_t *a_chain_sign, const void *a_data, const
             l_ret = -6;
     }
     dap_enc_key_signature_delete(l_key->type, l_sign_data);
-    dap_enc_key_delete(l_key);
+    s_pkey_cache_release(l_key, l_cache_item);
     return l_ret;
 }
 
 
+/**
+ * @brief s_verify_batch_process verify batch items until all of them are taken
+ * @return count of items verified by this thread
+ */
+static size_t s_verify_batch_process(sign_verify_batch_t *a_batch)
+{
+    size_t i, l_processed = 0;
+    for ( ; (i = atomic_fetch_add(&a_batch->taken, 1)) < a_batch->count; ++l_processed) {
+        dap_sign_verify_item_t *l_item = a_batch->items + i;
+        l_item->result = dap_sign_verify_by_pkey(l_item->sign, l_item->data, l_item->data_size, l_item->pkey);
+    }
+    return l_processed;
+}
+
+static void *s_verify_pool_thread(void *a_arg)
+{
+    uintptr_t l_generation = (uintptr_t)a_arg;
+    pthread_mutex_lock(&s_verify_pool.mutex);
+    // Pool restarted while this thread was busy doesn't keep it alive
+    while (s_verify_pool.generation == l_generation) {
+        sign_verify_batch_t *l_batch = s_verify_pool.batches;
+        if (!l_batch) {
+            pthread_cond_wait(&s_verify_pool.cond, &s_verify_pool.mutex);
+            continue;
+        }
+        if (atomic_load(&l_batch->taken) >= l_batch->count) {
+            DL_DELETE(s_verify_pool.batches, l_batch);
+            l_batch->queued = false;
+            continue;
+        }
+        l_batch->workers++;
+        pthread_mutex_unlock(&s_verify_pool.mutex);
+        size_t l_processed = s_verify_batch_process(l_batch);
+        pthread_mutex_lock(&s_verify_pool.mutex);
+        l_batch->done += l_processed;
+        if (!--l_batch->workers && l_batch->done == l_batch->count)
+            pthread_cond_broadcast(&s_verify_pool.done_cond);
+    }
+    pthread_mutex_unlock(&s_verify_pool.mutex);
+    return NULL;
+}
+
+/**
+ * @brief s_verify_pool_start start verification threads, pool mutex must be locked
+ */
+static void s_verify_pool_start()
+{
+    s_verify_pool.threads = DAP_NEW_Z_COUNT(pthread_t, s_verify_pool.threads_count);
+    if (!s_verify_pool.threads) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        s_verify_pool.threads_count = 0;
+        return;
+    }
+    for (s_verify_pool.threads_started = 0; s_verify_pool.threads_started < s_verify_pool.threads_count; s_verify_pool.threads_started++)
+        if (pthread_create(s_verify_pool.threads + s_verify_pool.threads_started, NULL, s_verify_pool_thread,
+                           (void *)s_verify_pool.generation)) {
+            log_it(L_ERROR, "Can't start signature verification thread");
+            break;
+        }
+    debug_if(s_dap_sign_debug_more, L_DEBUG, "Started %u signature verification threads", s_verify_pool.threads_started);
+}
+
+/**
+ * @brief dap_sign_verify_batch_set_threads set count of threads helping to verify signatures batches
+ * @param a_threads_count threads count, 0 to verify batches in caller thread only
+ */
+void dap_sign_verify_batch_set_threads(uint32_t a_threads_count)
+{
+    pthread_mutex_lock(&s_verify_pool.mutex);
+    pthread_t *l_threads = s_verify_pool.threads;
+    uint32_t l_started = s_verify_pool.threads_started;
+    s_verify_pool.generation++;
+    s_verify_pool.threads = NULL;
+    s_verify_pool.threads_started = 0;
+    s_verify_pool.threads_count = a_threads_count;
+    pthread_cond_broadcast(&s_verify_pool.cond);
+    pthread_mutex_unlock(&s_verify_pool.mutex);
+    // Threads are started again by the next batch. Stopped ones are joined by this caller only,
+    // they exit even if the next batch has already started the new generation
+    for (uint32_t i = 0; i < l_started; ++i)
+        pthread_join(l_threads[i], NULL);
+    DAP_DELETE(l_threads);
+}
+
+/**
+ * @brief dap_sign_verify_batch verify signatures batch in parallel
+ * @param a_items items to verify, result field is set for each of them
+ * @param a_count items count
+ * @return count of items with invalid signature
+ */
+size_t dap_sign_verify_batch(dap_sign_verify_item_t *a_items, size_t a_count)
+{
+    dap_return_val_if_fail(a_items, a_count);
+    sign_verify_batch_t l_batch = { .items = a_items, .count = a_count };
+    bool l_shared = false;
+    pthread_mutex_lock(&s_verify_pool.mutex);
+    if (a_count > 1 && s_verify_pool.threads_count) {
+        if (!s_verify_pool.threads_started)
+            s_verify_pool_start();
+        if (s_verify_pool.threads_started) {
+            l_shared = l_batch.queued = true;
+            DL_APPEND(s_verify_pool.batches, &l_batch);
+            pthread_cond_broadcast(&s_verify_pool.cond);
+        }
+    }
+    pthread_mutex_unlock(&s_verify_pool.mutex);
+
+    size_t l_processed = s_verify_batch_process(&l_batch);
+    if (l_shared) {
+        pthread_mutex_lock(&s_verify_pool.mutex);
+        // All items are taken already, nothing to do for pool threads
+        if (l_batch.queued) {
+            DL_DELETE(s_verify_pool.batches, &l_batch);
+            l_batch.queued = false;
+        }
+        l_batch.done += l_processed;
+        while (l_batch.done != a_count || l_batch.workers)
+            pthread_cond_wait(&s_verify_pool.done_cond, &s_verify_pool.mutex);
+        pthread_mutex_unlock(&s_verify_pool.mutex);
+    }
+    size_t l_failed = 0;
+    for (size_t i = 0; i < a_count; ++i)
+        if (a_items[i].result)
+            l_failed++;
+    return l_failed;
+}
+
 /**
  * @brief Get size of struct dap_sign_t
  * 
@@ -0,0 +1,44 @@
+/*
+ * AVX2 build of Falcon, selected at runtime by dap_pq_impl (see dap_enc_falcon.c).
+ * The whole implementation is compiled once more in its own namespace, as inner.h suggests.
+ * FMA is off, so keys and signatures are bit-exact with the portable build for the same seeds
+ */
+#ifdef DAP_PQ_AVX2
+
+#define FALCON_AVX2     1
+#define FALCON_FMA      0
+#define FALCON_PREFIX   falcon_inner_avx2
+
+#define shake256_init                   falcon_avx2_shake256_init
+#define shake256_inject                 falcon_avx2_shake256_inject
+#define shake256_flip                   falcon_avx2_shake256_flip
+#define shake256_extract                falcon_avx2_shake256_extract
+#define shake256_init_prng_from_seed    falcon_avx2_shake256_init_prng_from_seed
+#define shake256_init_prng_from_system  falcon_avx2_shake256_init_prng_from_system
+#define falcon_keygen_make              falcon_avx2_keygen_make
+#define falcon_make_public              falcon_avx2_make_public
+#define falcon_get_logn                 falcon_avx2_get_logn
+#define falcon_sign_dyn                 falcon_avx2_sign_dyn
+#define falcon_expand_privkey           falcon_avx2_expand_privkey
+#define falcon_sign_tree                falcon_avx2_sign_tree
+#define falcon_sign_start               falcon_avx2_sign_start
+#define falcon_sign_dyn_finish          falcon_avx2_sign_dyn_finish
+#define falcon_sign_tree_finish         falcon_avx2_sign_tree_finish
+#define falcon_verify                   falcon_avx2_verify
+#define falcon_verify_start             falcon_avx2_verify_start
+#define falcon_verify_finish            falcon_avx2_verify_finish
+
+#include "codec.c"
+#include "common.c"
+#include "fft.c"
+#include "fpr.c"
+#define align_fpr keygen_align_fpr  // falcon.c has the other one
+#include "keygen.c"
+#undef align_fpr
+#include "rng.c"
+#include "shake.c"
+#include "sign.c"
+#include "vrfy.c"
+#include "falcon.c"
+
+#endif
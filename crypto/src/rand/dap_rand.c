@@ -1,5 +1,6 @@
 #include "dap_rand.h"
 #include <stdlib.h>
+#include <string.h>
 //#define SHISHUA_TARGET 0    // SHISHUA_TARGET_SCALAR
 #include "shishua.h"
 
@@ -8,6 +9,11 @@
 #else
     #include <unistd.h>
     #include <fcntl.h>
+    #include <errno.h>
+    #include <pthread.h>
+#if defined(__linux__)
+    #include <sys/syscall.h>
+#endif
     static int lock = -1;
 #endif
 
@@ -74,9 +80,14 @@ int randombase64(void*random_array, unsigned int size)
 }
 
 
-int randombytes(void* random_array, unsigned int nbytes)
-{ // Generation of "nbytes" of random values
-    
+/**
+ * @brief s_entropy_get fill the buffer from OS entropy source. Syscall per call, so it's for DRBG seeding only
+ * @param a_buf output buffer
+ * @param a_size output size
+ * @return passed or failed
+ */
+static int s_entropy_get(void *a_buf, size_t a_size)
+{
 #if defined(_WIN32)
     HCRYPTPROV p;
 
@@ -84,14 +95,25 @@ int randombytes(void* random_array, unsigned int nbytes)
       return failed;
     }
 
-    if (CryptGenRandom(p, nbytes, (BYTE*)random_array) == FALSE) {
+    if (CryptGenRandom(p, a_size, (BYTE*)a_buf) == FALSE) {
       return failed;
     }
 
     CryptReleaseContext(p, 0);
     return passed;
 #else
-    int r, n = (int)nbytes, count = 0;
+    size_t l_done = 0;
+#if defined(__linux__) && defined(SYS_getrandom)
+    while (l_done < a_size) {
+        long r = syscall(SYS_getrandom, (char*)a_buf + l_done, a_size - l_done, 0);
+        if (r > 0)
+            l_done += r;
+        else if (errno != EINTR)
+            break;  // Old kernel without getrandom(), go to /dev/urandom
+    }
+    if (l_done == a_size)
+        return passed;
+#endif
     if (lock == -1) {
         do {
             lock = open("/dev/urandom", O_RDONLY);
@@ -101,17 +123,127 @@ int randombytes(void* random_array, unsigned int nbytes)
         } while (lock == -1);
     }
 
-    for(int i = 0; i < n;){
-        r = read(lock, (char*)random_array+i, n);
+    while (l_done < a_size) {
+        ssize_t r = read(lock, (char*)a_buf + l_done, a_size - l_done);
         if (r >= 0){
-            i += r;
+            l_done += r;
         } else{
             delay(0xFFFF);
         }
     }
+    return passed;
+#endif
+}
+
+/*** Per-thread buffered CSPRNG section ***/
+
+// ChaCha20 DRBG with fast key erasure: every refill produces the next key at the head of the keystream,
+// so the current state can't recover random bytes already given out. Reseeded from OS entropy periodically
+// and after fork(), so parent and child never share the output
+
+#define DAP_RAND_KEY_SIZE       32
+#define DAP_RAND_BLOCK_SIZE     64
+#define DAP_RAND_BUF_SIZE       (16 * DAP_RAND_BLOCK_SIZE)
+#define DAP_RAND_RESEED_BYTES   (1024 * 1024)
+
+typedef struct dap_rand_drbg {
+    uint32_t key[DAP_RAND_KEY_SIZE / 4];
+    uint8_t buf[DAP_RAND_BUF_SIZE];
+    size_t buf_pos;
+    size_t reseed_left;
+    unsigned fork_gen;
+    bool seeded;
+} dap_rand_drbg_t;
+
+static _Thread_local dap_rand_drbg_t s_drbg;
+static atomic_uint s_fork_gen = 0;
+
+#define DAP_RAND_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define DAP_RAND_QR(x, a, b, c, d)                                      \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = DAP_RAND_ROTL(x[d], 16);         \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = DAP_RAND_ROTL(x[b], 12);         \
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = DAP_RAND_ROTL(x[d], 8);          \
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = DAP_RAND_ROTL(x[b], 7);
+
+static void s_chacha20_block(const uint32_t *a_key, uint32_t a_counter, uint8_t *a_out)
+{
+    uint32_t l_state[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 }, x[16];
+    memcpy(l_state + 4, a_key, DAP_RAND_KEY_SIZE);
+    l_state[12] = a_counter;    // Nonce is zero, every block is made with the new key
+    memcpy(x, l_state, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        DAP_RAND_QR(x, 0, 4,  8, 12) DAP_RAND_QR(x, 1, 5,  9, 13)
+        DAP_RAND_QR(x, 2, 6, 10, 14) DAP_RAND_QR(x, 3, 7, 11, 15)
+        DAP_RAND_QR(x, 0, 5, 10, 15) DAP_RAND_QR(x, 1, 6, 11, 12)
+        DAP_RAND_QR(x, 2, 7,  8, 13) DAP_RAND_QR(x, 3, 4,  9, 14)
+    }
+    for (int i = 0; i < 16; i++) {
+        uint32_t l_word = x[i] + l_state[i];
+        a_out[i * 4] = l_word; a_out[i * 4 + 1] = l_word >> 8; a_out[i * 4 + 2] = l_word >> 16; a_out[i * 4 + 3] = l_word >> 24;
+    }
+}
+
+#if !defined(_WIN32)
+static void s_atfork_child(void)
+{
+    atomic_fetch_add(&s_fork_gen, 1);
+}
 
+static void s_atfork_register(void)
+{
+    pthread_atfork(NULL, NULL, s_atfork_child);
+}
 #endif
 
+static int s_drbg_reseed(dap_rand_drbg_t *a_drbg)
+{
+#if !defined(_WIN32)
+    static pthread_once_t s_atfork_once = PTHREAD_ONCE_INIT;
+    pthread_once(&s_atfork_once, s_atfork_register);
+#endif
+    uint32_t l_seed[DAP_RAND_KEY_SIZE / 4];
+    if (s_entropy_get(l_seed, sizeof(l_seed)) != passed)
+        return failed;
+    // Mix new entropy into the key, so the state stays unpredictable even if one of them is weak
+    for (size_t i = 0; i < DAP_RAND_KEY_SIZE / 4; i++)
+        a_drbg->key[i] ^= l_seed[i];
+    memset(l_seed, 0, sizeof(l_seed));
+    a_drbg->fork_gen = atomic_load(&s_fork_gen);
+    a_drbg->reseed_left = DAP_RAND_RESEED_BYTES;
+    a_drbg->buf_pos = DAP_RAND_BUF_SIZE;
+    a_drbg->seeded = true;
+    return passed;
+}
+
+static void s_drbg_refill(dap_rand_drbg_t *a_drbg)
+{
+    for (uint32_t i = 0; i < DAP_RAND_BUF_SIZE / DAP_RAND_BLOCK_SIZE; i++)
+        s_chacha20_block(a_drbg->key, i, a_drbg->buf + i * DAP_RAND_BLOCK_SIZE);
+    // Take the new key and erase it from the output
+    memcpy(a_drbg->key, a_drbg->buf, DAP_RAND_KEY_SIZE);
+    memset(a_drbg->buf, 0, DAP_RAND_KEY_SIZE);
+    a_drbg->buf_pos = DAP_RAND_KEY_SIZE;
+}
+
+int randombytes(void* random_array, unsigned int nbytes)
+{ // Generation of "nbytes" of random values
+    dap_rand_drbg_t *l_drbg = &s_drbg;
+    if ( (!l_drbg->seeded || !l_drbg->reseed_left || l_drbg->fork_gen != atomic_load(&s_fork_gen))
+            && s_drbg_reseed(l_drbg) != passed )
+        return failed;
+    uint8_t *l_out = random_array;
+    size_t l_left = nbytes;
+    while (l_left) {
+        if (l_drbg->buf_pos == DAP_RAND_BUF_SIZE)
+            s_drbg_refill(l_drbg);
+        size_t l_size = dap_min(l_left, (size_t)DAP_RAND_BUF_SIZE - l_drbg->buf_pos);
+        memcpy(l_out, l_drbg->buf + l_drbg->buf_pos, l_size);
+        memset(l_drbg->buf + l_drbg->buf_pos, 0, l_size);   // Given out bytes must not stay in memory
+        l_drbg->buf_pos += l_size;
+        l_out += l_size;
+        l_left -= l_size;
+    }
+    l_drbg->reseed_left = l_drbg->reseed_left > nbytes ? l_drbg->reseed_left - nbytes : 0;
     return passed;
 }
 
@@ -0,0 +1,100 @@
+/********************************************************************************************
+* Multi-lane SHA3-256: hashes SHA3_XN_LANES independent messages at once, every SIMD lane
+* keeps the Keccak-f[1600] state of its own message. When lane's message is over the lane
+* takes the next one, so messages of different sizes don't wait for each other.
+*
+* It's a template, define before include:
+*   SHA3_XN_LANES   lanes count
+*   SHA3_XN_VEC_T   name of lanes vector type
+*   SHA3_XN_FUNC    name of the hash function
+*   SHA3_XN_TARGET  instruction set for the function, as for __attribute__((target))
+* s_sha3_xn_rc[] round constants and s_sha3_xn_rho[] rotation offsets tables must be defined before include too,
+* SHA3_XN_RATE too. Little endian target only
+*********************************************************************************************/
+
+typedef uint64_t SHA3_XN_VEC_T __attribute__((vector_size(SHA3_XN_LANES * sizeof(uint64_t))));
+
+__attribute__((target(SHA3_XN_TARGET)))
+static void SHA3_XN_FUNC(const void * const *a_data_in, const size_t *a_data_in_size, dap_hash_fast_t *a_hash_out, size_t a_count)
+{
+    SHA3_XN_VEC_T A[25] = { }, B[25], C[5], D;
+    const uint8_t *l_msg[SHA3_XN_LANES];
+    size_t l_left[SHA3_XN_LANES];
+    dap_hash_fast_t *l_out[SHA3_XN_LANES] = { };
+    bool l_final[SHA3_XN_LANES];
+    uint8_t l_block[SHA3_XN_RATE];
+    size_t l_next = 0;
+    for (;;) {
+        unsigned l_active = 0;
+        for (unsigned j = 0; j < SHA3_XN_LANES; j++) {
+            if (!l_out[j] && l_next < a_count) {
+                l_msg[j] = a_data_in[l_next];
+                l_left[j] = a_data_in_size[l_next];
+                l_out[j] = a_hash_out + l_next++;
+                for (unsigned w = 0; w < 25; w++)
+                    A[w][j] = 0;
+            }
+            if (!l_out[j])
+                continue;
+            l_active++;
+            // Absorb one block of the lane message
+            const uint8_t *l_src = l_msg[j];
+            if ((l_final[j] = l_left[j] < SHA3_XN_RATE)) {
+                memset(l_block, 0, SHA3_XN_RATE);
+                memcpy(l_block, l_msg[j], l_left[j]);
+                l_block[l_left[j]] ^= 0x06;
+                l_block[SHA3_XN_RATE - 1] ^= 0x80;
+                l_src = l_block;
+            } else {
+                l_msg[j] += SHA3_XN_RATE;
+                l_left[j] -= SHA3_XN_RATE;
+            }
+            for (unsigned w = 0; w < SHA3_XN_RATE / 8; w++) {
+                uint64_t l_word;
+                memcpy(&l_word, l_src + w * 8, 8);
+                A[w][j] ^= l_word;
+            }
+        }
+        if (!l_active)
+            break;
+        // Keccak-f[1600] for all lanes
+        for (unsigned r = 0; r < 24; r++) {
+#pragma GCC unroll 5
+            for (unsigned x = 0; x < 5; x++)
+                C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
+#pragma GCC unroll 5
+            for (unsigned x = 0; x < 5; x++) {
+                D = C[(x + 4) % 5] ^ ((C[(x + 1) % 5] << 1) | (C[(x + 1) % 5] >> 63));
+#pragma GCC unroll 5
+                for (unsigned y = 0; y < 25; y += 5)
+                    A[y + x] ^= D;
+            }
+#pragma GCC unroll 25
+            for (unsigned i = 0; i < 25; i++) {
+                unsigned x = i % 5, y = i / 5, l_rho = s_sha3_xn_rho[i];
+                B[y + 5 * ((2 * x + 3 * y) % 5)] = l_rho ? (A[i] << l_rho) | (A[i] >> (64 - l_rho)) : A[i];
+            }
+#pragma GCC unroll 25
+            for (unsigned i = 0; i < 25; i++) {
+                unsigned x = i % 5, y = i - x;
+                A[i] = B[i] ^ (~B[y + (x + 1) % 5] & B[y + (x + 2) % 5]);
+            }
+            A[0] ^= s_sha3_xn_rc[r];
+        }
+        // Squeeze finished lanes
+        for (unsigned j = 0; j < SHA3_XN_LANES; j++) {
+            if (!l_out[j] || !l_final[j])
+                continue;
+            for (unsigned w = 0; w < DAP_HASH_FAST_SIZE / 8; w++) {
+                uint64_t l_word = A[w][j];
+                memcpy(l_out[j]->raw + w * 8, &l_word, 8);
+            }
+            l_out[j] = NULL;
+        }
+    }
+}
+
+#undef SHA3_XN_LANES
+#undef SHA3_XN_VEC_T
+#undef SHA3_XN_FUNC
+#undef SHA3_XN_TARGET
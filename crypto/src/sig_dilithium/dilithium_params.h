@@ -62,6 +62,7 @@ typedef struct {
 typedef struct {
   dilithium_kind_t kind;                 /* the kind of dilithium       */
   unsigned char *data;
+  void *expanded;                        /* precomputed verification data, see dilithium_public_key_expand() */
 } dilithium_public_key_t;
 
 typedef struct {
@@ -81,6 +82,8 @@ int dilithium_crypto_sign(dilithium_signature_t *, const unsigned char *, unsign
 
 int dilithium_crypto_sign_open( unsigned char *, unsigned long long, dilithium_signature_t *, const dilithium_public_key_t *);
 
+int dilithium_public_key_expand(dilithium_public_key_t *public_key);
+
 void dilithium_private_key_delete(void *private_key);
 void dilithium_public_key_delete(void *public_key);
 void dilithium_private_and_public_keys_delete(void *private_key, void *public_key);
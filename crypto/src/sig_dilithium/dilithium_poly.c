@@ -1,6 +1,96 @@
 #include <stdint.h>
 #include "dilithium_poly.h"
 #include "fips202.h"
+#include "dap_pq_impl.h"
+
+#ifdef DAP_PQ_AVX2
+#include <immintrin.h>
+
+/*
+ * AVX2 NTT and pointwise multiplication, eight coefficients per instruction. Results are bit-exact
+ * with the portable code, including 32-bit wrap-arounds, so keys and signatures don't depend on the CPU
+ */
+
+// montgomery_reduce(a * b) for every 32-bit lane
+__attribute__((target("avx2")))
+static inline __m256i s_montgomery_mul_x8(__m256i a, __m256i b)
+{
+    const __m256i l_qinv = _mm256_set1_epi32((int32_t)QINV), l_q = _mm256_set1_epi32((int32_t)Q);
+    __m256i l_even = _mm256_mul_epu32(a, b),
+            l_odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i l_t_even = _mm256_mul_epu32(_mm256_mul_epu32(l_even, l_qinv), l_q),
+            l_t_odd = _mm256_mul_epu32(_mm256_mul_epu32(l_odd, l_qinv), l_q);
+    l_even = _mm256_srli_epi64(_mm256_add_epi64(l_even, l_t_even), 32);
+    l_odd = _mm256_add_epi64(l_odd, l_t_odd);
+    return _mm256_blend_epi32(l_even, l_odd, 0xAA);
+}
+
+__attribute__((target("avx2")))
+static void s_ntt_avx2(uint32_t pp[NN], const uint32_t *a_zetas)
+{
+    unsigned int len, start, j, k = 1;
+    const __m256i l_2q = _mm256_set1_epi32((int32_t)(2 * Q));
+    for (len = 128; len >= 8; len >>= 1)
+        for (start = 0; start < NN; start += 2 * len) {
+            __m256i l_zeta = _mm256_set1_epi32((int32_t)a_zetas[k++]);
+            for (j = start; j < start + len; j += 8) {
+                __m256i l_lo = _mm256_loadu_si256((__m256i *)(pp + j)),
+                        l_hi = _mm256_loadu_si256((__m256i *)(pp + j + len)),
+                        l_t = s_montgomery_mul_x8(l_zeta, l_hi);
+                _mm256_storeu_si256((__m256i *)(pp + j + len), _mm256_sub_epi32(_mm256_add_epi32(l_lo, l_2q), l_t));
+                _mm256_storeu_si256((__m256i *)(pp + j), _mm256_add_epi32(l_lo, l_t));
+            }
+        }
+    for ( ; len > 0; len >>= 1)
+        for (start = 0; start < NN; start += 2 * len) {
+            uint32_t l_zeta = a_zetas[k++];
+            for (j = start; j < start + len; ++j) {
+                uint32_t t = montgomery_reduce((uint64_t)l_zeta * pp[j + len]);
+                pp[j + len] = pp[j] + 2*Q - t;
+                pp[j] = pp[j] + t;
+            }
+        }
+}
+
+__attribute__((target("avx2")))
+static void s_invntt_avx2(uint32_t pp[NN], const uint32_t *a_zetas_inv, uint32_t a_f)
+{
+    unsigned int len, start, j, k = 0;
+    for (len = 1; len < 8; len <<= 1)
+        for (start = 0; start < NN; start += 2 * len) {
+            uint32_t l_zeta = a_zetas_inv[k++];
+            for (j = start; j < start + len; ++j) {
+                uint32_t t = pp[j];
+                pp[j] = t + pp[j + len];
+                pp[j + len] = t + 256*Q - pp[j + len];
+                pp[j + len] = montgomery_reduce((uint64_t)l_zeta * pp[j + len]);
+            }
+        }
+    const __m256i l_256q = _mm256_set1_epi32((int32_t)(256 * Q));
+    for ( ; len < NN; len <<= 1)
+        for (start = 0; start < NN; start += 2 * len) {
+            __m256i l_zeta = _mm256_set1_epi32((int32_t)a_zetas_inv[k++]);
+            for (j = start; j < start + len; j += 8) {
+                __m256i l_lo = _mm256_loadu_si256((__m256i *)(pp + j)),
+                        l_hi = _mm256_loadu_si256((__m256i *)(pp + j + len));
+                _mm256_storeu_si256((__m256i *)(pp + j), _mm256_add_epi32(l_lo, l_hi));
+                l_hi = _mm256_sub_epi32(_mm256_add_epi32(l_lo, l_256q), l_hi);
+                _mm256_storeu_si256((__m256i *)(pp + j + len), s_montgomery_mul_x8(l_zeta, l_hi));
+            }
+        }
+    __m256i l_f = _mm256_set1_epi32((int32_t)a_f);
+    for (j = 0; j < NN; j += 8)
+        _mm256_storeu_si256((__m256i *)(pp + j), s_montgomery_mul_x8(l_f, _mm256_loadu_si256((__m256i *)(pp + j))));
+}
+
+__attribute__((target("avx2")))
+static void s_pointwise_avx2(poly *c, const poly *a, const poly *b)
+{
+    for (unsigned int i = 0; i < NN; i += 8)
+        _mm256_storeu_si256((__m256i *)(c->coeffs + i), s_montgomery_mul_x8(_mm256_loadu_si256((__m256i *)(a->coeffs + i)),
+                                                                           _mm256_loadu_si256((__m256i *)(b->coeffs + i))));
+}
+#endif
 
 /*************************************************/
 void poly_reduce(poly *a) {
@@ -74,6 +164,13 @@ void poly_invntt_montgomery(poly *a) {
 void poly_pointwise_invmontgomery(poly *c, const poly *a, const poly *b) {
   unsigned int i;
 
+#ifdef DAP_PQ_AVX2
+  if (dap_pq_impl_get() == DAP_PQ_IMPL_AVX2) {
+    s_pointwise_avx2(c, a, b);
+    return;
+  }
+#endif
+
   for(i = 0; i < NN; ++i)
     c->coeffs[i] = montgomery_reduce((uint64_t)a->coeffs[i] * b->coeffs[i]);
 }
@@ -566,6 +663,12 @@ void dilithium_ntt(uint32_t pp[NN])
     unsigned int len, start, j, k;
     uint32_t zeta, t;
 
+#ifdef DAP_PQ_AVX2
+    if (dap_pq_impl_get() == DAP_PQ_IMPL_AVX2) {
+        s_ntt_avx2(pp, zetas);
+        return;
+    }
+#endif
     k = 1;
     for(len = 128; len > 0; len >>= 1)
     {
@@ -589,6 +692,12 @@ void invntt_frominvmont(uint32_t pp[NN])
     uint32_t t, zeta;
     const uint32_t f = (((uint64_t)MONT*MONT % Q) * (Q-1) % Q) * ((Q-1) >> 8) % Q;
 
+#ifdef DAP_PQ_AVX2
+    if (dap_pq_impl_get() == DAP_PQ_IMPL_AVX2) {
+        s_invntt_avx2(pp, zetas_inv, f);
+        return;
+    }
+#endif
     k = 0;
     for(len = 1; len < NN; len <<= 1)
     {
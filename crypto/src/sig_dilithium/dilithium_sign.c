@@ -77,6 +77,14 @@ void challenge(poly *c, const unsigned char mu[CRHBYTES], const polyveck *w1, di
     }
 }
 
+/********************************************************************************************/
+/* Public key data independent of a message: it's computed once for keys verifying many signatures */
+typedef struct {
+  unsigned char tr[CRHBYTES];            /* SHAKE256 of the packed public key */
+  polyveck t1;                           /* t1 * 2^D in NTT domain */
+  polyvecl mat[];                        /* expanded matrix A, PARAM_K rows */
+} dilithium_public_key_expanded_t;
+
 /********************************************************************************************/
 void dilithium_private_key_delete(void *private_key)
 {
@@ -87,7 +95,7 @@ void dilithium_private_key_delete(void *private_key)
 void dilithium_public_key_delete(void *public_key)
 {
     dap_return_if_pass(!public_key);
-    DAP_DEL_MULTY(((dilithium_public_key_t *)public_key)->data, public_key);
+    DAP_DEL_MULTY(((dilithium_public_key_t *)public_key)->expanded, ((dilithium_public_key_t *)public_key)->data, public_key);
 }
 
 void dilithium_private_and_public_keys_delete(void *a_skey, void *a_pkey)
@@ -113,6 +121,7 @@ static int32_t dilithium_private_and_public_keys_init(dilithium_private_key_t *p
     }
     public_key->kind = p->kind;
     public_key->data = f;
+    public_key->expanded = NULL;
 
     g = calloc(p->CRYPTO_SECRETKEYBYTES, sizeof(unsigned char));
     if (g == NULL) {
@@ -338,15 +347,19 @@ int dilithium_crypto_sign_open( unsigned char *m, unsigned long long mlen, dilit
     unsigned char rho[SEEDBYTES];
     unsigned char mu[CRHBYTES];    
     poly c, chat, cp;
-    polyvecl mat[p->PARAM_K], z;
+    const dilithium_public_key_expanded_t *l_expanded = public_key->expanded;
+    polyvecl mat[l_expanded ? 1 : p->PARAM_K], z;
     polyveck t1, w1, h, tmp1, tmp2;
+    const polyvecl *l_mat = l_expanded ? l_expanded->mat : mat;
+    const polyveck *l_t1 = l_expanded ? &l_expanded->t1 : &t1;
 
     if((sig->sig_len - p->CRYPTO_BYTES) != mlen) {
         free(p);
         return -4;
     }
 
-    dilithium_unpack_pk(rho, &t1, public_key->data, p);
+    if (!l_expanded)
+        dilithium_unpack_pk(rho, &t1, public_key->data, p);
     if(dilithium_unpack_sig(&z, &h, &c, sig->sig_data, p)) {
         free(p);
         return -5;
@@ -368,21 +381,26 @@ int dilithium_crypto_sign_open( unsigned char *m, unsigned long long mlen, dilit
 
     //SHAKE256(tmp_m, CRHBYTES, public_key->data, p->CRYPTO_PUBLICKEYBYTES);
     //SHAKE256(mu, CRHBYTES, tmp_m, CRHBYTES + mlen);
-    shake256(tmp_m, CRHBYTES, public_key->data, p->CRYPTO_PUBLICKEYBYTES);
+    if (l_expanded)
+        memcpy(tmp_m, l_expanded->tr, CRHBYTES);
+    else
+        shake256(tmp_m, CRHBYTES, public_key->data, p->CRYPTO_PUBLICKEYBYTES);
     shake256(mu, CRHBYTES, tmp_m, CRHBYTES + mlen);
     free(tmp_m);
 
-    expand_mat(mat, rho, p);
+    if (!l_expanded) {
+        expand_mat(mat, rho, p);
+        polyveck_shiftl(&t1, D, p);
+        polyveck_ntt(&t1, p);
+    }
     polyvecl_ntt(&z, p);
     for(i = 0; i < p->PARAM_K ; ++i)
-        polyvecl_pointwise_acc_invmontgomery(tmp1.vec + i, mat+i, &z, p);
+        polyvecl_pointwise_acc_invmontgomery(tmp1.vec + i, l_mat + i, &z, p);
 
     chat = c;
     dilithium_poly_ntt(&chat);
-    polyveck_shiftl(&t1, D, p);
-    polyveck_ntt(&t1, p);
     for(i = 0; i < p->PARAM_K; ++i)
-        poly_pointwise_invmontgomery(tmp2.vec + i, &chat, t1.vec + i);
+        poly_pointwise_invmontgomery(tmp2.vec + i, &chat, l_t1->vec + i);
 
     polyveck_sub(&tmp1, &tmp1, &tmp2, p);
     polyveck_reduce(&tmp1, p);
@@ -402,6 +420,31 @@ int dilithium_crypto_sign_open( unsigned char *m, unsigned long long mlen, dilit
     return 0;
 }
 
+/*************************************************/
+/* Precompute message independent part of the verification, it's kept with the key up to its deletion */
+int dilithium_public_key_expand(dilithium_public_key_t *public_key)
+{
+    if (!public_key || !public_key->data)
+        return -1;
+    if (public_key->expanded)
+        return 0;
+    dilithium_param_t p;
+    if (!dilithium_params_init(&p, public_key->kind))
+        return -2;
+    dilithium_public_key_expanded_t *l_expanded = DAP_NEW_Z_SIZE(dilithium_public_key_expanded_t,
+                                                                 sizeof(dilithium_public_key_expanded_t) + p.PARAM_K * sizeof(polyvecl));
+    if (!l_expanded)
+        return -3;
+    unsigned char rho[SEEDBYTES];
+    dilithium_unpack_pk(rho, &l_expanded->t1, public_key->data, &p);
+    shake256(l_expanded->tr, CRHBYTES, public_key->data, p.CRYPTO_PUBLICKEYBYTES);
+    expand_mat(l_expanded->mat, rho, &p);
+    polyveck_shiftl(&l_expanded->t1, D, &p);
+    polyveck_ntt(&l_expanded->t1, &p);
+    public_key->expanded = l_expanded;
+    return 0;
+}
+
 /*************************************************/
 void dilithium_signature_delete(void *sig){
     dap_return_if_pass(!sig);
@@ -0,0 +1,481 @@
+/*
+ * Crypto benchmark with machine-readable output.
+ *
+ * Every operation of every key type available in the build is timed call by call, results are printed
+ * as JSON or CSV with ops/sec and latency percentiles to be compared between commits:
+ *   crypto-benchmark [-f json|csv] [-o file] [-n iterations] [-a name[,name...]] [-p auto|ref|avx2]
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <time.h>
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_enc_key.h"
+#include "dap_enc_base58.h"
+#include "dap_enc_base64.h"
+#include "dap_hash.h"
+#include "dap_sign.h"
+#include "dap_pq_impl.h"
+#include "rand/dap_rand.h"
+
+#define LOG_TAG "crypto_benchmark"
+
+#define BENCH_ITERATIONS_DEFAULT 100
+// Data operations process at least iterations * BENCH_DATA_UNIT bytes for every size
+#define BENCH_DATA_UNIT 65536
+#define BENCH_DATA_ITERATIONS_MIN 4
+#define BENCH_SEED_SIZE 32
+
+static const size_t s_data_sizes[] = { 64, 1024, 16384, 1048576 };
+
+typedef struct bench_result {
+    char algo[64];
+    char op[32];
+    size_t data_size;
+    size_t iterations;
+    double ops_per_sec;
+    double mb_per_sec;
+    uint64_t min_ns, p50_ns, p90_ns, p99_ns, max_ns;
+} bench_result_t;
+
+typedef struct bench_timer {
+    uint64_t *samples;
+    size_t count;
+    uint64_t start;
+} bench_timer_t;
+
+static bench_result_t *s_results = NULL;
+static size_t s_results_count = 0, s_results_size = 0;
+static size_t s_iterations = BENCH_ITERATIONS_DEFAULT;
+static char **s_algo_filter = NULL;
+static int s_errors = 0;
+
+static inline uint64_t s_now_ns(void)
+{
+    struct timespec l_ts;
+    clock_gettime(CLOCK_MONOTONIC, &l_ts);
+    return (uint64_t)l_ts.tv_sec * 1000000000 + l_ts.tv_nsec;
+}
+
+static inline void s_timer_start(bench_timer_t *a_timer)
+{
+    a_timer->start = s_now_ns();
+}
+
+static inline void s_timer_stop(bench_timer_t *a_timer)
+{
+    a_timer->samples[a_timer->count++] = s_now_ns() - a_timer->start;
+}
+
+static int s_samples_cmp(const void *a_first, const void *a_second)
+{
+    uint64_t l_first = *(const uint64_t *)a_first, l_second = *(const uint64_t *)a_second;
+    return (l_first > l_second) - (l_first < l_second);
+}
+
+static inline uint64_t s_percentile(const uint64_t *a_sorted, size_t a_count, unsigned a_percent)
+{
+    return a_sorted[dap_min(a_count - 1, a_count * a_percent / 100)];
+}
+
+/**
+ * @brief s_result_add sort samples collected by timer and store their statistics
+ * @param a_data_size processed data size for data operations, 0 for others
+ */
+static void s_result_add(const char *a_algo, const char *a_op, size_t a_data_size, bench_timer_t *a_timer)
+{
+    if (!a_timer->count)
+        return;
+    if (s_results_count == s_results_size) {
+        s_results_size = s_results_size ? s_results_size * 2 : 64;
+        s_results = DAP_REALLOC_COUNT(s_results, s_results_size);
+    }
+    bench_result_t *l_res = s_results + s_results_count++;
+    *l_res = (bench_result_t) { .data_size = a_data_size, .iterations = a_timer->count };
+    dap_strncpy(l_res->algo, a_algo, sizeof(l_res->algo));
+    dap_strncpy(l_res->op, a_op, sizeof(l_res->op));
+    uint64_t l_total = 0;
+    for (size_t i = 0; i < a_timer->count; i++)
+        l_total += a_timer->samples[i];
+    qsort(a_timer->samples, a_timer->count, sizeof(uint64_t), s_samples_cmp);
+    l_res->ops_per_sec = a_timer->count * 1e9 / dap_max(l_total, (uint64_t)1);
+    l_res->mb_per_sec = l_res->ops_per_sec * a_data_size / (1024 * 1024);
+    l_res->min_ns = a_timer->samples[0];
+    l_res->p50_ns = s_percentile(a_timer->samples, a_timer->count, 50);
+    l_res->p90_ns = s_percentile(a_timer->samples, a_timer->count, 90);
+    l_res->p99_ns = s_percentile(a_timer->samples, a_timer->count, 99);
+    l_res->max_ns = a_timer->samples[a_timer->count - 1];
+    a_timer->count = 0;
+}
+
+/**
+ * @brief s_bench_fail report failed operation and drop its samples, the run will exit with error
+ */
+static void s_bench_fail(bench_timer_t *a_timer, const char *a_format, ...)
+{
+    char l_msg[256];
+    va_list l_args;
+    va_start(l_args, a_format);
+    vsnprintf(l_msg, sizeof(l_msg), a_format, l_args);
+    va_end(l_args);
+    log_it(L_ERROR, "%s", l_msg);
+    a_timer->count = 0;
+    s_errors++;
+}
+
+static bool s_algo_enabled(const char *a_algo)
+{
+    if (!s_algo_filter)
+        return true;
+    for (char **l_name = s_algo_filter; *l_name; l_name++)
+        if (!strcasecmp(*l_name, a_algo))
+            return true;
+    return false;
+}
+
+static inline size_t s_data_iterations(size_t a_data_size)
+{
+    return dap_max(s_iterations * BENCH_DATA_UNIT / a_data_size, (size_t)BENCH_DATA_ITERATIONS_MIN);
+}
+
+/**
+ * @brief s_key_generate make a new random key
+ * @param a_symmetric symmetric key is derived from kex buffer and seed, so they are random
+ */
+static dap_enc_key_t *s_key_generate(dap_enc_key_type_t a_type, bool a_symmetric)
+{
+    uint8_t l_seed[BENCH_SEED_SIZE], l_kex[BENCH_SEED_SIZE];
+    randombytes(l_seed, sizeof(l_seed));
+    if (a_symmetric) {
+        randombytes(l_kex, sizeof(l_kex));
+        return dap_enc_key_new_generate(a_type, l_kex, sizeof(l_kex), l_seed, sizeof(l_seed), 32);
+    }
+    if (a_type == DAP_ENC_KEY_TYPE_SIG_MULTI_CHAINED) {
+        // Chained multisign is made of keys of listed types
+        dap_enc_key_type_t l_types[] = { DAP_ENC_KEY_TYPE_SIG_DILITHIUM, DAP_ENC_KEY_TYPE_SIG_FALCON };
+        return dap_enc_key_new_generate(a_type, l_types, sizeof(l_types) / sizeof(*l_types), l_seed, sizeof(l_seed), 0);
+    }
+    return dap_enc_key_new_generate(a_type, NULL, 0, NULL, 0, 0);
+}
+
+static void s_keygen_bench(const char *a_algo, dap_enc_key_type_t a_type, bool a_symmetric, bench_timer_t *a_timer)
+{
+    for (size_t i = 0; i < s_iterations; i++) {
+        s_timer_start(a_timer);
+        dap_enc_key_t *l_key = s_key_generate(a_type, a_symmetric);
+        s_timer_stop(a_timer);
+        if (!l_key) {
+            s_bench_fail(a_timer, "%s key generation failed", a_algo);
+            return;
+        }
+        dap_enc_key_delete(l_key);
+    }
+    s_result_add(a_algo, "keygen", 0, a_timer);
+}
+
+static void s_sign_bench(const char *a_algo, dap_enc_key_type_t a_type, bench_timer_t *a_timer)
+{
+    dap_enc_key_t *l_key = s_key_generate(a_type, false);
+    if (!l_key) {
+        s_bench_fail(a_timer, "%s key generation failed", a_algo);
+        return;
+    }
+    size_t l_sign_size = dap_sign_create_output_unserialized_calc_size(l_key);
+    uint8_t **l_signs = DAP_NEW_Z_COUNT(uint8_t *, s_iterations);
+    dap_hash_fast_t *l_hashes = DAP_NEW_Z_COUNT(dap_hash_fast_t, s_iterations);
+    randombytes(l_hashes, s_iterations * sizeof(dap_hash_fast_t));
+    bool l_failed = false;
+    for (size_t i = 0; i < s_iterations && !l_failed; i++) {
+        l_signs[i] = DAP_NEW_Z_SIZE(uint8_t, l_sign_size);
+        s_timer_start(a_timer);
+        l_failed = l_key->sign_get(l_key, l_hashes + i, sizeof(dap_hash_fast_t), l_signs[i], l_sign_size);
+        s_timer_stop(a_timer);
+    }
+    if (l_failed) {
+        s_bench_fail(a_timer, "%s signing failed", a_algo);
+    } else {
+        s_result_add(a_algo, "sign", 0, a_timer);
+        for (size_t i = 0; i < s_iterations && !l_failed; i++) {
+            s_timer_start(a_timer);
+            l_failed = l_key->sign_verify(l_key, l_hashes + i, sizeof(dap_hash_fast_t), l_signs[i], l_sign_size);
+            s_timer_stop(a_timer);
+        }
+        if (l_failed) {
+            s_bench_fail(a_timer, "%s verification failed", a_algo);
+        } else
+            s_result_add(a_algo, "verify", 0, a_timer);
+    }
+    for (size_t i = 0; i < s_iterations; i++)
+        if (l_signs[i])
+            dap_enc_key_signature_delete(a_type, l_signs[i]);
+    DAP_DEL_MULTY(l_hashes, l_signs);
+    dap_enc_key_delete(l_key);
+}
+
+/**
+ * @brief s_kem_bench every exchange is made with own keys, some KEMs spoil the private key on decapsulation
+ */
+static void s_kem_bench(const char *a_algo, dap_enc_key_type_t a_type, bench_timer_t *a_timer)
+{
+    dap_enc_key_t **l_alice = DAP_NEW_Z_COUNT(dap_enc_key_t *, s_iterations),
+                  **l_bob = DAP_NEW_Z_COUNT(dap_enc_key_t *, s_iterations);
+    void **l_cypher_msg = DAP_NEW_Z_COUNT(void *, s_iterations);
+    size_t *l_cypher_msg_size = DAP_NEW_Z_COUNT(size_t, s_iterations);
+    bool l_failed = false;
+    for (size_t i = 0; i < s_iterations && !l_failed; i++) {
+        l_alice[i] = s_key_generate(a_type, false);
+        l_bob[i] = dap_enc_key_new(a_type);
+        l_failed = !l_alice[i] || !l_bob[i];
+    }
+    if (l_failed)
+        s_bench_fail(a_timer, "%s key generation failed", a_algo);
+    for (size_t i = 0; i < s_iterations && !l_failed; i++) {
+        s_timer_start(a_timer);
+        l_cypher_msg_size[i] = l_bob[i]->gen_bob_shared_key(l_bob[i], l_alice[i]->pub_key_data, l_alice[i]->pub_key_data_size,
+                                                            l_cypher_msg + i);
+        s_timer_stop(a_timer);
+        if ((l_failed = !l_cypher_msg_size[i]))
+            s_bench_fail(a_timer, "%s encapsulation failed", a_algo);
+    }
+    if (!l_failed)
+        s_result_add(a_algo, "encaps", 0, a_timer);
+    for (size_t i = 0; i < s_iterations && !l_failed; i++) {
+        s_timer_start(a_timer);
+        l_alice[i]->gen_alice_shared_key(l_alice[i], l_alice[i]->priv_key_data, l_cypher_msg_size[i], l_cypher_msg[i]);
+        s_timer_stop(a_timer);
+        if ((l_failed = !l_alice[i]->shared_key || l_alice[i]->shared_key_size != l_bob[i]->shared_key_size
+                || memcmp(l_alice[i]->shared_key, l_bob[i]->shared_key, l_bob[i]->shared_key_size)))
+            s_bench_fail(a_timer, "%s decapsulation failed", a_algo);
+    }
+    if (!l_failed)
+        s_result_add(a_algo, "decaps", 0, a_timer);
+    for (size_t i = 0; i < s_iterations; i++) {
+        DAP_DELETE(l_cypher_msg[i]);
+        dap_enc_key_delete(l_bob[i]);
+        dap_enc_key_delete(l_alice[i]);
+    }
+    DAP_DEL_MULTY(l_cypher_msg_size, l_cypher_msg, l_bob, l_alice);
+}
+
+static void s_cipher_bench(const char *a_algo, dap_enc_key_type_t a_type, bench_timer_t *a_timer)
+{
+    dap_enc_key_t *l_key = s_key_generate(a_type, true);
+    if (!l_key) {
+        s_bench_fail(a_timer, "%s key generation failed", a_algo);
+        return;
+    }
+    for (size_t s = 0; s < sizeof(s_data_sizes) / sizeof(*s_data_sizes); s++) {
+        size_t l_size = s_data_sizes[s], l_iterations = s_data_iterations(l_size),
+               l_buf_size = dap_enc_key_get_enc_size(a_type, l_size), l_enc_size = 0, l_dec_size = 0;
+        uint8_t *l_plain = DAP_NEW_Z_SIZE(uint8_t, l_size), *l_enc = DAP_NEW_Z_SIZE(uint8_t, l_buf_size),
+                *l_dec = DAP_NEW_Z_SIZE(uint8_t, l_buf_size);
+        randombytes(l_plain, l_size);
+        for (size_t i = 0; i < l_iterations; i++) {
+            s_timer_start(a_timer);
+            l_enc_size = l_key->enc_na(l_key, l_plain, l_size, l_enc, l_buf_size);
+            s_timer_stop(a_timer);
+        }
+        s_result_add(a_algo, "encrypt", l_size, a_timer);
+        for (size_t i = 0; i < l_iterations; i++) {
+            s_timer_start(a_timer);
+            l_dec_size = l_key->dec_na(l_key, l_enc, l_enc_size, l_dec, l_buf_size);
+            s_timer_stop(a_timer);
+        }
+        if (l_dec_size != l_size || memcmp(l_plain, l_dec, l_size)) {
+            s_bench_fail(a_timer, "%s decryption of %zu bytes failed", a_algo, l_size);
+        } else
+            s_result_add(a_algo, "decrypt", l_size, a_timer);
+        DAP_DEL_MULTY(l_dec, l_enc, l_plain);
+    }
+    dap_enc_key_delete(l_key);
+}
+
+static void s_key_types_bench(bench_timer_t *a_timer)
+{
+    for (dap_enc_key_type_t l_type = DAP_ENC_KEY_TYPE_NULL; l_type <= DAP_ENC_KEY_TYPE_LAST; l_type++) {
+        // Gaps in types enumeration have no name, types not included to the build have no callbacks
+        const char *l_algo = dap_enc_get_type_name(l_type);
+        if (!strcmp(l_algo, "undefined") || !s_algo_enabled(l_algo))
+            continue;
+        // Ring signature needs public keys ring and uses cipher callbacks for it, see dap_enc_ringct20_test
+        if (l_type == DAP_ENC_KEY_TYPE_SIG_RINGCT20)
+            continue;
+        dap_enc_key_t *l_probe = dap_enc_key_new(l_type);
+        if (!l_probe)
+            continue;
+        // Some signatures fill cipher callbacks too
+        bool l_sign = l_probe->sign_get && l_probe->sign_verify,
+             l_kem = !l_sign && l_probe->gen_bob_shared_key && l_probe->gen_alice_shared_key,
+             l_cipher = !l_sign && !l_kem && l_probe->enc_na && l_probe->dec_na;
+        dap_enc_key_delete(l_probe);
+        if (!l_sign && !l_kem && !l_cipher)
+            continue;
+        log_it(L_NOTICE, "Benchmarking %s", l_algo);
+        s_keygen_bench(l_algo, l_type, l_cipher, a_timer);
+        if (l_sign)
+            s_sign_bench(l_algo, l_type, a_timer);
+        if (l_kem)
+            s_kem_bench(l_algo, l_type, a_timer);
+        if (l_cipher)
+            s_cipher_bench(l_algo, l_type, a_timer);
+    }
+}
+
+static void s_encoding_bench(bench_timer_t *a_timer)
+{
+    const bool l_hash = s_algo_enabled("SHA3_256"), l_base58 = s_algo_enabled("BASE58"), l_base64 = s_algo_enabled("BASE64");
+    for (size_t s = 0; s < sizeof(s_data_sizes) / sizeof(*s_data_sizes); s++) {
+        size_t l_size = s_data_sizes[s], l_iterations = s_data_iterations(l_size), l_out_size = 0;
+        uint8_t *l_data = DAP_NEW_Z_SIZE(uint8_t, l_size), *l_decoded = DAP_NEW_Z_SIZE(uint8_t, 2 * l_size + 1);
+        char *l_encoded = DAP_NEW_Z_SIZE(char, DAP_ENC_BASE58_ENCODE_SIZE(l_size) + DAP_ENC_BASE64_ENCODE_SIZE(l_size) + 1);
+        randombytes(l_data, l_size);
+        if (l_hash) {
+            dap_hash_fast_t l_hash_out;
+            for (size_t i = 0; i < l_iterations; i++) {
+                s_timer_start(a_timer);
+                dap_hash_fast(l_data, l_size, &l_hash_out);
+                s_timer_stop(a_timer);
+            }
+            s_result_add("SHA3_256", "hash", l_size, a_timer);
+        }
+        // Base58 is quadratic, big buffers take too long and are never used
+        if (l_base58 && l_size <= 1024) {
+            for (size_t i = 0; i < l_iterations; i++) {
+                s_timer_start(a_timer);
+                dap_enc_base58_encode(l_data, l_size, l_encoded);
+                s_timer_stop(a_timer);
+            }
+            s_result_add("BASE58", "encode", l_size, a_timer);
+            for (size_t i = 0; i < l_iterations; i++) {
+                s_timer_start(a_timer);
+                l_out_size = dap_enc_base58_decode(l_encoded, l_decoded);
+                s_timer_stop(a_timer);
+            }
+            if (l_out_size != l_size || memcmp(l_data, l_decoded, l_size)) {
+                s_bench_fail(a_timer, "Base58 decoding of %zu bytes failed", l_size);
+            } else
+                s_result_add("BASE58", "decode", l_size, a_timer);
+        }
+        if (l_base64) {
+            size_t l_encoded_size = 0;
+            for (size_t i = 0; i < l_iterations; i++) {
+                s_timer_start(a_timer);
+                l_encoded_size = dap_enc_base64_encode(l_data, l_size, l_encoded, DAP_ENC_DATA_TYPE_B64);
+                s_timer_stop(a_timer);
+            }
+            s_result_add("BASE64", "encode", l_size, a_timer);
+            for (size_t i = 0; i < l_iterations; i++) {
+                s_timer_start(a_timer);
+                l_out_size = dap_enc_base64_decode(l_encoded, l_encoded_size, l_decoded, DAP_ENC_DATA_TYPE_B64);
+                s_timer_stop(a_timer);
+            }
+            if (l_out_size != l_size || memcmp(l_data, l_decoded, l_size)) {
+                s_bench_fail(a_timer, "Base64 decoding of %zu bytes failed", l_size);
+            } else
+                s_result_add("BASE64", "decode", l_size, a_timer);
+        }
+        DAP_DEL_MULTY(l_encoded, l_decoded, l_data);
+    }
+}
+
+static void s_results_print_json(FILE *a_out)
+{
+    fprintf(a_out, "{\n  \"iterations\": %zu,\n  \"pq_impl\": \"%s\",\n  \"results\": [",
+            s_iterations, dap_pq_impl_to_str(dap_pq_impl_get()));
+    for (size_t i = 0; i < s_results_count; i++) {
+        bench_result_t *l_res = s_results + i;
+        fprintf(a_out, "%s\n    {\"algo\": \"%s\", \"op\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+                       "\"ops_per_sec\": %.2f, \"mb_per_sec\": %.2f, \"min_ns\": %" DAP_UINT64_FORMAT_U ", "
+                       "\"p50_ns\": %" DAP_UINT64_FORMAT_U ", \"p90_ns\": %" DAP_UINT64_FORMAT_U ", "
+                       "\"p99_ns\": %" DAP_UINT64_FORMAT_U ", \"max_ns\": %" DAP_UINT64_FORMAT_U "}",
+                i ? "," : "", l_res->algo, l_res->op, l_res->data_size, l_res->iterations, l_res->ops_per_sec,
+                l_res->mb_per_sec, l_res->min_ns, l_res->p50_ns, l_res->p90_ns, l_res->p99_ns, l_res->max_ns);
+    }
+    fprintf(a_out, "\n  ]\n}\n");
+}
+
+static void s_results_print_csv(FILE *a_out)
+{
+    fprintf(a_out, "algo,op,size,iterations,ops_per_sec,mb_per_sec,min_ns,p50_ns,p90_ns,p99_ns,max_ns\n");
+    for (size_t i = 0; i < s_results_count; i++) {
+        bench_result_t *l_res = s_results + i;
+        fprintf(a_out, "%s,%s,%zu,%zu,%.2f,%.2f,%" DAP_UINT64_FORMAT_U ",%" DAP_UINT64_FORMAT_U ",%" DAP_UINT64_FORMAT_U
+                       ",%" DAP_UINT64_FORMAT_U ",%" DAP_UINT64_FORMAT_U "\n",
+                l_res->algo, l_res->op, l_res->data_size, l_res->iterations, l_res->ops_per_sec, l_res->mb_per_sec,
+                l_res->min_ns, l_res->p50_ns, l_res->p90_ns, l_res->p99_ns, l_res->max_ns);
+    }
+}
+
+static void s_usage(const char *a_name)
+{
+    fprintf(stderr, "Usage: %s [-f json|csv] [-o file] [-n iterations] [-a name[,name...]] [-p auto|ref|avx2] [-v]\n"
+                    "  -f  output format, json by default\n"
+                    "  -o  write results to file instead of stdout\n"
+                    "  -n  iterations of key operations, data operations are scaled by data size (%d by default)\n"
+                    "  -a  benchmark only listed algorithms, key type names and SHA3_256, BASE58, BASE64\n"
+                    "  -p  post-quantum algorithms implementation\n"
+                    "  -v  print progress to stderr\n", a_name, BENCH_ITERATIONS_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+    bool l_csv = false;
+    const char *l_out_path = NULL;
+    int l_opt;
+    dap_log_level_set(L_ERROR);
+    dap_log_set_external_output(LOGGER_OUTPUT_STDERR, NULL);
+    while ((l_opt = getopt(argc, argv, "f:o:n:a:p:vh")) != -1) {
+        switch (l_opt) {
+        case 'f':
+            if (!strcmp(optarg, "csv"))
+                l_csv = true;
+            else if (strcmp(optarg, "json"))
+                return s_usage(argv[0]), 1;
+            break;
+        case 'o':
+            l_out_path = optarg;
+            break;
+        case 'n':
+            if (!(s_iterations = strtoul(optarg, NULL, 10)))
+                return s_usage(argv[0]), 1;
+            break;
+        case 'a':
+            s_algo_filter = dap_strsplit(optarg, ",", -1);
+            break;
+        case 'p':
+            if (!strcmp(optarg, "ref"))
+                l_opt = dap_pq_impl_set(DAP_PQ_IMPL_REF);
+            else if (!strcmp(optarg, "avx2"))
+                l_opt = dap_pq_impl_set(DAP_PQ_IMPL_AVX2);
+            else
+                l_opt = strcmp(optarg, "auto") ? -1 : dap_pq_impl_set(DAP_PQ_IMPL_AUTO);
+            if (l_opt)
+                return s_usage(argv[0]), 1;
+            break;
+        case 'v':
+            dap_log_level_set(L_NOTICE);
+            break;
+        default:
+            return s_usage(argv[0]), 1;
+        }
+    }
+    FILE *l_out = l_out_path ? fopen(l_out_path, "w") : stdout;
+    if (!l_out) {
+        fprintf(stderr, "Can't open %s: %s\n", l_out_path, strerror(errno));
+        return 1;
+    }
+    size_t l_samples_max = dap_max(s_iterations, s_data_iterations(s_data_sizes[0]));
+    bench_timer_t l_timer = { .samples = DAP_NEW_Z_COUNT(uint64_t, l_samples_max) };
+    s_key_types_bench(&l_timer);
+    s_encoding_bench(&l_timer);
+    if (l_csv)
+        s_results_print_csv(l_out);
+    else
+        s_results_print_json(l_out);
+    if (l_out != stdout)
+        fclose(l_out);
+    dap_strfreev(s_algo_filter);
+    DAP_DEL_MULTY(l_timer.samples, s_results);
+    return s_errors ? 2 : 0;
+}
@@ -1,4 +1,5 @@
 #include "dap_enc_benchmark_test.h"
+#include "dap_enc.h"
 #include "dap_sign.h"
 #include "dap_pkey.h"
 #include "dap_test.h"
@@ -242,6 +243,103 @@ static void s_sign_verify_ser_test(dap_enc_key_type_t a_key_type, int a_times, i
     }
 }
 
+#define REPEATED_SIGNERS_COUNT 8
+
+/**
+ * @brief s_sign_verify_repeated_test verify a_times signs made by a few signers with dap_sign_verify
+ * @param a_cache_size public keys cache size to use, 0 to verify without cache
+ */
+static void s_sign_verify_repeated_test(dap_enc_key_type_t a_key_type, int a_times, size_t a_cache_size, int *a_verify_time)
+{
+    uint8_t seed[sizeof(uint8_t)];
+    dap_sign_t *l_signers_signs[REPEATED_SIGNERS_COUNT];
+    dap_chain_hash_fast_t l_hashes[REPEATED_SIGNERS_COUNT];
+    for (int i = 0; i < REPEATED_SIGNERS_COUNT; ++i) {
+        randombytes(seed, sizeof(seed));
+        randombytes(l_hashes + i, sizeof(dap_chain_hash_fast_t));
+        dap_enc_key_t *l_key = dap_enc_key_new_generate(a_key_type, NULL, 0, seed, sizeof(seed), 0);
+        l_signers_signs[i] = dap_sign_create(l_key, l_hashes + i, sizeof(dap_chain_hash_fast_t));
+        dap_assert_PIF(l_signers_signs[i], "Signing message and serialize");
+        dap_enc_key_delete(l_key);
+    }
+    dap_sign_pkey_cache_set_size(a_cache_size);
+    int l_t1 = get_cur_time_msec();
+    for (int i = 0; i < a_times; ++i) {
+        int l_signer = random_uint32_t(REPEATED_SIGNERS_COUNT);
+        int l_verified = dap_sign_verify(l_signers_signs[l_signer], l_hashes + l_signer, sizeof(dap_chain_hash_fast_t));
+        dap_assert_PIF(!l_verified, "Deserialize and verifying signature");
+    }
+    *a_verify_time = get_cur_time_msec() - l_t1;
+    // Cached key mustn't pass a sign for other data
+    dap_assert_PIF(dap_sign_verify(l_signers_signs[0], l_hashes + 1, sizeof(dap_chain_hash_fast_t)), "Reject sign for another data");
+    dap_sign_pkey_cache_set_size(0);
+    for (int i = 0; i < REPEATED_SIGNERS_COUNT; ++i)
+        DAP_DELETE(l_signers_signs[i]);
+}
+
+static void s_sign_verify_repeated_test_benchmark(const char *a_name, dap_enc_key_type_t a_key_type, int a_times)
+{
+    dap_print_module_name(a_name);
+    int l_verify_time = 0;
+    char l_msg[120] = {0};
+    s_sign_verify_repeated_test(a_key_type, a_times, 0, &l_verify_time);
+    sprintf(l_msg, "Verifying %d signers message %d times without pkey cache", REPEATED_SIGNERS_COUNT, a_times);
+    benchmark_mgs_time(l_msg, l_verify_time);
+    s_sign_verify_repeated_test(a_key_type, a_times, REPEATED_SIGNERS_COUNT * 4, &l_verify_time);
+    sprintf(l_msg, "Verifying %d signers message %d times with pkey cache", REPEATED_SIGNERS_COUNT, a_times);
+    benchmark_mgs_time(l_msg, l_verify_time);
+}
+
+#define BATCH_VERIFY_COUNT 10000
+#define BATCH_SIGNERS_COUNT 16
+
+/**
+ * @brief s_sign_verify_batch_test verify BATCH_VERIFY_COUNT mixed signatures one by one and with dap_sign_verify_batch
+ */
+static void s_sign_verify_batch_test(int *a_verify_time, int *a_batch_verify_time)
+{
+    dap_enc_key_type_t l_types[] = { DAP_ENC_KEY_TYPE_SIG_DILITHIUM, DAP_ENC_KEY_TYPE_SIG_FALCON,
+#ifdef DAP_ECDSA
+                                     DAP_ENC_KEY_TYPE_SIG_ECDSA
+#endif
+    };
+    uint8_t seed[sizeof(uint8_t)];
+    dap_enc_key_t *l_keys[BATCH_SIGNERS_COUNT];
+    for (int i = 0; i < BATCH_SIGNERS_COUNT; ++i) {
+        randombytes(seed, sizeof(seed));
+        l_keys[i] = dap_enc_key_new_generate(l_types[i % (sizeof(l_types) / sizeof(l_types[0]))], NULL, 0, seed, sizeof(seed), 0);
+    }
+    dap_chain_hash_fast_t *l_hashes = DAP_NEW_Z_COUNT_RET_IF_FAIL(dap_chain_hash_fast_t, BATCH_VERIFY_COUNT);
+    dap_sign_verify_item_t *l_items = DAP_NEW_Z_COUNT_RET_IF_FAIL(dap_sign_verify_item_t, BATCH_VERIFY_COUNT, l_hashes);
+    for (int i = 0; i < BATCH_VERIFY_COUNT; ++i) {
+        randombytes(l_hashes + i, sizeof(dap_chain_hash_fast_t));
+        l_items[i].sign = dap_sign_create(l_keys[random_uint32_t(BATCH_SIGNERS_COUNT)], l_hashes + i, sizeof(dap_chain_hash_fast_t));
+        dap_assert_PIF(l_items[i].sign, "Signing message and serialize");
+        l_items[i].data = l_hashes + i;
+        l_items[i].data_size = sizeof(dap_chain_hash_fast_t);
+    }
+    // One broken item mustn't affect others
+    size_t l_broken = random_uint32_t(BATCH_VERIFY_COUNT);
+    l_items[l_broken].data = l_hashes + (l_broken + 1) % BATCH_VERIFY_COUNT;
+
+    int l_t1 = get_cur_time_msec();
+    for (int i = 0; i < BATCH_VERIFY_COUNT; ++i)
+        dap_assert_PIF(!dap_sign_verify(l_items[i].sign, l_items[i].data, l_items[i].data_size) == (i != (int)l_broken),
+                       "Deserialize and verifying signature");
+    *a_verify_time = get_cur_time_msec() - l_t1;
+
+    l_t1 = get_cur_time_msec();
+    size_t l_failed = dap_sign_verify_batch(l_items, BATCH_VERIFY_COUNT);
+    *a_batch_verify_time = get_cur_time_msec() - l_t1;
+    dap_assert_PIF(l_failed == 1 && l_items[l_broken].result, "Batch verifying signatures");
+
+    for (int i = 0; i < BATCH_VERIFY_COUNT; ++i)
+        DAP_DELETE(l_items[i].sign);
+    DAP_DEL_MULTY(l_items, l_hashes);
+    for (int i = 0; i < BATCH_SIGNERS_COUNT; ++i)
+        dap_enc_key_delete(l_keys[i]);
+}
+
 static void s_sign_verify_test_becnhmark(const char *a_name, dap_enc_key_type_t a_key_type, int a_times) {
     dap_print_module_name(a_name);
     int l_sig_time = 0;
@@ -263,6 +361,168 @@ static void s_sign_verify_test_becnhmark(const char *a_name, dap_enc_key_type_t
 }
 /*-----------------------------------------------------------------------*/
 
+/*--------------------------HASH TEST BLOCK------------------------------*/
+#define HASH_RECORDS_COUNT 100000
+#define HASH_RECORD_SIZE_MAX 512
+
+/**
+ * @brief s_hash_batch_test hash many small records with dap_hash_fast one by one and with dap_hash_fast_batch
+ */
+static void s_hash_batch_test(int a_times, int *a_hash_time, int *a_batch_hash_time)
+{
+    uint8_t *l_data = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, HASH_RECORDS_COUNT * HASH_RECORD_SIZE_MAX);
+    const void **l_records = DAP_NEW_Z_COUNT_RET_IF_FAIL(const void *, HASH_RECORDS_COUNT, l_data);
+    size_t *l_sizes = DAP_NEW_Z_COUNT_RET_IF_FAIL(size_t, HASH_RECORDS_COUNT, l_data, l_records);
+    dap_hash_fast_t *l_hashes = DAP_NEW_Z_COUNT_RET_IF_FAIL(dap_hash_fast_t, HASH_RECORDS_COUNT, l_data, l_records, l_sizes);
+    dap_hash_fast_t *l_batch_hashes = DAP_NEW_Z_COUNT_RET_IF_FAIL(dap_hash_fast_t, HASH_RECORDS_COUNT, l_data, l_records, l_sizes, l_hashes);
+    randombytes(l_data, HASH_RECORDS_COUNT * HASH_RECORD_SIZE_MAX);
+    for (int i = 0; i < HASH_RECORDS_COUNT; ++i) {
+        l_records[i] = l_data + i * HASH_RECORD_SIZE_MAX;
+        l_sizes[i] = 1 + random_uint32_t(HASH_RECORD_SIZE_MAX);
+    }
+    int l_t1 = get_cur_time_msec();
+    for (int j = 0; j < a_times; ++j)
+        for (int i = 0; i < HASH_RECORDS_COUNT; ++i)
+            dap_hash_fast(l_records[i], l_sizes[i], l_hashes + i);
+    *a_hash_time = get_cur_time_msec() - l_t1;
+
+    l_t1 = get_cur_time_msec();
+    for (int j = 0; j < a_times; ++j)
+        dap_assert_PIF(dap_hash_fast_batch(l_records, l_sizes, l_batch_hashes, HASH_RECORDS_COUNT), "Batch hashing");
+    *a_batch_hash_time = get_cur_time_msec() - l_t1;
+    dap_assert_PIF(!memcmp(l_hashes, l_batch_hashes, HASH_RECORDS_COUNT * sizeof(dap_hash_fast_t)), "Batch hashes are equal to single ones");
+    DAP_DEL_MULTY(l_batch_hashes, l_hashes, l_sizes, l_records, l_data);
+}
+
+static void s_hash_tests_run(int a_times)
+{
+    dap_init_test_case();
+    dap_print_module_name("SHA3-256 BATCH");
+    int l_hash_time = 0, l_batch_hash_time = 0;
+    char l_msg[120] = {0};
+    s_hash_batch_test(a_times, &l_hash_time, &l_batch_hash_time);
+    sprintf(l_msg, "Hashing %d records up to %d bytes %d times one by one", HASH_RECORDS_COUNT, HASH_RECORD_SIZE_MAX, a_times);
+    benchmark_mgs_time(l_msg, l_hash_time);
+    sprintf(l_msg, "Hashing %d records up to %d bytes %d times with batch", HASH_RECORDS_COUNT, HASH_RECORD_SIZE_MAX, a_times);
+    benchmark_mgs_time(l_msg, l_batch_hash_time);
+    dap_cleanup_test_case();
+}
+/*-----------------------------------------------------------------------*/
+
+/*--------------------------CIPHER TEST BLOCK----------------------------*/
+#define CIPHER_BUF_SIZE 16384
+#define CIPHER_ROUNDS 2000
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CIPHER_TICKS_UNIT "cycles/byte"
+static inline uint64_t s_ticks_now() { return __rdtsc(); }
+#else
+#define CIPHER_TICKS_UNIT "ns/byte"
+static inline uint64_t s_ticks_now()
+{
+    struct timespec l_ts;
+    clock_gettime(CLOCK_MONOTONIC, &l_ts);
+    return (uint64_t)l_ts.tv_sec * 1000000000 + l_ts.tv_nsec;
+}
+#endif
+
+/**
+ * @brief s_cipher_test_benchmark encrypt and decrypt stream-sized packets with symmetric cipher
+ */
+static void s_cipher_test_benchmark(dap_enc_key_type_t a_key_type, int a_times)
+{
+    uint8_t l_kex[32], l_seed[16];
+    randombytes(l_kex, sizeof(l_kex));
+    randombytes(l_seed, sizeof(l_seed));
+    dap_enc_key_t *l_key = dap_enc_key_new_generate(a_key_type, l_kex, sizeof(l_kex), l_seed, sizeof(l_seed), 32);
+    size_t l_enc_size = dap_enc_key_get_enc_size(a_key_type, CIPHER_BUF_SIZE);
+    uint8_t *l_plain = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, CIPHER_BUF_SIZE),
+            *l_enc = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, l_enc_size, l_plain),
+            *l_dec = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, l_enc_size, l_plain, l_enc);
+    randombytes(l_plain, CIPHER_BUF_SIZE);
+    uint64_t l_enc_ticks = 0, l_dec_ticks = 0;
+    size_t l_rounds = (size_t)a_times * CIPHER_ROUNDS, l_dec_size = 0;
+    for (size_t i = 0; i < l_rounds; i++) {
+        uint64_t l_t1 = s_ticks_now();
+        l_enc_size = l_key->enc_na(l_key, l_plain, CIPHER_BUF_SIZE, l_enc, l_enc_size);
+        uint64_t l_t2 = s_ticks_now();
+        l_dec_size = l_key->dec_na(l_key, l_enc, l_enc_size, l_dec, l_enc_size);
+        l_dec_ticks += s_ticks_now() - l_t2;
+        l_enc_ticks += l_t2 - l_t1;
+    }
+    dap_assert_PIF(l_dec_size == CIPHER_BUF_SIZE && !memcmp(l_plain, l_dec, CIPHER_BUF_SIZE), "Encrypt and decrypt");
+    char l_msg[120];
+    snprintf(l_msg, sizeof(l_msg), "%s encrypt %d bytes %zu times (%.2f %s)", dap_enc_get_type_name(a_key_type), CIPHER_BUF_SIZE,
+             l_rounds, (double)l_enc_ticks / l_rounds / CIPHER_BUF_SIZE, CIPHER_TICKS_UNIT);
+    dap_pass_msg(l_msg);
+    snprintf(l_msg, sizeof(l_msg), "%s decrypt %d bytes %zu times (%.2f %s)", dap_enc_get_type_name(a_key_type), CIPHER_BUF_SIZE,
+             l_rounds, (double)l_dec_ticks / l_rounds / CIPHER_BUF_SIZE, CIPHER_TICKS_UNIT);
+    dap_pass_msg(l_msg);
+    DAP_DEL_MULTY(l_dec, l_enc, l_plain);
+    dap_enc_key_delete(l_key);
+}
+
+/**
+ * @brief s_cipher_inplace_test_benchmark compare stream packet path with intermediate buffers and the in-place one
+ */
+static void s_cipher_inplace_test_benchmark(dap_enc_key_type_t a_key_type, int a_times)
+{
+    uint8_t l_kex[32], l_seed[16];
+    randombytes(l_kex, sizeof(l_kex));
+    randombytes(l_seed, sizeof(l_seed));
+    dap_enc_key_t *l_key = dap_enc_key_new_generate(a_key_type, l_kex, sizeof(l_kex), l_seed, sizeof(l_seed), 32);
+    size_t l_headroom = dap_enc_key_get_inplace_headroom(a_key_type),
+           l_buf_size = dap_enc_key_get_enc_size(a_key_type, CIPHER_BUF_SIZE), l_enc_size = 0, l_dec_size = 0;
+    dap_assert_PIF(l_headroom, "Cipher supports in-place processing");
+    uint8_t *l_plain = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, CIPHER_BUF_SIZE),
+            *l_pkt = DAP_NEW_Z_SIZE_RET_IF_FAIL(uint8_t, l_buf_size, l_plain);
+    randombytes(l_plain, CIPHER_BUF_SIZE);
+    uint64_t l_copy_ticks = 0, l_inplace_ticks = 0;
+    size_t l_rounds = (size_t)a_times * CIPHER_ROUNDS;
+    for (size_t i = 0; i < l_rounds; i++) {
+        // Payload is gathered to temporary buffer, encrypted to packet and decrypted to one more buffer
+        uint64_t l_t1 = s_ticks_now();
+        uint8_t *l_tmp = DAP_DUP_SIZE(l_plain, CIPHER_BUF_SIZE);
+        l_enc_size = l_key->enc_na(l_key, l_tmp, CIPHER_BUF_SIZE, l_pkt, l_buf_size);
+        DAP_DELETE(l_tmp);
+        l_tmp = DAP_NEW_Z_SIZE(uint8_t, l_buf_size);
+        l_dec_size = l_key->dec_na(l_key, l_pkt, l_enc_size, l_tmp, l_buf_size);
+        DAP_DELETE(l_tmp);
+        // Payload is gathered right to the packet and processed there
+        uint64_t l_t2 = s_ticks_now();
+        memcpy(l_pkt + l_headroom, l_plain, CIPHER_BUF_SIZE);
+        l_enc_size = dap_enc_code_inplace(l_key, l_pkt, CIPHER_BUF_SIZE, l_buf_size);
+        l_dec_size = dap_enc_decode_inplace(l_key, l_pkt, l_enc_size);
+        l_inplace_ticks += s_ticks_now() - l_t2;
+        l_copy_ticks += l_t2 - l_t1;
+    }
+    dap_assert_PIF(l_dec_size == CIPHER_BUF_SIZE && !memcmp(l_plain, l_pkt, CIPHER_BUF_SIZE), "In-place encrypt and decrypt");
+    char l_msg[160];
+    snprintf(l_msg, sizeof(l_msg), "%s %d bytes round trip: with buffers %.2f %s, in-place %.2f %s, %zu MB less copied",
+             dap_enc_get_type_name(a_key_type), CIPHER_BUF_SIZE,
+             (double)l_copy_ticks / l_rounds / CIPHER_BUF_SIZE, CIPHER_TICKS_UNIT,
+             (double)l_inplace_ticks / l_rounds / CIPHER_BUF_SIZE, CIPHER_TICKS_UNIT, l_rounds * CIPHER_BUF_SIZE >> 20);
+    dap_pass_msg(l_msg);
+    DAP_DEL_MULTY(l_pkt, l_plain);
+    dap_enc_key_delete(l_key);
+}
+
+static void s_cipher_tests_run(int a_times)
+{
+    dap_init_test_case();
+    dap_print_module_name("STREAM CIPHERS");
+    s_cipher_test_benchmark(DAP_ENC_KEY_TYPE_SALSA2012, a_times);
+    s_cipher_test_benchmark(DAP_ENC_KEY_TYPE_IAES, a_times);
+    s_cipher_test_benchmark(DAP_ENC_KEY_TYPE_AES256_GCM, a_times);
+    s_cipher_test_benchmark(DAP_ENC_KEY_TYPE_CHACHA20_POLY1305, a_times);
+    s_cipher_inplace_test_benchmark(DAP_ENC_KEY_TYPE_SALSA2012, a_times);
+    s_cipher_inplace_test_benchmark(DAP_ENC_KEY_TYPE_AES256_GCM, a_times);
+    s_cipher_inplace_test_benchmark(DAP_ENC_KEY_TYPE_CHACHA20_POLY1305, a_times);
+    dap_cleanup_test_case();
+}
+/*-----------------------------------------------------------------------*/
+
 static void s_transfer_tests_run(int a_times)
 {
     dap_init_test_case();
@@ -283,9 +543,31 @@ static void s_sign_verify_tests_run(int a_times)
     dap_cleanup_test_case();
 }
 
+static void s_sign_verify_repeated_tests_run(int a_times)
+{
+    dap_sign_init(DAP_SIGN_HASH_TYPE_SHA3);
+    dap_init_test_case();
+    s_sign_verify_repeated_test_benchmark("DILITHIUM REPEATED SIGNERS", DAP_ENC_KEY_TYPE_SIG_DILITHIUM, a_times);
+    s_sign_verify_repeated_test_benchmark("FALCON REPEATED SIGNERS", DAP_ENC_KEY_TYPE_SIG_FALCON, a_times);
+
+    dap_print_module_name("MIXED SIGNATURES BATCH");
+    int l_verify_time = 0, l_batch_verify_time = 0;
+    char l_msg[120] = {0};
+    s_sign_verify_batch_test(&l_verify_time, &l_batch_verify_time);
+    sprintf(l_msg, "Verifying %d mixed signatures one by one", BATCH_VERIFY_COUNT);
+    benchmark_mgs_time(l_msg, l_verify_time);
+    sprintf(l_msg, "Verifying %d mixed signatures with batch", BATCH_VERIFY_COUNT);
+    benchmark_mgs_time(l_msg, l_batch_verify_time);
+    dap_cleanup_test_case();
+    dap_sign_deinit();
+}
+
 void dap_enc_benchmark_tests_run(int a_times)
 {
     s_transfer_tests_run(a_times);
+    s_cipher_tests_run(a_times);
+    s_hash_tests_run(a_times);
     s_sign_verify_tests_run(a_times);
+    s_sign_verify_repeated_tests_run(a_times);
 }
 
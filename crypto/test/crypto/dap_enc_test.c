@@ -124,6 +124,32 @@ void test_encypt_decrypt_fast(int count_steps, const dap_enc_key_type_t key_type
     dap_pass_msg(pass_msg_buf);
 }
 
+/**
+ * @brief test_encypt_decrypt_tamper check that AEAD cipher rejects modified ciphertext
+ */
+void test_encypt_decrypt_tamper(int count_steps, const dap_enc_key_type_t key_type, const int cipher_key_size)
+{
+    const int max_source_size = 10000;
+    dap_print_module_name(dap_enc_get_type_name(key_type));
+    uint8_t buf_encrypt_out[max_source_size + 128], buf_decrypt_out[max_source_size + 32], seed[16], kex[32];
+    randombytes(seed, sizeof(seed));
+    randombytes(kex, sizeof(kex));
+    dap_enc_key_t *key = dap_enc_key_new_generate(key_type, kex, sizeof(kex), seed, sizeof(seed), cipher_key_size);
+    for (int i = 0; i < count_steps; i++) {
+        size_t source_size = 1 + random_uint32_t(max_source_size);
+        uint8_t *source = DAP_NEW_SIZE(uint8_t, source_size);
+        randombytes(source, source_size);
+        size_t encrypted_size = key->enc_na(key, source, source_size, buf_encrypt_out, sizeof(buf_encrypt_out));
+        dap_assert_PIF(encrypted_size > source_size, "Encrypt with nonce and tag");
+        buf_encrypt_out[random_uint32_t(encrypted_size)] ^= 1 + random_uint32_t(255);
+        dap_assert_PIF(!key->dec_na(key, buf_encrypt_out, encrypted_size, buf_decrypt_out, sizeof(buf_decrypt_out)),
+                       "Modified ciphertext is rejected");
+        DAP_DELETE(source);
+    }
+    dap_enc_key_delete(key);
+    dap_pass_msg("Reject modified ciphertext");
+}
+
 
 static void _encrypt_decrypt(enum dap_enc_key_type key_type,
                              enum dap_enc_data_type data_type,
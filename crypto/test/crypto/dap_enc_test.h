@@ -27,6 +27,7 @@ DAP_STATIC_INLINE const char *s_key_type_to_str(dap_enc_key_type_t a_signe_key_t
 
 void test_encypt_decrypt(int count_steps, const dap_enc_key_type_t key_type, const int cipher_key_size);
 void test_encypt_decrypt_fast(int count_steps, const dap_enc_key_type_t key_type, const int cipher_key_size);
+void test_encypt_decrypt_tamper(int count_steps, const dap_enc_key_type_t key_type, const int cipher_key_size);
 
 void dap_enc_tests_run(void);
 void dap_enc_benchmark_tests_run(int a_times);
@@ -0,0 +1,5 @@
+#pragma once
+#include "dap_test.h"
+#include "dap_pq_impl.h"
+
+extern void dap_pq_impl_tests_run(int a_times);
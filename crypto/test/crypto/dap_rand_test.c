@@ -0,0 +1,101 @@
+#include <math.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "dap_rand_test.h"
+#include "dap_common.h"
+
+#define RAND_SAMPLE_SIZE (1024 * 1024)
+#define RAND_BENCHMARK_CALLS 200000
+#define RAND_THREADS_COUNT 4
+
+// Monobit frequency, byte distribution chi-square and runs tests over the sample
+static void s_statistics_test(const uint8_t *a_sample, size_t a_size)
+{
+    size_t l_ones = 0, l_runs = 1, l_counts[256] = { };
+    int l_prev_bit = a_sample[0] & 1;
+    for (size_t i = 0; i < a_size; i++) {
+        l_counts[a_sample[i]]++;
+        l_ones += __builtin_popcount(a_sample[i]);
+        for (int b = 0; b < 8; b++) {
+            int l_bit = (a_sample[i] >> b) & 1;
+            l_runs += l_bit != l_prev_bit;
+            l_prev_bit = l_bit;
+        }
+    }
+    double l_bits = a_size * 8.0, l_pi = l_ones / l_bits;
+    // Deviation more than 6 sigmas is practically impossible for a good generator
+    dap_assert(fabs(l_ones - l_bits / 2) < 6 * sqrt(l_bits) / 2, "Monobit frequency");
+    double l_chi2 = 0, l_expected = a_size / 256.0;
+    for (int i = 0; i < 256; i++)
+        l_chi2 += (l_counts[i] - l_expected) * (l_counts[i] - l_expected) / l_expected;
+    // 255 degrees of freedom, p-value 1e-6 is near 370
+    dap_assert(l_chi2 < 370, "Bytes distribution chi-square");
+    double l_runs_expected = 2 * l_bits * l_pi * (1 - l_pi);
+    dap_assert(fabs(l_runs - l_runs_expected) < 6 * 2 * sqrt(2 * l_bits) * l_pi * (1 - l_pi), "Bits runs");
+}
+
+static void *s_thread_sample(void *a_arg)
+{
+    randombytes(a_arg, 32);
+    return NULL;
+}
+
+// Small requests must be served from the buffer too, different threads and processes must get different output
+static void s_independence_test(void)
+{
+    uint8_t l_samples[RAND_THREADS_COUNT][32];
+    pthread_t l_threads[RAND_THREADS_COUNT];
+    for (int i = 0; i < RAND_THREADS_COUNT; i++)
+        pthread_create(l_threads + i, NULL, s_thread_sample, l_samples[i]);
+    for (int i = 0; i < RAND_THREADS_COUNT; i++)
+        pthread_join(l_threads[i], NULL);
+    bool l_unique = true;
+    for (int i = 0; i < RAND_THREADS_COUNT; i++)
+        for (int j = i + 1; j < RAND_THREADS_COUNT; j++)
+            l_unique &= !!memcmp(l_samples[i], l_samples[j], 32);
+    dap_assert(l_unique, "Threads output is unique");
+
+    uint8_t l_parent[32], l_child[32] = { };
+    int l_pipe[2];
+    dap_assert_PIF(!pipe(l_pipe), "Pipe create");
+    randombytes(l_parent, 1);   // The buffer is already filled before fork
+    pid_t l_pid = fork();
+    if (!l_pid) {
+        randombytes(l_child, sizeof(l_child));
+        _exit(write(l_pipe[1], l_child, sizeof(l_child)) != sizeof(l_child));
+    }
+    randombytes(l_parent, sizeof(l_parent));
+    waitpid(l_pid, NULL, 0);
+    dap_assert_PIF(read(l_pipe[0], l_child, sizeof(l_child)) == sizeof(l_child), "Child output read");
+    close(l_pipe[0]);
+    close(l_pipe[1]);
+    dap_assert(memcmp(l_parent, l_child, sizeof(l_parent)), "Output after fork differs from parent one");
+}
+
+static void s_calls_benchmark(int a_times)
+{
+    const unsigned l_sizes[] = { 1, 16, 32, 256 };
+    char l_msg[64];
+    uint8_t l_buf[256];
+    for (size_t s = 0; s < sizeof(l_sizes) / sizeof(*l_sizes); s++) {
+        int l_calls = RAND_BENCHMARK_CALLS * a_times, l_time = get_cur_time_msec();
+        for (int i = 0; i < l_calls; i++)
+            randombytes(l_buf, l_sizes[s]);
+        snprintf(l_msg, sizeof(l_msg), "randombytes() %u bytes calls", l_sizes[s]);
+        benchmark_mgs_rate(l_msg, l_calls * 1000.0f / dap_max(get_cur_time_msec() - l_time, 1));
+    }
+}
+
+void dap_rand_tests_run(int a_times)
+{
+    dap_print_module_name("dap_rand");
+    uint8_t *l_sample = DAP_NEW_Z_SIZE(uint8_t, RAND_SAMPLE_SIZE);
+    dap_assert_PIF(l_sample, "Memory allocation");
+    // Mix of small and big requests
+    for (size_t l_pos = 0, l_size = 1; l_pos < RAND_SAMPLE_SIZE; l_pos += l_size, l_size = l_size * 3 % 1500 + 1)
+        randombytes(l_sample + l_pos, dap_min(l_size, RAND_SAMPLE_SIZE - l_pos));
+    s_statistics_test(l_sample, RAND_SAMPLE_SIZE);
+    DAP_DELETE(l_sample);
+    s_independence_test();
+    s_calls_benchmark(a_times);
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "dap_test.h"
+#include "rand/dap_rand.h"
+
+extern void dap_rand_tests_run(int a_times);
@@ -4,6 +4,8 @@
 #include "dap_enc_benchmark_test.h"
 #include "dap_enc_multithread_test.h"
 #include "dap_enc_ringct20_test.h"
+#include "dap_rand_test.h"
+#include "dap_pq_impl_test.h"
 #include "rand/dap_rand.h"
 #include "dap_common.h"
 
@@ -31,8 +33,16 @@ int main(void) {
     test_encypt_decrypt_fast(l_times, DAP_ENC_KEY_TYPE_IAES, 32);
     test_encypt_decrypt(l_times, DAP_ENC_KEY_TYPE_OAES, 32);
     test_encypt_decrypt_fast(l_times, DAP_ENC_KEY_TYPE_OAES, 32);
+    test_encypt_decrypt(l_times, DAP_ENC_KEY_TYPE_AES256_GCM, 32);
+    test_encypt_decrypt_fast(l_times, DAP_ENC_KEY_TYPE_AES256_GCM, 32);
+    test_encypt_decrypt_tamper(l_times, DAP_ENC_KEY_TYPE_AES256_GCM, 32);
+    test_encypt_decrypt(l_times, DAP_ENC_KEY_TYPE_CHACHA20_POLY1305, 32);
+    test_encypt_decrypt_fast(l_times, DAP_ENC_KEY_TYPE_CHACHA20_POLY1305, 32);
+    test_encypt_decrypt_tamper(l_times, DAP_ENC_KEY_TYPE_CHACHA20_POLY1305, 32);
 
+    dap_rand_tests_run(l_times);
     dap_enc_tests_run();
+    dap_pq_impl_tests_run(l_times);
     dap_enc_base64_tests_run(l_times);
     dap_enc_base58_tests_run(l_times);
     dap_enc_ringct20_tests_run(l_times);
@@ -21,6 +21,7 @@
     along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <string.h>
+#include "uthash.h"
 #include "dap_common.h"
 #include "dap_config.h"
 #include "dap_strfuncs.h"
@@ -55,6 +56,7 @@ enum queue_io_msg_opcode {
     MSG_OPCODE_SET_MULTIPLE,
     MSG_OPCODE_PIN,
     MSG_OPCODE_DELETE,
+    MSG_OPCODE_BATCH,
     MSG_OPCODE_FLUSH
 };
 
@@ -69,6 +71,7 @@ struct queue_io_msg{
         dap_global_db_callback_result_raw_t  callback_result_raw;
         dap_global_db_callback_results_t     callback_results;
         dap_global_db_callback_results_raw_t callback_results_raw;
+        dap_global_db_callback_batch_t       callback_batch;
     };
     // Custom argument passed to the callback
     void *callback_arg;
@@ -87,6 +90,7 @@ struct queue_io_msg{
             dap_global_db_obj_t *values;
             uint64_t values_count;
         };
+        dap_global_db_batch_t *batch; // Write batch commit
         struct { // Value for singe request
             void *value;
             size_t value_length;
@@ -98,6 +102,29 @@ struct queue_io_msg{
     dap_global_db_instance_t *dbi;
 };
 
+// Write batch, operations are applied in the order of addition
+struct dap_global_db_batch {
+    struct gdb_batch_op {
+        enum gdb_batch_op_type {
+            GDB_BATCH_OP_SET,
+            GDB_BATCH_OP_PIN,
+            GDB_BATCH_OP_UNPIN,
+            GDB_BATCH_OP_DEL
+        } type;
+        char *group;
+        char *key;
+        byte_t *value;
+        size_t value_len;
+        bool pin;
+    } *ops;
+    size_t count;
+    size_t size;                                // Allocated ops count
+#ifdef DAP_SDK_TESTS
+    dap_global_db_callback_batch_check_t callback_check;
+    void *callback_check_arg;
+#endif
+};
+
 static pthread_cond_t s_check_db_cond = PTHREAD_COND_INITIALIZER; // Check version condition
 static pthread_mutex_t s_check_db_mutex = PTHREAD_MUTEX_INITIALIZER; // Check version condition mutex
 #define INVALID_RETCODE +100500
@@ -125,6 +152,7 @@ static void s_check_pinned_db_objs_deinit();
 
 static int s_pinned_objs_group_init();
 static int s_add_pinned_obj_in_pinned_group(dap_store_obj_t * a_objs);
+static int s_add_pinned_obj_in_pinned_group_ex(dap_store_obj_t *a_objs, dap_store_obj_t **a_pinned_obj);
 static void s_del_pinned_obj_from_pinned_group_by_source_group(const char * a_group, const char* a_key);
 static bool s_check_is_obj_pinned(const char * a_group, const char * a_key);
 DAP_STATIC_INLINE char *dap_get_local_pinned_groups_mask(const char *a_group);
@@ -149,6 +177,7 @@ static void s_msg_opcode_set_raw(struct queue_io_msg * a_msg);
 static void s_msg_opcode_set_multiple_zc(struct queue_io_msg * a_msg);
 static void s_msg_opcode_pin(struct queue_io_msg * a_msg);
 static void s_msg_opcode_delete(struct queue_io_msg * a_msg);
+static void s_msg_opcode_batch(struct queue_io_msg * a_msg);
 static void s_msg_opcode_flush(struct queue_io_msg * a_msg);
 
 // Free memor for queue i/o message
@@ -284,7 +313,69 @@ bool dap_global_db_group_match_mask(const char *a_group, const char *a_mask)
     return true;
 }
 
-static int s_store_obj_apply(dap_global_db_instance_t *a_dbi, dap_store_obj_t *a_obj)
+static void s_store_obj_notify(dap_global_db_cluster_t *a_cluster, dap_store_obj_t *a_obj)
+{
+    if (a_obj->flags & DAP_GLOBAL_DB_RECORD_NEW)
+        // Notify sync cluster first
+        dap_global_db_cluster_broadcast(a_cluster, a_obj);
+    if (a_cluster->notifiers)
+        // Notify others
+        dap_global_db_cluster_notify(a_cluster, a_obj);
+}
+
+// What is left to do with the applied object: pinned group bookkeeping and notifications
+struct gdb_post_apply {
+    enum {
+        GDB_PINNED_KEEP,
+        GDB_PINNED_ADD,
+        GDB_PINNED_DEL
+    } pinned;
+    dap_global_db_cluster_t *notify_cluster;    // NULL if there is nothing to notify
+    dap_store_obj_t *pinned_obj;                // Record added to the pinned group, it's notified with the object
+};
+
+/**
+ * @brief Does the pinned group bookkeeping of the applied object
+ * @param a_post what is left to do with the object
+ * @param a_obj an object
+ * @param a_defer_notify the record added to the pinned group is kept in a_post to be notified by s_store_obj_post_notify()
+ */
+static void s_store_obj_post_pinned(struct gdb_post_apply *a_post, dap_store_obj_t *a_obj, bool a_defer_notify)
+{
+    switch (a_post->pinned) {
+    case GDB_PINNED_ADD:
+        s_add_pinned_obj_in_pinned_group_ex(a_obj, a_defer_notify ? &a_post->pinned_obj : NULL);
+        break;
+    case GDB_PINNED_DEL:
+        s_del_pinned_obj_from_pinned_group_by_source_group(a_obj->group, a_obj->key);
+        break;
+    default:
+        break;
+    }
+}
+
+static void s_store_obj_post_notify(struct gdb_post_apply *a_post, dap_store_obj_t *a_obj)
+{
+    if (a_post->notify_cluster)
+        s_store_obj_notify(a_post->notify_cluster, a_obj);
+    if (a_post->pinned_obj) {
+        dap_global_db_cluster_t *l_cluster = dap_global_db_cluster_by_group(s_dbi, a_post->pinned_obj->group);
+        if (l_cluster)
+            s_store_obj_notify(l_cluster, a_post->pinned_obj);
+        dap_store_obj_free_one(a_post->pinned_obj);
+        a_post->pinned_obj = NULL;
+    }
+}
+
+/**
+ * @brief Checks and applies the object
+ * @param a_dbi a global DB instance
+ * @param a_obj an object
+ * @param a_post if not NULL, pinned group bookkeeping and notifications are deferred:
+ *               they are returned to be done with s_store_obj_post_pinned() and s_store_obj_post_notify() by the caller
+ * @return Returns 0 if successful
+ */
+static int s_store_obj_apply_ex(dap_global_db_instance_t *a_dbi, dap_store_obj_t *a_obj, struct gdb_post_apply *a_post)
 {
     dap_global_db_cluster_t *l_cluster = dap_global_db_cluster_by_group(a_dbi, a_obj->group);
     if (!l_cluster) {
@@ -404,22 +495,18 @@ static int s_store_obj_apply(dap_global_db_instance_t *a_dbi, dap_store_obj_t *a
         // Only the condition to apply new object
         l_ret = dap_global_db_driver_apply(a_obj, 1);
 
-        // if global_db obj is pinned
-        if (a_obj->flags & DAP_GLOBAL_DB_RECORD_PINNED) {
-            s_add_pinned_obj_in_pinned_group(a_obj);
-        // if upin obj
-        } else if (l_existed_obj_pinned && !(a_obj->flags & DAP_GLOBAL_DB_RECORD_PINNED)) {
-            s_del_pinned_obj_from_pinned_group_by_source_group(a_obj->group, a_obj->key);
-        }
-
-        if (l_obj_type != DAP_GLOBAL_DB_OPTYPE_DEL || l_read_obj) {
+        struct gdb_post_apply l_post = {
+            // if global_db obj is pinned or if unpin obj
+            .pinned = a_obj->flags & DAP_GLOBAL_DB_RECORD_PINNED ? GDB_PINNED_ADD
+                    : l_existed_obj_pinned ? GDB_PINNED_DEL : GDB_PINNED_KEEP,
             // Do not notify for delete if deleted record not exists
-            if (a_obj->flags & DAP_GLOBAL_DB_RECORD_NEW)
-                // Notify sync cluster first
-                dap_global_db_cluster_broadcast(l_cluster, a_obj);
-            if (l_cluster->notifiers)
-                // Notify others
-                dap_global_db_cluster_notify(l_cluster, a_obj);
+            .notify_cluster = l_obj_type != DAP_GLOBAL_DB_OPTYPE_DEL || l_read_obj ? l_cluster : NULL
+        };
+        if (a_post)
+            *a_post = l_post;
+        else {
+            s_store_obj_post_pinned(&l_post, a_obj, false);
+            s_store_obj_post_notify(&l_post, a_obj);
         }
     }
 free_n_exit:
@@ -428,6 +515,11 @@ free_n_exit:
     return l_ret;
 }
 
+static inline int s_store_obj_apply(dap_global_db_instance_t *a_dbi, dap_store_obj_t *a_obj)
+{
+    return s_store_obj_apply_ex(a_dbi, a_obj, NULL);
+}
+
 /* *** Get functions group *** */
 
 byte_t *dap_global_db_get_sync(const char *a_group,
@@ -989,6 +1081,56 @@ static bool s_msg_opcode_get_all_raw(struct queue_io_msg *a_msg)
     return l_rc == DAP_GLOBAL_DB_RC_PROGRESS && l_ret;
 }
 
+/* *** Cursor functions group *** */
+
+/**
+ * @brief Opens an iterator over the group, records are read by batches over a snapshot made at the opening moment
+ * @param a_group a group name
+ * @param a_with_holes if true - iterate deleted records too
+ * @return a cursor to be closed with dap_global_db_cursor_close(), NULL if group is empty or on error
+ */
+dap_global_db_cursor_t *dap_global_db_cursor_open(const char *a_group, bool a_with_holes)
+{
+    dap_return_val_if_fail(s_dbi && a_group, NULL);
+    return dap_global_db_driver_cursor_open(a_group, a_with_holes);
+}
+
+/**
+ * @brief Gets next batch of records from the cursor
+ * @param a_cursor a cursor
+ * @param a_objs_count[in] a max batch size, 0 for default
+ * @param a_objs_count[out] a number of returned records
+ * @return an array of records to be deleted with dap_global_db_objs_delete(), NULL if there are no more records
+ */
+dap_global_db_obj_t *dap_global_db_cursor_next(dap_global_db_cursor_t *a_cursor, size_t *a_objs_count)
+{
+    dap_return_val_if_fail(a_cursor && a_objs_count, NULL);
+    dap_store_obj_t *l_store_objs = dap_global_db_driver_cursor_next(a_cursor, a_objs_count);
+    return l_store_objs ? s_objs_from_store_objs(l_store_objs, *a_objs_count) : NULL;
+}
+
+/**
+ * @brief Gets next batch of records from the cursor in raw format
+ * @param a_cursor a cursor
+ * @param a_objs_count[in] a max batch size, 0 for default
+ * @param a_objs_count[out] a number of returned records
+ * @return an array of records to be deleted with dap_store_obj_free(), NULL if there are no more records
+ */
+dap_store_obj_t *dap_global_db_cursor_next_raw(dap_global_db_cursor_t *a_cursor, size_t *a_objs_count)
+{
+    dap_return_val_if_fail(a_cursor && a_objs_count, NULL);
+    return dap_global_db_driver_cursor_next(a_cursor, a_objs_count);
+}
+
+/**
+ * @brief Closes the cursor and releases its snapshot
+ * @param a_cursor a cursor
+ */
+void dap_global_db_cursor_close(dap_global_db_cursor_t *a_cursor)
+{
+    dap_global_db_driver_cursor_close(a_cursor);
+}
+
 static int s_set_sync_with_ts(dap_global_db_instance_t *a_dbi, const char *a_group, const char *a_key, const void *a_value,
                               const size_t a_value_length, bool a_pin_value, dap_nanotime_t a_timestamp)
 {
@@ -1497,6 +1639,314 @@ static void s_msg_opcode_delete(struct queue_io_msg * a_msg)
     }
 }
 
+/* *** Write batch functions group *** */
+
+/**
+ * @brief Creates an empty write batch
+ * @return a new batch to be committed or deleted with dap_global_db_batch_delete()
+ */
+dap_global_db_batch_t *dap_global_db_batch_new()
+{
+    return DAP_NEW_Z_RET_VAL_IF_FAIL(dap_global_db_batch_t, NULL);
+}
+
+static int s_batch_add(dap_global_db_batch_t *a_batch, enum gdb_batch_op_type a_type, const char *a_group, const char *a_key,
+                       const void *a_value, size_t a_value_len, bool a_pin)
+{
+    dap_return_val_if_fail(a_batch && a_group && a_key, DAP_GLOBAL_DB_RC_ERROR);
+    if (a_batch->count == a_batch->size) {
+        size_t l_size = a_batch->size ? a_batch->size * 2 : 16;
+        a_batch->ops = DAP_REALLOC_RET_VAL_IF_FAIL(a_batch->ops, l_size * sizeof(struct gdb_batch_op), DAP_GLOBAL_DB_RC_CRITICAL);
+        a_batch->size = l_size;
+    }
+    struct gdb_batch_op *l_op = a_batch->ops + a_batch->count;
+    *l_op = (struct gdb_batch_op) { .type = a_type, .value_len = a_value_len, .pin = a_pin };
+    l_op->group = dap_strdup(a_group);
+    l_op->key = dap_strdup(a_key);
+    if (a_value && a_value_len)
+        l_op->value = DAP_DUP_SIZE((byte_t *)a_value, a_value_len);
+    if (!l_op->group || !l_op->key || (a_value && a_value_len && !l_op->value)) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        DAP_DEL_MULTY(l_op->group, l_op->key, l_op->value);
+        return DAP_GLOBAL_DB_RC_CRITICAL;
+    }
+    a_batch->count++;
+    return DAP_GLOBAL_DB_RC_SUCCESS;
+}
+
+/**
+ * @brief Adds a value setting into the batch
+ * @param a_batch a batch
+ * @param a_group a group name
+ * @param a_key a key
+ * @param a_value a value, it's copied
+ * @param a_value_length a value length
+ * @param a_pin_value pin the value
+ * @return Returns 0 if successful
+ */
+int dap_global_db_batch_set(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key, const void *a_value, const size_t a_value_length, bool a_pin_value)
+{
+    return s_batch_add(a_batch, GDB_BATCH_OP_SET, a_group, a_key, a_value, a_value_length, a_pin_value);
+}
+
+/**
+ * @brief Adds pinning of the existed value into the batch
+ * @param a_batch a batch
+ * @param a_group a group name
+ * @param a_key a key
+ * @return Returns 0 if successful
+ */
+int dap_global_db_batch_pin(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key)
+{
+    return s_batch_add(a_batch, GDB_BATCH_OP_PIN, a_group, a_key, NULL, 0, true);
+}
+
+/**
+ * @brief Adds unpinning of the existed value into the batch
+ * @param a_batch a batch
+ * @param a_group a group name
+ * @param a_key a key
+ * @return Returns 0 if successful
+ */
+int dap_global_db_batch_unpin(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key)
+{
+    return s_batch_add(a_batch, GDB_BATCH_OP_UNPIN, a_group, a_key, NULL, 0, false);
+}
+
+/**
+ * @brief Adds a value deletion into the batch
+ * @param a_batch a batch
+ * @param a_group a group name
+ * @param a_key a key
+ * @return Returns 0 if successful
+ */
+int dap_global_db_batch_del(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key)
+{
+    return s_batch_add(a_batch, GDB_BATCH_OP_DEL, a_group, a_key, NULL, 0, false);
+}
+
+#ifdef DAP_SDK_TESTS
+/**
+ * @brief Sets the callback called in the batch transaction after all operations are applied
+ * @param a_batch a batch
+ * @param a_callback a callback, the batch is rolled back if it returns false
+ * @param a_arg a callback argument
+ */
+void dap_global_db_batch_set_check(dap_global_db_batch_t *a_batch, dap_global_db_callback_batch_check_t a_callback, void *a_arg)
+{
+    dap_return_if_fail(a_batch);
+    a_batch->callback_check = a_callback;
+    a_batch->callback_check_arg = a_arg;
+}
+#endif
+
+size_t dap_global_db_batch_count(dap_global_db_batch_t *a_batch)
+{
+    return a_batch ? a_batch->count : 0;
+}
+
+void dap_global_db_batch_delete(dap_global_db_batch_t *a_batch)
+{
+    if (!a_batch)
+        return;
+    for (size_t i = 0; i < a_batch->count; i++)
+        DAP_DEL_MULTY(a_batch->ops[i].group, a_batch->ops[i].key, a_batch->ops[i].value);
+    DAP_DEL_MULTY(a_batch->ops, a_batch);
+}
+
+/**
+ * @brief Makes a signed object for the batch operation and applies it with deferred pinning and notification
+ * @param a_dbi a global DB instance
+ * @param a_op an operation
+ * @param a_obj[out] an object to be freed by the caller
+ * @param a_post[out] what is left to be done after the commit
+ * @return Returns 0 if successful
+ */
+static int s_batch_op_apply(dap_global_db_instance_t *a_dbi, struct gdb_batch_op *a_op, dap_store_obj_t *a_obj,
+                            struct gdb_post_apply *a_post)
+{
+    switch (a_op->type) {
+    case GDB_BATCH_OP_PIN:
+    case GDB_BATCH_OP_UNPIN: {
+        // Read under the transaction, so it sees previous operations of the batch
+        dap_store_obj_t *l_cur = dap_global_db_driver_read(a_op->group, a_op->key, NULL, false);
+        if (!l_cur) {
+            log_it(L_ERROR, "Can't %s absent record group %s key %s", a_op->pin ? "pin" : "unpin", a_op->group, a_op->key);
+            return DAP_GLOBAL_DB_RC_NO_RESULTS;
+        }
+        *a_obj = *l_cur;
+        DAP_DEL_Z(a_obj->sign);
+        DAP_DELETE(l_cur);
+        a_obj->flags = DAP_GLOBAL_DB_RECORD_NEW | (a_op->pin ? DAP_GLOBAL_DB_RECORD_PINNED : 0);
+    } break;
+    case GDB_BATCH_OP_SET:
+    case GDB_BATCH_OP_DEL:
+        *a_obj = (dap_store_obj_t) {
+            .flags      = DAP_GLOBAL_DB_RECORD_NEW | (a_op->type == GDB_BATCH_OP_DEL ? DAP_GLOBAL_DB_RECORD_DEL :
+                                                      a_op->pin ? DAP_GLOBAL_DB_RECORD_PINNED : 0),
+            .group      = dap_strdup(a_op->group),
+            .key        = dap_strdup(a_op->key),
+            .value      = a_op->value ? DAP_DUP_SIZE(a_op->value, a_op->value_len) : NULL,
+            .value_len  = a_op->value ? a_op->value_len : 0
+        };
+        if (!a_obj->group || !a_obj->key || (a_op->value && !a_obj->value))
+            return log_it(L_CRITICAL, "%s", c_error_memory_alloc), DAP_GLOBAL_DB_RC_CRITICAL;
+        break;
+    default:
+        return DAP_GLOBAL_DB_RC_ERROR;
+    }
+    a_obj->timestamp = dap_nanotime_now();
+    a_obj->crc = 0;
+    a_obj->sign = dap_store_obj_sign(a_obj, a_dbi->signing_key, &a_obj->crc);
+    if (!a_obj->sign) {
+        log_it(L_ERROR, "Can't sign new global DB object group %s key %s", a_obj->group, a_obj->key);
+        return DAP_GLOBAL_DB_RC_ERROR;
+    }
+    return s_store_obj_apply_ex(a_dbi, a_obj, a_post);
+}
+
+/**
+ * @brief Leaves the pinned group bookkeeping to the last batch operation on each key. Earlier ones are decided
+ *        on the intermediate states, and their pinning would rewrite the record over the later operations.
+ * @param a_batch a batch
+ * @param a_posts post-apply actions of the batch operations
+ */
+static void s_batch_pinned_last_only(dap_global_db_batch_t *a_batch, struct gdb_post_apply *a_posts)
+{
+    struct gdb_batch_key {
+        UT_hash_handle hh;
+        struct gdb_post_apply *last;
+        char name[];                            // Group and key, both zero terminated
+    } *l_keys = NULL, *l_key, *l_found, *l_tmp;
+    for (size_t i = a_batch->count; i--; ) {
+        struct gdb_batch_op *l_op = a_batch->ops + i;
+        size_t l_group_len = strlen(l_op->group) + 1, l_len = l_group_len + strlen(l_op->key) + 1;
+        if (!(l_key = DAP_NEW_Z_SIZE(struct gdb_batch_key, sizeof(struct gdb_batch_key) + l_len))) {
+            log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+            break;
+        }
+        memcpy(l_key->name, l_op->group, l_group_len);
+        memcpy(l_key->name + l_group_len, l_op->key, l_len - l_group_len);
+        HASH_FIND(hh, l_keys, l_key->name, l_len, l_found);
+        if (l_found) {
+            // Last operation doesn't touch the pinned group, but the record could be pinned or unpinned before it
+            if (l_found->last->pinned == GDB_PINNED_KEEP && a_posts[i].pinned != GDB_PINNED_KEEP)
+                l_found->last->pinned = GDB_PINNED_DEL;
+            a_posts[i].pinned = GDB_PINNED_KEEP;
+            DAP_DELETE(l_key);
+            continue;
+        }
+        l_key->last = a_posts + i;
+        HASH_ADD_KEYPTR(hh, l_keys, l_key->name, l_len, l_key);
+    }
+    HASH_ITER(hh, l_keys, l_key, l_tmp) {
+        HASH_DEL(l_keys, l_key);
+        DAP_DELETE(l_key);
+    }
+}
+
+static int s_batch_commit_sync(dap_global_db_instance_t *a_dbi, dap_global_db_batch_t *a_batch)
+{
+    if (!a_batch->count)
+        return DAP_GLOBAL_DB_RC_SUCCESS;
+    if (dap_global_db_driver_batch_start()) {
+        log_it(L_ERROR, "Can't start transaction for batch of %zu operations", a_batch->count);
+        return DAP_GLOBAL_DB_RC_ERROR;
+    }
+    dap_store_obj_t *l_objs = DAP_NEW_Z_COUNT(dap_store_obj_t, a_batch->count);
+    struct gdb_post_apply *l_posts = DAP_NEW_Z_COUNT(struct gdb_post_apply, a_batch->count);
+    int l_ret = l_objs && l_posts ? DAP_GLOBAL_DB_RC_SUCCESS : DAP_GLOBAL_DB_RC_CRITICAL;
+    if (l_ret)
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+    for (size_t i = 0; !l_ret && i < a_batch->count; i++) {
+        if ( (l_ret = s_batch_op_apply(a_dbi, a_batch->ops + i, l_objs + i, l_posts + i)) )
+            log_it(L_ERROR, "Batch operation %zu / %zu on group %s key %s failed with code %d, batch is rolled back",
+                            i + 1, a_batch->count, a_batch->ops[i].group, a_batch->ops[i].key, l_ret);
+    }
+    // Pinned groups are written in the same transaction, so they are committed or rolled back with the records
+    if (!l_ret) {
+        s_batch_pinned_last_only(a_batch, l_posts);
+        for (size_t j = 0; j < a_batch->count; j++)
+            s_store_obj_post_pinned(l_posts + j, l_objs + j, true);
+    }
+#ifdef DAP_SDK_TESTS
+    if (!l_ret && a_batch->callback_check && !a_batch->callback_check(a_dbi, a_batch->count, a_batch->callback_check_arg)) {
+        log_it(L_WARNING, "Batch of %zu operations is rejected by the check callback, batch is rolled back", a_batch->count);
+        l_ret = DAP_GLOBAL_DB_RC_ERROR;
+    }
+#endif
+    if (dap_global_db_driver_txn_end(!l_ret) && !l_ret) {
+        log_it(L_ERROR, "Can't commit batch of %zu operations", a_batch->count);
+        l_ret = DAP_GLOBAL_DB_RC_ERROR;
+    }
+    // Subscribers see only the committed batch
+    for (size_t j = 0; l_posts && j < a_batch->count; j++) {
+        if (!l_ret)
+            s_store_obj_post_notify(l_posts + j, l_objs + j);
+        dap_store_obj_free_one(l_posts[j].pinned_obj);
+    }
+    if (l_objs)
+        dap_store_obj_free(l_objs, a_batch->count);
+    DAP_DELETE(l_posts);
+    return l_ret == DAP_GLOBAL_DB_RC_SUCCESS || l_ret == DAP_GLOBAL_DB_RC_CRITICAL ? l_ret : DAP_GLOBAL_DB_RC_ERROR;
+}
+
+/**
+ * @brief Applies all operations of the batch in one driver transaction. Nothing is applied if any of them fails.
+ *        Notifications are sent after the commit only.
+ * @param a_batch a batch, it's kept and may be committed again
+ * @return Returns 0 if successful
+ */
+int dap_global_db_batch_commit_sync(dap_global_db_batch_t *a_batch)
+{
+    dap_return_val_if_fail(s_dbi && a_batch, DAP_GLOBAL_DB_RC_ERROR);
+    return s_batch_commit_sync(s_dbi, a_batch);
+}
+
+/**
+ * @brief s_msg_opcode_batch
+ * @param a_msg
+ */
+static void s_msg_opcode_batch(struct queue_io_msg *a_msg)
+{
+    int l_res = s_batch_commit_sync(a_msg->dbi, a_msg->batch);
+    if (a_msg->callback_batch)
+        a_msg->callback_batch(a_msg->dbi, l_res, a_msg->batch->count, a_msg->callback_arg);
+}
+
+/**
+ * @brief Commits the batch in GlobalDB context, see dap_global_db_batch_commit_sync()
+ * @param a_batch a batch, it's consumed regardless of the result
+ * @param a_callback a callback called once after the commit
+ * @param a_arg a callback argument
+ * @return Returns 0 if the request is sent
+ */
+int dap_global_db_batch_commit(dap_global_db_batch_t *a_batch, dap_global_db_callback_batch_t a_callback, void *a_arg)
+{
+    dap_return_val_if_fail(a_batch, DAP_GLOBAL_DB_RC_ERROR);
+    dap_return_val_if_fail_err(s_dbi, DAP_GLOBAL_DB_RC_ERROR, "GlobalDB isn't initialized");
+    struct queue_io_msg *l_msg = DAP_NEW_Z(struct queue_io_msg);
+    if (!l_msg) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        dap_global_db_batch_delete(a_batch);
+        return DAP_GLOBAL_DB_RC_CRITICAL;
+    }
+    l_msg->dbi = s_dbi;
+    l_msg->opcode = MSG_OPCODE_BATCH;
+    l_msg->batch = a_batch;
+    l_msg->callback_batch = a_callback;
+    l_msg->callback_arg = a_arg;
+    size_t l_count = a_batch->count;
+    int l_ret = dap_proc_thread_callback_add(NULL, s_queue_io_callback, l_msg);
+    if (l_ret != 0) {
+        log_it(L_ERROR, "Can't exec batch request, code %d", l_ret);
+        s_queue_io_msg_delete(l_msg);
+        return DAP_GLOBAL_DB_RC_ERROR;
+    }
+    debug_if(g_dap_global_db_debug_more, L_DEBUG, "Have sent batch request with %zu operations", l_count);
+    return DAP_GLOBAL_DB_RC_SUCCESS;
+}
+
 /* *** Flush functions group *** */
 
 /**
@@ -1621,6 +2071,7 @@ static const char *s_msg_opcode_to_str(enum queue_io_msg_opcode a_opcode)
         case MSG_OPCODE_SET_RAW:        return "SET_RAW";
         case MSG_OPCODE_PIN:            return "PIN";
         case MSG_OPCODE_DELETE:         return "DELETE";
+        case MSG_OPCODE_BATCH:          return "BATCH";
         case MSG_OPCODE_FLUSH:          return "FLUSH";
         default:                        return "UNKNOWN";
     }
@@ -1652,6 +2103,7 @@ static bool s_queue_io_callback(void * a_arg)
     case MSG_OPCODE_SET_RAW:        s_msg_opcode_set_raw(l_msg); break;
     case MSG_OPCODE_PIN:            s_msg_opcode_pin(l_msg); break;
     case MSG_OPCODE_DELETE:         s_msg_opcode_delete(l_msg); break;
+    case MSG_OPCODE_BATCH:          s_msg_opcode_batch(l_msg); break;
     case MSG_OPCODE_FLUSH:          s_msg_opcode_flush(l_msg); break;
     default:
         log_it(L_WARNING, "Message with undefined opcode %d received in queue_io",
@@ -1685,6 +2137,9 @@ static void s_queue_io_msg_delete( struct queue_io_msg * a_msg)
         break;
     case MSG_OPCODE_SET_RAW:
         dap_store_obj_free(a_msg->values_raw, a_msg->values_raw_total);
+        break;
+    case MSG_OPCODE_BATCH:
+        dap_global_db_batch_delete(a_msg->batch);
     default:;
     }
     DAP_DEL_Z(a_msg);
@@ -1709,61 +2164,104 @@ static int s_check_db_version()
     return l_ret;
 }
 
-static void s_clean_old_obj_gdb_callback(void UNUSED_ARG *a_arg) {
-    debug_if(g_dap_global_db_debug_more, L_INFO, "Start clean old objs in global_db callback");
-    dap_list_t *l_group_list = dap_global_db_driver_get_groups_by_mask("*");
-    size_t l_count = 0;
-    for (dap_list_t *l_list = l_group_list; l_list; l_list = dap_list_next(l_list), ++l_count) {
-        size_t l_count_obj = dap_global_db_driver_count((char*)l_list->data, c_dap_global_db_driver_hash_blank, true);
-        if (!l_count_obj) {
-            debug_if(g_dap_global_db_debug_more, L_INFO, "Empty group %s, delete it", (char*)l_list->data);
-            dap_global_db_del_sync((char*)l_list->data, NULL);
-            continue;
+// Expired objects are erased continuously with a time budget per tick, group by group, range by range
+static struct gdb_expire_state {
+    pthread_mutex_t mutex;
+    dap_list_t *groups;                         // Groups snapshot of the current pass
+    dap_list_t *current;                        // Group under processing
+    dap_global_db_driver_hash_t hash_from;      // Last examined driver key of the current group
+    dap_nanotime_t budget;                      // Max time spent by one tick
+    size_t batch;                               // Max count of records examined by one driver call
+    bool active;
+} s_expire = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+/**
+ * @brief Processes one step of expiration for the current group
+ * @return true if the group is finished, false if it has more records to examine
+ */
+static bool s_expire_group_step(const char *a_group)
+{
+    if ( dap_global_db_driver_hash_is_blank(&s_expire.hash_from) ) {
+        // First visit of the group in this pass
+        dap_store_obj_t *l_last = dap_global_db_driver_read_last(a_group, true);
+        if (!l_last) {
+            debug_if(g_dap_global_db_debug_more, L_INFO, "Empty group %s, delete it", a_group);
+            dap_global_db_del_sync(a_group, NULL);
+            return true;
         }
-        dap_global_db_cluster_t *l_cluster = dap_global_db_cluster_by_group(s_dbi, (char*)l_list->data);
-        if (!l_cluster) {
-            continue;
+        dap_store_obj_free_one(l_last);
+    }
+    dap_global_db_cluster_t *l_cluster = dap_global_db_cluster_by_group(s_dbi, a_group);
+    if (!l_cluster)
+        return true;
+    dap_nanotime_t l_time_now = dap_nanotime_now(), l_ttl = dap_nanotime_from_sec(l_cluster->ttl);
+    bool l_holes_only = !l_ttl;
+    // Records without TTL are kept, only holes of local groups are erased
+    if ( l_holes_only && !dap_global_db_group_match_mask(a_group, "local.*") )
+        return true;
+    if (l_cluster->del_callback && !l_holes_only) {
+        // Cluster wants to be notified with the whole expired records, one chunk per pass; holes are erased as is
+        size_t l_count = 0;
+        dap_store_obj_t *l_objs = dap_global_db_driver_read_obj_below_timestamp(a_group, l_time_now - l_ttl, &l_count);
+        for (size_t i = 0; i < l_count; i++) {
+            if ( !l_objs[i].group || (l_objs[i].flags & DAP_GLOBAL_DB_RECORD_PINNED) )
+                continue;
+            debug_if(g_dap_global_db_debug_more, L_INFO, "Try to delete from global_db the obj %s group, %s key", l_objs[i].group, l_objs[i].key);
+            l_cluster->del_callback(l_objs + i, NULL);
         }
-        dap_nanotime_t l_time_now = dap_nanotime_now();
-        dap_nanotime_t l_ttl = dap_nanotime_from_sec(l_cluster->ttl);
-        size_t l_ret_count = 0;
-        dap_store_obj_t *l_ret = dap_global_db_driver_read_obj_below_timestamp((char*)l_list->data, l_time_now - l_ttl, &l_ret_count);
-        while (l_ret_count > 0 && l_ret && l_ret->group) {
-            for(size_t i = 0; i < l_ret_count; i++) {
-                if (!(l_ret[i].flags & DAP_GLOBAL_DB_RECORD_PINNED)) {
-                    if (l_ttl != 0) {
-                        if (l_ret[i].timestamp + l_ttl < l_time_now) {
-                            debug_if(g_dap_global_db_debug_more, L_INFO, "Try to delete from global_db the obj %s group, %s key", l_ret[i].group, l_ret[i].key);
-                            if (l_cluster->del_callback)
-                                l_cluster->del_callback(l_ret+i, NULL);
-                            else dap_global_db_driver_delete(l_ret + i, 1);
-                        }
-                    } else if ( l_ret[i].flags & DAP_GLOBAL_DB_RECORD_DEL && dap_global_db_group_match_mask(l_ret->group, "local.*")) {       
-                        debug_if(g_dap_global_db_debug_more, L_INFO, "Delete from empty local global_db obj %s group, %s key", l_ret[i].group, l_ret[i].key);
-                        dap_global_db_driver_delete(l_ret + i, 1);
-                    }
-                } 
-            }
-            dap_store_obj_free(l_ret, l_ret_count);
-            // filter for local groups
-            if (l_ttl == 0)
-                break;
-            l_ret_count = 0;
-            l_ret = dap_global_db_driver_read_obj_below_timestamp((char*)l_list->data, l_time_now - l_ttl, &l_ret_count);
+        dap_store_obj_free(l_objs, l_count);
+        return true;
+    }
+    dap_global_db_driver_hash_t l_hash_to = { .bets = htobe64(l_time_now - l_ttl) };
+    size_t l_count = s_expire.batch;
+    int l_rc = dap_global_db_driver_erase_range(a_group, &s_expire.hash_from, l_hash_to, l_holes_only, &l_count);
+    debug_if(g_dap_global_db_debug_more && l_count, L_INFO, "Erased %zu expired objs from group %s", l_count, a_group);
+    if (l_rc == DAP_GLOBAL_DB_RC_ERROR)
+        log_it(L_ERROR, "Can't erase expired objs from group %s", a_group);
+    return l_rc != DAP_GLOBAL_DB_RC_PROGRESS;
+}
+
+static void s_clean_old_obj_gdb_callback(void UNUSED_ARG *a_arg)
+{
+    pthread_mutex_lock(&s_expire.mutex);
+    if (!s_expire.active)
+        return pthread_mutex_unlock(&s_expire.mutex), (void)0;
+    dap_nanotime_t l_deadline = dap_nanotime_now() + s_expire.budget;
+    if (!s_expire.current) {
+        // New pass starts not often than once per tick
+        dap_list_free_full(s_expire.groups, NULL);
+        s_expire.current = s_expire.groups = dap_global_db_driver_get_groups_by_mask("*");
+        s_expire.hash_from = c_dap_global_db_driver_hash_blank;
+    }
+    while ( s_expire.current && dap_nanotime_now() < l_deadline ) {
+        if ( s_expire_group_step((const char *)s_expire.current->data) ) {
+            s_expire.current = s_expire.current->next;
+            s_expire.hash_from = c_dap_global_db_driver_hash_blank;
         }
     }
-    dap_list_free(l_group_list);
+    pthread_mutex_unlock(&s_expire.mutex);
 }
 
 static int s_gdb_clean_init()
 {
     debug_if(g_dap_global_db_debug_more, L_INFO, "Init global_db clean old objects");
-    dap_proc_thread_timer_add(NULL, (dap_thread_timer_callback_t)s_clean_old_obj_gdb_callback, NULL, 1800000);
+    uint32_t l_tick_ms = dap_config_get_item_uint32_default(g_config, "global_db", "ttl_expire_tick_ms", 1000);
+    pthread_mutex_lock(&s_expire.mutex);
+    s_expire.budget = (dap_nanotime_t)dap_config_get_item_uint32_default(g_config, "global_db", "ttl_expire_budget_ms", 20) * 1000000;
+    s_expire.batch = dap_config_get_item_uint32_default(g_config, "global_db", "ttl_expire_batch", DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT);
+    s_expire.active = true;
+    pthread_mutex_unlock(&s_expire.mutex);
+    dap_proc_thread_timer_add(NULL, (dap_thread_timer_callback_t)s_clean_old_obj_gdb_callback, NULL, l_tick_ms);
     return 0;
 }
 
 static void s_gdb_clean_deinit()
 {
+    pthread_mutex_lock(&s_expire.mutex);
+    s_expire.active = false;
+    dap_list_free_full(s_expire.groups, NULL);
+    s_expire.groups = s_expire.current = NULL;
+    pthread_mutex_unlock(&s_expire.mutex);
 }
 
 static bool s_check_is_obj_pinned(const char * a_group, const char * a_key)
@@ -1905,12 +2403,51 @@ static void s_set_pinned_timer(const char *a_group)
     }
 }
 
+/**
+ * @brief Sets the record like dap_global_db_set_sync(), but leaves its notification to the caller
+ * @param a_group a group name
+ * @param a_src an object with key and value of the record
+ * @param a_obj_out[out] the applied record to be notified and freed by the caller, NULL if nothing to notify
+ * @return Returns 0 if successful
+ */
+static int s_set_sync_notify_deferred(const char *a_group, dap_store_obj_t *a_src, dap_store_obj_t **a_obj_out)
+{
+    dap_store_obj_t l_obj = {
+        .timestamp  = dap_nanotime_now(),
+        .flags      = DAP_GLOBAL_DB_RECORD_NEW,
+        .group      = (char *)a_group,
+        .key        = a_src->key,
+        .value      = a_src->value,
+        .value_len  = a_src->value_len
+    };
+    if ( !(l_obj.sign = dap_store_obj_sign(&l_obj, s_dbi->signing_key, &l_obj.crc)) )
+        return log_it(L_ERROR, "Can't sign new global DB object group %s key %s", a_group, l_obj.key), DAP_GLOBAL_DB_RC_ERROR;
+    struct gdb_post_apply l_post = { };
+    int l_ret = s_store_obj_apply_ex(s_dbi, &l_obj, &l_post);
+    if (!l_ret && l_post.notify_cluster && !(*a_obj_out = dap_store_obj_copy(&l_obj, 1)))
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+    DAP_DELETE(l_obj.sign);
+    return l_ret;
+}
+
 static int s_add_pinned_obj_in_pinned_group(dap_store_obj_t * a_objs){
+    return s_add_pinned_obj_in_pinned_group_ex(a_objs, NULL);
+}
+
+/**
+ * @brief Adds the pinned object to its local pinned group
+ * @param a_objs a pinned object
+ * @param a_pinned_obj[out] if not NULL, the added record is returned here to be notified by the caller, otherwise it's notified at once
+ * @return Returns 0
+ */
+static int s_add_pinned_obj_in_pinned_group_ex(dap_store_obj_t *a_objs, dap_store_obj_t **a_pinned_obj)
+{
     if (!dap_global_db_group_match_mask(a_objs->group, "*pinned")) {
         char * l_pinned_mask = dap_get_local_pinned_groups_mask(a_objs->group);
         dap_store_obj_t * l_ret_check = dap_global_db_get_raw_sync(l_pinned_mask, a_objs->key);
         if (!l_ret_check) {
-            if (!dap_global_db_set_sync(l_pinned_mask, a_objs->key, a_objs->value, a_objs->value_len, false)) {
+            if (!(a_pinned_obj ? s_set_sync_notify_deferred(l_pinned_mask, a_objs, a_pinned_obj)
+                               : dap_global_db_set_sync(l_pinned_mask, a_objs->key, a_objs->value, a_objs->value_len, false))) {
                 debug_if(g_dap_global_db_debug_more, L_INFO, "Pinned objs was added in pinned group %s, %s key", l_pinned_mask, a_objs->key);
                 a_objs->timestamp = dap_nanotime_now();
                 dap_global_db_driver_apply(a_objs, 1);
@@ -1930,6 +2467,8 @@ static void s_del_pinned_obj_from_pinned_group_by_source_group(const char * a_gr
     dap_store_obj_t * l_pin_del_obj = dap_global_db_get_raw_sync(l_pinned_group, a_key);
     if (l_pin_del_obj)
         dap_global_db_driver_delete(l_pin_del_obj, 1);
+    dap_store_obj_free_one(l_pin_del_obj);
+    DAP_DELETE(l_pinned_group);
 }
 
 static void s_get_all_pinned_objs_in_group(dap_store_obj_t * a_objs, size_t a_objs_count) {
@@ -211,12 +211,22 @@ static bool s_process_request(void *a_arg)
     return false;
 }
 
+static bool s_check_store_obj_access(dap_store_obj_t *a_obj, dap_stream_node_addr_t *a_addr);
+
 bool dap_global_db_ch_check_store_obj(dap_store_obj_t *a_obj, dap_stream_node_addr_t *a_addr)
 {
     if (!dap_global_db_pkt_check_sign_crc(a_obj)) {
         log_it(L_WARNING, "Global DB record packet sign verify or CRC check error for group %s and key %s", a_obj->group, a_obj->key);
         return false;
     }
+    return s_check_store_obj_access(a_obj, a_addr);
+}
+
+/**
+ * @brief s_check_store_obj_access check if sender with a_addr allowed to write object with already checked sign
+ */
+static bool s_check_store_obj_access(dap_store_obj_t *a_obj, dap_stream_node_addr_t *a_addr)
+{
     if (g_dap_global_db_debug_more) {
         char l_ts_str[DAP_TIME_STR_SIZE] = { '\0' };
         dap_time_to_str_rfc822(l_ts_str, sizeof(l_ts_str), dap_nanotime_to_sec(a_obj->timestamp));
@@ -259,10 +269,11 @@ static bool s_process_records(void *a_arg)
 {
     dap_return_val_if_fail(a_arg, false);
     struct processing_arg *l_arg = a_arg;
-    bool l_success = false;
-    for (uint32_t i = 0; i < l_arg->count; i++)
-        if (!(l_success = dap_global_db_ch_check_store_obj(l_arg->objs + i, &l_arg->addr)))
-            break;
+    bool l_success = dap_global_db_pkt_check_sign_crc_batch(l_arg->objs, l_arg->count);
+    if (!l_success)
+        log_it(L_WARNING, "Global DB record pack sign verify or CRC check error for group %s", l_arg->objs->group);
+    for (uint32_t i = 0; l_success && i < l_arg->count; i++)
+        l_success = s_check_store_obj_access(l_arg->objs + i, &l_arg->addr);
     if (l_success)
         dap_global_db_set_raw_sync(l_arg->objs, l_arg->count);
     dap_store_obj_free(l_arg->objs, l_arg->count);
@@ -68,6 +68,21 @@ static char s_used_driver [32];                                             /* N
 
 static dap_global_db_driver_callbacks_t s_drv_callback;                            /* A set of interface routines for the selected
                                                                             DB Driver at startup time */
+/*
+ * Driver transactions are flat: nested start/end pairs only count the depth, the outermost pair
+ * begins and finishes the driver transaction. Rollback of any nested one makes the whole transaction rollback-only.
+ */
+static _Thread_local unsigned s_txn_depth = 0;
+static _Thread_local bool s_txn_rollback_only = false;
+static _Thread_local dap_global_db_driver_txn_end_callback_t s_txn_end = NULL;  /* Finishes the outermost transaction */
+
+struct dap_global_db_driver_cursor {
+    void *drv_cursor;                                                       /* Driver's iterator, NULL for the paged reading */
+    char *group;
+    dap_global_db_driver_hash_t last_hash;                                  /* Last returned record for the paged reading */
+    bool with_holes;
+    bool finished;
+};
 
 /**
  * @brief Initializes a database driver.
@@ -275,8 +290,7 @@ dap_store_obj_t *l_store_obj_cur;
     l_store_obj_cur = a_store_obj;                                          /* We have to  use a power of the address's incremental arithmetic */
     l_ret = 0;                                                              /* Preset return code to OK */
 
-    if (a_store_count > 1)
-        dap_global_db_driver_txn_start();
+    bool l_txn = a_store_count > 1 && !dap_global_db_driver_txn_start();
 
     if (s_drv_callback.apply_store_obj) {
         for(int i = a_store_count; !l_ret && i; l_store_obj_cur++, i--) {
@@ -300,7 +314,7 @@ dap_store_obj_t *l_store_obj_cur;
         debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s not have apply_store_obj callback", s_used_driver);
     }
 
-    if (a_store_count > 1)
+    if (l_txn)
         dap_global_db_driver_txn_end(true);
 
     debug_if(g_dap_global_db_debug_more, L_DEBUG, "[%p] Finished DB Request (code %d)", a_store_obj, l_ret);
@@ -356,6 +370,140 @@ size_t dap_global_db_driver_count(const char *a_group, dap_global_db_driver_hash
     return l_count_out;
 }
 
+/**
+ * @brief Erases records of a group with driver hashes in range (a_hash_from, a_hash_to), pinned records are kept.
+ * Since the driver hash starts with big-endian timestamp it's a way to drop all records older than given time
+ * without reading of their values. Work is limited by a number of examined records, so it may be continued
+ * from the returned position.
+ * @param a_group the group name string
+ * @param a_hash_from[in] a hash to start after, blank to start from the group beginning
+ * @param a_hash_from[out] a last examined hash, position to continue from
+ * @param a_hash_to a hash to stop before
+ * @param a_holes_only erase only records marked as deleted
+ * @param a_count[in] a maximum number of records to be examined, if 0 - use default limit
+ * @param a_count[out] a number of erased records
+ * @return DAP_GLOBAL_DB_RC_SUCCESS if the range is finished, DAP_GLOBAL_DB_RC_PROGRESS if the limit is reached,
+ *         DAP_GLOBAL_DB_RC_ERROR otherwise
+ */
+int dap_global_db_driver_erase_range(const char *a_group, dap_global_db_driver_hash_t *a_hash_from, dap_global_db_driver_hash_t a_hash_to,
+                                     bool a_holes_only, size_t *a_count)
+{
+    dap_return_val_if_fail(a_group && a_hash_from && a_count, DAP_GLOBAL_DB_RC_ERROR);
+    if (s_drv_callback.erase_range)
+        return s_drv_callback.erase_range(a_group, a_hash_from, a_hash_to, a_holes_only, a_count);
+    debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s not have erase_range callback, use conditional read", s_used_driver);
+    // Generic way for drivers w/o native range deletion
+    size_t l_limit = *a_count ? *a_count : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT, l_read_count = l_limit, l_erase_count = 0;
+    *a_count = 0;
+    dap_store_obj_t *l_objs = dap_global_db_driver_cond_read(a_group, *a_hash_from, &l_read_count, true);
+    if (!l_objs)
+        return DAP_GLOBAL_DB_RC_SUCCESS;
+    int l_ret = l_read_count < l_limit ? DAP_GLOBAL_DB_RC_SUCCESS : DAP_GLOBAL_DB_RC_PROGRESS;
+    for (size_t i = 0; i < l_read_count; i++) {
+        dap_global_db_driver_hash_t l_hash_cur = dap_global_db_driver_hash_get(l_objs + i);
+        if (dap_global_db_driver_hash_is_blank(&l_hash_cur) || dap_global_db_driver_hash_compare(&l_hash_cur, &a_hash_to) >= 0) {
+            l_ret = DAP_GLOBAL_DB_RC_SUCCESS;
+            break;
+        }
+        *a_hash_from = l_hash_cur;
+        if ( (l_objs[i].flags & DAP_GLOBAL_DB_RECORD_PINNED) || (a_holes_only && !(l_objs[i].flags & DAP_GLOBAL_DB_RECORD_DEL)) )
+            continue;
+        if (l_erase_count != i) {
+            // Move erased object to the head of array, the kept one is not needed anymore
+            dap_store_obj_t *l_kept = l_objs + l_erase_count;
+            DAP_DEL_MULTY(l_kept->group, l_kept->key, l_kept->value, l_kept->sign);
+            *l_kept = l_objs[i];
+            l_objs[i] = (dap_store_obj_t) { };
+        }
+        l_erase_count++;
+    }
+    if (l_erase_count && dap_global_db_driver_delete(l_objs, l_erase_count))
+        l_ret = DAP_GLOBAL_DB_RC_ERROR;
+    else
+        *a_count = l_erase_count;
+    dap_store_obj_free(l_objs, l_read_count);
+    return l_ret;
+}
+
+/**
+ * @brief Opens an iterator over a group. Records are returned in the driver hash order by batches of bounded size,
+ * so any group may be walked through with a constant memory. If driver supports it, the iterator is backed
+ * by its own read transaction and sees the group snapshot made at the opening moment.
+ * @note The cursor may be passed between threads, but mustn't be used concurrently
+ * @param a_group the group name string
+ * @param a_with_holes if true - iterate any records, if false - only actual records
+ * @return If successful, returns the cursor to be closed with dap_global_db_driver_cursor_close(), otherwise NULL.
+ */
+dap_global_db_driver_cursor_t *dap_global_db_driver_cursor_open(const char *a_group, bool a_with_holes)
+{
+    dap_return_val_if_fail(a_group, NULL);
+    dap_global_db_driver_cursor_t *l_cursor = DAP_NEW_Z_RET_VAL_IF_FAIL(dap_global_db_driver_cursor_t, NULL);
+    l_cursor->with_holes = a_with_holes;
+    if (s_drv_callback.cursor_open) {
+        if ( !(l_cursor->drv_cursor = s_drv_callback.cursor_open(a_group, a_with_holes)) )
+            return DAP_DELETE(l_cursor), NULL;
+        return l_cursor;
+    }
+    debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s not have cursor_open callback, use conditional read", s_used_driver);
+    if ( !(l_cursor->group = dap_strdup(a_group)) ) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return DAP_DELETE(l_cursor), NULL;
+    }
+    return l_cursor;
+}
+
+/**
+ * @brief Retrieves next batch of records from the cursor.
+ * @param a_cursor the cursor
+ * @param a_count[in] a max number of records to return, 0 for default
+ * @param a_count[out] a number of returned records
+ * @return If successful, returns the array of objects to be freed with dap_store_obj_free(), NULL if there are no more records.
+ */
+dap_store_obj_t *dap_global_db_driver_cursor_next(dap_global_db_driver_cursor_t *a_cursor, size_t *a_count)
+{
+    dap_return_val_if_fail(a_cursor && a_count, NULL);
+    size_t l_count = *a_count ? *a_count : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT;
+    *a_count = 0;
+    if (a_cursor->finished)
+        return NULL;
+    dap_store_obj_t *l_objs = NULL;
+    if (a_cursor->drv_cursor) {
+        if ( !(l_objs = s_drv_callback.cursor_next(a_cursor->drv_cursor, &l_count)) || !l_count ) {
+            a_cursor->finished = true;
+            return dap_store_obj_free(l_objs, l_count), NULL;
+        }
+        return *a_count = l_count, l_objs;
+    }
+    // Generic way, re-query the group from the last returned hash
+    size_t l_limit = l_count;
+    if ( !(l_objs = dap_global_db_driver_cond_read(a_cursor->group, a_cursor->last_hash, &l_count, a_cursor->with_holes)) || !l_count ) {
+        a_cursor->finished = true;
+        return dap_store_obj_free(l_objs, l_count), NULL;
+    }
+    dap_global_db_driver_hash_t l_last_hash = dap_global_db_driver_hash_get(l_objs + l_count - 1);
+    if ( dap_global_db_driver_hash_is_blank(&l_last_hash) ) {
+        // Blank marker of the final iteration, it has no allocated fields
+        a_cursor->finished = true;
+        if (!--l_count)
+            return dap_store_obj_free_one(l_objs), NULL;
+    } else if (l_count < l_limit)
+        a_cursor->finished = true;
+    a_cursor->last_hash = dap_global_db_driver_hash_get(l_objs + l_count - 1);
+    return *a_count = l_count, l_objs;
+}
+
+/**
+ * @brief Closes the cursor and releases its resources.
+ * @param a_cursor the cursor
+ */
+void dap_global_db_driver_cursor_close(dap_global_db_driver_cursor_t *a_cursor)
+{
+    dap_return_if_fail(a_cursor);
+    if (a_cursor->drv_cursor)
+        s_drv_callback.cursor_close(a_cursor->drv_cursor);
+    DAP_DEL_MULTY(a_cursor->group, a_cursor);
+}
+
 /**
  * @brief Gets a list of group names matching the pattern.
  * Check whether the groups match the pattern a_group_mask, which is a shell wildcard pattern
@@ -486,18 +634,69 @@ dap_global_db_pkt_pack_t *dap_global_db_driver_get_by_hash(const char *a_group,
     return NULL;
 }
 
+static int s_txn_begin(dap_global_db_driver_txn_start_callback_t a_start, dap_global_db_driver_txn_end_callback_t a_end)
+{
+    if (s_txn_depth) {
+        s_txn_depth++;
+        return 0;
+    }
+    int l_ret = a_start();
+    if (!l_ret) {
+        s_txn_depth = 1;
+        s_txn_rollback_only = false;
+        s_txn_end = a_end;
+    }
+    return l_ret;
+}
+
+/**
+ * @brief Starts a driver transaction for the caller thread. A nested call joins the already started one.
+ * @return Returns 0 if successful, otherwise the driver's error code or -1 if transactions aren't supported
+ */
 int dap_global_db_driver_txn_start()
 {
-    if (s_drv_callback.transaction_start)
-        return s_drv_callback.transaction_start();
-    debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s not have transaction_start callback", s_used_driver);
-    return -1;
+    if (!s_txn_depth && (!s_drv_callback.transaction_start || !s_drv_callback.transaction_end)) {
+        debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s not have transaction_start callback", s_used_driver);
+        return -1;
+    }
+    return s_txn_begin(s_drv_callback.transaction_start, s_drv_callback.transaction_end);
 }
 
+/**
+ * @brief Starts a write batch transaction for the caller thread, it's finished with dap_global_db_driver_txn_end().
+ *        Unlike dap_global_db_driver_txn_start() it fails if the driver can't roll the batch back.
+ * @return Returns 0 if successful, otherwise the driver's error code or -1 if write batches aren't supported
+ */
+int dap_global_db_driver_batch_start()
+{
+    if (!s_txn_depth && (!s_drv_callback.batch_start || !s_drv_callback.batch_end)) {
+        log_it(L_ERROR, "Driver %s doesn't support atomic write batches", s_used_driver);
+        return -1;
+    }
+    return s_txn_begin(s_drv_callback.batch_start, s_drv_callback.batch_end);
+}
+
+/**
+ * @brief Finishes the transaction started by dap_global_db_driver_txn_start() or dap_global_db_driver_batch_start()
+ * @param a_commit true to commit, false to rollback. Nested rollback is deferred up to the outermost call
+ * @return Returns 0 if successful, otherwise the driver's error code or DAP_GLOBAL_DB_RC_ERROR
+ *         if the commit is requested for the transaction rolled back by the nested one
+ */
 int dap_global_db_driver_txn_end(bool a_commit)
 {
-    if (s_drv_callback.transaction_end)
-        return  s_drv_callback.transaction_end(a_commit);
-    debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s not have transaction_end callback", s_used_driver);
-    return -1;
+    if (!s_txn_depth) {
+        debug_if(g_dap_global_db_debug_more, L_WARNING, "Driver %s transaction isn't started", s_used_driver);
+        return -1;
+    }
+    if (!a_commit)
+        s_txn_rollback_only = true;
+    if (--s_txn_depth)
+        return 0;
+    int l_ret = s_txn_end(!s_txn_rollback_only);
+    if (!l_ret && a_commit && s_txn_rollback_only) {
+        log_it(L_WARNING, "Driver %s transaction is rolled back by the nested one", s_used_driver);
+        l_ret = DAP_GLOBAL_DB_RC_ERROR;
+    }
+    s_txn_rollback_only = false;
+    return l_ret;
 }
@@ -68,10 +68,20 @@
 typedef struct __db_ctx__ {
         size_t  namelen;                                                    /* Group name length */
         char name[DAP_GLOBAL_DB_GROUP_NAME_SIZE_MAX + 1];                   /* Group's name */
-        MDBX_dbi    dbi;                                                    /* MDBX's internal context id */
-        UT_hash_handle hh;
+        _Atomic(MDBX_dbi) dbi;                                              /* MDBX's internal context id, renewed when the group is revived */
+        atomic_bool dropped;                                                /* Group table has been dropped, context is kept for readers */
 } dap_db_ctx_t;
 
+/** Group iterator, owns a read transaction for the whole iteration */
+typedef struct dap_mdbx_cursor {
+        MDBX_txn    *txn;                                                   /* Snapshot of the DB */
+        MDBX_cursor *cursor;
+        dap_db_ctx_t *db_ctx;
+        unsigned    generation;                                             /* Environment generation at the opening moment */
+        bool        with_holes;
+        bool        started;
+} dap_mdbx_cursor_t;
+
 /*
  * MDBX record structure
  */
@@ -83,8 +93,17 @@ struct DAP_ALIGN_PACKED driver_record {                                     /* T
     byte_t          key_n_value_n_sign[];                                   /* Serialized form */
 };
 
-static dap_db_ctx_t *s_db_ctxs = NULL;                                      /* A hash table of <group/subDB/table> == <MDBX DB context> */
-static pthread_rwlock_t s_db_ctxs_rwlock = PTHREAD_RWLOCK_INITIALIZER;      /* A read-write lock for working with a <s_db_ctxs>. */
+/*
+ * A hash table of <group/subDB/table> == <MDBX DB context>. It's an open addressing table:
+ * slots are published with release semantic and never cleared until deinit, dropped groups are only marked,
+ * so readers look up contexts without any lock. A slot of the dropped group is reused for a new group,
+ * the replaced context is retired to <s_db_ctxs_retired> and freed on deinit, since readers may still hold it.
+ * Writers are serialized by <s_db_ctxs_mutex>, which is always taken inside of the MDBX write transaction.
+ */
+#define DAP_MDBX_CTXS_TABLE_SIZE    (DAP_GLOBAL_DB_GROUPS_COUNT_MAX * 2)    /* Power of 2, keep load factor below 0.5 */
+static _Atomic(dap_db_ctx_t *) s_db_ctxs[DAP_MDBX_CTXS_TABLE_SIZE];
+static pthread_mutex_t s_db_ctxs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static dap_list_t *s_db_ctxs_retired = NULL;                                /* Replaced contexts of the dropped groups */
 
 static char s_db_path[MAX_PATH];                                            /* A root directory for the MDBX files */
 
@@ -109,6 +128,11 @@ static inline dap_store_obj_t *s_db_mdbx_read_cond_store_obj(const char *a_group
 }
 static size_t           s_db_mdbx_read_count_store(const char *a_group, dap_global_db_driver_hash_t a_hash_from, bool a_with_holes);
 static dap_list_t       *s_db_mdbx_get_groups_by_mask(const char *a_group_mask);
+static int              s_db_mdbx_erase_range(const char *a_group, dap_global_db_driver_hash_t *a_hash_from, dap_global_db_driver_hash_t a_hash_to,
+                                              bool a_holes_only, size_t *a_count);
+static void             *s_db_mdbx_cursor_open(const char *a_group, bool a_with_holes);
+static dap_store_obj_t  *s_db_mdbx_cursor_next(void *a_cursor, size_t *a_count);
+static void             s_db_mdbx_cursor_close(void *a_cursor);
 static int              s_db_mdbx_txn_start();
 static int              s_db_mdbx_txn_end(bool a_commit);
 
@@ -120,6 +144,25 @@ static char s_db_master_tbl [] = "MDBX$MASTER";                             /* A
                                                                               to keep and maintains application level information */
 static MDBX_dbi s_db_master_dbi;                                            /* A handle of the MDBX' DBI of the master subDB */
 static _Thread_local MDBX_txn *s_txn = NULL;
+static _Thread_local dap_list_t *s_txn_ctxs = NULL;                         /* Contexts created or revived by the uncommitted write transaction */
+
+/*
+ * A per-thread read-only transaction. It's reset after every read and renewed by the next one,
+ * so a batch of reads doesn't allocate and bind a reader slot each time.
+ * Parked transactions of all threads are listed in <s_txn_rd_list>, deinit aborts them.
+ * <s_env_generation> invalidates cursors of the closed environment.
+ */
+typedef struct dap_db_txn_rd {
+    MDBX_txn *txn;                                                          /* NULL if there is no parked one */
+    struct dap_db_txn_rd *prev, *next;
+} dap_db_txn_rd_t;
+
+static _Thread_local dap_db_txn_rd_t *s_txn_rd = NULL;
+static dap_db_txn_rd_t *s_txn_rd_list = NULL;
+static pthread_mutex_t s_txn_rd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint s_env_generation = 1;
+static pthread_key_t s_txn_rd_key;
+static pthread_once_t s_txn_rd_key_once = PTHREAD_ONCE_INIT;
 
 /*
  *   DESCRIPTION: A kind of replacement of the C RTL assert()
@@ -190,14 +233,50 @@ char    l_buf[1024] = {0};
 }
 #endif     /* DAP_SYS_DEBUG */
 
+/*
+ *   DESCRIPTION: Look up a slot of the DB contexts hash table for the given group name.
+ *      Linear probing is used, slots are never cleared, so a probe sequence is stopped at the first empty slot.
+ *
+ *   INPUTS:
+ *      a_group:    A group name, ASCIZ
+ *      a_name_len: A length of the group name
+ *
+ *   OUTPUTS:
+ *      a_dropped:  The first slot of the probe sequence with a dropped context of other group, may be NULL
+ *
+ *   RETURNS:
+ *      An address of the slot with the DB context of the group or of the empty slot to put it
+ *      NULL in case of the table is full
+ */
+static _Atomic(dap_db_ctx_t *) *s_db_ctx_slot(const char *a_group, size_t a_name_len, _Atomic(dap_db_ctx_t *) **a_dropped)
+{
+unsigned l_hashv;
+
+    HASH_VALUE(a_group, a_name_len, l_hashv);
+    if (a_dropped)
+        *a_dropped = NULL;
+    for (size_t i = 0; i < DAP_MDBX_CTXS_TABLE_SIZE; i++) {
+        _Atomic(dap_db_ctx_t *) *l_slot = s_db_ctxs + ((l_hashv + i) & (DAP_MDBX_CTXS_TABLE_SIZE - 1));
+        dap_db_ctx_t *l_db_ctx = atomic_load_explicit(l_slot, memory_order_acquire);
+        if ( !l_db_ctx || (l_db_ctx->namelen == a_name_len && !memcmp(l_db_ctx->name, a_group, a_name_len)) )
+            return l_slot;
+        if ( a_dropped && !*a_dropped && atomic_load(&l_db_ctx->dropped) )
+            *a_dropped = l_slot;
+    }
+    return a_dropped ? *a_dropped : NULL;
+}
+
 /*
  *   DESCRIPTION: Open or create (if a_flag=MDBX_CREATE) a DB context for a given group.
  *      Initialize an MDBX's internal context for the subDB (== a_group);
  *      Add new group/table name into the special MDBX subDB named MDBX$MASTER.
+ *      A context of the dropped group is revived instead of creation of the new one,
+ *      a new context takes a slot of other dropped group if there is one on its probe sequence.
  *
  *   INPUTS:
  *      a_group:    A group name (in terms of MDBX it's subDB), ASCIZ
  *      a_flag:     A flag
+ *      a_txn:      An MDBX write transaction, new one is started if NULL
  *
  *   IMPLICITE OUTPUTS:
  *
@@ -217,38 +296,56 @@ int rc;
 dap_db_ctx_t *l_db_ctx = NULL;
 size_t l_name_len;
 MDBX_val    l_key_iov, l_data_iov;
+_Atomic(dap_db_ctx_t *) *l_slot, *l_dropped_slot;
+MDBX_dbi l_dbi;
+bool l_new = false;
 
     debug_if(g_dap_global_db_debug_more, L_DEBUG, "Init group/table '%s', flags: %#x ...", a_group, a_flags);
 
-    HASH_FIND_STR(s_db_ctxs, a_group, l_db_ctx);                            /* Is there exist context for the group ? */
-
-    if ( l_db_ctx ) {                                                       /* Found! Good job - return DB context */
-        return  log_it(L_INFO, "Found DB context: %p for group: '%s'", l_db_ctx, a_group), l_db_ctx;
-    }
-
-    /* So , at this point we are going to create (if not exist)  'table' for new group */
-
-    if ( (l_name_len = strlen(a_group)) >(int) DAP_GLOBAL_DB_GROUP_NAME_SIZE_MAX ) {              /* Check length of the group name */
+    if ( (l_name_len = strlen(a_group)) > DAP_GLOBAL_DB_GROUP_NAME_SIZE_MAX ) {  /* Check length of the group name */
         return  log_it(L_ERROR, "Group name '%s' is too long (%zu>%lu)", a_group, l_name_len, DAP_GLOBAL_DB_GROUP_NAME_SIZE_MAX), NULL;
     }
-    if ( !(l_db_ctx = DAP_NEW_Z(dap_db_ctx_t)) ) {                            /* Allocate zeroed memory for new DB context */
-        return  log_it(L_ERROR, "Cannot allocate DB context for '%s', errno=%d", a_group, errno), NULL;
-    }
-
-    memcpy(l_db_ctx->name, a_group, l_db_ctx->namelen = l_name_len);             /* Store group name in the DB context */
     /*
-    ** Start transaction, create table, commit.
+    ** Start transaction before the lock to keep the same locks order as the table dropping
     */
     MDBX_txn *l_txn = a_txn;
-    if (!a_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, 0, &l_txn)) ) {
-        DAP_DEL_Z(l_db_ctx);
+    if (!a_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, 0, &l_txn)) )
         return  log_it(L_CRITICAL, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), NULL;
+
+    dap_assert ( !pthread_mutex_lock(&s_db_ctxs_mutex) );
+    if ( !(l_slot = s_db_ctx_slot(a_group, l_name_len, &l_dropped_slot)) ) {
+        log_it(L_ERROR, "No free room to keep DB context for '%s', %lu groups max", a_group, DAP_GLOBAL_DB_GROUPS_COUNT_MAX);
+        goto err;
+    }
+    l_db_ctx = atomic_load_explicit(l_slot, memory_order_relaxed);           /* Is there exist context for the group ? */
+    if ( l_db_ctx && l_slot == l_dropped_slot )                             /* No room but the slot of other dropped group */
+        l_db_ctx = NULL;
+    else if ( !l_db_ctx && l_dropped_slot )                                 /* Reuse the slot of dropped group */
+        l_slot = l_dropped_slot;
+    if ( l_db_ctx && !atomic_load(&l_db_ctx->dropped) ) {                   /* Found! Good job - return DB context */
+        pthread_mutex_unlock(&s_db_ctxs_mutex);
+        if (!a_txn)
+            mdbx_txn_abort(l_txn);
+        return  log_it(L_INFO, "Found DB context: %p for group: '%s'", l_db_ctx, a_group), l_db_ctx;
     }
 
-    if  ( MDBX_SUCCESS != (rc = mdbx_dbi_open(l_txn, a_group, a_flags, &l_db_ctx->dbi)) ) {
-        DAP_DEL_Z(l_db_ctx);
-        return  log_it(L_CRITICAL, "mdbx_dbi_open: (%d) %s", rc, mdbx_strerror(rc)), NULL;
+    /* So , at this point we are going to create (if not exist)  'table' for new group */
+    if ( (l_new = !l_db_ctx) ) {
+        if ( !(l_db_ctx = DAP_NEW_Z(dap_db_ctx_t)) ) {                        /* Allocate zeroed memory for new DB context */
+            log_it(L_ERROR, "Cannot allocate DB context for '%s', errno=%d", a_group, errno);
+            goto err;
+        }
+        memcpy(l_db_ctx->name, a_group, l_db_ctx->namelen = l_name_len);     /* Store group name in the DB context */
+    }
+    /*
+    ** A handle of the revived context is reopened too: it may be opened by an aborted transaction,
+    ** MDBX returns the same handle for the alive one
+    */
+    if  ( MDBX_SUCCESS != (rc = mdbx_dbi_open(l_txn, a_group, a_flags, &l_dbi)) ) {
+        log_it(L_CRITICAL, "mdbx_dbi_open: (%d) %s", rc, mdbx_strerror(rc));
+        goto err;
     }
+    atomic_store_explicit(&l_db_ctx->dbi, l_dbi, memory_order_release);    /* Readers of the revived context may load it */
 
     /*
      * Save new subDB name into the master table
@@ -259,21 +356,156 @@ MDBX_val    l_key_iov, l_data_iov;
     if (MDBX_SUCCESS != (rc = mdbx_put(l_txn, s_db_master_dbi, &l_key_iov, &l_data_iov, MDBX_NOOVERWRITE))
          && (rc != MDBX_KEYEXIST)) {
         log_it (L_ERROR, "mdbx_put: (%d) %s", rc, mdbx_strerror(rc));
-        if (!a_txn && MDBX_SUCCESS != (rc = mdbx_txn_abort(l_txn)) ) {
-            return  log_it(L_CRITICAL, "mdbx_txn_abort: (%d) %s", rc, mdbx_strerror(rc)), NULL;
-        }
+        goto err;
     }
 
     if (!a_txn && MDBX_SUCCESS != (rc = mdbx_txn_commit(l_txn)) ) {
-        return  log_it(L_CRITICAL, "mdbx_txn_commit: (%d) %s", rc, mdbx_strerror(rc)), NULL;
+        l_txn = NULL;                                                       /* Transaction is freed even on error */
+        log_it(L_CRITICAL, "mdbx_txn_commit: (%d) %s", rc, mdbx_strerror(rc));
+        goto err;
     }
 
     /*
-    ** Add new DB Context for the group into the hash for quick access
+    ** Publish new DB Context for the group into the hash for quick access
     */
-    HASH_ADD_STR(s_db_ctxs, name, l_db_ctx);
-
+    if (l_new) {
+        dap_db_ctx_t *l_replaced = atomic_exchange_explicit(l_slot, l_db_ctx, memory_order_acq_rel);
+        if (l_replaced)
+            s_db_ctxs_retired = dap_list_prepend(s_db_ctxs_retired, l_replaced);
+    } else
+        atomic_store(&l_db_ctx->dropped, false);
+    if (a_txn)                                                              /* Rolled back by s_txn_ctxs_finish() if the caller aborts */
+        s_txn_ctxs = dap_list_prepend(s_txn_ctxs, l_db_ctx);
+    pthread_mutex_unlock(&s_db_ctxs_mutex);
     return l_db_ctx;
+
+err:
+    if (l_new)
+        DAP_DELETE(l_db_ctx);
+    pthread_mutex_unlock(&s_db_ctxs_mutex);
+    if (!a_txn && l_txn && MDBX_SUCCESS != (rc = mdbx_txn_abort(l_txn)) )
+        log_it(L_CRITICAL, "mdbx_txn_abort: (%d) %s", rc, mdbx_strerror(rc));
+    return NULL;
+}
+
+/*
+ *   DESCRIPTION: Finish DB contexts created or revived within the caller's write transaction.
+ *      Contexts of the aborted transaction are marked as dropped: their tables don't exist anymore,
+ *      and the next writer revives them with a new table handle.
+ *
+ *   INPUTS:
+ *      a_committed:    The transaction has been committed
+ *
+ *   IMPLICITE OUTPUTS:
+ *      s_txn_ctxs:     Cleared
+ *
+ *   RETURNS:
+ *      NONE
+ */
+static void s_txn_ctxs_finish(bool a_committed)
+{
+    if (!s_txn_ctxs)
+        return;
+    if (!a_committed) {
+        dap_assert ( !pthread_mutex_lock(&s_db_ctxs_mutex) );
+        for (dap_list_t *l_item = s_txn_ctxs; l_item; l_item = l_item->next)
+            atomic_store(&((dap_db_ctx_t *)l_item->data)->dropped, true);
+        pthread_mutex_unlock(&s_db_ctxs_mutex);
+    }
+    dap_list_free(s_txn_ctxs);
+    s_txn_ctxs = NULL;
+}
+
+static void s_txn_rd_key_destructor(void *a_txn_rd)
+{
+    dap_db_txn_rd_t *l_txn_rd = a_txn_rd;
+    dap_assert ( !pthread_mutex_lock(&s_txn_rd_mutex) );
+    DL_DELETE(s_txn_rd_list, l_txn_rd);
+    if (l_txn_rd->txn)
+        mdbx_txn_abort(l_txn_rd->txn);
+    pthread_mutex_unlock(&s_txn_rd_mutex);
+    DAP_DELETE(l_txn_rd);
+    s_txn_rd = NULL;
+}
+
+static void s_txn_rd_key_create(void)
+{
+    pthread_key_create(&s_txn_rd_key, s_txn_rd_key_destructor);
+}
+
+/*
+ *  DESCRIPTION: Set the parked transaction of the caller thread
+ *
+ *  INPUTS:
+ *      a_txn:  A transaction or NULL
+ *
+ *  RETURNS:
+ *      0 or -1 if there is no memory to register the thread
+ */
+static int s_txn_rd_park(MDBX_txn *a_txn)
+{
+    bool l_new = !s_txn_rd;
+    if (l_new) {
+        if ( !(s_txn_rd = DAP_NEW_Z(dap_db_txn_rd_t)) )
+            return log_it(L_CRITICAL, "%s", c_error_memory_alloc), -1;
+        pthread_once(&s_txn_rd_key_once, s_txn_rd_key_create);
+        pthread_setspecific(s_txn_rd_key, s_txn_rd);                       /* Release it on the thread exit */
+    }
+    dap_assert ( !pthread_mutex_lock(&s_txn_rd_mutex) );
+    if (l_new)
+        DL_APPEND(s_txn_rd_list, s_txn_rd);
+    s_txn_rd->txn = a_txn;
+    pthread_mutex_unlock(&s_txn_rd_mutex);
+    return 0;
+}
+
+/*
+ *  DESCRIPTION: Begin a read-only transaction for the caller thread or renew its parked one.
+ *      The static write transaction is returned as is if it's started.
+ *
+ *  OUTPUTS:
+ *      a_txn:  A transaction to be passed into the s_txn_rd_end() after reading
+ *
+ *  RETURNS:
+ *      MDBX_SUCCESS or MDBX error code
+ */
+static int s_txn_rd_begin(MDBX_txn **a_txn)
+{
+int rc;
+
+    if (s_txn)
+        return *a_txn = s_txn, MDBX_SUCCESS;
+    if (s_txn_rd && s_txn_rd->txn) {                                        /* Deinit aborts it and clears the field */
+        if ( MDBX_SUCCESS == (rc = mdbx_txn_renew(s_txn_rd->txn)) )
+            return *a_txn = s_txn_rd->txn, MDBX_SUCCESS;
+        log_it(L_WARNING, "mdbx_txn_renew: (%d) %s", rc, mdbx_strerror(rc));
+        mdbx_txn_abort(s_txn_rd->txn);
+        s_txn_rd_park(NULL);
+    }
+    if ( MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, a_txn)) )
+        return log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), rc;
+    if ( s_txn_rd_park(*a_txn) )
+        return mdbx_txn_abort(*a_txn), MDBX_ENOMEM;
+    return MDBX_SUCCESS;
+}
+
+/*
+ *  DESCRIPTION: Finish reading with the transaction started by s_txn_rd_begin(), it's parked for the next read
+ *
+ *  INPUTS:
+ *      a_txn:  A transaction
+ */
+static void s_txn_rd_end(MDBX_txn *a_txn)
+{
+int rc;
+
+    if (!a_txn || a_txn == s_txn)
+        return;
+    if ( MDBX_SUCCESS != (rc = mdbx_txn_reset(a_txn)) ) {
+        log_it(L_ERROR, "mdbx_txn_reset: (%d) %s", rc, mdbx_strerror(rc));
+        mdbx_txn_abort(a_txn);
+        s_txn_rd_park(NULL);
+    }
 }
 
 /*
@@ -293,19 +525,31 @@ MDBX_val    l_key_iov, l_data_iov;
 
 static  int s_db_mdbx_deinit(void)
 {
-    dap_db_ctx_t *l_db_ctx = NULL, *l_tmp;
-
-    dap_assert ( !pthread_rwlock_wrlock(&s_db_ctxs_rwlock) );               /* Prelock for WR */
-    HASH_ITER(hh, s_db_ctxs, l_db_ctx, l_tmp) {                             /* run over the hash table of the DB contexts */
+    dap_assert ( !pthread_mutex_lock(&s_db_ctxs_mutex) );
+    dap_db_txn_rd_t *l_txn_rd;
+    dap_assert ( !pthread_mutex_lock(&s_txn_rd_mutex) );
+    DL_FOREACH(s_txn_rd_list, l_txn_rd) {                                   /* Parked read transactions of all threads */
+        if (l_txn_rd->txn)
+            mdbx_txn_abort(l_txn_rd->txn);                                  /* The env is opened with MDBX_NOTLS, any thread may do it */
+        l_txn_rd->txn = NULL;
+    }
+    pthread_mutex_unlock(&s_txn_rd_mutex);
+    atomic_fetch_add(&s_env_generation, 1);                                 /* Cursors of the closed env are stale now */
+    for (size_t i = 0; i < DAP_MDBX_CTXS_TABLE_SIZE; i++) {                  /* run over the hash table of the DB contexts */
+        dap_db_ctx_t *l_db_ctx = atomic_exchange(s_db_ctxs + i, NULL);      /* Delete DB context from the hash-table */
+        if (!l_db_ctx)
+            continue;
         if (l_db_ctx->dbi)
             mdbx_dbi_close(s_mdbx_env, l_db_ctx->dbi);
-        HASH_DEL(s_db_ctxs, l_db_ctx);                                      /* Delete DB context from the hash-table */
         DAP_DELETE(l_db_ctx);                                               /* Release memory of DB context area */
     }
+    dap_list_free_full(s_db_ctxs_retired, NULL);                            /* Handles are closed by the env */
+    s_db_ctxs_retired = NULL;
     if (s_mdbx_env)
         mdbx_env_close(s_mdbx_env);                                         /* Finaly close MDBX DB */
+    s_mdbx_env = NULL;
 
-    dap_assert ( !pthread_rwlock_unlock(&s_db_ctxs_rwlock) );
+    dap_assert ( !pthread_mutex_unlock(&s_db_ctxs_mutex) );
 
     return 0;
 }
@@ -367,7 +611,9 @@ size_t     l_upper_limit_of_db_size = 16;
     if ( MDBX_SUCCESS != (rc = mdbx_env_set_geometry(s_mdbx_env, -1, -1, l_upper_limit_of_db_size, -1, -1, -1)) )
         return  log_it (L_CRITICAL, "mdbx_env_set_geometry (%s): (%d) %s", s_db_path, rc, mdbx_strerror(rc)),  -EINVAL;
 
-    if ( MDBX_SUCCESS != (rc = mdbx_env_open(s_mdbx_env, s_db_path, MDBX_CREATE |  MDBX_COALESCE | MDBX_LIFORECLAIM, 0664)) )
+                                                                            /* Read transactions aren't bound to threads, so cursors
+                                                                              may be kept open aside of other reads and writes */
+    if ( MDBX_SUCCESS != (rc = mdbx_env_open(s_mdbx_env, s_db_path, MDBX_CREATE |  MDBX_COALESCE | MDBX_LIFORECLAIM | MDBX_NOTLS, 0664)) )
         return  log_it (L_CRITICAL, "mdbx_env_open (%s): (%d) %s", s_db_path, rc, mdbx_strerror(rc)),  -EINVAL;
 
     /*
@@ -435,6 +681,10 @@ size_t     l_upper_limit_of_db_size = 16;
     a_drv_dpt->get_groups_by_mask          = s_db_mdbx_get_groups_by_mask;
     a_drv_dpt->is_obj                      = s_db_mdbx_is_obj;
     a_drv_dpt->is_hash                     = s_db_mdbx_is_hash;
+    a_drv_dpt->erase_range                 = s_db_mdbx_erase_range;
+    a_drv_dpt->cursor_open                 = s_db_mdbx_cursor_open;
+    a_drv_dpt->cursor_next                 = s_db_mdbx_cursor_next;
+    a_drv_dpt->cursor_close                = s_db_mdbx_cursor_close;
     a_drv_dpt->deinit                      = s_db_mdbx_deinit;
     a_drv_dpt->flush                       = s_db_mdbx_flush;
     a_drv_dpt->transaction_start           = s_db_mdbx_txn_start;
@@ -447,13 +697,17 @@ size_t     l_upper_limit_of_db_size = 16;
     a_drv_dpt->transaction_start   = NULL;
     a_drv_dpt->transaction_end     = NULL;
 
+    /* Write batches are all-or-nothing, so they need the transaction anyway */
+    a_drv_dpt->batch_start         = s_db_mdbx_txn_start;
+    a_drv_dpt->batch_end           = s_db_mdbx_txn_end;
+
     return MDBX_SUCCESS;
 }
 
 /*
  *  DESCRIPTION: Get a DB context for the specified group/table name
  *      from the DB context hash table. This context is just pointer to the DB Context
- *      structure, so don't modify it.
+ *      structure, so don't modify it. No lock is needed, contexts are never freed before deinit.
  *
  *  INPUTS:
  *      a_group:    Group/table name to be looked for DB context
@@ -468,10 +722,11 @@ size_t     l_upper_limit_of_db_size = 16;
  */
 static  dap_db_ctx_t  *s_get_db_ctx_for_group(const char *a_group)
 {
-dap_db_ctx_t *l_db_ctx = NULL;
-
-    HASH_FIND_STR(s_db_ctxs, a_group, l_db_ctx);
+_Atomic(dap_db_ctx_t *) *l_slot = s_db_ctx_slot(a_group, strlen(a_group), NULL);
+dap_db_ctx_t *l_db_ctx = l_slot ? atomic_load_explicit(l_slot, memory_order_acquire) : NULL;
 
+    if ( l_db_ctx && atomic_load(&l_db_ctx->dropped) )
+        l_db_ctx = NULL;
     if ( !l_db_ctx )
         debug_if(g_dap_global_db_debug_more, L_DEBUG, "No DB context for the group '%s'", a_group);
 
@@ -624,17 +879,12 @@ dap_store_obj_t *l_obj = NULL;
      /* Sanity check for group/table */
     dap_return_val_if_fail(a_group, NULL);
 
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
-    if ( !(l_db_ctx = s_get_db_ctx_for_group(a_group)) ) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    if ( !(l_db_ctx = s_get_db_ctx_for_group(a_group)) )
         return NULL;
-    }
 
-    MDBX_txn *l_txn = s_txn;
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn)) ) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        return log_it (L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), NULL;
-    }
+    MDBX_txn *l_txn = NULL;
+    if ( MDBX_SUCCESS != s_txn_rd_begin(&l_txn) )
+        return NULL;
 
     if ( MDBX_SUCCESS != (rc = mdbx_cursor_open(l_txn, l_db_ctx->dbi, &l_cursor)) ) {
         log_it(L_ERROR, "mdbx_cursor_open: (%d) %s", rc, mdbx_strerror(rc));
@@ -669,10 +919,7 @@ ret:
 
     if (l_cursor)                                                           // Release uncesessary MDBX cursor area
         mdbx_cursor_close(l_cursor);
-    if (!s_txn)
-        mdbx_txn_commit(l_txn);
-
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    s_txn_rd_end(l_txn);
     return l_obj;
 }
 
@@ -698,74 +945,55 @@ static dap_store_obj_t *s_db_mdbx_read_store_obj_below_timestamp(const char *a_g
  */
 bool s_db_mdbx_is_obj(const char *a_group, const char *a_key)
 {
-int rc, rc2;
+int rc;
 dap_db_ctx_t *l_db_ctx;
 MDBX_val l_key, l_data;
 
     dap_return_val_if_fail(a_group && a_key, NULL);                         /* Sanity check */
 
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
-    if ( !(l_db_ctx = s_get_db_ctx_for_group(a_group)) ) {                  /* Get DB Context for group/table */
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    if ( !(l_db_ctx = s_get_db_ctx_for_group(a_group)) )                    /* Get DB Context for group/table */
         return 0;
-    }
 
-    MDBX_txn *l_txn = s_txn;
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn)) ) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        return log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), false;
-    }
+    MDBX_txn *l_txn = NULL;
+    if ( MDBX_SUCCESS != s_txn_rd_begin(&l_txn) )
+        return false;
 
     rc = s_get_obj_by_text_key(l_txn, l_db_ctx->dbi, &l_key, &l_data, a_key);
 
-    if (!s_txn && MDBX_SUCCESS != (rc2 = mdbx_txn_commit(l_txn)) )
-        log_it (L_ERROR, "mdbx_txn_commit: (%d) %s", rc2, mdbx_strerror(rc2));
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    s_txn_rd_end(l_txn);
     return ( rc == MDBX_SUCCESS );    /*0 - RNF, 1 - SUCCESS */
 }
 
 static bool s_db_mdbx_is_hash(const char *a_group, dap_global_db_driver_hash_t a_hash)
 {
     dap_return_val_if_fail(a_group, NULL); /* Sanity check */
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
     dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_group);
-    if (!l_db_ctx) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    if (!l_db_ctx)
         return false;
-    }
     int rc;
-    MDBX_txn *l_txn = s_txn ? s_txn : NULL;
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn)) ) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        return log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), NULL;
-    }
+    MDBX_txn *l_txn = NULL;
+    if ( MDBX_SUCCESS != s_txn_rd_begin(&l_txn) )
+        return false;
     MDBX_val l_key, l_data;
     l_key.iov_base = &a_hash;                                    /* Fill IOV for MDBX key */
     l_key.iov_len =  sizeof(a_hash);
     rc = mdbx_get(l_txn, l_db_ctx->dbi, &l_key, &l_data);
     if (rc != MDBX_NOTFOUND && rc != MDBX_SUCCESS)
         log_it (L_ERROR, "mdbx_get: (%d) %s", rc, mdbx_strerror(rc));
-    if (!s_txn)
-        mdbx_txn_commit(l_txn);
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    s_txn_rd_end(l_txn);
     return rc == MDBX_SUCCESS;
 }
 
 static dap_global_db_pkt_pack_t *s_db_mdbx_get_by_hash(const char *a_group, dap_global_db_driver_hash_t *a_hashes, size_t a_count)
 {
     dap_return_val_if_fail(a_group && a_count, NULL); /* Sanity check */
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
     dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_group);
-    if (!l_db_ctx) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        return false;
-    }
+    if (!l_db_ctx)
+        return NULL;
     int rc;
-    MDBX_txn *l_txn = s_txn;
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn)) ) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        return log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), NULL;
-    }
+    MDBX_txn *l_txn = NULL;
+    if ( MDBX_SUCCESS != s_txn_rd_begin(&l_txn) )
+        return NULL;
     MDBX_val l_key, l_data;
     dap_global_db_pkt_pack_t *l_ret = NULL;
     for (size_t i = 0; i < a_count; i++) {
@@ -838,9 +1066,7 @@ static dap_global_db_pkt_pack_t *s_db_mdbx_get_by_hash(const char *a_group, dap_
             l_ret->obj_count++;
         }
     }
-    if (!s_txn)
-        mdbx_txn_commit(l_txn);
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    s_txn_rd_end(l_txn);
     return l_ret;
 }
 
@@ -855,12 +1081,9 @@ static void *s_db_mdbx_read_cond(const char *a_group, dap_global_db_driver_hash_
 {
     dap_return_val_if_fail(a_group && *a_group, NULL);  /* Sanity check */
 
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
     dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_group);
-    if (!l_db_ctx) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    if (!l_db_ctx)
         return NULL;
-    }
     size_t l_element_size = a_keys_only_read ? sizeof(dap_global_db_driver_hash_t) : sizeof(dap_store_obj_t);
     size_t l_count_current = 0,
            l_count_out = a_count_out ? *a_count_out : 0;
@@ -868,12 +1091,10 @@ static void *s_db_mdbx_read_cond(const char *a_group, dap_global_db_driver_hash_
         l_count_out = a_keys_only_read ? DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT;
     byte_t *l_obj_arr = NULL;
     int rc = 0;
-    MDBX_txn *l_txn = s_txn;
+    MDBX_txn *l_txn = NULL;
     MDBX_cursor *l_cursor = NULL;
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn))) {
-        log_it (L_ERROR, "mdbx_txn: (%d) %s", rc, mdbx_strerror(rc));
+    if ( MDBX_SUCCESS != (rc = s_txn_rd_begin(&l_txn)) )
         goto safe_ret;
-    }
     if ( MDBX_SUCCESS != (rc = mdbx_cursor_open(l_txn, l_db_ctx->dbi, &l_cursor)) ) {
         log_it(L_ERROR, "mdbx_cursor_open: (%d) %s", rc, mdbx_strerror(rc));
         goto safe_ret;
@@ -947,13 +1168,11 @@ static void *s_db_mdbx_read_cond(const char *a_group, dap_global_db_driver_hash_
 safe_ret:
     if (l_cursor)
         mdbx_cursor_close(l_cursor);
-    if (l_txn)
-        mdbx_txn_commit(l_txn);
+    s_txn_rd_end(l_txn);
     if (a_count_out)
         *a_count_out = l_count_current;
     if (a_keys_only_read && l_obj_arr)
         ((dap_global_db_hash_pkt_t *)l_obj_arr)->hashes_count = l_count_current;
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
     return l_obj_arr;
 }
 
@@ -966,19 +1185,13 @@ static size_t s_db_mdbx_read_count_store(const char *a_group, dap_global_db_driv
 {
     dap_return_val_if_fail(a_group, 0);                                       /* Sanity check */
 
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
     dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_group);
-    if (!l_db_ctx) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    if (!l_db_ctx)
         return 0;
-    }
     int rc = 0;
-    MDBX_txn *l_txn = s_txn;
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn))) {
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        log_it(L_ERROR, "mdbx_txn: (%d) %s", rc, mdbx_strerror(rc));
+    MDBX_txn *l_txn = NULL;
+    if ( MDBX_SUCCESS != s_txn_rd_begin(&l_txn) )
         return 0;
-    }
     // Return all entries count
     if (dap_global_db_driver_hash_is_blank(&a_hash_from) && a_with_holes) {
         MDBX_stat l_stat;
@@ -987,27 +1200,21 @@ static size_t s_db_mdbx_read_count_store(const char *a_group, dap_global_db_driv
             log_it(L_ERROR, "mdbx_dbi_stat: (%d) %s", rc, mdbx_strerror(rc));
         else if (!l_stat.ms_entries)                                    /* Nothing to retrieve , table contains no record */
             debug_if(g_dap_global_db_debug_more, L_NOTICE, "No object (-s) to be retrieved from the group '%s'", a_group);
-        if (!s_txn)
-            mdbx_txn_commit(l_txn);
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        s_txn_rd_end(l_txn);
         return rc == MDBX_SUCCESS ? l_stat.ms_entries : 0;
     }
     // Return count of entries after specified position by driver hash
     MDBX_cursor *l_cursor = NULL;
     if ( MDBX_SUCCESS != (rc = mdbx_cursor_open(l_txn, l_db_ctx->dbi, &l_cursor)) ) {
         log_it(L_ERROR, "mdbx_cursor_open: (%d) %s", rc, mdbx_strerror(rc));
-        if (!s_txn)
-            mdbx_txn_commit(l_txn);
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        s_txn_rd_end(l_txn);
         return 0;
     }
     MDBX_val l_key = { .iov_base = &a_hash_from, .iov_len = sizeof(a_hash_from) },
              l_data = {};
     if ( MDBX_SUCCESS != (rc = mdbx_cursor_get(l_cursor, &l_key, &l_data, MDBX_SET_UPPERBOUND))) {
         mdbx_cursor_close(l_cursor);
-        if (!s_txn)
-            mdbx_txn_commit(l_txn);
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        s_txn_rd_end(l_txn);
         if (rc != MDBX_NOTFOUND)
             log_it(L_ERROR, "mdbx_cursor_get: (%d) %s", rc, mdbx_strerror(rc));
         return 0;
@@ -1017,13 +1224,200 @@ static size_t s_db_mdbx_read_count_store(const char *a_group, dap_global_db_driv
         if(a_with_holes || !s_is_hole(l_data.iov_base))
             l_ret_count++;
     mdbx_cursor_close(l_cursor);
-    if (!s_txn)
-        mdbx_txn_commit(l_txn);
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+    s_txn_rd_end(l_txn);
 
     return l_ret_count;
 }
 
+/*
+ *  DESCRIPTION: Action routine - erase records of the group in the range of driver keys (a_hash_from, a_hash_to)
+ *      with a single write transaction. Only record headers are looked at to skip pinned records (and actual ones
+ *      if a_holes_only), values are not copied.
+ *
+ *  INPUTS:
+ *      a_group:        A group/table name
+ *      a_hash_from:    A driver key to start after
+ *      a_hash_to:      A driver key to stop before
+ *      a_holes_only:   Erase only records marked as deleted
+ *      a_count:        A maximum number of records to be examined
+ *
+ *  OUTPUTS:
+ *      a_hash_from:    A last examined driver key
+ *      a_count:        A number of erased records
+ *
+ *  RETURNS:
+ *      DAP_GLOBAL_DB_RC_SUCCESS    - range is finished
+ *      DAP_GLOBAL_DB_RC_PROGRESS   - limit of examined records is reached
+ *      DAP_GLOBAL_DB_RC_ERROR
+ */
+static int s_db_mdbx_erase_range(const char *a_group, dap_global_db_driver_hash_t *a_hash_from, dap_global_db_driver_hash_t a_hash_to,
+                                 bool a_holes_only, size_t *a_count)
+{
+int rc, rc2, l_ret = DAP_GLOBAL_DB_RC_SUCCESS;
+size_t l_limit = *a_count ? *a_count : DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT, l_erased = 0;
+MDBX_txn *l_txn = s_txn;
+MDBX_cursor *l_cursor = NULL;
+
+    dap_return_val_if_fail(a_group && a_hash_from, DAP_GLOBAL_DB_RC_ERROR);       /* Sanity check */
+    *a_count = 0;
+
+    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_READWRITE, &l_txn)) )
+        return log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), DAP_GLOBAL_DB_RC_ERROR;
+    dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_group);                  /* Look up under the write txn, see table dropping */
+    if (!l_db_ctx)
+        goto safe_ret;
+    if ( MDBX_SUCCESS != (rc = mdbx_cursor_open(l_txn, l_db_ctx->dbi, &l_cursor)) ) {
+        log_it(L_ERROR, "mdbx_cursor_open: (%d) %s", rc, mdbx_strerror(rc));
+        l_ret = DAP_GLOBAL_DB_RC_ERROR;
+        goto safe_ret;
+    }
+    MDBX_val l_key = { .iov_base = a_hash_from, .iov_len = sizeof(*a_hash_from) }, l_data = {};
+    for ( rc = mdbx_cursor_get(l_cursor, &l_key, &l_data, MDBX_SET_UPPERBOUND); rc == MDBX_SUCCESS;
+          rc = mdbx_cursor_get(l_cursor, &l_key, &l_data, MDBX_NEXT) ) {
+        if ( l_key.iov_len != sizeof(dap_global_db_driver_hash_t) || memcmp(l_key.iov_base, &a_hash_to, sizeof(a_hash_to)) >= 0 )
+            break;
+        if (!l_limit--) {
+            l_ret = DAP_GLOBAL_DB_RC_PROGRESS;
+            break;
+        }
+        *a_hash_from = *(dap_global_db_driver_hash_t *)l_key.iov_base;
+        struct driver_record *l_record = l_data.iov_base;
+        if ( l_data.iov_len < sizeof(*l_record) || (l_record->flags & DAP_GLOBAL_DB_RECORD_PINNED) || (a_holes_only && !s_is_hole(l_record)) )
+            continue;
+        if ( MDBX_SUCCESS != (rc = mdbx_cursor_del(l_cursor, 0)) )              /* Cursor is moved to the next record by MDBX_NEXT */
+            break;
+        l_erased++;
+    }
+    if (rc != MDBX_SUCCESS && rc != MDBX_NOTFOUND) {
+        log_it(L_ERROR, "mdbx_erase_range: (%d) %s", rc, mdbx_strerror(rc));
+        l_ret = DAP_GLOBAL_DB_RC_ERROR;
+    }
+
+safe_ret:
+    if (l_cursor)
+        mdbx_cursor_close(l_cursor);
+    if (!s_txn) {
+        if (l_ret == DAP_GLOBAL_DB_RC_ERROR || !l_erased)
+            rc2 = mdbx_txn_abort(l_txn);
+        else if ( MDBX_SUCCESS != (rc2 = mdbx_txn_commit(l_txn)) )
+            l_ret = DAP_GLOBAL_DB_RC_ERROR;
+        if (rc2 != MDBX_SUCCESS)
+            log_it(L_ERROR, "mdbx_txn_end: (%d) %s", rc2, mdbx_strerror(rc2));
+    }
+    if (l_ret != DAP_GLOBAL_DB_RC_ERROR)
+        *a_count = l_erased;
+    return l_ret;
+}
+
+/*
+ *  DESCRIPTION: Action routine - open an iterator over the group with a dedicated read-only transaction,
+ *      so the iteration sees a stable snapshot and doesn't block writers.
+ *
+ *  INPUTS:
+ *      a_group:        A group/table name
+ *      a_with_holes:   Iterate records marked as deleted too
+ *
+ *  RETURNS:
+ *      An iterator to be released by s_db_mdbx_cursor_close()
+ *      NULL    - group is not found or error
+ */
+static void *s_db_mdbx_cursor_open(const char *a_group, bool a_with_holes)
+{
+int rc;
+dap_mdbx_cursor_t *l_cursor;
+
+    dap_return_val_if_fail(a_group, NULL);                                  /* Sanity check */
+
+    dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_group);
+    if (!l_db_ctx)
+        return debug_if(g_dap_global_db_debug_more, L_WARNING, "No DB context for the group '%s'", a_group), NULL;
+    if ( !(l_cursor = DAP_NEW_Z(dap_mdbx_cursor_t)) )
+        return log_it(L_CRITICAL, "%s", c_error_memory_alloc), NULL;
+    l_cursor->db_ctx = l_db_ctx;
+    l_cursor->with_holes = a_with_holes;
+    l_cursor->generation = atomic_load(&s_env_generation);
+    if ( MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_cursor->txn)) ) {
+        log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc));
+        return DAP_DELETE(l_cursor), NULL;
+    }
+    if ( atomic_load(&l_db_ctx->dropped) ) {                                /* Table was dropped before the snapshot */
+        mdbx_txn_abort(l_cursor->txn);
+        return DAP_DELETE(l_cursor), NULL;
+    }
+    if ( MDBX_SUCCESS != (rc = mdbx_cursor_open(l_cursor->txn, l_db_ctx->dbi, &l_cursor->cursor)) ) {
+        log_it(L_ERROR, "mdbx_cursor_open: (%d) %s", rc, mdbx_strerror(rc));
+        mdbx_txn_abort(l_cursor->txn);
+        return DAP_DELETE(l_cursor), NULL;
+    }
+    return l_cursor;
+}
+
+/*
+ *  DESCRIPTION: Action routine - retrieve next batch of records from the iterator
+ *
+ *  INPUTS:
+ *      a_cursor:   An iterator
+ *      a_count:    A maximum number of records to be returned
+ *
+ *  OUTPUTS:
+ *      a_count:    A number of returned records
+ *
+ *  RETURNS:
+ *      An array of <store object>s
+ *      NULL    - no more records or error
+ */
+static dap_store_obj_t *s_db_mdbx_cursor_next(void *a_cursor, size_t *a_count)
+{
+int rc = MDBX_SUCCESS;
+dap_mdbx_cursor_t *l_cursor = a_cursor;
+size_t l_count_out = *a_count, l_count_current = 0;
+
+    dap_return_val_if_fail(a_cursor && l_count_out, NULL);                  /* Sanity check */
+    *a_count = 0;
+    if (l_cursor->generation != atomic_load(&s_env_generation))
+        return log_it(L_ERROR, "Cursor of the closed DB is used"), NULL;
+
+    dap_store_obj_t *l_objs = DAP_NEW_Z_COUNT(dap_store_obj_t, l_count_out);
+    if (!l_objs)
+        return log_it(L_CRITICAL, "%s", c_error_memory_alloc), NULL;
+    MDBX_val l_key, l_data;
+    while ( l_count_current < l_count_out &&
+            MDBX_SUCCESS == (rc = mdbx_cursor_get(l_cursor->cursor, &l_key, &l_data, l_cursor->started ? MDBX_NEXT : MDBX_FIRST)) ) {
+        l_cursor->started = true;
+        if (!l_cursor->with_holes && s_is_hole(l_data.iov_base))
+            continue;
+        if ( s_fill_store_obj(l_cursor->db_ctx->name, &l_key, &l_data, l_objs + l_count_current) ) {
+            rc = MDBX_PROBLEM;
+            break;
+        }
+        l_count_current++;
+    }
+    if ( (MDBX_SUCCESS != rc) && (rc != MDBX_NOTFOUND) )
+        log_it (L_ERROR, "mdbx_cursor_next: (%d) %s", rc, mdbx_strerror(rc));
+    if (!l_count_current)
+        return DAP_DELETE(l_objs), NULL;
+    *a_count = l_count_current;
+    return l_objs;
+}
+
+/*
+ *  DESCRIPTION: Action routine - release the iterator and its read transaction
+ *
+ *  INPUTS:
+ *      a_cursor:   An iterator
+ */
+static void s_db_mdbx_cursor_close(void *a_cursor)
+{
+dap_mdbx_cursor_t *l_cursor = a_cursor;
+
+    dap_return_if_fail(a_cursor);
+    if (l_cursor->generation == atomic_load(&s_env_generation)) {          /* Transaction of the closed environment is just forgotten */
+        mdbx_cursor_close(l_cursor->cursor);
+        mdbx_txn_abort(l_cursor->txn);
+    }
+    DAP_DELETE(l_cursor);
+}
+
 /*
  *  DESCRIPTION: Action routine - returns a list of group/table names in DB contexts hash table is matched
  *      to specified pattern.
@@ -1041,17 +1435,17 @@ static size_t s_db_mdbx_read_count_store(const char *a_group, dap_global_db_driv
 static dap_list_t  *s_db_mdbx_get_groups_by_mask(const char *a_group_mask)
 {
 dap_list_t *l_ret_list = NULL;
-dap_db_ctx_t *l_db_ctx, *l_db_ctx2;
+dap_db_ctx_t *l_db_ctx;
 
     dap_return_val_if_fail(a_group_mask, NULL);
 
-    dap_assert ( !pthread_rwlock_rdlock(&s_db_ctxs_rwlock) );
-
-    HASH_ITER(hh, s_db_ctxs, l_db_ctx, l_db_ctx2)
+    for (size_t i = 0; i < DAP_MDBX_CTXS_TABLE_SIZE; i++) {                  /* run over the hash table of the DB contexts */
+        if ( !(l_db_ctx = atomic_load_explicit(s_db_ctxs + i, memory_order_acquire)) || atomic_load(&l_db_ctx->dropped) )
+            continue;
         if (dap_global_db_group_match_mask(l_db_ctx->name, a_group_mask) )  /* Name match a pattern/mask ? */
             l_ret_list = dap_list_append(l_ret_list,
                                          dap_strdup(l_db_ctx->name));       /* Add group name to output list */
-    dap_assert ( !pthread_rwlock_unlock(&s_db_ctxs_rwlock) );
+    }
 
     return l_ret_list;
 }
@@ -1079,28 +1473,13 @@ static int s_db_mdbx_apply_store_obj_with_txn(dap_store_obj_t *a_store_obj, MDBX
     uint8_t l_type_erase = a_store_obj->flags & DAP_GLOBAL_DB_RECORD_ERASE;
 
     dap_db_ctx_t *l_db_ctx;
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
     if ( !(l_db_ctx = s_get_db_ctx_for_group(a_store_obj->group)) ) {               /* Get a DB context for the group */
-        if (l_type_erase) {                                                         /* Nothing to do anymore */
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        if (l_type_erase)                                                           /* Nothing to do anymore */
             return DAP_GLOBAL_DB_RC_NOT_FOUND;
-        }                                                                           /* Group is not found ? Try to create table for new group */
-        // Reacquire rwlock for write
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        pthread_rwlock_wrlock(&s_db_ctxs_rwlock);
-        // Check again if anyone change protected HT before us
-        l_db_ctx = s_get_db_ctx_for_group(a_store_obj->group);
-        if (!l_db_ctx) {
-            l_db_ctx = s_cre_db_ctx_for_group(a_store_obj->group, MDBX_CREATE, a_txn);
-            if (!l_db_ctx) {
-                pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-                return log_it(L_WARNING, "Cannot create DB context for the group '%s'", a_store_obj->group), -EIO;
-            }
-            log_it(L_NOTICE, "DB context for the group '%s' has been created", a_store_obj->group);
-        }
-        // Reacquire rwlock for read with recursive call
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-        return s_db_mdbx_apply_store_obj_with_txn(a_store_obj, a_txn);
+                                                                                    /* Group is not found ? Try to create table for new group */
+        if ( !(l_db_ctx = s_cre_db_ctx_for_group(a_store_obj->group, MDBX_CREATE, a_txn)) )
+            return log_it(L_WARNING, "Cannot create DB context for the group '%s'", a_store_obj->group), -EIO;
+        debug_if(g_dap_global_db_debug_more, L_NOTICE, "DB context for the group '%s' has been created", a_store_obj->group);
     }
     int rc = -EIO;
     MDBX_val l_key = {}, l_data;
@@ -1108,10 +1487,8 @@ static int s_db_mdbx_apply_store_obj_with_txn(dap_store_obj_t *a_store_obj, MDBX
     if (!l_type_erase) {
         rc = s_get_obj_by_text_key(a_txn, l_db_ctx->dbi, &l_key, &l_data, a_store_obj->key);
         // Drop object with same text key
-        if (MDBX_SUCCESS == rc && MDBX_SUCCESS != (rc = mdbx_del(a_txn, l_db_ctx->dbi, &l_key, NULL)) && rc != MDBX_NOTFOUND) {
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        if (MDBX_SUCCESS == rc && MDBX_SUCCESS != (rc = mdbx_del(a_txn, l_db_ctx->dbi, &l_key, NULL)) && rc != MDBX_NOTFOUND)
             return log_it(L_ERROR, "mdbx_del: (%d) %s", rc, mdbx_strerror(rc)), rc;
-        }
         /* Fill IOV for MDBX key */
         dap_global_db_driver_hash_t l_driver_key = dap_global_db_driver_hash_get(a_store_obj);
         l_key.iov_base = &l_driver_key;
@@ -1135,7 +1512,6 @@ static int s_db_mdbx_apply_store_obj_with_txn(dap_store_obj_t *a_store_obj, MDBX
             if (!l_record->sign_len) {
                 DAP_DELETE(l_record);
                 log_it(L_ERROR, "Global DB store object sign corrupted");
-                pthread_rwlock_unlock(&s_db_ctxs_rwlock);
                 return MDBX_EINVAL;
             }
             memcpy(l_record->key_n_value_n_sign + l_key_len + a_store_obj->value_len, a_store_obj->sign, l_record->sign_len);
@@ -1164,7 +1540,6 @@ static int s_db_mdbx_apply_store_obj_with_txn(dap_store_obj_t *a_store_obj, MDBX
                 log_it(L_ERROR, "mdbx_del: (%d) %s", rc, mdbx_strerror(rc));
         }
     }
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
     return rc;
 }
 
@@ -1176,26 +1551,25 @@ static int s_db_mdbx_apply_store_obj(dap_store_obj_t *a_store_obj)
             log_it(L_ERROR, "Can't drop tables with static MDBX transaction, table %s will be unchanged", a_store_obj->group);
             return DAP_GLOBAL_DB_RC_ERROR;
         }
-        pthread_rwlock_wrlock(&s_db_ctxs_rwlock);
-        dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_store_obj->group);
-        if (!l_db_ctx) {
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-            return MDBX_SUCCESS;
-        }
+        /*
+         * Context is only marked as dropped inside of the write transaction, so concurrent writers
+         * (serialized by MDBX) will see it and revive the group, readers can keep using it without a lock
+         */
         MDBX_txn *l_txn;
         int rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_READWRITE, &l_txn);
-        if (rc != MDBX_SUCCESS) {
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        if (rc != MDBX_SUCCESS)
             return log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc)), rc;
+        dap_assert ( !pthread_mutex_lock(&s_db_ctxs_mutex) );
+        dap_db_ctx_t *l_db_ctx = s_get_db_ctx_for_group(a_store_obj->group);
+        if (!l_db_ctx) {
+            pthread_mutex_unlock(&s_db_ctxs_mutex);
+            mdbx_txn_abort(l_txn);
+            return MDBX_SUCCESS;
         }
         rc = mdbx_drop(l_txn, l_db_ctx->dbi, false);
         if (rc != MDBX_SUCCESS) {
             log_it (L_ERROR, "mdbx_drop: (%d) %s", rc, mdbx_strerror(rc));
-            rc = mdbx_txn_abort(l_txn);
-            if (rc != MDBX_SUCCESS)
-                log_it (L_ERROR, "mdbx_txn_abort: (%d) %s", rc, mdbx_strerror(rc));
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-            return DAP_GLOBAL_DB_RC_ERROR;
+            goto drop_abort;
         }
         struct iovec l_data_iov, l_key_iov;
         l_data_iov.iov_base =  l_key_iov.iov_base = l_db_ctx->name;
@@ -1203,22 +1577,24 @@ static int s_db_mdbx_apply_store_obj(dap_store_obj_t *a_store_obj)
 
         if (MDBX_SUCCESS != (rc = mdbx_del(l_txn, s_db_master_dbi, &l_key_iov, &l_data_iov))) {
             log_it (L_ERROR, "mdbx_del: (%d) %s", rc, mdbx_strerror(rc));
-            rc = mdbx_txn_abort(l_txn);
-            if (rc != MDBX_SUCCESS)
-                log_it (L_ERROR, "mdbx_txn_abort: (%d) %s", rc, mdbx_strerror(rc));
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
-            return DAP_GLOBAL_DB_RC_ERROR;
+            goto drop_abort;
         }
+        atomic_store(&l_db_ctx->dropped, true);
         rc = mdbx_txn_commit(l_txn);
         if (rc != MDBX_SUCCESS) {
+            atomic_store(&l_db_ctx->dropped, false);
+            pthread_mutex_unlock(&s_db_ctxs_mutex);
             log_it (L_ERROR, "mdbx_txn_commit: (%d) %s", rc, mdbx_strerror(rc));
-            pthread_rwlock_unlock(&s_db_ctxs_rwlock);
             return DAP_GLOBAL_DB_RC_ERROR;
         }
-        HASH_DEL(s_db_ctxs, l_db_ctx);
-        DAP_DELETE(l_db_ctx);
-        pthread_rwlock_unlock(&s_db_ctxs_rwlock);
+        pthread_mutex_unlock(&s_db_ctxs_mutex);
         return DAP_GLOBAL_DB_RC_SUCCESS;
+drop_abort:
+        pthread_mutex_unlock(&s_db_ctxs_mutex);
+        rc = mdbx_txn_abort(l_txn);
+        if (rc != MDBX_SUCCESS)
+            log_it (L_ERROR, "mdbx_txn_abort: (%d) %s", rc, mdbx_strerror(rc));
+        return DAP_GLOBAL_DB_RC_ERROR;
     }
 
     if (s_txn)
@@ -1232,8 +1608,11 @@ static int s_db_mdbx_apply_store_obj(dap_store_obj_t *a_store_obj)
     if ( rc != MDBX_SUCCESS ) {                                      /* Check result of mdbx_drop/del */
         if ( MDBX_SUCCESS != (rc2 = mdbx_txn_abort(l_txn)) )
             log_it (L_ERROR, "mdbx_txn_abort: (%d) %s", rc2, mdbx_strerror(rc2));
-    } else if ( MDBX_SUCCESS != (rc2 = mdbx_txn_commit(l_txn)) )
+    } else if ( MDBX_SUCCESS != (rc2 = mdbx_txn_commit(l_txn)) ) {
         log_it (L_ERROR, "mdbx_txn_commit: (%d) %s", rc2, mdbx_strerror(rc2));
+        rc = rc2;
+    }
+    s_txn_ctxs_finish(rc == MDBX_SUCCESS);
     return rc;
 }
 
@@ -1262,18 +1641,15 @@ dap_store_obj_t *l_obj_arr = NULL;
 MDBX_val    l_key, l_data;
 MDBX_stat   l_stat;
 MDBX_cursor *l_cursor = NULL;                                       /* Initialize MDBX cursor context area */
-MDBX_txn *l_txn = s_txn;
+MDBX_txn *l_txn = NULL;
 
     dap_return_val_if_fail(a_group, NULL);                          /* Sanity check */
 
-    pthread_rwlock_rdlock(&s_db_ctxs_rwlock);
     if (!(l_db_ctx = s_get_db_ctx_for_group(a_group)))
         goto safe_ret;
 
-    if (!s_txn && MDBX_SUCCESS != (rc = mdbx_txn_begin(s_mdbx_env, NULL, MDBX_TXN_RDONLY, &l_txn)) ) {
-        log_it(L_ERROR, "mdbx_txn_begin: (%d) %s", rc, mdbx_strerror(rc));
+    if ( MDBX_SUCCESS != s_txn_rd_begin(&l_txn) )
         goto safe_ret;
-    }
 
     if ( a_key ) {
         /*
@@ -1359,11 +1735,9 @@ MDBX_txn *l_txn = s_txn;
 safe_ret:
     if (l_cursor)
         mdbx_cursor_close(l_cursor);
-    if (!s_txn)
-        mdbx_txn_commit(l_txn);
+    s_txn_rd_end(l_txn);
     if (a_count_out)
         *a_count_out = l_count_current;
-    pthread_rwlock_unlock(&s_db_ctxs_rwlock);
     return l_obj_arr;
 }
 
@@ -1388,6 +1762,7 @@ static int s_db_mdbx_txn_end(bool a_commit)
             log_it (L_ERROR, "mdbx_txn_abort: (%d) %s", rc, mdbx_strerror(rc));
     } else if ( MDBX_SUCCESS != (rc = mdbx_txn_commit(s_txn)) )
         log_it (L_ERROR, "mdbx_txn_commit: (%d) %s", rc, mdbx_strerror(rc));
+    s_txn_ctxs_finish(a_commit && rc == MDBX_SUCCESS);
     s_txn = NULL;
     return rc;
 }
@@ -44,17 +44,74 @@ along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/
 #include "dap_global_db.h"
 #include "dap_proc_thread.h"
 
+#include "uthash.h"
+
 #define LOG_TAG "db_sqlite"
 #define DAP_GLOBAL_DB_TYPE_CURRENT DAP_GLOBAL_DB_TYPE_SQLITE
 
+/* Per-group statements kept prepared for the connection lifetime */
+typedef enum sqlite_stmt_type {
+    DAP_SQLITE_STMT_INSERT = 0,
+    DAP_SQLITE_STMT_DELETE,
+    DAP_SQLITE_STMT_READ_KEY,
+    DAP_SQLITE_STMT_READ_ALL,
+    DAP_SQLITE_STMT_READ_COND,
+    DAP_SQLITE_STMT_READ_LAST,
+    DAP_SQLITE_STMT_READ_BELOW_TS,
+    DAP_SQLITE_STMT_READ_HASHES,
+    DAP_SQLITE_STMT_READ_BY_HASH,
+    DAP_SQLITE_STMT_COUNT,
+    DAP_SQLITE_STMT_IS_HASH,
+    DAP_SQLITE_STMT_IS_OBJ,
+    DAP_SQLITE_STMT_ERASE_BOUND,
+    DAP_SQLITE_STMT_ERASE_RANGE,
+    DAP_SQLITE_STMT_TYPES_COUNT
+} sqlite_stmt_type_t;
+
+/* Templates are formatted with (group name, DAP_GLOBAL_DB_RECORD_DEL, DAP_GLOBAL_DB_RECORD_PINNED): the first %d is
+   the hole flag, only ERASE_RANGE uses the second one to keep pinned records. Holes filter is bound as a parameter */
+static const char *s_stmt_templates[DAP_SQLITE_STMT_TYPES_COUNT] = {
+    [DAP_SQLITE_STMT_INSERT]        = "INSERT INTO \"%w\" VALUES(?1, ?2, ?3, ?4, ?5) "
+                                      "ON CONFLICT(key) DO UPDATE SET driver_key = excluded.driver_key, flags = excluded.flags, value = excluded.value, sign = excluded.sign",
+    [DAP_SQLITE_STMT_DELETE]        = "DELETE FROM \"%w\" WHERE key = ?1",
+    [DAP_SQLITE_STMT_READ_KEY]      = "SELECT * FROM \"%w\" WHERE key = ?1 AND (?2 OR flags & %d = 0)",
+    [DAP_SQLITE_STMT_READ_ALL]      = "SELECT * FROM \"%w\" WHERE ?1 OR flags & %d = 0 ORDER BY driver_key LIMIT ?2",
+    [DAP_SQLITE_STMT_READ_COND]     = "SELECT * FROM \"%w\" WHERE driver_key > ?1 AND (?2 OR flags & %d = 0) ORDER BY driver_key LIMIT ?3",
+    [DAP_SQLITE_STMT_READ_LAST]     = "SELECT * FROM \"%w\" WHERE ?1 OR flags & %d = 0 ORDER BY driver_key DESC LIMIT 1",
+    [DAP_SQLITE_STMT_READ_BELOW_TS] = "SELECT * FROM \"%w\" WHERE driver_key < ?1 ORDER BY driver_key LIMIT ?2",
+    [DAP_SQLITE_STMT_READ_HASHES]   = "SELECT driver_key FROM \"%w\" WHERE driver_key > ?1 ORDER BY driver_key LIMIT ?2",
+    [DAP_SQLITE_STMT_READ_BY_HASH]  = "SELECT * FROM \"%w\" WHERE driver_key = ?1",
+    [DAP_SQLITE_STMT_COUNT]         = "SELECT COUNT(*) FROM \"%w\" WHERE driver_key > ?1 AND (?2 OR flags & %d = 0)",
+    [DAP_SQLITE_STMT_IS_HASH]       = "SELECT EXISTS(SELECT 1 FROM \"%w\" WHERE driver_key = ?1)",
+    [DAP_SQLITE_STMT_IS_OBJ]        = "SELECT EXISTS(SELECT 1 FROM \"%w\" WHERE key = ?1)",
+    [DAP_SQLITE_STMT_ERASE_BOUND]   = "SELECT MAX(driver_key), COUNT(*) FROM (SELECT driver_key FROM \"%w\" "
+                                      "WHERE driver_key > ?1 AND driver_key < ?2 ORDER BY driver_key LIMIT ?3)",
+    [DAP_SQLITE_STMT_ERASE_RANGE]   = "DELETE FROM \"%w\" WHERE driver_key > ?1 AND driver_key <= ?2 "
+                                      "AND (?3 = 0 OR flags & %d) AND flags & %d = 0"
+};
+
+typedef struct sqlite_stmt_cache {
+    char *group;                                                /* Group (table) name, hash key */
+    sqlite3_stmt *stmts[DAP_SQLITE_STMT_TYPES_COUNT];           /* Lazily prepared statements */
+    UT_hash_handle hh;                                          /* Hash order is the usage order, least recently used first */
+} sqlite_stmt_cache_t;
+
 typedef struct conn_pool_item {
     sqlite3 *conn;                                                  /* SQLITE connection context itself */
     int idx;                                                    /* Just index, no more */
     atomic_flag busy_conn;                                      /* Connection busy flag */
     atomic_flag busy_trans;                                     /* Outstanding transaction busy flag */
     atomic_ullong  usage;                                       /* Usage counter */
+    sqlite_stmt_cache_t *stmt_cache;                            /* Prepared statements by group */
 } conn_list_item_t;
 
+typedef struct sqlite_cursor {
+    sqlite3 *conn;                                              /* Dedicated connection keeping the read transaction */
+    sqlite3_stmt *stmt;                                         /* Group reading statement, stepped by batches */
+    char *group;
+    bool finished;                                              /* Statement is done, next step would restart it */
+} sqlite_cursor_t;
+
 extern int g_dap_global_db_debug_more;                         /* Enable extensible debug output */
 
 static char s_filename_db [MAX_PATH];
@@ -64,8 +121,10 @@ static const int s_sleep_period = 500 * 1000;  /* Wait 0.5 sec */;
 static bool s_db_inited = false;
 static _Thread_local conn_list_item_t *s_conn = NULL;  // local connection
 
+static void s_db_sqlite_stmt_cache_clear(conn_list_item_t *a_conn);
 
 static void s_connection_destructor(UNUSED_ARG void *a_conn) {
+    s_db_sqlite_stmt_cache_clear(s_conn);
     sqlite3_close(s_conn->conn);
     log_it(L_DEBUG, "Close  connection: @%p/%p, usage: %llu", s_conn, s_conn->conn, s_conn->usage);
     DAP_DEL_Z(s_conn);
@@ -113,24 +172,22 @@ static inline void s_db_sqlite_free_connection(conn_list_item_t *a_conn, bool a_
     if (g_dap_global_db_debug_more)
         log_it(L_DEBUG, "Free  l_conn: @%p/%p, usage: %llu", a_conn, a_conn->conn, a_conn->usage);
     if (a_trans)
-        atomic_flag_clear(&a_conn->busy_trans);  
+        atomic_flag_clear(&a_conn->busy_trans);
     else
         atomic_flag_clear(&a_conn->busy_conn);
 }
 
 /**
- * @brief Free connection, dynamic num sql items and finalize sqlite3_stmts.
+ * @brief Resets a cached statement and frees the connection.
  * @param a_conn connection item to free
- * @param a_count num of pairs sql item + sqlite3_stmts
+ * @param a_stmt cached statement to reset, may be NULL
  */
-static void s_db_sqlite_clean(conn_list_item_t *a_conn, size_t a_count, ... ) {
-    va_list l_args_list;
-    va_start(l_args_list, a_count);
-    for (size_t i = 0; i < a_count; ++i)
-        sqlite3_free(va_arg(l_args_list, void*));
-    for (size_t i = 0; i < a_count; ++i)
-        sqlite3_finalize(va_arg(l_args_list, void*));
-    va_end(l_args_list);
+static void s_db_sqlite_clean(conn_list_item_t *a_conn, sqlite3_stmt *a_stmt)
+{
+    if (a_stmt) {
+        sqlite3_reset(a_stmt);
+        sqlite3_clear_bindings(a_stmt);
+    }
     s_db_sqlite_free_connection(a_conn, false);
 }
 
@@ -159,15 +216,16 @@ static int s_db_sqlite_step(sqlite3_stmt *a_stmt, const char *a_error_msg)
  * @param a_db a pointer to an instance of SQLite connection
  * @param a_str_query SQL query string
  * @param a_stmt pointer to generate sqlite3_stmt
+ * @param a_prep_flags SQLITE_PREPARE_* flags, SQLITE_PREPARE_PERSISTENT for cached statements
  * @param a_error_msg module name
  * @return result code
  */
-static int s_db_sqlite_prepare(sqlite3 *a_db, const char *a_str_query, sqlite3_stmt **a_stmt, const char *a_error_msg)
+static int s_db_sqlite_prepare(sqlite3 *a_db, const char *a_str_query, sqlite3_stmt **a_stmt, unsigned int a_prep_flags, const char *a_error_msg)
 {
     dap_return_val_if_pass(!a_stmt || !a_str_query || !a_stmt, SQLITE_ERROR);
     int l_ret = 0;
     for (char i = s_attempts_count; i--; ) {
-        l_ret = sqlite3_prepare_v2(a_db, a_str_query, -1, a_stmt, NULL);
+        l_ret = sqlite3_prepare_v3(a_db, a_str_query, -1, a_prep_flags, a_stmt, NULL);
         if (l_ret != SQLITE_BUSY && l_ret != SQLITE_LOCKED)
             break;
         dap_usleep(s_sleep_period);
@@ -204,23 +262,14 @@ static int s_db_sqlite_bind_blob64(sqlite3_stmt *a_stmt, int a_pos, const void *
  * @brief Executes SQL statements.
  * @param a_db a pointer to an instance of SQLite connection
  * @param a_query the SQL statement
- * @param a_hash pointer to data hash
- * @param a_value pointer to data
- * @param a_value_len data len to write
- * @param a_sign record sign
  * @return result code.
  */
-static int s_db_sqlite_exec(sqlite3 *a_db, const char *a_query, dap_global_db_driver_hash_t *a_hash, byte_t *a_value, size_t a_value_len, dap_sign_t *a_sign)
+static int s_db_sqlite_exec(sqlite3 *a_db, const char *a_query)
 {
     dap_return_val_if_pass(!a_db || !a_query, SQLITE_ERROR);
-    int l_ret = 0;
     sqlite3_stmt *l_stmt = NULL;
-    if (
-        (l_ret = s_db_sqlite_prepare(a_db, a_query, &l_stmt, a_query)) != SQLITE_OK ||
-        (a_hash && (l_ret = s_db_sqlite_bind_blob64(l_stmt, 1, a_hash, sizeof(*a_hash), SQLITE_STATIC, a_query)) != SQLITE_OK) ||
-        (a_value && (l_ret = s_db_sqlite_bind_blob64(l_stmt, 2, a_value, a_value_len, SQLITE_STATIC, a_query)) != SQLITE_OK) ||
-        (a_sign && (l_ret = s_db_sqlite_bind_blob64(l_stmt, 3, a_sign, dap_sign_get_size(a_sign), SQLITE_STATIC, a_query)) != SQLITE_OK)
-        ) {
+    int l_ret = s_db_sqlite_prepare(a_db, a_query, &l_stmt, 0, a_query);
+    if (l_ret != SQLITE_OK) {
         sqlite3_finalize(l_stmt);
         return l_ret;
     }
@@ -232,6 +281,86 @@ static int s_db_sqlite_exec(sqlite3 *a_db, const char *a_query, dap_global_db_dr
     return SQLITE_OK;
 }
 
+/**
+ * @brief Finalizes all the statements cached for a group.
+ * @param a_conn connection item
+ * @param a_group a group name string
+ */
+static void s_db_sqlite_stmt_cache_drop(conn_list_item_t *a_conn, const char *a_group)
+{
+    sqlite_stmt_cache_t *l_item = NULL;
+    HASH_FIND_STR(a_conn->stmt_cache, a_group, l_item);
+    if (!l_item)
+        return;
+    HASH_DEL(a_conn->stmt_cache, l_item);
+    for (size_t i = 0; i < DAP_SQLITE_STMT_TYPES_COUNT; ++i)
+        sqlite3_finalize(l_item->stmts[i]);
+    DAP_DEL_MULTY(l_item->group, l_item);
+}
+
+/**
+ * @brief Finalizes all the cached statements of a connection. Must be called before closing it.
+ * @param a_conn connection item
+ */
+static void s_db_sqlite_stmt_cache_clear(conn_list_item_t *a_conn)
+{
+    if (!a_conn)
+        return;
+    sqlite_stmt_cache_t *l_item, *l_tmp;
+    HASH_ITER(hh, a_conn->stmt_cache, l_item, l_tmp) {
+        HASH_DEL(a_conn->stmt_cache, l_item);
+        for (size_t i = 0; i < DAP_SQLITE_STMT_TYPES_COUNT; ++i)
+            sqlite3_finalize(l_item->stmts[i]);
+        DAP_DEL_MULTY(l_item->group, l_item);
+    }
+}
+
+/**
+ * @brief Gets a prepared statement for a group from the connection cache, prepares it on first use.
+ * @note Statement must be reset with s_db_sqlite_clean() after use
+ * @param a_conn connection item
+ * @param a_group a group name string
+ * @param a_type statement type
+ * @return pointer to the statement, NULL if it can't be prepared (i.e. group table not exists)
+ */
+static sqlite3_stmt *s_db_sqlite_stmt_get(conn_list_item_t *a_conn, const char *a_group, sqlite_stmt_type_t a_type)
+{
+    sqlite_stmt_cache_t *l_item = NULL;
+    HASH_FIND_STR(a_conn->stmt_cache, a_group, l_item);
+    if (l_item) {
+        // Move the group to the tail of the usage order
+        HASH_DEL(a_conn->stmt_cache, l_item);
+        HASH_ADD_KEYPTR(hh, a_conn->stmt_cache, l_item->group, strlen(l_item->group), l_item);
+        if (l_item->stmts[a_type])
+            return l_item->stmts[a_type];
+    }
+    char *l_query = sqlite3_mprintf(s_stmt_templates[a_type], a_group, DAP_GLOBAL_DB_RECORD_DEL, DAP_GLOBAL_DB_RECORD_PINNED);
+    if (!l_query) {
+        log_it(L_ERROR, "Error in SQL request forming");
+        return NULL;
+    }
+    sqlite3_stmt *l_stmt = NULL;
+    int l_ret = s_db_sqlite_prepare(a_conn->conn, l_query, &l_stmt, SQLITE_PREPARE_PERSISTENT, l_query);
+    sqlite3_free(l_query);
+    if (l_ret != SQLITE_OK) {
+        sqlite3_finalize(l_stmt);
+        return NULL;
+    }
+    if (!l_item) {
+        if (HASH_COUNT(a_conn->stmt_cache) >= DAP_GLOBAL_DB_GROUPS_COUNT_MAX)
+            // Evict the least recently used group, the head of the hash
+            s_db_sqlite_stmt_cache_drop(a_conn, a_conn->stmt_cache->group);
+        if ( !(l_item = DAP_NEW_Z(sqlite_stmt_cache_t)) || !(l_item->group = dap_strdup(a_group)) ) {
+            log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+            sqlite3_finalize(l_stmt);
+            DAP_DELETE(l_item);
+            return NULL;
+        }
+        HASH_ADD_KEYPTR(hh, a_conn->stmt_cache, l_item->group, strlen(l_item->group), l_item);
+    }
+    return l_item->stmts[a_type] = l_stmt;
+}
+
 /**
  * @brief Prepare connection item
  * @param a_trans outstanding transaction flag
@@ -256,11 +385,11 @@ static conn_list_item_t *s_db_sqlite_get_connection(bool a_trans)
             return NULL;
         }
         s_conn->idx = l_conn_idx++;
-        if((s_db_sqlite_exec(s_conn->conn, "PRAGMA synchronous = NORMAL", NULL, NULL, 0, NULL)))
+        if((s_db_sqlite_exec(s_conn->conn, "PRAGMA synchronous = NORMAL")))
             log_it(L_ERROR, "can't set new synchronous mode\n");
-        if(s_db_sqlite_exec(s_conn->conn, "PRAGMA journal_mode = WAL", NULL, NULL, 0, NULL))
+        if(s_db_sqlite_exec(s_conn->conn, "PRAGMA journal_mode = WAL"))
             log_it(L_ERROR, "can't set new journal mode\n");
-        if(s_db_sqlite_exec(s_conn->conn, "PRAGMA page_size = 4096", NULL, NULL, 0, NULL))
+        if(s_db_sqlite_exec(s_conn->conn, "PRAGMA page_size = 4096"))
             log_it(L_ERROR, "can't set page_size\n");
         log_it(L_DEBUG, "SQL connection #%d is created @%p", s_conn->idx, s_conn);
     }
@@ -307,11 +436,34 @@ static int s_db_sqlite_create_group_table(const char *a_table_name, conn_list_it
 {
 // sanity check
     dap_return_val_if_pass(!a_table_name || !a_conn, -EINVAL);
-    char *l_query = dap_strdup_printf("CREATE TABLE IF NOT EXISTS \"%s\""
+    char *l_query = sqlite3_mprintf("CREATE TABLE IF NOT EXISTS \"%w\""
         "(driver_key BLOB UNIQUE NOT NULL PRIMARY KEY ON CONFLICT REPLACE, key TEXT UNIQUE NOT NULL, flags INTEGER, value BLOB, sign BLOB)",
         a_table_name);
-    int l_ret = s_db_sqlite_exec(a_conn->conn, l_query, NULL, NULL, 0, NULL);
-    return DAP_DELETE(l_query), l_ret;
+    int l_ret = s_db_sqlite_exec(a_conn->conn, l_query);
+    return sqlite3_free(l_query), l_ret;
+}
+
+/**
+ * @brief Binds and steps the cached insert statement for an object.
+ * @param a_stmt insert statement
+ * @param a_store_obj a pointer to the object structure
+ * @return result code.
+ */
+static int s_db_sqlite_insert(sqlite3_stmt *a_stmt, dap_store_obj_t *a_store_obj)
+{
+    const char *l_error_msg = "insert";
+    dap_global_db_driver_hash_t l_driver_key = dap_global_db_driver_hash_get(a_store_obj);
+    int l_ret = SQLITE_OK;
+    if (
+        (l_ret = s_db_sqlite_bind_blob64(a_stmt, 1, &l_driver_key, sizeof(l_driver_key), SQLITE_TRANSIENT, l_error_msg)) != SQLITE_OK ||
+        (l_ret = sqlite3_bind_text(a_stmt, 2, a_store_obj->key, -1, SQLITE_STATIC)) != SQLITE_OK ||
+        (l_ret = sqlite3_bind_int(a_stmt, 3, (int)(a_store_obj->flags & ~DAP_GLOBAL_DB_RECORD_NEW))) != SQLITE_OK ||
+        (a_store_obj->value && (l_ret = s_db_sqlite_bind_blob64(a_stmt, 4, a_store_obj->value, a_store_obj->value_len, SQLITE_STATIC, l_error_msg)) != SQLITE_OK) ||
+        (a_store_obj->sign && (l_ret = s_db_sqlite_bind_blob64(a_stmt, 5, a_store_obj->sign, dap_sign_get_size(a_store_obj->sign), SQLITE_STATIC, l_error_msg)) != SQLITE_OK)
+        )
+        return l_ret;
+    l_ret = s_db_sqlite_step(a_stmt, l_error_msg);
+    return l_ret == SQLITE_DONE || l_ret == SQLITE_ROW ? SQLITE_OK : l_ret;
 }
 
 /**
@@ -332,35 +484,46 @@ static int s_db_sqlite_apply_store_obj(dap_store_obj_t *a_store_obj)
         return -2;
 
     int l_ret = 0;
-    char *l_query = NULL;
+    sqlite3_stmt *l_stmt = NULL;
     if (!l_type_erase) {
         if (!a_store_obj->key) {
             log_it(L_ERROR, "Global DB store object unsigned");
             l_ret = -3;
             goto clean_and_ret;
-        } else { //add one record
-            l_query = sqlite3_mprintf("INSERT INTO \"%s\" VALUES(?, '%s', '%d', ?, ?) "
-            "ON CONFLICT(key) DO UPDATE SET driver_key = excluded.driver_key, flags = excluded.flags, value = excluded.value, sign = excluded.sign;",
-                                                  a_store_obj->group, a_store_obj->key, (int)(a_store_obj->flags & ~DAP_GLOBAL_DB_RECORD_NEW));
         }
-        dap_global_db_driver_hash_t l_driver_key = dap_global_db_driver_hash_get(a_store_obj);
-        l_ret = s_db_sqlite_exec(l_conn->conn, l_query, &l_driver_key, a_store_obj->value, a_store_obj->value_len, a_store_obj->sign);
-        if (l_ret == SQLITE_ERROR) {
+        //add one record
+        if ( !(l_stmt = s_db_sqlite_stmt_get(l_conn, a_store_obj->group, DAP_SQLITE_STMT_INSERT)) ) {
             // create table and repeat request
+            if ( s_db_sqlite_create_group_table(a_store_obj->group, l_conn) != SQLITE_OK
+                || !(l_stmt = s_db_sqlite_stmt_get(l_conn, a_store_obj->group, DAP_SQLITE_STMT_INSERT)) ) {
+                l_ret = SQLITE_ERROR;
+                goto clean_and_ret;
+            }
+        }
+        l_ret = s_db_sqlite_insert(l_stmt, a_store_obj);
+        if (l_ret == SQLITE_ERROR) {
+            // table was dropped by another connection, create it and repeat request
+            sqlite3_reset(l_stmt);
             if (s_db_sqlite_create_group_table(a_store_obj->group, l_conn) == SQLITE_OK)
-                l_ret = s_db_sqlite_exec(l_conn->conn, l_query, &l_driver_key, a_store_obj->value, a_store_obj->value_len, a_store_obj->sign);
+                l_ret = s_db_sqlite_insert(l_stmt, a_store_obj);
         }
-    } else {
-        if (a_store_obj->key) //delete one record
-            l_query = sqlite3_mprintf("DELETE FROM \"%s\" WHERE key = '%s'", a_store_obj->group, a_store_obj->key);
-        else // remove all group
-            l_query = sqlite3_mprintf("DROP TABLE IF EXISTS \"%s\"", a_store_obj->group);
-        l_ret = s_db_sqlite_exec(l_conn->conn, l_query, NULL, NULL, 0, NULL);
+    } else if (a_store_obj->key) { //delete one record
+        if ( !(l_stmt = s_db_sqlite_stmt_get(l_conn, a_store_obj->group, DAP_SQLITE_STMT_DELETE)) ) {
+            l_ret = SQLITE_ERROR;
+            goto clean_and_ret;
+        }
+        if ( (l_ret = sqlite3_bind_text(l_stmt, 1, a_store_obj->key, -1, SQLITE_STATIC)) == SQLITE_OK ) {
+            l_ret = s_db_sqlite_step(l_stmt, "delete");
+            l_ret = l_ret == SQLITE_DONE || l_ret == SQLITE_ROW ? SQLITE_OK : l_ret;
+        }
+    } else { // remove all group
+        s_db_sqlite_stmt_cache_drop(l_conn, a_store_obj->group);
+        char *l_query = sqlite3_mprintf("DROP TABLE IF EXISTS \"%w\"", a_store_obj->group);
+        l_ret = s_db_sqlite_exec(l_conn->conn, l_query);
+        sqlite3_free(l_query);
     }
 clean_and_ret:
-    s_db_sqlite_free_connection(l_conn, false);
-    if (l_query)
-        sqlite3_free(l_query);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -409,6 +572,52 @@ clean_and_ret:
     return l_ret;
 }
 
+/**
+ * @brief Reads rows of a bound statement into an objects array, growing it on demand
+ * @param a_group a group name string
+ * @param a_stmt a bound statement
+ * @param a_limit a maximum number of objects to be read, 0 means no limits
+ * @param a_count_out[out] a number of objects that were read, untouched if nothing found
+ * @param a_error_msg module name
+ * @return If successful, a pointer to an objects, otherwise NULL.
+ */
+static dap_store_obj_t *s_db_sqlite_fill_items(const char *a_group, sqlite3_stmt *a_stmt, size_t a_limit, size_t *a_count_out, const char *a_error_msg)
+{
+    dap_store_obj_t *l_ret = NULL;
+    size_t l_count = 0, l_size = 0;
+    int rc = SQLITE_DONE;
+    while ( !a_limit || l_count < a_limit ) {
+        if (l_count == l_size) {
+            size_t l_new_size = l_size ? l_size * 2 : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT;
+            if (a_limit)
+                l_new_size = dap_min(l_new_size, a_limit);
+            // one zeroed item more as the array tail
+            dap_store_obj_t *l_new = DAP_REALLOC(l_ret, (l_new_size + 1) * sizeof(dap_store_obj_t));
+            if (!l_new) {
+                log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+                dap_store_obj_free(l_ret, l_count);
+                return NULL;
+            }
+            memset(l_new + l_size, 0, (l_new_size + 1 - l_size) * sizeof(dap_store_obj_t));
+            l_ret = l_new;
+            l_size = l_new_size;
+        }
+        if ( SQLITE_ROW != (rc = s_db_sqlite_fill_one_item(a_group, l_ret + l_count, a_stmt)) )
+            break;
+        ++l_count;
+    }
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+        log_it(L_ERROR, "SQLite %s error %d(%s)", a_error_msg, rc, sqlite3_errstr(rc));
+    if (!l_count) {
+        log_it(L_INFO, "There are no records satisfying the %s request", a_error_msg);
+        DAP_DELETE(l_ret);
+        return NULL;
+    }
+    if (a_count_out)
+        *a_count_out = l_count;
+    return l_ret;
+}
+
 /**
  * @brief Reads a last object from the s_db database.
  * @param a_group a group name string
@@ -422,37 +631,12 @@ static dap_store_obj_t* s_db_sqlite_read_last_store_obj(const char *a_group, boo
     dap_return_val_if_pass(!a_group || !(l_conn = s_db_sqlite_get_connection(false)), NULL);
 // preparing
     dap_store_obj_t *l_ret = NULL;
-    sqlite3_stmt *l_stmt = NULL;
-    char *l_query_str = sqlite3_mprintf("SELECT * FROM \"%s\""
-                                        " WHERE flags & '%d' %s 0"
-                                        " ORDER BY driver_key DESC LIMIT 1",
-                                        a_group, DAP_GLOBAL_DB_RECORD_DEL,
-                                        a_with_holes ? ">=" : "=");
-    if (!l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, "last read")!= SQLITE_OK) {
-        goto clean_and_ret;
-    }
-// memory alloc
-    l_ret = DAP_NEW_Z(dap_store_obj_t);
-    if (!l_ret) {
-        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
-        goto clean_and_ret;
-    }
-// fill item
-    int l_ret_code = s_db_sqlite_fill_one_item(a_group, l_ret, l_stmt);
-    if(l_ret_code != SQLITE_ROW && l_ret_code != SQLITE_DONE) {
-        log_it(L_ERROR, "SQLite last read error %d(%s)", sqlite3_errcode(l_conn->conn), sqlite3_errmsg(l_conn->conn));
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_LAST);
+    if ( !l_stmt || sqlite3_bind_int(l_stmt, 1, a_with_holes) != SQLITE_OK )
         goto clean_and_ret;
-    }
-    if( l_ret_code != SQLITE_ROW) {
-        log_it(L_INFO, "There are no records satisfying the last read request");
-    }
+    l_ret = s_db_sqlite_fill_items(a_group, l_stmt, 1, NULL, "last read");
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 1, l_query_str, l_stmt);    
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -471,129 +655,69 @@ static dap_global_db_pkt_pack_t *s_db_sqlite_get_by_hash(const char *a_group, da
 // preparing
     const char *l_error_msg = "get by hash";
     dap_global_db_pkt_pack_t *l_ret = NULL;
-    sqlite3_stmt *l_stmt_count = NULL, *l_stmt = NULL, *l_stmt_size = NULL;
-    char *l_blob_str = DAP_NEW_Z_SIZE(char, a_count * 2);
-    if (!l_blob_str) {
-        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
-        return NULL;
-    }
-    for (size_t k = 0; k < a_count; memcpy(l_blob_str + 2 * (k++), "?,", 2));
-    l_blob_str[2 * a_count - 1] = '\0';
-
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\" "
-                                        " WHERE driver_key IN (%s)",
-                                        a_group, l_blob_str);
-    char *l_query_size_str = sqlite3_mprintf("SELECT SUM(LENGTH(key)) + COALESCE(SUM(LENGTH(value)), 0) + COALESCE(SUM(LENGTH(sign)), 0) FROM \"%s\" "
-                                        " WHERE driver_key IN (%s)",
-                                        a_group, l_blob_str);
-    char *l_query_str = sqlite3_mprintf("SELECT * FROM \"%s\""
-                                        " WHERE driver_key IN (%s) ORDER BY driver_key",
-                                        a_group, l_blob_str);
-    DAP_DELETE(l_blob_str);
-    if (!l_query_count_str || !l_query_size_str ||  !l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-    if( s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_prepare(l_conn->conn, l_query_size_str, &l_stmt_size, l_error_msg)  != SQLITE_OK ||
-        s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, l_error_msg)            != SQLITE_OK )
-    {
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_BY_HASH);
+    if (!l_stmt)
         goto clean_and_ret;
-    }
-    for (size_t i = 1; i <= a_count; ++i) {
-        if( s_db_sqlite_bind_blob64(l_stmt_count, i,a_hashes + i - 1, sizeof(*a_hashes), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-            s_db_sqlite_bind_blob64(l_stmt_size, i, a_hashes + i - 1, sizeof(*a_hashes), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-            s_db_sqlite_bind_blob64(l_stmt, i,      a_hashes + i - 1, sizeof(*a_hashes), SQLITE_STATIC, l_error_msg) != SQLITE_OK )
-        {
-            goto clean_and_ret;
-        }
-    }
-    if ( s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW || s_db_sqlite_step(l_stmt_size, l_error_msg) != SQLITE_ROW ) {
-        goto clean_and_ret;
-    }
-// memory alloc
-    int64_t i, j, l_count = sqlite3_column_int64(l_stmt_count, 0), l_size = sqlite3_column_int64(l_stmt_size, 0);
-    if ( l_count <= 0 || l_size <= 0 ) {
-        log_it(L_INFO, "There are no records satisfying the get by hash request");
-        goto clean_and_ret;
-    }
-    size_t l_group_name_len = strlen(a_group) + 1;
-    size_t l_data_size = l_count * (sizeof(dap_global_db_pkt_t) + l_group_name_len + 1) + l_size;  // +1 add \0 to key
-    l_ret = DAP_NEW_Z_SIZE(dap_global_db_pkt_pack_t, sizeof(dap_global_db_pkt_pack_t) + l_data_size);
-    if ( !l_ret ) {
-        log_it(L_CRITICAL, "Memory allocation error!");
-        goto clean_and_ret;
-    }
-    byte_t *l_data_pos = l_ret->data, *l_data_end = l_data_pos + l_data_size;
-    for (i = 0; s_db_sqlite_step(l_stmt, l_error_msg) == SQLITE_ROW && i < l_count; ++i) {
-        dap_global_db_pkt_t *l_cur_pkt = (dap_global_db_pkt_t*)(l_data_pos);
-        l_data_pos = l_cur_pkt->data;
-        if ( l_data_pos + l_group_name_len > l_data_end )
-            break;
-        l_data_pos = dap_mempcpy(l_data_pos, a_group, l_cur_pkt->group_len = l_group_name_len);
-        int l_count_col = sqlite3_column_count(l_stmt);
-        for (j = 0; j < l_count_col; ++j) {
-            switch ( sqlite3_column_type(l_stmt, j) ) {
-            case SQLITE_BLOB:
-                if ( j == 0 ) {
-                    dap_global_db_driver_hash_t *l_driver_key = (dap_global_db_driver_hash_t*)sqlite3_column_blob(l_stmt, j);
-                    l_cur_pkt->timestamp = be64toh(l_driver_key->bets);
-                    l_cur_pkt->crc = be64toh(l_driver_key->becrc);
-                } else if ( j == 3 ) {
-                    l_cur_pkt->value_len = sqlite3_column_bytes(l_stmt, j);
-                    if ( l_data_pos + l_cur_pkt->value_len > l_data_end )
-                        break;
-                    l_data_pos = dap_mempcpy(l_data_pos, sqlite3_column_blob(l_stmt, j), l_cur_pkt->value_len);
-                } else if ( j == 4 ) {
-                    size_t l_sign_size = sqlite3_column_bytes(l_stmt, j);
-                    if (l_sign_size) {
-                        dap_sign_t *l_sign = (dap_sign_t*)sqlite3_column_blob(l_stmt, j);
-                        if ( dap_sign_get_size(l_sign) != l_sign_size || l_data_pos + l_sign_size > l_data_end ) {
-                            log_it(L_ERROR, "Wrong sign size in GDB group %s", a_group);
-                            break;
-                        }
-                        l_data_pos = dap_mempcpy(l_data_pos, l_sign, l_sign_size);
-                    }
-                } continue;
-            case SQLITE_TEXT:
-                if ( j == 1 ) {
-                    l_cur_pkt->key_len = sqlite3_column_bytes(l_stmt, j);
-                    if ( l_data_pos + l_cur_pkt->key_len  + 1 > l_data_end )
-                        break;
-                    l_data_pos = dap_mempcpy(l_data_pos, sqlite3_column_text(l_stmt, j), l_cur_pkt->key_len++) + 1;
-                } continue;
-            case SQLITE_INTEGER:
-                if ( j == 2 ) {
-                    if (sqlite3_column_bytes(l_stmt, j))
-                        l_cur_pkt->flags = sqlite3_column_int64(l_stmt, j) & DAP_GLOBAL_DB_RECORD_DEL;
-                } continue;
-            default:
-                continue;
-            }
-            // Some break occured, escape from loops
-            j = -1;
+    size_t l_group_name_len = strlen(a_group) + 1, l_data_size = 0, l_alloc_size = 0;
+    for (size_t i = 0; i < a_count; ++i) {
+        if ( dap_global_db_driver_hash_is_blank(a_hashes + i) )
+            continue;
+        if ( s_db_sqlite_bind_blob64(l_stmt, 1, a_hashes + i, sizeof(*a_hashes), SQLITE_STATIC, l_error_msg) != SQLITE_OK )
             break;
+        if ( s_db_sqlite_step(l_stmt, l_error_msg) != SQLITE_ROW ) {
+            sqlite3_reset(l_stmt);
+            continue;
         }
-        if ( j == -1 ) {
-            l_data_pos = (byte_t*)l_cur_pkt;
-            break;
+        const char *l_key = (const char *)sqlite3_column_text(l_stmt, 1);
+        const byte_t *l_value = sqlite3_column_blob(l_stmt, 3);
+        dap_sign_t *l_sign = (dap_sign_t *)sqlite3_column_blob(l_stmt, 4);
+        size_t  l_key_len = sqlite3_column_bytes(l_stmt, 1),
+                l_value_len = sqlite3_column_bytes(l_stmt, 3),
+                l_sign_size = sqlite3_column_bytes(l_stmt, 4);
+        if ( !l_key || sqlite3_column_bytes(l_stmt, 0) != sizeof(dap_global_db_driver_hash_t)
+            || (l_sign_size && dap_sign_get_size(l_sign) != l_sign_size) ) {
+            log_it(L_ERROR, "Broken record in GDB group %s, skip it", a_group);
+            sqlite3_reset(l_stmt);
+            continue;
         }
-        l_cur_pkt->data_len = (uint32_t)(l_data_pos - l_cur_pkt->data);
-        l_ret->data_size = (uint64_t)(l_data_pos - l_ret->data);
-    }
-    l_ret->obj_count = i;
-    if (i < l_count) {
-        log_it(L_ERROR, "Invalid pack size, only %ld / %ld pkts (%zu / %zu bytes) fit the storage",
-                        i, l_count, l_ret->data_size, l_data_size);
-        size_t l_new_size = (size_t)(l_data_pos - (byte_t*)l_ret);
-        dap_global_db_pkt_pack_t *l_new_pack = DAP_REALLOC(l_ret, l_new_size);
-        if (l_new_pack)
+        size_t l_pkt_size = sizeof(dap_global_db_pkt_t) + l_group_name_len + l_key_len + 1 + l_value_len + l_sign_size;
+        if ( sizeof(dap_global_db_pkt_pack_t) + l_data_size + l_pkt_size > l_alloc_size ) {
+            l_alloc_size = dap_max(l_alloc_size * 2, sizeof(dap_global_db_pkt_pack_t) + l_data_size + l_pkt_size);
+            dap_global_db_pkt_pack_t *l_new_pack = DAP_REALLOC(l_ret, l_alloc_size);
+            if (!l_new_pack) {
+                log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+                DAP_DEL_Z(l_ret);
+                goto clean_and_ret;
+            }
+            if (!l_ret)
+                l_new_pack->obj_count = 0;
             l_ret = l_new_pack;
-        else
-            DAP_DEL_Z(l_ret);
+        }
+        dap_global_db_pkt_t *l_cur_pkt = (dap_global_db_pkt_t *)(l_ret->data + l_data_size);
+        dap_global_db_driver_hash_t *l_driver_key = (dap_global_db_driver_hash_t *)sqlite3_column_blob(l_stmt, 0);
+        l_cur_pkt->timestamp = be64toh(l_driver_key->bets);
+        l_cur_pkt->crc = be64toh(l_driver_key->becrc);
+        l_cur_pkt->flags = sqlite3_column_int64(l_stmt, 2) & DAP_GLOBAL_DB_RECORD_DEL;
+        l_cur_pkt->group_len = l_group_name_len;
+        l_cur_pkt->key_len = l_key_len + 1;
+        l_cur_pkt->value_len = l_value_len;
+        byte_t *l_data_pos = dap_mempcpy(l_cur_pkt->data, a_group, l_group_name_len);
+        l_data_pos = dap_mempcpy(l_data_pos, l_key, l_key_len);
+        *l_data_pos++ = '\0';
+        if (l_value_len)
+            l_data_pos = dap_mempcpy(l_data_pos, l_value, l_value_len);
+        if (l_sign_size)
+            l_data_pos = dap_mempcpy(l_data_pos, l_sign, l_sign_size);
+        l_cur_pkt->data_len = (uint32_t)(l_data_pos - l_cur_pkt->data);
+        l_data_size += sizeof(dap_global_db_pkt_t) + l_cur_pkt->data_len;
+        l_ret->data_size = l_data_size;
+        l_ret->obj_count++;
+        sqlite3_reset(l_stmt);
     }
+    if (!l_ret)
+        log_it(L_INFO, "There are no records satisfying the get by hash request");
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 3, l_query_str, l_query_count_str, l_query_size_str, l_stmt, l_stmt_count, l_stmt_size);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -611,35 +735,14 @@ static dap_global_db_hash_pkt_t *s_db_sqlite_read_hashes(const char *a_group, da
 // preparing
     const char *l_error_msg = "hashes read";
     dap_global_db_hash_pkt_t *l_ret = NULL;
-    sqlite3_stmt *l_stmt_count = NULL, *l_stmt = NULL;
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\""
-                                        " WHERE driver_key > ?",
-                                        a_group);
-    char *l_query_str = sqlite3_mprintf("SELECT driver_key FROM \"%s\""
-                                        " WHERE driver_key > ?"
-                                        " ORDER BY driver_key LIMIT '%d'",
-                                        a_group, (int)DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT);
-    if (!l_query_count_str || !l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt_count, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-        s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW)
-    {
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_HASHES);
+    if ( !l_stmt
+        || s_db_sqlite_bind_blob64(l_stmt, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || sqlite3_bind_int64(l_stmt, 2, DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT) != SQLITE_OK )
         goto clean_and_ret;
-    }
 // memory alloc
-    uint64_t l_count = sqlite3_column_int64(l_stmt_count, 0);
-    if (!l_count) {
-        log_it(L_INFO, "There are no records satisfying the hashes read request");
-        goto clean_and_ret;
-    }
     size_t l_group_name_len = strlen(a_group) + 1;
-    l_ret = DAP_NEW_Z_SIZE(dap_global_db_hash_pkt_t, sizeof(dap_global_db_hash_pkt_t) + (l_count + 1) * sizeof(dap_global_db_driver_hash_t) + l_group_name_len);
+    l_ret = DAP_NEW_Z_SIZE(dap_global_db_hash_pkt_t, sizeof(dap_global_db_hash_pkt_t) + (DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT + 1) * sizeof(dap_global_db_driver_hash_t) + l_group_name_len);
     if (!l_ret) {
         log_it(L_CRITICAL, "%s", c_error_memory_alloc);
         goto clean_and_ret;
@@ -649,7 +752,7 @@ static dap_global_db_hash_pkt_t *s_db_sqlite_read_hashes(const char *a_group, da
     l_ret->group_name_len = l_group_name_len;
     byte_t *l_pos = dap_mempcpy(l_ret->group_n_hashses, a_group, l_group_name_len);
 
-    for ( l_count_out = 0; l_count_out < l_count 
+    for ( l_count_out = 0; l_count_out < DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT
             && s_db_sqlite_step(l_stmt, l_error_msg) == SQLITE_ROW
             && sqlite3_column_type(l_stmt, 0) == SQLITE_BLOB;
             ++l_count_out )
@@ -660,9 +763,14 @@ static dap_global_db_hash_pkt_t *s_db_sqlite_read_hashes(const char *a_group, da
         }
         l_pos = dap_mempcpy(l_pos, sqlite3_column_blob(l_stmt, 0), sizeof(dap_global_db_driver_hash_t));
     }
+    if (!l_count_out) {
+        log_it(L_INFO, "There are no records satisfying the hashes read request");
+        DAP_DEL_Z(l_ret);
+        goto clean_and_ret;
+    }
     l_ret->hashes_count = l_count_out + 1;
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 2, l_query_str, l_query_count_str, l_stmt, l_stmt_count);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -683,51 +791,16 @@ static dap_store_obj_t* s_db_sqlite_read_cond_store_obj(const char *a_group, dap
 // preparing
     const char *l_error_msg = "conditional read";
     dap_store_obj_t *l_ret = NULL;
-    sqlite3_stmt *l_stmt_count = NULL, *l_stmt = NULL;
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\""
-                                        " WHERE driver_key > ? AND (flags & '%d' %s 0)",
-                                        a_group, DAP_GLOBAL_DB_RECORD_DEL,
-                                        a_with_holes ? ">=" : "=");
-    char *l_query_str = sqlite3_mprintf("SELECT * FROM \"%s\""
-                                        " WHERE driver_key > ? AND (flags & '%d' %s 0)"
-                                        " ORDER BY driver_key LIMIT '%d'",
-                                        a_group, DAP_GLOBAL_DB_RECORD_DEL,
-                                        a_with_holes ? ">=" : "=",
-                                        a_count_out && *a_count_out ? (int)*a_count_out : (int)DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT);
-    if (!l_query_count_str || !l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
+    size_t l_limit = a_count_out && *a_count_out ? *a_count_out : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT;
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_COND);
+    if ( !l_stmt
+        || s_db_sqlite_bind_blob64(l_stmt, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || sqlite3_bind_int(l_stmt, 2, a_with_holes) != SQLITE_OK
+        || sqlite3_bind_int64(l_stmt, 3, (sqlite3_int64)l_limit) != SQLITE_OK )
         goto clean_and_ret;
-    }
-    
-    if( s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)                        != SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt_count, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-        s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, l_error_msg)                                    != SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg)       != SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg)                                                             != SQLITE_ROW )
-    {
-        goto clean_and_ret;
-    }
-// memory alloc
-    uint64_t l_count = sqlite3_column_int64(l_stmt_count, 0);
-    l_count = a_count_out && *a_count_out ? dap_min(l_count, *a_count_out) : dap_min(l_count, DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT);
-    if (!l_count) {
-        log_it(L_INFO, "There are no records satisfying the conditional read request");
-        goto clean_and_ret;
-    }
-    if (!( l_ret = DAP_NEW_Z_COUNT(dap_store_obj_t, l_count + 1) )) {
-        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
-        goto clean_and_ret;
-    }
-// data forming
-    size_t l_count_out = 0;
-    int rc;
-    for ( rc = 0; SQLITE_ROW == ( rc = s_db_sqlite_fill_one_item(a_group, l_ret + l_count_out, l_stmt) ) && l_count_out < l_count; ++l_count_out ) {};
-    if ( rc != SQLITE_DONE )
-        log_it(L_ERROR, "SQLite conditional read error %d(%s)", sqlite3_errcode(l_conn->conn), sqlite3_errmsg(l_conn->conn));
-    if (a_count_out)
-        *a_count_out = l_count_out;
+    l_ret = s_db_sqlite_fill_items(a_group, l_stmt, l_limit, a_count_out, l_error_msg);
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 2, l_query_str, l_query_count_str, l_stmt, l_stmt_count);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -747,52 +820,23 @@ static dap_store_obj_t* s_db_sqlite_read_store_obj(const char *a_group, const ch
 // func work
     const char *l_error_msg = "read";
     dap_store_obj_t *l_ret = NULL;
-    sqlite3_stmt *l_stmt_count = NULL, *l_stmt = NULL;
-    char *l_query_count_str = NULL;
-    char *l_query_str = NULL;
+    sqlite3_stmt *l_stmt = NULL;
+    size_t l_limit = 1;
     if (a_key) {
-        l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\" WHERE key='%s' AND (flags & '%d' %s 0)", a_group, a_key, DAP_GLOBAL_DB_RECORD_DEL, a_with_holes ? ">=" : "=");
-        l_query_str = sqlite3_mprintf("SELECT * FROM \"%s\" WHERE key='%s' AND (flags & '%d' %s 0)", a_group, a_key, DAP_GLOBAL_DB_RECORD_DEL, a_with_holes ? ">=" : "=");
+        if ( !(l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_KEY))
+            || sqlite3_bind_text(l_stmt, 1, a_key, -1, SQLITE_STATIC) != SQLITE_OK
+            || sqlite3_bind_int(l_stmt, 2, a_with_holes) != SQLITE_OK )
+            goto clean_and_ret;
     } else { // no limit
-        l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\" WHERE flags & '%d' %s 0 ORDER BY driver_key", a_group, DAP_GLOBAL_DB_RECORD_DEL, a_with_holes ? ">=" : "=");
-        l_query_str = sqlite3_mprintf("SELECT * FROM \"%s\" WHERE flags & '%d' %s 0 ORDER BY driver_key LIMIT '%d'",
-                                        a_group, DAP_GLOBAL_DB_RECORD_DEL,
-                                        a_with_holes ? ">=" : "=",
-                                        a_count_out && *a_count_out ? (int)*a_count_out : -1);
-    }
-    if (!l_query_count_str || !l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW)
-    {
-        goto clean_and_ret;
-    }
-// memory alloc
-    uint64_t l_count = sqlite3_column_int64(l_stmt_count, 0);
-    l_count = a_count_out && *a_count_out ? dap_min(*a_count_out, l_count) : l_count;
-    if (!l_count) {
-        log_it(L_INFO, "There are no records satisfying the read request");
-        goto clean_and_ret;
-    }
-    if (!( l_ret = DAP_NEW_Z_COUNT(dap_store_obj_t, l_count) )) {
-        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
-        goto clean_and_ret;
+        l_limit = a_count_out && *a_count_out ? *a_count_out : 0;
+        if ( !(l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_ALL))
+            || sqlite3_bind_int(l_stmt, 1, a_with_holes) != SQLITE_OK
+            || sqlite3_bind_int64(l_stmt, 2, l_limit ? (sqlite3_int64)l_limit : -1) != SQLITE_OK )
+            goto clean_and_ret;
     }
-    
-// data forming
-    size_t l_count_out = 0;
-    int rc;
-    for ( rc = 0; SQLITE_ROW == ( rc = s_db_sqlite_fill_one_item(a_group, l_ret + l_count_out, l_stmt) ) && l_count_out < l_count; ++l_count_out ) {};
-    if ( rc != SQLITE_DONE )
-        log_it(L_ERROR, "SQLite read error %d(%s)", sqlite3_errcode(l_conn->conn), sqlite3_errmsg(l_conn->conn));
-    if (a_count_out)
-        *a_count_out = l_count_out;
+    l_ret = s_db_sqlite_fill_items(a_group, l_stmt, l_limit, a_count_out, l_error_msg);
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 2, l_query_str, l_query_count_str, l_stmt, l_stmt_count);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -802,50 +846,17 @@ static dap_store_obj_t* s_db_sqlite_read_store_obj_below_timestamp(const char *a
     dap_return_val_if_fail(a_group && (l_conn = s_db_sqlite_get_connection(false)), NULL);
 
     const char *l_error_msg = "read below timestamp";
-    char *l_str_query = NULL;
-    size_t l_row = 0;
     dap_store_obj_t * l_ret = NULL;
-    uint64_t l_count = a_count_out && *a_count_out ? *a_count_out : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT;
-    sqlite3_stmt *l_stmt_count = NULL, *l_stmt = NULL;
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\""
-                                        " WHERE driver_key < ?", a_group);
-    char *l_query_str = sqlite3_mprintf("SELECT * FROM \"%s\""
-                                        " WHERE driver_key < ?"
-                                        " ORDER BY driver_key LIMIT '%d'", a_group, (int)l_count);
-    if (!l_query_count_str || !l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-
+    size_t l_limit = a_count_out && *a_count_out ? *a_count_out : DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT;
     dap_global_db_driver_hash_t l_hash_from = { .bets = htobe64(a_timestamp), .becrc = (uint64_t)-1 };
-    if( s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)                        != SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt_count, 1, &l_hash_from, sizeof(l_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-        s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, l_error_msg)                                    != SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt, 1, &l_hash_from, sizeof(l_hash_from), SQLITE_STATIC, l_error_msg)       != SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg)                                                             != SQLITE_ROW )
-    {
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_READ_BELOW_TS);
+    if ( !l_stmt
+        || s_db_sqlite_bind_blob64(l_stmt, 1, &l_hash_from, sizeof(l_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || sqlite3_bind_int64(l_stmt, 2, (sqlite3_int64)l_limit) != SQLITE_OK )
         goto clean_and_ret;
-    }
-// memory alloc
-    uint64_t l_count_int = dap_min(l_count, (uint64_t)sqlite3_column_int64(l_stmt_count, 0));
-    if (!l_count_int) {
-        log_it(L_INFO, "There are no records satisfying the conditional read request");
-        goto clean_and_ret;
-    }
-    if (!( l_ret = DAP_NEW_Z_COUNT(dap_store_obj_t, l_count_int) )) {
-        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
-        goto clean_and_ret;
-    }
-// data forming
-    size_t l_count_out = 0;
-    int rc;
-    for ( rc = 0; SQLITE_ROW == ( rc = s_db_sqlite_fill_one_item(a_group, l_ret + l_count_out, l_stmt) ) && l_count_out < l_count; ++l_count_out ) {};
-    if ( rc != SQLITE_DONE )
-        log_it(L_ERROR, "SQLite conditional read error %d(%s)", sqlite3_errcode(l_conn->conn), sqlite3_errmsg(l_conn->conn));
-    if (a_count_out)
-        *a_count_out = l_count_out;
+    l_ret = s_db_sqlite_fill_items(a_group, l_stmt, l_limit, a_count_out, l_error_msg);
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 2, l_query_str, l_query_count_str, l_stmt, l_stmt_count);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -865,15 +876,9 @@ static dap_list_t *s_db_sqlite_get_groups_by_mask(const char *a_group_mask)
     const char *l_error_msg = "get groups";
     dap_list_t* l_ret = NULL;
     sqlite3_stmt *l_stmt = NULL;
-    char *l_query_str = sqlite3_mprintf("SELECT name FROM sqlite_master WHERE type ='table' AND name NOT LIKE 'sqlite_%c'", '%');
-    if (!l_query_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
+    if ( s_db_sqlite_prepare(l_conn->conn, "SELECT name FROM sqlite_master WHERE type ='table' AND name NOT LIKE 'sqlite_%'",
+                             &l_stmt, 0, l_error_msg) != SQLITE_OK )
         goto clean_and_ret;
-    }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_str, &l_stmt, l_error_msg)!= SQLITE_OK) {
-        goto clean_and_ret;
-    }
     int rc = 0;
     while ( SQLITE_ROW == ( rc = s_db_sqlite_step(l_stmt, l_error_msg) ) && sqlite3_column_type(l_stmt, 0) == SQLITE_TEXT ) {
         const char *l_table_name = (const char*)sqlite3_column_text(l_stmt, 0);
@@ -883,7 +888,8 @@ static dap_list_t *s_db_sqlite_get_groups_by_mask(const char *a_group_mask)
     if ( rc != SQLITE_DONE )
         log_it(L_ERROR, "SQLite read error %d(%s)", sqlite3_errcode(l_conn->conn), sqlite3_errmsg(l_conn->conn));
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 1, l_query_str, l_stmt);
+    sqlite3_finalize(l_stmt);
+    s_db_sqlite_free_connection(l_conn, false);
     return l_ret;
 }
 
@@ -902,28 +908,161 @@ static size_t s_db_sqlite_read_count_store(const char *a_group, dap_global_db_dr
 // preparing
     const char *l_error_msg = "count read";
     size_t l_ret = 0;
-    sqlite3_stmt *l_stmt_count = NULL;
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\" "
-                                        " WHERE driver_key > ? AND (flags & '%d' %s 0)",
-                                        a_group, DAP_GLOBAL_DB_RECORD_DEL,
-                                        a_with_holes ? ">=" : "=");
-    if (!l_query_count_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
+    sqlite3_stmt *l_stmt_count = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_COUNT);
+    if ( !l_stmt_count
+        || s_db_sqlite_bind_blob64(l_stmt_count, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || sqlite3_bind_int(l_stmt_count, 2, a_with_holes) != SQLITE_OK
+        || s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW )
+        goto clean_and_ret;
+    l_ret = sqlite3_column_int64(l_stmt_count, 0);
+clean_and_ret:
+    s_db_sqlite_clean(l_conn, l_stmt_count);
+    return l_ret;
+}
+
+/**
+ * @brief Erases records in the range of driver keys (a_hash_from, a_hash_to) without reading them.
+ * @param a_group a group name string
+ * @param a_hash_from pointer to a driver key to start after, on return - a last examined key
+ * @param a_hash_to a driver key to stop before
+ * @param a_holes_only if true - erase only records marked as deleted
+ * @param a_count pointer to a max number of records to examine, on return - a number of erased records
+ * @return DAP_GLOBAL_DB_RC_SUCCESS if range is finished, DAP_GLOBAL_DB_RC_PROGRESS if limit is reached, DAP_GLOBAL_DB_RC_ERROR on error
+ */
+static int s_db_sqlite_erase_range(const char *a_group, dap_global_db_driver_hash_t *a_hash_from, dap_global_db_driver_hash_t a_hash_to,
+                                   bool a_holes_only, size_t *a_count)
+{
+// sanity check
+    conn_list_item_t *l_conn = NULL;
+    dap_return_val_if_pass(!a_group || !a_hash_from || !a_count || !(l_conn = s_db_sqlite_get_connection(false)), DAP_GLOBAL_DB_RC_ERROR);
+// preparing
+    const char *l_error_msg = "erase range";
+    int l_ret = DAP_GLOBAL_DB_RC_ERROR;
+    size_t l_limit = *a_count ? *a_count : DAP_GLOBAL_DB_COND_READ_KEYS_DEFAULT;
+    sqlite3_stmt *l_stmt_erase = NULL, *l_stmt_bound = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_ERASE_BOUND);
+    if (!l_stmt_bound) {
+        // group table not exists, nothing to erase
+        *a_count = 0;
+        l_ret = DAP_GLOBAL_DB_RC_SUCCESS;
         goto clean_and_ret;
     }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt_count, 1, &a_hash_from, sizeof(a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW)
-    {
+    if ( s_db_sqlite_bind_blob64(l_stmt_bound, 1, a_hash_from, sizeof(*a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || s_db_sqlite_bind_blob64(l_stmt_bound, 2, &a_hash_to, sizeof(a_hash_to), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || sqlite3_bind_int64(l_stmt_bound, 3, l_limit) != SQLITE_OK
+        || s_db_sqlite_step(l_stmt_bound, l_error_msg) != SQLITE_ROW )
+        goto clean_and_ret;
+    size_t l_examined = sqlite3_column_int64(l_stmt_bound, 1);
+    if (!l_examined) {
+        *a_count = 0;
+        l_ret = DAP_GLOBAL_DB_RC_SUCCESS;
         goto clean_and_ret;
     }
-    l_ret = sqlite3_column_int64(l_stmt_count, 0);
+    dap_global_db_driver_hash_t l_hash_last = { };
+    if (sqlite3_column_bytes(l_stmt_bound, 0) != sizeof(l_hash_last))
+        goto clean_and_ret;
+    memcpy(&l_hash_last, sqlite3_column_blob(l_stmt_bound, 0), sizeof(l_hash_last));
+// erasing, range is bounded by the last examined key, so only those records are affected
+    if ( !(l_stmt_erase = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_ERASE_RANGE))
+        || s_db_sqlite_bind_blob64(l_stmt_erase, 1, a_hash_from, sizeof(*a_hash_from), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || s_db_sqlite_bind_blob64(l_stmt_erase, 2, &l_hash_last, sizeof(l_hash_last), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || sqlite3_bind_int(l_stmt_erase, 3, a_holes_only) != SQLITE_OK
+        || s_db_sqlite_step(l_stmt_erase, l_error_msg) != SQLITE_DONE )
+        goto clean_and_ret;
+    *a_count = sqlite3_changes(l_conn->conn);
+    *a_hash_from = l_hash_last;
+    l_ret = l_examined < l_limit ? DAP_GLOBAL_DB_RC_SUCCESS : DAP_GLOBAL_DB_RC_PROGRESS;
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 1, l_query_count_str, l_stmt_count);
+    if (l_stmt_bound) {
+        sqlite3_reset(l_stmt_bound);
+        sqlite3_clear_bindings(l_stmt_bound);
+    }
+    s_db_sqlite_clean(l_conn, l_stmt_erase);
     return l_ret;
 }
 
+/**
+ * @brief Opens an iterator over a group. It uses a dedicated connection with a read transaction,
+ * so in WAL mode the group snapshot is stable for the whole iteration and writers aren't blocked.
+ * @param a_group a group name string
+ * @param a_with_holes if true - iterate any records, if false - only actual records
+ * @return If successful, a pointer to the iterator, otherwise NULL.
+ */
+static void *s_db_sqlite_cursor_open(const char *a_group, bool a_with_holes)
+{
+// sanity check
+    dap_return_val_if_pass_err(!s_db_inited, NULL, "SQLite driver not inited");
+    dap_return_val_if_pass(!a_group, NULL);
+// preparing
+    sqlite_cursor_t *l_cursor = DAP_NEW_Z_RET_VAL_IF_FAIL(sqlite_cursor_t, NULL);
+    char *l_error_message = NULL, *l_query = NULL;
+    if ( !(l_cursor->group = dap_strdup(a_group)) ) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        goto clean_and_ret;
+    }
+    if ( !(l_cursor->conn = s_db_sqlite_open(s_filename_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, &l_error_message)) ) {
+        log_it(L_ERROR, "Can't open sqlite cursor connection: \"%s\"", l_error_message ? l_error_message : "UNKNOWN");
+        goto clean_and_ret;
+    }
+// snapshot is taken by the first read in transaction
+    if ( s_db_sqlite_exec(l_cursor->conn, "BEGIN") || s_db_sqlite_exec(l_cursor->conn, "SELECT COUNT(*) FROM sqlite_master") )
+        goto clean_and_ret;
+    if ( !(l_query = sqlite3_mprintf(s_stmt_templates[DAP_SQLITE_STMT_READ_ALL], a_group, DAP_GLOBAL_DB_RECORD_DEL)) ) {
+        log_it(L_ERROR, "Error in SQL request forming");
+        goto clean_and_ret;
+    }
+    if ( s_db_sqlite_prepare(l_cursor->conn, l_query, &l_cursor->stmt, 0, "cursor open") != SQLITE_OK
+        || sqlite3_bind_int(l_cursor->stmt, 1, a_with_holes) != SQLITE_OK
+        || sqlite3_bind_int64(l_cursor->stmt, 2, -1) != SQLITE_OK )
+        goto clean_and_ret;
+    sqlite3_free(l_query);
+    return l_cursor;
+clean_and_ret:
+    sqlite3_free(l_query);
+    sqlite3_free(l_error_message);
+    sqlite3_finalize(l_cursor->stmt);
+    sqlite3_close(l_cursor->conn);
+    DAP_DEL_MULTY(l_cursor->group, l_cursor);
+    return NULL;
+}
+
+/**
+ * @brief Retrieves next batch of records from the iterator.
+ * @param a_cursor an iterator
+ * @param a_count[in] a maximum number of records to be returned
+ * @param a_count[out] a number of returned records
+ * @return If successful, a pointer to the objects array, NULL if there are no more records.
+ */
+static dap_store_obj_t *s_db_sqlite_cursor_next(void *a_cursor, size_t *a_count)
+{
+// sanity check
+    dap_return_val_if_pass(!a_cursor || !a_count || !*a_count, NULL);
+// func work
+    sqlite_cursor_t *l_cursor = a_cursor;
+    size_t l_limit = *a_count;
+    *a_count = 0;
+    if (l_cursor->finished)
+        return NULL;
+    dap_store_obj_t *l_ret = s_db_sqlite_fill_items(l_cursor->group, l_cursor->stmt, l_limit, a_count, "cursor next");
+    l_cursor->finished = *a_count < l_limit;
+    return l_ret;
+}
+
+/**
+ * @brief Releases the iterator, its read transaction and connection.
+ * @param a_cursor an iterator
+ */
+static void s_db_sqlite_cursor_close(void *a_cursor)
+{
+// sanity check
+    dap_return_if_pass(!a_cursor);
+// func work
+    sqlite_cursor_t *l_cursor = a_cursor;
+    sqlite3_finalize(l_cursor->stmt);
+    s_db_sqlite_exec(l_cursor->conn, "ROLLBACK");
+    sqlite3_close(l_cursor->conn);
+    DAP_DEL_MULTY(l_cursor->group, l_cursor);
+}
+
 /**
  * @brief Checks if an object is in a database by hash.
  * @param a_group a group name string
@@ -938,24 +1077,14 @@ static bool s_db_sqlite_is_hash(const char *a_group, dap_global_db_driver_hash_t
 // preparing
     const char *l_error_msg = "is hash read";
     bool l_ret = false;
-    sqlite3_stmt *l_stmt_count = NULL;
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\" "
-                                        " WHERE driver_key = ?",
-                                        a_group);
-    if (!l_query_count_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_bind_blob64(l_stmt_count, 1, &a_hash, sizeof(a_hash), SQLITE_STATIC, l_error_msg) != SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW)
-    {
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_IS_HASH);
+    if ( !l_stmt
+        || s_db_sqlite_bind_blob64(l_stmt, 1, &a_hash, sizeof(a_hash), SQLITE_STATIC, l_error_msg) != SQLITE_OK
+        || s_db_sqlite_step(l_stmt, l_error_msg) != SQLITE_ROW )
         goto clean_and_ret;
-    }
-    l_ret = (bool)sqlite3_column_int64(l_stmt_count, 0);
+    l_ret = (bool)sqlite3_column_int64(l_stmt, 0);
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 1, l_query_count_str, l_stmt_count);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -973,23 +1102,14 @@ static bool s_db_sqlite_is_obj(const char *a_group, const char *a_key)
 // preparing
     const char *l_error_msg = "is obj read";
     bool l_ret = false;
-    sqlite3_stmt *l_stmt_count = NULL;
-    char *l_query_count_str = sqlite3_mprintf("SELECT COUNT(*) FROM \"%s\" "
-                                        " WHERE key = '%s'",
-                                        a_group, a_key);
-    if (!l_query_count_str) {
-        log_it(L_ERROR, "Error in SQL request forming");
-        goto clean_and_ret;
-    }
-    
-    if(s_db_sqlite_prepare(l_conn->conn, l_query_count_str, &l_stmt_count, l_error_msg)!= SQLITE_OK ||
-        s_db_sqlite_step(l_stmt_count, l_error_msg) != SQLITE_ROW)
-    {
+    sqlite3_stmt *l_stmt = s_db_sqlite_stmt_get(l_conn, a_group, DAP_SQLITE_STMT_IS_OBJ);
+    if ( !l_stmt
+        || sqlite3_bind_text(l_stmt, 1, a_key, -1, SQLITE_STATIC) != SQLITE_OK
+        || s_db_sqlite_step(l_stmt, l_error_msg) != SQLITE_ROW )
         goto clean_and_ret;
-    }
-    l_ret = (bool)sqlite3_column_int64(l_stmt_count, 0);
+    l_ret = (bool)sqlite3_column_int64(l_stmt, 0);
 clean_and_ret:
-    s_db_sqlite_clean(l_conn, 1, l_query_count_str, l_stmt_count);
+    s_db_sqlite_clean(l_conn, l_stmt);
     return l_ret;
 }
 
@@ -1006,6 +1126,7 @@ static int s_db_sqlite_flush()
 // preparing
     char *l_error_message = NULL;
     log_it(L_DEBUG, "Start flush sqlite data base.");
+    s_db_sqlite_stmt_cache_clear(l_conn);
     sqlite3_close(l_conn->conn);
     if ( !(l_conn->conn = s_db_sqlite_open(s_filename_db, SQLITE_OPEN_READWRITE, &l_error_message)) ) {
         log_it(L_ERROR, "Can't init sqlite err: \"%s\"", l_error_message ? l_error_message: "UNKNOWN");
@@ -1034,7 +1155,7 @@ static int s_db_sqlite_transaction_start()
     if ( g_dap_global_db_debug_more )
         log_it(L_DEBUG, "Start TX: @%p", l_conn->conn);
     
-    int l_ret = s_db_sqlite_exec(l_conn->conn, "BEGIN", NULL, NULL, 0, NULL);
+    int l_ret = s_db_sqlite_exec(l_conn->conn, "BEGIN");
     if ( l_ret != SQLITE_OK ) {
         s_db_sqlite_free_connection(l_conn, true);
     }
@@ -1054,9 +1175,9 @@ static int s_db_sqlite_transaction_end(bool a_commit)
         log_it(L_DEBUG, "End TX l_conn: @%p", s_conn->conn);
     int l_ret = 0;
     if (a_commit)
-        l_ret = s_db_sqlite_exec(s_conn->conn, "COMMIT", NULL, NULL, 0, NULL);
+        l_ret = s_db_sqlite_exec(s_conn->conn, "COMMIT");
     else
-        l_ret = s_db_sqlite_exec(s_conn->conn, "ROLLBACK", NULL, NULL, 0, NULL);
+        l_ret = s_db_sqlite_exec(s_conn->conn, "ROLLBACK");
     if ( l_ret == SQLITE_OK ) {
         s_db_sqlite_free_connection(s_conn, true);
     }
@@ -1117,12 +1238,18 @@ int dap_global_db_driver_sqlite_init(const char *a_filename_db, dap_global_db_dr
     a_drv_callback->read_last_store_obj          = s_db_sqlite_read_last_store_obj;
     a_drv_callback->transaction_start            = s_db_sqlite_transaction_start;
     a_drv_callback->transaction_end              = s_db_sqlite_transaction_end;
+    a_drv_callback->batch_start                  = s_db_sqlite_transaction_start;
+    a_drv_callback->batch_end                    = s_db_sqlite_transaction_end;
     a_drv_callback->get_groups_by_mask           = s_db_sqlite_get_groups_by_mask;
     a_drv_callback->read_count_store             = s_db_sqlite_read_count_store;
     a_drv_callback->is_obj                       = s_db_sqlite_is_obj;
     a_drv_callback->deinit                       = s_db_sqlite_deinit;
     a_drv_callback->flush                        = s_db_sqlite_flush;
     a_drv_callback->get_by_hash                  = s_db_sqlite_get_by_hash;
+    a_drv_callback->erase_range                  = s_db_sqlite_erase_range;
+    a_drv_callback->cursor_open                  = s_db_sqlite_cursor_open;
+    a_drv_callback->cursor_next                  = s_db_sqlite_cursor_next;
+    a_drv_callback->cursor_close                 = s_db_sqlite_cursor_close;
     a_drv_callback->read_hashes                  = s_db_sqlite_read_hashes;
     a_drv_callback->is_hash                      = s_db_sqlite_is_hash;
     s_db_inited = true;
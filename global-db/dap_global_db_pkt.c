@@ -145,6 +145,42 @@ bool dap_global_db_pkt_check_sign_crc(dap_store_obj_t *a_obj)
 
 }
 
+/// Same as dap_global_db_pkt_check_sign_crc() for objects array, signatures are verified in parallel
+bool dap_global_db_pkt_check_sign_crc_batch(dap_store_obj_t *a_objs, size_t a_count)
+{
+    dap_return_val_if_fail(a_objs && a_count, false);
+    if (a_count == 1)
+        return dap_global_db_pkt_check_sign_crc(a_objs);
+    dap_global_db_pkt_t **l_pkts = DAP_NEW_Z_COUNT_RET_VAL_IF_FAIL(dap_global_db_pkt_t *, a_count, false);
+    dap_sign_verify_item_t *l_items = DAP_NEW_Z_COUNT_RET_VAL_IF_FAIL(dap_sign_verify_item_t, a_count, false, l_pkts);
+    bool l_ret = false;
+    size_t i, l_signs_count = 0;
+    for (i = 0; i < a_count; i++) {
+        dap_global_db_pkt_t *l_pkt = l_pkts[i] = dap_global_db_pkt_serialize(a_objs + i);
+        if (!l_pkt)
+            goto clean_and_ret;
+        uint64_t l_checksum = crc64((uint8_t *)l_pkt + sizeof(uint64_t),
+                                    dap_global_db_pkt_get_size(l_pkt) - sizeof(uint64_t));
+        if (l_checksum != l_pkt->crc)
+            goto clean_and_ret;
+        if (!a_objs[i].sign)
+            continue;
+        // Exclude sign from signed data
+        l_pkt->data_len = l_pkt->group_len + l_pkt->key_len + l_pkt->value_len;
+        l_items[l_signs_count++] = (dap_sign_verify_item_t) {
+            .sign = (dap_sign_t *)(l_pkt->data + l_pkt->data_len),
+            .data = (uint8_t *)l_pkt + sizeof(uint64_t),
+            .data_size = dap_global_db_pkt_get_size(l_pkt) - sizeof(uint64_t)
+        };
+    }
+    l_ret = !dap_sign_verify_batch(l_items, l_signs_count);
+clean_and_ret:
+    for (i = 0; i < a_count; i++)
+        DAP_DELETE(l_pkts[i]);
+    DAP_DEL_MULTY(l_items, l_pkts);
+    return l_ret;
+}
+
 static byte_t *s_fill_one_store_obj(dap_global_db_pkt_t *a_pkt, dap_store_obj_t *a_obj, size_t a_bound_size, dap_stream_node_addr_t *a_addr)
 {
     if (sizeof(dap_global_db_pkt_t) > a_bound_size ||            /* Check for buffer boundaries */
@@ -102,6 +102,18 @@ typedef bool (*dap_global_db_callback_results_raw_t) (dap_global_db_instance_t *
                                                       int a_rc, const char *a_group,
                                                       const size_t a_values_current, const size_t a_values_count,
                                                       dap_store_obj_t *a_values, void *a_arg);
+/**
+ *  @brief callback for write batch commit
+ *  @arg a_rc DAP_GLOBAL_DB_RC_SUCCESS if all operations are applied, others if nothing is applied
+ *  @arg a_ops_count Number of operations in the batch
+ *  @arg a_arg Custom argument
+ *  @return none.
+ */
+typedef void (*dap_global_db_callback_batch_t)(dap_global_db_instance_t *a_dbi, int a_rc, size_t a_ops_count, void *a_arg);
+
+// Write batch: sets, pins and deletes across groups applied all-or-nothing in one driver transaction
+typedef struct dap_global_db_batch dap_global_db_batch_t;
+
 // Return codes
 #define DAP_GLOBAL_DB_RC_SUCCESS     0
 #define DAP_GLOBAL_DB_RC_NOT_FOUND   1
@@ -162,6 +174,12 @@ byte_t *dap_global_db_get_last_sync(const char *a_group, char **a_key, size_t *a
 dap_store_obj_t *dap_global_db_get_last_raw_sync(const char *a_group);
 dap_global_db_obj_t *dap_global_db_get_all_sync(const char *a_group, size_t *a_objs_count);
 dap_store_obj_t *dap_global_db_get_all_raw_sync(const char *a_group, size_t *a_objs_count);
+// Group iteration by batches over a stable snapshot, with memory bounded by the batch size
+typedef dap_global_db_driver_cursor_t dap_global_db_cursor_t;
+dap_global_db_cursor_t *dap_global_db_cursor_open(const char *a_group, bool a_with_holes);
+dap_global_db_obj_t *dap_global_db_cursor_next(dap_global_db_cursor_t *a_cursor, size_t *a_objs_count);
+dap_store_obj_t *dap_global_db_cursor_next_raw(dap_global_db_cursor_t *a_cursor, size_t *a_objs_count);
+void dap_global_db_cursor_close(dap_global_db_cursor_t *a_cursor);
 
 int dap_global_db_set_sync(const char *a_group, const char *a_key, const void *a_value, const size_t a_value_length, bool a_pin_value);
 // set raw with cluster roles and rights checks
@@ -177,4 +195,27 @@ bool dap_global_db_isalnum_group_key(const dap_store_obj_t *a_obj, bool a_not_nu
 bool dap_global_db_group_match_mask(const char *a_group, const char *a_mask);
 
 int dap_global_db_erase_table_sync(const char *a_group);
-int dap_global_db_erase_table(const char *a_group, dap_global_db_callback_result_t a_callback, void *a_arg);
\ No newline at end of file
+int dap_global_db_erase_table(const char *a_group, dap_global_db_callback_result_t a_callback, void *a_arg);
+
+// === Write batch functions ===
+dap_global_db_batch_t *dap_global_db_batch_new();
+int dap_global_db_batch_set(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key, const void *a_value, const size_t a_value_length, bool a_pin_value);
+int dap_global_db_batch_pin(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key);
+int dap_global_db_batch_unpin(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key);
+int dap_global_db_batch_del(dap_global_db_batch_t *a_batch, const char *a_group, const char *a_key);
+size_t dap_global_db_batch_count(dap_global_db_batch_t *a_batch);
+void dap_global_db_batch_delete(dap_global_db_batch_t *a_batch);
+int dap_global_db_batch_commit_sync(dap_global_db_batch_t *a_batch);
+// Batch is consumed regardless of the result
+int dap_global_db_batch_commit(dap_global_db_batch_t *a_batch, dap_global_db_callback_batch_t a_callback, void *a_arg);
+
+#ifdef DAP_SDK_TESTS
+/**
+ *  @brief callback for write batch check before the commit, it's called in the batch transaction
+ *  @arg a_ops_count Number of operations in the batch
+ *  @arg a_arg Custom argument
+ *  @return false to roll the batch back
+ */
+typedef bool (*dap_global_db_callback_batch_check_t)(dap_global_db_instance_t *a_dbi, size_t a_ops_count, void *a_arg);
+void dap_global_db_batch_set_check(dap_global_db_batch_t *a_batch, dap_global_db_callback_batch_check_t a_callback, void *a_arg);
+#endif
@@ -140,6 +140,11 @@ typedef dap_list_t* (*dap_global_db_driver_get_groups_callback_t)(const char *a_
 typedef bool (*dap_global_db_driver_is_obj_callback_t)(const char *a_group, const char *a_key);
 typedef bool (*dap_global_db_driver_is_hash_callback_t)(const char *a_group, dap_global_db_driver_hash_t a_hash);
 typedef dap_global_db_pkt_pack_t * (*dap_global_db_driver_get_by_hash_callback_t)(const char *a_group, dap_global_db_driver_hash_t *a_hash, size_t a_count);
+typedef int (*dap_global_db_driver_erase_range_callback_t)(const char *a_group, dap_global_db_driver_hash_t *a_hash_from, dap_global_db_driver_hash_t a_hash_to,
+                                                           bool a_holes_only, size_t *a_count);
+typedef void* (*dap_global_db_driver_cursor_open_callback_t)(const char *a_group, bool a_with_holes);
+typedef dap_store_obj_t* (*dap_global_db_driver_cursor_next_callback_t)(void *a_cursor, size_t *a_count);
+typedef void (*dap_global_db_driver_cursor_close_callback_t)(void *a_cursor);
 typedef int (*dap_global_db_driver_txn_start_callback_t)(void);
 typedef int (*dap_global_db_driver_txn_end_callback_t)(bool);
 typedef int (*dap_global_db_driver_callback_t)(void);
@@ -161,9 +166,17 @@ typedef struct dap_global_db_driver_callbacks {
     dap_global_db_driver_is_hash_callback_t    is_hash;                            /* Check for existence of a record in the table/group for
                                                                               a given driver hash */
     dap_global_db_driver_get_by_hash_callback_t get_by_hash;                       /* Retrieve a record from the table/group for a given driver hash */
+    dap_global_db_driver_erase_range_callback_t erase_range;                       /* Erase unpinned records from the range of driver hashes w/o reading them */
+
+    dap_global_db_driver_cursor_open_callback_t  cursor_open;                      /* Open a group iterator over the read snapshot of DB */
+    dap_global_db_driver_cursor_next_callback_t  cursor_next;                      /* Retrieve next batch of 'store objects' from the snapshot */
+    dap_global_db_driver_cursor_close_callback_t cursor_close;                     /* Release the iterator and its snapshot */
 
     dap_global_db_driver_txn_start_callback_t  transaction_start;                  /* Allocate DB context for consequtive operations */
     dap_global_db_driver_txn_end_callback_t    transaction_end;                    /* Release DB context at end of DB consequtive operations */
+    dap_global_db_driver_txn_start_callback_t  batch_start;                        /* Begin the write batch transaction, NULL if the driver
+                                                                              can't roll it back */
+    dap_global_db_driver_txn_end_callback_t    batch_end;                          /* Commit or roll back the write batch transaction */
 
     dap_global_db_driver_callback_t            deinit;
     dap_global_db_driver_callback_t            flush;
@@ -190,7 +203,14 @@ dap_global_db_pkt_pack_t *dap_global_db_driver_get_by_hash(const char *a_group,
 bool dap_global_db_driver_is(const char *a_group, const char *a_key);
 bool dap_global_db_driver_is_hash(const char *a_group, dap_global_db_driver_hash_t a_hash);
 size_t dap_global_db_driver_count(const char *a_group, dap_global_db_driver_hash_t a_hash_from, bool a_with_holes);
+int dap_global_db_driver_erase_range(const char *a_group, dap_global_db_driver_hash_t *a_hash_from, dap_global_db_driver_hash_t a_hash_to,
+                                     bool a_holes_only, size_t *a_count);
 dap_list_t *dap_global_db_driver_get_groups_by_mask(const char *a_group_mask);
+typedef struct dap_global_db_driver_cursor dap_global_db_driver_cursor_t;
+dap_global_db_driver_cursor_t *dap_global_db_driver_cursor_open(const char *a_group, bool a_with_holes);
+dap_store_obj_t *dap_global_db_driver_cursor_next(dap_global_db_driver_cursor_t *a_cursor, size_t *a_count);
+void dap_global_db_driver_cursor_close(dap_global_db_driver_cursor_t *a_cursor);
 dap_global_db_hash_pkt_t *dap_global_db_driver_hashes_read(const char *a_group, dap_global_db_driver_hash_t a_hash_from);
 int dap_global_db_driver_txn_start();
+int dap_global_db_driver_batch_start();
 int dap_global_db_driver_txn_end(bool a_commit);
@@ -97,4 +97,5 @@ DAP_STATIC_INLINE uint64_t dap_store_obj_checksum(dap_store_obj_t *a_obj)
 }
 
 bool dap_global_db_pkt_check_sign_crc(dap_store_obj_t *a_obj);
+bool dap_global_db_pkt_check_sign_crc_batch(dap_store_obj_t *a_objs, size_t a_count);
 void *dap_gossip_pkt_read(dap_hash_fast_t *a_route, size_t *a_route_len);
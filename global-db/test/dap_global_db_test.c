@@ -1,6 +1,8 @@
 #include <time.h>
 #include <unistd.h>
 #include <stdatomic.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 #include "dap_common.h"
 #include "dap_strfuncs.h"
@@ -13,10 +15,15 @@
 #include "dap_global_db_driver.h"
 #include "dap_test.h"
 #include "dap_global_db_pkt.h"
+#include "dap_global_db_cluster.h"
+#include "dap_cert.h"
+#include "dap_enc_ks.h"
+#include "dap_stream.h"
 
 #define LOG_TAG "dap_globaldb_test"
 
 #define DB_FILE "./base.tmp"
+#define DB_BATCH_DIR "./batch.tmp"
 
 static const char *s_db_types[] = {
 #ifdef DAP_CHAIN_GDB_ENGINE_CUTTDB
@@ -78,9 +85,15 @@ typedef struct __dap_test_record__ {
 #define DAP_DB$T_GROUP_PREF                  "group.zero."
 #define DAP_DB$T_GROUP_WRONG_PREF            "group.wrong."
 #define DAP_DB$T_GROUP_NOT_EXISTED_PREF      "group.not.existed."
+#define DAP_DB$T_GROUP_BENCH_PREF            "group.bench."
+#define DAP_DB$T_GROUP_TXN_PREF              "local.txn."
+#define DAP_DB$SZ_BENCH_VALUE                256
+#define DAP_DB$SZ_CURSOR_VALUE               2048
+#define DAP_DB$SZ_CURSOR_RSS_KB              8192
 static char s_group[64] = {};
 static char s_group_wrong[64] = {};
 static char s_group_not_existed[64] = {};
+static char s_group_bench[64] = {};
 
 
 static int s_test_create_db(const char *db_type)
@@ -691,6 +704,487 @@ static void s_test_tx_start_end(size_t a_count, bool a_missing_allow)
     dap_pass_msg("tx_start tx_end check");
 }
 
+typedef struct bench_read_arg {
+    size_t count;
+    dap_nanotime_t ts;
+    unsigned seed;
+} bench_read_arg_t;
+
+static void *s_test_bench_read_thread(void *a_arg)
+{
+    bench_read_arg_t *l_arg = a_arg;
+    char l_key[64] = { 0 };
+    for (size_t i = 0; i < l_arg->count; ++i) {
+        size_t l_idx = rand_r(&l_arg->seed) % l_arg->count;
+        dap_global_db_driver_hash_t l_hash = { .bets = htobe64(l_arg->ts + l_idx), .becrc = htobe64(l_idx + 1) };
+        dap_assert_PIF(dap_global_db_driver_is_hash(s_group_bench, l_hash), "Bench concurrent is_hash");
+        if (i % 4)
+            continue;
+        snprintf(l_key, sizeof(l_key), "BENCH$%08zx", l_idx);
+        dap_store_obj_t *l_obj = dap_global_db_driver_read(s_group_bench, l_key, NULL, true);
+        dap_assert_PIF(l_obj && l_obj->value_len == DAP_DB$SZ_BENCH_VALUE, "Bench concurrent read record");
+        dap_store_obj_free_one(l_obj);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Concurrent point reads of the benchmark group, shows how the driver scales
+ * with readers count (group lookup and read transactions are on this path)
+ */
+static void s_test_bench_read_threads(size_t a_count, dap_nanotime_t a_ts)
+{
+    static const uint32_t s_threads_counts[] = { 1, 2, 4, 8 };
+    pthread_t l_threads[8];
+    bench_read_arg_t l_args[8];
+    for (size_t n = 0; n < sizeof(s_threads_counts) / sizeof(*s_threads_counts); ++n) {
+        uint32_t l_thread_count = s_threads_counts[n];
+        uint64_t l_time = get_cur_time_nsec();
+        for (uint32_t i = 0; i < l_thread_count; ++i) {
+            l_args[i] = (bench_read_arg_t) { .count = a_count, .ts = a_ts, .seed = i + 1 };
+            pthread_create(l_threads + i, NULL, s_test_bench_read_thread, l_args + i);
+        }
+        for (uint32_t i = 0; i < l_thread_count; ++i)
+            pthread_join(l_threads[i], NULL);
+        l_time = get_cur_time_nsec() - l_time;
+        char l_msg[64];
+        snprintf(l_msg, sizeof(l_msg), "Driver concurrent reads, %u threads", l_thread_count);
+        benchmark_mgs_rate(l_msg, (float)a_count * l_thread_count * 1000000000 / dap_max(l_time, (uint64_t)1));
+    }
+}
+
+/**
+ * @brief Driver level throughput of the hot paths: single writes, point reads,
+ * existence checks and paged conditional reads over a separate group
+ */
+static void s_test_bench_throughput(size_t a_count)
+{
+    dap_test_msg("Start driver throughput benchmark on %zu records ...", a_count);
+    dap_store_obj_t l_store_obj = { .group = s_group_bench, .value_len = DAP_DB$SZ_BENCH_VALUE };
+    char l_key[64] = { 0 };
+    byte_t l_value[DAP_DB$SZ_BENCH_VALUE];
+    l_store_obj.key = l_key;
+    l_store_obj.value = l_value;
+    dap_nanotime_t l_ts = dap_nanotime_now();
+
+    uint64_t l_time = get_cur_time_nsec();
+    for (size_t i = 0; i < a_count; ++i) {
+        snprintf(l_key, sizeof(l_key), "BENCH$%08zx", i);
+        memset(l_value, (int)i, sizeof(l_value));
+        l_store_obj.timestamp = l_ts + i;
+        l_store_obj.crc = i + 1;
+        dap_assert_PIF(!dap_global_db_driver_add(&l_store_obj, 1), "Bench write record to DB");
+    }
+    uint64_t l_write = get_cur_time_nsec() - l_time;
+
+    l_time = get_cur_time_nsec();
+    for (size_t i = 0; i < a_count; ++i) {
+        snprintf(l_key, sizeof(l_key), "BENCH$%08zx", i);
+        dap_store_obj_t *l_obj = dap_global_db_driver_read(s_group_bench, l_key, NULL, true);
+        dap_assert_PIF(l_obj && l_obj->value_len == DAP_DB$SZ_BENCH_VALUE, "Bench read record from DB");
+        dap_store_obj_free_one(l_obj);
+    }
+    uint64_t l_read = get_cur_time_nsec() - l_time;
+
+    l_time = get_cur_time_nsec();
+    for (size_t i = 0; i < a_count; ++i) {
+        snprintf(l_key, sizeof(l_key), "BENCH$%08zx", i);
+        dap_assert_PIF(dap_global_db_driver_is(s_group_bench, l_key), "Bench is_obj");
+    }
+    uint64_t l_is_obj = get_cur_time_nsec() - l_time;
+
+    size_t l_pages = 0, l_total = 0;
+    l_time = get_cur_time_nsec();
+    dap_global_db_driver_hash_t l_driver_key = { };
+    for (size_t l_count = DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT / 4; ; l_count = DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT / 4) {
+        dap_store_obj_t *l_objs = dap_global_db_driver_cond_read(s_group_bench, l_driver_key, &l_count, true);
+        if (!l_objs)
+            break;
+        ++l_pages;
+        l_driver_key = dap_global_db_driver_hash_get(l_objs + l_count - 1);
+        dap_store_obj_free(l_objs, l_count);
+        l_total += l_count - dap_global_db_driver_hash_is_blank(&l_driver_key);
+        if (dap_global_db_driver_hash_is_blank(&l_driver_key))
+            break;
+    }
+    uint64_t l_cond_read = get_cur_time_nsec() - l_time;
+    dap_assert_PIF(l_total == a_count, "Bench cond read total count");
+
+    benchmark_mgs_rate("Driver writes", (float)a_count * 1000000000 / dap_max(l_write, (uint64_t)1));
+    benchmark_mgs_rate("Driver point reads", (float)a_count * 1000000000 / dap_max(l_read, (uint64_t)1));
+    benchmark_mgs_rate("Driver is_obj", (float)a_count * 1000000000 / dap_max(l_is_obj, (uint64_t)1));
+    benchmark_mgs_rate("Driver cond read pages", (float)l_pages * 1000000000 / dap_max(l_cond_read, (uint64_t)1));
+    s_test_bench_read_threads(a_count, l_ts);
+
+    dap_store_obj_t l_erase_table_obj = {
+        .group = s_group_bench,
+        .flags = DAP_GLOBAL_DB_RECORD_NEW | DAP_GLOBAL_DB_RECORD_ERASE,
+        .timestamp = dap_nanotime_now()
+    };
+    dap_global_db_driver_apply(&l_erase_table_obj, 1);
+    dap_pass_msg("driver throughput benchmark");
+}
+
+/**
+ * @brief Fills bench group with a_expired records older than an hour (each DAP_DB$SZ_HOLES one is a hole),
+ * one pinned old record and a_live fresh records, then erases expired ones by driver key ranges
+ * @return count of erase range driver calls
+ */
+static size_t s_test_expire_pass(size_t a_expired, size_t a_live, uint64_t *a_time)
+{
+    dap_store_obj_t l_store_obj = { .group = s_group_bench, .value_len = DAP_DB$SZ_BENCH_VALUE };
+    char l_key[64] = { 0 };
+    byte_t l_value[DAP_DB$SZ_BENCH_VALUE] = { 0 };
+    l_store_obj.key = l_key;
+    l_store_obj.value = l_value;
+    dap_nanotime_t l_now = dap_nanotime_now(), l_hour = dap_nanotime_from_sec(3600);
+    size_t l_holes = 0;
+    for (size_t i = 0; i <= a_expired + a_live; ++i) {
+        snprintf(l_key, sizeof(l_key), "EXPIRE$%08zx", i);
+        if (i < a_expired) {
+            l_store_obj.timestamp = l_now - 2 * l_hour + i;
+            l_store_obj.flags = i % DAP_DB$SZ_HOLES ? 0 : DAP_GLOBAL_DB_RECORD_DEL;
+            l_holes += !(i % DAP_DB$SZ_HOLES);
+        } else if (i == a_expired) {
+            l_store_obj.timestamp = l_now - 2 * l_hour - 1;
+            l_store_obj.flags = DAP_GLOBAL_DB_RECORD_PINNED;
+        } else {
+            l_store_obj.timestamp = l_now - l_hour / 2 + i;
+            l_store_obj.flags = 0;
+        }
+        l_store_obj.crc = i + 1;
+        dap_assert_PIF(!dap_global_db_driver_add(&l_store_obj, 1), "Write expire test record to DB");
+    }
+    dap_global_db_driver_hash_t l_hash_to = { .bets = htobe64(l_now - l_hour) };
+    size_t l_calls = 0, l_erased_holes = 0, l_erased = 0;
+    uint64_t l_time = get_cur_time_nsec();
+    for (int l_pass = 0; l_pass < 2; ++l_pass) {
+        dap_global_db_driver_hash_t l_hash_from = { };
+        int l_rc;
+        do {
+            size_t l_count = DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT / 4;
+            l_rc = dap_global_db_driver_erase_range(s_group_bench, &l_hash_from, l_hash_to, !l_pass, &l_count);
+            dap_assert_PIF(l_rc != DAP_GLOBAL_DB_RC_ERROR, "Erase range of expired records");
+            *(l_pass ? &l_erased : &l_erased_holes) += l_count;
+            ++l_calls;
+        } while (l_rc == DAP_GLOBAL_DB_RC_PROGRESS);
+    }
+    *a_time = get_cur_time_nsec() - l_time;
+    dap_assert_PIF(l_erased_holes == l_holes, "Erased holes count");
+    dap_assert_PIF(l_erased_holes + l_erased == a_expired, "Erased expired records count");
+    snprintf(l_key, sizeof(l_key), "EXPIRE$%08zx", a_expired);
+    dap_assert_PIF(dap_global_db_driver_is(s_group_bench, l_key), "Pinned record is kept");
+    for (size_t i = a_expired + 1; i <= a_expired + a_live; ++i) {
+        snprintf(l_key, sizeof(l_key), "EXPIRE$%08zx", i);
+        dap_assert_PIF(dap_global_db_driver_is(s_group_bench, l_key), "Live record is kept");
+    }
+    dap_store_obj_t l_erase_table_obj = {
+        .group = s_group_bench,
+        .flags = DAP_GLOBAL_DB_RECORD_NEW | DAP_GLOBAL_DB_RECORD_ERASE,
+        .timestamp = dap_nanotime_now()
+    };
+    dap_global_db_driver_apply(&l_erase_table_obj, 1);
+    return l_calls;
+}
+
+/**
+ * @brief TTL expiration cost has to depend on expired records count only, not on a group size
+ */
+static void s_test_expire(size_t a_count)
+{
+    dap_test_msg("Start TTL expiration test on %zu expired records ...", a_count);
+    uint64_t l_time_small = 0, l_time_large = 0;
+    size_t l_calls_small = s_test_expire_pass(a_count, a_count, &l_time_small),
+           l_calls_large = s_test_expire_pass(a_count, a_count * 16, &l_time_large);
+    dap_assert_PIF(l_calls_small == l_calls_large, "Erase range calls count not depends on live records count");
+    char l_msg[128];
+    snprintf(l_msg, sizeof(l_msg), "Expire %zu of %zu records", a_count, a_count * 2 + 1);
+    benchmark_mgs_time(l_msg, l_time_small / 1000000);
+    snprintf(l_msg, sizeof(l_msg), "Expire %zu of %zu records", a_count, a_count * 17 + 1);
+    benchmark_mgs_time(l_msg, l_time_large / 1000000);
+    dap_pass_msg("TTL expiration");
+}
+
+/**
+ * @brief Anonymous resident memory of the process, file mappings of DB are not counted
+ */
+static size_t s_rss_anon_kb()
+{
+    FILE *l_file = fopen("/proc/self/status", "r");
+    if (!l_file)
+        return 0;
+    char l_line[128];
+    size_t l_ret = 0;
+    while (fgets(l_line, sizeof(l_line), l_file))
+        if (sscanf(l_line, "RssAnon: %zu", &l_ret) == 1)
+            break;
+    fclose(l_file);
+    return l_ret;
+}
+
+/**
+ * @brief Iterates a large group with a cursor, checks records order and count, memory usage has to be bounded
+ * by the batch size and a record written during the iteration ahead of the cursor mustn't be seen by it
+ */
+static void s_test_cursor(size_t a_count)
+{
+    dap_test_msg("Start cursor iteration test on %zu records ...", a_count);
+    dap_store_obj_t l_store_obj = { .group = s_group_bench, .value_len = DAP_DB$SZ_CURSOR_VALUE };
+    char l_key[64] = { 0 };
+    byte_t *l_value = DAP_NEW_Z_SIZE(byte_t, DAP_DB$SZ_CURSOR_VALUE);
+    dap_assert_PIF(l_value, "Allocate cursor test value");
+    l_store_obj.key = l_key;
+    l_store_obj.value = l_value;
+    dap_nanotime_t l_ts = dap_nanotime_now();
+    for (size_t i = 0; i < a_count; ++i) {
+        snprintf(l_key, sizeof(l_key), "CURSOR$%08zx", i);
+        memset(l_value, (int)i, DAP_DB$SZ_CURSOR_VALUE);
+        l_store_obj.timestamp = l_ts + i;
+        l_store_obj.crc = i + 1;
+        l_store_obj.flags = i % DAP_DB$SZ_HOLES ? 0 : DAP_GLOBAL_DB_RECORD_DEL;
+        dap_assert_PIF(!dap_global_db_driver_add(&l_store_obj, 1), "Write cursor test record to DB");
+    }
+
+    dap_global_db_driver_cursor_t *l_cursor = dap_global_db_driver_cursor_open(s_group_bench, true);
+    dap_assert_PIF(l_cursor, "Open cursor");
+    size_t l_total = 0, l_rss_start = 0, l_rss_max = 0;
+    dap_global_db_driver_hash_t l_prev = { };
+    uint64_t l_time = get_cur_time_nsec();
+    for (size_t l_count = 0; ; l_count = 0) {
+        dap_store_obj_t *l_objs = dap_global_db_driver_cursor_next(l_cursor, &l_count);
+        if (!l_objs)
+            break;
+        dap_assert_PIF(l_count && l_count <= DAP_GLOBAL_DB_COND_READ_COUNT_DEFAULT, "Cursor batch size");
+        for (size_t i = 0; i < l_count; ++i) {
+            dap_global_db_driver_hash_t l_cur = dap_global_db_driver_hash_get(l_objs + i);
+            dap_assert_PIF(dap_global_db_driver_hash_compare(&l_prev, &l_cur) < 0, "Cursor records order");
+            dap_assert_PIF(l_objs[i].value_len == DAP_DB$SZ_CURSOR_VALUE && l_objs[i].value[0] == (byte_t)(l_total + i), "Cursor record value");
+            dap_assert_PIF(strcmp(l_objs[i].key, "CURSOR$NEW"), "Cursor snapshot is isolated from later writes");
+            l_prev = l_cur;
+        }
+        l_total += l_count;
+        dap_store_obj_free(l_objs, l_count);
+        if (l_total == l_count) {
+            // Write after the first batch, the record is ahead of the cursor position, so it's seen without snapshot
+            snprintf(l_key, sizeof(l_key), "CURSOR$NEW");
+            l_store_obj.timestamp = l_ts + a_count;
+            l_store_obj.crc = a_count + 1;
+            l_store_obj.flags = 0;
+            dap_assert_PIF(!dap_global_db_driver_add(&l_store_obj, 1), "Write record during iteration");
+            l_rss_start = l_rss_max = s_rss_anon_kb();
+        } else
+            l_rss_max = dap_max(l_rss_max, s_rss_anon_kb());
+    }
+    l_time = get_cur_time_nsec() - l_time;
+    dap_global_db_driver_cursor_close(l_cursor);
+    dap_assert_PIF(l_total == a_count, "Cursor iterated all records");
+    dap_assert_PIF(dap_global_db_driver_is(s_group_bench, "CURSOR$NEW"), "Record written during iteration is stored");
+    dap_assert_PIF(l_rss_max - l_rss_start < DAP_DB$SZ_CURSOR_RSS_KB, "Cursor memory usage is bounded");
+
+    l_cursor = dap_global_db_driver_cursor_open(s_group_bench, false);
+    dap_assert_PIF(l_cursor, "Open cursor without holes");
+    l_total = 0;
+    for (size_t l_count = 0; ; l_count = 0) {
+        dap_store_obj_t *l_objs = dap_global_db_driver_cursor_next(l_cursor, &l_count);
+        if (!l_objs)
+            break;
+        for (size_t i = 0; i < l_count; ++i)
+            dap_assert_PIF(!(l_objs[i].flags & DAP_GLOBAL_DB_RECORD_DEL), "Cursor skips holes");
+        l_total += l_count;
+        dap_store_obj_free(l_objs, l_count);
+    }
+    dap_global_db_driver_cursor_close(l_cursor);
+    dap_assert_PIF(l_total == a_count - (a_count + DAP_DB$SZ_HOLES - 1) / DAP_DB$SZ_HOLES + 1, "Cursor iterated all actual records");
+
+    char l_msg[128];
+    snprintf(l_msg, sizeof(l_msg), "Cursor iteration, anonymous RSS grown by %zu Kb", l_rss_max - l_rss_start);
+    benchmark_mgs_rate(l_msg, (float)a_count * 1000000000 / dap_max(l_time, (uint64_t)1));
+    dap_store_obj_t l_erase_table_obj = {
+        .group = s_group_bench,
+        .flags = DAP_GLOBAL_DB_RECORD_NEW | DAP_GLOBAL_DB_RECORD_ERASE,
+        .timestamp = dap_nanotime_now()
+    };
+    dap_global_db_driver_apply(&l_erase_table_obj, 1);
+    DAP_DELETE(l_value);
+    dap_pass_msg("cursor iteration");
+}
+
+enum txn_stage {
+    TXN_CRASH_BEFORE_COMMIT,
+    TXN_ROLLBACK,
+    TXN_COMMIT
+};
+
+static const char *s_txn_groups[2] = { DAP_DB$T_GROUP_TXN_PREF "1", DAP_DB$T_GROUP_TXN_PREF "2" };
+static atomic_size_t s_txn_notified = 0;                                    /* Notifications of the batch records */
+static atomic_bool s_txn_marker_notified = false;
+
+static void s_test_txn_notify(dap_store_obj_t *a_obj, void UNUSED_ARG *a_arg)
+{
+    if (!dap_strcmp(a_obj->key, "TXN$marker"))
+        atomic_store(&s_txn_marker_notified, true);
+    else if (!strncmp(a_obj->group, DAP_DB$T_GROUP_TXN_PREF, sizeof(DAP_DB$T_GROUP_TXN_PREF) - 1))
+        atomic_fetch_add(&s_txn_notified, 1);
+}
+
+/**
+ * @brief Notifications are processed in order by the only proc thread,
+ *        so the batch ones are already done when the marker record is notified
+ */
+static size_t s_test_txn_notified(void)
+{
+    atomic_store(&s_txn_marker_notified, false);
+    dap_assert_PIF(!dap_global_db_set_sync(DAP_DB$T_GROUP_TXN_PREF "marker", "TXN$marker", "", 1, false), "Write marker record");
+    for (int i = 0; i < 5000 && !atomic_load(&s_txn_marker_notified); i++)
+        dap_usleep(1000);
+    dap_assert_PIF(atomic_load(&s_txn_marker_notified), "Marker record is notified");
+    return atomic_load(&s_txn_notified);
+}
+
+static bool s_test_txn_is_pinned(const char *a_group, const char *a_key)
+{
+    char *l_pinned_group = dap_strdup_printf("local.%s.pinned", a_group);
+    bool l_ret = dap_global_db_driver_is(l_pinned_group, a_key);
+    DAP_DELETE(l_pinned_group);
+    return l_ret;
+}
+
+/*
+ * Committed state is a_count records, every 4th is pinned. The batch rewrites them, adds as many new ones,
+ * unpins the pinned ones, pins the records 4 * n + 1 by setting and 4 * n + 2 by pinning after the setting.
+ */
+static dap_global_db_batch_t *s_test_txn_batch(size_t a_count, bool a_committed_state)
+{
+    char l_key[64] = { 0 };
+    byte_t l_value[DAP_DB$SZ_BENCH_VALUE];
+    dap_global_db_batch_t *l_batch = dap_global_db_batch_new();
+    dap_assert_PIF(l_batch, "Create batch");
+    size_t l_keys_count = a_committed_state ? a_count : a_count * 2;
+    for (size_t i = 0; i < l_keys_count; ++i) {
+        snprintf(l_key, sizeof(l_key), "TXN$%08zx", i);
+        memset(l_value, (int)(a_committed_state ? i : a_count * 4 + i), sizeof(l_value));
+        bool l_pin = a_committed_state ? i % 4 == 0 : i % 4 == 1;
+        dap_assert_PIF(!dap_global_db_batch_set(l_batch, s_txn_groups[i % 2], l_key, l_value, sizeof(l_value), l_pin), "Add batch set");
+        if (!a_committed_state && i % 4 == 2)
+            dap_assert_PIF(!dap_global_db_batch_pin(l_batch, s_txn_groups[i % 2], l_key), "Add batch pin");
+    }
+    return l_batch;
+}
+
+static void s_test_txn_check_state(size_t a_count, bool a_committed)
+{
+    char l_key[64];
+    for (size_t i = 0; i < a_count * 2; ++i) {
+        snprintf(l_key, sizeof(l_key), "TXN$%08zx", i);
+        dap_store_obj_t *l_obj = dap_global_db_driver_read(s_txn_groups[i % 2], l_key, NULL, true);
+        if (!a_committed && i >= a_count) {
+            dap_assert_PIF(!l_obj, "No new records of uncommitted batch");
+            dap_assert_PIF(!s_test_txn_is_pinned(s_txn_groups[i % 2], l_key), "No pinned records of uncommitted batch");
+            continue;
+        }
+        dap_assert_PIF(l_obj && l_obj->value_len == DAP_DB$SZ_BENCH_VALUE, "Read batch record");
+        dap_assert_PIF(l_obj->value[0] == (byte_t)(a_committed ? a_count * 4 + i : i), "Batch record value");
+        bool l_pinned = a_committed ? i % 4 == 1 || i % 4 == 2 : i % 4 == 0;
+        dap_assert_PIF(!(l_obj->flags & DAP_GLOBAL_DB_RECORD_PINNED) == !l_pinned, "Batch record pin flag");
+        dap_assert_PIF(s_test_txn_is_pinned(s_txn_groups[i % 2], l_key) == l_pinned, "Pinned group follows the batch record");
+        dap_store_obj_free_one(l_obj);
+    }
+}
+
+struct txn_check {
+    enum txn_stage stage;
+    size_t count;
+    size_t notified;
+};
+
+static bool s_test_txn_check(dap_global_db_instance_t UNUSED_ARG *a_dbi, size_t UNUSED_ARG a_ops_count, void *a_arg)
+{
+    struct txn_check *l_check = a_arg;
+    char l_key[64];
+    // Batch changes and their pinning are visible inside the transaction, notifications aren't done yet
+    snprintf(l_key, sizeof(l_key), "TXN$%08zx", l_check->count + 1);
+    dap_assert_PIF(dap_global_db_driver_is(s_txn_groups[(l_check->count + 1) % 2], l_key), "Batch record is written before commit");
+    dap_assert_PIF(s_test_txn_is_pinned(s_txn_groups[(l_check->count + 1) % 2], l_key), "Pinned group is updated in the batch transaction");
+    dap_assert_PIF(atomic_load(&s_txn_notified) == l_check->notified, "Nothing is notified before commit");
+    if (l_check->stage == TXN_CRASH_BEFORE_COMMIT)
+        kill(getpid(), SIGKILL);
+    return l_check->stage == TXN_COMMIT;
+}
+
+/**
+ * @brief Batch commit is interrupted before the commit by the process kill or by the rollback, or it's committed.
+ *        Reopened DB has to contain all of the batch changes or none of them, pinned groups and notifications included.
+ */
+static void s_test_txn_stage(size_t a_count, enum txn_stage a_stage)
+{
+    dap_global_db_instance_t *l_dbi = dap_global_db_instance_get_default();
+    size_t l_notified = s_test_txn_notified();
+    struct txn_check l_check = { .stage = a_stage, .count = a_count, .notified = l_notified };
+    dap_global_db_batch_t *l_batch = s_test_txn_batch(a_count, false);
+    dap_global_db_batch_set_check(l_batch, s_test_txn_check, &l_check);
+    if (a_stage == TXN_CRASH_BEFORE_COMMIT) {
+        dap_global_db_driver_deinit();                                      /* Child can't share MDBX environment with the parent */
+        pid_t l_pid = fork();
+        dap_assert_PIF(l_pid >= 0, "Fork crash test process");
+        if (!l_pid) {
+            if (!dap_global_db_driver_init(l_dbi->driver_name, l_dbi->storage_path))
+                dap_global_db_batch_commit_sync(l_batch);
+            _exit(1);
+        }
+        int l_status = 0;
+        dap_assert_PIF(waitpid(l_pid, &l_status, 0) == l_pid, "Wait crash test process");
+        dap_assert_PIF(WIFSIGNALED(l_status) && WTERMSIG(l_status) == SIGKILL, "Crash test process is killed");
+        dap_assert_PIF(!dap_global_db_driver_init(l_dbi->driver_name, l_dbi->storage_path), "Reopen DB after crash");
+    } else {
+        int l_rc = dap_global_db_batch_commit_sync(l_batch);
+        dap_assert_PIF(a_stage == TXN_COMMIT ? l_rc == DAP_GLOBAL_DB_RC_SUCCESS : l_rc == DAP_GLOBAL_DB_RC_ERROR, "Batch commit result");
+    }
+    s_test_txn_check_state(a_count, a_stage == TXN_COMMIT);
+    size_t l_expected = a_stage == TXN_COMMIT ? l_notified + dap_global_db_batch_count(l_batch) : l_notified;
+    dap_assert_PIF(s_test_txn_notified() == l_expected, a_stage == TXN_COMMIT ? "Every batch operation is notified after commit"
+                                                                              : "Nothing is notified by uncommitted batch");
+    dap_global_db_batch_delete(l_batch);
+}
+
+static void s_test_txn(size_t a_count)
+{
+    dap_test_msg("Start write batch consistency test on %zu records ...", a_count);
+    // GlobalDB instance with the node certificate and the only proc thread, batch records are signed by it
+    dap_assert_PIF(!dap_events_init(1, 0) && !dap_events_start(), "Events start");
+    dap_cert_t *l_cert = dap_cert_generate_mem(DAP_STREAM_NODE_ADDR_CERT_NAME, DAP_ENC_KEY_TYPE_SIG_DILITHIUM);
+    dap_assert_PIF(l_cert && !dap_cert_add(l_cert), "Generate node certificate");
+    g_node_addr = dap_stream_node_addr_from_cert(l_cert);
+    g_sys_dir_path = dap_strdup(DB_BATCH_DIR);
+    dap_assert_PIF(!dap_global_db_init(), "GlobalDB init");
+    dap_global_db_instance_t *l_dbi = dap_global_db_instance_get_default();
+    dap_assert_PIF(!dap_global_db_cluster_add_notify_callback(dap_global_db_cluster_by_group(l_dbi, s_txn_groups[0]), s_test_txn_notify, NULL),
+                   "Add batch groups notifier");
+
+    dap_global_db_batch_t *l_batch = s_test_txn_batch(a_count, true);
+    dap_assert_PIF(!dap_global_db_batch_commit_sync(l_batch), "Commit batch");
+    dap_assert_PIF(s_test_txn_notified() == a_count, "Every batch operation is notified");
+    dap_global_db_batch_delete(l_batch);
+    s_test_txn_check_state(a_count, false);
+
+    s_test_txn_stage(a_count, TXN_CRASH_BEFORE_COMMIT);
+    s_test_txn_stage(a_count, TXN_ROLLBACK);
+    s_test_txn_stage(a_count, TXN_COMMIT);
+
+    // Nested rollback makes the outer transaction rollback-only
+    dap_store_obj_t l_store_obj = { .group = (char *)s_txn_groups[0], .key = "TXN$nested", .value = (byte_t *)"", .value_len = 1,
+                                    .timestamp = dap_nanotime_now(), .crc = 1 };
+    dap_assert_PIF(!dap_global_db_driver_batch_start() && !dap_global_db_driver_batch_start(), "Start nested transaction");
+    dap_assert_PIF(!dap_global_db_driver_add(&l_store_obj, 1), "Write record in nested transaction");
+    dap_assert_PIF(!dap_global_db_driver_txn_end(false), "Rollback nested transaction");
+    dap_assert_PIF(dap_global_db_driver_txn_end(true) == DAP_GLOBAL_DB_RC_ERROR, "Commit of rolled back transaction fails");
+    dap_assert_PIF(!dap_global_db_driver_is(s_txn_groups[0], "TXN$nested"), "Nothing is written by rolled back transaction");
+
+    // Instance and its threads are kept up to the process exit, clusters can't be deleted along with their links clusters
+    dap_global_db_driver_deinit();
+    dap_rm_rf(DB_BATCH_DIR);
+    dap_pass_msg("write batch consistency");
+}
+
 static void s_test_close_db(void)
 {
     dap_global_db_driver_deinit();
@@ -869,6 +1363,7 @@ static void s_test_full(size_t a_db_count, size_t a_count)
         dap_random_string_fill(s_group + strlen(DAP_DB$T_GROUP_PREF), 32);
         dap_random_string_fill(s_group_wrong + strlen(DAP_DB$T_GROUP_WRONG_PREF), 32);
         dap_random_string_fill(s_group_not_existed + strlen(DAP_DB$T_GROUP_NOT_EXISTED_PREF), 32);
+        dap_random_string_fill(s_group_bench + strlen(DAP_DB$T_GROUP_BENCH_PREF), 32);
 
         dap_test_msg("s_group name %s", s_group);
         dap_test_msg("s_group_wrong name %s", s_group_wrong);
@@ -914,6 +1409,9 @@ static void s_test_full(size_t a_db_count, size_t a_count)
         benchmark_mgs_time("Tests to get_by_hash", s_get_by_hash / 1000000);
         benchmark_mgs_time("Tests to get_groups_by_mask", s_get_groups_by_mask / 1000000);
         benchmark_mgs_time(l_msg, (l_t2 - l_t1) / 1000000);
+        s_test_bench_throughput(a_count * 8);
+        s_test_expire(a_count * 8);
+        s_test_cursor(a_count * 64);
         s_test_table_erase();
         s_test_close_db();
     }
@@ -933,8 +1431,13 @@ int main(int argc, char **argv)
     sprintf(s_group, "%s", DAP_DB$T_GROUP_PREF);
     sprintf(s_group_wrong, "%s", DAP_DB$T_GROUP_WRONG_PREF);
     sprintf(s_group_not_existed, "%s", DAP_DB$T_GROUP_NOT_EXISTED_PREF);
+    sprintf(s_group_bench, "%s", DAP_DB$T_GROUP_BENCH_PREF);
     
     dap_print_module_name("Tests with combined value");
     s_test_full(l_db_count, l_count);
+#ifdef DAP_CHAIN_GDB_ENGINE_MDBX
+    dap_print_module_name("Tests of write batch");
+    s_test_txn(l_count * 8);
+#endif
 }
 
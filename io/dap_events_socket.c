@@ -85,6 +85,7 @@ typedef cpuset_t cpu_set_t; // Adopt BSD CPU setstructure to POSIX variant
 #include "dap_timerfd.h"
 #include "dap_context.h"
 #include "dap_events_socket.h"
+#include "dap_server.h"
 
 #define LOG_TAG "dap_events_socket"
 
@@ -1505,6 +1506,8 @@ void dap_events_socket_delete_unsafe(dap_events_socket_t *a_esocket, bool a_pres
 #ifndef DAP_EVENTS_CAPS_IOCP
     dap_events_socket_descriptor_close(a_esocket);
 #endif
+    if (a_esocket->flags & DAP_SOCK_SERVER_COUNTED)
+        dap_server_client_release(a_esocket);
     DAP_DEL_MULTY(a_esocket->_pvt, a_esocket->buf_in, a_esocket->buf_out);
     if (!a_preserve_inheritor)
         DAP_DELETE(a_esocket->_inheritor);
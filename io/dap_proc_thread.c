@@ -212,7 +212,9 @@ static int s_context_callback_started(dap_context_t UNUSED_ARG *a_context, void
     assert(l_thread);
     pthread_mutex_init(&l_thread->queue_lock, NULL);
     pthread_cond_init(&l_thread->queue_event, NULL);
-    // Init proc_queue for related worker
+    // Init proc_queue for related worker, thread created without CPU affinity is a standalone one
+    if (l_thread->context->cpu_id == -1)
+        return 0;
     dap_worker_t * l_worker_related = dap_events_worker_get(l_thread->context->cpu_id);
     assert(l_worker_related);
     l_worker_related->proc_queue_input = l_thread;
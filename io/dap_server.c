@@ -72,6 +72,7 @@
 #include "dap_net.h"
 #include "dap_strfuncs.h"
 #include "dap_file_utils.h"
+#include "dap_time.h"
 
 #define LOG_TAG "dap_server"
 
@@ -80,9 +81,35 @@ bool s_server_enabled = false;
 static void s_es_server_new     (dap_events_socket_t *a_es, void *a_arg);
 static void s_es_server_accept  (dap_events_socket_t *a_es_listener, SOCKET a_remote_socket, struct sockaddr_storage *a_remote_addr);
 static void s_es_server_error   (dap_events_socket_t *a_es, int a_arg);
+static bool s_limits_accept     (dap_server_t *a_server, const struct sockaddr_storage *a_addr, bool *a_counted);
 
 static dap_server_t* s_default_server = NULL;
 
+#define DAP_SERVER_LIMITS_SWEEP_PERIOD  (10 * 1000000000ULL)    // Idle addresses are forgotten not often than once in 10 s
+#define DAP_SERVER_LIMITS_CLIENTS_MAX   65536                   // Tracked addresses if not set
+#define DAP_SERVER_LIMITS_IPV6_PREFIX   8                       // Bytes of IPv6 address counted as one client, /64 usually belongs to one host
+
+typedef struct limits_bucket {
+    double tokens;
+    dap_nanotime_t ts_update;                                   // Zero for the full bucket of the new client
+} limits_bucket_t;
+
+typedef struct limits_client {
+    byte_t addr[16];                                            // IPv4 is mapped to ::ffff:0:0/96, IPv6 is cut to /64
+    uint32_t connections;
+    limits_bucket_t conn_bucket, request_bucket;
+    bool rejected, throttled;
+    UT_hash_handle hh;
+} limits_client_t;
+
+struct dap_server_limits_pvt {
+    dap_server_limits_t limits;
+    dap_server_limits_stats_t stats;
+    limits_client_t *clients;
+    dap_nanotime_t ts_sweep;
+    pthread_mutex_t mutex;
+};
+
 /**
  * @brief dap_server_init
  * @return
@@ -251,6 +278,9 @@ int dap_server_callbacks_set(dap_server_t* a_server, dap_events_socket_callbacks
 dap_server_t *dap_server_new(const char *a_cfg_section, dap_events_socket_callbacks_t *a_server_callbacks, dap_events_socket_callbacks_t *a_client_callbacks)
 {
     dap_server_t *l_server = DAP_NEW_Z_RET_VAL_IF_FAIL(dap_server_t, NULL);
+    // Allocated once and never replaced, workers read the pointer with no lock
+    l_server->limits = DAP_NEW_Z_RET_VAL_IF_FAIL(struct dap_server_limits_pvt, NULL, l_server);
+    pthread_mutex_init(&l_server->limits->mutex, NULL);
     dap_events_socket_callbacks_t l_callbacks = {
         .accept_callback = s_es_server_accept,
         .new_callback    = s_es_server_new,
@@ -297,6 +327,16 @@ dap_server_t *dap_server_new(const char *a_cfg_section, dap_events_socket_callba
             log_it(L_CRITICAL, "Server can't have both black- and whitelists, fix section [%s]", a_cfg_section);
             l_server->whitelist = NULL; /* Blacklist will have priority */
         }
+        dap_server_limits_t l_limits = {
+            .conn_per_addr_max  = dap_config_get_item_uint32_default(g_config, a_cfg_section, DAP_CFG_PARAM_CONN_PER_ADDR, 0),
+            .conn_rate          = dap_config_get_item_double_default(g_config, a_cfg_section, DAP_CFG_PARAM_CONN_RATE, 0),
+            .conn_burst         = dap_config_get_item_uint32_default(g_config, a_cfg_section, DAP_CFG_PARAM_CONN_BURST, 0),
+            .request_rate       = dap_config_get_item_double_default(g_config, a_cfg_section, DAP_CFG_PARAM_REQUEST_RATE, 0),
+            .request_burst      = dap_config_get_item_uint32_default(g_config, a_cfg_section, DAP_CFG_PARAM_REQUEST_BURST, 0),
+            .clients_max        = dap_config_get_item_uint32_default(g_config, a_cfg_section, DAP_CFG_PARAM_CLIENTS_MAX, 0)
+        };
+        if (l_limits.conn_per_addr_max || l_limits.conn_rate > 0 || l_limits.request_rate > 0)
+            dap_server_limits_set(l_server, &l_limits);
     }
     if (!l_server->es_listeners) {
         log_it(L_INFO, "Server with no listeners created. "
@@ -306,6 +346,213 @@ dap_server_t *dap_server_new(const char *a_cfg_section, dap_events_socket_callba
     return l_server;
 }
 
+static bool s_limits_addr_key(const struct sockaddr_storage *a_addr, byte_t *a_key)
+{
+    switch (a_addr->ss_family) {
+    case AF_INET:
+        memset(a_key, 0, 10);
+        a_key[10] = a_key[11] = 0xff;
+        memcpy(a_key + 12, &((struct sockaddr_in *)a_addr)->sin_addr, 4);
+        return true;
+    case AF_INET6: {
+        const struct in6_addr *l_addr = &((struct sockaddr_in6 *)a_addr)->sin6_addr;
+        // Mapped IPv4 of the dual stack socket is the whole address
+        size_t l_len = IN6_IS_ADDR_V4MAPPED(l_addr) ? 16 : DAP_SERVER_LIMITS_IPV6_PREFIX;
+        memcpy(a_key, l_addr, l_len);
+        memset(a_key + l_len, 0, 16 - l_len);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static inline double s_bucket_size(double a_rate, uint32_t a_burst)
+{
+    return a_burst ? a_burst : dap_max(a_rate, 1.0);
+}
+
+static inline double s_bucket_tokens(limits_bucket_t *a_bucket, double a_rate, uint32_t a_burst, dap_nanotime_t a_now)
+{
+    double l_size = s_bucket_size(a_rate, a_burst);
+    return a_bucket->ts_update ? dap_min(l_size, a_bucket->tokens + (a_now - a_bucket->ts_update) * a_rate / 1e9) : l_size;
+}
+
+/**
+ * @brief s_bucket_take Takes one token from the bucket refilled with a_rate tokens per second
+ * @return false if the bucket is empty, always true if there is no rate limit
+ */
+static bool s_bucket_take(limits_bucket_t *a_bucket, double a_rate, uint32_t a_burst, dap_nanotime_t a_now)
+{
+    if (a_rate <= 0)
+        return true;
+    a_bucket->tokens = s_bucket_tokens(a_bucket, a_rate, a_burst, a_now);
+    a_bucket->ts_update = a_now;
+    if (a_bucket->tokens < 1)
+        return false;
+    a_bucket->tokens -= 1;
+    return true;
+}
+
+// Forgets addresses with no connections and full buckets, they are the same as never seen ones. Under mutex
+static void s_limits_sweep(struct dap_server_limits_pvt *a_limits, dap_nanotime_t a_now)
+{
+    if (a_now - a_limits->ts_sweep < DAP_SERVER_LIMITS_SWEEP_PERIOD)
+        return;
+    a_limits->ts_sweep = a_now;
+    dap_server_limits_t *l_cfg = &a_limits->limits;
+    limits_client_t *l_client, *l_tmp;
+    HASH_ITER(hh, a_limits->clients, l_client, l_tmp) {
+        if (l_client->connections
+                || (l_cfg->conn_rate > 0 && s_bucket_tokens(&l_client->conn_bucket, l_cfg->conn_rate, l_cfg->conn_burst, a_now)
+                                            < s_bucket_size(l_cfg->conn_rate, l_cfg->conn_burst))
+                || (l_cfg->request_rate > 0 && s_bucket_tokens(&l_client->request_bucket, l_cfg->request_rate, l_cfg->request_burst, a_now)
+                                               < s_bucket_size(l_cfg->request_rate, l_cfg->request_burst)))
+            continue;
+        HASH_DEL(a_limits->clients, l_client);
+        DAP_DELETE(l_client);
+    }
+}
+
+static limits_client_t *s_limits_client_get(struct dap_server_limits_pvt *a_limits, const byte_t *a_key, bool a_create)
+{
+    limits_client_t *l_client = NULL;
+    HASH_FIND(hh, a_limits->clients, a_key, 16, l_client);
+    if (l_client || !a_create)
+        return l_client;
+    uint32_t l_max = a_limits->limits.clients_max ? a_limits->limits.clients_max : DAP_SERVER_LIMITS_CLIENTS_MAX;
+    if (HASH_COUNT(a_limits->clients) >= l_max) {
+        // Untracked address is not limited, refusing it would let the flood of new addresses lock out everyone
+        a_limits->stats.clients_overflow++;
+        return NULL;
+    }
+    l_client = DAP_NEW_Z_RET_VAL_IF_FAIL(limits_client_t, NULL);
+    memcpy(l_client->addr, a_key, 16);
+    HASH_ADD(hh, a_limits->clients, addr, 16, l_client);
+    return l_client;
+}
+
+/**
+ * @brief dap_server_limits_set Sets per source address limits, may be called on the running server
+ * @param a_server created by dap_server_new()
+ * @param a_limits zero fields mean no limit, NULL removes all of them
+ * @return 0 if ok
+ */
+int dap_server_limits_set(dap_server_t *a_server, const dap_server_limits_t *a_limits)
+{
+    dap_return_val_if_fail(a_server && a_server->limits, -1);
+    if (a_limits && (a_limits->conn_rate < 0 || a_limits->request_rate < 0))
+        return log_it(L_ERROR, "Negative rate limit"), -2;
+    pthread_mutex_lock(&a_server->limits->mutex);
+    a_server->limits->limits = a_limits ? *a_limits : (dap_server_limits_t){ };
+    pthread_mutex_unlock(&a_server->limits->mutex);
+    if (a_limits)
+        log_it(L_INFO, "Server limits per address: %u connections, %.1f (burst %u) connections/s, %.1f (burst %u) requests/s",
+                       a_limits->conn_per_addr_max, a_limits->conn_rate, a_limits->conn_burst, a_limits->request_rate, a_limits->request_burst);
+    return 0;
+}
+
+/**
+ * @brief dap_server_limits_stats_get
+ * @param a_server
+ * @param a_stats
+ */
+void dap_server_limits_stats_get(dap_server_t *a_server, dap_server_limits_stats_t *a_stats)
+{
+    dap_return_if_fail(a_server && a_stats);
+    *a_stats = (dap_server_limits_stats_t){ };
+    if (!a_server->limits)
+        return;
+    pthread_mutex_lock(&a_server->limits->mutex);
+    *a_stats = a_server->limits->stats;
+    a_stats->clients_tracked = HASH_COUNT(a_server->limits->clients);
+    pthread_mutex_unlock(&a_server->limits->mutex);
+}
+
+// Checks connection quota and rate of the new connection, counts it if accepted
+static bool s_limits_accept(dap_server_t *a_server, const struct sockaddr_storage *a_addr, bool *a_counted)
+{
+    struct dap_server_limits_pvt *l_limits = a_server->limits;
+    byte_t l_key[16];
+    *a_counted = false;
+    if (!l_limits || !s_limits_addr_key(a_addr, l_key))
+        return true;
+    dap_nanotime_t l_now = dap_nanotime_now();
+    pthread_mutex_lock(&l_limits->mutex);
+    dap_server_limits_t *l_cfg = &l_limits->limits;
+    if (!l_cfg->conn_per_addr_max && l_cfg->conn_rate <= 0)
+        return pthread_mutex_unlock(&l_limits->mutex), true;
+    s_limits_sweep(l_limits, l_now);
+    limits_client_t *l_client = s_limits_client_get(l_limits, l_key, true);
+    if (!l_client)
+        return pthread_mutex_unlock(&l_limits->mutex), true;
+    bool l_ret = (!l_cfg->conn_per_addr_max || l_client->connections < l_cfg->conn_per_addr_max)
+            && s_bucket_take(&l_client->conn_bucket, l_cfg->conn_rate, l_cfg->conn_burst, l_now);
+    if (l_ret) {
+        l_client->connections++;
+        l_client->rejected = false;
+        *a_counted = true;
+    } else {
+        l_limits->stats.conn_rejected++;
+        if (!l_client->rejected) {
+            l_client->rejected = true;
+            l_limits->stats.clients_rejected++;
+        }
+    }
+    pthread_mutex_unlock(&l_limits->mutex);
+    return l_ret;
+}
+
+/**
+ * @brief dap_server_request_allow Takes the request token of the client address
+ * @param a_server
+ * @param a_addr
+ * @return false if the request should be rejected
+ */
+bool dap_server_request_allow(dap_server_t *a_server, const struct sockaddr_storage *a_addr)
+{
+    byte_t l_key[16];
+    if (!a_server || !a_server->limits || !s_limits_addr_key(a_addr, l_key))
+        return true;
+    struct dap_server_limits_pvt *l_limits = a_server->limits;
+    dap_nanotime_t l_now = dap_nanotime_now();
+    pthread_mutex_lock(&l_limits->mutex);
+    bool l_ret = true;
+    limits_client_t *l_client = l_limits->limits.request_rate > 0 ? s_limits_client_get(l_limits, l_key, true) : NULL;
+    if (l_client) {
+        l_ret = s_bucket_take(&l_client->request_bucket, l_limits->limits.request_rate, l_limits->limits.request_burst, l_now);
+        if (l_ret)
+            l_client->throttled = false;
+        else {
+            l_limits->stats.requests_throttled++;
+            if (!l_client->throttled) {
+                l_client->throttled = true;
+                l_limits->stats.clients_throttled++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&l_limits->mutex);
+    return l_ret;
+}
+
+/**
+ * @brief dap_server_client_release Uncounts closed connection of the client
+ * @param a_es
+ */
+void dap_server_client_release(dap_events_socket_t *a_es)
+{
+    byte_t l_key[16];
+    if (!a_es->server || !a_es->server->limits || !s_limits_addr_key(&a_es->addr_storage, l_key))
+        return;
+    struct dap_server_limits_pvt *l_limits = a_es->server->limits;
+    pthread_mutex_lock(&l_limits->mutex);
+    limits_client_t *l_client = s_limits_client_get(l_limits, l_key, false);
+    if (l_client && l_client->connections)
+        l_client->connections--;
+    pthread_mutex_unlock(&l_limits->mutex);
+    a_es->flags &= ~DAP_SOCK_SERVER_COUNTED;
+}
+
 /**
  * @brief s_es_server_new
  * @param a_es
@@ -351,6 +598,7 @@ static void s_es_server_accept(dap_events_socket_t *a_es_listener, SOCKET a_remo
         return;
     }
     char l_remote_addr_str[INET6_ADDRSTRLEN] = "", l_port_str[NI_MAXSERV] = "";
+    bool l_counted = false;
 
     dap_events_desc_type_t l_es_type = DESCRIPTOR_TYPE_SOCKET_CLIENT;
     switch (a_remote_addr->ss_family) {
@@ -363,6 +611,10 @@ static void s_es_server_accept(dap_events_socket_t *a_es_listener, SOCKET a_remo
 #endif
     case AF_INET:
     case AF_INET6:
+        if ( l_server->accept_check_callback && !l_server->accept_check_callback(l_server, a_remote_addr) ) {
+            closesocket(a_remote_socket);
+            return;
+        }
         if ( getnameinfo((struct sockaddr*)a_remote_addr, sizeof(*a_remote_addr), 
                          l_remote_addr_str, sizeof(l_remote_addr_str),
                          l_port_str, sizeof(l_port_str), NI_NUMERICHOST | NI_NUMERICSERV) )
@@ -382,6 +634,11 @@ static void s_es_server_accept(dap_events_socket_t *a_es_listener, SOCKET a_remo
                                 l_remote_addr_str, l_port_str);
             }
                 
+        if ( !s_limits_accept(l_server, a_remote_addr, &l_counted) ) {
+            closesocket(a_remote_socket);
+            return debug_if(l_server->ext_log, L_INFO, "Connection from %s : %s exceeds limits. Dump it",
+                            l_remote_addr_str, l_port_str);
+        }
         debug_if(l_server->ext_log, L_INFO, "Connection accepted from %s : %s, socket %"DAP_FORMAT_SOCKET,
                                             l_remote_addr_str, l_port_str, a_remote_socket);
         int one = 1;
@@ -395,6 +652,8 @@ static void s_es_server_accept(dap_events_socket_t *a_es_listener, SOCKET a_remo
     l_es_new = dap_events_socket_wrap_no_add(a_remote_socket, &l_server->client_callbacks);
     l_es_new->server = l_server;
     l_es_new->type = l_es_type;
+    if (l_counted)
+        l_es_new->flags |= DAP_SOCK_SERVER_COUNTED;
     l_es_new->addr_storage = *a_remote_addr;
     l_es_new->remote_port = strtol(l_port_str, NULL, 10);
     dap_strncpy(l_es_new->remote_addr_str, l_remote_addr_str, INET6_ADDRSTRLEN);
@@ -418,6 +677,15 @@ void dap_server_delete(dap_server_t *a_server)
     if(a_server->delete_callback)
         a_server->delete_callback(a_server,NULL);
 
+    if (a_server->limits) {
+        limits_client_t *l_client, *l_tmp;
+        HASH_ITER(hh, a_server->limits->clients, l_client, l_tmp) {
+            HASH_DEL(a_server->limits->clients, l_client);
+            DAP_DELETE(l_client);
+        }
+        pthread_mutex_destroy(&a_server->limits->mutex);
+        DAP_DELETE(a_server->limits);
+    }
     //DAP_DELETE(a_server->_inheritor);
     DAP_DELETE(a_server);
 }
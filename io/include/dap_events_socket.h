@@ -126,6 +126,7 @@ typedef struct queue_entry {
 // If set - queue limited to sizeof(void*) size of data transmitted
 #define DAP_SOCK_FILE_MAPPED       BIT( 7 )
 #define DAP_SOCK_QUEUE_PTR         BIT( 8 )
+#define DAP_SOCK_SERVER_COUNTED    BIT( 9 )    // Accepted connection is counted by server per-address limits
 
 #define FLAG_CLOSE(f)           (f & DAP_SOCK_SIGNAL_CLOSE)
 #define FLAG_READ_NOCLOSE(f)    (!(f & DAP_SOCK_SIGNAL_CLOSE) && (f & DAP_SOCK_READY_TO_READ))
@@ -49,6 +49,12 @@
 #define DAP_CFG_PARAM_LEGACY_PORT       "listen-port-tcp"
 #define DAP_CFG_PARAM_WHITE_LIST        "white-list"
 #define DAP_CFG_PARAM_BLACK_LIST        "black-list"
+#define DAP_CFG_PARAM_CONN_PER_ADDR     "conn-per-addr-max"
+#define DAP_CFG_PARAM_CONN_RATE         "conn-rate"
+#define DAP_CFG_PARAM_CONN_BURST        "conn-burst"
+#define DAP_CFG_PARAM_REQUEST_RATE      "request-rate"
+#define DAP_CFG_PARAM_REQUEST_BURST     "request-burst"
+#define DAP_CFG_PARAM_CLIENTS_MAX       "clients-max"
 
 typedef struct dap_link_info {
     dap_stream_node_addr_t node_addr;
@@ -47,13 +47,34 @@
 
 struct dap_server;
 typedef void (*dap_server_callback_t) (struct dap_server*, void*); // Callback for specific server's operations
+typedef bool (*dap_server_accept_check_callback_t) (struct dap_server*, const struct sockaddr_storage*); // False drops the connection
+
+// Limits per source address, zero means no limit
+typedef struct dap_server_limits {
+    uint32_t conn_per_addr_max;                                     // Concurrent connections
+    double conn_rate, request_rate;                                 // Token bucket rates, per second
+    uint32_t conn_burst, request_burst;                             // Token bucket sizes, rate (at least 1) if zero
+    uint32_t clients_max;                                           // Tracked addresses, new ones over it are not limited
+} dap_server_limits_t;
+
+typedef struct dap_server_limits_stats {
+    uint64_t conn_rejected;                                         // Connections dropped at accept
+    uint64_t requests_throttled;                                    // Requests rejected by rate limit
+    uint64_t clients_rejected, clients_throttled;                   // Times a source address hit a limit after being fine
+    uint64_t clients_overflow;                                      // Times a new address was not tracked, the table is full
+    uint32_t clients_tracked;
+} dap_server_limits_stats_t;
+
+struct dap_server_limits_pvt;
 
 typedef struct dap_server {
     dap_events_socket_callbacks_t client_callbacks;
     dap_server_callback_t delete_callback;
+    dap_server_accept_check_callback_t accept_check_callback; // Called right after accept(), before any allocations
     dap_cpu_stats_t cpu_stats;
     dap_list_t *es_listeners;
     const char **whitelist, **blacklist;
+    struct dap_server_limits_pvt *limits;
     void *_inheritor;
     bool ext_log;
 } dap_server_t;
@@ -72,3 +93,10 @@ int dap_server_listen_addr_add(dap_server_t *a_server, const char *a_addr, uint1
                                dap_events_desc_type_t a_type, dap_events_socket_callbacks_t *a_callbacks);
 int dap_server_callbacks_set(dap_server_t*, dap_events_socket_callbacks_t*, dap_events_socket_callbacks_t*);
 void dap_server_delete(dap_server_t *a_server);
+
+int dap_server_limits_set(dap_server_t *a_server, const dap_server_limits_t *a_limits);
+void dap_server_limits_stats_get(dap_server_t *a_server, dap_server_limits_stats_t *a_stats);
+// Called by protocol layer on each request (URL dispatch), false means the client exceeds request rate
+bool dap_server_request_allow(dap_server_t *a_server, const struct sockaddr_storage *a_addr);
+// Connection of the client is closed, called on esocket deletion
+void dap_server_client_release(dap_events_socket_t *a_es);
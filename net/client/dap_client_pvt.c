@@ -52,6 +52,7 @@
 #include "dap_stream_ch_proc.h"
 #include "dap_stream_pkt.h"
 #include "dap_net.h"
+#include "rand/dap_rand.h"
 
 #define LOG_TAG "dap_client_pvt"
 
@@ -63,6 +64,22 @@ static int s_max_attempts = 3;
 static int s_timeout = 20;
 static bool s_debug_more = false;
 static time_t s_client_timeout_active_after_connect_seconds = 15;
+static dap_enc_key_type_t s_session_key_type = DAP_ENC_KEY_TYPE_SALSA2012;
+
+// Session resumption tickets received from uplinks, shared between clients of the same uplink
+typedef struct dap_client_resume {
+    char uplink[DAP_HOSTADDR_STRLEN + 8]; // addr:port
+    char id[DAP_ENC_KS_KEY_ID_SIZE];
+    uint8_t secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+    uint8_t nonce[DAP_ENC_KS_RESUME_NONCE_SIZE];
+    time_t time_expire;
+    bool authorized;
+    UT_hash_handle hh;
+} dap_client_resume_t;
+
+static bool s_session_resume = true;
+static dap_client_resume_t *s_resume_tickets = NULL;
+static pthread_rwlock_t s_resume_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
 
 static void s_stage_status_after(dap_client_pvt_t * a_client_internal);
@@ -72,6 +89,8 @@ static int s_json_multy_obj_parse_str(const char *a_key, const char *a_val, int
 // ENC stage callbacks
 static void s_enc_init_response(dap_client_t *a_client, void *a_data, size_t a_data_size);
 static void s_enc_init_error(dap_client_t *a_client, void *a_arg, int a_error);
+static void s_enc_resume_response(dap_client_t *a_client, void *a_data, size_t a_data_size);
+static void s_enc_resume_error(dap_client_t *a_client, void *a_arg, int a_error);
 
 // STREAM_CTL stage callbacks
 static void s_stream_ctl_response(dap_client_t *a_client, void *a_data, size_t a_data_size);
@@ -106,6 +125,16 @@ int dap_client_pvt_init()
     s_debug_more = dap_config_get_item_bool_default(g_config, "dap_client", "debug_more", false);
     s_client_timeout_active_after_connect_seconds = (time_t) dap_config_get_item_uint32_default(g_config,
                                                   "dap_client","timeout_active_after_connect", s_client_timeout_active_after_connect_seconds);
+    // Session cipher proposed to the server, e.g. AES256_GCM or CHACHA20_POLY1305 for authenticated encryption
+    const char *l_session_key_type = dap_config_get_item_str(g_config, "dap_client", "session_key_type");
+    if (l_session_key_type) {
+        dap_enc_key_type_t l_key_type = dap_enc_key_type_find_by_name(l_session_key_type);
+        if (l_key_type != DAP_ENC_KEY_TYPE_INVALID && dap_enc_key_get_enc_size(l_key_type, 1))
+            s_session_key_type = l_key_type;
+        else
+            log_it(L_ERROR, "Unsupported session key type %s, use %s", l_session_key_type, dap_enc_get_type_name(s_session_key_type));
+    }
+    s_session_resume = dap_config_get_item_bool_default(g_config, "dap_client", "session_resume", s_session_resume);
     return 0;
 }
 
@@ -114,6 +143,76 @@ int dap_client_pvt_init()
  */
 void dap_client_pvt_deinit()
 {
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    dap_client_resume_t *l_resume, *l_tmp;
+    HASH_ITER(hh, s_resume_tickets, l_resume, l_tmp) {
+        HASH_DEL(s_resume_tickets, l_resume);
+        DAP_DELETE(l_resume);
+    }
+    pthread_rwlock_unlock(&s_resume_rwlock);
+}
+
+static void s_resume_uplink_str(dap_client_pvt_t *a_client_pvt, char *a_buf, size_t a_buf_size)
+{
+    snprintf(a_buf, a_buf_size, "%s:%u", a_client_pvt->client->link_info.uplink_addr, a_client_pvt->client->link_info.uplink_port);
+}
+
+/**
+ * @brief s_resume_ticket_take tickets are single-use, so it's removed from the storage
+ * @param a_client_pvt client
+ * @return not expired resumption ticket for client uplink or NULL
+ */
+static dap_client_resume_t *s_resume_ticket_take(dap_client_pvt_t *a_client_pvt)
+{
+    char l_uplink[DAP_HOSTADDR_STRLEN + 8];
+    s_resume_uplink_str(a_client_pvt, l_uplink, sizeof(l_uplink));
+    dap_client_resume_t *l_resume = NULL;
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    HASH_FIND_STR(s_resume_tickets, l_uplink, l_resume);
+    if (l_resume)
+        HASH_DEL(s_resume_tickets, l_resume);
+    pthread_rwlock_unlock(&s_resume_rwlock);
+    if (l_resume && l_resume->time_expire <= time(NULL))
+        DAP_DEL_Z(l_resume);
+    return l_resume;
+}
+
+/**
+ * @brief s_resume_ticket_put save resumption ticket for client uplink, replaces the previous one
+ * @param a_client_pvt client
+ * @param a_id ticket id
+ * @param a_secret resumption secret
+ * @param a_ttl ticket lifetime
+ */
+static void s_resume_ticket_put(dap_client_pvt_t *a_client_pvt, const char *a_id, const uint8_t *a_secret, time_t a_ttl)
+{
+    if (strlen(a_id) != DAP_ENC_KS_KEY_ID_SIZE - 1 || a_ttl <= 0)
+        return log_it(L_WARNING, "Invalid resumption ticket");
+    dap_client_resume_t *l_resume = DAP_NEW_Z_RET_IF_FAIL(dap_client_resume_t), *l_old = NULL;
+    s_resume_uplink_str(a_client_pvt, l_resume->uplink, sizeof(l_resume->uplink));
+    memcpy(l_resume->id, a_id, DAP_ENC_KS_KEY_ID_SIZE);
+    memcpy(l_resume->secret, a_secret, DAP_ENC_KS_RESUME_SECRET_SIZE);
+    // Local clock is used, so ticket expires a bit earlier than on the server side
+    l_resume->time_expire = time(NULL) + a_ttl - dap_min(a_ttl / 10, (time_t)60);
+    l_resume->authorized = a_client_pvt->authorized;
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    HASH_REPLACE_STR(s_resume_tickets, uplink, l_resume, l_old);
+    pthread_rwlock_unlock(&s_resume_rwlock);
+    DAP_DELETE(l_old);
+}
+
+static void s_resume_ticket_drop(dap_client_pvt_t *a_client_pvt)
+{
+    char l_uplink[DAP_HOSTADDR_STRLEN + 8];
+    s_resume_uplink_str(a_client_pvt, l_uplink, sizeof(l_uplink));
+    dap_client_resume_t *l_resume = NULL;
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    HASH_FIND_STR(s_resume_tickets, l_uplink, l_resume);
+    if (l_resume)
+        HASH_DEL(s_resume_tickets, l_resume);
+    pthread_rwlock_unlock(&s_resume_rwlock);
+    DAP_DEL_Z(l_resume);
+    DAP_DEL_Z(a_client_pvt->resume);
 }
 
 /**
@@ -122,7 +221,7 @@ void dap_client_pvt_deinit()
  */
 void dap_client_pvt_new(dap_client_pvt_t * a_client_pvt)
 {
-    a_client_pvt->session_key_type = DAP_ENC_KEY_TYPE_SALSA2012 ;
+    a_client_pvt->session_key_type = s_session_key_type;
     a_client_pvt->session_key_open_type = DAP_ENC_KEY_TYPE_KEM_KYBER512;
     a_client_pvt->session_key_block_size = 32;
 
@@ -151,6 +250,7 @@ static void s_client_internal_clean(dap_client_pvt_t *a_client_pvt)
     }
 
     DAP_DEL_Z(a_client_pvt->session_key_id);
+    DAP_DEL_Z(a_client_pvt->resume);
     if (a_client_pvt->session_key_open) {
         dap_enc_key_delete(a_client_pvt->session_key_open);
         a_client_pvt->session_key_open = NULL;
@@ -385,6 +485,24 @@ static void s_stage_status_after(dap_client_pvt_t *a_client_pvt)
                         break;
                     }
 
+                    DAP_DEL_Z(a_client_pvt->resume);
+                    if ( s_session_resume && (a_client_pvt->resume = s_resume_ticket_take(a_client_pvt)) ) {
+                        // Resume previous session, no key exchange and signs
+                        randombytes(a_client_pvt->resume->nonce, sizeof(a_client_pvt->resume->nonce));
+                        char l_nonce_str[DAP_ENC_BASE64_ENCODE_SIZE(DAP_ENC_KS_RESUME_NONCE_SIZE) + 1] = { '\0' },
+                             l_enc_resume_url[1024] = { '\0' };
+                        size_t l_nonce_str_size = dap_enc_base64_encode(a_client_pvt->resume->nonce, sizeof(a_client_pvt->resume->nonce),
+                                                                        l_nonce_str, DAP_ENC_DATA_TYPE_B64);
+                        snprintf(l_enc_resume_url, sizeof(l_enc_resume_url), DAP_UPLINK_PATH_ENC_INIT
+                                 "/resume" "?enc_type=%d,block_key_size=%zu,resume_id=%s",
+                                 a_client_pvt->session_key_type, a_client_pvt->session_key_block_size, a_client_pvt->resume->id);
+                        debug_if(s_debug_more, L_DEBUG, "ENC resume request with ticket %s", a_client_pvt->resume->id);
+                        if ( dap_client_pvt_request(a_client_pvt, l_enc_resume_url, l_nonce_str, l_nonce_str_size,
+                                                    s_enc_resume_response, s_enc_resume_error) )
+                            a_client_pvt->stage_status = STAGE_STATUS_ERROR;
+                        break;
+                    }
+
                     if (a_client_pvt->session_key_open)
                         dap_enc_key_delete(a_client_pvt->session_key_open);
                     a_client_pvt->session_key_open = dap_enc_key_new_generate(a_client_pvt->session_key_open_type, NULL, 0, NULL, 0,
@@ -930,7 +1048,8 @@ static void s_enc_init_response(dap_client_t *a_client, void *a_data, size_t a_d
     dap_return_if_pass(!l_client_pvt || !a_data);
 // func work
     char *l_data = (char*)a_data, *l_session_id_b64 = NULL,
-         *l_bob_message_b64 = NULL, *l_node_sign_b64 = NULL, *l_bob_message = NULL;
+         *l_bob_message_b64 = NULL, *l_node_sign_b64 = NULL, *l_bob_message = NULL, *l_resume_id = NULL;
+    time_t l_resume_ttl = 0;
     l_client_pvt->last_error = ERROR_NO_ERROR;
     while(l_client_pvt->last_error == ERROR_NO_ERROR) {
         // first checks
@@ -958,13 +1077,15 @@ static void s_enc_init_response(dap_client_t *a_client, void *a_data, size_t a_d
                                             "encrypt_id", &l_session_id_b64, 
                                             "encrypt_msg",  &l_bob_message_b64,
                                             "node_sign", &l_node_sign_b64);
+                    s_json_multy_obj_parse_str(key, l_str, 2, "resume_id", &l_resume_id);
                 }
                 if(json_object_get_type(val) == json_type_int) {
                     int val_int = json_object_get_int(val);
                     if(!strcmp(key, "dap_protocol_version")) {
                         l_client_pvt->remote_protocol_version = val_int;
                         l_json_parse_count++;
-                    }
+                    } else if (!strcmp(key, "resume_ttl"))
+                        l_resume_ttl = val_int;
                 }
             }
             // free jobj
@@ -1041,10 +1162,17 @@ static void s_enc_init_response(dap_client_t *a_client, void *a_data, size_t a_d
             log_it(L_INFO, "Unverified stream to node "NODE_ADDR_FP_STR"\n", NODE_ADDR_FP_ARGS_S(a_client->link_info.node_addr));
             l_client_pvt->authorized = false;
         }
+        if (s_session_resume && l_resume_id) {
+            uint8_t l_resume_secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+            dap_enc_ks_resume_secret_make(l_client_pvt->session_key_open->priv_key_data,
+                                          l_client_pvt->session_key_open->priv_key_data_size, l_resume_secret);
+            s_resume_ticket_put(l_client_pvt, l_resume_id, l_resume_secret, l_resume_ttl);
+            memset(l_resume_secret, 0, sizeof(l_resume_secret));
+        }
         break;
     }
 
-    DAP_DEL_MULTY(l_session_id_b64, l_bob_message_b64, l_node_sign_b64, l_bob_message);
+    DAP_DEL_MULTY(l_session_id_b64, l_bob_message_b64, l_node_sign_b64, l_bob_message, l_resume_id);
     if (l_client_pvt->last_error == ERROR_NO_ERROR) {
         l_client_pvt->stage_status = STAGE_STATUS_DONE;
     } else {
@@ -1075,6 +1203,112 @@ static void s_enc_init_error(dap_client_t * a_client, UNUSED_ARG void *a_arg, in
     s_stage_status_after(l_client_pvt);
 }
 
+/**
+ * @brief s_enc_resume_response check server key confirmation and make resumed session key
+ * @param a_client
+ * @param a_data
+ * @param a_data_size
+ */
+static void s_enc_resume_response(dap_client_t *a_client, void *a_data, size_t a_data_size)
+{
+    dap_client_pvt_t *l_client_pvt = DAP_CLIENT_PVT(a_client);
+    dap_return_if_pass(!l_client_pvt || !l_client_pvt->resume);
+    char *l_session_id_b64 = NULL, *l_proof_b64 = NULL, *l_session_key_id = NULL, *l_resume_id = NULL;
+    time_t l_resume_ttl = 0;
+    struct json_object *jobj = a_data && a_data_size ? json_tokener_parse((char*)a_data) : NULL;
+    if (jobj) {
+        json_object_object_foreach(jobj, key, val) {
+            if (json_object_get_type(val) == json_type_string)
+                s_json_multy_obj_parse_str(key, json_object_get_string(val), 6, "encrypt_id", &l_session_id_b64,
+                                                                                "encrypt_msg", &l_proof_b64,
+                                                                                "resume_id", &l_resume_id);
+            else if (json_object_get_type(val) == json_type_int && !strcmp(key, "dap_protocol_version"))
+                l_client_pvt->remote_protocol_version = json_object_get_int(val);
+            else if (json_object_get_type(val) == json_type_int && !strcmp(key, "resume_ttl"))
+                l_resume_ttl = json_object_get_int64(val);
+        }
+        json_object_put(jobj);
+    }
+    dap_enc_key_t *l_key = NULL;
+    if (l_session_id_b64 && l_proof_b64) {
+        size_t l_id_len = strlen(l_session_id_b64), l_proof_len = strlen(l_proof_b64), l_id_size = 0, l_proof_size = 0;
+        byte_t *l_proof_remote = DAP_NEW_Z_SIZE(byte_t, DAP_ENC_BASE64_DECODE_SIZE(l_proof_len) + 1);
+        l_session_key_id = DAP_NEW_Z_SIZE(char, DAP_ENC_BASE64_DECODE_SIZE(l_id_len) + 1);
+        if (l_proof_remote && l_session_key_id) {
+            l_id_size = dap_enc_base64_decode(l_session_id_b64, l_id_len, l_session_key_id, DAP_ENC_DATA_TYPE_B64);
+            l_proof_size = dap_enc_base64_decode(l_proof_b64, l_proof_len, l_proof_remote, DAP_ENC_DATA_TYPE_B64);
+        }
+        dap_hash_fast_t l_proof;
+        if ( l_id_size && l_proof_size == sizeof(l_proof)
+                && (l_key = dap_enc_ks_resume_key_make(l_client_pvt->resume->secret, l_client_pvt->resume->nonce, l_session_key_id,
+                                                       l_id_size, l_client_pvt->session_key_type, l_client_pvt->session_key_block_size, &l_proof))
+                && memcmp(&l_proof, l_proof_remote, sizeof(l_proof)) ) {
+            dap_enc_key_delete(l_key);
+            l_key = NULL;
+        }
+        DAP_DELETE(l_proof_remote);
+    }
+    DAP_DEL_MULTY(l_session_id_b64, l_proof_b64);
+    if (!l_key) {
+        // Server could be restarted or ticket expired, go the full way
+        log_it(L_INFO, "ENC: session resumption rejected by %s:%u, make the full handshake",
+               a_client->link_info.uplink_addr, a_client->link_info.uplink_port);
+        DAP_DEL_MULTY(l_session_key_id, l_resume_id);
+        s_resume_ticket_drop(l_client_pvt);
+        s_stage_status_after(l_client_pvt);
+        return;
+    }
+    if (l_client_pvt->stage != STAGE_ENC_INIT) {
+        log_it(L_WARNING, "ENC: resumed session but current stage is %s (%s)",
+               dap_client_get_stage_str(a_client), dap_client_get_stage_status_str(a_client));
+        dap_enc_key_delete(l_key);
+        DAP_DELETE(l_session_key_id);
+        l_client_pvt->last_error = ERROR_WRONG_STAGE;
+        l_client_pvt->stage_status = STAGE_STATUS_ERROR;
+    } else {
+        log_it(L_DEBUG, "ENC: session resumed, Key ID %s", l_session_key_id);
+        if (!l_client_pvt->remote_protocol_version)
+            l_client_pvt->remote_protocol_version = DAP_PROTOCOL_VERSION_DEFAULT;
+        l_client_pvt->session_key_id = l_session_key_id;
+        l_client_pvt->session_key = l_key;
+        l_client_pvt->authorized = l_client_pvt->resume->authorized;
+        l_client_pvt->last_error = ERROR_NO_ERROR;
+        l_client_pvt->stage_status = STAGE_STATUS_DONE;
+        // Used ticket is exchanged for the next one
+        if (l_resume_id) {
+            uint8_t l_resume_secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+            dap_enc_ks_resume_secret_next(l_client_pvt->resume->secret, l_client_pvt->resume->nonce, l_resume_secret);
+            s_resume_ticket_put(l_client_pvt, l_resume_id, l_resume_secret, l_resume_ttl);
+            memset(l_resume_secret, 0, sizeof(l_resume_secret));
+        }
+    }
+    DAP_DELETE(l_resume_id);
+    DAP_DEL_Z(l_client_pvt->resume);
+    s_stage_status_after(l_client_pvt);
+}
+
+/**
+ * @brief s_enc_resume_error
+ * @param a_client
+ * @param a_arg
+ * @param a_err_code
+ */
+static void s_enc_resume_error(dap_client_t *a_client, void *a_arg, int a_err_code)
+{
+    dap_client_pvt_t *l_client_pvt = DAP_CLIENT_PVT(a_client);
+    if (!l_client_pvt)
+        return;
+    if (a_err_code == ETIMEDOUT) {
+        // Uplink is unreachable, full handshake won't help
+        DAP_DEL_Z(l_client_pvt->resume);
+        s_enc_init_error(a_client, a_arg, a_err_code);
+        return;
+    }
+    log_it(L_INFO, "ENC: session resumption failed with code %d, make the full handshake", a_err_code);
+    s_resume_ticket_drop(l_client_pvt);
+    s_stage_status_after(l_client_pvt);
+}
+
 /**
  * @brief s_stream_ctl_response
  * @param a_client
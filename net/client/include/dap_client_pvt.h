@@ -78,6 +78,7 @@ typedef struct dap_client_pvt {
 
     dap_list_t *pkt_queue;
     dap_timerfd_t *reconnect_timer;
+    struct dap_client_resume *resume; // Session resumption ticket used for current ENC_INIT stage
 } dap_client_pvt_t;
 
 typedef struct dap_client_pkt_queue_elm {
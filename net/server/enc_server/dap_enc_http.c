@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 #ifdef DAP_OS_WINDOWS
 #include <winsock2.h>
@@ -52,34 +53,61 @@
 #include "dap_http_ban_list_client.h"
 #include "dap_cert.h"
 #include "dap_strfuncs.h"
+#include "dap_config.h"
+#include "dap_proc_thread.h"
+#include "dap_context.h"
+#include "dap_events.h"
 
 #define LOG_TAG "dap_enc_http"
 
 dap_stream_node_addr_t dap_stream_node_addr_from_sign(dap_sign_t *a_sign);
 
 static dap_enc_acl_callback_t s_acl_callback = NULL;
+static time_t s_resume_ttl = 600; // Session resumption ticket lifetime, 0 to disable resumption
+
+// Dedicated threads for handshakes key exchange and signs, they don't delay other requests and streams processing
+static dap_proc_thread_t *s_crypto_threads = NULL;
+static uint32_t s_crypto_threads_count = 0, s_crypto_queue_max = 0;
+static atomic_uint_fast32_t s_crypto_queue_size = 0;
 
 int enc_http_init()
 {
     dap_http_ban_list_client_init();
+    uint32_t l_cpu_count = dap_get_cpu_count();
+    s_crypto_threads_count = l_cpu_count > 1 ? l_cpu_count / 2 : 1;
+    if (g_config) {
+        s_resume_ttl = dap_config_get_item_uint32_default(g_config, "enc_http", "resume_ttl", s_resume_ttl);
+        dap_enc_ks_resume_set_count_max(dap_config_get_item_uint32_default(g_config, "enc_http", "resume_count_max", 0));
+        s_crypto_threads_count = dap_config_get_item_uint32_default(g_config, "enc_http", "crypto_threads", s_crypto_threads_count);
+        s_crypto_queue_max = dap_config_get_item_uint32_default(g_config, "enc_http", "crypto_queue_max", 0);
+    }
+    if (!s_crypto_queue_max)
+        s_crypto_queue_max = s_crypto_threads_count * 32;
     return 0;
 }
 
 void enc_http_deinit()
 {
-
+    for (uint32_t i = 0; s_crypto_threads && i < s_crypto_threads_count; i++)
+        dap_context_stop_n_kill(s_crypto_threads[i].context);
+    DAP_DEL_Z(s_crypto_threads);
 }
 
 static void _enc_http_write_reply(struct dap_http_simple *a_cl_st,
                                   const char* a_encrypt_id, int a_id_len,
                                   const char* a_encrypt_msg,int a_msg_len,
-                                  const char* a_node_sign,  int a_sign_len)
+                                  const char* a_node_sign,  int a_sign_len,
+                                  const char* a_resume_id, time_t a_resume_ttl)
 {
     struct json_object *l_jobj = json_object_new_object();
     json_object_object_add(l_jobj, "encrypt_id", json_object_new_string_len(a_encrypt_id, a_id_len));
     json_object_object_add(l_jobj, "encrypt_msg", json_object_new_string_len(a_encrypt_msg, a_msg_len));
     if (a_node_sign)
         json_object_object_add(l_jobj, "node_sign", json_object_new_string_len(a_node_sign, a_sign_len));
+    if (a_resume_id) {
+        json_object_object_add(l_jobj, "resume_id", json_object_new_string(a_resume_id));
+        json_object_object_add(l_jobj, "resume_ttl", json_object_new_int64(a_resume_ttl));
+    }
     json_object_object_add(l_jobj, "dap_protocol_version", json_object_new_int(DAP_PROTOCOL_VERSION));
     const char* l_json_str = json_object_to_json_string(l_jobj);
     dap_http_simple_reply(a_cl_st, (void*) l_json_str, (size_t) strlen(l_json_str));
@@ -94,141 +122,331 @@ void dap_enc_http_set_acl_callback(dap_enc_acl_callback_t a_callback)
 }
 
 /**
- * @brief enc_http_proc Enc http interface
- * @param cl_st HTTP Simple client instance
- * @param arg Pointer to bool with okay status (true if everything is ok, by default)
+ * @brief s_enc_http_resume_proc resume the session by the ticket issued on the full handshake.
+ * New session key is derived from the ticket secret and client nonce, no key exchange and signs are needed.
+ * Ticket is single-use, the next one with the rest of its lifetime is issued instead
+ * @param a_cl_st HTTP Simple client instance
+ * @param a_return_code HTTP status
  */
-void enc_http_proc(struct dap_http_simple *cl_st, void * arg)
+static void s_enc_http_resume_proc(struct dap_http_simple *a_cl_st, http_status_code_t *a_return_code)
 {
-    log_it(L_DEBUG,"Proc enc http request");
-    http_status_code_t * return_code = (http_status_code_t*)arg;
-
-    if(!strcmp(cl_st->http_client->url_path,"gd4y5yh78w42aaagh")) {
-        dap_enc_key_type_t l_pkey_exchange_type =DAP_ENC_KEY_TYPE_MSRLN ;
-        dap_enc_key_type_t l_enc_block_type = DAP_ENC_KEY_TYPE_IAES;
-        size_t l_pkey_exchange_size = MSRLN_PKA_BYTES;
-        size_t l_block_key_size=32;
-        int l_protocol_version = 0;
-        size_t l_sign_count = 0;
-        sscanf(cl_st->http_client->in_query_string, "enc_type=%d,pkey_exchange_type=%d,pkey_exchange_size=%zu,block_key_size=%zu,protocol_version=%d,sign_count=%zu",
-                                      &l_enc_block_type,&l_pkey_exchange_type,&l_pkey_exchange_size,&l_block_key_size, &l_protocol_version, &l_sign_count);
-
-        log_it(L_DEBUG, "Stream encryption: %s\t public key exchange: %s",dap_enc_get_type_name(l_enc_block_type),
-               dap_enc_get_type_name(l_pkey_exchange_type));
-        size_t l_decode_len = DAP_ENC_BASE64_DECODE_SIZE(cl_st->request_size);
-        uint8_t alice_msg[l_decode_len + 1];
-        l_decode_len = dap_enc_base64_decode(cl_st->request, cl_st->request_size, alice_msg, DAP_ENC_DATA_TYPE_B64);
-        alice_msg[l_decode_len] = '\0';
-        dap_chain_hash_fast_t l_sign_hash = {0};
-        if (!l_protocol_version && !l_sign_count) {
-            if (l_decode_len > l_pkey_exchange_size + sizeof(dap_sign_hdr_t)) {
-                l_sign_count = 1;
-            } else if (l_decode_len != l_pkey_exchange_size) {
-                /* No sign inside */
-                log_it(L_WARNING, "Wrong message size, without a valid sign must be = %zu", l_pkey_exchange_size);
-                *return_code = Http_Status_BadRequest;
-                return;
-            }
+    dap_enc_key_type_t l_enc_block_type = DAP_ENC_KEY_TYPE_IAES;
+    size_t l_block_key_size = 32;
+    char l_resume_id[DAP_ENC_KS_KEY_ID_SIZE] = { '\0' };
+    if (sscanf(a_cl_st->http_client->in_query_string, "enc_type=%d,block_key_size=%zu,resume_id=%32[A-Z]",
+               &l_enc_block_type, &l_block_key_size, l_resume_id) != 3) {
+        log_it(L_WARNING, "Wrong resume request query '%s'", a_cl_st->http_client->in_query_string);
+        *a_return_code = Http_Status_BadRequest;
+        return;
+    }
+    uint8_t l_nonce[DAP_ENC_BASE64_DECODE_SIZE(DAP_ENC_BASE64_ENCODE_SIZE(DAP_ENC_KS_RESUME_NONCE_SIZE)) + 1];
+    if (a_cl_st->request_size > DAP_ENC_BASE64_ENCODE_SIZE(DAP_ENC_KS_RESUME_NONCE_SIZE)
+            || dap_enc_base64_decode(a_cl_st->request, a_cl_st->request_size, l_nonce, DAP_ENC_DATA_TYPE_B64) != DAP_ENC_KS_RESUME_NONCE_SIZE) {
+        log_it(L_WARNING, "Wrong resume request nonce size");
+        *a_return_code = Http_Status_BadRequest;
+        return;
+    }
+    dap_enc_ks_resume_t l_resume;
+    if (!dap_enc_ks_resume_take(l_resume_id, &l_resume)) {
+        debug_if(dap_enc_debug_more(), L_DEBUG, "Resumption ticket %s not found, expired or already used", l_resume_id);
+        *a_return_code = Http_Status_Unauthorized;
+        return;
+    }
+    if (l_resume.node_addr.uint64) {
+        const char *l_client_node_addr_str = dap_stream_node_addr_to_str_static(l_resume.node_addr);
+        if (dap_http_ban_list_client_check(l_client_node_addr_str, NULL, NULL)) {
+            log_it(L_ERROR, "Client %s is banned.", l_client_node_addr_str);
+            memset(l_resume.secret, 0, sizeof(l_resume.secret));
+            *a_return_code = Http_Status_Forbidden;
+            return;
         }
+    }
+    dap_enc_ks_key_t *l_enc_key_ks = dap_enc_ks_new();
+    if (!l_enc_key_ks) {
+        memset(l_resume.secret, 0, sizeof(l_resume.secret));
+        *a_return_code = Http_Status_InternalServerError;
+        return;
+    }
+    dap_hash_fast_t l_proof;
+    l_enc_key_ks->key = dap_enc_ks_resume_key_make(l_resume.secret, l_nonce, l_enc_key_ks->id, DAP_ENC_KS_KEY_ID_SIZE,
+                                                   l_enc_block_type, l_block_key_size, &l_proof);
+    // issue the next ticket, it doesn't prolong the lifetime of the full handshake one
+    char l_next_id[DAP_ENC_KS_KEY_ID_SIZE] = { '\0' };
+    time_t l_next_ttl = l_resume.time_expire - time(NULL);
+    if (l_enc_key_ks->key && l_next_ttl > 0) {
+        uint8_t l_next_secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+        dap_enc_ks_resume_secret_next(l_resume.secret, l_nonce, l_next_secret);
+        if (dap_enc_ks_resume_add(l_next_secret, l_resume.node_addr, l_next_ttl, l_next_id))
+            *l_next_id = '\0';
+        memset(l_next_secret, 0, sizeof(l_next_secret));
+    }
+    memset(l_resume.secret, 0, sizeof(l_resume.secret));
+    if (!l_enc_key_ks->key) {
+        log_it(L_WARNING, "Can't resume session with key type %s", dap_enc_get_type_name(l_enc_block_type));
+        pthread_mutex_destroy(&l_enc_key_ks->mutex);
+        DAP_DELETE(l_enc_key_ks);
+        *a_return_code = Http_Status_BadRequest;
+        return;
+    }
+    if (s_acl_callback) {
+        dap_chain_hash_fast_t l_sign_hash = { };
+        l_enc_key_ks->acl_list = s_acl_callback(&l_sign_hash);
+    }
+    l_enc_key_ks->node_addr = l_resume.node_addr;
+    dap_enc_ks_save_in_storage(l_enc_key_ks);
+
+    char l_encrypt_id[DAP_ENC_BASE64_ENCODE_SIZE(DAP_ENC_KS_KEY_ID_SIZE) + 1] = { '\0' },
+         l_proof_str[DAP_ENC_BASE64_ENCODE_SIZE(sizeof(l_proof)) + 1] = { '\0' };
+    int l_enc_id_len = (int)dap_enc_base64_encode(l_enc_key_ks->id, sizeof(l_enc_key_ks->id), l_encrypt_id, DAP_ENC_DATA_TYPE_B64),
+        l_proof_len = (int)dap_enc_base64_encode(&l_proof, sizeof(l_proof), l_proof_str, DAP_ENC_DATA_TYPE_B64);
+    // Key confirmation goes in place of key exchange message
+    _enc_http_write_reply(a_cl_st, l_encrypt_id, l_enc_id_len, l_proof_str, l_proof_len, NULL, 0,
+                          *l_next_id ? l_next_id : NULL, l_next_ttl);
+    *a_return_code = Http_Status_OK;
+}
 
-        /* Verify all signs */
-        dap_sign_t *l_sign = NULL;
-        size_t l_bias = l_pkey_exchange_size;
-        size_t l_sign_validated_count = 0;
-        for(; l_sign_validated_count < l_sign_count && l_bias < l_decode_len; ++l_sign_validated_count) {
-            l_sign = (dap_sign_t *)&alice_msg[l_bias];
-            int l_verify_ret = dap_sign_verify_all(l_sign, l_decode_len - l_bias, alice_msg, l_pkey_exchange_size);
-            if (l_verify_ret) {
-                log_it(L_ERROR, "Can't authorize, sign verification didn't pass (err %d)", l_verify_ret);
-                *return_code = Http_Status_Unauthorized;
-                return;
-            }
-            l_bias += dap_sign_get_size(l_sign);
-            dap_stream_node_addr_t l_client_pkey_node_addr = dap_stream_node_addr_from_sign(l_sign);
-            const char *l_client_node_addr_str = dap_stream_node_addr_to_str_static(l_client_pkey_node_addr);
-            if (dap_http_ban_list_client_check(l_client_node_addr_str, NULL, NULL)) {
-                log_it(L_ERROR, "Client %s is banned.", l_client_node_addr_str);
-                *return_code = Http_Status_Forbidden;
-                return;
-            }
-        }
-        if (l_sign_validated_count != l_sign_count) {
-            log_it(L_ERROR, "Can't authorize all %zu signs", l_sign_count);
-            *return_code = Http_Status_Unauthorized;
+/**
+ * @brief s_enc_http_handshake_proc full handshake with key exchange and signs verification
+ * @param cl_st HTTP Simple client instance
+ * @param return_code HTTP status
+ */
+static void s_enc_http_handshake_proc(struct dap_http_simple *cl_st, http_status_code_t *return_code)
+{
+    dap_enc_key_type_t l_pkey_exchange_type =DAP_ENC_KEY_TYPE_MSRLN ;
+    dap_enc_key_type_t l_enc_block_type = DAP_ENC_KEY_TYPE_IAES;
+    size_t l_pkey_exchange_size = MSRLN_PKA_BYTES;
+    size_t l_block_key_size=32;
+    int l_protocol_version = 0;
+    size_t l_sign_count = 0;
+    sscanf(cl_st->http_client->in_query_string, "enc_type=%d,pkey_exchange_type=%d,pkey_exchange_size=%zu,block_key_size=%zu,protocol_version=%d,sign_count=%zu",
+                                  &l_enc_block_type,&l_pkey_exchange_type,&l_pkey_exchange_size,&l_block_key_size, &l_protocol_version, &l_sign_count);
+
+    log_it(L_DEBUG, "Stream encryption: %s\t public key exchange: %s",dap_enc_get_type_name(l_enc_block_type),
+           dap_enc_get_type_name(l_pkey_exchange_type));
+    size_t l_decode_len = DAP_ENC_BASE64_DECODE_SIZE(cl_st->request_size);
+    uint8_t alice_msg[l_decode_len + 1];
+    l_decode_len = dap_enc_base64_decode(cl_st->request, cl_st->request_size, alice_msg, DAP_ENC_DATA_TYPE_B64);
+    alice_msg[l_decode_len] = '\0';
+    dap_chain_hash_fast_t l_sign_hash = {0};
+    if (!l_protocol_version && !l_sign_count) {
+        if (l_decode_len > l_pkey_exchange_size + sizeof(dap_sign_hdr_t)) {
+            l_sign_count = 1;
+        } else if (l_decode_len != l_pkey_exchange_size) {
+            /* No sign inside */
+            log_it(L_WARNING, "Wrong message size, without a valid sign must be = %zu", l_pkey_exchange_size);
+            *return_code = Http_Status_BadRequest;
             return;
         }
+    }
 
-        dap_enc_key_t* l_pkey_exchange_key = dap_enc_key_new(l_pkey_exchange_type);
-        if(! l_pkey_exchange_key){
-            log_it(L_WARNING, "Wrong http_enc request. Can't init PKey exchange with type %s", dap_enc_get_type_name(l_pkey_exchange_type) );
-            *return_code = Http_Status_BadRequest;
+    /* Verify all signs */
+    dap_sign_t *l_sign = NULL;
+    size_t l_bias = l_pkey_exchange_size;
+    size_t l_sign_validated_count = 0;
+    for(; l_sign_validated_count < l_sign_count && l_bias < l_decode_len; ++l_sign_validated_count) {
+        l_sign = (dap_sign_t *)&alice_msg[l_bias];
+        int l_verify_ret = dap_sign_verify_all(l_sign, l_decode_len - l_bias, alice_msg, l_pkey_exchange_size);
+        if (l_verify_ret) {
+            log_it(L_ERROR, "Can't authorize, sign verification didn't pass (err %d)", l_verify_ret);
+            *return_code = Http_Status_Unauthorized;
             return;
         }
-        if(l_pkey_exchange_key->gen_bob_shared_key) {
-            l_pkey_exchange_key->pub_key_data_size = l_pkey_exchange_key->gen_bob_shared_key(l_pkey_exchange_key, alice_msg, l_pkey_exchange_size,
-                    &l_pkey_exchange_key->pub_key_data);
+        l_bias += dap_sign_get_size(l_sign);
+        dap_stream_node_addr_t l_client_pkey_node_addr = dap_stream_node_addr_from_sign(l_sign);
+        const char *l_client_node_addr_str = dap_stream_node_addr_to_str_static(l_client_pkey_node_addr);
+        if (dap_http_ban_list_client_check(l_client_node_addr_str, NULL, NULL)) {
+            log_it(L_ERROR, "Client %s is banned.", l_client_node_addr_str);
+            *return_code = Http_Status_Forbidden;
+            return;
         }
+    }
+    if (l_sign_validated_count != l_sign_count) {
+        log_it(L_ERROR, "Can't authorize all %zu signs", l_sign_count);
+        *return_code = Http_Status_Unauthorized;
+        return;
+    }
 
-        dap_enc_ks_key_t *l_enc_key_ks = dap_enc_ks_new();
-        dap_return_if_pass(!l_enc_key_ks);
-        if (s_acl_callback) {
-            l_enc_key_ks->acl_list = s_acl_callback(&l_sign_hash);
-        } else {
-            log_it(L_DEBUG, "Callback for ACL is not set, pass anauthorized");
-        }
+    dap_enc_key_t* l_pkey_exchange_key = dap_enc_key_new(l_pkey_exchange_type);
+    if(! l_pkey_exchange_key){
+        log_it(L_WARNING, "Wrong http_enc request. Can't init PKey exchange with type %s", dap_enc_get_type_name(l_pkey_exchange_type) );
+        *return_code = Http_Status_BadRequest;
+        return;
+    }
+    if(l_pkey_exchange_key->gen_bob_shared_key) {
+        l_pkey_exchange_key->pub_key_data_size = l_pkey_exchange_key->gen_bob_shared_key(l_pkey_exchange_key, alice_msg, l_pkey_exchange_size,
+                &l_pkey_exchange_key->pub_key_data);
+    }
+
+    dap_enc_ks_key_t *l_enc_key_ks = dap_enc_ks_new();
+    dap_return_if_pass(!l_enc_key_ks);
+    if (s_acl_callback) {
+        l_enc_key_ks->acl_list = s_acl_callback(&l_sign_hash);
+    } else {
+        log_it(L_DEBUG, "Callback for ACL is not set, pass anauthorized");
+    }
+
+    char    *encrypt_msg = DAP_NEW_Z_SIZE(char, DAP_ENC_BASE64_ENCODE_SIZE(l_pkey_exchange_key->pub_key_data_size) + 1),
+            encrypt_id[DAP_ENC_BASE64_ENCODE_SIZE(DAP_ENC_KS_KEY_ID_SIZE) + 1] = { '\0' };
+    int l_enc_msg_len = (int)dap_enc_base64_encode( l_pkey_exchange_key->pub_key_data,
+                                                    l_pkey_exchange_key->pub_key_data_size,
+                                                    encrypt_msg, DAP_ENC_DATA_TYPE_B64);
+
+    l_enc_key_ks->key = dap_enc_key_new_generate(l_enc_block_type,
+                                           l_pkey_exchange_key->priv_key_data, // shared key
+                                           l_pkey_exchange_key->priv_key_data_size,
+                                           l_enc_key_ks->id, DAP_ENC_KS_KEY_ID_SIZE, l_block_key_size);
     
-        char    *encrypt_msg = DAP_NEW_Z_SIZE(char, DAP_ENC_BASE64_ENCODE_SIZE(l_pkey_exchange_key->pub_key_data_size) + 1),
-                encrypt_id[DAP_ENC_BASE64_ENCODE_SIZE(DAP_ENC_KS_KEY_ID_SIZE) + 1] = { '\0' };
-        int l_enc_msg_len = (int)dap_enc_base64_encode( l_pkey_exchange_key->pub_key_data,
-                                                        l_pkey_exchange_key->pub_key_data_size,
-                                                        encrypt_msg, DAP_ENC_DATA_TYPE_B64);
-
-        l_enc_key_ks->key = dap_enc_key_new_generate(l_enc_block_type,
-                                               l_pkey_exchange_key->priv_key_data, // shared key
-                                               l_pkey_exchange_key->priv_key_data_size,
-                                               l_enc_key_ks->id, DAP_ENC_KS_KEY_ID_SIZE, l_block_key_size);
-        
-        dap_enc_ks_save_in_storage(l_enc_key_ks);
-        int l_enc_id_len = (int)dap_enc_base64_encode(l_enc_key_ks->id, sizeof (l_enc_key_ks->id), 
-                                                      encrypt_id, DAP_ENC_DATA_TYPE_B64),
-            l_node_msg_len = 0;
-
-        // save verified node addr and generate own sign
-        char* l_node_sign_msg = NULL;
-        if (l_protocol_version && l_sign_count) {
-            l_enc_key_ks->node_addr = dap_stream_node_addr_from_sign(l_sign);
-
-            dap_cert_t *l_node_cert = dap_cert_find_by_name(DAP_STREAM_NODE_ADDR_CERT_NAME);
-            dap_sign_t *l_node_sign = dap_sign_create(l_node_cert->enc_key,l_pkey_exchange_key->pub_key_data, l_pkey_exchange_key->pub_key_data_size);
-            if (!l_node_sign) {
-                dap_enc_key_delete(l_pkey_exchange_key);
-                DAP_DELETE(encrypt_msg);
-                *return_code = Http_Status_InternalServerError;
-                return;
-            }
-            size_t l_node_sign_size = dap_sign_get_size(l_node_sign);
-            size_t l_node_sign_size_new = DAP_ENC_BASE64_ENCODE_SIZE(l_node_sign_size) + 1;
+    dap_enc_ks_save_in_storage(l_enc_key_ks);
+    int l_enc_id_len = (int)dap_enc_base64_encode(l_enc_key_ks->id, sizeof (l_enc_key_ks->id), 
+                                                  encrypt_id, DAP_ENC_DATA_TYPE_B64),
+        l_node_msg_len = 0;
+
+    // save verified node addr and generate own sign
+    char* l_node_sign_msg = NULL;
+    if (l_protocol_version && l_sign_count) {
+        l_enc_key_ks->node_addr = dap_stream_node_addr_from_sign(l_sign);
+
+        dap_cert_t *l_node_cert = dap_cert_find_by_name(DAP_STREAM_NODE_ADDR_CERT_NAME);
+        dap_sign_t *l_node_sign = dap_sign_create(l_node_cert->enc_key,l_pkey_exchange_key->pub_key_data, l_pkey_exchange_key->pub_key_data_size);
+        if (!l_node_sign) {
+            dap_enc_key_delete(l_pkey_exchange_key);
+            DAP_DELETE(encrypt_msg);
+            *return_code = Http_Status_InternalServerError;
+            return;
+        }
+        size_t l_node_sign_size = dap_sign_get_size(l_node_sign);
+        size_t l_node_sign_size_new = DAP_ENC_BASE64_ENCODE_SIZE(l_node_sign_size) + 1;
 
-            l_node_sign_msg = DAP_NEW_Z_SIZE(char, l_node_sign_size_new);
-            if (!l_node_sign_msg) {
-                log_it(L_CRITICAL, "%s", c_error_memory_alloc);
-                dap_enc_key_delete(l_pkey_exchange_key);
-                *return_code = Http_Status_InternalServerError;
-                DAP_DELETE(encrypt_msg);
-                DAP_DELETE(l_node_sign);
-                return;
-            }
-            l_node_msg_len = (int)dap_enc_base64_encode(l_node_sign, l_node_sign_size, l_node_sign_msg, DAP_ENC_DATA_TYPE_B64);
+        l_node_sign_msg = DAP_NEW_Z_SIZE(char, l_node_sign_size_new);
+        if (!l_node_sign_msg) {
+            log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+            dap_enc_key_delete(l_pkey_exchange_key);
+            *return_code = Http_Status_InternalServerError;
+            DAP_DELETE(encrypt_msg);
             DAP_DELETE(l_node_sign);
+            return;
         }
+        l_node_msg_len = (int)dap_enc_base64_encode(l_node_sign, l_node_sign_size, l_node_sign_msg, DAP_ENC_DATA_TYPE_B64);
+        DAP_DELETE(l_node_sign);
+    }
+
+    // issue resumption ticket, so the client could skip key exchange on reconnect
+    char l_resume_id[DAP_ENC_KS_KEY_ID_SIZE] = { '\0' };
+    if (s_resume_ttl) {
+        uint8_t l_resume_secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+        dap_enc_ks_resume_secret_make(l_pkey_exchange_key->priv_key_data, l_pkey_exchange_key->priv_key_data_size, l_resume_secret);
+        if (dap_enc_ks_resume_add(l_resume_secret, l_enc_key_ks->node_addr, s_resume_ttl, l_resume_id))
+            *l_resume_id = '\0';
+        memset(l_resume_secret, 0, sizeof(l_resume_secret));
+    }
+
+    _enc_http_write_reply(cl_st, encrypt_id, l_enc_id_len, encrypt_msg, l_enc_msg_len, l_node_sign_msg, l_node_msg_len,
+                          *l_resume_id ? l_resume_id : NULL, s_resume_ttl);
+    DAP_DELETE(encrypt_msg);
+    dap_enc_key_delete(l_pkey_exchange_key);
+    DAP_DEL_Z(l_node_sign_msg);
+
+    *return_code = Http_Status_OK;
+}
 
-        _enc_http_write_reply(cl_st, encrypt_id, l_enc_id_len, encrypt_msg, l_enc_msg_len, l_node_sign_msg, l_node_msg_len);
-        DAP_DELETE(encrypt_msg);
-        dap_enc_key_delete(l_pkey_exchange_key);
-        DAP_DEL_Z(l_node_sign_msg);
+/**
+ * @brief s_crypto_pool_callback handshake processing in the crypto pool thread
+ * @param a_arg HTTP Simple client instance
+ * @return false
+ */
+static bool s_crypto_pool_callback(void *a_arg)
+{
+    struct dap_http_simple *l_http_simple = a_arg;
+    http_status_code_t l_return_code = (http_status_code_t)0;
+    s_enc_http_handshake_proc(l_http_simple, &l_return_code);
+    atomic_fetch_sub(&s_crypto_queue_size, 1);
+    dap_http_simple_proc_done(l_http_simple, l_return_code);
+    return false;
+}
 
-        *return_code = Http_Status_OK;
+static pthread_once_t s_crypto_pool_once = PTHREAD_ONCE_INIT;
 
+static void s_crypto_pool_start()
+{
+    s_crypto_threads = DAP_NEW_Z_COUNT(dap_proc_thread_t, s_crypto_threads_count);
+    if (!s_crypto_threads) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        s_crypto_threads_count = 0;
+        return;
+    }
+    uint32_t i = 0;
+    for (; i < s_crypto_threads_count; i++)
+        if (dap_proc_thread_create(s_crypto_threads + i, -1))
+            break;
+    if ( !(s_crypto_threads_count = i) ) {
+        log_it(L_ERROR, "Can't start crypto pool, handshakes will be processed in place");
+        DAP_DEL_Z(s_crypto_threads);
+    } else
+        log_it(L_INFO, "Crypto pool started with %u threads, queue limit %u", s_crypto_threads_count, s_crypto_queue_max);
+}
+
+/**
+ * @brief s_crypto_pool_add pass handshake to the crypto pool, if it's not overloaded
+ * @param a_http_simple HTTP Simple client instance
+ * @return true if the handshake is queued
+ */
+static bool s_crypto_pool_add(struct dap_http_simple *a_http_simple)
+{
+    if (atomic_fetch_add(&s_crypto_queue_size, 1) >= s_crypto_queue_max) {
+        atomic_fetch_sub(&s_crypto_queue_size, 1);
+        return false;
+    }
+    static atomic_uint_fast32_t s_crypto_thread_next = 0;
+    dap_http_simple_proc_defer(a_http_simple);
+    dap_proc_thread_callback_add(s_crypto_threads + atomic_fetch_add(&s_crypto_thread_next, 1) % s_crypto_threads_count,
+                                 s_crypto_pool_callback, a_http_simple);
+    return true;
+}
+
+/**
+ * @brief dap_enc_http_set_crypto_pool set handshakes crypto pool size, before the first handshake only
+ * @param a_threads_count crypto threads count, 0 to process handshakes in place
+ * @param a_queue_max handshakes in processing limit, 0 means default
+ */
+void dap_enc_http_set_crypto_pool(uint32_t a_threads_count, uint32_t a_queue_max)
+{
+    if (s_crypto_threads)
+        return log_it(L_WARNING, "Crypto pool is already started");
+    s_crypto_threads_count = a_threads_count;
+    s_crypto_queue_max = a_queue_max ? a_queue_max : a_threads_count * 32;
+}
+
+/**
+ * @brief dap_enc_http_get_crypto_queue_size
+ * @return handshakes count queued or processing in the crypto pool
+ */
+uint32_t dap_enc_http_get_crypto_queue_size(void)
+{
+    return atomic_load(&s_crypto_queue_size);
+}
+
+/**
+ * @brief enc_http_proc Enc http interface
+ * @param cl_st HTTP Simple client instance
+ * @param arg Pointer to bool with okay status (true if everything is ok, by default)
+ */
+void enc_http_proc(struct dap_http_simple *cl_st, void * arg)
+{
+    log_it(L_DEBUG,"Proc enc http request");
+    http_status_code_t * return_code = (http_status_code_t*)arg;
+
+    if(!strcmp(cl_st->http_client->url_path,"gd4y5yh78w42aaagh")) {
+        if (s_crypto_threads_count)
+            pthread_once(&s_crypto_pool_once, s_crypto_pool_start);
+        if (!s_crypto_threads_count)
+            s_enc_http_handshake_proc(cl_st, return_code);
+        else if (!s_crypto_pool_add(cl_st)) {
+            // Shed new handshakes, established sessions have to be served
+            log_it(L_WARNING, "Crypto pool is overloaded, reject the handshake");
+            *return_code = Http_Status_ServiceUnavailable;
+        }
+    } else if (!strcmp(cl_st->http_client->url_path, "resume")) {
+        s_enc_http_resume_proc(cl_st, return_code);
     } else{
         log_it(L_ERROR,"Wrong path '%s' in the request to enc_http module",cl_st->http_client->url_path);
         *return_code = Http_Status_NotFound;
@@ -38,13 +38,22 @@
 #include "dap_enc.h"
 #include "include/dap_enc_ks.h"
 #include "dap_enc_key.h"
+#include "dap_hash.h"
+#include "rand/dap_rand.h"
 
 #define LOG_TAG "dap_enc_ks"
 
+#define DAP_ENC_KS_RESUME_SWEEP_PERIOD 60
+
 static dap_enc_ks_key_t * _ks = NULL;
 static bool s_memcache_enable = false;
 static time_t s_memcache_expiration_key = 0;
 
+static dap_enc_ks_resume_t *s_resume = NULL;
+static pthread_rwlock_t s_resume_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static time_t s_resume_sweep_time = 0;
+static size_t s_resume_count_max = DAP_ENC_KS_RESUME_COUNT_MAX;
+
 static void s_enc_key_free(dap_enc_ks_key_t **ptr);
 
 void dap_enc_ks_deinit()
@@ -57,6 +66,13 @@ void dap_enc_ks_deinit()
             s_enc_key_free(&cur_item);
         }
     }
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    dap_enc_ks_resume_t *l_resume, *l_tmp;
+    HASH_ITER(hh, s_resume, l_resume, l_tmp) {
+        HASH_DEL(s_resume, l_resume);
+        DAP_DELETE(l_resume);
+    }
+    pthread_rwlock_unlock(&s_resume_rwlock);
 }
 
 inline static void s_gen_session_id(char a_id_buf[DAP_ENC_KS_KEY_ID_SIZE])
@@ -178,3 +194,187 @@ static void s_enc_key_free(dap_enc_ks_key_t **ptr)
         DAP_DELETE(*ptr);
     }
 }
+
+/**
+ * @brief dap_enc_ks_resume_secret_make derive resumption secret from the key exchange shared key.
+ * Both client and server make it after the full handshake
+ * @param a_shared_key key exchange shared key
+ * @param a_shared_key_size its size
+ * @param a_secret_out DAP_ENC_KS_RESUME_SECRET_SIZE bytes buffer
+ */
+void dap_enc_ks_resume_secret_make(const void *a_shared_key, size_t a_shared_key_size, uint8_t *a_secret_out)
+{
+    static const char c_label[] = "dap_enc_ks_resume";
+    byte_t l_buf[a_shared_key_size + sizeof(c_label)];
+    memcpy(l_buf, a_shared_key, a_shared_key_size);
+    memcpy(l_buf + a_shared_key_size, c_label, sizeof(c_label));
+    dap_hash_fast_t l_hash;
+    dap_hash_fast(l_buf, sizeof(l_buf), &l_hash);
+    memcpy(a_secret_out, l_hash.raw, DAP_ENC_KS_RESUME_SECRET_SIZE);
+    memset(l_buf, 0, sizeof(l_buf));
+}
+
+/**
+ * @brief dap_enc_ks_resume_secret_next derive the secret of the ticket issued on resumption instead of the used one
+ * @param a_secret used ticket resumption secret
+ * @param a_nonce client nonce of the resumption, DAP_ENC_KS_RESUME_NONCE_SIZE bytes
+ * @param a_secret_out DAP_ENC_KS_RESUME_SECRET_SIZE bytes buffer
+ */
+void dap_enc_ks_resume_secret_next(const uint8_t *a_secret, const uint8_t *a_nonce, uint8_t *a_secret_out)
+{
+    byte_t l_buf[DAP_ENC_KS_RESUME_SECRET_SIZE + DAP_ENC_KS_RESUME_NONCE_SIZE];
+    memcpy(l_buf, a_secret, DAP_ENC_KS_RESUME_SECRET_SIZE);
+    memcpy(l_buf + DAP_ENC_KS_RESUME_SECRET_SIZE, a_nonce, DAP_ENC_KS_RESUME_NONCE_SIZE);
+    dap_enc_ks_resume_secret_make(l_buf, sizeof(l_buf), a_secret_out);
+    memset(l_buf, 0, sizeof(l_buf));
+}
+
+/**
+ * @brief dap_enc_ks_resume_key_make derive resumed session key from resumption secret and client nonce
+ * @param a_secret resumption secret
+ * @param a_nonce client nonce, DAP_ENC_KS_RESUME_NONCE_SIZE bytes
+ * @param a_key_id new session key id, used as the key seed like in the full handshake
+ * @param a_key_id_size its size
+ * @param a_key_type session key type
+ * @param a_key_size session key size
+ * @param a_proof_out server proves it knows the secret with it, could be NULL
+ * @return session key or NULL
+ */
+dap_enc_key_t *dap_enc_ks_resume_key_make(const uint8_t *a_secret, const uint8_t *a_nonce, const void *a_key_id, size_t a_key_id_size,
+                                          dap_enc_key_type_t a_key_type, size_t a_key_size, dap_hash_fast_t *a_proof_out)
+{
+    dap_return_val_if_fail(a_secret && a_nonce && a_key_id, NULL);
+    byte_t l_buf[DAP_ENC_KS_RESUME_SECRET_SIZE + DAP_ENC_KS_RESUME_NONCE_SIZE];
+    memcpy(l_buf, a_secret, DAP_ENC_KS_RESUME_SECRET_SIZE);
+    memcpy(l_buf + DAP_ENC_KS_RESUME_SECRET_SIZE, a_nonce, DAP_ENC_KS_RESUME_NONCE_SIZE);
+    dap_hash_fast_t l_kex;
+    dap_hash_fast(l_buf, sizeof(l_buf), &l_kex);
+    memset(l_buf, 0, sizeof(l_buf));
+    if (a_proof_out) {
+        byte_t l_proof_buf[sizeof(l_kex) + a_key_id_size];
+        memcpy(l_proof_buf, &l_kex, sizeof(l_kex));
+        memcpy(l_proof_buf + sizeof(l_kex), a_key_id, a_key_id_size);
+        dap_hash_fast(l_proof_buf, sizeof(l_proof_buf), a_proof_out);
+        memset(l_proof_buf, 0, sizeof(l_kex));
+    }
+    dap_enc_key_t *l_ret = dap_enc_key_new_generate(a_key_type, &l_kex, sizeof(l_kex), a_key_id, a_key_id_size, a_key_size);
+    memset(&l_kex, 0, sizeof(l_kex));
+    return l_ret;
+}
+
+static void s_resume_sweep_unsafe(time_t a_now)
+{
+    if (a_now < s_resume_sweep_time)
+        return;
+    dap_enc_ks_resume_t *l_resume, *l_tmp;
+    HASH_ITER(hh, s_resume, l_resume, l_tmp) {
+        if (l_resume->time_expire <= a_now) {
+            HASH_DEL(s_resume, l_resume);
+            DAP_DELETE(l_resume);
+        }
+    }
+    s_resume_sweep_time = a_now + DAP_ENC_KS_RESUME_SWEEP_PERIOD;
+}
+
+// Hash keeps tickets in the order they're added, so the head is the oldest one
+static void s_resume_evict_unsafe(size_t a_count_max)
+{
+    while (s_resume && HASH_COUNT(s_resume) >= a_count_max) {
+        dap_enc_ks_resume_t *l_resume = s_resume;
+        HASH_DEL(s_resume, l_resume);
+        memset(l_resume->secret, 0, sizeof(l_resume->secret));
+        DAP_DELETE(l_resume);
+    }
+}
+
+/**
+ * @brief dap_enc_ks_resume_add save resumption ticket, expired ones are removed by the way,
+ *        the oldest one is dropped if there are too many of them
+ * @param a_secret resumption secret
+ * @param a_node_addr verified client node address
+ * @param a_ttl ticket lifetime, seconds
+ * @param a_id_out DAP_ENC_KS_KEY_ID_SIZE bytes buffer for null-terminated ticket id
+ * @return 0 if ok
+ */
+int dap_enc_ks_resume_add(const uint8_t *a_secret, dap_stream_node_addr_t a_node_addr, time_t a_ttl, char *a_id_out)
+{
+    dap_return_val_if_fail(a_secret && a_ttl > 0 && a_id_out, -1);
+    dap_enc_ks_resume_t *l_resume = DAP_NEW_Z_RET_VAL_IF_FAIL(dap_enc_ks_resume_t, -2);
+    uint8_t l_rnd[DAP_ENC_KS_KEY_ID_SIZE - 1];
+    randombytes(l_rnd, sizeof(l_rnd));
+    for (size_t i = 0; i < sizeof(l_rnd); i++)
+        l_resume->id[i] = 'A' + l_rnd[i] % 26;
+    memcpy(l_resume->secret, a_secret, DAP_ENC_KS_RESUME_SECRET_SIZE);
+    l_resume->node_addr = a_node_addr;
+    time_t l_now = time(NULL);
+    l_resume->time_expire = l_now + a_ttl;
+    dap_enc_ks_resume_t *l_exists = NULL;
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    s_resume_sweep_unsafe(l_now);
+    HASH_FIND_STR(s_resume, l_resume->id, l_exists);
+    if (!l_exists) {
+        s_resume_evict_unsafe(s_resume_count_max);
+        HASH_ADD_STR(s_resume, id, l_resume);
+    }
+    pthread_rwlock_unlock(&s_resume_rwlock);
+    if (l_exists) {
+        log_it(L_WARNING, "Resumption ticket id collision");
+        DAP_DELETE(l_resume);
+        return -3;
+    }
+    memcpy(a_id_out, l_resume->id, DAP_ENC_KS_KEY_ID_SIZE);
+    return 0;
+}
+
+/**
+ * @brief dap_enc_ks_resume_take find not expired resumption ticket and remove it, so every ticket is single-use
+ * @param a_id ticket id
+ * @param a_resume_out ticket copy
+ * @return true if found
+ */
+bool dap_enc_ks_resume_take(const char *a_id, dap_enc_ks_resume_t *a_resume_out)
+{
+    dap_return_val_if_fail(a_id && a_resume_out, false);
+    dap_enc_ks_resume_t *l_resume = NULL;
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    HASH_FIND_STR(s_resume, a_id, l_resume);
+    if (l_resume)
+        HASH_DEL(s_resume, l_resume);
+    pthread_rwlock_unlock(&s_resume_rwlock);
+    if (!l_resume)
+        return false;
+    bool l_ret = l_resume->time_expire > time(NULL);
+    if (l_ret)
+        *a_resume_out = *l_resume;
+    memset(l_resume->secret, 0, sizeof(l_resume->secret));
+    DAP_DELETE(l_resume);
+    return l_ret;
+}
+
+/**
+ * @brief dap_enc_ks_resume_delete revoke resumption ticket
+ * @param a_id ticket id
+ */
+void dap_enc_ks_resume_delete(const char *a_id)
+{
+    dap_return_if_fail(a_id);
+    dap_enc_ks_resume_t *l_resume = NULL;
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    HASH_FIND_STR(s_resume, a_id, l_resume);
+    if (l_resume)
+        HASH_DEL(s_resume, l_resume);
+    pthread_rwlock_unlock(&s_resume_rwlock);
+    DAP_DEL_Z(l_resume);
+}
+
+/**
+ * @brief dap_enc_ks_resume_set_count_max limit stored tickets count
+ * @param a_count_max max tickets count, DAP_ENC_KS_RESUME_COUNT_MAX if 0
+ */
+void dap_enc_ks_resume_set_count_max(size_t a_count_max)
+{
+    pthread_rwlock_wrlock(&s_resume_rwlock);
+    s_resume_count_max = a_count_max ? a_count_max : DAP_ENC_KS_RESUME_COUNT_MAX;
+    s_resume_evict_unsafe(s_resume_count_max + 1);
+    pthread_rwlock_unlock(&s_resume_rwlock);
+}
@@ -72,6 +72,9 @@ size_t enc_http_reply(enc_http_delegate_t *a_http_delegate, const void *a_data,
 DAP_PRINTF_ATTR(2, 3) size_t enc_http_reply_f(enc_http_delegate_t *a_http_delegate, const char * a_data, ...);
 
 void dap_enc_http_set_acl_callback(dap_enc_acl_callback_t a_callback);
+// Crypto pool settings, have effect until the first handshake only. Zero threads count means in place processing
+void dap_enc_http_set_crypto_pool(uint32_t a_threads_count, uint32_t a_queue_max);
+uint32_t dap_enc_http_get_crypto_queue_size(void);
 
 enc_http_delegate_t *enc_http_request_decode(struct dap_http_simple *a_http_simple);
 
@@ -79,6 +82,7 @@ void enc_http_reply_encode(struct dap_http_simple *a_http_simple,enc_http_delega
 
 void enc_http_delegate_delete(enc_http_delegate_t * dg);
 
+void enc_http_proc(struct dap_http_simple *cl_st, void *arg);
 void enc_http_add_proc(struct dap_http_server *sh, const char * url);
 
 #endif
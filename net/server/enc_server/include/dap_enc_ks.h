@@ -25,6 +25,7 @@
 #include "uthash.h"
 #include "dap_common.h"
 #include "dap_enc_key.h"
+#include "dap_hash.h"
 #include "stdbool.h"
 
 // TODO rewrite code for remove this module (with no stream setting sockets disconnects)
@@ -32,6 +33,10 @@
 #define DAP_STREAM_NODE_ADDR_CERT_TYPE DAP_ENC_KEY_TYPE_SIG_DILITHIUM
 
 #define DAP_ENC_KS_KEY_ID_SIZE 33
+// Session resumption ticket, lets returning client derive a new session key without key exchange
+#define DAP_ENC_KS_RESUME_SECRET_SIZE 32
+#define DAP_ENC_KS_RESUME_NONCE_SIZE 32
+#define DAP_ENC_KS_RESUME_COUNT_MAX 65536 // Stored tickets, the oldest one is dropped to add a new one over it
 struct dap_http_client;
 typedef struct dap_enc_key dap_enc_key_t;
 typedef struct dap_enc_ks_key{
@@ -44,6 +49,14 @@ typedef struct dap_enc_ks_key{
     UT_hash_handle hh; // makes this structure hashable with UTHASH library
 } dap_enc_ks_key_t;
 
+typedef struct dap_enc_ks_resume {
+    char id[DAP_ENC_KS_KEY_ID_SIZE]; // Null-terminated
+    uint8_t secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+    time_t time_expire;
+    dap_stream_node_addr_t node_addr;
+    UT_hash_handle hh;
+} dap_enc_ks_resume_t;
+
 void dap_enc_ks_deinit();
 
 dap_enc_ks_key_t * dap_enc_ks_find(const char * v_id);
@@ -55,4 +68,13 @@ dap_enc_ks_key_t * dap_enc_ks_add(struct dap_enc_key * key);
 bool dap_enc_ks_save_in_storage(dap_enc_ks_key_t* key);
 void dap_enc_ks_delete(const char *id);
 
+void dap_enc_ks_resume_secret_make(const void *a_shared_key, size_t a_shared_key_size, uint8_t *a_secret_out);
+void dap_enc_ks_resume_secret_next(const uint8_t *a_secret, const uint8_t *a_nonce, uint8_t *a_secret_out);
+dap_enc_key_t *dap_enc_ks_resume_key_make(const uint8_t *a_secret, const uint8_t *a_nonce, const void *a_key_id, size_t a_key_id_size,
+                                          dap_enc_key_type_t a_key_type, size_t a_key_size, dap_hash_fast_t *a_proof_out);
+int dap_enc_ks_resume_add(const uint8_t *a_secret, dap_stream_node_addr_t a_node_addr, time_t a_ttl, char *a_id_out);
+bool dap_enc_ks_resume_take(const char *a_id, dap_enc_ks_resume_t *a_resume_out);
+void dap_enc_ks_resume_delete(const char *a_id);
+void dap_enc_ks_resume_set_count_max(size_t a_count_max);
+
 #endif
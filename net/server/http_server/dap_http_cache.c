@@ -20,37 +20,142 @@
     You should have received a copy of the GNU General Public License
     along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <pthread.h>
 #include "utlist.h"
+#include "dap_config.h"
+#include "dap_hash.h"
+#include "dap_strfuncs.h"
 #include "dap_http_server.h"
 #include "dap_http_cache.h"
+#include "dap_http_compress.h"
+#include "http_status_code.h"
 
 #define LOG_TAG "http_cache"
 
+#define DAP_HTTP_CACHE_SIZE_MAX_DEFAULT     64                              /* MB */
+
+static pthread_mutex_t s_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static dap_http_cache_t *s_cache_table = NULL, *s_cache_lru = NULL;
+static size_t s_cache_size = 0, s_cache_count = 0,
+              s_cache_size_max = DAP_HTTP_CACHE_SIZE_MAX_DEFAULT * 1024 * 1024;
+
+/**
+ * @brief dap_http_cache_init Read memory limit for all cached replies
+ * @return 0
+ */
+int dap_http_cache_init()
+{
+    s_cache_size_max = (size_t)dap_config_get_item_uint32_default(g_config, "http", "cache_size_max",
+                                                                  DAP_HTTP_CACHE_SIZE_MAX_DEFAULT) * 1024 * 1024;
+    return 0;
+}
+
 /**
- * @brief dap_http_cache_update
- * @param a_url_proc
+ * @brief dap_http_cache_deinit Drop all cached replies which are not being sent now
+ */
+void dap_http_cache_deinit()
+{
+    dap_http_cache_invalidate(NULL);
+}
+
+static void s_cache_unlink(dap_http_cache_t *a_cache)
+{
+    HASH_DEL(s_cache_table, a_cache);
+    DL_DELETE(s_cache_lru, a_cache);
+    s_cache_size -= a_cache->mem_size;
+    s_cache_count--;
+    a_cache->linked = false;
+    if (!--a_cache->refs)
+        dap_http_cache_delete(a_cache);
+}
+
+static void s_cache_shrink(size_t a_size_max)
+{
+    while (s_cache_size > a_size_max && s_cache_lru)
+        s_cache_unlink(s_cache_lru->prev);                                  /* Head's prev is the tail, the least recently used */
+}
+
+void dap_http_cache_set_size_max(size_t a_size_max)
+{
+    pthread_mutex_lock(&s_cache_mutex);
+    s_cache_size_max = a_size_max;
+    s_cache_shrink(a_size_max);
+    pthread_mutex_unlock(&s_cache_mutex);
+}
+
+size_t dap_http_cache_get_size()
+{
+    pthread_mutex_lock(&s_cache_mutex);
+    size_t l_ret = s_cache_size;
+    pthread_mutex_unlock(&s_cache_mutex);
+    return l_ret;
+}
+
+size_t dap_http_cache_get_count()
+{
+    pthread_mutex_lock(&s_cache_mutex);
+    size_t l_ret = s_cache_count;
+    pthread_mutex_unlock(&s_cache_mutex);
+    return l_ret;
+}
+
+/**
+ * @brief dap_http_cache_set_proc_ttl Set cache policy for URL processor
+ * @param a_url_proc URL processor
+ * @param a_ttl Seconds to keep the successful GET replies in cache, 0 disables caching and drops cached ones
+ */
+void dap_http_cache_set_proc_ttl(struct dap_http_url_proc *a_url_proc, time_t a_ttl)
+{
+    a_url_proc->cache_ttl = a_ttl;
+    if (!a_ttl)
+        dap_http_cache_invalidate(a_url_proc);
+}
+
+/**
+ * @brief s_cache_key Make cache key from request line, only GET replies are cached
+ * @return Key length or 0 if the request is not cacheable
+ */
+static size_t s_cache_key(dap_http_client_t *a_http_client, char *a_key, size_t a_key_size)
+{
+    if (!a_http_client->proc || strcmp(a_http_client->action, "GET"))
+        return 0;
+    int l_len = snprintf(a_key, a_key_size, "GET %s/%s?%s", a_http_client->proc->url, a_http_client->url_path,
+                         a_http_client->in_query_string);
+    return l_len > 0 && (size_t)l_len < a_key_size ? (size_t)l_len : 0;
+}
+
+/**
+ * @brief dap_http_cache_update Put reply to the cache, replacing the previous one with the same key
+ * @param a_http_client HTTP client which request is replied, its method, URL and query make the key
  * @param a_body
  * @param a_body_size
- * @param a_headers
+ * @param a_headers Extra headers to be sent with cached reply
  * @param a_response_phrase
  * @param a_respoonse_code
  * @param ts_expire
- * @return
+ * @return Referenced cache object, release it with dap_http_cache_release(), or NULL if the reply is not cacheable
  */
-dap_http_cache_t * dap_http_cache_update(struct dap_http_url_proc * a_url_proc, const byte_t * a_body, size_t a_body_size,
+dap_http_cache_t * dap_http_cache_update(dap_http_client_t *a_http_client, const byte_t * a_body, size_t a_body_size,
                                          dap_http_header_t * a_headers, const char * a_response_phrase, int a_respoonse_code,
                                          time_t a_ts_expire )
 {
+    dap_return_val_if_fail(a_http_client, NULL);
+    char l_key[sizeof(a_http_client->url_path) * 2 + sizeof(a_http_client->in_query_string) + 16];
+    size_t l_key_len = s_cache_key(a_http_client, l_key, sizeof(l_key));
+    if (!l_key_len)
+        return NULL;
     dap_http_cache_t * l_ret = DAP_NEW_Z_RET_VAL_IF_FAIL(dap_http_cache_t, NULL);
     if (a_body_size) {
         l_ret->body = DAP_DUP_SIZE_RET_VAL_IF_FAIL((byte_t*)a_body, a_body_size, NULL, l_ret);
         l_ret->body_size = a_body_size;
     }
+    l_ret->key = dap_strdup(l_key);
     l_ret->headers =  dap_http_headers_dup( a_headers);
     l_ret->ts_expire = a_ts_expire;
-    l_ret->url_proc = a_url_proc;
+    l_ret->url_proc = a_http_client->proc;
+    dap_strncpy(l_ret->content_type, a_http_client->out_content_type, sizeof(l_ret->content_type));
     if(a_response_phrase)
-        l_ret->response_phrase = strdup(a_response_phrase);
+        l_ret->response_phrase = dap_strdup(a_response_phrase);
     l_ret->response_code = a_respoonse_code;
 
     //Here we cut off 'Date' header because we add it new on each cached request
@@ -58,14 +163,157 @@ dap_http_cache_t * dap_http_cache_update(struct dap_http_url_proc * a_url_proc,
     if(l_hdr_date)
         dap_http_header_remove(&l_ret->headers,l_hdr_date);
 
-    // Reset current cache for url_proc and replace with our own
-    pthread_rwlock_wrlock(&a_url_proc->cache_rwlock);
-    dap_http_cache_delete(a_url_proc->cache);
-    a_url_proc->cache = l_ret;
-    pthread_rwlock_unlock(&a_url_proc->cache_rwlock);
+    // Strong validator, it changes with any byte of the body
+    dap_hash_fast_t l_hash = { };
+    dap_hash_fast(a_body, a_body_size, &l_hash);
+    l_ret->etag[0] = '"';
+    dap_bin2hex(l_ret->etag + 1, l_hash.raw, (DAP_HTTP_CACHE_ETAG_SIZE - 3) / 2);
+    l_ret->etag[DAP_HTTP_CACHE_ETAG_SIZE - 2] = '"';
+    // Compressed once here, then sent to every client which accepts it
+    if ( dap_http_compress_allowed(l_ret->content_type, a_body_size)
+            && (l_ret->body_gzip = dap_http_compress(DAP_HTTP_ENCODING_GZIP, a_body, a_body_size, &l_ret->body_gzip_size)) )
+        snprintf(l_ret->etag_gzip, sizeof(l_ret->etag_gzip), "%.*s-gz\"", DAP_HTTP_CACHE_ETAG_SIZE - 2, l_ret->etag);
+
+    size_t l_headers_count = 0;
+    dap_http_header_t *l_hdr;
+    DL_COUNT(l_ret->headers, l_hdr, l_headers_count);
+    l_ret->mem_size = sizeof(dap_http_cache_t) + l_key_len + 1 + a_body_size + l_ret->body_gzip_size
+            + l_headers_count * sizeof(dap_http_header_t);
+    l_ret->refs = 1;                                                        /* Reference of the table */
+
+    pthread_mutex_lock(&s_cache_mutex);
+    if (l_ret->mem_size > s_cache_size_max) {
+        pthread_mutex_unlock(&s_cache_mutex);
+        log_it(L_DEBUG, "Reply for %s is too big for cache", l_key);
+        dap_http_cache_delete(l_ret);
+        return NULL;
+    }
+    dap_http_cache_t *l_old = NULL;
+    HASH_FIND(hh, s_cache_table, l_key, l_key_len, l_old);
+    if (l_old)
+        s_cache_unlink(l_old);
+    s_cache_shrink(s_cache_size_max - l_ret->mem_size);
+    HASH_ADD_KEYPTR(hh, s_cache_table, l_ret->key, l_key_len, l_ret);
+    DL_PREPEND(s_cache_lru, l_ret);
+    l_ret->linked = true;
+    s_cache_size += l_ret->mem_size;
+    s_cache_count++;
+    l_ret->refs++;                                                          /* The caller's one, table may drop it any moment */
+    pthread_mutex_unlock(&s_cache_mutex);
+    return l_ret;
+}
+
+/**
+ * @brief dap_http_cache_find Look for the cached reply to the request
+ * @param a_http_client HTTP client with parsed request line
+ * @return Referenced cache object, release it with dap_http_cache_release(), or NULL
+ */
+dap_http_cache_t *dap_http_cache_find(dap_http_client_t *a_http_client)
+{
+    char l_key[sizeof(a_http_client->url_path) * 2 + sizeof(a_http_client->in_query_string) + 16];
+    size_t l_key_len = s_cache_key(a_http_client, l_key, sizeof(l_key));
+    if (!l_key_len)
+        return NULL;
+    dap_http_cache_t *l_ret = NULL;
+    pthread_mutex_lock(&s_cache_mutex);
+    HASH_FIND(hh, s_cache_table, l_key, l_key_len, l_ret);
+    if (l_ret) {
+        if (l_ret->ts_expire && l_ret->ts_expire < time(NULL)) {
+            s_cache_unlink(l_ret);
+            l_ret = NULL;
+        } else {
+            if (l_ret != s_cache_lru) {                                     /* Move to the LRU head */
+                DL_DELETE(s_cache_lru, l_ret);
+                DL_PREPEND(s_cache_lru, l_ret);
+            }
+            l_ret->refs++;
+        }
+    }
+    pthread_mutex_unlock(&s_cache_mutex);
     return l_ret;
 }
 
+/**
+ * @brief dap_http_cache_release Drop the reference taken by dap_http_cache_find() or dap_http_cache_update()
+ * @param a_http_cache
+ */
+void dap_http_cache_release(dap_http_cache_t *a_http_cache)
+{
+    if (!a_http_cache)
+        return;
+    pthread_mutex_lock(&s_cache_mutex);
+    bool l_delete = !--a_http_cache->refs;
+    pthread_mutex_unlock(&s_cache_mutex);
+    if (l_delete)
+        dap_http_cache_delete(a_http_cache);
+}
+
+/**
+ * @brief dap_http_cache_invalidate Drop cached replies of URL processor
+ * @param a_url_proc URL processor, NULL for all
+ */
+void dap_http_cache_invalidate(struct dap_http_url_proc *a_url_proc)
+{
+    dap_http_cache_t *l_cache, *l_tmp;
+    pthread_mutex_lock(&s_cache_mutex);
+    HASH_ITER(hh, s_cache_table, l_cache, l_tmp)
+        if (!a_url_proc || l_cache->url_proc == a_url_proc)
+            s_cache_unlink(l_cache);
+    pthread_mutex_unlock(&s_cache_mutex);
+}
+
+/**
+ * @brief s_etag_match Weak comparison of If-None-Match list with the entity tag
+ */
+static bool s_etag_match(const char *a_list, const char *a_etag)
+{
+    size_t l_etag_len = strlen(a_etag);
+    for (const char *l_cp = a_list; *l_cp; ) {
+        while (*l_cp == ' ' || *l_cp == ',')
+            l_cp++;
+        if (*l_cp == '*')
+            return true;
+        if (!strncmp(l_cp, "W/", 2))
+            l_cp += 2;
+        if (!strncmp(l_cp, a_etag, l_etag_len))
+            return true;
+        if (!(l_cp = strchr(l_cp, ',')))
+            break;
+    }
+    return false;
+}
+
+/**
+ * @brief dap_http_cache_reply_prepare Set status and headers of the cached reply, 304 if client has it already
+ * @param a_http_client HTTP client with found cache object
+ */
+void dap_http_cache_reply_prepare(dap_http_client_t *a_http_client)
+{
+    dap_http_cache_t *l_cache = a_http_client->out_cache;
+    if (l_cache->body_gzip) {
+        a_http_client->out_vary_encoding = true;
+        if (dap_http_compress_negotiate(a_http_client, l_cache->content_type, l_cache->body_size) == DAP_HTTP_ENCODING_GZIP)
+            a_http_client->out_encoding = DAP_HTTP_ENCODING_GZIP;
+    }
+    const char *l_etag = a_http_client->out_encoding ? l_cache->etag_gzip : l_cache->etag;
+    dap_http_header_t *l_hdr = dap_http_header_find(a_http_client->in_headers, "If-None-Match");
+    if (l_hdr && s_etag_match(l_hdr->value, l_etag)) {
+        a_http_client->reply_status_code = Http_Status_NotModified;
+        dap_strncpy(a_http_client->reply_reason_phrase, "Not Modified", sizeof(a_http_client->reply_reason_phrase));
+        a_http_client->out_content_length = 0;
+        a_http_client->out_encoding = DAP_HTTP_ENCODING_IDENTITY;
+    } else {
+        a_http_client->reply_status_code = l_cache->response_code;
+        if (l_cache->response_phrase)
+            dap_strncpy(a_http_client->reply_reason_phrase, l_cache->response_phrase, sizeof(a_http_client->reply_reason_phrase));
+        a_http_client->out_content_length = a_http_client->out_encoding ? l_cache->body_gzip_size : l_cache->body_size;
+        dap_strncpy(a_http_client->out_content_type, l_cache->content_type, sizeof(a_http_client->out_content_type));
+        for (l_hdr = l_cache->headers; l_hdr; l_hdr = l_hdr->next)
+            dap_http_out_header_add(a_http_client, l_hdr->name, l_hdr->value);
+    }
+    dap_http_out_header_add(a_http_client, "ETag", l_etag);
+}
+
 /**
  * @brief dap_http_cache_delete
  * @param a_http_cache
@@ -75,6 +323,7 @@ void dap_http_cache_delete(dap_http_cache_t * a_http_cache)
    if (a_http_cache){
        if(a_http_cache->body)
            DAP_DELETE(a_http_cache->body);
+       DAP_DEL_Z(a_http_cache->body_gzip);
        dap_http_header_t *l_hdr=NULL, *l_tmp=NULL;
 
        DL_FOREACH_SAFE(a_http_cache->headers,l_hdr,l_tmp){
@@ -82,6 +331,7 @@ void dap_http_cache_delete(dap_http_cache_t * a_http_cache)
 
            DAP_DELETE(l_hdr);
        }
+       DAP_DEL_MULTY(a_http_cache->key, a_http_cache->response_phrase);
        DAP_DELETE(a_http_cache);
    }
 }
@@ -0,0 +1,324 @@
+/*
+ * Authors:
+ * DeM Labs Ltd.   https://demlabs.net
+ * Copyright  (c) 2024
+ * All rights reserved.
+
+ This file is part of DAP SDK the open source project
+
+    DAP SDK is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    DAP SDK is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#ifdef DAP_HTTP_ZLIB
+#include <zlib.h>
+#endif
+#include "dap_common.h"
+#include "dap_config.h"
+#include "dap_http_client.h"
+#include "dap_http_header.h"
+#include "dap_http_compress.h"
+
+#define LOG_TAG "dap_http_compress"
+
+#define DAP_HTTP_COMPRESS_MIN_SIZE_DEFAULT  1024
+#define DAP_HTTP_COMPRESS_LEVEL_DEFAULT     6
+
+static bool s_enabled = false;
+static size_t s_min_size = DAP_HTTP_COMPRESS_MIN_SIZE_DEFAULT;
+#ifdef DAP_HTTP_ZLIB
+static int s_level = DAP_HTTP_COMPRESS_LEVEL_DEFAULT;
+#endif
+
+// Content types worth to compress, the rest is binary or compressed already
+static const char *s_types_allowed[] = {
+    "text/", "application/json", "application/javascript", "application/xml", "application/xhtml+xml",
+    "application/rss+xml", "application/atom+xml", "application/x-javascript", "application/wasm",
+    "image/svg+xml", "image/x-icon", "font/ttf", "font/otf"
+};
+
+struct dap_http_compressor {
+#ifdef DAP_HTTP_ZLIB
+    z_stream zs;
+#endif
+    bool last;                                                              /* Last input is given */
+    bool flushing;                                                          /* Input or its flush isn't written out yet */
+    bool over;
+};
+
+/**
+ * @brief dap_http_compress_init Read compression settings
+ * @return 0
+ */
+int dap_http_compress_init()
+{
+    dap_http_compress_set(dap_config_get_item_bool_default(g_config, "http", "compress", false),
+                          dap_config_get_item_uint32_default(g_config, "http", "compress_min_size", DAP_HTTP_COMPRESS_MIN_SIZE_DEFAULT),
+                          dap_config_get_item_int32_default(g_config, "http", "compress_level", DAP_HTTP_COMPRESS_LEVEL_DEFAULT));
+    return 0;
+}
+
+void dap_http_compress_deinit()
+{
+    s_enabled = false;
+}
+
+/**
+ * @brief dap_http_compress_set Turn reply compression on or off
+ * @param a_enabled Compress replies for clients which accept it
+ * @param a_min_size Smaller replies are sent as is, compression doesn't pay off for them
+ * @param a_level zlib compression level, 1 is the fastest, 9 is the best
+ * @return 0 if ok, -1 if compression isn't supported
+ */
+int dap_http_compress_set(bool a_enabled, size_t a_min_size, int a_level)
+{
+#ifdef DAP_HTTP_ZLIB
+    s_enabled = a_enabled;
+    s_min_size = a_min_size;
+    s_level = a_level >= 1 && a_level <= 9 ? a_level : DAP_HTTP_COMPRESS_LEVEL_DEFAULT;
+    return 0;
+#else
+    if (a_enabled)
+        log_it(L_WARNING, "Reply compression is not supported, SDK is built without zlib");
+    return a_enabled ? -1 : 0;
+#endif
+}
+
+bool dap_http_compress_enabled()
+{
+    return s_enabled;
+}
+
+bool dap_http_compress_type_allowed(const char *a_content_type)
+{
+    if (!a_content_type)
+        return false;
+    for (size_t i = 0; i < sizeof(s_types_allowed) / sizeof(s_types_allowed[0]); i++)
+        if (!strncasecmp(a_content_type, s_types_allowed[i], strlen(s_types_allowed[i])))
+            return true;
+    return false;
+}
+
+bool dap_http_compress_allowed(const char *a_content_type, size_t a_size)
+{
+    return s_enabled && a_size >= s_min_size && dap_http_compress_type_allowed(a_content_type);
+}
+
+/**
+ * @brief dap_http_compress_accepted Choose the encoding from Accept-Encoding value
+ * @param a_accept_encoding Header value, like "gzip, deflate;q=0.5, br"
+ * @return Encoding with the best quality, gzip if they are equal, identity if nothing supported is accepted
+ */
+dap_http_encoding_t dap_http_compress_accepted(const char *a_accept_encoding)
+{
+    if (!a_accept_encoding)
+        return DAP_HTTP_ENCODING_IDENTITY;
+    // Quality in thousandths, -1 if not listed
+    int l_gzip = -1, l_deflate = -1, l_any = -1;
+    for (const char *l_cp = a_accept_encoding; *l_cp; ) {
+        while (*l_cp == ' ' || *l_cp == '\t' || *l_cp == ',')
+            l_cp++;
+        size_t l_len = strcspn(l_cp, " \t;,");
+        if (!l_len)
+            break;
+        const char *l_name = l_cp;
+        int l_q = 1000;
+        l_cp += l_len;
+        while (*l_cp == ' ' || *l_cp == '\t')
+            l_cp++;
+        if (*l_cp == ';') {
+            const char *l_param = l_cp + 1;
+            while (*l_param == ' ' || *l_param == '\t')
+                l_param++;
+            if ((*l_param == 'q' || *l_param == 'Q') && l_param[1] == '=')
+                l_q = (int)(strtod(l_param + 2, NULL) * 1000);
+            l_cp += strcspn(l_cp, ",");
+        }
+        if ((l_len == 4 && !strncasecmp(l_name, "gzip", 4)) || (l_len == 6 && !strncasecmp(l_name, "x-gzip", 6)))
+            l_gzip = l_q;
+        else if (l_len == 7 && !strncasecmp(l_name, "deflate", 7))
+            l_deflate = l_q;
+        else if (l_len == 1 && *l_name == '*')
+            l_any = l_q;
+    }
+    if (l_gzip < 0)
+        l_gzip = l_any;
+    if (l_deflate < 0)
+        l_deflate = l_any;
+    if (l_gzip <= 0 && l_deflate <= 0)
+        return DAP_HTTP_ENCODING_IDENTITY;
+    return l_gzip >= l_deflate ? DAP_HTTP_ENCODING_GZIP : DAP_HTTP_ENCODING_DEFLATE;
+}
+
+/**
+ * @brief dap_http_compress_negotiate Check if the reply should be compressed for the client
+ * @param a_http_client HTTP client with parsed request headers
+ * @param a_content_type Content type of the reply
+ * @param a_size Body size or DAP_HTTP_COMPRESS_SIZE_UNKNOWN for streamed reply
+ * @return Encoding to use
+ */
+dap_http_encoding_t dap_http_compress_negotiate(dap_http_client_t *a_http_client, const char *a_content_type, size_t a_size)
+{
+    if (!dap_http_compress_allowed(a_content_type, a_size))
+        return DAP_HTTP_ENCODING_IDENTITY;
+    dap_http_header_t *l_hdr = dap_http_header_find(a_http_client->in_headers, "Accept-Encoding");
+    return l_hdr ? dap_http_compress_accepted(l_hdr->value) : DAP_HTTP_ENCODING_IDENTITY;
+}
+
+const char *dap_http_encoding_str(dap_http_encoding_t a_encoding)
+{
+    switch (a_encoding) {
+    case DAP_HTTP_ENCODING_GZIP:
+        return "gzip";
+    case DAP_HTTP_ENCODING_DEFLATE:
+        return "deflate";
+    default:
+        return "identity";
+    }
+}
+
+#ifdef DAP_HTTP_ZLIB
+static int s_deflate_init(z_stream *a_zs, dap_http_encoding_t a_encoding)
+{
+    // Window bits 15 make zlib format, 16 more make gzip one
+    return deflateInit2(a_zs, s_level, Z_DEFLATED, a_encoding == DAP_HTTP_ENCODING_GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY);
+}
+#endif
+
+/**
+ * @brief dap_http_compress Compress the whole body
+ * @param a_encoding gzip or deflate
+ * @param a_data Body
+ * @param a_size Body size
+ * @param a_out_size Compressed body size
+ * @return Compressed body or NULL if it isn't smaller than the source
+ */
+uint8_t *dap_http_compress(dap_http_encoding_t a_encoding, const void *a_data, size_t a_size, size_t *a_out_size)
+{
+    dap_return_val_if_fail(a_data && a_out_size && a_encoding != DAP_HTTP_ENCODING_IDENTITY, NULL);
+#ifdef DAP_HTTP_ZLIB
+    z_stream l_zs = { };
+    if (s_deflate_init(&l_zs, a_encoding) != Z_OK) {
+        log_it(L_ERROR, "Can't init deflate: %s", l_zs.msg ? l_zs.msg : "unknown error");
+        return NULL;
+    }
+    // Gzip header and trailer are bigger than zlib ones
+    size_t l_bound = deflateBound(&l_zs, a_size) + 16;
+    uint8_t *l_ret = DAP_NEW_SIZE(uint8_t, l_bound);
+    if (!l_ret) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        deflateEnd(&l_zs);
+        return NULL;
+    }
+    l_zs.next_in = (Bytef *)a_data;
+    l_zs.avail_in = a_size;
+    l_zs.next_out = l_ret;
+    l_zs.avail_out = l_bound;
+    int l_rc = deflate(&l_zs, Z_FINISH);
+    *a_out_size = l_zs.total_out;
+    deflateEnd(&l_zs);
+    if (l_rc != Z_STREAM_END || *a_out_size >= a_size) {
+        debug_if(l_rc != Z_STREAM_END, L_ERROR, "Deflate error %d", l_rc);
+        DAP_DELETE(l_ret);
+        return NULL;
+    }
+    return l_ret;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief dap_http_compressor_new Create streaming compressor
+ * @param a_encoding gzip or deflate
+ * @return Compressor or NULL if compression isn't supported
+ */
+dap_http_compressor_t *dap_http_compressor_new(dap_http_encoding_t a_encoding)
+{
+    dap_return_val_if_fail(a_encoding != DAP_HTTP_ENCODING_IDENTITY, NULL);
+#ifdef DAP_HTTP_ZLIB
+    dap_http_compressor_t *l_ret = DAP_NEW_Z_RET_VAL_IF_FAIL(dap_http_compressor_t, NULL);
+    if (s_deflate_init(&l_ret->zs, a_encoding) != Z_OK) {
+        log_it(L_ERROR, "Can't init deflate: %s", l_ret->zs.msg ? l_ret->zs.msg : "unknown error");
+        DAP_DELETE(l_ret);
+        return NULL;
+    }
+    return l_ret;
+#else
+    return NULL;
+#endif
+}
+
+void dap_http_compressor_delete(dap_http_compressor_t *a_compressor)
+{
+    if (!a_compressor)
+        return;
+#ifdef DAP_HTTP_ZLIB
+    deflateEnd(&a_compressor->zs);
+#endif
+    DAP_DELETE(a_compressor);
+}
+
+void dap_http_compressor_input(dap_http_compressor_t *a_compressor, const void *a_data, size_t a_size, bool a_last)
+{
+    dap_return_if_fail(a_compressor && dap_http_compressor_wants_input(a_compressor));
+#ifdef DAP_HTTP_ZLIB
+    a_compressor->zs.next_in = (Bytef *)a_data;
+    a_compressor->zs.avail_in = a_size;
+#endif
+    a_compressor->last = a_last;
+    a_compressor->flushing = true;
+}
+
+bool dap_http_compressor_wants_input(dap_http_compressor_t *a_compressor)
+{
+    return !a_compressor->flushing && !a_compressor->last;
+}
+
+/**
+ * @brief dap_http_compressor_output Compress the input given. Each piece is flushed, so client gets it without delay
+ * @param a_compressor Compressor
+ * @param a_buf Output buffer
+ * @param a_buf_size Output buffer size
+ * @return Size of compressed data put into the buffer, -1 on error
+ */
+ssize_t dap_http_compressor_output(dap_http_compressor_t *a_compressor, void *a_buf, size_t a_buf_size)
+{
+    dap_return_val_if_fail(a_compressor && a_buf, -1);
+    if (a_compressor->over || !a_compressor->flushing || !a_buf_size)
+        return 0;
+#ifdef DAP_HTTP_ZLIB
+    z_stream *l_zs = &a_compressor->zs;
+    l_zs->next_out = a_buf;
+    l_zs->avail_out = a_buf_size;
+    int l_rc = deflate(l_zs, a_compressor->last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (l_rc == Z_STREAM_ERROR) {
+        log_it(L_ERROR, "Deflate stream error");
+        return -1;
+    }
+    if (l_rc == Z_STREAM_END)
+        a_compressor->over = true;
+    else if (!a_compressor->last && l_zs->avail_out)
+        a_compressor->flushing = false;                                     /* Room is left, so the flush is complete */
+    return a_buf_size - l_zs->avail_out;
+#else
+    return -1;
+#endif
+}
+
+bool dap_http_compressor_is_over(dap_http_compressor_t *a_compressor)
+{
+    return a_compressor->over;
+}
@@ -24,10 +24,17 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
 
 #ifndef _WIN32
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#ifdef DAP_OS_LINUX
+#include <sys/sendfile.h>
+#endif
 #else
 #include <winsock2.h>
 #include <windows.h>
@@ -39,11 +46,28 @@
 #include <pthread.h>
 
 #include "dap_common.h"
+#include "dap_config.h"
 #include "dap_events_socket.h"
 #include "dap_http_server.h"
 #include "dap_http_client.h"
 #include "dap_http_folder.h"
+#include "dap_http_header.h"
+#include "dap_http_compress.h"
+#include "dap_proc_thread.h"
+#include "dap_time.h"
+#include "dap_strfuncs.h"
 #include "http_status_code.h"
+#include "utlist.h"
+#include "uthash.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#define DAP_HTTP_FOLDER_SEND_CHUNK  (1024 * 1024)   // Max bytes pushed to the socket per write event
+#define DAP_HTTP_FOLDER_GZIP_FILE_MAX           (4 * 1024 * 1024)   // Bigger files are sent as is
+#define DAP_HTTP_FOLDER_GZIP_INLINE_MAX         (64 * 1024)         // Bigger ones are compressed by proc thread, sent as is till then
+#define DAP_HTTP_FOLDER_GZIP_CACHE_SIZE_DEFAULT 16                  // MB
 
 typedef struct dap_http_url_proc_folder {
     char local_path[4096];
@@ -52,9 +76,29 @@ typedef struct dap_http_url_proc_folder {
 
 #define URL_PROC_FOLDER(a) ((dap_http_url_proc_folder_t*) (a)->_inhertior )
 
+// Compressed copy of the file, shared by clients while referenced
+typedef struct dap_http_folder_gzip {
+    char *path;
+    time_t mtime;                       // Source file it's made of
+    uint64_t size;
+    byte_t *data;                       // NULL if compression doesn't pay off for the file
+    size_t data_size;
+    size_t mem_size;
+    int refs;                           // Table, clients sending it and proc thread compressing it
+    bool linked;
+    bool ready;                         // Compressed, otherwise it only marks the file is being compressed
+    struct dap_http_folder_gzip *prev, *next;   // LRU list, the most recent is the head
+    UT_hash_handle hh;
+} dap_http_folder_gzip_t;
+
 typedef struct dap_http_file{
-    FILE * fd;
-    size_t position;
+    int fd;
+    uint64_t position;                  // Next file offset to send
+    uint64_t end;                       // One past the last byte of requested range
+    void *map;                          // Whole file mapping for DAP_HTTP_FOLDER_SEND_MMAP
+    size_t map_size;
+    dap_http_folder_send_mode_t send_mode;
+    dap_http_folder_gzip_t *gzip;       // Compressed body is sent instead of the file
     char local_path[4096+2048+1];
     dap_http_client_t *client;
 } dap_http_file_t;
@@ -65,17 +109,347 @@ void dap_http_folder_headers_read( dap_http_client_t *cl_ht, void *arg );
 bool dap_http_folder_headers_write( dap_http_client_t *cl_ht, void *arg );
 void dap_http_folder_data_read( dap_http_client_t *cl_ht, void *arg );
 bool dap_http_folder_data_write( dap_http_client_t *cl_ht, void *arg );
+static void s_folder_client_delete(dap_http_client_t *a_http_client, void *a_arg);
+static void s_gzip_unlink(dap_http_folder_gzip_t *a_gzip);
 
 #define LOG_TAG "dap_http_folder"
 
+#if defined DAP_OS_LINUX
+static dap_http_folder_send_mode_t s_send_mode = DAP_HTTP_FOLDER_SEND_SENDFILE;
+#elif defined DAP_OS_UNIX
+static dap_http_folder_send_mode_t s_send_mode = DAP_HTTP_FOLDER_SEND_MMAP;
+#else
+static dap_http_folder_send_mode_t s_send_mode = DAP_HTTP_FOLDER_SEND_BUFFERED;
+#endif
+
+static pthread_mutex_t s_gzip_mutex = PTHREAD_MUTEX_INITIALIZER;
+static dap_http_folder_gzip_t *s_gzip_table = NULL, *s_gzip_lru = NULL;
+static size_t s_gzip_size = 0, s_gzip_count = 0,
+              s_gzip_size_max = DAP_HTTP_FOLDER_GZIP_CACHE_SIZE_DEFAULT * 1024 * 1024;
+
+// Content types by file extension
+static const struct {
+    const char *ext, *type;
+} s_mime_types[] = {
+    { "html", "text/html; charset=utf-8" }, { "htm", "text/html; charset=utf-8" }, { "css", "text/css" },
+    { "js", "application/javascript" }, { "mjs", "application/javascript" }, { "json", "application/json" },
+    { "txt", "text/plain; charset=utf-8" }, { "xml", "application/xml" }, { "csv", "text/csv" },
+    { "svg", "image/svg+xml" }, { "ico", "image/x-icon" }, { "wasm", "application/wasm" },
+    { "png", "image/png" }, { "jpg", "image/jpeg" }, { "jpeg", "image/jpeg" }, { "gif", "image/gif" },
+    { "webp", "image/webp" }, { "woff", "font/woff" }, { "woff2", "font/woff2" }, { "ttf", "font/ttf" },
+    { "pdf", "application/pdf" }, { "zip", "application/zip" }, { "gz", "application/gzip" }
+};
+
 int dap_http_folder_init( )
 {
+    s_gzip_size_max = (size_t)dap_config_get_item_uint32_default(g_config, "http", "folder_gzip_cache_size_max",
+                                                                 DAP_HTTP_FOLDER_GZIP_CACHE_SIZE_DEFAULT) * 1024 * 1024;
     return 0;
 }
 
 void dap_http_folder_deinit( )
 {
+    dap_http_folder_set_gzip_cache_size_max(0);
+    // Files being compressed are left to proc threads
+    pthread_mutex_lock(&s_gzip_mutex);
+    dap_http_folder_gzip_t *l_gzip, *l_tmp;
+    HASH_ITER(hh, s_gzip_table, l_gzip, l_tmp)
+        s_gzip_unlink(l_gzip);
+    pthread_mutex_unlock(&s_gzip_mutex);
+}
+
+static const char *s_mime_type(const char *a_path)
+{
+    const char *l_ext = strrchr(a_path, '.');
+    if (l_ext && !strchr(l_ext, '/'))
+        for (size_t i = 0; i < sizeof(s_mime_types) / sizeof(s_mime_types[0]); i++)
+            if (!strcasecmp(l_ext + 1, s_mime_types[i].ext))
+                return s_mime_types[i].type;
+    return "application/octet-stream";
+}
 
+static void s_gzip_delete(dap_http_folder_gzip_t *a_gzip)
+{
+    DAP_DEL_MULTY(a_gzip->path, a_gzip->data, a_gzip);
+}
+
+static void s_gzip_unlink(dap_http_folder_gzip_t *a_gzip)
+{
+    HASH_DEL(s_gzip_table, a_gzip);
+    if (a_gzip->ready) {
+        DL_DELETE(s_gzip_lru, a_gzip);
+        s_gzip_size -= a_gzip->mem_size;
+        s_gzip_count--;
+    }
+    a_gzip->linked = false;
+    if (!--a_gzip->refs)
+        s_gzip_delete(a_gzip);
+}
+
+static void s_gzip_shrink(size_t a_size_max)
+{
+    while (s_gzip_size > a_size_max && s_gzip_lru)
+        s_gzip_unlink(s_gzip_lru->prev);                                    // Head's prev is the tail, the least recently used
+}
+
+static void s_gzip_release(dap_http_folder_gzip_t *a_gzip)
+{
+    if (!a_gzip)
+        return;
+    pthread_mutex_lock(&s_gzip_mutex);
+    bool l_delete = !--a_gzip->refs;
+    pthread_mutex_unlock(&s_gzip_mutex);
+    if (l_delete)
+        s_gzip_delete(a_gzip);
+}
+
+// Puts compressed copy of the table to LRU list if it fits the cache, false if it doesn't. Under mutex
+static bool s_gzip_account(dap_http_folder_gzip_t *a_gzip)
+{
+    if (a_gzip->mem_size > s_gzip_size_max)
+        return false;
+    s_gzip_shrink(s_gzip_size_max - a_gzip->mem_size);
+    DL_PREPEND(s_gzip_lru, a_gzip);
+    s_gzip_size += a_gzip->mem_size;
+    s_gzip_count++;
+    return true;
+}
+
+/**
+ * @brief dap_http_folder_set_gzip_cache_size_max Set memory limit for compressed files
+ * @param a_size_max Limit in bytes, 0 drops all cached files
+ */
+void dap_http_folder_set_gzip_cache_size_max(size_t a_size_max)
+{
+    pthread_mutex_lock(&s_gzip_mutex);
+    s_gzip_size_max = a_size_max;
+    s_gzip_shrink(a_size_max);
+    pthread_mutex_unlock(&s_gzip_mutex);
+}
+
+size_t dap_http_folder_get_gzip_cache_count()
+{
+    pthread_mutex_lock(&s_gzip_mutex);
+    size_t l_ret = s_gzip_count;
+    pthread_mutex_unlock(&s_gzip_mutex);
+    return l_ret;
+}
+
+/**
+ * @brief s_gzip_compress Read the whole file and compress it to the copy
+ * @param a_gzip Compressed copy with path, size and modification time set
+ * @param a_fd Opened file, its offset is moved to the start
+ * @return false if the file can't be read
+ */
+static bool s_gzip_compress(dap_http_folder_gzip_t *a_gzip, int a_fd)
+{
+    byte_t *l_body = DAP_NEW_SIZE(byte_t, a_gzip->size);
+    if (!l_body)
+        return log_it(L_CRITICAL, "%s", c_error_memory_alloc), false;
+    uint64_t l_read = 0;
+    lseek(a_fd, 0, SEEK_SET);
+    for (ssize_t l_rc; l_read < a_gzip->size; l_read += l_rc)
+        if ((l_rc = read(a_fd, l_body + l_read, a_gzip->size - l_read)) <= 0)
+            break;
+    lseek(a_fd, 0, SEEK_SET);                                               // File is sent as is if compression fails
+    if (l_read < a_gzip->size) {
+        log_it(L_ERROR, "Can't read %s to compress it", a_gzip->path);
+        DAP_DELETE(l_body);
+        return false;
+    }
+    a_gzip->data = dap_http_compress(DAP_HTTP_ENCODING_GZIP, l_body, a_gzip->size, &a_gzip->data_size);
+    DAP_DELETE(l_body);
+    a_gzip->mem_size = sizeof(dap_http_folder_gzip_t) + strlen(a_gzip->path) + 1 + a_gzip->data_size;
+    log_it(L_DEBUG, "File %s %"DAP_UINT64_FORMAT_U" bytes is compressed to %zu", a_gzip->path, a_gzip->size, a_gzip->data_size);
+    return true;
+}
+
+// Compresses the file marked in the table, it's taken by the next requests when ready
+static bool s_gzip_proc_callback(void *a_arg)
+{
+    dap_http_folder_gzip_t *l_gzip = a_arg;
+    int l_fd = open(l_gzip->path, O_RDONLY | O_BINARY);
+    bool l_ok = l_fd >= 0 && s_gzip_compress(l_gzip, l_fd);
+    if (l_fd >= 0)
+        close(l_fd);
+    pthread_mutex_lock(&s_gzip_mutex);
+    if (l_gzip->linked) {
+        if (l_ok) {
+            l_gzip->ready = true;
+            l_ok = s_gzip_account(l_gzip);
+            l_gzip->ready = l_ok;
+        }
+        if (!l_ok)
+            s_gzip_unlink(l_gzip);                                          // Next request will try again
+    }
+    bool l_delete = !--l_gzip->refs;
+    pthread_mutex_unlock(&s_gzip_mutex);
+    if (l_delete)
+        s_gzip_delete(l_gzip);
+    return false;
+}
+
+/**
+ * @brief s_gzip_get Find compressed copy of the file or make it. File is compressed once, then it's taken from the cache
+ *        while its modification time and size are the same. Small files are compressed right here, bigger ones are
+ *        passed to proc thread not to stall the worker
+ * @param a_file File response data with the opened file
+ * @param a_size File size
+ * @param a_mtime File modification time
+ * @return Referenced compressed copy, release it with s_gzip_release(), or NULL if it isn't ready
+ */
+static dap_http_folder_gzip_t *s_gzip_get(dap_http_file_t *a_file, uint64_t a_size, time_t a_mtime)
+{
+    size_t l_path_len = strlen(a_file->local_path);
+    dap_http_folder_gzip_t *l_ret = NULL;
+    pthread_mutex_lock(&s_gzip_mutex);
+    HASH_FIND(hh, s_gzip_table, a_file->local_path, l_path_len, l_ret);
+    if (l_ret && l_ret->ready && (l_ret->mtime != a_mtime || l_ret->size != a_size)) {
+        s_gzip_unlink(l_ret);                                               // File is changed
+        l_ret = NULL;
+    }
+    if (l_ret) {
+        if (!l_ret->ready || l_ret->mtime != a_mtime || l_ret->size != a_size)
+            l_ret = NULL;                                                   // Is being compressed
+        else {
+            if (l_ret != s_gzip_lru) {
+                DL_DELETE(s_gzip_lru, l_ret);
+                DL_PREPEND(s_gzip_lru, l_ret);
+            }
+            l_ret->refs++;
+        }
+        pthread_mutex_unlock(&s_gzip_mutex);
+        return l_ret;
+    }
+    if (a_size > DAP_HTTP_FOLDER_GZIP_INLINE_MAX) {
+        // Marks the file in the table so other workers don't compress it too
+        char *l_path = dap_strdup(a_file->local_path);
+        if (l_path && (l_ret = DAP_NEW_Z(dap_http_folder_gzip_t))) {
+            *l_ret = (dap_http_folder_gzip_t) { .path = l_path, .mtime = a_mtime, .size = a_size, .refs = 2, .linked = true };
+            HASH_ADD_KEYPTR(hh, s_gzip_table, l_ret->path, l_path_len, l_ret);
+        } else
+            DAP_DELETE(l_path);
+        pthread_mutex_unlock(&s_gzip_mutex);
+        if (!l_ret)
+            return log_it(L_CRITICAL, "%s", c_error_memory_alloc), NULL;
+        if (dap_proc_thread_callback_add(dap_proc_thread_get_auto(), s_gzip_proc_callback, l_ret)) {
+            pthread_mutex_lock(&s_gzip_mutex);
+            l_ret->refs--;
+            if (l_ret->linked)
+                s_gzip_unlink(l_ret);
+            pthread_mutex_unlock(&s_gzip_mutex);
+        }
+        return NULL;
+    }
+    pthread_mutex_unlock(&s_gzip_mutex);
+
+    if (!(l_ret = DAP_NEW_Z(dap_http_folder_gzip_t)) || !(l_ret->path = dap_strdup(a_file->local_path))) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        DAP_DELETE(l_ret);
+        return NULL;
+    }
+    l_ret->mtime = a_mtime;
+    l_ret->size = a_size;
+    l_ret->refs = 1;                                                        // Reference of the caller
+    l_ret->ready = true;
+    if (!s_gzip_compress(l_ret, a_file->fd)) {
+        s_gzip_delete(l_ret);
+        return NULL;
+    }
+    pthread_mutex_lock(&s_gzip_mutex);
+    dap_http_folder_gzip_t *l_old = NULL;
+    HASH_FIND(hh, s_gzip_table, l_ret->path, l_path_len, l_old);
+    if (l_old)
+        s_gzip_unlink(l_old);                                               // Made by another worker at the same time
+    if (s_gzip_account(l_ret)) {
+        HASH_ADD_KEYPTR(hh, s_gzip_table, l_ret->path, l_path_len, l_ret);
+        l_ret->linked = true;
+        l_ret->refs++;
+    }
+    pthread_mutex_unlock(&s_gzip_mutex);
+    return l_ret;
+}
+
+/**
+ * @brief s_gzip_try Send compressed copy of the file if client accepts it
+ * @param a_http_client HTTP client instance with file reply prepared
+ * @param a_file File response data
+ * @param a_size File size
+ */
+static void s_gzip_try(dap_http_client_t *a_http_client, dap_http_file_t *a_file, uint64_t a_size)
+{
+    if (a_size > DAP_HTTP_FOLDER_GZIP_FILE_MAX || !dap_http_compress_allowed(a_http_client->out_content_type, a_size))
+        return;
+    a_http_client->out_vary_encoding = true;
+    if (dap_http_compress_negotiate(a_http_client, a_http_client->out_content_type, a_size) != DAP_HTTP_ENCODING_GZIP)
+        return;
+    dap_http_folder_gzip_t *l_gzip = s_gzip_get(a_file, a_size, a_http_client->out_last_modified);
+    if (!l_gzip || !l_gzip->data)
+        return s_gzip_release(l_gzip);
+    a_file->gzip = l_gzip;
+    a_file->position = 0;
+    a_file->end = l_gzip->data_size;
+    a_http_client->out_content_length = l_gzip->data_size;
+    a_http_client->out_encoding = DAP_HTTP_ENCODING_GZIP;
+    close(a_file->fd);
+    a_file->fd = -1;
+}
+
+/**
+ * @brief dap_http_folder_set_send_mode Select how file bodies are sent to plain sockets
+ * @param a_mode Send mode
+ * @return 0 if ok, -1 if the mode is not supported on this platform
+ */
+int dap_http_folder_set_send_mode(dap_http_folder_send_mode_t a_mode)
+{
+    switch (a_mode) {
+    case DAP_HTTP_FOLDER_SEND_BUFFERED:
+        break;
+#ifdef DAP_OS_UNIX
+    case DAP_HTTP_FOLDER_SEND_MMAP:
+        break;
+#endif
+#ifdef DAP_OS_LINUX
+    case DAP_HTTP_FOLDER_SEND_SENDFILE:
+        break;
+#endif
+    default:
+        log_it(L_ERROR, "Send mode %d is not supported on this platform", a_mode);
+        return -1;
+    }
+    s_send_mode = a_mode;
+    return 0;
+}
+
+dap_http_folder_send_mode_t dap_http_folder_get_send_mode()
+{
+    return s_send_mode;
+}
+
+/**
+ * @brief s_file_close Release file resources of the client, the structure itself is kept for the next request
+ * @param a_file File response data
+ */
+static void s_file_close(dap_http_file_t *a_file)
+{
+#ifdef DAP_OS_UNIX
+    if (a_file->map)
+        munmap(a_file->map, a_file->map_size);
+#endif
+    a_file->map = NULL;
+    a_file->map_size = 0;
+    if (a_file->fd >= 0)
+        close(a_file->fd);
+    a_file->fd = -1;
+    s_gzip_release(a_file->gzip);
+    a_file->gzip = NULL;
+}
+
+static void s_folder_client_delete(dap_http_client_t *a_http_client, void *a_arg)
+{
+    (void) a_arg;
+    if (a_http_client->_inheritor)
+        s_file_close(DAP_HTTP_FILE(a_http_client));
 }
 
 
@@ -145,7 +519,7 @@ int dap_http_folder_add(dap_http_server_t *sh, const char *url_path, const char
                       url_path, 
                       up_folder, 
                       NULL,
-                      NULL,
+                      s_folder_client_delete,
                       dap_http_folder_headers_read,
                       dap_http_folder_headers_write,
                       dap_http_folder_data_read,
@@ -162,9 +536,11 @@ int dap_http_folder_add(dap_http_server_t *sh, const char *url_path, const char
 void dap_http_folder_headers_read(dap_http_client_t * cl_ht, void * arg)
 {
     (void) arg;
-    cl_ht->state_read = cl_ht->keep_alive ? DAP_HTTP_CLIENT_STATE_START : DAP_HTTP_CLIENT_STATE_NONE;
+    // Response headers go to the output buffer right now, the body follows on write events.
+    // Input is paused until the whole body is sent, keep-alive connection is resumed after that
+    dap_http_client_write(cl_ht);
     dap_events_socket_set_writable_unsafe(cl_ht->esocket,true);
-    dap_events_socket_set_readable_unsafe(cl_ht->esocket, cl_ht->keep_alive);
+    dap_events_socket_set_readable_unsafe(cl_ht->esocket, false);
 }
 
 #ifdef _WIN32
@@ -179,6 +555,84 @@ time_t FileTimeToUnixTime( FILETIME ft )
 }
 #endif
 
+/**
+ * @brief s_http_date_parse Parse HTTP-date from conditional request headers
+ * @details Accepts IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT") and the numeric zone form we send in Last-Modified
+ * @param a_str Header value
+ * @return UNIX time or 0 if the string is not recognized
+ */
+static time_t s_http_date_parse(const char *a_str)
+{
+#ifdef DAP_OS_WINDOWS
+    UNUSED(a_str);
+    return 0;
+#else
+    struct tm l_tm = { };
+    const char *l_rest = strptime(a_str, "%a, %d %b %Y %H:%M:%S", &l_tm);
+    if (!l_rest)
+        return 0;
+    while (*l_rest == ' ')
+        l_rest++;
+    long l_gmtoff = 0;
+    if (*l_rest == '+' || *l_rest == '-') {
+        struct tm l_tz = { };
+        if (!strptime(l_rest, "%z", &l_tz))
+            return 0;
+        l_gmtoff = l_tz.tm_gmtoff;
+    } else if (*l_rest && strcmp(l_rest, "GMT") && strcmp(l_rest, "UTC"))
+        return 0;
+    time_t l_time = timegm(&l_tm);
+    return l_time > 0 ? l_time - l_gmtoff : 0;
+#endif
+}
+
+/**
+ * @brief s_range_parse Parse single byte range from the Range header
+ * @param a_str Header value
+ * @param a_size File size
+ * @param a_start[out] First byte of range
+ * @param a_end[out] One past the last byte of range
+ * @return 1 if range is set, 0 if header should be ignored, -1 if range is not satisfiable
+ */
+static int s_range_parse(const char *a_str, uint64_t a_size, uint64_t *a_start, uint64_t *a_end)
+{
+    if (strncmp(a_str, "bytes=", 6) || strchr(a_str, ','))
+        return 0;                                                           /* Other units and multipart ranges are not supported, whole file is sent */
+    const char *l_cp = a_str + 6;
+    char *l_endp;
+    if (*l_cp == '-') {                                                     /* Suffix range "bytes=-N", last N bytes */
+        uint64_t l_suffix = strtoull(l_cp + 1, &l_endp, 10);
+        if (l_endp == l_cp + 1 || *l_endp)
+            return 0;
+        if (!l_suffix || !a_size)
+            return -1;
+        *a_start = a_size - dap_min(l_suffix, a_size);
+        *a_end = a_size;
+        return 1;
+    }
+    if (!isdigit(*l_cp))
+        return 0;
+    uint64_t l_first = strtoull(l_cp, &l_endp, 10), l_last = UINT64_MAX;
+    if (*l_endp++ != '-')
+        return 0;
+    if (*l_endp) {                                                          /* "bytes=A-B", otherwise "bytes=A-" till the end */
+        const char *l_last_str = l_endp;
+        l_last = strtoull(l_last_str, &l_endp, 10);
+        if (l_endp == l_last_str || *l_endp || l_last < l_first)
+            return 0;
+    }
+    if (l_first >= a_size)
+        return -1;
+    *a_start = l_first;
+    *a_end = dap_min(l_last, a_size - 1) + 1;
+    return 1;
+}
+
+static inline bool s_esocket_is_plain(dap_events_socket_t *a_es)
+{
+    return a_es->type == DESCRIPTOR_TYPE_SOCKET_CLIENT || a_es->type == DESCRIPTOR_TYPE_SOCKET_LOCAL_CLIENT;
+}
+
 /**
  * @brief dap_http_folder_headers Prepare response HTTP headers for file folder request
  * @param cl_ht HTTP client instane
@@ -191,15 +645,21 @@ bool dap_http_folder_headers_write( dap_http_client_t *cl_ht, void * arg)
   dap_http_url_proc_folder_t * up_folder=(dap_http_url_proc_folder_t*) cl_ht->proc->_inheritor;
 
   // Init specific file response data for HTTP client instance
-  cl_ht->_inheritor=DAP_NEW_Z(dap_http_file_t);
+  if ( !(cl_ht->_inheritor = DAP_NEW_Z(dap_http_file_t)) ) {
+    log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+    cl_ht->reply_status_code = Http_Status_InternalServerError;
+    return false;
+  }
 
   dap_http_file_t* cl_ht_file=DAP_HTTP_FILE(cl_ht);
   cl_ht_file->client=cl_ht;
+  cl_ht_file->fd = -1;
 
   // Produce local path for file to open
   snprintf(cl_ht_file->local_path,sizeof(cl_ht_file->local_path),"%s/%s", up_folder->local_path, cl_ht->url_path );
   log_it(L_DEBUG, "Check %s file", cl_ht_file->local_path);
 
+  uint64_t l_size;
 #ifndef _WIN32
 
   struct stat file_stat;
@@ -208,7 +668,7 @@ bool dap_http_folder_headers_write( dap_http_client_t *cl_ht, void * arg)
     goto err;
 
   cl_ht->out_last_modified  = file_stat.st_mtime;
-  cl_ht->out_content_length = file_stat.st_size;
+  l_size = file_stat.st_size;
 
 #else
 
@@ -234,24 +694,54 @@ bool dap_http_folder_headers_write( dap_http_client_t *cl_ht, void * arg)
                &LastWriteTime );
 
   cl_ht->out_last_modified  = FileTimeToUnixTime( LastWriteTime );
-  cl_ht->out_content_length = GetFileSize( fileh, NULL );
+  l_size = GetFileSize( fileh, NULL );
 
   CloseHandle( fileh );
 
 #endif
 
-  cl_ht_file->fd = fopen( cl_ht_file->local_path, "rb" );
+  dap_http_header_t *l_hdr = dap_http_header_find( cl_ht->in_headers, "If-Modified-Since" );
+  time_t l_since;
+  if ( l_hdr && (l_since = s_http_date_parse(l_hdr->value)) && cl_ht->out_last_modified <= l_since ) {
+    log_it( L_DEBUG, "File %s is not modified since %s", cl_ht_file->local_path, l_hdr->value );
+    cl_ht->reply_status_code = Http_Status_NotModified;
+    strncpy( cl_ht->reply_reason_phrase, "Not Modified", sizeof(cl_ht->reply_reason_phrase)-1 );
+    return false;
+  }
+
+  cl_ht_file->position = 0;
+  cl_ht_file->end = l_size;
+  int l_range = 0;
+  if ( (l_hdr = dap_http_header_find(cl_ht->in_headers, "Range")) )
+    l_range = s_range_parse( l_hdr->value, l_size, &cl_ht_file->position, &cl_ht_file->end );
+  if ( l_range < 0 ) {
+    log_it( L_WARNING, "Range \"%s\" is out of %s", l_hdr->value, cl_ht_file->local_path );
+    cl_ht->reply_status_code = Http_Status_RangeNotSatisfiable;
+    strncpy( cl_ht->reply_reason_phrase, "Range Not Satisfiable", sizeof(cl_ht->reply_reason_phrase)-1 );
+    dap_http_out_header_add_f( cl_ht, "Content-Range", "bytes */%"DAP_UINT64_FORMAT_U, l_size );
+    return false;
+  }
 
-  if ( cl_ht_file->fd == NULL ) {
+  cl_ht_file->fd = open( cl_ht_file->local_path, O_RDONLY | O_BINARY );
+
+  if ( cl_ht_file->fd < 0 ) {
     log_it(L_ERROR, "Can't open %s: %s",cl_ht_file->local_path,strerror(errno));
     cl_ht->reply_status_code = Http_Status_NotFound;
     strncpy( cl_ht->reply_reason_phrase, "Not Found", sizeof(cl_ht->reply_reason_phrase)-1 );
   }
   else {
-    cl_ht->reply_status_code = Http_Status_OK;
-    strncpy( cl_ht->reply_reason_phrase,"OK",sizeof(cl_ht->reply_reason_phrase)-1 );
+    if ( l_range ) {
+      cl_ht->reply_status_code = Http_Status_PartialContent;
+      strncpy( cl_ht->reply_reason_phrase, "Partial Content", sizeof(cl_ht->reply_reason_phrase)-1 );
+      dap_http_out_header_add_f( cl_ht, "Content-Range", "bytes %"DAP_UINT64_FORMAT_U"-%"DAP_UINT64_FORMAT_U"/%"DAP_UINT64_FORMAT_U,
+                                 cl_ht_file->position, cl_ht_file->end - 1, l_size );
+    } else {
+      cl_ht->reply_status_code = Http_Status_OK;
+      strncpy( cl_ht->reply_reason_phrase,"OK",sizeof(cl_ht->reply_reason_phrase)-1 );
+    }
+    cl_ht->out_content_length = cl_ht_file->end - cl_ht_file->position;
 
-    const char *mime_type = "application/octet-stream";/* magic_file( up_folder->mime_detector, cl_ht_file->local_path );
+    const char *mime_type = s_mime_type( cl_ht_file->local_path );/* magic_file( up_folder->mime_detector, cl_ht_file->local_path );
 
     if( mime_type ) { */
       strncpy(cl_ht->out_content_type,mime_type,sizeof(cl_ht->out_content_type)-1);
@@ -261,6 +751,32 @@ bool dap_http_folder_headers_write( dap_http_client_t *cl_ht, void * arg)
       cl_ht->esocket->flags |= DAP_SOCK_SIGNAL_CLOSE;
       log_it(L_WARNING,"Can't detect MIME type of %s file: %s",cl_ht_file->local_path,magic_error(up_folder->mime_detector));
     }*/
+
+    // Ranges are served from the file as is, compressed copy doesn't support them
+    if ( !l_range ) {
+      s_gzip_try( cl_ht, cl_ht_file, l_size );
+      if ( cl_ht_file->gzip )
+        return false;
+    }
+    dap_http_out_header_add( cl_ht, "Accept-Ranges", "bytes" );
+
+    // Zero-copy modes write to the socket directly, SSL sockets have to go through the output buffer
+    cl_ht_file->send_mode = s_esocket_is_plain(cl_ht->esocket) ? s_send_mode : DAP_HTTP_FOLDER_SEND_BUFFERED;
+#ifdef DAP_OS_UNIX
+    if ( cl_ht_file->send_mode == DAP_HTTP_FOLDER_SEND_MMAP && cl_ht->out_content_length ) {
+      cl_ht_file->map = mmap( NULL, l_size, PROT_READ, MAP_SHARED, cl_ht_file->fd, 0 );
+      if ( cl_ht_file->map == MAP_FAILED ) {
+        log_it( L_WARNING, "Can't map %s: %s, fall back to buffered send", cl_ht_file->local_path, strerror(errno) );
+        cl_ht_file->map = NULL;
+        cl_ht_file->send_mode = DAP_HTTP_FOLDER_SEND_BUFFERED;
+      } else {
+        cl_ht_file->map_size = l_size;
+        madvise( cl_ht_file->map, l_size, MADV_SEQUENTIAL );
+      }
+    }
+#endif
+    if ( cl_ht_file->send_mode == DAP_HTTP_FOLDER_SEND_BUFFERED && cl_ht_file->position )
+      lseek( cl_ht_file->fd, (off_t)cl_ht_file->position, SEEK_SET );
   }
 
   return false;
@@ -286,28 +802,88 @@ void dap_http_folder_data_read(dap_http_client_t * cl_ht, void * arg)
     *bytes_return=cl_ht->esocket->buf_in_size;
 }
 
+/**
+ * @brief s_file_send_finished Release the file and go on with the connection when the whole range is sent
+ * @param a_http_client HTTP client instance
+ * @param a_file File response data
+ */
+static void s_file_send_finished(dap_http_client_t *a_http_client, dap_http_file_t *a_file)
+{
+    log_it(L_INFO, "All the file %s is sent out", a_file->local_path);
+    s_file_close(a_file);
+    dap_http_client_request_done(a_http_client);
+}
+
 /**
  * @brief dap_http_folder_write HTTP client callback for writting function for the folder processing
+ * @details Plain sockets get the file with sendfile() or send() from the mapping, bypassing the output buffer,
+ *          so the buffered headers must be flushed by reactor first
  * @param cl_ht HTTP client instance
  * @param arg
+ * @return true if write event is needed again
  */
 bool dap_http_folder_data_write(dap_http_client_t * cl_ht, void * arg)
 {
     (void) arg;
-    dap_http_file_t * cl_ht_file= DAP_HTTP_FILE(cl_ht);
-    cl_ht->esocket->buf_out_size=fread(cl_ht->esocket->buf_out, 1, cl_ht->esocket->buf_out_size_max + 1, cl_ht_file->fd);
-    cl_ht_file->position+=cl_ht->esocket->buf_out_size;
-    dap_events_socket_set_writable_unsafe(cl_ht->esocket, true);
-
-    if(feof(cl_ht_file->fd)!=0){
-        log_it(L_INFO, "All the file %s is sent out",cl_ht_file->local_path);
-        //strncat(cl_ht->client->buf_out+cl_ht->client->buf_out_size,"\r\n",sizeof(cl_ht->client->buf_out));
-        fclose(cl_ht_file->fd);
-        dap_events_socket_set_writable_unsafe(cl_ht->esocket,false);
-
-        if ( !cl_ht->keep_alive )
-            cl_ht->esocket->flags |= DAP_SOCK_SIGNAL_CLOSE;
+    dap_http_file_t *cl_ht_file = DAP_HTTP_FILE(cl_ht);
+    dap_events_socket_t *l_es = cl_ht->esocket;
+    if (!cl_ht_file || (cl_ht_file->fd < 0 && !cl_ht_file->gzip))
+        return false;
+    if (cl_ht_file->position >= cl_ht_file->end) {
+        if (l_es->buf_out_size)
+            return true;                                                    /* Reactor doesn't flush buffer of closing socket, wait for the tail */
+        s_file_send_finished(cl_ht, cl_ht_file);
+        return false;
     }
-    return false;
+    if (cl_ht_file->gzip) {
+        // Compressed copy is in memory, it goes through the output buffer as it has room
+        size_t l_free = dap_events_socket_get_free_buf_size(l_es);
+        if (l_free)
+            cl_ht_file->position += dap_events_socket_write_unsafe(l_es, cl_ht_file->gzip->data + cl_ht_file->position,
+                                                                   dap_min(cl_ht_file->end - cl_ht_file->position, (uint64_t)l_free));
+        l_es->last_time_active = time(NULL);
+        return true;
+    }
+    size_t l_chunk = dap_min(cl_ht_file->end - cl_ht_file->position, (uint64_t)DAP_HTTP_FOLDER_SEND_CHUNK);
+    ssize_t l_sent;
+    int l_errno;
+    switch (cl_ht_file->send_mode) {
+#ifdef DAP_OS_LINUX
+    case DAP_HTTP_FOLDER_SEND_SENDFILE: {
+        if (l_es->buf_out_size)
+            return true;
+        off_t l_offset = (off_t)cl_ht_file->position;
+        l_sent = sendfile(l_es->socket, cl_ht_file->fd, &l_offset, l_chunk);
+        l_errno = l_sent ? errno : EIO;                                     /* Zero means the file is truncated under us */
+    } break;
+#endif
+#ifdef DAP_OS_UNIX
+    case DAP_HTTP_FOLDER_SEND_MMAP:
+        if (l_es->buf_out_size)
+            return true;
+        l_sent = send(l_es->socket, (const byte_t *)cl_ht_file->map + cl_ht_file->position, l_chunk, MSG_DONTWAIT | MSG_NOSIGNAL);
+        l_errno = errno;
+        break;
+#endif
+    default:
+        if (!dap_events_socket_get_free_buf_size(l_es))
+            return true;
+        l_chunk = dap_min(l_chunk, dap_events_socket_get_free_buf_size(l_es));
+        l_sent = read(cl_ht_file->fd, l_es->buf_out + l_es->buf_out_size, l_chunk);
+        l_errno = l_sent ? errno : EIO;
+        if (l_sent > 0)
+            l_es->buf_out_size += l_sent;
+        break;
+    }
+    if (l_sent <= 0) {
+        if (l_sent && (l_errno == EAGAIN || l_errno == EWOULDBLOCK || l_errno == EINTR))
+            return true;
+        log_it(L_ERROR, "Can't send file %s: %s", cl_ht_file->local_path, dap_strerror(l_errno));
+        s_file_close(cl_ht_file);
+        l_es->flags |= DAP_SOCK_SIGNAL_CLOSE;
+        return false;
+    }
+    cl_ht_file->position += l_sent;
+    l_es->last_time_active = time(NULL);
+    return true;
 }
-
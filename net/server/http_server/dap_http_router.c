@@ -0,0 +1,310 @@
+/*
+ * Authors:
+ * DeM Labs Ltd.   https://demlabs.net
+ * Copyright  (c) 2024
+ * All rights reserved.
+
+ This file is part of DAP SDK the open source project
+
+    DAP SDK is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    DAP SDK is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "uthash.h"
+#include "utlist.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_http_server.h"
+#include "dap_http_router.h"
+
+#define LOG_TAG "http_router"
+
+typedef struct route_handler {
+    uint32_t methods;                                                       /* Zero for any method */
+    bool tail;                                                              /* Processor gets the rest of path or the last segment, not the whole path */
+    dap_http_url_proc_t *proc;
+    struct route_handler *next;
+} route_handler_t;
+
+typedef struct dap_http_route_node {
+    char *segment;                                                          /* Parameter name for parameter node */
+    bool param_empty;                                                       /* Legacy parameter matches empty segment too */
+    struct dap_http_route_node *children, *param;
+    route_handler_t *handlers, *prefix_handlers;
+    UT_hash_handle hh;
+} route_node_t;
+
+static const char *s_methods[] = { "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH", "CONNECT", "TRACE" };
+
+static uint32_t s_method_bit(const char *a_method, size_t a_len)
+{
+    for (size_t i = 0; i < sizeof(s_methods) / sizeof(*s_methods); i++)
+        if (!strncmp(s_methods[i], a_method, a_len) && !s_methods[i][a_len])
+            return 1U << i;
+    return 0;
+}
+
+/**
+ * @brief dap_http_route_methods_str
+ * @param a_methods Methods bitmask
+ * @param a_buf Output buffer
+ * @param a_buf_size
+ * @return String length
+ */
+size_t dap_http_route_methods_str(uint32_t a_methods, char *a_buf, size_t a_buf_size)
+{
+    size_t l_len = 0;
+    if (a_buf_size)
+        *a_buf = '\0';
+    for (size_t i = 0; i < sizeof(s_methods) / sizeof(*s_methods) && l_len < a_buf_size; i++)
+        if (a_methods & (1U << i))
+            l_len += snprintf(a_buf + l_len, a_buf_size - l_len, "%s%s", l_len ? ", " : "", s_methods[i]);
+    return dap_min(l_len, a_buf_size ? a_buf_size - 1 : 0);
+}
+
+static route_node_t *s_node_new(const char *a_segment, size_t a_len)
+{
+    route_node_t *l_node = DAP_NEW_Z_RET_VAL_IF_FAIL(route_node_t, NULL);
+    if ( !(l_node->segment = DAP_NEW_Z_SIZE(char, a_len + 1)) ) {
+        DAP_DELETE(l_node);
+        return log_it(L_CRITICAL, "%s", c_error_memory_alloc), NULL;
+    }
+    memcpy(l_node->segment, a_segment, a_len);
+    return l_node;
+}
+
+static void s_node_delete(route_node_t *a_node)
+{
+    route_node_t *l_child, *l_tmp;
+    HASH_ITER(hh, a_node->children, l_child, l_tmp) {
+        HASH_DEL(a_node->children, l_child);
+        s_node_delete(l_child);
+    }
+    if (a_node->param)
+        s_node_delete(a_node->param);
+    route_handler_t *l_handler, *l_handler_tmp;
+    LL_FOREACH_SAFE(a_node->handlers, l_handler, l_handler_tmp)
+        DAP_DELETE(l_handler);
+    LL_FOREACH_SAFE(a_node->prefix_handlers, l_handler, l_handler_tmp)
+        DAP_DELETE(l_handler);
+    DAP_DEL_MULTY(a_node->segment, a_node);
+}
+
+static int s_handler_check(route_handler_t *a_list, uint32_t a_methods, dap_http_url_proc_t *a_proc)
+{
+    route_handler_t *l_handler;
+    LL_FOREACH(a_list, l_handler)
+        if (!l_handler->methods || !a_methods || (l_handler->methods & a_methods))
+            return log_it(L_ERROR, "URL \"%s\" is already routed to \"%s\"", a_proc->url, l_handler->proc->url), -3;
+    return 0;
+}
+
+static int s_handler_add(route_handler_t **a_list, uint32_t a_methods, bool a_tail, dap_http_url_proc_t *a_proc)
+{
+    if ( s_handler_check(*a_list, a_methods, a_proc) )
+        return -3;
+    route_handler_t *l_handler = DAP_NEW_Z_RET_VAL_IF_FAIL(route_handler_t, -1);
+    *l_handler = (route_handler_t) { .methods = a_methods, .tail = a_tail, .proc = a_proc };
+    // Method specific handlers are checked before any method one
+    if (a_methods)
+        LL_PREPEND(*a_list, l_handler);
+    else
+        LL_APPEND(*a_list, l_handler);
+    return 0;
+}
+
+static route_node_t *s_param_node(route_node_t *a_node, const char *a_name, size_t a_len, bool a_empty)
+{
+    if (a_node->param) {
+        if (strlen(a_node->param->segment) != a_len || strncmp(a_node->param->segment, a_name, a_len) || a_node->param->param_empty != a_empty)
+            return log_it(L_ERROR, "Parameter \":%.*s\" conflicts with \":%s\" of other route", (int)a_len, a_name, a_node->param->segment), NULL;
+        return a_node->param;
+    }
+    if ( (a_node->param = s_node_new(a_name, a_len)) )
+        a_node->param->param_empty = a_empty;
+    return a_node->param;
+}
+
+/**
+ * @brief dap_http_route_add Route requests matching the pattern to URL processor
+ * @param a_http HTTP server instance
+ * @param a_pattern Route pattern, see dap_http_router.h
+ * @param a_proc URL processor
+ * @return 0 if ok, negative if pattern is invalid or conflicts with existing route
+ */
+int dap_http_route_add(dap_http_server_t *a_http, const char *a_pattern, dap_http_url_proc_t *a_proc)
+{
+    dap_return_val_if_fail(a_http && a_pattern && a_proc, -1);
+    uint32_t l_methods = 0;
+    const char *l_path = a_pattern;
+    if (*l_path != '/') {
+        const char *l_end = strchr(a_pattern, ' ');
+        if (!l_end)
+            return log_it(L_ERROR, "Route pattern \"%s\" has no path", a_pattern), -2;
+        for (const char *l_method = a_pattern; l_method < l_end; ) {
+            const char *l_next = memchr(l_method, ',', l_end - l_method);
+            if (!l_next)
+                l_next = l_end;
+            uint32_t l_bit = s_method_bit(l_method, l_next - l_method);
+            if (!l_bit)
+                return log_it(L_ERROR, "Unknown method \"%.*s\" in route pattern \"%s\"", (int)(l_next - l_method), l_method, a_pattern), -2;
+            l_methods |= l_bit;
+            l_method = l_next + 1;
+        }
+        for (l_path = l_end; *l_path == ' '; l_path++);
+        if (*l_path != '/')
+            return log_it(L_ERROR, "Route pattern \"%s\" has no path", a_pattern), -2;
+    }
+    if (!a_http->routes && !(a_http->routes = s_node_new("", 0)))
+        return -1;
+    route_node_t *l_node = a_http->routes;
+    bool l_legacy = !l_methods;
+    const char *l_end = l_path + strlen(l_path);
+    // Root path has no segments
+    for (const char *l_seg = l_path[1] ? l_path + 1 : NULL; l_seg; ) {
+        const char *l_seg_end = memchr(l_seg, '/', l_end - l_seg);
+        if (!l_seg_end)
+            l_seg_end = l_end;
+        size_t l_len = l_seg_end - l_seg;
+        if (*l_seg == '*') {
+            if (l_len != 1 || l_seg_end != l_end)
+                return log_it(L_ERROR, "Wildcard is allowed as the last segment only in \"%s\"", a_pattern), -2;
+            return s_handler_add(&l_node->prefix_handlers, l_methods, true, a_proc);
+        }
+        if (*l_seg == ':') {
+            if (l_len == 1)
+                return log_it(L_ERROR, "Parameter without name in \"%s\"", a_pattern), -2;
+            l_node = s_param_node(l_node, l_seg + 1, l_len - 1, false);
+            l_legacy = false;
+        } else {
+            route_node_t *l_child = NULL;
+            HASH_FIND(hh, l_node->children, l_seg, l_len, l_child);
+            if (!l_child) {
+                if ( !(l_child = s_node_new(l_seg, l_len)) )
+                    return -1;
+                HASH_ADD_KEYPTR(hh, l_node->children, l_child->segment, l_len, l_child);
+            }
+            l_node = l_child;
+        }
+        if (!l_node)
+            return -2;
+        l_seg = l_seg_end < l_end ? l_seg_end + 1 : NULL;
+    }
+    // Plain path takes a single segment below it, as URL processors always did
+    route_node_t *l_param = NULL;
+    if (l_legacy && l_node != a_http->routes) {
+        if ( !(l_param = s_param_node(l_node, "", 0, true)) || s_handler_check(l_param->handlers, 0, a_proc) )
+            return -3;
+    }
+    int l_ret = s_handler_add(&l_node->handlers, l_methods, l_legacy, a_proc);
+    if (!l_ret && l_param && (l_ret = s_handler_add(&l_param->handlers, 0, true, a_proc))) {
+        route_handler_t *l_handler;
+        LL_SEARCH_SCALAR(l_node->handlers, l_handler, proc, a_proc);
+        LL_DELETE(l_node->handlers, l_handler);
+        DAP_DELETE(l_handler);
+    }
+    return l_ret;
+}
+
+static route_handler_t *s_handler_find(route_handler_t *a_list, uint32_t a_method, uint32_t *a_allowed)
+{
+    for ( ; a_list; a_list = a_list->next) {
+        if (!a_list->methods || (a_list->methods & a_method))
+            return a_list;
+        *a_allowed |= a_list->methods;
+    }
+    return NULL;
+}
+
+// Matches path from a_seg against the subtree, static children are tried first then parameter and prefix routes
+static route_handler_t *s_match(route_node_t *a_node, const char *a_seg, const char *a_last, const char *a_end, uint32_t a_method,
+                                dap_http_route_match_t *a_match, const char **a_tail)
+{
+    route_handler_t *l_ret;
+    if (!a_seg) {
+        if ( (l_ret = s_handler_find(a_node->handlers, a_method, &a_match->methods_allowed)) )
+            *a_tail = a_last;
+        else if ( (l_ret = s_handler_find(a_node->prefix_handlers, a_method, &a_match->methods_allowed)) )
+            *a_tail = a_end;
+        return l_ret;
+    }
+    const char *l_seg_end = memchr(a_seg, '/', a_end - a_seg);
+    if (!l_seg_end)
+        l_seg_end = a_end;
+    size_t l_len = l_seg_end - a_seg;
+    // No way out of the processor's directory
+    if (l_len == 2 && a_seg[0] == '.' && a_seg[1] == '.')
+        return NULL;
+    const char *l_next = l_seg_end < a_end ? l_seg_end + 1 : NULL;
+    route_node_t *l_child = NULL;
+    HASH_FIND(hh, a_node->children, a_seg, l_len, l_child);
+    if (l_child && (l_ret = s_match(l_child, l_next, a_seg, a_end, a_method, a_match, a_tail)))
+        return l_ret;
+    if (a_node->param && (l_len || a_node->param->param_empty)) {
+        uint8_t l_count = a_match->params_count;
+        if (*a_node->param->segment) {
+            if (l_count == DAP_HTTP_ROUTE_PARAMS_MAX)
+                return NULL;
+            a_match->params[a_match->params_count++] = (dap_http_route_param_t) {
+                .name = a_node->param->segment, .value = a_seg, .value_len = l_len };
+        }
+        if ( (l_ret = s_match(a_node->param, l_next, a_seg, a_end, a_method, a_match, a_tail)) )
+            return l_ret;
+        a_match->params_count = l_count;
+    }
+    if ( (l_ret = s_handler_find(a_node->prefix_handlers, a_method, &a_match->methods_allowed)) )
+        *a_tail = a_seg;
+    return l_ret;
+}
+
+/**
+ * @brief dap_http_route_find Find URL processor for the request
+ * @param a_http HTTP server instance
+ * @param a_method Request method
+ * @param a_path URL path beginning with '/', without query string
+ * @param a_path_len
+ * @param a_match Output, processor, its url_path and parameters point to a_path
+ * @return Result code
+ */
+dap_http_route_result_t dap_http_route_find(dap_http_server_t *a_http, const char *a_method, const char *a_path, size_t a_path_len,
+                                            dap_http_route_match_t *a_match)
+{
+    dap_return_val_if_fail(a_http && a_method && a_path && a_match, DAP_HTTP_ROUTE_NOT_FOUND);
+    a_match->proc = NULL;
+    a_match->params_count = 0;
+    a_match->methods_allowed = 0;
+    if (!a_http->routes || !a_path_len || *a_path != '/')
+        return DAP_HTTP_ROUTE_NOT_FOUND;
+    const char *l_tail = NULL, *l_end = a_path + a_path_len;
+    route_handler_t *l_handler = s_match(a_http->routes, a_path_len > 1 ? a_path + 1 : NULL, a_path, l_end,
+                                         s_method_bit(a_method, strlen(a_method)), a_match, &l_tail);
+    if (!l_handler) {
+        a_match->params_count = 0;
+        return a_match->methods_allowed ? DAP_HTTP_ROUTE_METHOD_NOT_ALLOWED : DAP_HTTP_ROUTE_NOT_FOUND;
+    }
+    a_match->proc = l_handler->proc;
+    a_match->path = l_handler->tail ? l_tail : a_path;
+    a_match->path_len = l_end - a_match->path;
+    return DAP_HTTP_ROUTE_FOUND;
+}
+
+/**
+ * @brief dap_http_routes_delete Delete all routes of the server, URL processors are not deleted
+ * @param a_http HTTP server instance
+ */
+void dap_http_routes_delete(dap_http_server_t *a_http)
+{
+    dap_return_if_fail(a_http);
+    if (a_http->routes)
+        s_node_delete(a_http->routes);
+    a_http->routes = NULL;
+}
@@ -51,6 +51,8 @@
 #include "dap_http_server.h"
 #include "dap_http_header.h"
 #include "dap_http_client.h"
+#include "dap_http_ban_list_client.h"
+#include "dap_http_compress.h"
 #include "dap_strfuncs.h"
 
 #define LOG_TAG "http"
@@ -70,6 +72,9 @@ int dap_http_init( )
         return -2;
     }
 
+    dap_http_cache_init();
+    dap_http_compress_init();
+
     log_it( L_NOTICE, "Initialized HTTP server module" );
     return 0;
 }
@@ -81,9 +86,25 @@ void dap_http_deinit()
 {
     dap_http_header_deinit( );
     dap_http_client_deinit( );
+    dap_http_cache_deinit( );
+    dap_http_compress_deinit( );
 }
 
 
+/**
+ * @brief s_accept_check Drop connections from banned addresses and subnets before HTTP client is created
+ * @param a_server Server instance
+ * @param a_addr Remote address
+ * @return false if the address is banned
+ */
+static bool s_accept_check(dap_server_t *a_server, const struct sockaddr_storage *a_addr)
+{
+    if ( !dap_http_ban_list_client_check_sockaddr(a_addr, NULL, NULL) )
+        return true;
+    debug_if(a_server->ext_log, L_INFO, "Connection from banned address is dropped");
+    return false;
+}
+
 /**
  * @brief dap_server_http_init   Init HTTP server
  * @param a_server               Server instance
@@ -104,10 +125,13 @@ dap_server_t* dap_http_server_new(const char *a_cfg_section, const char *a_serve
         log_it(L_ERROR, "HTTP server was not created");
         return NULL;
     }
+    l_server->accept_check_callback = s_accept_check;
     dap_http_server_t *l_http_server = DAP_NEW_Z(dap_http_server_t);
     l_server->_inheritor = l_http_server;
     l_http_server->server = l_server;
     dap_strncpy(l_http_server->server_name, a_server_name, sizeof(l_http_server->server_name));
+    l_http_server->server_header_size = snprintf(l_http_server->server_header, sizeof(l_http_server->server_header),
+                                                 "Server: %s\r\n", l_http_server->server_name);
     return l_server;
 }
 
@@ -125,10 +149,12 @@ void dap_http_delete( dap_server_t *a_server, void * a_arg )
     HASH_ITER( hh, l_http->url_proc ,l_url_proc, l_tmp ) {
         // Clang bug at this, l_url_proc should change at every loop cycle
         HASH_DEL(l_http->url_proc, l_url_proc);
+        dap_http_cache_invalidate(l_url_proc);
         if( l_url_proc->_inheritor )
             DAP_DELETE(l_url_proc->_inheritor );
         DAP_DELETE(l_url_proc );
     }
+    dap_http_routes_delete(l_http);
 }
 
 
@@ -136,7 +162,7 @@ void dap_http_delete( dap_server_t *a_server, void * a_arg )
  * @brief dap_http_add_proc             Add custom procesor for the HTTP server
  * 
  * @param a_http                        Server's instance
- * @param a_url_path                    Part of URL to be processed
+ * @param a_url_path                    Part of URL to be processed or route pattern, see dap_http_router.h
  * @param a_inheritor                   Internal data specific to the current URL processor
  * @param a_new_callback                additional callback function
  * 
@@ -185,8 +211,12 @@ dap_http_url_proc_t * dap_http_add_proc(dap_http_server_t *a_http, const char *a
     l_url_proc->headers_write_callback = a_headers_write_callback;
     l_url_proc->error_callback = a_error_callback;
 
+    if ( dap_http_route_add(a_http, a_url_path, l_url_proc) ) {
+        log_it( L_ERROR, "Can't route '%s' to URL processor", a_url_path );
+        DAP_DELETE(l_url_proc);
+        return NULL;
+    }
     l_url_proc->_inheritor = a_inheritor;
-    pthread_rwlock_init(& l_url_proc->cache_rwlock, NULL);
 
     HASH_ADD_STR( a_http->url_proc, url, l_url_proc );
 
@@ -50,6 +50,7 @@ See more details here <http://www.gnu.org/licenses/>.
 #include "dap_http_client.h"
 #include "dap_http_simple.h"
 #include "dap_http_user_agent.h"
+#include "dap_http_compress.h"
 #include "dap_context.h"
 #include "http_status_code.h"
 
@@ -67,9 +68,19 @@ static bool s_proc_queue_callback(void *a_arg );
 
 typedef struct dap_http_simple_url_proc {
   dap_http_simple_callback_t proc_callback;
+  dap_http_simple_chunk_callback_t chunk_callback;
   size_t reply_size_max;
+  size_t request_size_limit;
 } dap_http_simple_url_proc_t;
 
+// Piece of request body passed to proc thread in streaming mode
+typedef struct http_simple_chunk {
+    dap_http_simple_t *http_simple;
+    bool last;
+    size_t size;
+    byte_t data[];
+} http_simple_chunk_t;
+
 
 typedef struct user_agents_item {
   dap_http_user_agent_ptr_t user_agent;
@@ -80,6 +91,9 @@ static user_agents_item_t *user_agents_list = NULL;
 static int is_unknown_user_agents_pass = 0;
 
 #define DAP_HTTP_SIMPLE_URL_PROC(a) ((dap_http_simple_url_proc_t*) (a)->_inheritor)
+#define DAP_HTTP_SIMPLE_CHUNKED_REQUEST_PREALLOC 4096
+#define DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE 10                   // Fixed width chunk size line "%08x" CRLF, leading zeros are allowed
+#define DAP_HTTP_SIMPLE_STREAM_BUF_SIZE (32 * 1024)             // Piece of streamed reply to compress
 
 static void s_free_user_agents_list( void );
 
@@ -101,6 +115,22 @@ void dap_http_simple_module_deinit( void )
  * @param a_callback Callback for data processing
  */
 struct dap_http_url_proc * dap_http_simple_proc_add( dap_http_server_t *a_http, const char *a_url_path, size_t a_reply_size_max, dap_http_simple_callback_t a_callback )
+{
+    return dap_http_simple_proc_add_streaming(a_http, a_url_path, a_reply_size_max, 0, NULL, a_callback);
+}
+
+/**
+ * @brief dap_http_simple_proc_add_streaming Add simple HTTP processor with request body streaming
+ * @param a_http HTTP server instance
+ * @param a_url_path URL path
+ * @param a_reply_size_max Maximum reply size
+ * @param a_request_size_limit Maximum request body size, 0 means no limit except DAP_HTTP_SIMPLE_CHUNKED_REQUEST_LIMIT
+ * @param a_chunk_callback Callback for request body pieces, if NULL the whole body is collected in request buffer
+ * @param a_callback Callback for data processing, called after the whole body is received
+ */
+struct dap_http_url_proc * dap_http_simple_proc_add_streaming( dap_http_server_t *a_http, const char *a_url_path, size_t a_reply_size_max,
+                                                               size_t a_request_size_limit, dap_http_simple_chunk_callback_t a_chunk_callback,
+                                                               dap_http_simple_callback_t a_callback )
 {
     dap_http_simple_url_proc_t *l_url_proc = DAP_NEW_Z( dap_http_simple_url_proc_t );
     if (!l_url_proc) {
@@ -109,7 +139,9 @@ struct dap_http_url_proc * dap_http_simple_proc_add( dap_http_server_t *a_http,
     }
 
     l_url_proc->proc_callback = a_callback;
+    l_url_proc->chunk_callback = a_chunk_callback;
     l_url_proc->reply_size_max = a_reply_size_max;
+    l_url_proc->request_size_limit = a_request_size_limit;
 
     return dap_http_add_proc( a_http, a_url_path,
                      l_url_proc, // Internal structure
@@ -120,6 +152,17 @@ struct dap_http_url_proc * dap_http_simple_proc_add( dap_http_server_t *a_http,
                      NULL); // errror
 }
 
+/**
+ * @brief dap_http_simple_set_request_size_limit Set maximum request body size for simple HTTP processor
+ * @param a_url_proc URL processor made with dap_http_simple_proc_add()
+ * @param a_request_size_limit Maximum request body size, 0 means no limit except DAP_HTTP_SIMPLE_CHUNKED_REQUEST_LIMIT
+ */
+void dap_http_simple_set_request_size_limit(struct dap_http_url_proc *a_url_proc, size_t a_request_size_limit)
+{
+    dap_return_if_fail(a_url_proc);
+    DAP_HTTP_SIMPLE_URL_PROC(a_url_proc)->request_size_limit = a_request_size_limit;
+}
+
 static void s_free_user_agents_list()
 {
 user_agents_item_t *elt, *tmp;
@@ -212,34 +255,72 @@ void dap_http_simple_set_pass_unknown_user_agents(int pass)
     is_unknown_user_agents_pass = pass;
 }
 
-static void s_esocket_worker_write_callback(void *a_arg)
+/**
+ * @brief s_http_simple_delete Free the request which esocket is deleted while it was processed in proc thread
+ * @param a_http_simple HTTP simple client instance
+ */
+static void s_http_simple_delete(dap_http_simple_t *a_http_simple)
+{
+    debug_if(g_debug_reactor, L_INFO, "Esocket 0x%"DAP_UINT64_FORMAT_x" is already deleted", a_http_simple->esocket_uuid);
+    dap_http_client_t *l_http_client = a_http_simple->http_client;
+    if (l_http_client) {
+        while (l_http_client->in_headers)
+            dap_http_header_remove(&l_http_client->in_headers, l_http_client->in_headers);
+        while (l_http_client->out_headers)
+            dap_http_header_remove(&l_http_client->out_headers, l_http_client->out_headers);
+        DAP_DELETE(l_http_client);
+    }
+    DAP_DEL_Z(a_http_simple->request);
+    DAP_DEL_Z(a_http_simple->reply);
+    DAP_DEL_Z(a_http_simple->_inheritor);
+    dap_http_compressor_delete(a_http_simple->compressor);
+    DAP_DEL_Z(a_http_simple->stream_buf);
+    DAP_DELETE(a_http_simple);
+}
+
+static dap_events_socket_t *s_esocket_find(dap_http_simple_t *a_http_simple)
 {
-    dap_http_simple_t *l_http_simple = (dap_http_simple_t*)a_arg;
     dap_worker_t *l_worker = dap_worker_get_current();
     if (!l_worker) {
         log_it(L_ERROR, "l_worker is NULL");
-        return;
+        return NULL;
     }
-    dap_events_socket_t *l_es = dap_context_find(l_worker->context, l_http_simple->esocket_uuid);
-    if (!l_es) {
-        debug_if(g_debug_reactor, L_INFO, "Esocket 0x%"DAP_UINT64_FORMAT_x" is already deleted", l_http_simple->esocket_uuid);
-        dap_http_client_t *l_http_client = l_http_simple->http_client;
-        if (l_http_client) {
-            while (l_http_client->in_headers)
-                dap_http_header_remove(&l_http_client->in_headers, l_http_client->in_headers);
-            while (l_http_client->out_headers)
-                dap_http_header_remove(&l_http_client->out_headers, l_http_client->out_headers);
-            DAP_DELETE(l_http_client);
-        }
-        DAP_DEL_Z(l_http_simple->request);
-        DAP_DEL_Z(l_http_simple->reply);
-        DAP_DELETE(l_http_simple);
+    dap_events_socket_t *l_es = dap_context_find(l_worker->context, a_http_simple->esocket_uuid);
+    if (!l_es)
+        s_http_simple_delete(a_http_simple);
+    return l_es;
+}
+
+static void s_esocket_worker_write_callback(void *a_arg)
+{
+    dap_http_simple_t *l_http_simple = (dap_http_simple_t*)a_arg;
+    dap_events_socket_t *l_es = s_esocket_find(l_http_simple);
+    if (!l_es)
         return;
-    }
     l_es->_inheritor = l_http_simple->http_client; // Back to the owner
     dap_http_client_write(l_http_simple->http_client);
 }
 
+/**
+ * @brief s_esocket_worker_resume_callback Continue request body reading after its piece is processed in streaming mode
+ * @param a_arg HTTP simple client instance
+ */
+static void s_esocket_worker_resume_callback(void *a_arg)
+{
+    dap_http_simple_t *l_http_simple = (dap_http_simple_t*)a_arg;
+    dap_events_socket_t *l_es = s_esocket_find(l_http_simple);
+    if (!l_es)
+        return;
+    dap_http_client_t *l_http_client = l_http_simple->http_client;
+    l_es->_inheritor = l_http_client; // Back to the owner
+    if (l_http_client->reply_status_code)
+        // Chunk callback rejected the request, rest of the body isn't read
+        return dap_http_client_reply_error(l_http_client, l_http_client->reply_status_code);
+    dap_events_socket_set_readable_unsafe(l_es, true);
+    if (l_es->buf_in_size)
+        dap_http_client_read(l_es, NULL);
+}
+
 inline static void s_write_data_to_socket(dap_http_simple_t *a_simple)
 {
     dap_worker_exec_callback_on(dap_events_worker_get(a_simple->worker->id), s_esocket_worker_write_callback, a_simple);
@@ -256,23 +337,93 @@ static bool s_http_client_headers_write(dap_http_client_t *cl_ht, void *a_arg)
         dap_http_out_header_add(cl_ht, i->name, i->value);
         log_it(L_DEBUG, "Added http header. %s: %s", i->name, i->value);
     }
-    
+    if (cl_ht->out_chunked && !l_hs->generate_default_header)
+        dap_http_out_header_add(cl_ht, "Transfer-Encoding", "chunked");
+
     return !l_hs->generate_default_header;
 }
 
 
+/**
+ * @brief s_stream_compress Compress the streamed reply, next piece of it is requested when the previous one is written out
+ * @param a_http_simple HTTP simple client instance
+ * @param a_buf Chunk data
+ * @param a_buf_size Room for chunk data
+ * @return Chunk size, negative value if the reply is aborted
+ */
+static ssize_t s_stream_compress(dap_http_simple_t *a_http_simple, void *a_buf, size_t a_buf_size)
+{
+    dap_http_compressor_t *l_compressor = a_http_simple->compressor;
+    if (dap_http_compressor_wants_input(l_compressor)) {
+        ssize_t l_size = a_http_simple->stream_callback(a_http_simple, a_http_simple->stream_buf, DAP_HTTP_SIMPLE_STREAM_BUF_SIZE);
+        if (l_size < 0)
+            return l_size;
+        a_http_simple->reply_sent += l_size;
+        dap_http_compressor_input(l_compressor, a_http_simple->stream_buf, l_size, !l_size);
+    }
+    return dap_http_compressor_output(l_compressor, a_buf, a_buf_size);
+}
+
+/**
+ * @brief s_stream_write Put next chunk of streamed reply into output buffer. New chunk is produced only when
+ *        the buffer has room, so the reply is generated as fast as the client reads it
+ * @param a_http_simple HTTP simple client instance
+ * @return true if there is more to write
+ */
+static bool s_stream_write(dap_http_simple_t *a_http_simple)
+{
+    dap_events_socket_t *l_es = a_http_simple->http_client->esocket;
+    if (a_http_simple->stream_over) {
+        if (l_es->buf_out_size)
+            return true;                                    // Reactor doesn't flush buffer of closing socket, wait for the tail
+        log_it(L_INFO, "All the streamed reply (%zu) is sent out", a_http_simple->reply_sent);
+        dap_http_client_request_done(a_http_simple->http_client);
+        return false;
+    }
+    size_t l_free = dap_events_socket_get_free_buf_size(l_es);
+    if (l_free <= DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE + 2)
+        return true;
+    byte_t *l_chunk = l_es->buf_out + l_es->buf_out_size;
+    size_t l_room = dap_min(l_free - DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE - 2, (size_t)UINT32_MAX);
+    ssize_t l_size = a_http_simple->compressor
+            ? s_stream_compress(a_http_simple, l_chunk + DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE, l_room)
+            : a_http_simple->stream_callback(a_http_simple, l_chunk + DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE, l_room);
+    if (l_size < 0) {
+        log_it(L_ERROR, "Streamed reply is aborted after %zu bytes", a_http_simple->reply_sent);
+        l_es->flags |= DAP_SOCK_SIGNAL_CLOSE;
+        return false;
+    }
+    if (l_size) {
+        char l_header[DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE + 1];
+        snprintf(l_header, sizeof(l_header), "%08x\r\n", (uint32_t)l_size);
+        memcpy(l_chunk, l_header, DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE);
+        memcpy(l_chunk + DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE + l_size, "\r\n", 2);
+        l_es->buf_out_size += DAP_HTTP_SIMPLE_CHUNK_HEADER_SIZE + l_size + 2;
+        if (!a_http_simple->compressor)
+            a_http_simple->reply_sent += l_size;
+    }
+    // Compressed stream is over when its trailer is out, input is over before that
+    if (a_http_simple->compressor ? dap_http_compressor_is_over(a_http_simple->compressor) : !l_size) {
+        dap_events_socket_write_unsafe(l_es, "0\r\n\r\n", 5);  // Last chunk with no trailer
+        a_http_simple->stream_over = true;
+    }
+    return true;
+}
+
 static bool s_http_client_data_write(dap_http_client_t * a_http_client, void *a_arg)
 {
     dap_http_simple_t *l_http_simple = DAP_HTTP_SIMPLE( a_http_client );
     assert(l_http_simple == a_arg);
     if (!a_arg)
         return false;
+    if (l_http_simple->stream_callback)
+        return s_stream_write(l_http_simple);
     l_http_simple->reply_sent += dap_events_socket_write_unsafe(l_http_simple->esocket,
                                               l_http_simple->reply_byte + l_http_simple->reply_sent,
                                               l_http_simple->http_client->out_content_length - l_http_simple->reply_sent);
     if (l_http_simple->reply_sent >= a_http_client->out_content_length) {
         log_it(L_INFO, "All the reply (%zu) is sent out", a_http_client->out_content_length);
-        a_http_client->esocket->flags |= DAP_SOCK_SIGNAL_CLOSE;
+        dap_http_client_request_done(a_http_client);
         return false;
     }
     return true;
@@ -356,16 +507,113 @@ static bool s_proc_queue_callback(void *a_arg)
 
     DAP_HTTP_SIMPLE_URL_PROC(l_http_simple->http_client->proc)->proc_callback(l_http_simple,&return_code);
 
-    if(return_code) {
-        log_it(L_DEBUG, "Request was processed well return_code=%d", return_code);
-        l_http_simple->http_client->reply_status_code = (uint16_t)return_code;
-        s_copy_reply_and_mime_to_response(l_http_simple);
+    if (!l_http_simple->reply_deferred)
+        dap_http_simple_proc_done(l_http_simple, return_code);
+    return false;
+}
+
+/**
+ * @brief s_proc_chunk_callback Pass a piece of request body to the chunk callback in streaming mode
+ * @param a_arg Request body piece
+ */
+static bool s_proc_chunk_callback(void *a_arg)
+{
+    http_simple_chunk_t *l_chunk = (http_simple_chunk_t *)a_arg;
+    dap_http_simple_t *l_http_simple = l_chunk->http_simple;
+    bool l_last = l_chunk->last;
+    http_status_code_t l_ret = l_chunk->size
+            ? DAP_HTTP_SIMPLE_URL_PROC(l_http_simple->http_client->proc)->chunk_callback(l_http_simple, l_chunk->data, l_chunk->size)
+            : Http_Status_OK;
+    DAP_DELETE(l_chunk);
+    if (l_ret != Http_Status_OK) {
+        log_it(L_WARNING, "Request body is rejected with code %d", l_ret);
+        l_http_simple->http_client->reply_status_code = l_ret ? (uint16_t)l_ret : Http_Status_InternalServerError;
+        dap_worker_exec_callback_on(dap_events_worker_get(l_http_simple->worker->id), s_esocket_worker_resume_callback, l_http_simple);
+    } else if (l_last)
+        s_proc_queue_callback(l_http_simple);
+    else
+        dap_worker_exec_callback_on(dap_events_worker_get(l_http_simple->worker->id), s_esocket_worker_resume_callback, l_http_simple);
+    return false;
+}
+
+/**
+ * @brief s_reply_compress Compress the reply body for the client which accepts it, in proc thread
+ * @param a_http_simple HTTP simple client instance with the reply ready
+ */
+static void s_reply_compress(dap_http_simple_t *a_http_simple)
+{
+    dap_http_client_t *l_http_client = a_http_simple->http_client;
+    if (!dap_http_compress_allowed(l_http_client->out_content_type, a_http_simple->reply_size))
+        return;
+    l_http_client->out_vary_encoding = true;
+    // Tagged reply is the cached one, it's sent as tagged. Compressed variant is in the cache for the next requests
+    if (dap_http_header_find(a_http_simple->ext_headers, "ETag"))
+        return;
+    dap_http_encoding_t l_encoding = dap_http_compress_negotiate(l_http_client, l_http_client->out_content_type, a_http_simple->reply_size);
+    size_t l_size = 0;
+    uint8_t *l_reply = l_encoding ? dap_http_compress(l_encoding, a_http_simple->reply, a_http_simple->reply_size, &l_size) : NULL;
+    if (!l_reply)
+        return;
+    log_it(L_DEBUG, "Reply %zu bytes is compressed to %zu", a_http_simple->reply_size, l_size);
+    DAP_DELETE(a_http_simple->reply);
+    a_http_simple->reply_byte = l_reply;
+    a_http_simple->reply_size = a_http_simple->reply_size_max = l_size;
+    l_http_client->out_content_length = l_size;
+    l_http_client->out_encoding = l_encoding;
+}
+
+/**
+ * @brief s_stream_compress_start Set up compression of the streamed reply for the client which accepts it
+ * @param a_http_simple HTTP simple client instance
+ */
+static void s_stream_compress_start(dap_http_simple_t *a_http_simple)
+{
+    dap_http_client_t *l_http_client = a_http_simple->http_client;
+    if (!dap_http_compress_allowed(a_http_simple->reply_mime, DAP_HTTP_COMPRESS_SIZE_UNKNOWN))
+        return;
+    l_http_client->out_vary_encoding = true;
+    dap_http_encoding_t l_encoding = dap_http_compress_negotiate(l_http_client, a_http_simple->reply_mime, DAP_HTTP_COMPRESS_SIZE_UNKNOWN);
+    if (!l_encoding || !(a_http_simple->compressor = dap_http_compressor_new(l_encoding)))
+        return;
+    if (!(a_http_simple->stream_buf = DAP_NEW_SIZE(uint8_t, DAP_HTTP_SIMPLE_STREAM_BUF_SIZE))) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        dap_http_compressor_delete(a_http_simple->compressor);
+        a_http_simple->compressor = NULL;
+        return;
+    }
+    l_http_client->out_encoding = l_encoding;
+}
+
+/**
+ * @brief dap_http_simple_proc_done set reply status and send the reply. Thread safe
+ * @param a_http_simple HTTP simple client instance
+ * @param a_return_code reply status, 0 means processing error
+ */
+void dap_http_simple_proc_done(dap_http_simple_t *a_http_simple, http_status_code_t a_return_code)
+{
+    if (a_return_code) {
+        log_it(L_DEBUG, "Request was processed well return_code=%d", a_return_code);
+        a_http_simple->http_client->reply_status_code = (uint16_t)a_return_code;
+        time_t l_ttl = a_http_simple->http_client->proc->cache_ttl;
+        if (a_http_simple->stream_callback && a_return_code == Http_Status_OK) {
+            // Streamed reply is never cached, its length is unknown
+            a_http_simple->http_client->out_chunked = true;
+            dap_strncpy(a_http_simple->http_client->out_content_type, a_http_simple->reply_mime,
+                        sizeof(a_http_simple->http_client->out_content_type));
+            s_stream_compress_start(a_http_simple);
+        } else if (l_ttl && a_return_code == Http_Status_OK && !dap_http_header_find(a_http_simple->ext_headers, "ETag"))
+            // Cache policy of the proc, unless its callback has cached the reply itself
+            dap_http_cache_release(dap_http_simple_make_cache_from_reply(a_http_simple, time(NULL) + l_ttl));
+        else {
+            s_copy_reply_and_mime_to_response(a_http_simple);
+            if (a_return_code == Http_Status_OK)
+                s_reply_compress(a_http_simple);
+        }
     } else {
         log_it(L_ERROR, "Request was processed with ERROR");
-        l_http_simple->http_client->reply_status_code = Http_Status_InternalServerError;
+        a_http_simple->http_client->reply_status_code = Http_Status_InternalServerError;
     }
-    s_write_data_to_socket(l_http_simple);
-    return false;
+    s_write_data_to_socket(a_http_simple);
 }
 
 static void s_http_client_new(dap_http_client_t *a_http_client, UNUSED_ARG void *arg)
@@ -390,11 +638,14 @@ static void s_http_client_delete(dap_http_client_t *a_http_client, void *arg)
     dap_http_simple_t * l_http_simple = DAP_HTTP_SIMPLE(a_http_client);
 
     if (l_http_simple) {
-        for (dap_http_header_t *i = l_http_simple->ext_headers; i ;i = i->next){
-            dap_http_header_remove(&l_http_simple->ext_headers, i);
-        }
+        while (l_http_simple->ext_headers)
+            dap_http_header_remove(&l_http_simple->ext_headers, l_http_simple->ext_headers);
         DAP_DEL_Z(l_http_simple->request);
         DAP_DEL_Z(l_http_simple->reply_byte);
+        DAP_DEL_Z(l_http_simple->_inheritor);
+        dap_http_compressor_delete(l_http_simple->compressor);
+        l_http_simple->compressor = NULL;
+        DAP_DEL_Z(l_http_simple->stream_buf);
         l_http_simple->http_client = NULL;
     }
 }
@@ -408,7 +659,21 @@ static void s_http_client_headers_read( dap_http_client_t *a_http_client, void U
         dap_http_out_header_add(a_http_client, "Access-Control-Allow-Origin", "*");
     }
 
-    if( a_http_client->in_content_length ) {
+    dap_http_simple_url_proc_t *l_url_proc = DAP_HTTP_SIMPLE_URL_PROC(a_http_client->proc);
+    if ( l_url_proc->request_size_limit && a_http_client->in_content_length > l_url_proc->request_size_limit ) {
+        log_it(L_WARNING, "Content-Length %zu exceeds the limit %zu", a_http_client->in_content_length, l_url_proc->request_size_limit);
+        return dap_http_client_reply_error(a_http_client, Http_Status_PayloadTooLarge);
+    }
+    if ( l_url_proc->chunk_callback && (a_http_client->in_content_length || a_http_client->in_chunked) )
+        return;                                                     // Body is passed by pieces, no buffer needed
+    if ( a_http_client->in_chunked ) {
+        // Body size is unknown, the buffer grows with it
+        l_http_simple->request_size_max = DAP_HTTP_SIMPLE_CHUNKED_REQUEST_PREALLOC;
+        if ( !(l_http_simple->request = DAP_NEW_Z_SIZE(void, l_http_simple->request_size_max)) ) {
+            log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+            return dap_http_client_reply_error(a_http_client, Http_Status_InternalServerError);
+        }
+    } else if( a_http_client->in_content_length ) {
         // dbg if( a_http_client->in_content_length < 3){
         if( a_http_client->in_content_length > 0){
             l_http_simple->request_size_max = a_http_client->in_content_length + 1;
@@ -444,10 +709,48 @@ void s_http_client_data_read( dap_http_client_t *a_http_client, void * a_arg )
         return;
     }
 
-    size_t bytes_to_read = (a_http_client->esocket->buf_in_size + l_http_simple->request_size) < a_http_client->in_content_length ?
+    dap_http_simple_url_proc_t *l_url_proc = DAP_HTTP_SIMPLE_URL_PROC(a_http_client->proc);
+    bool l_chunked = a_http_client->in_chunked;
+    size_t bytes_to_read = l_chunked || (a_http_client->esocket->buf_in_size + l_http_simple->request_size) < a_http_client->in_content_length ?
                             a_http_client->esocket->buf_in_size : ( a_http_client->in_content_length - l_http_simple->request_size );
+    // Buffer for chunked body grows with it, so it's never unlimited
+    size_t l_size_limit = l_url_proc->request_size_limit || !l_chunked || l_url_proc->chunk_callback
+            ? l_url_proc->request_size_limit : DAP_HTTP_SIMPLE_CHUNKED_REQUEST_LIMIT;
+    if ( l_size_limit && l_http_simple->request_size + bytes_to_read > l_size_limit ) {
+        log_it(L_WARNING, "Request body exceeds the limit %zu", l_size_limit);
+        return dap_http_client_reply_error(a_http_client, Http_Status_PayloadTooLarge);
+    }
+    bool l_complete = l_chunked ? a_http_client->in_chunk_state == DAP_HTTP_CHUNK_DONE
+                                : l_http_simple->request_size + bytes_to_read >= a_http_client->in_content_length;
+
+    if ( l_url_proc->chunk_callback ) {
+        // Streaming mode, reading is paused until the piece is processed
+        http_simple_chunk_t *l_chunk = DAP_NEW_Z_SIZE(http_simple_chunk_t, sizeof(http_simple_chunk_t) + bytes_to_read);
+        if (!l_chunk) {
+            log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+            return dap_http_client_reply_error(a_http_client, Http_Status_InternalServerError);
+        }
+        *l_chunk = (http_simple_chunk_t) { .http_simple = l_http_simple, .last = l_complete, .size = bytes_to_read };
+        memcpy(l_chunk->data, a_http_client->esocket->buf_in, bytes_to_read);
+        l_http_simple->request_size += bytes_to_read;
+        *ret = (int)bytes_to_read;
+        dap_events_socket_set_readable_unsafe(a_http_client->esocket, false);
+        a_http_client->esocket->_inheritor = NULL;
+        dap_proc_thread_callback_add(l_http_simple->worker->proc_queue_input, s_proc_chunk_callback, l_chunk);
+        return;
+    }
 
     if( bytes_to_read ) {
+        if ( l_chunked && l_http_simple->request_size + bytes_to_read >= l_http_simple->request_size_max ) {
+            size_t l_size_max = dap_max(l_http_simple->request_size_max * 2, l_http_simple->request_size + bytes_to_read + 1);
+            byte_t *l_req_new = DAP_REALLOC((byte_t*)l_http_simple->request, l_size_max);
+            if (!l_req_new) {
+                log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+                return dap_http_client_reply_error(a_http_client, Http_Status_InternalServerError);
+            }
+            l_http_simple->request = l_req_new;
+            l_http_simple->request_size_max = l_size_max;
+        }
         // Oops! The client sent more data than write in the CONTENT_LENGTH header
         if(l_http_simple->request_size + bytes_to_read > l_http_simple->request_size_max){
             log_it(L_WARNING, "Client sent more data length=%zu than in content-length=%zu in request", l_http_simple->request_size + bytes_to_read, a_http_client->in_content_length);
@@ -464,10 +767,11 @@ void s_http_client_data_read( dap_http_client_t *a_http_client, void * a_arg )
         if(l_http_simple->request){// request_byte=request
             memcpy( l_http_simple->request_byte + l_http_simple->request_size, a_http_client->esocket->buf_in, bytes_to_read );
             l_http_simple->request_size += bytes_to_read;
+            l_http_simple->request_byte[l_http_simple->request_size] = '\0';
         }
     }
     *ret = (int) a_http_client->esocket->buf_in_size;
-    if( l_http_simple->request_size >= a_http_client->in_content_length ) {
+    if( l_complete ) {
 
         // bool isOK=true;
         log_it( L_INFO,"Data for http_simple_request collected" );
@@ -500,18 +804,20 @@ size_t dap_http_simple_reply(dap_http_simple_t *a_http_simple, void *a_data, siz
  * @brief dap_http_simple_make_cache_from_reply
  * @param a_http_simple
  * @param a_ts_expire
+ * @return Referenced cache object, release it with dap_http_cache_release(), or NULL
  */
 dap_http_cache_t * dap_http_simple_make_cache_from_reply(dap_http_simple_t * a_http_simple, time_t a_ts_expire  )
 {
     // Because we call it from callback, we have no headers ready for output
     s_copy_reply_and_mime_to_response(a_http_simple);
-    a_http_simple->http_client->reply_status_code = Http_Status_OK;
-    dap_http_client_out_header_generate(a_http_simple->http_client);
-    return dap_http_cache_update(a_http_simple->http_client->proc,
-                                 a_http_simple->reply_byte,
-                                 a_http_simple->reply_size,
-                                 a_http_simple->http_client->out_headers,NULL,
-                                  200, a_ts_expire);
+    dap_http_cache_t *l_cache = dap_http_cache_update(a_http_simple->http_client,
+                                                      a_http_simple->reply_byte,
+                                                      a_http_simple->reply_size,
+                                                      a_http_simple->ext_headers, NULL,
+                                                      Http_Status_OK, a_ts_expire);
+    if (l_cache)
+        dap_http_header_add(&a_http_simple->ext_headers, "ETag", l_cache->etag);
+    return l_cache;
 }
 
 /**
@@ -3,53 +3,304 @@
 #include "json_types.h"
 #include "dap_json_rpc_errors.h"
 
+#define LOG_TAG "dap_http_ban_list_client"
+
+#define BAN_EXPIRED_SWEEP_PERIOD    60
+#define BAN_FAMILY_NONE             -1                                      /* Key is not an IP address, e.g. node address, matched exactly */
+
 typedef struct ban_record {
     dap_hash_fast_t decree_hash;
-    dap_time_t ts_created;
+    dap_time_t ts_created, ts_expire;
+    int family;                                                             /* Index of prefix tree, 0 for IPv4, 1 for IPv6 or BAN_FAMILY_NONE */
+    uint8_t prefix[16];
+    unsigned prefix_len;
     UT_hash_handle hh;
     char addr[];
 } ban_record_t;
 
+// Binary prefix tree node, the record of the longest matched prefix wins
+typedef struct ban_node {
+    struct ban_node *child[2];
+    ban_record_t *rec;
+} ban_node_t;
+
 pthread_rwlock_t s_ban_list_lock = PTHREAD_RWLOCK_INITIALIZER;
 ban_record_t *s_ban_list;
+static ban_node_t s_ban_tree[2];
+static dap_time_t s_ts_sweep;
 
-bool dap_http_ban_list_client_check(const char *a_addr, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts) {
-    ban_record_t *l_rec = NULL;
+static const unsigned s_family_bits[2] = { 32, 128 };
+
+static inline unsigned s_bit(const uint8_t *a_bytes, unsigned a_n) { return (a_bytes[a_n >> 3] >> (7 - (a_n & 7))) & 1; }
+
+/**
+ * @brief s_addr_parse Parse address or subnet, IPv4-mapped IPv6 addresses are treated as IPv4
+ * @param a_addr Address string, optionally with "/prefix_len"
+ * @param a_bytes Address bytes with host bits cleared
+ * @param a_family Prefix tree index
+ * @param a_prefix_len Prefix length
+ * @param a_key Normalized string, plain address for full length prefix
+ * @return 0 if ok, -1 if the string is not an address, -2 if it's an address with invalid prefix length
+ */
+static int s_addr_parse(const char *a_addr, uint8_t a_bytes[16], int *a_family, unsigned *a_prefix_len, char a_key[INET6_ADDRSTRLEN + 4])
+{
+    char l_addr[INET6_ADDRSTRLEN + 4];
+    if (strlen(a_addr) >= sizeof(l_addr))
+        return -1;
+    dap_strncpy(l_addr, a_addr, sizeof(l_addr));
+    char *l_slash = strchr(l_addr, '/');
+    if (l_slash)
+        *l_slash++ = '\0';
+    memset(a_bytes, 0, 16);
+    if (inet_pton(AF_INET, l_addr, a_bytes) == 1)
+        *a_family = 0;
+    else if (inet_pton(AF_INET6, l_addr, a_bytes) == 1)
+        *a_family = 1;
+    else
+        return -1;
+    unsigned l_bits = s_family_bits[*a_family];
+    if (l_slash) {
+        char *l_end;
+        unsigned long l_len = strtoul(l_slash, &l_end, 10);
+        if (!*l_slash || *l_end || l_len > l_bits)
+            return -2;
+        l_bits = l_len;
+    }
+    if (*a_family && IN6_IS_ADDR_V4MAPPED((struct in6_addr *)a_bytes) && l_bits >= 96) {
+        memmove(a_bytes, a_bytes + 12, 4);
+        memset(a_bytes + 4, 0, 12);
+        *a_family = 0;
+        l_bits -= 96;
+    }
+    for (unsigned i = l_bits; i < s_family_bits[*a_family]; i++)
+        a_bytes[i >> 3] &= ~(0x80 >> (i & 7));
+    *a_prefix_len = l_bits;
+    inet_ntop(*a_family ? AF_INET6 : AF_INET, a_bytes, a_key, INET6_ADDRSTRLEN);
+    if (l_bits < s_family_bits[*a_family])
+        sprintf(a_key + strlen(a_key), "/%u", l_bits);
+    return 0;
+}
+
+static inline bool s_is_expired(ban_record_t *a_rec, dap_time_t a_now)
+{
+    return a_rec->ts_expire && a_rec->ts_expire <= a_now;
+}
+
+static ban_record_t *s_tree_lookup(int a_family, const uint8_t *a_bytes, dap_time_t a_now)
+{
+    ban_record_t *l_ret = NULL;
+    ban_node_t *l_node = &s_ban_tree[a_family];
+    for (unsigned i = 0; l_node; l_node = i < s_family_bits[a_family] ? l_node->child[s_bit(a_bytes, i)] : NULL, i++)
+        if (l_node->rec && !s_is_expired(l_node->rec, a_now))
+            l_ret = l_node->rec;
+    return l_ret;
+}
+
+// Free the nodes of the prefix branch which have no records and no children
+static void s_tree_prune(int a_family, const uint8_t *a_bytes, unsigned a_prefix_len)
+{
+    ban_node_t *l_path[129] = { &s_ban_tree[a_family] };
+    unsigned l_depth = 0;
+    for ( ; l_depth < a_prefix_len && l_path[l_depth]; l_depth++)
+        l_path[l_depth + 1] = l_path[l_depth]->child[s_bit(a_bytes, l_depth)];
+    while (!l_path[l_depth])
+        l_depth--;
+    for ( ; l_depth && !l_path[l_depth]->rec && !l_path[l_depth]->child[0] && !l_path[l_depth]->child[1]; l_depth--) {
+        l_path[l_depth - 1]->child[s_bit(a_bytes, l_depth - 1)] = NULL;
+        DAP_DELETE(l_path[l_depth]);
+    }
+}
+
+static ban_node_t *s_tree_insert(int a_family, const uint8_t *a_bytes, unsigned a_prefix_len)
+{
+    ban_node_t *l_node = &s_ban_tree[a_family];
+    for (unsigned i = 0; i < a_prefix_len; i++) {
+        ban_node_t **l_child = &l_node->child[s_bit(a_bytes, i)];
+        if (!*l_child && !(*l_child = DAP_NEW_Z(ban_node_t))) {
+            // Nodes made so far have nothing under them
+            s_tree_prune(a_family, a_bytes, i);
+            return NULL;
+        }
+        l_node = *l_child;
+    }
+    return l_node;
+}
+
+// Detach the record and free the branch which has no records anymore
+static void s_tree_remove(ban_record_t *a_rec)
+{
+    if (a_rec->family == BAN_FAMILY_NONE)
+        return;
+    ban_node_t *l_node = &s_ban_tree[a_rec->family];
+    for (unsigned i = 0; i < a_rec->prefix_len && l_node; i++)
+        l_node = l_node->child[s_bit(a_rec->prefix, i)];
+    if (!l_node || l_node->rec != a_rec)
+        return;
+    l_node->rec = NULL;
+    s_tree_prune(a_rec->family, a_rec->prefix, a_rec->prefix_len);
+}
+
+static void s_record_delete(ban_record_t *a_rec)
+{
+    s_tree_remove(a_rec);
+    HASH_DEL(s_ban_list, a_rec);
+    DAP_DELETE(a_rec);
+}
+
+static bool s_check(int a_family, const uint8_t *a_bytes, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts)
+{
     pthread_rwlock_rdlock(&s_ban_list_lock);
-    HASH_FIND_STR(s_ban_list, a_addr, l_rec);
+    ban_record_t *l_rec = s_ban_list ? s_tree_lookup(a_family, a_bytes, dap_time_now()) : NULL;
+    if (l_rec) {
+        if (a_decree_hash) *a_decree_hash = l_rec->decree_hash;
+        if (a_ts) *a_ts = l_rec->ts_created;
+    }
     pthread_rwlock_unlock(&s_ban_list_lock);
+    return l_rec;
+}
+
+// Exact match of the key which is not an IP address
+static bool s_check_key(const char *a_key, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts)
+{
+    ban_record_t *l_rec = NULL;
+    pthread_rwlock_rdlock(&s_ban_list_lock);
+    HASH_FIND_STR(s_ban_list, a_key, l_rec);
+    if (l_rec && s_is_expired(l_rec, dap_time_now()))
+        l_rec = NULL;
     if (l_rec) {
         if (a_decree_hash) *a_decree_hash = l_rec->decree_hash;
         if (a_ts) *a_ts = l_rec->ts_created;
-        return true;
     }
-    return false;
+    pthread_rwlock_unlock(&s_ban_list_lock);
+    return l_rec;
 }
 
-int dap_http_ban_list_client_add(const char *a_addr, dap_hash_fast_t a_decree_hash, dap_time_t a_ts) {
-    if ( dap_http_ban_list_client_check(a_addr, NULL, NULL) )
+bool dap_http_ban_list_client_check(const char *a_addr, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts) {
+    uint8_t l_bytes[16];
+    int l_family;
+    unsigned l_prefix_len;
+    char l_key[INET6_ADDRSTRLEN + 4];
+    if (!a_addr)
+        return false;
+    switch (s_addr_parse(a_addr, l_bytes, &l_family, &l_prefix_len, l_key)) {
+    case 0:
+        return s_check(l_family, l_bytes, a_decree_hash, a_ts);
+    case -1:
+        return s_check_key(a_addr, a_decree_hash, a_ts);
+    default:
+        return false;
+    }
+}
+
+bool dap_http_ban_list_client_check_sockaddr(const struct sockaddr_storage *a_addr, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts) {
+    switch (a_addr->ss_family) {
+    case AF_INET:
+        return s_check(0, (const uint8_t *)&((const struct sockaddr_in *)a_addr)->sin_addr, a_decree_hash, a_ts);
+    case AF_INET6: {
+        const struct in6_addr *l_addr = &((const struct sockaddr_in6 *)a_addr)->sin6_addr;
+        return IN6_IS_ADDR_V4MAPPED(l_addr)
+            ? s_check(0, (const uint8_t *)l_addr + 12, a_decree_hash, a_ts)
+            : s_check(1, (const uint8_t *)l_addr, a_decree_hash, a_ts);
+    }
+    default:
+        return false;
+    }
+}
+
+int dap_http_ban_list_client_add_ex(const char *a_addr, dap_hash_fast_t a_decree_hash, dap_time_t a_ts, dap_time_t a_ts_expire) {
+    uint8_t l_bytes[16];
+    int l_family;
+    unsigned l_prefix_len;
+    char l_addr_key[INET6_ADDRSTRLEN + 4];
+    const char *l_key = l_addr_key;
+    switch (a_addr && *a_addr ? s_addr_parse(a_addr, l_bytes, &l_family, &l_prefix_len, l_addr_key) : -2) {
+    case 0:
+        break;
+    case -1:
+        // Node address or other key, it has no prefix tree
+        l_key = a_addr;
+        l_family = BAN_FAMILY_NONE;
+        l_prefix_len = 0;
+        break;
+    default:
+        log_it(L_ERROR, "Invalid address or subnet \"%s\" to ban", a_addr ? a_addr : "(null)");
+        return -2;
+    }
+    ban_record_t *l_rec = NULL, *l_tmp;
+    dap_time_t l_now = dap_time_now();
+    pthread_rwlock_wrlock(&s_ban_list_lock);
+    if (l_now >= s_ts_sweep + BAN_EXPIRED_SWEEP_PERIOD) {
+        s_ts_sweep = l_now;
+        HASH_ITER(hh, s_ban_list, l_rec, l_tmp)
+            if (s_is_expired(l_rec, l_now))
+                s_record_delete(l_rec);
+    }
+    HASH_FIND_STR(s_ban_list, l_key, l_rec);
+    if (l_rec && !s_is_expired(l_rec, l_now)) {
+        pthread_rwlock_unlock(&s_ban_list_lock);
         return -1;
-    ban_record_t *l_rec = DAP_NEW_Z_SIZE( ban_record_t, sizeof(ban_record_t) + strlen(a_addr) + 1);
+    }
+    if (l_rec)
+        s_record_delete(l_rec);
+    l_rec = DAP_NEW_Z_SIZE(ban_record_t, sizeof(ban_record_t) + strlen(l_key) + 1);
+    ban_node_t *l_node = !l_rec || l_family == BAN_FAMILY_NONE ? NULL : s_tree_insert(l_family, l_bytes, l_prefix_len);
+    if (!l_rec || (!l_node && l_family != BAN_FAMILY_NONE)) {
+        pthread_rwlock_unlock(&s_ban_list_lock);
+        DAP_DEL_Z(l_rec);
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return -3;
+    }
     *l_rec = (ban_record_t) {
         .decree_hash = a_decree_hash,
         .ts_created = a_ts,
+        .ts_expire = a_ts_expire,
+        .family = l_family,
+        .prefix_len = l_prefix_len
     };
-    strcpy(l_rec->addr, a_addr);
-    pthread_rwlock_wrlock(&s_ban_list_lock);
+    if (l_node) {
+        memcpy(l_rec->prefix, l_bytes, sizeof(l_rec->prefix));
+        l_node->rec = l_rec;
+    }
+    strcpy(l_rec->addr, l_key);
     HASH_ADD_STR(s_ban_list, addr, l_rec);
     pthread_rwlock_unlock(&s_ban_list_lock);
     return 0;
 }
 
+int dap_http_ban_list_client_add(const char *a_addr, dap_hash_fast_t a_decree_hash, dap_time_t a_ts) {
+    return dap_http_ban_list_client_add_ex(a_addr, a_decree_hash, a_ts, 0);
+}
+
+/**
+ * @brief s_key_make Key of the ban record: normalized address or subnet, or the string itself if it's not an address
+ * @param a_addr Address, subnet or other key
+ * @param a_key Buffer for normalized address
+ * @return Key or NULL if address is invalid
+ */
+static const char *s_key_make(const char *a_addr, char a_key[INET6_ADDRSTRLEN + 4])
+{
+    uint8_t l_bytes[16];
+    int l_family;
+    unsigned l_prefix_len;
+    switch (a_addr ? s_addr_parse(a_addr, l_bytes, &l_family, &l_prefix_len, a_key) : -2) {
+    case 0: return a_key;
+    case -1: return a_addr;
+    default: return NULL;
+    }
+}
+
 int dap_http_ban_list_client_remove(const char *a_addr) {
+    char l_addr_key[INET6_ADDRSTRLEN + 4];
+    const char *l_key = s_key_make(a_addr, l_addr_key);
+    if (!l_key)
+        return -1;
     ban_record_t *l_rec = NULL;
     int l_ret = 0;
     pthread_rwlock_wrlock(&s_ban_list_lock);
-    HASH_FIND_STR(s_ban_list, a_addr, l_rec);
-    if (l_rec) {
-        HASH_DEL(s_ban_list, l_rec);
-        DAP_DELETE(l_rec);
-    } else
+    HASH_FIND_STR(s_ban_list, l_key, l_rec);
+    if (l_rec)
+        s_record_delete(l_rec);
+    else
         l_ret = -1;
     pthread_rwlock_unlock(&s_ban_list_lock);
     return l_ret;
@@ -62,6 +313,10 @@ static void s_dap_http_ban_list_client_dump_single(ban_record_t *a_rec, json_obj
     json_object_object_add(a_jobj_out, "decree_hash", json_object_new_string(l_decree_hash_str));
     json_object_object_add(a_jobj_out, "address", json_object_new_string(a_rec->addr));
     json_object_object_add(a_jobj_out, "created_at", json_object_new_string(l_ts));
+    if (a_rec->ts_expire) {
+        dap_time_to_str_rfc822(l_ts, sizeof(l_ts), a_rec->ts_expire);
+        json_object_object_add(a_jobj_out, "expires_at", json_object_new_string(l_ts));
+    }
 }
 
 json_object *dap_http_ban_list_client_dump(const char *a_addr) {
@@ -70,20 +325,32 @@ json_object *dap_http_ban_list_client_dump(const char *a_addr) {
     json_object *l_jobj_out = json_object_new_object();
     json_object *l_jobj_array = NULL;
     if (!l_jobj_out) return dap_json_rpc_allocation_put(l_jobj_out);
+    dap_time_t l_now = dap_time_now();
     pthread_rwlock_rdlock(&s_ban_list_lock);
     if (a_addr) {
-        HASH_FIND_STR(s_ban_list, a_addr, l_rec);
-        if (l_rec)
+        char l_addr_key[INET6_ADDRSTRLEN + 4];
+        const char *l_key = s_key_make(a_addr, l_addr_key);
+        if (l_key)
+            HASH_FIND_STR(s_ban_list, l_key, l_rec);
+        if (l_rec && !s_is_expired(l_rec, l_now))
             s_dap_http_ban_list_client_dump_single(l_rec, l_jobj_out);
         else
             json_object_object_add(l_jobj_out, a_addr, json_object_new_string("Address is not banlisted"));
     } else {
         l_jobj_array = json_object_new_array();
-        if (!l_jobj_array) return dap_json_rpc_allocation_put(l_jobj_out);
+        if (!l_jobj_array) {
+            pthread_rwlock_unlock(&s_ban_list_lock);
+            return dap_json_rpc_allocation_put(l_jobj_out);
+        }
         json_object_object_add(l_jobj_out, "banlist", l_jobj_array);
         HASH_ITER(hh, s_ban_list, l_rec, l_tmp) {
+            if (s_is_expired(l_rec, l_now))
+                continue;
             json_object *l_jobj_addr = json_object_new_object();
-            if (!l_jobj_addr) return dap_json_rpc_allocation_put(l_jobj_out);
+            if (!l_jobj_addr) {
+                pthread_rwlock_unlock(&s_ban_list_lock);
+                return dap_json_rpc_allocation_put(l_jobj_out);
+            }
             json_object_object_add(l_jobj_addr, "num", json_object_new_int(num++));
             s_dap_http_ban_list_client_dump_single(l_rec, l_jobj_addr);
             json_object_array_add(l_jobj_array, l_jobj_addr);
@@ -100,10 +367,8 @@ int dap_http_ban_list_client_init() {
 void dap_http_ban_list_client_deinit() {
     ban_record_t *l_rec = NULL, *l_tmp = NULL;
     pthread_rwlock_wrlock(&s_ban_list_lock);
-    HASH_ITER(hh, s_ban_list, l_rec, l_tmp) {
-        HASH_DEL(s_ban_list, l_rec);
-        DAP_DELETE(l_rec);
-    }
+    HASH_ITER(hh, s_ban_list, l_rec, l_tmp)
+        s_record_delete(l_rec);
     pthread_rwlock_unlock(&s_ban_list_lock);
     pthread_rwlock_destroy(&s_ban_list_lock);
 }
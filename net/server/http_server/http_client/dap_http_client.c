@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 
 #ifndef _WIN32
 #include <libgen.h>
@@ -38,6 +39,9 @@
 #include "dap_common.h"
 #include "dap_config.h"
 #include "dap_events_socket.h"
+#include "dap_context.h"
+#include "dap_worker.h"
+#include "dap_timerfd.h"
 
 #include "dap_time.h"
 #include "dap_http_server.h"
@@ -58,14 +62,37 @@ int s_debug_http = 1;                                                       /* N
 #define HTTP$SZ_MINSTARTLINE 8
 #define HTTP$SZ_HTLINE 4096
 
+#define DAP_HTTP_KEEP_ALIVE_TIMEOUT         15                              /* Seconds */
+#define DAP_HTTP_KEEP_ALIVE_REQUESTS_MAX    1000
+#define DAP_HTTP_HEADERS_BUF_SIZE           4096                            /* Headers are rendered there before output */
+
+static time_t s_keep_alive_timeout = DAP_HTTP_KEEP_ALIVE_TIMEOUT;
+static uint32_t s_keep_alive_requests_max = DAP_HTTP_KEEP_ALIVE_REQUESTS_MAX;
+static char s_keep_alive_header[128];                                       /* Connection and Keep-Alive headers without "max" value */
+static size_t s_keep_alive_header_size;
+
+static void s_request_clear(dap_http_client_t *a_http_client);
+static void s_keep_alive_timer_stop(dap_http_client_t *a_http_client);
+
 /**
  * @brief dap_http_client_init Init HTTP client module
  * @return  Zero if ok others if not
  */
+static void s_keep_alive_header_render()
+{
+    s_keep_alive_header_size = snprintf(s_keep_alive_header, sizeof(s_keep_alive_header),
+                                        "Connection: Keep-Alive" CRLF "Keep-Alive: timeout=%"DAP_UINT64_FORMAT_U", max=",
+                                        (uint64_t)s_keep_alive_timeout);
+}
+
 int dap_http_client_init( )
 {
     log_it(L_NOTICE,"Initialized HTTP client module");
     s_debug_http = dap_config_get_item_bool_default(g_config,"general","debug_http",false);
+    s_keep_alive_timeout = dap_config_get_item_uint32_default(g_config, "http", "keep_alive_timeout", DAP_HTTP_KEEP_ALIVE_TIMEOUT);
+    s_keep_alive_requests_max = dap_config_get_item_uint32_default(g_config, "http", "keep_alive_requests_max",
+                                                                   DAP_HTTP_KEEP_ALIVE_REQUESTS_MAX);
+    s_keep_alive_header_render();
     return 0;
 }
 
@@ -112,66 +139,154 @@ void dap_http_client_delete( dap_events_socket_t * a_esocket, void *a_arg )
     if ( !(l_http_client = DAP_HTTP_CLIENT( a_esocket )) )
         return;                                                             /* Client is in proc callback in another thread so we don't delete it */
 
-    while( l_http_client->in_headers )
-        dap_http_header_remove( &l_http_client->in_headers, l_http_client->in_headers );
+    s_keep_alive_timer_stop(l_http_client);
+    s_request_clear(l_http_client);
+}
+
+/**
+ * @brief s_request_clear Free all the per-request data of HTTP client
+ * @param a_http_client HTTP client instance
+ */
+static void s_request_clear(dap_http_client_t *a_http_client)
+{
+    while( a_http_client->in_headers )
+        dap_http_header_remove( &a_http_client->in_headers, a_http_client->in_headers );
 
-    while( l_http_client->out_headers )
-        dap_http_header_remove( &l_http_client->out_headers, l_http_client->out_headers );
+    while( a_http_client->out_headers )
+        dap_http_header_remove( &a_http_client->out_headers, a_http_client->out_headers );
 
-    if( l_http_client->proc ) {
-        if( l_http_client->proc->delete_callback ) {
-          l_http_client->proc->delete_callback( l_http_client, NULL );
+    dap_http_cache_release(a_http_client->out_cache);
+    a_http_client->out_cache = NULL;
+    if( a_http_client->proc ) {
+        if( a_http_client->proc->delete_callback ) {
+          a_http_client->proc->delete_callback( a_http_client, NULL );
         }
     }
-    DAP_DEL_Z(l_http_client->_inheritor);
+    DAP_DEL_Z(a_http_client->_inheritor);
 }
 
-
-static char  *z_basename( char *path, uint32_t len )
+/**
+ * @brief s_request_reset Prepare HTTP client for the next request over the same connection
+ * @param a_http_client HTTP client instance
+ */
+static void s_request_reset(dap_http_client_t *a_http_client)
 {
-  if ( !len )
-    len = strlen( path );
+    s_request_clear(a_http_client);
+    a_http_client->action[0] = a_http_client->url_path[0] = a_http_client->in_query_string[0] = '\0';
+    a_http_client->action_len = a_http_client->url_path_len = a_http_client->in_query_string_len = 0;
+    a_http_client->keep_alive = 0;
+    a_http_client->in_content_type[0] = a_http_client->in_cookie[0] = '\0';
+    a_http_client->in_content_length = a_http_client->in_content_received = a_http_client->in_cookie_len = 0;
+    a_http_client->in_chunked = false;
+    a_http_client->in_chunk_state = DAP_HTTP_CHUNK_SIZE;
+    a_http_client->in_chunk_left = 0;
+
+    a_http_client->out_headers_tpl = NULL;
+    a_http_client->out_headers_default = false;
+    a_http_client->out_content_ready = 0;
+    a_http_client->out_content_type[0] = '\0';
+    a_http_client->out_content_length = 0;
+    a_http_client->out_last_modified = 0;
+    a_http_client->out_connection_close = a_http_client->out_keep_alive = 0;
+    a_http_client->out_chunked = a_http_client->out_vary_encoding = false;
+    a_http_client->out_encoding = DAP_HTTP_ENCODING_IDENTITY;
+    a_http_client->out_cache_position = 0;
+
+    a_http_client->route_params_count = 0;
+    a_http_client->route_values[0] = '\0';
+
+    a_http_client->proc = NULL;
+    a_http_client->reply_status_code = 0;
+    a_http_client->reply_reason_phrase[0] = '\0';
+    a_http_client->reply_reason_phrase_len = 0;
+    a_http_client->esocket->callbacks.arg = NULL;
+    a_http_client->state_read = DAP_HTTP_CLIENT_STATE_START;
+}
 
-  if ( len < 2 )
-    return path;
+/**
+ * @brief s_keep_alive_timer_callback Close keep-alive connection which is idle for too long
+ * @param a_arg Esocket UUID
+ * @return false, timer is one-shot
+ */
+static bool s_keep_alive_timer_callback(void *a_arg)
+{
+    dap_events_socket_uuid_t *l_es_uuid = (dap_events_socket_uuid_t *)a_arg;
+    dap_worker_t *l_worker = dap_worker_get_current();
+    dap_events_socket_t *l_es = l_worker ? dap_context_find(l_worker->context, *l_es_uuid) : NULL;
+    dap_http_client_t *l_http_client = l_es ? DAP_HTTP_CLIENT(l_es) : NULL;
+    DAP_DELETE(l_es_uuid);
+    if (!l_http_client)
+        return false;
+    l_http_client->keep_alive_timer = NULL;
+    debug_if(s_debug_http, L_DEBUG, "Keep-alive connection %"DAP_FORMAT_SOCKET" is idle for %"DAP_UINT64_FORMAT_U" seconds, close it",
+             l_es->socket, (uint64_t)(time(NULL) - l_http_client->ts_idle));
+    dap_events_socket_remove_and_delete_unsafe(l_es, false);
+    return false;
+}
 
-  char *ptr = path + len - 1;
+static void s_keep_alive_timer_stop(dap_http_client_t *a_http_client)
+{
+    if (!a_http_client->keep_alive_timer)
+        return;
+    DAP_DEL_Z(a_http_client->keep_alive_timer->callback_arg);
+    dap_timerfd_delete_unsafe(a_http_client->keep_alive_timer);
+    a_http_client->keep_alive_timer = NULL;
+}
 
-  while( ptr > path ) {
-    if ( *ptr == '/' ) {
-      ++ptr;
-      break;
+/**
+ * @brief s_keep_alive_allowed Check if the connection could be kept after the current reply
+ * @param a_http_client HTTP client instance
+ * @return true if reply will be sent with Connection: Keep-Alive
+ */
+static bool s_keep_alive_allowed(dap_http_client_t *a_http_client)
+{
+    switch (a_http_client->reply_status_code) {
+    case Http_Status_OK:
+    case Http_Status_PartialContent:
+    case Http_Status_NotModified:
+        break;
+    default:
+        return false;                                                       /* Error replies are sent without length */
     }
-    --ptr;
-  }
-
-  return ptr;
+    return a_http_client->keep_alive && !a_http_client->out_connection_close && s_keep_alive_timeout
+            && a_http_client->requests_count < s_keep_alive_requests_max
+            && a_http_client->state_read != DAP_HTTP_CLIENT_STATE_NONE;
 }
 
-static int32_t  z_dirname( char *path, uint32_t len )
+/**
+ * @brief dap_http_client_request_done Called by URL processors when the whole reply is written out.
+ * @details Keep-alive connection is reset to read the next request, which may be already in the input buffer
+ *          if client pipelines them. Other connections are closed
+ * @param a_http_client HTTP client instance
+ */
+void dap_http_client_request_done(dap_http_client_t *a_http_client)
 {
-  if ( !len )
-    len = strlen( path );
-
-  if ( len < 2 )
-    return 0;
-
-  char *ptr = path + len - 1;
-
-  while( ptr > path ) {
-    if ( *ptr == '/' ) {
-      break;
+    dap_events_socket_t *l_es = a_http_client->esocket;
+    if (!a_http_client->out_keep_alive) {
+        l_es->flags |= DAP_SOCK_SIGNAL_CLOSE;
+        return;
     }
-    --ptr;
-  }
-
-  len = (uint32_t)(ptr - path);
-  if ( len  )
-    path[ len ] = 0;
-
-  return len;
+    s_request_reset(a_http_client);
+    a_http_client->ts_idle = time(NULL);
+    dap_events_socket_set_readable_unsafe(l_es, true);
+    if (l_es->buf_in_size) {                                                /* Pipelined request */
+        dap_http_client_read(l_es, NULL);
+        if (a_http_client->state_read != DAP_HTTP_CLIENT_STATE_START || (l_es->flags & DAP_SOCK_SIGNAL_CLOSE))
+            return;
+    }
+    dap_events_socket_uuid_t *l_es_uuid = DAP_NEW_Z(dap_events_socket_uuid_t);
+    if (!l_es_uuid) {
+        log_it(L_CRITICAL, "%s", c_error_memory_alloc);
+        return;
+    }
+    *l_es_uuid = l_es->uuid;
+    a_http_client->keep_alive_timer = dap_timerfd_start_on_worker(l_es->worker, s_keep_alive_timeout * 1000,
+                                                                  s_keep_alive_timer_callback, l_es_uuid);
+    if (!a_http_client->keep_alive_timer)
+        DAP_DELETE(l_es_uuid);
 }
 
+
 static int32_t  z_rootdirname( char *path, uint32_t len )
 {
   if ( !len )
@@ -301,6 +416,98 @@ static inline void s_report_error_and_restart( dap_events_socket_t *a_esocket, d
     dap_http_client_write(a_http_client);
 }
 
+// Copies path parameters of the route to the client since url_path is rewritten for the processor
+static int s_route_params_copy(dap_http_client_t *a_http_client, dap_http_route_match_t *a_route)
+{
+    size_t l_offset = 0;
+    for (uint8_t i = 0; i < a_route->params_count; i++) {
+        if (l_offset + a_route->params[i].value_len >= sizeof(a_http_client->route_values))
+            return log_it(L_WARNING, "Path parameters of %s are too long", a_http_client->url_path), -1;
+        char *l_value = a_http_client->route_values + l_offset;
+        memcpy(l_value, a_route->params[i].value, a_route->params[i].value_len);
+        l_value[a_route->params[i].value_len] = '\0';
+        l_offset += a_route->params[i].value_len + 1;
+        a_http_client->route_params[i] = (dap_http_route_param_t) {
+            .name = a_route->params[i].name, .value = l_value, .value_len = a_route->params[i].value_len };
+    }
+    a_http_client->route_params_count = a_route->params_count;
+    return 0;
+}
+
+/**
+ * @brief dap_http_client_route_param Path parameter of the route, e.g. "id" for "/users/:id"
+ * @param a_http_client HTTP client instance
+ * @param a_name Parameter name
+ * @return Parameter value or NULL if there is no such parameter
+ */
+const char *dap_http_client_route_param(dap_http_client_t *a_http_client, const char *a_name)
+{
+    dap_return_val_if_fail(a_http_client && a_name, NULL);
+    for (uint8_t i = 0; i < a_http_client->route_params_count; i++)
+        if (!strcmp(a_http_client->route_params[i].name, a_name))
+            return a_http_client->route_params[i].value;
+    return NULL;
+}
+
+/**
+ * @brief dap_http_client_reply_error Stop reading the request and reply with error, connection is closed after that.
+ *        URL processors may call it from their read callbacks, e.g. to reject too big request body
+ * @param a_http_client HTTP client instance
+ * @param a_code HTTP status code
+ */
+void dap_http_client_reply_error(dap_http_client_t *a_http_client, uint16_t a_code)
+{
+    s_report_error_and_restart(a_http_client->esocket, a_http_client, a_code);
+}
+
+/**
+ * @brief s_chunk_frame_parse Parse a line of chunked body framing: chunk size, CRLF after chunk data or trailer field
+ * @param a_http_client HTTP client instance
+ * @param a_buf Input data
+ * @param a_size Input data size
+ * @param a_len Length of parsed line, zero if the line is incomplete yet
+ * @return Zero if ok, negative if framing is broken
+ */
+static int s_chunk_frame_parse(dap_http_client_t *a_http_client, const byte_t *a_buf, size_t a_size, size_t *a_len)
+{
+    *a_len = 0;
+    const byte_t *l_peol = memchr(a_buf, LF, a_size);
+    if ( !l_peol )
+        return a_size < HTTP$SZ_HTLINE ? 0 : -1;
+    if ( l_peol == a_buf || *(l_peol - 1) != CR )
+        return -1;
+    size_t l_len = l_peol + 1 - a_buf;
+
+    switch ( a_http_client->in_chunk_state ) {
+    case DAP_HTTP_CHUNK_SIZE: {                                             /* chunk-size [ chunk-ext ] CRLF */
+        if ( !isxdigit(*a_buf) )
+            return -1;
+        char *l_end;
+        errno = 0;
+        unsigned long long l_chunk_size = strtoull((const char *)a_buf, &l_end, 16);
+        if ( errno || (*l_end != ';' && *l_end != CR && *l_end != ' ' && *l_end != '\t') )
+            return -1;
+        a_http_client->in_chunk_left = l_chunk_size;
+        a_http_client->in_chunk_state = l_chunk_size ? DAP_HTTP_CHUNK_DATA : DAP_HTTP_CHUNK_TRAILER;
+    } break;
+    case DAP_HTTP_CHUNK_DATA_END:
+        if ( l_len != 2 )
+            return -1;
+        a_http_client->in_chunk_state = DAP_HTTP_CHUNK_SIZE;
+        break;
+    case DAP_HTTP_CHUNK_TRAILER:                                            /* Trailer fields are ignored */
+        if ( l_len == 2 ) {
+            a_http_client->in_chunk_state = DAP_HTTP_CHUNK_DONE;
+            a_http_client->in_content_length = a_http_client->in_content_received;
+        }
+        break;
+    default:
+        return -1;
+    }
+    *a_len = l_len;
+    return 0;
+}
+
 /**
  * @brief dap_http_client_read
  * @param cl HTTP Client instance
@@ -312,13 +519,13 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
     UNUSED(a_arg);
 
     byte_t *l_peol;
-    char *l_cp;
     int l_ret;
     size_t l_len = 0;
 
     dap_http_client_t *l_http_client = DAP_HTTP_CLIENT( a_esocket );
-    dap_http_url_proc_t *url_proc = NULL;
-    dap_http_cache_t * l_http_cache;
+    dap_http_route_match_t l_route;
+    if ( !l_http_client )
+        return;                                                             /* Request is processed in another thread */
 
     /*
     HTTP-message   = start-line CRLF
@@ -338,24 +545,21 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
             case DAP_HTTP_CLIENT_STATE_START: { // Beginning of the session. We try to detect URL with CRLF pair at end
                 if (l_http_client->esocket->type == DESCRIPTOR_TYPE_SOCKET_CLIENT 
                     || l_http_client->esocket->type == DESCRIPTOR_TYPE_SOCKET_UDP) {
-                    if ( dap_http_ban_list_client_check(l_http_client->esocket->remote_addr_str, NULL, NULL) ) {
+                    // Connection may be accepted before the ban, so each request is checked too
+                    if ( dap_http_ban_list_client_check_sockaddr(&l_http_client->esocket->addr_storage, NULL, NULL) ) {
                         log_it(L_ERROR, "Client %s is banned", l_http_client->esocket->remote_addr_str);
                         s_report_error_and_restart( a_esocket, l_http_client, Http_Status_Forbidden);
                         break;
                     }
                 }
 
-                if ( a_esocket->buf_in_size < HTTP$SZ_MINSTARTLINE )         /* Is the length of the start-line looks to be enough ? */
-                {
-                    log_it( L_ERROR, "Start-line '%.*s' is too short (%d < %d)",
-                            (int ) a_esocket->buf_in_size, a_esocket->buf_in, (int) a_esocket->buf_in_size , HTTP$SZ_MINSTARTLINE );
-                    s_report_error_and_restart( a_esocket, l_http_client,  Http_Status_BadRequest);
-                    break;
-                }
-
-                if ( (l_peol = memchr(a_esocket->buf_in, LF, a_esocket->buf_in_size)) ) /* Found LF ? */
-                    if ( *(l_peol - 1) != CR )                              /* Check CR at previous position */
-                        l_peol = NULL;
+                if ( !(l_peol = memchr(a_esocket->buf_in, LF, a_esocket->buf_in_size)) ) { /* Found LF ? */
+                    if (HTTP$SZ_HTLINE > a_esocket->buf_in_size) {
+                        debug_if(s_debug_http, L_DEBUG, "May be incomplete start-line in buffer, wait another part");
+                        return;
+                    }
+                } else if ( l_peol == a_esocket->buf_in || *(l_peol - 1) != CR )   /* Check CR at previous position */
+                    l_peol = NULL;
 
                 if ( !l_peol ) {
                     log_it( L_ERROR, "Start-line with size %zu is not terminated by CRLF pair", a_esocket->buf_in_size);
@@ -366,6 +570,19 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
                 l_peol++;                                                   /* Count terminal  <LF> */
                 l_len = l_peol - a_esocket->buf_in;                         /* <l_len> - actual data length of the HTTP's start-line  */
 
+                if ( l_len == 2 ) {                                         /* Empty line before the request, e.g. after pipelined body */
+                    dap_events_socket_shrink_buf_in( a_esocket, l_len );
+                    break;
+                }
+
+                if ( l_len < HTTP$SZ_MINSTARTLINE )                         /* Is the length of the start-line looks to be enough ? */
+                {
+                    log_it( L_ERROR, "Start-line '%.*s' is too short (%d < %d)",
+                            (int) l_len, a_esocket->buf_in, (int) l_len, HTTP$SZ_MINSTARTLINE );
+                    s_report_error_and_restart( a_esocket, l_http_client,  Http_Status_BadRequest);
+                    break;
+                }
+
                                                                             /* Parse HTTP's start-line */
                 if ( 0 > s_http_start_line_parse(l_http_client, (char *) a_esocket->buf_in, l_len) ) {
                     log_it( L_WARNING, "Error parsing request line '%.*s'", (int)l_len, a_esocket->buf_in );
@@ -374,6 +591,14 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
                 }
 
                 dap_events_socket_shrink_buf_in( a_esocket, l_len);         /* Shrink input buffer over start-line */
+                s_keep_alive_timer_stop(l_http_client);                     /* Connection is not idle anymore */
+                l_http_client->requests_count++;
+                if ( !dap_server_request_allow(l_http_client->http->server, &a_esocket->addr_storage) ) {
+                    log_it(L_WARNING, "Client %s exceeds request rate limit", a_esocket->remote_addr_str);
+                    dap_http_header_add(&l_http_client->out_headers, "Retry-After", "1");
+                    s_report_error_and_restart( a_esocket, l_http_client, Http_Status_TooManyRequests );
+                    break;
+                }
 
                 log_it( L_INFO, "Input: '%.*s' request for '%.*s' document (query string '%.*s')",
                         (int) l_http_client->action_len, l_http_client->action,
@@ -383,67 +608,49 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
                 /*
                  * Find URL processor
                 */
-                                                                            /* url_path = '/p1/p2/p3/target' */
-                l_ret = z_dirname( l_http_client->url_path, l_http_client->url_path_len );
-                                                                            /* url_path = '/p1/p2/p3/ */
-                HASH_FIND_STR( l_http_client->http->url_proc, l_http_client->url_path, url_proc );
-                l_http_client->proc = url_proc;
-
-                if ( l_ret )
-                    l_http_client->url_path[ l_ret ] = '/';
-
-                                                                            /* url_path = '/p1/p2/p3/target' */
-                l_cp = z_basename( l_http_client->url_path, l_http_client->url_path_len );
-                memmove( l_http_client->url_path, l_cp, strlen(l_cp) + 1 );
-                                                                            /* url_path = 'target' */
-                if ( !url_proc )
-                {
+                switch ( dap_http_route_find(l_http_client->http, l_http_client->action, l_http_client->url_path,
+                                             l_http_client->url_path_len, &l_route) ) {
+                case DAP_HTTP_ROUTE_FOUND:
+                    break;
+                case DAP_HTTP_ROUTE_METHOD_NOT_ALLOWED: {
+                    char l_allow[128];
+                    dap_http_route_methods_str(l_route.methods_allowed, l_allow, sizeof(l_allow));
+                    log_it( L_WARNING, "Input: method %s is not allowed for %s", l_http_client->action, l_http_client->url_path );
+                    dap_http_header_add( &l_http_client->out_headers, "Allow", l_allow );
+                    s_report_error_and_restart( a_esocket, l_http_client, Http_Status_MethodNotAllowed );
+                } break;
+                default:
                     log_it( L_WARNING, "Input: unprocessed URL request %s is rejected", l_http_client->url_path );
                     s_report_error_and_restart( a_esocket, l_http_client, Http_Status_NotFound );
                     break;
                 }
+                if ( !l_route.proc )
+                    break;
+                                                                            /* Parameters and url_path point to url_path */
+                if ( s_route_params_copy(l_http_client, &l_route) ) {
+                    s_report_error_and_restart( a_esocket, l_http_client, Http_Status_URITooLong );
+                    break;
+                }
+                l_http_client->proc = l_route.proc;
+                memmove( l_http_client->url_path, l_route.path, l_route.path_len );
+                l_http_client->url_path[ l_http_client->url_path_len = l_route.path_len ] = '\0';
 
                 l_http_client->state_read = DAP_HTTP_CLIENT_STATE_HEADERS;
 
                 // Check if present cache
-                pthread_rwlock_rdlock(&l_http_client->proc->cache_rwlock);
-                if ( (l_http_cache = l_http_client->proc->cache) ) {
-                    if ( ! l_http_cache->ts_expire || l_http_cache->ts_expire >= time(NULL) ){
-                        l_http_client->out_headers = dap_http_headers_dup(l_http_cache->headers);
-                        l_http_client->out_content_length = l_http_cache->body_size;
-                        l_http_client->reply_status_code = l_http_cache->response_code;
-                        if(l_http_cache->response_phrase)
-                            strncpy(l_http_client->reply_reason_phrase,l_http_cache->response_phrase,sizeof (l_http_client->reply_reason_phrase)-1);
-
-                    debug_if (s_debug_http, L_DEBUG,"%"DAP_FORMAT_SOCKET" Out: prepare cached headers", l_http_client->esocket->socket);
-
-                    } else {
-                        pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-                        pthread_rwlock_wrlock(&l_http_client->proc->cache_rwlock);
-                        dap_http_cache_delete(l_http_cache);
-                        l_http_client->proc->cache = NULL;
-                        l_http_cache = NULL;
-                    }
-                    pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-                } else { /* No cache */
-                    pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-                    if (l_http_client->proc->new_callback) /* Call client constructor */
-                        l_http_client->proc->new_callback(l_http_client, NULL);
-                }
+                dap_http_cache_release(l_http_client->out_cache);
+                l_http_client->out_cache_position = 0;
+                if ( (l_http_client->out_cache = dap_http_cache_find(l_http_client)) )
+                    debug_if(s_debug_http, L_DEBUG, "%"DAP_FORMAT_SOCKET" Out: reply from cache", l_http_client->esocket->socket);
+                else if (l_http_client->proc->new_callback) /* No cache, call client constructor */
+                    l_http_client->proc->new_callback(l_http_client, NULL);
             } /* case DAP_HTTP_CLIENT_STATE_START: */
 
             /* no break here just step to next phase */
 
             case DAP_HTTP_CLIENT_STATE_HEADERS: { // Parse input headers
-                if ( a_esocket->buf_in_size < 2 )                          /* 2 = CRLF pair */
-                    {
-                        log_it( L_ERROR, "HTTP Header field is too short (%d octets) to be useful", (int) a_esocket->buf_in_size);
-                        s_report_error_and_restart( a_esocket, l_http_client, Http_Status_BadRequest );
-                        break;
-                    }
-
                 if ( (l_peol = memchr(a_esocket->buf_in, LF, a_esocket->buf_in_size)) ) /* Found LF ? */
-                    if ( *(l_peol - 1) != CR )                              /* Check CR at previous position */
+                    if ( l_peol == a_esocket->buf_in || *(l_peol - 1) != CR ) /* Check CR at previous position */
                         l_peol = NULL;
 
                 if ( !l_peol ) {
@@ -459,7 +666,11 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
                 l_peol++;                                                   /* Count terminal  <LF> */
                 l_len = l_peol - a_esocket->buf_in;
 
-                if ( 0 > (l_ret = dap_http_header_parse( l_http_client, (char *) a_esocket->buf_in, l_len )) ) {
+                if ( (l_ret = dap_http_header_parse( l_http_client, (char *) a_esocket->buf_in, l_len )) == -EBADMSG ) {
+                    // Body can't be read with unknown length, connection is closed after the reply
+                    s_report_error_and_restart( a_esocket, l_http_client, Http_Status_BadRequest );
+                    break;
+                } else if ( 0 > l_ret ) {
                     log_it( L_WARNING, "Input: not a valid header '%.*s'", (int)l_len, a_esocket->buf_in );
                 }else if ( l_ret == 1 ) {
                     log_it( L_INFO, "Input: HTTP headers are over" );
@@ -472,30 +683,31 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
                         {
                             log_it( L_NOTICE, "Access restricted" );
                             s_report_error_and_restart( a_esocket, l_http_client, Http_Status_Unauthorized );
+                            break;
                         }
                     }
 
-                    pthread_rwlock_rdlock(&l_http_client->proc->cache_rwlock);
-
-                    if ( l_http_client->proc->cache == NULL &&  l_http_client->proc->headers_read_callback )
-                    {
-                        pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
+                    if ( !l_http_client->out_cache && l_http_client->proc->headers_read_callback )
                         l_http_client->proc->headers_read_callback( l_http_client, NULL );
-                    }else {
-                        pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
+                    else
                         debug_if (s_debug_http, L_DEBUG, "Cache is present, don't call underlying callbacks");
-                    }
 
-                    // If no headers callback we go to the DATA processing
-                    if( l_http_client->in_content_length ) {
+                    // Unless proc took the connection over or rejected the request
+                    if ( l_http_client->state_read != DAP_HTTP_CLIENT_STATE_HEADERS )
+                        ;
+                    else if( l_http_client->in_content_length || l_http_client->in_chunked ) {
                         debug_if (s_debug_http, L_DEBUG, "headers -> DAP_HTTP_CLIENT_STATE_DATA" );
                         l_http_client->state_read = DAP_HTTP_CLIENT_STATE_DATA;
-                    } else if (l_http_client->proc->cache)
-                        // No data, its over
-                        dap_http_client_write(l_http_client);
-                    else {
-                        a_esocket->buf_in_size = 0;
-                        break;
+                        dap_http_header_t *l_expect = dap_http_header_find(l_http_client->in_headers, "Expect");
+                        if ( l_expect && !strcasecmp(l_expect->value, "100-continue") )
+                            dap_events_socket_write_f_unsafe(a_esocket, "HTTP/1.1 %d %s" CRLF CRLF, Http_Status_Continue,
+                                                             http_status_reason_phrase(Http_Status_Continue));
+                    } else {
+                        if (l_http_client->out_cache)
+                            // No data, its over
+                            dap_http_client_write(l_http_client);
+                        // The rest of input is the next pipelined request
+                        l_http_client->state_read = DAP_HTTP_CLIENT_STATE_REPLY;
                     }
                 }
                 dap_events_socket_shrink_buf_in(a_esocket, l_len);         /* Shrink input buffer over whole HTTP header */
@@ -504,17 +716,52 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
             case DAP_HTTP_CLIENT_STATE_DATA:{
                 debug_if (s_debug_http, L_DEBUG, "dap_http_client_read: DAP_HTTP_CLIENT_STATE_DATA");
 
-                pthread_rwlock_rdlock(&l_http_client->proc->cache_rwlock);
-                if ( l_http_client->proc->cache == NULL && l_http_client->proc->data_read_callback ) {
-                    pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-                    l_http_client->proc->data_read_callback( l_http_client, &l_len );
+                bool l_chunked = l_http_client->in_chunked;
+                if ( l_chunked && l_http_client->in_chunk_state != DAP_HTTP_CHUNK_DATA ) {
+                    if ( s_chunk_frame_parse(l_http_client, a_esocket->buf_in, a_esocket->buf_in_size, &l_len) ) {
+                        log_it( L_WARNING, "Input: broken chunked body framing" );
+                        s_report_error_and_restart( a_esocket, l_http_client, Http_Status_BadRequest );
+                        break;
+                    }
+                    if ( !l_len )
+                        return;                                             /* Wait for the rest of line */
                     dap_events_socket_shrink_buf_in( a_esocket, l_len );
-                } else {
-                    pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-                    a_esocket->buf_in_size = 0;
-                    dap_http_client_write(l_http_client);
+                    if ( l_http_client->in_chunk_state != DAP_HTTP_CHUNK_DONE )
+                        break;
+                    // The last chunk, URL processor gets no data but in_content_length to know the body is over
+                }
+                size_t l_buf_in_size = a_esocket->buf_in_size,
+                       l_body_left = l_chunked ? l_http_client->in_chunk_left
+                                               : l_http_client->in_content_length - l_http_client->in_content_received;
+                bool l_body_limited = (l_chunked || l_http_client->in_content_length) && l_buf_in_size > l_body_left;
+                if ( l_body_limited )                                       /* Don't pass pipelined request or framing as the body */
+                    a_esocket->buf_in_size = l_body_left;
+                l_len = 0;
+                if ( !l_http_client->out_cache && l_http_client->proc->data_read_callback )
+                    l_http_client->proc->data_read_callback( l_http_client, &l_len );
+                else
+                    l_len = a_esocket->buf_in_size;                         /* Body is not needed for cached reply */
+                if ( l_http_client->state_read != DAP_HTTP_CLIENT_STATE_DATA )
+                    break;                                                  /* Request is rejected */
+                if ( l_body_limited )
+                    a_esocket->buf_in_size = l_buf_in_size;
+                dap_events_socket_shrink_buf_in( a_esocket, l_len );
+
+                l_http_client->in_content_received += l_len;
+                if ( l_chunked && l_http_client->in_chunk_state == DAP_HTTP_CHUNK_DATA
+                        && !(l_http_client->in_chunk_left -= l_len) )
+                    l_http_client->in_chunk_state = DAP_HTTP_CHUNK_DATA_END;
+                if ( l_chunked ? l_http_client->in_chunk_state == DAP_HTTP_CHUNK_DONE
+                               : l_http_client->in_content_length && l_http_client->in_content_received >= l_http_client->in_content_length ) {
+                    if ( l_http_client->out_cache )
+                        dap_http_client_write(l_http_client);
+                    l_http_client->state_read = DAP_HTTP_CLIENT_STATE_REPLY;
                 }
             } break;
+            case DAP_HTTP_CLIENT_STATE_REPLY: {
+                // Next request is read after the reply is done, see dap_http_client_request_done()
+                dap_events_socket_set_readable_unsafe( a_esocket, false );
+            } return;
             case DAP_HTTP_CLIENT_STATE_NONE: {
                 a_esocket->buf_in_size = 0;
             } break;
@@ -524,6 +771,8 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
             s_report_error_and_restart( a_esocket, l_http_client, Http_Status_LoopDetected );
             break;
         }
+        if ( a_esocket->_inheritor != l_http_client )
+            return;                                                         /* Request is passed to another thread */
     } while (a_esocket->buf_in_size && l_len);
 }
 
@@ -532,38 +781,149 @@ void dap_http_client_read( dap_events_socket_t *a_esocket, void *a_arg )
  * @param a_esocket HTTP Client instance's esocket
  * @param a_arg Additional argument (usualy not used)
  */
+typedef struct headers_buf {
+    dap_events_socket_t *esocket;
+    size_t size;
+    char data[DAP_HTTP_HEADERS_BUF_SIZE];
+} headers_buf_t;
+
+static void s_put(headers_buf_t *a_buf, const void *a_data, size_t a_size)
+{
+    if (a_buf->size + a_size > sizeof(a_buf->data)) {
+        dap_events_socket_write_unsafe(a_buf->esocket, a_buf->data, a_buf->size);
+        a_buf->size = 0;
+        if (a_size > sizeof(a_buf->data)) {
+            dap_events_socket_write_unsafe(a_buf->esocket, a_data, a_size);
+            return;
+        }
+    }
+    memcpy(a_buf->data + a_buf->size, a_data, a_size);
+    a_buf->size += a_size;
+}
+
+#define s_put_literal(a_buf, a_str) s_put(a_buf, a_str, sizeof(a_str) - 1)
+
+static inline void s_put_str(headers_buf_t *a_buf, const char *a_str)
+{
+    s_put(a_buf, a_str, strlen(a_str));
+}
+
+static void s_put_uint(headers_buf_t *a_buf, uint64_t a_value)
+{
+    char l_str[24], *l_cp = l_str + sizeof(l_str);
+    do
+        *--l_cp = '0' + a_value % 10;
+    while (a_value /= 10);
+    s_put(a_buf, l_cp, l_str + sizeof(l_str) - l_cp);
+}
+
+static void s_put_header(headers_buf_t *a_buf, const char *a_name, size_t a_name_len, const char *a_value, size_t a_value_len)
+{
+    s_put(a_buf, a_name, a_name_len);
+    s_put_literal(a_buf, ": ");
+    s_put(a_buf, a_value, a_value_len);
+    s_put_literal(a_buf, CRLF);
+}
+
+// Date header is the same during a second, so it's rendered once per second in each worker thread
+static void s_put_date(headers_buf_t *a_buf)
+{
+    static _Thread_local time_t s_date_ts;
+    static _Thread_local char s_date[DAP_TIME_STR_SIZE + 16];
+    static _Thread_local size_t s_date_size;
+    time_t l_now = time(NULL);
+    if (l_now != s_date_ts) {
+        char l_time[DAP_TIME_STR_SIZE];
+        dap_time_to_str_rfc822(l_time, sizeof(l_time), l_now);
+        s_date_size = snprintf(s_date, sizeof(s_date), "Date: %s" CRLF, l_time);
+        s_date_ts = l_now;
+    }
+    s_put(a_buf, s_date, s_date_size);
+}
+
+/**
+ * @brief s_headers_write Render status line and all headers of the reply into one buffer and put it to output
+ * @param a_http_client HTTP client instance
+ */
+static void s_headers_write(dap_http_client_t *a_http_client)
+{
+    headers_buf_t l_buf;
+    l_buf.esocket = a_http_client->esocket;
+    l_buf.size = 0;
+    const char *l_reason = a_http_client->reply_reason_phrase[0] ? a_http_client->reply_reason_phrase
+                                                                   : http_status_reason_phrase(a_http_client->reply_status_code);
+    s_put_literal(&l_buf, "HTTP/1.1 ");
+    s_put_uint(&l_buf, a_http_client->reply_status_code);
+    s_put_literal(&l_buf, " ");
+    s_put_str(&l_buf, l_reason);
+    s_put_literal(&l_buf, CRLF);
+
+    // Headers of URL processor go first
+    for ( dap_http_header_t *l_hdr = a_http_client->out_headers; l_hdr; l_hdr = a_http_client->out_headers ) {
+        s_put_header(&l_buf, l_hdr->name, l_hdr->namesz, l_hdr->value, l_hdr->valuesz);
+        dap_http_header_remove( &a_http_client->out_headers, l_hdr );
+    }
+    // Body representation, written with custom headers too
+    if ( a_http_client->out_encoding ) {
+        s_put_literal(&l_buf, "Content-Encoding: ");
+        s_put_str(&l_buf, dap_http_encoding_str(a_http_client->out_encoding));
+        s_put_literal(&l_buf, CRLF);
+    }
+    if ( a_http_client->out_vary_encoding )
+        s_put_literal(&l_buf, "Vary: Accept-Encoding" CRLF);
+    if ( a_http_client->out_headers_default ) {
+        if ( a_http_client->reply_status_code == Http_Status_OK || a_http_client->reply_status_code == Http_Status_PartialContent ) {
+            if ( a_http_client->out_last_modified ) {
+                char l_time[DAP_TIME_STR_SIZE];
+                dap_time_to_str_rfc822(l_time, sizeof(l_time), a_http_client->out_last_modified);
+                s_put_header(&l_buf, "Last-Modified", sizeof("Last-Modified") - 1, l_time, strlen(l_time));
+            }
+            if ( a_http_client->out_content_type[0] )
+                s_put_header(&l_buf, "Content-Type", sizeof("Content-Type") - 1,
+                             a_http_client->out_content_type, strlen(a_http_client->out_content_type));
+            if ( a_http_client->out_chunked )
+                s_put_literal(&l_buf, "Transfer-Encoding: chunked" CRLF);
+            else if ( a_http_client->out_content_length || a_http_client->out_keep_alive ) {
+                s_put_literal(&l_buf, "Content-Length: ");
+                s_put_uint(&l_buf, a_http_client->out_content_length);
+                s_put_literal(&l_buf, CRLF);
+            }
+        }
+        if ( a_http_client->out_keep_alive ) {
+            if ( !s_keep_alive_header_size )
+                s_keep_alive_header_render();
+            s_put(&l_buf, s_keep_alive_header, s_keep_alive_header_size);
+            s_put_uint(&l_buf, s_keep_alive_requests_max - a_http_client->requests_count);
+            s_put_literal(&l_buf, CRLF);
+        } else
+            s_put_literal(&l_buf, "Connection: Close" CRLF);
+        s_put(&l_buf, a_http_client->http->server_header, a_http_client->http->server_header_size);
+    }
+    if ( a_http_client->out_headers_tpl )
+        s_put(&l_buf, a_http_client->out_headers_tpl->data, a_http_client->out_headers_tpl->size);
+    s_put_date(&l_buf);
+    s_put_literal(&l_buf, CRLF);                                            /* Final CRLF - HTTP's End-Of-Header */
+    dap_events_socket_write_unsafe(a_http_client->esocket, l_buf.data, l_buf.size);
+}
+
 void dap_http_client_write(dap_http_client_t *a_http_client)
 {
-    if ( a_http_client->proc ) {
-        // We check out_headers because if they are - we send only cached headers and don't call headers_write_callback at all
+    if ( a_http_client->out_cache ) {
+        // Cached reply, proc callbacks are not called at all
+        dap_http_cache_reply_prepare(a_http_client);
+        dap_http_client_out_header_generate(a_http_client);
+    } else if ( a_http_client->proc ) {
+        // We check out_headers because if they are - we send only prepared headers and don't call headers_write_callback at all
         if (!a_http_client->out_headers) {
             bool l_generate_default_headers = a_http_client->proc->headers_write_callback && a_http_client->state_read != DAP_HTTP_CLIENT_STATE_NONE ?
                         !a_http_client->proc->headers_write_callback(a_http_client, a_http_client->esocket->callbacks.arg) : true;
             if (l_generate_default_headers)
                 dap_http_client_out_header_generate( a_http_client );
-        } else {
-            a_http_client->reply_status_code = Http_Status_OK; // Cached data are always OK... for now.
-            //TODO: make cached reply status code
-        }
+        } else
+            a_http_client->reply_status_code = Http_Status_OK;
     }
     log_it( L_INFO," HTTP response with %u status code", a_http_client->reply_status_code );
-    a_http_client->esocket->buf_out_size += snprintf((char *) a_http_client->esocket->buf_out + a_http_client->esocket->buf_out_size,
-                                                         a_http_client->esocket->buf_out_size_max - a_http_client->esocket->buf_out_size,
-                    "HTTP/1.1 %u %s" CRLF,
-                    a_http_client->reply_status_code, a_http_client->reply_reason_phrase[0] ?
-                    a_http_client->reply_reason_phrase : http_status_reason_phrase(a_http_client->reply_status_code) );
-    /* Write HTTP headres */
-    char l_buf[DAP_TIME_STR_SIZE];
-    dap_time_to_str_rfc822( l_buf, DAP_TIME_STR_SIZE, time( NULL ) );
-    dap_http_header_add( &a_http_client->out_headers, "Date", l_buf );
-
-    for ( dap_http_header_t *hdr = a_http_client->out_headers; hdr; hdr = a_http_client->out_headers ) {
-        a_http_client->esocket->buf_out_size += snprintf((char *) a_http_client->esocket->buf_out + a_http_client->esocket->buf_out_size,
-                                                            a_http_client->esocket->buf_out_size_max - a_http_client->esocket->buf_out_size,
-                                                            "%s: %s" CRLF, hdr->name, hdr->value);
-        dap_http_header_remove( &a_http_client->out_headers, hdr );
-    }
-    dap_events_socket_write_unsafe(a_http_client->esocket, CRLF, 2); /* Add final CRLF - HTTP's End-Of-Header */
+    s_headers_write(a_http_client);
 }
 
 bool dap_http_client_write_callback(dap_events_socket_t *a_esocket, void *a_arg)
@@ -572,7 +932,16 @@ bool dap_http_client_write_callback(dap_events_socket_t *a_esocket, void *a_arg)
     dap_http_client_t *l_http_client = DAP_HTTP_CLIENT(a_esocket);
     if (!l_http_client)
         return false;
-    if (l_http_client->reply_status_code != Http_Status_OK || l_http_client->state_read == DAP_HTTP_CLIENT_STATE_NONE) {
+    if ( !l_http_client->reply_status_code )
+        return false;                                                       /* Reply is not started yet, e.g. after 100 Continue */
+    uint32_t l_requests_count = l_http_client->requests_count;
+    if ( l_http_client->reply_status_code == Http_Status_NotModified && l_http_client->state_read != DAP_HTTP_CLIENT_STATE_NONE ) {
+        // Reply has no body
+        dap_http_client_request_done(l_http_client);
+        return l_http_client->requests_count != l_requests_count;
+    }
+    if ( (l_http_client->reply_status_code != Http_Status_OK && l_http_client->reply_status_code != Http_Status_PartialContent)
+            || l_http_client->state_read == DAP_HTTP_CLIENT_STATE_NONE ) {
         // No write data if error code set
         l_http_client->esocket->flags |= DAP_SOCK_SIGNAL_CLOSE;
         return false;
@@ -580,32 +949,29 @@ bool dap_http_client_write_callback(dap_events_socket_t *a_esocket, void *a_arg)
     bool l_ret = false;
     debug_if(s_debug_http, L_DEBUG, "Entering HTTP data write callback, a_esocket: %p, a_arg: %p", a_esocket, a_arg);
     /* Write HTTP data */
-    if (l_http_client->proc && l_http_client->proc->data_write_callback) {
-        pthread_rwlock_wrlock(&l_http_client->proc->cache_rwlock);
-        if (!l_http_client->proc->cache) {
-            debug_if(s_debug_http, L_DEBUG, "No cache so we call write callback");
-            pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-            l_ret = l_http_client->proc->data_write_callback(l_http_client, a_arg);
-        } else {
-            size_t l_sent = dap_events_socket_write_unsafe(l_http_client->esocket,
-                                           l_http_client->proc->cache->body + l_http_client->out_cache_position,
-                                           l_http_client->proc->cache->body_size-l_http_client->out_cache_position);
-            if (!l_sent || l_http_client->out_cache_position + l_sent >= l_http_client->proc->cache->body_size) { // All is sent
-                if (!l_sent)
-                    debug_if(s_debug_http, L_ERROR, "Can't send data to socket");
-                else
-                    debug_if(s_debug_http, L_DEBUG, "Out %"DAP_FORMAT_SOCKET" All cached data over, signal to close connection",
-                             l_http_client->esocket->socket);
-                l_http_client->esocket->flags |= DAP_SOCK_SIGNAL_CLOSE;
-            } else
-                l_http_client->out_cache_position += l_sent;
-            pthread_rwlock_unlock(&l_http_client->proc->cache_rwlock);
-        }
+    if (l_http_client->out_cache) {
+        // Cached body is immutable while referenced, no locks needed
+        dap_http_cache_t *l_cache = l_http_client->out_cache;
+        const byte_t *l_body = l_http_client->out_encoding ? l_cache->body_gzip : l_cache->body;
+        size_t l_body_size = l_http_client->out_encoding ? l_cache->body_gzip_size : l_cache->body_size;
+        if (l_body_size > l_http_client->out_cache_position)
+            l_http_client->out_cache_position += dap_events_socket_write_unsafe(l_http_client->esocket,
+                                                        l_body + l_http_client->out_cache_position,
+                                                        l_body_size - l_http_client->out_cache_position);
+        if (l_http_client->out_cache_position >= l_body_size) { // All is sent
+            debug_if(s_debug_http, L_DEBUG, "Out %"DAP_FORMAT_SOCKET" All cached data over", l_http_client->esocket->socket);
+            dap_http_client_request_done(l_http_client);
+        } else
+            l_ret = true;                                                   /* Output buffer is full, wait for it */
+    } else if (l_http_client->proc && l_http_client->proc->data_write_callback) {
+        debug_if(s_debug_http, L_DEBUG, "No cache so we call write callback");
+        l_ret = l_http_client->proc->data_write_callback(l_http_client, a_arg);
     } else {
         log_it(L_WARNING, "No http proc, nothing to write");
         l_http_client->esocket->flags |= DAP_SOCK_SIGNAL_CLOSE;
     }
-    return l_ret;
+    // Pipelined request started by dap_http_client_request_done() may have its reply to write
+    return l_ret || l_http_client->requests_count != l_requests_count;
 }
 
 /**
@@ -614,35 +980,11 @@ bool dap_http_client_write_callback(dap_events_socket_t *a_esocket, void *a_arg)
  */
 void dap_http_client_out_header_generate(dap_http_client_t *a_http_client)
 {
-    char buf[1024];
-
-    if ( a_http_client->reply_status_code == Http_Status_OK ) {
-        if (s_debug_http)
-            log_it(L_DEBUG, "Out headers generate for sock %"DAP_FORMAT_SOCKET, a_http_client->socket_num);
-        if ( a_http_client->out_last_modified ) {
-            dap_time_to_str_rfc822( buf, sizeof(buf), a_http_client->out_last_modified );
-            dap_http_header_add( &a_http_client->out_headers, "Last-Modified", buf );
-        }
-        if ( a_http_client->out_content_type[0] ) {
-            dap_http_header_add(&a_http_client->out_headers,"Content-Type",a_http_client->out_content_type);
-            log_it(L_DEBUG,"Output: Content-Type = '%s'",a_http_client->out_content_type);
-        }
-        if ( a_http_client->out_content_length ) {
-            snprintf(buf,sizeof(buf),"%zu",a_http_client->out_content_length);
-            dap_http_header_add(&a_http_client->out_headers,"Content-Length",buf);
-            log_it(L_DEBUG,"Output: Content-Length = %zu",a_http_client->out_content_length);
-        }
-    }else
-        if (s_debug_http)
-            log_it(L_WARNING, "Out headers: nothing generate for sock %"DAP_FORMAT_SOCKET", http code %d", a_http_client->socket_num,
-                   a_http_client->reply_status_code);
-
-    if ( a_http_client->out_connection_close || !a_http_client->keep_alive )
-        dap_http_header_add( &a_http_client->out_headers, "Connection","Close" );
-
-    dap_http_header_add( &a_http_client->out_headers, "Server", a_http_client->http->server_name );
-
-    log_it( L_DEBUG,"Output: Headers generated" );
+    // Headers are rendered straight into output buffer by dap_http_client_write()
+    a_http_client->out_keep_alive = s_keep_alive_allowed(a_http_client);
+    a_http_client->out_headers_default = true;
+    debug_if(s_debug_http, L_DEBUG, "Out headers generate for sock %"DAP_FORMAT_SOCKET", http code %d",
+             a_http_client->socket_num, a_http_client->reply_status_code);
 }
 
 /**
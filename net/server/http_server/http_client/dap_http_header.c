@@ -60,6 +60,7 @@ struct ht_field {
     {HTTP_FLD$K_CONTENT_TYPE,   $STRINI("Content-Type")},
     {HTTP_FLD$K_CONTENT_LEN,    $STRINI("Content-Length")},
     {HTTP_FLD$K_COOKIE,         $STRINI("Cookie")},
+    {HTTP_FLD$K_TRANSFER_ENC,   $STRINI("Transfer-Encoding")},
 
     {-1, {0}, 0},                                                           /* End-of-list marker, dont' touch!!! */
 };
@@ -86,11 +87,75 @@ void dap_http_header_deinit()
 }
 
 
+/**
+ * @brief s_content_length_parse Parse Content-Length value strictly: decimal digits only, no sign, list or junk
+ * @param a_value Field value
+ * @param a_length Output length
+ * @return Zero if value is valid, -1 otherwise
+ */
+static int s_content_length_parse(const char *a_value, size_t *a_length)
+{
+    size_t l_len = strlen(a_value);
+    for (; l_len && (a_value[l_len - 1] == ' ' || a_value[l_len - 1] == '\t'); l_len-- );
+    if ( !l_len || strspn(a_value, "0123456789") != l_len )
+        return -1;
+    errno = 0;
+    unsigned long long l_length = strtoull(a_value, NULL, 10);
+    if ( errno == ERANGE || l_length > SIZE_MAX )
+        return -1;
+    *a_length = (size_t)l_length;
+    return 0;
+}
+
+/**
+ * @brief s_body_framing_check Check how the request body is delimited, RFC 9112 section 6.3
+ * @param a_http_client HTTP client with all the request headers parsed
+ * @return Zero if body length is known, -EBADMSG otherwise
+ */
+static int s_body_framing_check(dap_http_client_t *a_http_client)
+{
+    dap_http_header_t *l_header, *l_transfer_encoding = NULL;
+    bool l_content_length = false;
+    DL_FOREACH(a_http_client->in_headers, l_header)
+        if ( !strcasecmp(l_header->name, "Transfer-Encoding") )
+            l_transfer_encoding = l_header;
+        else if ( !strcasecmp(l_header->name, "Content-Length") ) {
+            size_t l_length;
+            if ( s_content_length_parse(l_header->value, &l_length) )
+                return log_it(L_WARNING, "Invalid Content-Length '%s'", l_header->value), -EBADMSG;
+            /* Repeated field must have the same value, otherwise it's unknown which one a proxy in front of us took */
+            if ( l_content_length && l_length != a_http_client->in_content_length )
+                return log_it(L_WARNING, "Different Content-Length values %zu and %zu", a_http_client->in_content_length, l_length),
+                        -EBADMSG;
+            a_http_client->in_content_length = l_length;
+            l_content_length = true;
+        }
+    if ( !l_transfer_encoding )
+        return 0;
+
+    /* "chunked" must be the last coding of the last field, no length is known otherwise */
+    const char *l_coding = strrchr(l_transfer_encoding->value, ',');
+    l_coding = l_coding ? l_coding + 1 : l_transfer_encoding->value;
+    l_coding += strspn(l_coding, " \t");
+    size_t l_len = strlen(l_coding);
+    for (; l_len && (l_coding[l_len - 1] == ' ' || l_coding[l_len - 1] == '\t'); l_len-- );
+    if ( l_len != sizeof("chunked") - 1 || strncasecmp(l_coding, "chunked", l_len) )
+        return log_it(L_WARNING, "Unsupported transfer coding '%s'", l_transfer_encoding->value), -EBADMSG;
+
+    /* Both lengths could be read differently by a proxy in front of us, so it's a request smuggling attempt */
+    if ( l_content_length )
+        return log_it(L_WARNING, "Request has both Content-Length and Transfer-Encoding"), -EBADMSG;
+
+    a_http_client->in_chunked = true;
+    return 0;
+}
+
 /**
  * @brief dap_http_header_parse Parse string with HTTP header
  * @param top Top of list with HTTP header structures
  * @param str String to parse
- * @return Zero if parsed well -1 if it wasn't HTTP header 1 if its "\r\n" string
+ * @return Zero if parsed well -1 if it wasn't HTTP header 1 if its "\r\n" string,
+ *         -EBADMSG if headers are over but request body length can't be determined
  */
 #define	CRLF    "\r\n"
 #define	CR      '\r'
@@ -107,7 +172,7 @@ dap_http_header_t *l_new_header;
 
     /* Check for HTTP End-Of-Header sequence */
     if ( (ht_line_len == 2) && (*ht_line == CR) && ( *(ht_line + 1) == LF) )
-        return  1;
+        return  s_body_framing_check(cl_ht) ? -EBADMSG : 1;
 
 
     /*
@@ -130,7 +195,7 @@ dap_http_header_t *l_new_header;
     for ( l_ht = ht_fields; l_ht->namelen; l_ht++)
         {
             if ( l_namelen == l_ht->namelen )
-                if ( !memcmp(l_pname, l_ht->name, l_namelen) )
+                if ( !strncasecmp(l_pname, l_ht->name, l_namelen) )
                     break;
             }
 
@@ -151,7 +216,8 @@ dap_http_header_t *l_new_header;
     switch (l_ht->ht_field_code )
     {
         case    HTTP_FLD$K_CONNECTION:
-            cl_ht->keep_alive = !strncasecmp(l_pval, "Keep-Alive", l_valuelen);
+            for (l_len = l_valuelen; l_len && isspace(l_pval[l_len - 1]); l_len-- );
+            cl_ht->keep_alive = l_len == sizeof("Keep-Alive") - 1 && !strncasecmp(l_pval, "Keep-Alive", l_len);
             break;
 
         case    HTTP_FLD$K_CONTENT_TYPE:
@@ -159,18 +225,11 @@ dap_http_header_t *l_new_header;
             cl_ht->in_content_type[l_valuelen] = '\0';
             break;
 
-        case    HTTP_FLD$K_CONTENT_LEN:
-            {
-            char digit[32] = {0};
-            memcpy(digit, l_pval, dap_min(l_valuelen, sizeof(digit) - 1));
-            cl_ht->in_content_length = atoi( digit );
-        }
-            break;
-
         case    HTTP_FLD$K_COOKIE:
             memcpy(cl_ht->in_cookie, l_pval, l_len = dap_min(l_valuelen, sizeof(cl_ht->in_cookie) - 1) );
             cl_ht->in_cookie[l_valuelen] = '\0';
             break;
+
     }
 
 
@@ -236,6 +295,36 @@ dap_http_header_t * dap_http_out_header_add_f(dap_http_client_t *ht, const char
     return ret;
 }
 
+/**
+ * @brief dap_http_header_tpl_new Render header lines once to write them into many replies
+ * @param a_name First header name
+ * @param a_value First header value, then next name and value pairs terminated by NULL
+ * @return Template, delete it with dap_http_header_tpl_delete()
+ */
+dap_http_header_tpl_t *dap_http_header_tpl_new(const char *a_name, const char *a_value, ...)
+{
+    dap_return_val_if_fail(a_name && a_value, NULL);
+    va_list l_args;
+    size_t l_size = 0;
+    va_start(l_args, a_value);
+    for (const char *l_name = a_name, *l_value = a_value; l_name && l_value; ) {
+        l_size += strlen(l_name) + strlen(l_value) + 4;
+        if ( (l_name = va_arg(l_args, const char *)) )
+            l_value = va_arg(l_args, const char *);
+    }
+    va_end(l_args);
+
+    dap_http_header_tpl_t *l_tpl = DAP_NEW_Z_SIZE_RET_VAL_IF_FAIL(dap_http_header_tpl_t, sizeof(dap_http_header_tpl_t) + l_size + 1, NULL);
+    va_start(l_args, a_value);
+    for (const char *l_name = a_name, *l_value = a_value; l_name && l_value; ) {
+        l_tpl->size += snprintf(l_tpl->data + l_tpl->size, l_size + 1 - l_tpl->size, "%s: %s" CRLF, l_name, l_value);
+        if ( (l_name = va_arg(l_args, const char *)) )
+            l_value = va_arg(l_args, const char *);
+    }
+    va_end(l_args);
+    return l_tpl;
+}
+
 /**
  * @brief dap_http_header_remove Removes header from the list
  * @param dap_hdr HTTP header
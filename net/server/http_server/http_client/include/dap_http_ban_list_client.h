@@ -18,8 +18,14 @@
 int dap_http_ban_list_client_init();
 void dap_http_ban_list_client_deinit();
 
+// Addresses are IPv4 or IPv6, optionally with prefix length to ban a subnet, e.g. "10.0.0.0/8", "2001:db8::/32".
+// Other strings, like node addresses "XXXX::XXXX::XXXX::XXXX", are banned and checked as they are
 bool dap_http_ban_list_client_check(const char *a_addr, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts);
+// Check for accept path, no string conversions; the longest matched prefix gives decree hash and time
+bool dap_http_ban_list_client_check_sockaddr(const struct sockaddr_storage *a_addr, dap_hash_fast_t *a_decree_hash, dap_time_t *a_ts);
 int dap_http_ban_list_client_add(const char *a_addr, dap_hash_fast_t a_decree_hash, dap_time_t a_ts);
+// Ban is lifted at a_ts_expire, 0 means never
+int dap_http_ban_list_client_add_ex(const char *a_addr, dap_hash_fast_t a_decree_hash, dap_time_t a_ts, dap_time_t a_ts_expire);
 int dap_http_ban_list_client_remove(const char *a_addr);
 json_object  *dap_http_ban_list_client_dump(const char *a_addr);
 
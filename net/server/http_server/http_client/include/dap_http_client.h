@@ -22,6 +22,8 @@
 #include <time.h>
 #include <stdbool.h>
 #include "dap_events_socket.h"
+#include "dap_http_router.h"
+#include "dap_http_compress.h"
 
 struct dap_http_client;
 struct dap_http;
@@ -31,9 +33,19 @@ typedef enum dap_http_client_state{
     DAP_HTTP_CLIENT_STATE_NONE = 0,
     DAP_HTTP_CLIENT_STATE_START = 1,
     DAP_HTTP_CLIENT_STATE_HEADERS = 2,
-    DAP_HTTP_CLIENT_STATE_DATA = 3
+    DAP_HTTP_CLIENT_STATE_DATA = 3,
+    DAP_HTTP_CLIENT_STATE_REPLY = 4                                         /* Request is read, next pipelined one waits in buf_in */
 } dap_http_client_state_t;
 
+// Decoder state of request body with "Transfer-Encoding: chunked"
+typedef enum dap_http_chunk_state {
+    DAP_HTTP_CHUNK_SIZE = 0,                                                /* Chunk size line is expected */
+    DAP_HTTP_CHUNK_DATA,
+    DAP_HTTP_CHUNK_DATA_END,                                                /* CRLF after chunk data */
+    DAP_HTTP_CHUNK_TRAILER,                                                 /* Trailer fields after the last chunk */
+    DAP_HTTP_CHUNK_DONE                                                     /* Body is over, in_content_length is set */
+} dap_http_chunk_state_t;
+
 typedef void (*dap_http_client_callback_t) (struct dap_http_client *,void * arg); // Callback for specific client operations
 typedef bool (*dap_http_client_callback_write_t) (struct dap_http_client *a_client, void *a_arg); // Callback for write client operation
 typedef void (*dap_http_client_callback_error_t) (struct dap_http_client *,int); // Callback for specific client operations
@@ -54,9 +66,15 @@ typedef struct dap_http_client
     char in_content_type[256],
         in_cookie[1024];
     size_t in_content_length,
+        in_content_received,
         in_cookie_len;
+    bool    in_chunked;                                                     /* Transfer-Encoding: chunked */
+    dap_http_chunk_state_t in_chunk_state;
+    size_t  in_chunk_left;
 
     struct dap_http_header *out_headers;
+    const struct dap_http_header_tpl *out_headers_tpl;                      /* Pre-rendered headers of the reply, not owned */
+    bool    out_headers_default;                                            /* General headers are written by dap_http_client_write() */
 
     int     out_content_ready;
 
@@ -65,12 +83,26 @@ typedef struct dap_http_client
 
     time_t out_last_modified;
     int     out_connection_close;
+    int     out_keep_alive;                                                 /* Reply is sent with Connection: Keep-Alive */
+    bool    out_chunked;                                                    /* Reply is sent with Transfer-Encoding: chunked */
+    dap_http_encoding_t out_encoding;                                       /* Content-Encoding of the body, out_content_length is encoded size */
+    bool    out_vary_encoding;                                              /* Body depends on Accept-Encoding, Vary header is sent */
+    struct dap_http_cache *out_cache;                                       /* Cached reply being sent, referenced */
     size_t out_cache_position;
 
+    uint8_t route_params_count;                                             /* Path parameters of the route, like ":id" */
+    dap_http_route_param_t route_params[DAP_HTTP_ROUTE_PARAMS_MAX];
+    char route_values[256];
+
     dap_events_socket_t *esocket;
     SOCKET socket_num;
     struct dap_http_server * http;
 
+    // Connection state, kept between requests
+    uint32_t requests_count;                                                /* Requests received over this connection */
+    time_t  ts_idle;                                                        /* When the last reply was done */
+    struct dap_timerfd *keep_alive_timer;                                   /* Idle timeout, runs between requests only */
+
     uint16_t reply_status_code;
 
     char reply_reason_phrase[256];
@@ -100,6 +132,9 @@ void dap_http_client_error( dap_events_socket_t * a_esocket,int a_arg ); // Proc
 void dap_http_client_out_header_generate( dap_http_client_t *a_http_client );
 
 void dap_http_client_write(dap_http_client_t *a_http_client);   // Start write event
+void dap_http_client_request_done(dap_http_client_t *a_http_client);    // Reply is sent, go to the next request or close
+void dap_http_client_reply_error(dap_http_client_t *a_http_client, uint16_t a_code);   // Stop reading the request and reply with error
+const char *dap_http_client_route_param(dap_http_client_t *a_http_client, const char *a_name);  // Path parameter of the route
 
 #ifdef __cplusplus
 }
@@ -42,6 +42,11 @@ typedef struct dap_http_header{
     struct dap_http_header *next, *prev;                                    /* List's element links */
 } dap_http_header_t;
 
+// Pre-rendered header lines "Name: value\r\n...", written to reply as is. For headers which are the same for many replies
+typedef struct dap_http_header_tpl {
+    size_t size;
+    char data[];
+} dap_http_header_tpl_t;
 
 
 int dap_http_header_init(); // Init module
@@ -65,6 +70,13 @@ dap_http_header_t * dap_http_headers_dup(dap_http_header_t * a_top);
 
 void dap_http_header_remove(dap_http_header_t **a_top,dap_http_header_t *a_hdr);
 
+// Name and value pairs terminated by NULL
+dap_http_header_tpl_t *dap_http_header_tpl_new(const char *a_name, const char *a_value, ...);
+static inline void dap_http_header_tpl_delete(dap_http_header_tpl_t *a_tpl)
+{
+    DAP_DELETE(a_tpl);
+}
+
 // For debug output
 void print_dap_http_headers(dap_http_header_t * a_ht);
 
@@ -82,6 +94,7 @@ enum    {
     HTTP_FLD$K_CONTENT_TYPE,                                                /* Content-Type: application/x-www-form-urlencoded */
     HTTP_FLD$K_CONTENT_LEN,                                                 /* Content-Length: 348 */
     HTTP_FLD$K_COOKIE,                                                      /* Cookie: $Version=1; Skin=new; */
+    HTTP_FLD$K_TRANSFER_ENC,                                                /* Transfer-Encoding: chunked */
 
 
     HTTP_FLD$K_EOL                                                          /* End-Of-List marker, mast be last element here */
@@ -23,20 +23,55 @@
 #pragma once
 #include "dap_common.h"
 #include "dap_http_header.h"
+#include "uthash.h"
 
-// Cache object
+#define DAP_HTTP_CACHE_ETAG_SIZE    19                                      /* Quoted 16 hex digits + '\0' */
+
+// Cache object, shared by all clients while referenced
 typedef struct dap_http_cache
 {
+    char *key;                                                              /* "METHOD /proc/path?query" */
     struct dap_http_url_proc * url_proc;
     byte_t *body;
     size_t body_size;
+    byte_t *body_gzip;                                                      /* Compressed variant if it's worth it */
+    size_t body_gzip_size;
     dap_http_header_t * headers;
+    char content_type[256];
     char * response_phrase;
     int    response_code;
     time_t ts_expire;
+    char etag[DAP_HTTP_CACHE_ETAG_SIZE];
+    char etag_gzip[DAP_HTTP_CACHE_ETAG_SIZE + 3];                           /* Representations differ, so tags do: "...-gz" */
+
+    size_t mem_size;                                                        /* Accounted in the memory limit */
+    int refs;                                                               /* Table and clients sending it */
+    bool linked;                                                            /* Still in the table and LRU list */
+    struct dap_http_cache *prev, *next;                                     /* LRU list, the most recent is the head */
+    UT_hash_handle hh;
 } dap_http_cache_t;
 
-dap_http_cache_t * dap_http_cache_update(struct dap_http_url_proc * a_url_proc, const byte_t * a_body, size_t a_body_size,
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int dap_http_cache_init(void);
+void dap_http_cache_deinit(void);
+
+void dap_http_cache_set_size_max(size_t a_size_max);
+size_t dap_http_cache_get_size(void);
+size_t dap_http_cache_get_count(void);
+void dap_http_cache_set_proc_ttl(struct dap_http_url_proc *a_url_proc, time_t a_ttl);
+
+dap_http_cache_t * dap_http_cache_update(dap_http_client_t *a_http_client, const byte_t * a_body, size_t a_body_size,
                                          dap_http_header_t * a_headers, const char * a_response_phrase, int a_respoonse_code,
                                          time_t a_ts_expire );
+dap_http_cache_t *dap_http_cache_find(dap_http_client_t *a_http_client);
+void dap_http_cache_release(dap_http_cache_t *a_http_cache);
+void dap_http_cache_invalidate(struct dap_http_url_proc *a_url_proc);
+void dap_http_cache_reply_prepare(dap_http_client_t *a_http_client);
 void dap_http_cache_delete(dap_http_cache_t * a_http_cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Authors:
+ * DeM Labs Ltd.   https://demlabs.net
+ * Copyright  (c) 2024
+ * All rights reserved.
+
+ This file is part of DAP SDK the open source project
+
+    DAP SDK is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    DAP SDK is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "dap_common.h"
+
+// Reply compression, negotiated by Accept-Encoding of the request. Works if the SDK is built with zlib (DAP_HTTP_ZLIB),
+// turned off by default, see [http] compress, compress_min_size and compress_level config items
+
+#define DAP_HTTP_COMPRESS_SIZE_UNKNOWN  SIZE_MAX                            /* Body is streamed */
+
+struct dap_http_client;
+
+typedef enum dap_http_encoding {
+    DAP_HTTP_ENCODING_IDENTITY = 0,
+    DAP_HTTP_ENCODING_GZIP,
+    DAP_HTTP_ENCODING_DEFLATE                                               /* zlib format, as RFC 9110 says */
+} dap_http_encoding_t;
+
+// Streaming compressor, produces output by pieces as the buffer allows
+typedef struct dap_http_compressor dap_http_compressor_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int dap_http_compress_init(void);
+void dap_http_compress_deinit(void);
+
+// Returns -1 if the SDK is built without compression support
+int dap_http_compress_set(bool a_enabled, size_t a_min_size, int a_level);
+bool dap_http_compress_enabled(void);
+
+// Text-like types only, images and archives are compressed already
+bool dap_http_compress_type_allowed(const char *a_content_type);
+// Compression is on and the reply is big enough and of the allowed type
+bool dap_http_compress_allowed(const char *a_content_type, size_t a_size);
+dap_http_encoding_t dap_http_compress_accepted(const char *a_accept_encoding);
+// Encoding for the reply of given type and size, identity if the reply shouldn't be compressed
+dap_http_encoding_t dap_http_compress_negotiate(struct dap_http_client *a_http_client, const char *a_content_type, size_t a_size);
+const char *dap_http_encoding_str(dap_http_encoding_t a_encoding);
+
+// Whole body at once, returns NULL if compressed body isn't smaller than the source
+uint8_t *dap_http_compress(dap_http_encoding_t a_encoding, const void *a_data, size_t a_size, size_t *a_out_size);
+
+dap_http_compressor_t *dap_http_compressor_new(dap_http_encoding_t a_encoding);
+void dap_http_compressor_delete(dap_http_compressor_t *a_compressor);
+// Next piece of the body, it must be kept until dap_http_compressor_wants_input() is true again. a_last finishes the stream
+void dap_http_compressor_input(dap_http_compressor_t *a_compressor, const void *a_data, size_t a_size, bool a_last);
+bool dap_http_compressor_wants_input(dap_http_compressor_t *a_compressor);
+// Puts compressed data into the buffer, returns its size or -1 on error
+ssize_t dap_http_compressor_output(dap_http_compressor_t *a_compressor, void *a_buf, size_t a_buf_size);
+bool dap_http_compressor_is_over(dap_http_compressor_t *a_compressor);
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,10 +21,33 @@
     along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
+#include <stddef.h>
 struct dap_http_server;
 
+// How file body is moved to the plain (non-SSL) client socket
+typedef enum dap_http_folder_send_mode {
+    DAP_HTTP_FOLDER_SEND_BUFFERED = 0,  // read() chunks into the esocket's output buffer
+    DAP_HTTP_FOLDER_SEND_MMAP,          // send() straight from the mapped file
+    DAP_HTTP_FOLDER_SEND_SENDFILE       // sendfile(), zero-copy in kernel (Linux only)
+} dap_http_folder_send_mode_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 int dap_http_folder_init(void);
 void dap_http_folder_deinit(void);
 
 int dap_http_folder_add(struct dap_http_server *sh, const char * url_path, const char * local_path); // Add folder for reading to the HTTP server
 
+int dap_http_folder_set_send_mode(dap_http_folder_send_mode_t a_mode);
+dap_http_folder_send_mode_t dap_http_folder_get_send_mode(void);
+
+// Compressed copies of text files for clients which accept gzip, see dap_http_compress.h
+void dap_http_folder_set_gzip_cache_size_max(size_t a_size_max);
+size_t dap_http_folder_get_gzip_cache_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -0,0 +1,74 @@
+/*
+ * Authors:
+ * DeM Labs Ltd.   https://demlabs.net
+ * Copyright  (c) 2024
+ * All rights reserved.
+
+ This file is part of DAP SDK the open source project
+
+    DAP SDK is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    DAP SDK is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with any DAP SDK based project.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct dap_http_server;
+struct dap_http_url_proc;
+
+// URL router is a trie of path segments, lookup time is linear in path length.
+// Route pattern is "[METHOD[,METHOD...] ]/segment/:param/*":
+//   "/enc_init"            plain path and any single segment below it, processor gets the last segment as url_path,
+//                          e.g. "enc_init" or "gd4y5yh78w42aaagh", as before (legacy processors)
+//   "GET,HEAD /users/:id"  parameter matches one non-empty segment, the route is for listed methods only
+//   "/static/*"            prefix route, processor gets the rest of path as url_path
+// Static segments win over parameters, parameters win over prefixes, so longer prefix wins over shorter one.
+
+#define DAP_HTTP_ROUTE_PARAMS_MAX   8
+
+typedef struct dap_http_route_param {
+    const char *name;                                                       /* Owned by router */
+    const char *value;
+    size_t value_len;
+} dap_http_route_param_t;
+
+typedef struct dap_http_route_match {
+    struct dap_http_url_proc *proc;
+    const char *path;                                                       /* What processor gets as url_path */
+    size_t path_len;
+    uint8_t params_count;
+    dap_http_route_param_t params[DAP_HTTP_ROUTE_PARAMS_MAX];
+    uint32_t methods_allowed;                                               /* Set if the method is not allowed */
+} dap_http_route_match_t;
+
+typedef enum dap_http_route_result {
+    DAP_HTTP_ROUTE_FOUND = 0,
+    DAP_HTTP_ROUTE_NOT_FOUND,
+    DAP_HTTP_ROUTE_METHOD_NOT_ALLOWED                                       /* Path is routed for other methods only */
+} dap_http_route_result_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int dap_http_route_add(struct dap_http_server *a_http, const char *a_pattern, struct dap_http_url_proc *a_proc);
+dap_http_route_result_t dap_http_route_find(struct dap_http_server *a_http, const char *a_method, const char *a_path, size_t a_path_len,
+                                            dap_http_route_match_t *a_match);
+// Comma separated list of methods for Allow header of 405 reply
+size_t dap_http_route_methods_str(uint32_t a_methods, char *a_buf, size_t a_buf_size);
+void dap_http_routes_delete(struct dap_http_server *a_http);
+
+#ifdef __cplusplus
+}
+#endif
@@ -27,6 +27,7 @@ See more details here <http://www.gnu.org/licenses/>.
 #include "dap_http_header.h"
 #include "dap_http_client.h"
 #include "dap_http_cache.h"
+#include "dap_http_router.h"
 #include "uthash.h"
 
 struct dap_http_server;
@@ -35,11 +36,10 @@ struct dap_http_url_processor;
 
 // Structure for holding URL processors
 typedef struct dap_http_url_proc{
-    char url[512]; // First part of URL that will be processed
+    char url[512]; // First part of URL that will be processed or route pattern, see dap_http_router.h
     struct dap_http_server *http; // Pointer to HTTP server instance
 
-    dap_http_cache_t * cache; // In memory cache, could be present or not
-    pthread_rwlock_t cache_rwlock;
+    time_t cache_ttl; // Seconds to keep successful GET replies in cache, 0 if they are not cached
 
     dap_http_client_callback_t new_callback; // Init internal structure
     dap_http_client_callback_t delete_callback; // Delete internal structure
@@ -61,7 +61,10 @@ typedef struct dap_http_url_proc{
 typedef struct dap_http_server {
     dap_server_t *server;
     char server_name[256];
+    char server_header[256 + 16]; // Pre-rendered "Server: <name>\r\n"
+    size_t server_header_size;
     dap_http_url_proc_t * url_proc;
+    struct dap_http_route_node *routes; // URL router trie
 } dap_http_server_t;
 
 #define DAP_HTTP_SERVER(a) ((dap_http_server_t *) (a)->_inheritor)
@@ -28,12 +28,20 @@ See more details here <http://www.gnu.org/licenses/>.
 #include "dap_events_socket.h"
 #include "dap_http_server.h"
 #include "dap_uuid.h"
+#include "http_status_code.h"
 //#define DAP_HTTP_SIMPLE_REQUEST_MAX 100000
 // number of simultaneous http requests
 #define DAP_HTTP_SIMPLE_REQUEST_MAX 65536
+// Chunked body collected in request buffer is limited with it if processor has no request size limit
+#define DAP_HTTP_SIMPLE_CHUNKED_REQUEST_LIMIT (16 * 1024 * 1024)
 
 struct dap_http_simple;
 typedef void ( *dap_http_simple_callback_t )( struct dap_http_simple *, void * );
+// Streaming mode, called in proc thread for each piece of request body, any status except Http_Status_OK aborts the request
+typedef http_status_code_t ( *dap_http_simple_chunk_callback_t )( struct dap_http_simple *, const void *a_data, size_t a_data_size );
+// Streamed reply, called in worker thread when output buffer has room. Writes up to a_buf_size bytes of body into a_buf and
+// returns its size, zero when the body is over, negative value aborts the reply and closes the connection
+typedef ssize_t ( *dap_http_simple_stream_callback_t )( struct dap_http_simple *, void *a_buf, size_t a_buf_size );
 
 typedef struct dap_http_simple {
     dap_events_socket_t * esocket;
@@ -67,6 +75,13 @@ typedef struct dap_http_simple {
 
     dap_http_header_t *ext_headers;
     bool generate_default_header;
+    bool reply_deferred; // Reply will be sent with dap_http_simple_proc_done()
+    dap_http_simple_stream_callback_t stream_callback; // Reply body is produced by pieces, see dap_http_simple_reply_stream()
+    bool stream_over;
+    struct dap_http_compressor *compressor; // Streamed reply is compressed, the callback fills stream_buf then
+    uint8_t *stream_buf;
+
+    void *_inheritor; // Proc callbacks state, freed with the request
 
    // dap_http_simple_callback_t reply_proc_post_callback;
 } dap_http_simple_t;
@@ -74,6 +89,12 @@ typedef struct dap_http_simple {
 #define DAP_HTTP_SIMPLE(a) ((dap_http_simple_t*) (a)->_inheritor )
 
 struct dap_http_url_proc * dap_http_simple_proc_add( dap_http_server_t *sh, const char *url_path, size_t reply_size_max, dap_http_simple_callback_t cb ); // Add simple processor
+// Add simple processor which gets request body by pieces with chunk callback, then cb is called with no request buffer
+struct dap_http_url_proc * dap_http_simple_proc_add_streaming( dap_http_server_t *sh, const char *url_path, size_t reply_size_max,
+                                                               size_t request_size_limit, dap_http_simple_chunk_callback_t chunk_cb,
+                                                               dap_http_simple_callback_t cb );
+// Requests with bigger body are rejected with 413 status, 0 means no limit except DAP_HTTP_SIMPLE_CHUNKED_REQUEST_LIMIT
+void dap_http_simple_set_request_size_limit( struct dap_http_url_proc *a_url_proc, size_t a_request_size_limit );
 
 int  dap_http_simple_module_init( void );
 void dap_http_simple_module_deinit(void);
@@ -93,6 +114,15 @@ void dap_http_simple_set_pass_unknown_user_agents(int pass );
 
 size_t dap_http_simple_reply( dap_http_simple_t *a_http_simple, void *a_data, size_t a_data_size);
 DAP_PRINTF_ATTR(2, 3) size_t dap_http_simple_reply_f(dap_http_simple_t *a_http_simple, const char *a_format, ... );
+// Reply body isn't collected in reply buffer but sent with chunked transfer coding as the callback produces it
+DAP_STATIC_INLINE void dap_http_simple_reply_stream(dap_http_simple_t *a_http_simple, dap_http_simple_stream_callback_t a_callback)
+{
+    a_http_simple->stream_callback = a_callback;
+}
 dap_http_cache_t * dap_http_simple_make_cache_from_reply(dap_http_simple_t * a_http_simple , time_t a_ts_expire );
 void dap_http_simple_set_flag_generate_default_header(dap_http_simple_t *a_http_simple, bool flag);
 
+// Proc callback passes the request to another thread, it must finish it with dap_http_simple_proc_done()
+DAP_STATIC_INLINE void dap_http_simple_proc_defer(dap_http_simple_t *a_http_simple) { a_http_simple->reply_deferred = true; }
+void dap_http_simple_proc_done(dap_http_simple_t *a_http_simple, http_status_code_t a_return_code);
+
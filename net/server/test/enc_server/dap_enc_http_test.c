@@ -0,0 +1,410 @@
+#include "dap_enc_http_test.h"
+#include "dap_enc_http.h"
+#include "dap_enc_ks.h"
+#include "dap_enc.h"
+#include "dap_enc_base64.h"
+#include "dap_enc_key.h"
+#include "dap_http_simple.h"
+#include "dap_http_client.h"
+#include "dap_http_server.h"
+#include "dap_cert.h"
+#include "dap_sign.h"
+#include "http_status_code.h"
+#include "rand/dap_rand.h"
+#include "dap_strfuncs.h"
+#include "dap_events.h"
+#include "dap_worker.h"
+#include "dap_proc_thread.h"
+#include "dap_time.h"
+#include "json.h"
+
+#define HANDSHAKES_COUNT 200
+#define REPLY_SIZE_MAX 140000
+#define REQUESTS_COUNT 200
+#define STORM_QUEUE_MAX 4
+#define STORM_IN_FLIGHT_MAX 8
+
+typedef struct test_session {
+    char id[DAP_ENC_KS_KEY_ID_SIZE + 1];
+    size_t id_size;
+    dap_enc_key_t *key;
+} test_session_t;
+
+static char *s_resume_id = NULL;
+static uint8_t s_resume_secret[DAP_ENC_KS_RESUME_SECRET_SIZE];
+
+// Server side request processing without network, the same way as HTTP simple worker does it
+static http_status_code_t s_request(dap_http_simple_t *a_simple, dap_http_client_t *a_http, const char *a_path, const char *a_query,
+                                    const void *a_body, size_t a_body_size)
+{
+    char l_body_b64[DAP_ENC_BASE64_ENCODE_SIZE(a_body_size) + 1];
+    dap_strncpy(a_http->url_path, a_path, sizeof(a_http->url_path));
+    dap_strncpy(a_http->in_query_string, a_query, sizeof(a_http->in_query_string));
+    a_simple->request_size = dap_enc_base64_encode(a_body, a_body_size, l_body_b64, DAP_ENC_DATA_TYPE_B64);
+    a_simple->request = l_body_b64;
+    a_simple->reply_size = 0;
+    http_status_code_t l_code = Http_Status_OK;
+    enc_http_proc(a_simple, &l_code);
+    a_simple->request = NULL;
+    a_simple->reply_str[a_simple->reply_size] = '\0';
+    return l_code;
+}
+
+static const char *s_reply_field(struct json_object *a_jobj, const char *a_name)
+{
+    struct json_object *l_obj = NULL;
+    return json_object_object_get_ex(a_jobj, a_name, &l_obj) ? json_object_get_string(l_obj) : NULL;
+}
+
+static size_t s_decode_field(struct json_object *a_jobj, const char *a_name, void *a_out, size_t a_out_size)
+{
+    const char *l_str = s_reply_field(a_jobj, a_name);
+    size_t l_len = l_str ? strlen(l_str) : 0;
+    return l_len && DAP_ENC_BASE64_DECODE_SIZE(l_len) <= a_out_size ? dap_enc_base64_decode(l_str, l_len, a_out, DAP_ENC_DATA_TYPE_B64) : 0;
+}
+
+// Client and server keys must be the same
+static bool s_session_check(test_session_t *a_session)
+{
+    dap_enc_ks_key_t *l_ks = dap_enc_ks_find(a_session->id);
+    if (!l_ks || !a_session->key)
+        return false;
+    const char l_msg[] = "session check";
+    char l_enc[256], l_dec[256];
+    size_t l_enc_size = dap_enc_code(a_session->key, l_msg, sizeof(l_msg), l_enc, sizeof(l_enc), DAP_ENC_DATA_TYPE_RAW),
+           l_dec_size = dap_enc_decode(l_ks->key, l_enc, l_enc_size, l_dec, sizeof(l_dec), DAP_ENC_DATA_TYPE_RAW);
+    return l_dec_size == sizeof(l_msg) && !memcmp(l_msg, l_dec, sizeof(l_msg));
+}
+
+static int s_handshake_full(dap_http_simple_t *a_simple, dap_http_client_t *a_http, dap_cert_t *a_cert, test_session_t *a_session)
+{
+    dap_enc_key_t *l_kex = dap_enc_key_new_generate(DAP_ENC_KEY_TYPE_KEM_KYBER512, NULL, 0, NULL, 0, 32);
+    dap_sign_t *l_sign = dap_sign_create(a_cert->enc_key, l_kex->pub_key_data, l_kex->pub_key_data_size);
+    size_t l_sign_size = dap_sign_get_size(l_sign), l_body_size = l_kex->pub_key_data_size + l_sign_size;
+    byte_t *l_body = DAP_NEW_Z_SIZE(byte_t, l_body_size);
+    memcpy(l_body, l_kex->pub_key_data, l_kex->pub_key_data_size);
+    memcpy(l_body + l_kex->pub_key_data_size, l_sign, l_sign_size);
+    char l_query[256];
+    snprintf(l_query, sizeof(l_query), "enc_type=%d,pkey_exchange_type=%d,pkey_exchange_size=%zu,block_key_size=32,protocol_version=%d,sign_count=1",
+             DAP_ENC_KEY_TYPE_SALSA2012, DAP_ENC_KEY_TYPE_KEM_KYBER512, l_kex->pub_key_data_size, DAP_PROTOCOL_VERSION);
+    http_status_code_t l_code = s_request(a_simple, a_http, "gd4y5yh78w42aaagh", l_query, l_body, l_body_size);
+    DAP_DEL_MULTY(l_body, l_sign);
+    int l_ret = -1;
+    struct json_object *l_jobj = l_code == Http_Status_OK ? json_tokener_parse(a_simple->reply_str) : NULL;
+    if (l_jobj) {
+        byte_t l_bob_msg[4096], l_node_sign[REPLY_SIZE_MAX];
+        size_t l_bob_msg_size = s_decode_field(l_jobj, "encrypt_msg", l_bob_msg, sizeof(l_bob_msg)),
+               l_node_sign_size = s_decode_field(l_jobj, "node_sign", l_node_sign, sizeof(l_node_sign));
+        a_session->id_size = s_decode_field(l_jobj, "encrypt_id", a_session->id, sizeof(a_session->id));
+        if ( a_session->id_size && l_bob_msg_size
+                && l_kex->gen_alice_shared_key(l_kex, l_kex->priv_key_data, l_bob_msg_size, l_bob_msg)
+                && !dap_sign_verify_all((dap_sign_t*)l_node_sign, l_node_sign_size, l_bob_msg, l_bob_msg_size) ) {
+            a_session->key = dap_enc_key_new_generate(DAP_ENC_KEY_TYPE_SALSA2012, l_kex->priv_key_data, l_kex->priv_key_data_size,
+                                                      a_session->id, a_session->id_size, 32);
+            const char *l_resume_id = s_reply_field(l_jobj, "resume_id");
+            if (l_resume_id) {
+                DAP_DEL_Z(s_resume_id);
+                s_resume_id = dap_strdup(l_resume_id);
+                dap_enc_ks_resume_secret_make(l_kex->priv_key_data, l_kex->priv_key_data_size, s_resume_secret);
+            }
+            l_ret = 0;
+        }
+        json_object_put(l_jobj);
+    }
+    dap_enc_key_delete(l_kex);
+    return l_ret;
+}
+
+static int s_handshake_resume(dap_http_simple_t *a_simple, dap_http_client_t *a_http, test_session_t *a_session)
+{
+    uint8_t l_nonce[DAP_ENC_KS_RESUME_NONCE_SIZE];
+    randombytes(l_nonce, sizeof(l_nonce));
+    char l_query[256];
+    snprintf(l_query, sizeof(l_query), "enc_type=%d,block_key_size=32,resume_id=%s", DAP_ENC_KEY_TYPE_SALSA2012, s_resume_id);
+    if (s_request(a_simple, a_http, "resume", l_query, l_nonce, sizeof(l_nonce)) != Http_Status_OK)
+        return -1;
+    struct json_object *l_jobj = json_tokener_parse(a_simple->reply_str);
+    if (!l_jobj)
+        return -2;
+    dap_hash_fast_t l_proof, l_proof_remote;
+    a_session->id_size = s_decode_field(l_jobj, "encrypt_id", a_session->id, sizeof(a_session->id));
+    size_t l_proof_size = s_decode_field(l_jobj, "encrypt_msg", &l_proof_remote, sizeof(l_proof_remote) + 2);
+    const char *l_next_id = s_reply_field(l_jobj, "resume_id");
+    char *l_resume_id = l_next_id ? dap_strdup(l_next_id) : NULL;
+    json_object_put(l_jobj);
+    int l_ret = -3;
+    if (a_session->id_size && l_proof_size == sizeof(l_proof)) {
+        a_session->key = dap_enc_ks_resume_key_make(s_resume_secret, l_nonce, a_session->id, a_session->id_size,
+                                                    DAP_ENC_KEY_TYPE_SALSA2012, 32, &l_proof);
+        l_ret = a_session->key && !memcmp(&l_proof, &l_proof_remote, sizeof(l_proof)) ? 0 : -4;
+    }
+    // The used ticket is exchanged for the next one
+    if (!l_ret && l_resume_id) {
+        DAP_DELETE(s_resume_id);
+        s_resume_id = l_resume_id;
+        dap_enc_ks_resume_secret_next(s_resume_secret, l_nonce, s_resume_secret);
+    } else
+        DAP_DELETE(l_resume_id);
+    return l_ret;
+}
+
+static void s_session_free(test_session_t *a_session)
+{
+    dap_enc_ks_delete(a_session->id);
+    dap_enc_key_delete(a_session->key);
+    memset(a_session, 0, sizeof(*a_session));
+}
+
+static void s_handshakes_benchmark(dap_http_simple_t *a_simple, dap_http_client_t *a_http, dap_cert_t *a_cert)
+{
+    test_session_t l_session = { };
+    int l_time = get_cur_time_msec(), l_ret = 0;
+    for (int i = 0; i < HANDSHAKES_COUNT && !l_ret; i++) {
+        if (!(l_ret = s_handshake_full(a_simple, a_http, a_cert, &l_session)))
+            l_ret = !s_session_check(&l_session);
+        s_session_free(&l_session);
+    }
+    dap_assert_PIF(!l_ret, "Full handshake");
+    int l_full_time = dap_max(get_cur_time_msec() - l_time, 1);
+    benchmark_mgs_rate("Full handshakes", HANDSHAKES_COUNT * 1000.0f / l_full_time);
+
+    l_time = get_cur_time_msec();
+    for (int i = 0; i < HANDSHAKES_COUNT && !l_ret; i++) {
+        if (!(l_ret = s_handshake_resume(a_simple, a_http, &l_session)))
+            l_ret = !s_session_check(&l_session);
+        s_session_free(&l_session);
+    }
+    dap_assert_PIF(!l_ret, "Resumed handshake");
+    int l_resume_time = dap_max(get_cur_time_msec() - l_time, 1);
+    benchmark_mgs_rate("Resumed handshakes", HANDSHAKES_COUNT * 1000.0f / l_resume_time);
+}
+
+static void s_resume_reject_test(dap_http_simple_t *a_simple, dap_http_client_t *a_http)
+{
+    test_session_t l_session = { };
+    // Used ticket
+    char *l_used_id = dap_strdup(s_resume_id);
+    dap_assert_PIF(!s_handshake_resume(a_simple, a_http, &l_session), "Resumption");
+    s_session_free(&l_session);
+    char *l_next_id = s_resume_id;
+    s_resume_id = l_used_id;
+    dap_assert(s_handshake_resume(a_simple, a_http, &l_session) == -1, "Resumption with used ticket is rejected");
+    s_session_free(&l_session);
+    DAP_DELETE(l_used_id);
+    s_resume_id = l_next_id;
+    // Wrong secret, the ticket is used by the attempt
+    s_resume_secret[0] ^= 1;
+    dap_assert(s_handshake_resume(a_simple, a_http, &l_session) == -4, "Resumption with wrong secret is not confirmed");
+    s_session_free(&l_session);
+    s_resume_secret[0] ^= 1;
+    dap_assert(s_handshake_resume(a_simple, a_http, &l_session) == -1, "Ticket is used by the failed resumption");
+    s_session_free(&l_session);
+    // Revoked ticket
+    char l_id[DAP_ENC_KS_KEY_ID_SIZE];
+    dap_assert_PIF(!dap_enc_ks_resume_add(s_resume_secret, (dap_stream_node_addr_t){ }, 60, l_id), "Ticket add");
+    DAP_DELETE(s_resume_id);
+    s_resume_id = dap_strdup(l_id);
+    dap_enc_ks_resume_delete(s_resume_id);
+    dap_assert(s_handshake_resume(a_simple, a_http, &l_session) == -1, "Resumption with revoked ticket is rejected");
+    s_session_free(&l_session);
+    // Oversized nonce
+    dap_assert_PIF(!dap_enc_ks_resume_add(s_resume_secret, (dap_stream_node_addr_t){ }, 60, l_id), "Ticket add");
+    char l_query[256];
+    snprintf(l_query, sizeof(l_query), "enc_type=%d,block_key_size=32,resume_id=%s", DAP_ENC_KEY_TYPE_SALSA2012, l_id);
+    byte_t l_huge[1024] = { };
+    dap_assert(s_request(a_simple, a_http, "resume", l_query, l_huge, sizeof(l_huge)) == Http_Status_BadRequest,
+               "Resumption with oversized nonce is rejected");
+    dap_enc_ks_resume_t l_resume;
+    dap_assert(dap_enc_ks_resume_take(l_id, &l_resume) && !memcmp(l_resume.secret, s_resume_secret, sizeof(s_resume_secret)),
+               "Ticket is kept after malformed request");
+    dap_assert(!dap_enc_ks_resume_take(l_id, &l_resume), "Taken ticket is not found");
+    // Expired ticket
+    dap_assert_PIF(!dap_enc_ks_resume_add(s_resume_secret, (dap_stream_node_addr_t){ }, 1, l_id), "Ticket add");
+    sleep(2);
+    dap_assert(!dap_enc_ks_resume_take(l_id, &l_resume), "Expired ticket is not found");
+    // The oldest ticket is dropped over the limit
+    char l_ids[3][DAP_ENC_KS_KEY_ID_SIZE];
+    dap_enc_ks_resume_set_count_max(2);
+    for (int i = 0; i < 3; i++)
+        dap_assert_PIF(!dap_enc_ks_resume_add(s_resume_secret, (dap_stream_node_addr_t){ }, 60, l_ids[i]), "Ticket add");
+    dap_assert(!dap_enc_ks_resume_take(l_ids[0], &l_resume) && dap_enc_ks_resume_take(l_ids[1], &l_resume)
+               && dap_enc_ks_resume_take(l_ids[2], &l_resume), "The oldest ticket is dropped over the limit");
+    dap_enc_ks_resume_set_count_max(0);
+}
+
+typedef struct test_request {
+    dap_http_simple_t *simple;
+    dap_http_client_t *http;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool done;
+    int ret;
+} test_request_t;
+
+typedef struct test_storm {
+    char query[256];
+    char *body_b64;
+    volatile bool stop;
+    atomic_int in_flight;
+    int queued, shed;
+} test_storm_t;
+
+static test_storm_t s_storm = { };
+static dap_http_url_proc_t s_storm_proc = { };
+
+// Regular request, resumed handshake is cheap and always processed in place
+static bool s_request_callback(void *a_arg)
+{
+    test_request_t *l_request = a_arg;
+    test_session_t l_session = { };
+    int l_ret = s_handshake_resume(l_request->simple, l_request->http, &l_session);
+    if (!l_ret && !s_session_check(&l_session))
+        l_ret = -5;
+    s_session_free(&l_session);
+    pthread_mutex_lock(&l_request->mutex);
+    l_request->ret = l_ret;
+    l_request->done = true;
+    pthread_cond_signal(&l_request->cond);
+    pthread_mutex_unlock(&l_request->mutex);
+    return false;
+}
+
+// Average latency of regular requests passed through the worker proc thread queue, the same way as HTTP simple does
+static dap_nanotime_t s_request_latency(dap_http_simple_t *a_simple, dap_http_client_t *a_http, dap_worker_t *a_worker)
+{
+    test_request_t l_request = { .simple = a_simple, .http = a_http,
+                                 .mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+    dap_nanotime_t l_total = 0;
+    for (int i = 0; i < REQUESTS_COUNT && !l_request.ret; i++) {
+        dap_nanotime_t l_start = dap_nanotime_now();
+        pthread_mutex_lock(&l_request.mutex);
+        l_request.done = false;
+        dap_proc_thread_callback_add(a_worker->proc_queue_input, s_request_callback, &l_request);
+        while (!l_request.done)
+            pthread_cond_wait(&l_request.cond, &l_request.mutex);
+        pthread_mutex_unlock(&l_request.mutex);
+        l_total += dap_nanotime_now() - l_start;
+    }
+    pthread_mutex_destroy(&l_request.mutex);
+    pthread_cond_destroy(&l_request.cond);
+    dap_assert_PIF(!l_request.ret, "Regular requests");
+    return l_total / REQUESTS_COUNT;
+}
+
+static bool s_storm_callback(void *a_arg)
+{
+    dap_http_simple_t *l_simple = a_arg;
+    test_storm_t *l_storm = &s_storm;
+    http_status_code_t l_code = Http_Status_OK;
+    enc_http_proc(l_simple, &l_code);
+    if (l_simple->reply_deferred)
+        l_storm->queued++;
+    else {
+        if (l_code == Http_Status_ServiceUnavailable)
+            l_storm->shed++;
+        DAP_DEL_MULTY(l_simple->request, l_simple->reply, l_simple->http_client, l_simple);
+    }
+    atomic_fetch_sub(&l_storm->in_flight, 1);
+    return false;
+}
+
+// Handshakes flood through the worker proc thread queue, the replies are sent to non existent esocket
+// so HTTP simple frees the deferred requests itself
+static void *s_handshakes_storm(void *a_arg)
+{
+    test_storm_t *l_storm = a_arg;
+    dap_worker_t *l_worker = dap_events_worker_get(0);
+    while (!l_storm->stop) {
+        if (atomic_load(&l_storm->in_flight) >= STORM_IN_FLIGHT_MAX) {
+            dap_usleep(100);
+            continue;
+        }
+        dap_http_client_t *l_http = DAP_NEW_Z(dap_http_client_t);
+        dap_http_simple_t *l_simple = DAP_NEW_Z(dap_http_simple_t);
+        *l_simple = (dap_http_simple_t) {
+            .worker = l_worker, .esocket_uuid = UINT64_MAX, .http_client = l_http, .reply_size_max = REPLY_SIZE_MAX,
+            .reply = DAP_NEW_Z_SIZE(char, REPLY_SIZE_MAX + 1),
+            .request = dap_strdup(l_storm->body_b64), .request_size = strlen(l_storm->body_b64)
+        };
+        l_http->proc = &s_storm_proc;
+        dap_strncpy(l_http->url_path, "gd4y5yh78w42aaagh", sizeof(l_http->url_path));
+        dap_strncpy(l_http->in_query_string, l_storm->query, sizeof(l_http->in_query_string));
+        atomic_fetch_add(&l_storm->in_flight, 1);
+        dap_proc_thread_callback_add(l_worker->proc_queue_input, s_storm_callback, l_simple);
+    }
+    return NULL;
+}
+
+static dap_nanotime_t s_storm_latency(test_storm_t *a_storm, dap_http_simple_t *a_simple, dap_http_client_t *a_http, dap_worker_t *a_worker)
+{
+    a_storm->stop = false;
+    a_storm->queued = a_storm->shed = 0;
+    pthread_t l_storm_thread;
+    pthread_create(&l_storm_thread, NULL, s_handshakes_storm, a_storm);
+    while (atomic_load(&a_storm->in_flight) < STORM_IN_FLIGHT_MAX && !a_storm->queued)
+        dap_usleep(100);
+    dap_nanotime_t l_ret = s_request_latency(a_simple, a_http, a_worker);
+    a_storm->stop = true;
+    pthread_join(l_storm_thread, NULL);
+    while (atomic_load(&a_storm->in_flight) || dap_enc_http_get_crypto_queue_size())
+        dap_usleep(1000);
+    dap_usleep(100000); // Replies are freed on the worker
+    return l_ret;
+}
+
+static void s_crypto_pool_test(dap_http_simple_t *a_simple, dap_http_client_t *a_http, dap_cert_t *a_cert)
+{
+    dap_print_module_name("dap_enc_http crypto pool");
+    dap_assert_PIF(!dap_events_init(1, 60) && !dap_events_start(), "Events start");
+    dap_worker_t *l_worker = dap_events_worker_get(0);
+    test_session_t l_session = { };
+    dap_assert_PIF(!s_handshake_full(a_simple, a_http, a_cert, &l_session) && s_resume_id, "Resumption ticket");
+    s_session_free(&l_session);
+    dap_nanotime_t l_idle_latency = s_request_latency(a_simple, a_http, l_worker);
+
+    test_storm_t *l_storm = &s_storm;
+    dap_enc_key_t *l_kex = dap_enc_key_new_generate(DAP_ENC_KEY_TYPE_KEM_KYBER512, NULL, 0, NULL, 0, 32);
+    dap_sign_t *l_sign = dap_sign_create(a_cert->enc_key, l_kex->pub_key_data, l_kex->pub_key_data_size);
+    size_t l_sign_size = dap_sign_get_size(l_sign), l_body_size = l_kex->pub_key_data_size + l_sign_size;
+    byte_t *l_body = DAP_NEW_Z_SIZE(byte_t, l_body_size);
+    memcpy(l_body, l_kex->pub_key_data, l_kex->pub_key_data_size);
+    memcpy(l_body + l_kex->pub_key_data_size, l_sign, l_sign_size);
+    l_storm->body_b64 = DAP_NEW_Z_SIZE(char, DAP_ENC_BASE64_ENCODE_SIZE(l_body_size) + 1);
+    dap_enc_base64_encode(l_body, l_body_size, l_storm->body_b64, DAP_ENC_DATA_TYPE_B64);
+    snprintf(l_storm->query, sizeof(l_storm->query), "enc_type=%d,pkey_exchange_type=%d,pkey_exchange_size=%zu,block_key_size=32,protocol_version=%d,sign_count=1",
+             DAP_ENC_KEY_TYPE_SALSA2012, DAP_ENC_KEY_TYPE_KEM_KYBER512, l_kex->pub_key_data_size, DAP_PROTOCOL_VERSION);
+    DAP_DEL_MULTY(l_body, l_sign);
+    dap_enc_key_delete(l_kex);
+
+    // Handshakes are processed in place, regular requests wait for them in the proc thread queue
+    dap_nanotime_t l_in_place_latency = s_storm_latency(l_storm, a_simple, a_http, l_worker);
+    dap_enc_http_set_crypto_pool(1, STORM_QUEUE_MAX);
+    dap_nanotime_t l_pool_latency = s_storm_latency(l_storm, a_simple, a_http, l_worker);
+
+    dap_test_msg("Requests latency idle %"DAP_UINT64_FORMAT_U" us, under handshakes storm in place %"DAP_UINT64_FORMAT_U
+                 " us, with crypto pool %"DAP_UINT64_FORMAT_U" us, handshakes queued %d, shed %d",
+                 l_idle_latency / 1000, l_in_place_latency / 1000, l_pool_latency / 1000, l_storm->queued, l_storm->shed);
+    dap_assert(l_storm->queued && l_storm->shed, "Handshakes over the queue limit are shed");
+    dap_assert(l_pool_latency * 4 < l_in_place_latency, "Crypto pool cuts requests latency under handshakes storm");
+    dap_assert(l_pool_latency < dap_max(l_idle_latency * 4, (dap_nanotime_t)2000000), "Requests latency is stable under handshakes storm");
+    DAP_DELETE(l_storm->body_b64);
+    enc_http_deinit();
+}
+
+void dap_enc_http_test_run(void)
+{
+    dap_print_module_name("dap_enc_http session resumption");
+    dap_enc_init();
+    enc_http_init();
+    dap_enc_http_set_crypto_pool(0, 0);
+    dap_cert_t *l_cert = dap_cert_generate_mem(DAP_STREAM_NODE_ADDR_CERT_NAME, DAP_STREAM_NODE_ADDR_CERT_TYPE);
+    dap_assert_PIF(l_cert && !dap_cert_add(l_cert), "Node certificate");
+    dap_http_client_t l_http = { };
+    dap_http_simple_t l_simple = { .http_client = &l_http, .reply_size_max = REPLY_SIZE_MAX };
+    l_simple.reply = DAP_NEW_Z_SIZE(char, REPLY_SIZE_MAX + 1);
+    s_handshakes_benchmark(&l_simple, &l_http, l_cert);
+    s_resume_reject_test(&l_simple, &l_http);
+    s_crypto_pool_test(&l_simple, &l_http, l_cert);
+    DAP_DEL_MULTY(l_simple.reply, s_resume_id);
+    dap_enc_ks_deinit();
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "dap_test.h"
+
+void dap_enc_http_test_run(void);
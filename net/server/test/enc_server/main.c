@@ -1,7 +1,9 @@
 #include "dap_common.h"
+#include "dap_enc_http_test.h"
 
 int main(void) {
     // switch off debug info from library
     dap_log_level_set(L_CRITICAL);
+    dap_enc_http_test_run();
     return 0;
 }
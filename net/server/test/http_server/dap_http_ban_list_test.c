@@ -0,0 +1,162 @@
+#include <sys/socket.h>
+#include <unistd.h>
+#include "dap_http_ban_list_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_http_ban_list_client.h"
+#include "json_object.h"
+
+#define TEST_BANS_COUNT         10000
+#define TEST_LOOKUPS            2000000
+#define TEST_FLOOD_CONNECTIONS  2000
+
+static dap_hash_fast_t s_hash(uint8_t a_byte)
+{
+    dap_hash_fast_t l_hash = { };
+    l_hash.raw[0] = a_byte;
+    return l_hash;
+}
+
+static uint8_t s_check(const char *a_addr)
+{
+    dap_hash_fast_t l_hash = { };
+    return dap_http_ban_list_client_check(a_addr, &l_hash, NULL) ? l_hash.raw[0] : 0;
+}
+
+static void s_prefix_test()
+{
+    dap_assert_PIF(!dap_http_ban_list_client_add("10.0.0.0/8", s_hash(1), 0)
+                   && !dap_http_ban_list_client_add("10.1.0.0/16", s_hash(2), 0)
+                   && !dap_http_ban_list_client_add("10.1.2.3", s_hash(3), 0)
+                   && !dap_http_ban_list_client_add("2001:db8::/32", s_hash(4), 0)
+                   && !dap_http_ban_list_client_add("2001:db8:1::1", s_hash(5), 0), "Bans are added");
+    dap_assert_PIF(dap_http_ban_list_client_add("10.0.0.0/8", s_hash(6), 0) == -1, "Same subnet can't be added twice");
+    // Host bits of subnet are ignored
+    dap_assert_PIF(dap_http_ban_list_client_add("10.255.0.1/8", s_hash(6), 0) == -1, "Subnet is normalized");
+    dap_assert_PIF(dap_http_ban_list_client_add("10.0.0.0/33", s_hash(6), 0) && dap_http_ban_list_client_add("10.0.0.0/x", s_hash(6), 0)
+                   && dap_http_ban_list_client_add("", s_hash(6), 0), "Invalid subnets are rejected");
+
+    dap_assert_PIF(s_check("10.200.1.1") == 1 && s_check("10.1.200.1") == 2 && s_check("10.1.2.3") == 3 && !s_check("11.0.0.1"),
+                   "IPv4 longest prefix match");
+    dap_assert_PIF(s_check("2001:db8:ffff::1") == 4 && s_check("2001:db8:1::1") == 5 && !s_check("2001:db9::1"),
+                   "IPv6 longest prefix match");
+    dap_assert_PIF(s_check("::ffff:10.1.2.3") == 3, "IPv4-mapped IPv6 address");
+
+    struct sockaddr_storage l_addr = { };
+    struct sockaddr_in6 *l_addr6 = (struct sockaddr_in6 *)&l_addr;
+    l_addr6->sin6_family = AF_INET6;
+    inet_pton(AF_INET6, "::ffff:10.9.9.9", &l_addr6->sin6_addr);
+    dap_assert_PIF(dap_http_ban_list_client_check_sockaddr(&l_addr, NULL, NULL), "Socket address of dual-stack listener");
+
+    dap_assert_PIF(!dap_http_ban_list_client_remove("10.1.0.0/16") && s_check("10.1.200.1") == 1 && s_check("10.1.2.3") == 3,
+                   "Subnet is removed");
+    dap_assert_PIF(!dap_http_ban_list_client_remove("10.0.0.0/8") && !s_check("10.1.200.1") && s_check("10.1.2.3") == 3
+                   && !dap_http_ban_list_client_remove("10.1.2.3") && !s_check("10.1.2.3"), "All IPv4 bans are removed");
+    dap_http_ban_list_client_remove("2001:db8::/32");
+    dap_http_ban_list_client_remove("2001:db8:1::1");
+
+    // Expired ban doesn't match and may be added again
+    dap_assert_PIF(!dap_http_ban_list_client_add_ex("192.168.0.0/16", s_hash(7), 0, dap_time_now() - 1)
+                   && !s_check("192.168.1.1"), "Expired ban");
+    dap_assert_PIF(!dap_http_ban_list_client_add_ex("192.168.0.0/16", s_hash(8), 0, dap_time_now() + 3600)
+                   && s_check("192.168.1.1") == 8, "Ban with expiry");
+    dap_http_ban_list_client_remove("192.168.0.0/16");
+    dap_pass_msg("CIDR bans");
+}
+
+static void s_node_addr_test()
+{
+    // Node addresses aren't IP ones, they are matched as strings
+    const char *l_node_addr = "0A1B::2C3D::4E5F::6071";
+    dap_assert_PIF(!dap_http_ban_list_client_add(l_node_addr, s_hash(10), 0) && s_check(l_node_addr) == 10
+                   && !s_check("0A1B::2C3D::4E5F::6072"), "Node address is banned");
+    dap_assert_PIF(dap_http_ban_list_client_add(l_node_addr, s_hash(11), 0) == -1, "Node address can't be banned twice");
+    json_object *l_dump = dap_http_ban_list_client_dump(l_node_addr);
+    json_object *l_hash = NULL;
+    dap_assert_PIF(json_object_object_get_ex(l_dump, "decree_hash", &l_hash), "Node address ban is dumped");
+    json_object_put(l_dump);
+    dap_assert_PIF(!dap_http_ban_list_client_remove(l_node_addr) && !s_check(l_node_addr), "Node address ban is removed");
+    dap_assert_PIF(!dap_http_ban_list_client_add_ex(l_node_addr, s_hash(12), 0, dap_time_now() - 1) && !s_check(l_node_addr),
+                   "Expired node address ban");
+    dap_http_ban_list_client_remove(l_node_addr);
+    dap_pass_msg("Node address bans");
+}
+
+static void s_lookup_benchmark()
+{
+    char l_addr[64];
+    for (int i = 0; i < TEST_BANS_COUNT; i++) {
+        snprintf(l_addr, sizeof(l_addr), "%d.%d.%d.0/24", 20 + i / 65536, (i / 256) % 256, i % 256);
+        dap_http_ban_list_client_add(l_addr, s_hash(9), 0);
+    }
+    struct sockaddr_storage l_sa = { };
+    struct sockaddr_in *l_sa4 = (struct sockaddr_in *)&l_sa;
+    l_sa4->sin_family = AF_INET;
+    int l_found = 0, l_start = get_cur_time_msec();
+    for (int i = 0; i < TEST_LOOKUPS; i++) {
+        l_sa4->sin_addr.s_addr = htonl((20u << 24) + ((uint32_t)i * 2654435761u) % (2 * TEST_BANS_COUNT * 256));
+        l_found += dap_http_ban_list_client_check_sockaddr(&l_sa, NULL, NULL);
+    }
+    int l_time = get_cur_time_msec() - l_start;
+    dap_assert_PIF(l_found > TEST_LOOKUPS / 3 && l_found < TEST_LOOKUPS * 2 / 3, "Half of addresses are banned");
+    dap_test_msg("%d subnets banned, %.0f lookups/s", TEST_BANS_COUNT, TEST_LOOKUPS / (dap_max(l_time, 1) / 1000.0));
+    for (int i = 0; i < TEST_BANS_COUNT; i++) {
+        snprintf(l_addr, sizeof(l_addr), "%d.%d.%d.0/24", 20 + i / 65536, (i / 256) % 256, i % 256);
+        dap_http_ban_list_client_remove(l_addr);
+    }
+}
+
+// Connects and sends a request, returns true if the server closed connection without any reply
+static bool s_flood_connection(bool *a_replied)
+{
+    const char l_request[] = "GET /banned HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    int l_sock = dap_http_test_connect();
+    if (l_sock < 0)
+        return false;
+    send(l_sock, l_request, sizeof(l_request) - 1, MSG_NOSIGNAL);
+    char l_buf[256];
+    ssize_t l_read = recv(l_sock, l_buf, sizeof(l_buf), 0);
+    close(l_sock);
+    *a_replied = l_read > 0;
+    return l_read <= 0;
+}
+
+static void s_flood_benchmark()
+{
+    bool l_replied = false;
+    // Not banned yet, server replies
+    s_flood_connection(&l_replied);
+    dap_assert_PIF(l_replied, "Connection is served before the ban");
+
+    double l_ms[2], l_server_us[2];
+    for (int l_banned = 0; l_banned < 2; l_banned++) {
+        if (l_banned)
+            dap_assert_PIF(!dap_http_ban_list_client_add("127.0.0.0/8", s_hash(10), 0), "Loopback subnet is banned");
+        int l_dropped = 0;
+        double l_wall = dap_http_test_time_sec(CLOCK_MONOTONIC), l_process = dap_http_test_time_sec(CLOCK_PROCESS_CPUTIME_ID),
+               l_client = dap_http_test_time_sec(CLOCK_THREAD_CPUTIME_ID);
+        for (int i = 0; i < TEST_FLOOD_CONNECTIONS; i++)
+            l_dropped += s_flood_connection(&l_replied) && !l_replied;
+        l_client = dap_http_test_time_sec(CLOCK_THREAD_CPUTIME_ID) - l_client;
+        l_process = dap_http_test_time_sec(CLOCK_PROCESS_CPUTIME_ID) - l_process;
+        l_ms[l_banned] = (dap_http_test_time_sec(CLOCK_MONOTONIC) - l_wall) * 1000 / TEST_FLOOD_CONNECTIONS;
+        l_server_us[l_banned] = (l_process - l_client) * 1e6 / TEST_FLOOD_CONNECTIONS;
+        dap_assert_PIF(l_banned ? l_dropped == TEST_FLOOD_CONNECTIONS : !l_dropped,
+                       l_banned ? "All connections from banned subnet are dropped" : "All connections are served");
+    }
+    dap_http_ban_list_client_remove("127.0.0.0/8");
+    s_flood_connection(&l_replied);
+    dap_assert_PIF(l_replied, "Connection is served after the ban is removed");
+    dap_test_msg("%d connections: served %.3f ms, %.1f us server CPU each; banned %.3f ms, %.1f us server CPU each",
+                 TEST_FLOOD_CONNECTIONS, l_ms[0], l_server_us[0], l_ms[1], l_server_us[1]);
+    dap_pass_msg("Connection flood from banned subnet");
+}
+
+void dap_http_ban_list_test_run(void)
+{
+    dap_print_module_name("dap_http_ban_list_client");
+    s_prefix_test();
+    s_node_addr_test();
+    s_lookup_benchmark();
+    s_flood_benchmark();
+}
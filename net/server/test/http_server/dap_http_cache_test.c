@@ -0,0 +1,166 @@
+#include "dap_http_cache_test.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_http_server.h"
+#include "dap_http_cache.h"
+#include "http_status_code.h"
+
+#define TEST_BUDGET         (1024 * 1024)
+#define TEST_URLS_COUNT     20000
+#define TEST_BODY_SIZE      1024
+
+static dap_http_url_proc_t s_proc = { .url = "/api" };
+
+static void s_client_init(dap_http_client_t *a_client, const char *a_action, const char *a_path, const char *a_query)
+{
+    memset(a_client, 0, sizeof(*a_client));
+    dap_strncpy(a_client->action, a_action, sizeof(a_client->action));
+    dap_strncpy(a_client->url_path, a_path, sizeof(a_client->url_path));
+    dap_strncpy(a_client->in_query_string, a_query, sizeof(a_client->in_query_string));
+    dap_strncpy(a_client->out_content_type, "application/json", sizeof(a_client->out_content_type));
+    a_client->proc = &s_proc;
+}
+
+static void s_client_clear(dap_http_client_t *a_client)
+{
+    while (a_client->in_headers)
+        dap_http_header_remove(&a_client->in_headers, a_client->in_headers);
+    while (a_client->out_headers)
+        dap_http_header_remove(&a_client->out_headers, a_client->out_headers);
+    dap_http_cache_release(a_client->out_cache);
+    a_client->out_cache = NULL;
+}
+
+static void s_etag_test()
+{
+    dap_http_client_t l_client;
+    const char l_body[] = "{\"status\":\"ok\"}", l_body2[] = "{\"status\":\"fail\"}";
+    s_client_init(&l_client, "GET", "status", "net=main");
+    dap_http_cache_t *l_cache = dap_http_cache_update(&l_client, (const byte_t *)l_body, sizeof(l_body) - 1, NULL, NULL, Http_Status_OK, 0);
+    dap_assert_PIF(l_cache && strlen(l_cache->etag) == DAP_HTTP_CACHE_ETAG_SIZE - 1 && l_cache->etag[0] == '"', "Strong ETag is made");
+    char l_etag[DAP_HTTP_CACHE_ETAG_SIZE];
+    dap_strncpy(l_etag, l_cache->etag, sizeof(l_etag));
+
+    l_client.out_cache = dap_http_cache_find(&l_client);
+    dap_assert_PIF(l_client.out_cache == l_cache, "Reply is found by method, path and query");
+    dap_http_cache_release(l_cache);
+    dap_http_cache_reply_prepare(&l_client);
+    dap_http_header_t *l_hdr = dap_http_header_find(l_client.out_headers, "ETag");
+    dap_assert_PIF(l_client.reply_status_code == Http_Status_OK && l_client.out_content_length == sizeof(l_body) - 1
+                   && l_hdr && !strcmp(l_hdr->value, l_etag), "Cached reply with ETag");
+    s_client_clear(&l_client);
+
+    char l_list[128];
+    snprintf(l_list, sizeof(l_list), "\"0000\", W/%s", l_etag);
+    dap_http_header_add(&l_client.in_headers, "If-None-Match", l_list);
+    l_client.out_cache = dap_http_cache_find(&l_client);
+    dap_http_cache_reply_prepare(&l_client);
+    dap_assert_PIF(l_client.reply_status_code == Http_Status_NotModified && !l_client.out_content_length, "If-None-Match gives 304");
+    s_client_clear(&l_client);
+
+    dap_http_header_add(&l_client.in_headers, "If-None-Match", "\"0000\"");
+    l_client.out_cache = dap_http_cache_find(&l_client);
+    dap_http_cache_reply_prepare(&l_client);
+    dap_assert_PIF(l_client.reply_status_code == Http_Status_OK, "Other ETag gives full reply");
+    s_client_clear(&l_client);
+
+    s_client_init(&l_client, "GET", "status", "net=backup");
+    l_cache = dap_http_cache_update(&l_client, (const byte_t *)l_body, sizeof(l_body) - 1, NULL, NULL, Http_Status_OK, 0);
+    dap_assert_PIF(!strcmp(l_cache->etag, l_etag), "Same body has same ETag");
+    dap_http_cache_release(l_cache);
+    s_client_init(&l_client, "GET", "status", "net=main");
+    l_cache = dap_http_cache_update(&l_client, (const byte_t *)l_body2, sizeof(l_body2) - 1, NULL, NULL, Http_Status_OK, 0);
+    dap_assert_PIF(strcmp(l_cache->etag, l_etag) && dap_http_cache_get_count() == 2, "Changed body replaces reply with new ETag");
+
+    // Reply returned by update stays valid after the table drops it
+    dap_http_cache_invalidate(NULL);
+    dap_assert_PIF(!dap_http_cache_get_count() && l_cache->refs == 1 && strcmp(l_cache->etag, l_etag), "Updated reply is referenced");
+    dap_http_cache_release(l_cache);
+    dap_http_cache_release(dap_http_cache_update(&l_client, (const byte_t *)l_body2, sizeof(l_body2) - 1, NULL, NULL, Http_Status_OK, 0));
+    s_client_init(&l_client, "GET", "status", "net=backup");
+    dap_http_cache_release(dap_http_cache_update(&l_client, (const byte_t *)l_body, sizeof(l_body) - 1, NULL, NULL, Http_Status_OK, 0));
+
+    s_client_init(&l_client, "POST", "status", "net=main");
+    dap_assert_PIF(!dap_http_cache_update(&l_client, (const byte_t *)l_body, sizeof(l_body) - 1, NULL, NULL, Http_Status_OK, 0)
+                   && !dap_http_cache_find(&l_client), "Only GET replies are cached");
+
+    s_client_init(&l_client, "GET", "status", "net=old");
+    dap_http_cache_release(dap_http_cache_update(&l_client, (const byte_t *)l_body, sizeof(l_body) - 1, NULL, NULL, Http_Status_OK,
+                                                 time(NULL) - 1));
+    dap_assert_PIF(!dap_http_cache_find(&l_client) && dap_http_cache_get_count() == 2, "Expired reply is dropped");
+
+    dap_http_cache_set_proc_ttl(&s_proc, 0);
+    dap_assert_PIF(!dap_http_cache_get_count() && !dap_http_cache_get_size(), "Zero TTL drops replies of proc");
+    dap_pass_msg("ETag and If-None-Match");
+}
+
+static void s_lru_test()
+{
+    dap_http_cache_set_size_max(TEST_BUDGET);
+    byte_t *l_body = DAP_NEW_Z_SIZE(byte_t, TEST_BODY_SIZE);
+    dap_http_client_t l_client, l_hot;
+    s_client_init(&l_hot, "GET", "balance", "addr=hot");
+    dap_http_cache_release(dap_http_cache_update(&l_hot, l_body, TEST_BODY_SIZE, NULL, NULL, Http_Status_OK, 0));
+
+    // Reference taken before eviction must stay valid
+    s_client_init(&l_client, "GET", "balance", "addr=0");
+    dap_http_cache_release(dap_http_cache_update(&l_client, l_body, TEST_BODY_SIZE, NULL, NULL, Http_Status_OK, 0));
+    dap_http_cache_t *l_held = dap_http_cache_find(&l_client);
+
+    char l_query[64];
+    bool l_budget_ok = true, l_hot_ok = true;
+    int l_start = get_cur_time_msec();
+    for (int i = 1; i < TEST_URLS_COUNT; i++) {
+        snprintf(l_query, sizeof(l_query), "addr=%d", i);
+        s_client_init(&l_client, "GET", "balance", l_query);
+        memcpy(l_body, &i, sizeof(i));
+        dap_http_cache_release(dap_http_cache_update(&l_client, l_body, TEST_BODY_SIZE, NULL, NULL, Http_Status_OK, 0));
+        l_budget_ok &= dap_http_cache_get_size() <= TEST_BUDGET;
+        if (i % 16 == 0) {
+            dap_http_cache_t *l_cache = dap_http_cache_find(&l_hot);
+            l_hot_ok &= l_cache != NULL;
+            dap_http_cache_release(l_cache);
+        }
+    }
+    int l_updates_time = get_cur_time_msec() - l_start;
+    size_t l_count = dap_http_cache_get_count();
+    dap_assert_PIF(l_budget_ok, "Memory budget is kept");
+    dap_assert_PIF(l_hot_ok, "Frequently used reply is not evicted");
+    dap_assert_PIF(l_count > TEST_BUDGET / (TEST_BODY_SIZE * 2) && l_count < TEST_BUDGET / TEST_BODY_SIZE, "Budget is filled");
+    dap_assert_PIF(l_held->body_size == TEST_BODY_SIZE && !l_held->linked, "Evicted reply is alive while referenced");
+    dap_http_cache_release(l_held);
+
+    // Most recent replies are kept, the oldest ones are evicted
+    int l_found_recent = 0, l_found_old = 0;
+    l_start = get_cur_time_msec();
+    for (int i = 1; i < TEST_URLS_COUNT; i++) {
+        snprintf(l_query, sizeof(l_query), "addr=%d", i);
+        s_client_init(&l_client, "GET", "balance", l_query);
+        dap_http_cache_t *l_cache = dap_http_cache_find(&l_client);
+        if (l_cache) {
+            if (i >= TEST_URLS_COUNT - (int)l_count + 1)
+                l_found_recent++;
+            else
+                l_found_old++;
+            dap_assert_PIF(!memcmp(l_cache->body, &i, sizeof(i)), "Reply body matches its URL");
+            dap_http_cache_release(l_cache);
+        }
+    }
+    int l_lookups_time = get_cur_time_msec() - l_start;
+    dap_assert_PIF(l_found_recent == (int)l_count - 1 && !l_found_old, "LRU eviction order");
+    dap_test_msg("%d URLs under %d KB budget: %zu replies kept (%zu bytes), %.0f updates/s, %.0f lookups/s",
+                 TEST_URLS_COUNT, TEST_BUDGET / 1024, l_count, dap_http_cache_get_size(),
+                 TEST_URLS_COUNT * 1000.0 / dap_max(l_updates_time, 1), TEST_URLS_COUNT * 1000.0 / dap_max(l_lookups_time, 1));
+
+    dap_http_cache_invalidate(NULL);
+    dap_assert_PIF(!dap_http_cache_get_count() && !dap_http_cache_get_size(), "Cache is empty after invalidation");
+    DAP_DELETE(l_body);
+    dap_pass_msg("LRU eviction under memory budget");
+}
+
+void dap_http_cache_test_run(void)
+{
+    dap_print_module_name("dap_http_cache");
+    s_etag_test();
+    s_lru_test();
+}
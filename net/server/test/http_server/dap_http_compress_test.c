@@ -0,0 +1,357 @@
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef DAP_HTTP_ZLIB
+#include <zlib.h>
+#endif
+#include "dap_http_compress_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_http_simple.h"
+#include "dap_http_folder.h"
+#include "dap_http_compress.h"
+#include "http_status_code.h"
+
+#ifdef DAP_HTTP_ZLIB
+
+#define TEST_MIN_SIZE           1024
+#define TEST_REPLY_SIZE_MAX     (4 * 1024 * 1024)
+#define TEST_BENCH_BYTES        (16 * 1024 * 1024)                          /* Processed by each benchmark run */
+#define TEST_STREAM_PIECES      64
+
+typedef struct test_payload {
+    const char *name;
+    size_t records;
+    char *data;
+    size_t size;
+} test_payload_t;
+
+static test_payload_t s_payloads[] = {
+    { .name = "small JSON-RPC reply", .records = 4 }, { .name = "ledger page", .records = 200 },
+    { .name = "ledger dump", .records = 4000 }
+};
+static test_payload_t *s_json = &s_payloads[1];
+
+// JSON-RPC reply with transaction records, hashes and addresses are random like the real ones
+static void s_payload_make(test_payload_t *a_payload)
+{
+    size_t l_size_max = 256 + a_payload->records * 512;
+    char *l_buf = DAP_NEW_Z_SIZE(char, l_size_max);
+    uint64_t l_rand = 0x9E3779B97F4A7C15ULL * (a_payload->records + 1);
+    size_t l_pos = snprintf(l_buf, l_size_max, "{\"jsonrpc\":\"2.0\",\"id\":%zu,\"result\":{\"net\":\"Backbone\",\"chain\":\"main\",\"txs\":[",
+                            a_payload->records);
+    for (size_t i = 0; i < a_payload->records; i++) {
+        char l_hash[65], l_addr[105];
+        for (size_t j = 0; j < 64; j++)
+            l_hash[j] = "0123456789ABCDEF"[(l_rand = l_rand * 6364136223846793005ULL + 1442695040888963407ULL) >> 60];
+        l_hash[64] = '\0';
+        for (size_t j = 0; j < 104; j++)
+            l_addr[j] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"[((l_rand = l_rand * 6364136223846793005ULL + 1) >> 33) % 58];
+        l_addr[104] = '\0';
+        l_pos += snprintf(l_buf + l_pos, l_size_max - l_pos,
+                          "%s{\"hash\":\"0x%s\",\"ts_created\":\"Mon, 14 Oct 2024 12:%02zu:%02zu\",\"status\":\"ACCEPTED\","
+                          "\"token\":\"CELL\",\"value\":\"%zu.%06zu\",\"fee\":\"0.05\",\"addr_to\":\"%s\",\"service\":\"transfer\","
+                          "\"action\":\"regular\",\"batching\":false}", i ? "," : "", l_hash, i / 60 % 60, i % 60,
+                          (size_t)(l_rand >> 50), (size_t)(l_rand % 1000000), l_addr);
+    }
+    l_pos += snprintf(l_buf + l_pos, l_size_max - l_pos, "]}}");
+    a_payload->data = l_buf;
+    a_payload->size = l_pos;
+}
+
+static byte_t *s_inflate(const byte_t *a_data, size_t a_size, size_t *a_out_size)
+{
+    z_stream l_zs = { };
+    if (inflateInit2(&l_zs, 15 + 32) != Z_OK)                               /* Both zlib and gzip formats */
+        return NULL;
+    size_t l_size_max = TEST_REPLY_SIZE_MAX;
+    byte_t *l_ret = DAP_NEW_SIZE(byte_t, l_size_max);
+    l_zs.next_in = (Bytef *)a_data;
+    l_zs.avail_in = a_size;
+    l_zs.next_out = l_ret;
+    l_zs.avail_out = l_size_max;
+    int l_rc = inflate(&l_zs, Z_FINISH);
+    *a_out_size = l_zs.total_out;
+    inflateEnd(&l_zs);
+    if (l_rc != Z_STREAM_END)
+        DAP_DEL_Z(l_ret);
+    return l_ret;
+}
+
+static void s_negotiation_test(void)
+{
+    dap_assert_PIF(dap_http_compress_accepted("gzip, deflate, br") == DAP_HTTP_ENCODING_GZIP
+                   && dap_http_compress_accepted("deflate") == DAP_HTTP_ENCODING_DEFLATE
+                   && dap_http_compress_accepted("gzip;q=0.5, deflate") == DAP_HTTP_ENCODING_DEFLATE
+                   && dap_http_compress_accepted("deflate;q=0.5,GZIP;q=0.8") == DAP_HTTP_ENCODING_GZIP
+                   && dap_http_compress_accepted("x-gzip") == DAP_HTTP_ENCODING_GZIP
+                   && dap_http_compress_accepted("*") == DAP_HTTP_ENCODING_GZIP
+                   && dap_http_compress_accepted("*;q=0.1, gzip;q=0") == DAP_HTTP_ENCODING_DEFLATE, "Accepted encodings");
+    dap_assert_PIF(dap_http_compress_accepted("br, zstd") == DAP_HTTP_ENCODING_IDENTITY
+                   && dap_http_compress_accepted("identity") == DAP_HTTP_ENCODING_IDENTITY
+                   && dap_http_compress_accepted("gzip;q=0, deflate;q=0.000") == DAP_HTTP_ENCODING_IDENTITY
+                   && dap_http_compress_accepted("") == DAP_HTTP_ENCODING_IDENTITY
+                   && dap_http_compress_accepted(NULL) == DAP_HTTP_ENCODING_IDENTITY, "Nothing supported is accepted");
+    dap_assert_PIF(dap_http_compress_type_allowed("application/json") && dap_http_compress_type_allowed("text/html; charset=utf-8")
+                   && dap_http_compress_type_allowed("image/svg+xml") && !dap_http_compress_type_allowed("image/png")
+                   && !dap_http_compress_type_allowed("application/octet-stream") && !dap_http_compress_type_allowed(NULL),
+                   "Compressible types");
+    dap_pass_msg("Encoding negotiation");
+}
+
+static void s_streaming_compressor_test(void)
+{
+    dap_http_compressor_t *l_compressor = dap_http_compressor_new(DAP_HTTP_ENCODING_GZIP);
+    dap_assert_PIF(l_compressor, "Compressor is created");
+    byte_t *l_out = DAP_NEW_SIZE(byte_t, s_json->size);
+    size_t l_out_size = 0, l_in_pos = 0, l_piece = s_json->size / 7 + 1;
+    bool l_ok = true;
+    // Small output room makes the compressor keep the flush pending between calls
+    while (l_ok && !dap_http_compressor_is_over(l_compressor)) {
+        if (dap_http_compressor_wants_input(l_compressor)) {
+            size_t l_size = dap_min(l_piece, s_json->size - l_in_pos);
+            dap_http_compressor_input(l_compressor, s_json->data + l_in_pos, l_size, !l_size);
+            l_in_pos += l_size;
+        }
+        ssize_t l_size = dap_http_compressor_output(l_compressor, l_out + l_out_size, dap_min((size_t)1000, s_json->size - l_out_size));
+        l_ok = l_size >= 0 && l_out_size + l_size < s_json->size;
+        l_out_size += l_size;
+    }
+    dap_http_compressor_delete(l_compressor);
+    size_t l_size = 0;
+    byte_t *l_plain = l_ok ? s_inflate(l_out, l_out_size, &l_size) : NULL;
+    dap_assert_PIF(l_plain && l_size == s_json->size && !memcmp(l_plain, s_json->data, l_size), "Streamed compression round trip");
+    DAP_DEL_MULTY(l_out, l_plain);
+    dap_pass_msg("Streaming compressor");
+}
+
+// CPU cost and ratio of the whole body compression, as it is done for simple replies and cached ones
+static void s_cost_benchmark(void)
+{
+    for (size_t i = 0; i < sizeof(s_payloads) / sizeof(s_payloads[0]); i++) {
+        test_payload_t *l_payload = &s_payloads[i];
+        int l_levels[] = { 1, 6 };
+        for (size_t j = 0; j < sizeof(l_levels) / sizeof(l_levels[0]); j++) {
+            dap_http_compress_set(true, 0, l_levels[j]);
+            size_t l_iterations = dap_max(TEST_BENCH_BYTES / l_payload->size / (j + 1), (size_t)1), l_size = 0;
+            struct timespec l_start, l_end;
+            clock_gettime(CLOCK_MONOTONIC, &l_start);
+            for (size_t k = 0; k < l_iterations; k++)
+                DAP_DELETE(dap_http_compress(DAP_HTTP_ENCODING_GZIP, l_payload->data, l_payload->size, &l_size));
+            clock_gettime(CLOCK_MONOTONIC, &l_end);
+            double l_us = ((l_end.tv_sec - l_start.tv_sec) * 1e6 + (l_end.tv_nsec - l_start.tv_nsec) / 1e3) / l_iterations;
+            dap_test_msg("%s %zu bytes, level %d: %zu bytes gzipped (%.1f%%), %.1f us per reply, %.0f MB/s",
+                         l_payload->name, l_payload->size, l_levels[j], l_size, l_size * 100.0 / l_payload->size, l_us,
+                         l_payload->size / l_us);
+            size_t l_plain_size = 0;
+            byte_t *l_packed = dap_http_compress(DAP_HTTP_ENCODING_GZIP, l_payload->data, l_payload->size, &l_size),
+                   *l_plain = s_inflate(l_packed, l_size, &l_plain_size);
+            dap_assert_PIF(l_plain && l_plain_size == l_payload->size && !memcmp(l_plain, l_payload->data, l_plain_size)
+                           && (l_payload != s_payloads || l_size < l_payload->size) && (l_payload == s_payloads || l_size < l_payload->size / 2),
+                           "Compressed JSON is smaller (less than half for bigger ones) and is decompressed back");
+            DAP_DEL_MULTY(l_packed, l_plain);
+        }
+    }
+}
+
+static void s_json_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    dap_strncpy(a_http_simple->reply_mime, "application/json", sizeof(a_http_simple->reply_mime));
+    if (!strcmp(a_http_simple->http_client->in_query_string, "small"))
+        dap_http_simple_reply(a_http_simple, s_payloads[0].data, TEST_MIN_SIZE / 2);
+    else
+        dap_http_simple_reply(a_http_simple, s_json->data, s_json->size);
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+static ssize_t s_stream_callback(dap_http_simple_t *a_http_simple, void *a_buf, size_t a_buf_size)
+{
+    size_t *l_position = a_http_simple->_inheritor;
+    size_t l_size = dap_min(dap_min(a_buf_size, s_json->size / TEST_STREAM_PIECES + 1), s_json->size - *l_position);
+    memcpy(a_buf, s_json->data + *l_position, l_size);
+    *l_position += l_size;
+    return l_size;
+}
+
+static void s_stream_proc_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    a_http_simple->_inheritor = DAP_NEW_Z(size_t);
+    dap_strncpy(a_http_simple->reply_mime, "application/json", sizeof(a_http_simple->reply_mime));
+    dap_http_simple_reply_stream(a_http_simple, s_stream_callback);
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+// One request over a new connection, the reply body is decoded
+static int s_request(const char *a_path, const char *a_headers, dap_http_test_reply_t *a_reply)
+{
+    char l_request[1024], l_value[64];
+    snprintf(l_request, sizeof(l_request), "GET %s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n%s\r\n",
+             a_path, a_headers ? a_headers : "");
+    int l_ret = dap_http_test_request(l_request, a_reply);
+    if (l_ret || !dap_http_test_reply_header(a_reply, "Content-Encoding", l_value, sizeof(l_value)))
+        return l_ret;
+    size_t l_size = 0;
+    byte_t *l_body = s_inflate(a_reply->body, a_reply->body_size, &l_size);
+    DAP_DELETE(a_reply->body);
+    a_reply->body = l_body;
+    a_reply->body_size = l_size;
+    return l_body ? 0 : -4;
+}
+
+static bool s_reply_is(dap_http_test_reply_t *a_reply, const char *a_encoding, const void *a_body, size_t a_body_size)
+{
+    char l_value[64];
+    const char *l_encoding = dap_http_test_reply_header(a_reply, "Content-Encoding", l_value, sizeof(l_value));
+    return a_reply->code == Http_Status_OK && (a_encoding ? l_encoding && !strcmp(l_encoding, a_encoding) : !l_encoding)
+            && a_reply->body_size == a_body_size && !memcmp(a_reply->body, a_body, a_body_size);
+}
+
+static void s_simple_test(void)
+{
+    dap_http_server_t *l_http = dap_http_test_server();
+    dap_http_url_proc_t *l_cached;
+    dap_assert_PIF(dap_http_simple_proc_add(l_http, "/cz/json", TEST_REPLY_SIZE_MAX, s_json_callback)
+                   && dap_http_simple_proc_add(l_http, "/cz/stream", 1024, s_stream_proc_callback)
+                   && (l_cached = dap_http_simple_proc_add(l_http, "/cz/cached", TEST_REPLY_SIZE_MAX, s_json_callback)), "Procs are added");
+    dap_http_cache_set_proc_ttl(l_cached, 60);
+    dap_http_test_reply_t l_plain, l_gzip, l_reply;
+    char l_value[64], l_etag[64];
+
+    dap_assert_PIF(!s_request("/cz/json", NULL, &l_plain) && s_reply_is(&l_plain, NULL, s_json->data, s_json->size)
+                   && dap_http_test_reply_header(&l_plain, "Vary", l_value, sizeof(l_value)), "Identity reply without Accept-Encoding");
+    dap_assert_PIF(!s_request("/cz/json", "Accept-Encoding: gzip, deflate\r\n", &l_gzip)
+                   && s_reply_is(&l_gzip, "gzip", s_json->data, s_json->size)
+                   && !strcmp(dap_http_test_reply_header(&l_gzip, "Vary", l_value, sizeof(l_value)) ?: "", "Accept-Encoding"), "Gzipped reply");
+    dap_test_msg("Simple reply %zu bytes: %zu bytes on the wire, %zu gzipped", s_json->size, l_plain.wire_size, l_gzip.wire_size);
+    dap_assert_PIF(l_gzip.wire_size < l_plain.wire_size / 2, "Less bytes on the wire");
+    DAP_DEL_MULTY(l_plain.body, l_gzip.body);
+
+    dap_assert_PIF(!s_request("/cz/json", "Accept-Encoding: deflate\r\n", &l_reply)
+                   && s_reply_is(&l_reply, "deflate", s_json->data, s_json->size), "Deflated reply");
+    DAP_DEL_Z(l_reply.body);
+    dap_assert_PIF(!s_request("/cz/json?small", "Accept-Encoding: gzip\r\n", &l_reply)
+                   && s_reply_is(&l_reply, NULL, s_payloads[0].data, TEST_MIN_SIZE / 2), "Small reply is sent as is");
+    DAP_DEL_Z(l_reply.body);
+
+    dap_assert_PIF(!s_request("/cz/stream", "Accept-Encoding: gzip\r\n", &l_gzip) && s_reply_is(&l_gzip, "gzip", s_json->data, s_json->size)
+                   && !s_request("/cz/stream", NULL, &l_plain) && s_reply_is(&l_plain, NULL, s_json->data, s_json->size),
+                   "Streamed chunked reply");
+    dap_test_msg("Streamed reply in %d pieces: %zu bytes on the wire, %zu gzipped", TEST_STREAM_PIECES, l_plain.wire_size, l_gzip.wire_size);
+    dap_assert_PIF(l_gzip.wire_size < l_plain.wire_size / 2, "Less bytes on the wire");
+    DAP_DEL_MULTY(l_plain.body, l_gzip.body);
+
+    // The first reply makes the cache, compressed variant of it is sent then
+    dap_assert_PIF(!s_request("/cz/cached", "Accept-Encoding: gzip\r\n", &l_reply) && s_reply_is(&l_reply, NULL, s_json->data, s_json->size)
+                   && dap_http_test_reply_header(&l_reply, "ETag", l_etag, sizeof(l_etag)), "Reply is cached");
+    DAP_DEL_Z(l_reply.body);
+    dap_assert_PIF(!s_request("/cz/cached", "Accept-Encoding: gzip\r\n", &l_gzip) && s_reply_is(&l_gzip, "gzip", s_json->data, s_json->size)
+                   && dap_http_test_reply_header(&l_gzip, "ETag", l_value, sizeof(l_value)) && strcmp(l_value, l_etag)
+                   && dap_http_test_reply_header(&l_gzip, "Vary", l_value, sizeof(l_value)), "Cached reply is gzipped with its own tag");
+    dap_assert_PIF(!s_request("/cz/cached", NULL, &l_plain) && s_reply_is(&l_plain, NULL, s_json->data, s_json->size)
+                   && !strcmp(dap_http_test_reply_header(&l_plain, "ETag", l_value, sizeof(l_value)) ?: "", l_etag), "Cached reply for identity");
+    DAP_DEL_MULTY(l_plain.body, l_gzip.body);
+    dap_pass_msg("Simple replies");
+}
+
+static void s_folder_test(void)
+{
+    char l_dir[128], l_path[192];
+    snprintf(l_dir, sizeof(l_dir), "%s/cz", dap_http_test_server_dir());
+    mkdir(l_dir, 0700);
+    snprintf(l_path, sizeof(l_path), "%s/ledger.json", l_dir);
+    FILE *l_file = fopen(l_path, "wb");
+    fwrite(s_json->data, 1, s_json->size, l_file);
+    fclose(l_file);
+    snprintf(l_path, sizeof(l_path), "%s/reply.json", l_dir);
+    l_file = fopen(l_path, "wb");
+    fwrite(s_payloads[0].data, 1, s_payloads[0].size, l_file);
+    fclose(l_file);
+    snprintf(l_path, sizeof(l_path), "%s/ledger.png", l_dir);
+    l_file = fopen(l_path, "wb");
+    fwrite(s_json->data, 1, s_json->size, l_file);
+    fclose(l_file);
+    dap_assert_PIF(!dap_http_folder_add(dap_http_test_server(), "/czfiles", l_dir), "Folder is added");
+
+    dap_http_test_reply_t l_plain, l_gzip, l_reply;
+    char l_value[64];
+    size_t l_count = dap_http_folder_get_gzip_cache_count();
+    dap_assert_PIF(!s_request("/czfiles/ledger.json", NULL, &l_plain) && s_reply_is(&l_plain, NULL, s_json->data, s_json->size)
+                   && !strcmp(dap_http_test_reply_header(&l_plain, "Content-Type", l_value, sizeof(l_value)) ?: "", "application/json"),
+                   "Identity file");
+    dap_assert_PIF(dap_http_test_reply_header(&l_plain, "Accept-Ranges", l_value, sizeof(l_value)), "Identity file accepts ranges");
+    // Bigger file is compressed by proc thread, it's sent as is till then
+    dap_assert_PIF(!s_request("/czfiles/ledger.json", "Accept-Encoding: gzip\r\n", &l_reply)
+                   && s_reply_is(&l_reply, NULL, s_json->data, s_json->size)
+                   && dap_http_test_reply_header(&l_reply, "Vary", l_value, sizeof(l_value)), "Identity file while it's compressed");
+    DAP_DEL_Z(l_reply.body);
+    for (int i = 0; i < 100 && dap_http_folder_get_gzip_cache_count() == l_count; i++)
+        usleep(10000);
+    dap_assert_PIF(!s_request("/czfiles/ledger.json", "Accept-Encoding: gzip\r\n", &l_gzip)
+                   && s_reply_is(&l_gzip, "gzip", s_json->data, s_json->size)
+                   && !dap_http_test_reply_header(&l_gzip, "Accept-Ranges", l_value, sizeof(l_value))
+                   && dap_http_folder_get_gzip_cache_count() == l_count + 1, "Gzipped file");
+    dap_test_msg("Static file %zu bytes: %zu bytes on the wire, %zu gzipped", s_json->size, l_plain.wire_size, l_gzip.wire_size);
+    dap_assert_PIF(l_gzip.wire_size < l_plain.wire_size / 2, "Less bytes on the wire");
+    DAP_DEL_MULTY(l_plain.body, l_gzip.body);
+
+    // The same compressed copy is sent again
+    struct timespec l_start, l_end;
+    clock_gettime(CLOCK_MONOTONIC, &l_start);
+    dap_assert_PIF(!s_request("/czfiles/ledger.json", "Accept-Encoding: gzip\r\n", &l_reply)
+                   && s_reply_is(&l_reply, "gzip", s_json->data, s_json->size)
+                   && dap_http_folder_get_gzip_cache_count() == l_count + 1, "Compressed file is cached");
+    clock_gettime(CLOCK_MONOTONIC, &l_end);
+    dap_test_msg("Cached gzipped file request %.2f ms", (l_end.tv_sec - l_start.tv_sec) * 1e3 + (l_end.tv_nsec - l_start.tv_nsec) / 1e6);
+    DAP_DEL_Z(l_reply.body);
+
+    dap_assert_PIF(!s_request("/czfiles/ledger.json", "Accept-Encoding: gzip\r\nRange: bytes=10-99\r\n", &l_reply)
+                   && l_reply.code == Http_Status_PartialContent && l_reply.body_size == 90
+                   && !memcmp(l_reply.body, s_json->data + 10, 90), "Range is served from the file");
+    DAP_DEL_Z(l_reply.body);
+    dap_assert_PIF(!s_request("/czfiles/reply.json", "Accept-Encoding: gzip\r\n", &l_reply)
+                   && s_reply_is(&l_reply, "gzip", s_payloads[0].data, s_payloads[0].size)
+                   && dap_http_folder_get_gzip_cache_count() == l_count + 2, "Small file is gzipped at once");
+    DAP_DEL_Z(l_reply.body);
+    dap_assert_PIF(!s_request("/czfiles/ledger.png", "Accept-Encoding: gzip\r\n", &l_reply)
+                   && s_reply_is(&l_reply, NULL, s_json->data, s_json->size) && !dap_http_test_reply_header(&l_reply, "Vary", l_value, sizeof(l_value)),
+                   "Image is sent as is");
+    DAP_DEL_Z(l_reply.body);
+
+    dap_http_folder_set_gzip_cache_size_max(0);
+    dap_assert_PIF(!dap_http_folder_get_gzip_cache_count(), "Cache is dropped");
+    unlink(l_path);
+    snprintf(l_path, sizeof(l_path), "%s/ledger.json", l_dir);
+    unlink(l_path);
+    snprintf(l_path, sizeof(l_path), "%s/reply.json", l_dir);
+    unlink(l_path);
+    rmdir(l_dir);
+    dap_pass_msg("Folder files");
+}
+
+void dap_http_compress_test_run(void)
+{
+    dap_print_module_name("dap_http_compress");
+    for (size_t i = 0; i < sizeof(s_payloads) / sizeof(s_payloads[0]); i++)
+        s_payload_make(&s_payloads[i]);
+    s_negotiation_test();
+    dap_assert_PIF(!dap_http_compress_set(true, TEST_MIN_SIZE, 6), "Compression is on");
+    s_streaming_compressor_test();
+    s_cost_benchmark();
+    dap_http_compress_set(true, TEST_MIN_SIZE, 6);
+    s_simple_test();
+    s_folder_test();
+    dap_http_compress_set(false, 0, 0);
+    for (size_t i = 0; i < sizeof(s_payloads) / sizeof(s_payloads[0]); i++)
+        DAP_DELETE(s_payloads[i].data);
+}
+
+#else
+
+void dap_http_compress_test_run(void)
+{
+    dap_print_module_name("dap_http_compress");
+    dap_assert_PIF(dap_http_compress_set(true, 0, 0) && !dap_http_compress_enabled(), "Compression isn't supported without zlib");
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include <unistd.h>
+#include "dap_http_folder_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_http_folder.h"
+
+#define TEST_FILE_SIZE      (64 * 1024 * 1024)
+#define TEST_DOWNLOADS      4
+
+typedef struct test_reply {
+    int code;
+    size_t content_length;
+    char content_range[128], last_modified[128];
+    byte_t *body;
+    size_t body_size;
+} test_reply_t;
+
+static byte_t *s_file_data;
+
+// Plain blocking HTTP/1.1 GET, server closes connection after reply
+static int s_request(const char *a_file, const char *a_headers, test_reply_t *a_reply)
+{
+    char l_request[512];
+    snprintf(l_request, sizeof(l_request), "GET /files/%s HTTP/1.1\r\nHost: localhost\r\n%s\r\n", a_file, a_headers ? a_headers : "");
+    dap_http_test_reply_t l_reply;
+    int l_ret = dap_http_test_request(l_request, &l_reply);
+    *a_reply = (test_reply_t) { };
+    if (l_ret) {
+        dap_http_test_reply_free(&l_reply);
+        return l_ret;
+    }
+    char l_value[128];
+    a_reply->code = l_reply.code;
+    if (dap_http_test_reply_header(&l_reply, "Content-Length", l_value, sizeof(l_value)))
+        a_reply->content_length = strtoull(l_value, NULL, 10);
+    dap_http_test_reply_header(&l_reply, "Content-Range", a_reply->content_range, sizeof(a_reply->content_range));
+    dap_http_test_reply_header(&l_reply, "Last-Modified", a_reply->last_modified, sizeof(a_reply->last_modified));
+    a_reply->body = l_reply.body;
+    a_reply->body_size = l_reply.body_size;
+    return 0;
+}
+
+static void s_download_benchmark(dap_http_folder_send_mode_t a_mode, const char *a_mode_name)
+{
+    dap_assert_PIF(!dap_http_folder_set_send_mode(a_mode), a_mode_name);
+    // Process CPU time minus this (client) thread time is the time spent by the server
+    double l_wall = dap_http_test_time_sec(CLOCK_MONOTONIC),
+           l_process = dap_http_test_time_sec(CLOCK_PROCESS_CPUTIME_ID),
+           l_client = dap_http_test_time_sec(CLOCK_THREAD_CPUTIME_ID);
+    bool l_ok = true;
+    for (int i = 0; i < TEST_DOWNLOADS; i++) {
+        test_reply_t l_reply;
+        l_ok &= !s_request("big.bin", NULL, &l_reply) && l_reply.code == 200 && l_reply.content_length == TEST_FILE_SIZE
+                && l_reply.body_size == TEST_FILE_SIZE && !memcmp(l_reply.body, s_file_data, TEST_FILE_SIZE);
+        DAP_DELETE(l_reply.body);
+    }
+    l_client = dap_http_test_time_sec(CLOCK_THREAD_CPUTIME_ID) - l_client;
+    l_process = dap_http_test_time_sec(CLOCK_PROCESS_CPUTIME_ID) - l_process;
+    l_wall = dap_http_test_time_sec(CLOCK_MONOTONIC) - l_wall;
+    dap_assert_PIF(l_ok, "Whole file is received");
+    dap_test_msg("%-9s %7.1f MB/s, server CPU %6.1f ms per 64 MB", a_mode_name,
+                 (double)TEST_FILE_SIZE * TEST_DOWNLOADS / l_wall / (1024 * 1024),
+                 (l_process - l_client) * 1000 / TEST_DOWNLOADS);
+}
+
+static void s_range_test(dap_http_folder_send_mode_t a_mode, const char *a_mode_name)
+{
+    dap_http_folder_set_send_mode(a_mode);
+    test_reply_t l_reply;
+    char l_expected[128];
+
+    dap_assert_PIF(!s_request("big.bin", "Range: bytes=1000-1999\r\n", &l_reply), "Range request");
+    snprintf(l_expected, sizeof(l_expected), "bytes 1000-1999/%d", TEST_FILE_SIZE);
+    dap_assert_PIF(l_reply.code == 206 && l_reply.content_length == 1000 && l_reply.body_size == 1000
+                   && !memcmp(l_reply.body, s_file_data + 1000, 1000) && !strcmp(l_reply.content_range, l_expected), a_mode_name);
+    DAP_DELETE(l_reply.body);
+
+    dap_assert_PIF(!s_request("big.bin", "Range: bytes=-100\r\n", &l_reply), "Suffix range request");
+    dap_assert_PIF(l_reply.code == 206 && l_reply.body_size == 100
+                   && !memcmp(l_reply.body, s_file_data + TEST_FILE_SIZE - 100, 100), "Suffix range");
+    DAP_DELETE(l_reply.body);
+
+    dap_assert_PIF(!s_request("big.bin", "Range: bytes=67000000-\r\n", &l_reply), "Open range request");
+    dap_assert_PIF(l_reply.code == 206 && l_reply.body_size == TEST_FILE_SIZE - 67000000
+                   && !memcmp(l_reply.body, s_file_data + 67000000, l_reply.body_size), "Open range");
+    DAP_DELETE(l_reply.body);
+}
+
+static void s_conditional_test()
+{
+    test_reply_t l_reply;
+    char l_header[256];
+
+    dap_assert_PIF(!s_request("big.bin", "Range: bytes=0-0\r\n", &l_reply) && l_reply.last_modified[0], "Last-Modified is sent");
+    snprintf(l_header, sizeof(l_header), "If-Modified-Since: %s\r\n", l_reply.last_modified);
+    DAP_DELETE(l_reply.body);
+    dap_assert_PIF(!s_request("big.bin", l_header, &l_reply) && l_reply.code == 304 && !l_reply.body_size, "Not modified");
+    DAP_DELETE(l_reply.body);
+
+    dap_assert_PIF(!s_request("big.bin", "If-Modified-Since: Thu, 01 Jan 1970 00:00:01 GMT\r\nRange: bytes=0-9\r\n", &l_reply)
+                   && l_reply.code == 206, "Modified since epoch");
+    DAP_DELETE(l_reply.body);
+
+    snprintf(l_header, sizeof(l_header), "Range: bytes=%d-\r\n", TEST_FILE_SIZE);
+    dap_assert_PIF(!s_request("big.bin", l_header, &l_reply) && l_reply.code == 416, "Range not satisfiable");
+    DAP_DELETE(l_reply.body);
+
+    dap_assert_PIF(!s_request("absent.bin", NULL, &l_reply) && l_reply.code == 404, "Absent file");
+    DAP_DELETE(l_reply.body);
+}
+
+void dap_http_folder_test_run(void)
+{
+    dap_print_module_name("dap_http_folder");
+    const char *l_dir = dap_http_test_server_dir();
+    char l_path[128];
+
+    s_file_data = DAP_NEW_Z_SIZE(byte_t, TEST_FILE_SIZE);
+    for (size_t i = 0; i < TEST_FILE_SIZE; i++)
+        s_file_data[i] = (byte_t)((i * 2654435761u) >> 13);
+    snprintf(l_path, sizeof(l_path), "%s/big.bin", l_dir);
+    FILE *l_file = fopen(l_path, "wb");
+    fwrite(s_file_data, 1, TEST_FILE_SIZE, l_file);
+    fclose(l_file);
+
+    dap_assert_PIF(!dap_http_folder_add(dap_http_test_server(), "/files", l_dir), "Folder is added");
+
+    s_range_test(DAP_HTTP_FOLDER_SEND_BUFFERED, "Buffered ranges");
+    s_range_test(DAP_HTTP_FOLDER_SEND_MMAP, "Mmap ranges");
+    s_range_test(DAP_HTTP_FOLDER_SEND_SENDFILE, "Sendfile ranges");
+    s_conditional_test();
+
+    s_download_benchmark(DAP_HTTP_FOLDER_SEND_BUFFERED, "buffered");
+    s_download_benchmark(DAP_HTTP_FOLDER_SEND_MMAP, "mmap");
+    s_download_benchmark(DAP_HTTP_FOLDER_SEND_SENDFILE, "sendfile");
+
+    unlink(l_path);
+    DAP_DELETE(s_file_data);
+}
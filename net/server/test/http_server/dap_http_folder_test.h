@@ -0,0 +1,5 @@
+#pragma once
+
+#include "dap_test.h"
+
+void dap_http_folder_test_run(void);
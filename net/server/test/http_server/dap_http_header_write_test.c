@@ -0,0 +1,127 @@
+#include "dap_http_header_write_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_time.h"
+#include "dap_events_socket.h"
+#include "dap_http_client.h"
+#include "dap_http_header.h"
+#include "http_status_code.h"
+
+#define TEST_REPLIES            300000
+#define TEST_BUF_SIZE           8192
+
+static dap_http_url_proc_t s_proc = { };                                    /* No callbacks, general headers are generated */
+
+// Client of a reply ready to write, the socket is not connected and only collects the output
+static dap_http_client_t *s_client_new(void)
+{
+    dap_http_client_t *l_client = DAP_NEW_Z(dap_http_client_t);
+    l_client->esocket = DAP_NEW_Z(dap_events_socket_t);
+    l_client->esocket->buf_out = DAP_NEW_Z_SIZE(byte_t, TEST_BUF_SIZE);
+    l_client->esocket->buf_out_size_max = TEST_BUF_SIZE;
+    l_client->esocket->flags = DAP_SOCK_READY_TO_WRITE;                     /* Not in any context, don't touch the poll */
+    l_client->http = dap_http_test_server();
+    l_client->proc = &s_proc;
+    l_client->keep_alive = true;
+    l_client->requests_count = 1;
+    return l_client;
+}
+
+static void s_client_delete(dap_http_client_t *a_client)
+{
+    DAP_DELETE(a_client->esocket->buf_out);
+    DAP_DEL_MULTY(a_client->esocket, a_client);
+}
+
+static void s_reply_prepare(dap_http_client_t *a_client)
+{
+    a_client->esocket->buf_out_size = 0;
+    a_client->state_read = DAP_HTTP_CLIENT_STATE_DATA;
+    a_client->reply_status_code = Http_Status_OK;
+    dap_strncpy(a_client->out_content_type, "application/json", sizeof(a_client->out_content_type));
+    a_client->out_content_length = 1234;
+}
+
+// Headers as they were written before: list nodes for each header, then formatted one by one
+static void s_legacy_write(dap_http_client_t *a_client)
+{
+    dap_events_socket_t *l_es = a_client->esocket;
+    dap_http_out_header_add(a_client, "Content-Type", a_client->out_content_type);
+    dap_http_out_header_add_f(a_client, "Content-Length", "%zu", a_client->out_content_length);
+    dap_http_out_header_add(a_client, "Connection", "Keep-Alive");
+    dap_http_out_header_add_f(a_client, "Keep-Alive", "timeout=%d, max=%d", 5, 99);
+    dap_http_out_header_add(a_client, "Server", a_client->http->server_name);
+    char l_time[DAP_TIME_STR_SIZE];
+    dap_time_to_str_rfc822(l_time, sizeof(l_time), time(NULL));
+    dap_http_out_header_add(a_client, "Date", l_time);
+    l_es->buf_out_size += snprintf((char *)l_es->buf_out + l_es->buf_out_size, l_es->buf_out_size_max - l_es->buf_out_size,
+                                   "HTTP/1.1 %u %s\r\n", a_client->reply_status_code, http_status_reason_phrase(a_client->reply_status_code));
+    for (dap_http_header_t *l_hdr = a_client->out_headers; l_hdr; l_hdr = a_client->out_headers) {
+        l_es->buf_out_size += snprintf((char *)l_es->buf_out + l_es->buf_out_size, l_es->buf_out_size_max - l_es->buf_out_size,
+                                       "%s: %s\r\n", l_hdr->name, l_hdr->value);
+        dap_http_header_remove(&a_client->out_headers, l_hdr);
+    }
+    dap_events_socket_write_unsafe(l_es, "\r\n", 2);
+}
+
+static double s_replies_per_sec(dap_http_client_t *a_client, void (*a_write)(dap_http_client_t *))
+{
+    int l_start = get_cur_time_msec();
+    for (int i = 0; i < TEST_REPLIES; i++) {
+        s_reply_prepare(a_client);
+        a_write(a_client);
+    }
+    return TEST_REPLIES / (dap_max(get_cur_time_msec() - l_start, 1) / 1000.0);
+}
+
+static bool s_has(dap_events_socket_t *a_es, const char *a_str)
+{
+    return memmem(a_es->buf_out, a_es->buf_out_size, a_str, strlen(a_str));
+}
+
+static void s_output_test(void)
+{
+    dap_http_header_tpl_t *l_tpl = dap_http_header_tpl_new("Cache-Control", "no-cache", "X-Test", "1", NULL);
+    dap_assert_PIF(l_tpl && l_tpl->size == strlen(l_tpl->data) && !strcmp(l_tpl->data, "Cache-Control: no-cache\r\nX-Test: 1\r\n"),
+                   "Template is rendered");
+    dap_http_client_t *l_client = s_client_new();
+    s_reply_prepare(l_client);
+    dap_http_out_header_add(l_client, "X-Custom", "value");
+    l_client->out_headers_tpl = l_tpl;
+    // Custom headers turn off general ones generation, so they are requested here
+    l_client->out_headers_default = true;
+    l_client->out_keep_alive = true;
+    dap_http_client_write(l_client);
+    dap_events_socket_t *l_es = l_client->esocket;
+    const char *l_end = memmem(l_es->buf_out, l_es->buf_out_size, "\r\n\r\n", 4);
+    dap_assert_PIF(l_es->buf_out_size > 15 && !memcmp(l_es->buf_out, "HTTP/1.1 200 OK\r\nX-Custom: value\r\n", 34)
+                   && l_end && l_end + 4 == (char *)l_es->buf_out + l_es->buf_out_size, "Status line goes first, headers end once");
+    dap_assert_PIF(s_has(l_es, "\r\nContent-Type: application/json\r\n") && s_has(l_es, "\r\nContent-Length: 1234\r\n")
+                   && s_has(l_es, "\r\nConnection: Keep-Alive\r\n") && s_has(l_es, "\r\nKeep-Alive: timeout=")
+                   && s_has(l_es, "\r\nServer: ") && s_has(l_es, "\r\nCache-Control: no-cache\r\nX-Test: 1\r\n")
+                   && s_has(l_es, "\r\nDate: ") && !l_client->out_headers, "Headers are written");
+    s_client_delete(l_client);
+    dap_http_header_tpl_delete(l_tpl);
+    dap_pass_msg("Headers output");
+}
+
+static void s_write_benchmark(void)
+{
+    dap_http_client_t *l_client = s_client_new();
+    double l_legacy = s_replies_per_sec(l_client, s_legacy_write);
+    size_t l_legacy_size = l_client->esocket->buf_out_size;
+    double l_current = s_replies_per_sec(l_client, dap_http_client_write);
+    size_t l_size = l_client->esocket->buf_out_size;
+    dap_test_msg("%d replies: %.0f replies/s with single buffer serializer (%zu bytes), %.0f replies/s with header list (%zu bytes)",
+                 TEST_REPLIES, l_current, l_size, l_legacy, l_legacy_size);
+    s_client_delete(l_client);
+    dap_assert_PIF(l_current > l_legacy, "Serializer is faster than header list");
+}
+
+void dap_http_header_write_test_run(void)
+{
+    dap_print_module_name("dap_http_header_write");
+    s_output_test();
+    s_write_benchmark();
+}
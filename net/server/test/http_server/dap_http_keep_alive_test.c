@@ -0,0 +1,234 @@
+#include <sys/socket.h>
+#include <unistd.h>
+#include "dap_http_keep_alive_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_http_simple.h"
+#include "dap_http_folder.h"
+#include "http_status_code.h"
+
+#define TEST_FILE_DATA          "Keep-alive file\n"
+#define TEST_PIPELINED_COUNT    30
+#define TEST_REQUESTS_MAX       200                                         /* keep_alive_requests_max of test server */
+#define TEST_BENCH_REQUESTS     5000
+
+typedef struct test_reply {
+    int code;
+    bool keep_alive;
+    char body[256];
+} test_reply_t;
+
+static void s_echo_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    dap_http_simple_reply_f(a_http_simple, "%s:%s:%.*s", a_http_simple->http_client->action,
+                            a_http_simple->http_client->in_query_string, (int)a_http_simple->request_size,
+                            a_http_simple->request_size ? a_http_simple->request_str : "");
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+// Reads exactly one reply, the rest of input is kept for the next one
+static int s_reply_read(dap_http_test_conn_t *a_conn, test_reply_t *a_reply)
+{
+    dap_http_test_reply_t l_reply;
+    char l_value[64];
+    int l_ret = dap_http_test_reply_read(a_conn, &l_reply);
+    *a_reply = (test_reply_t) {
+        .code = l_reply.code,
+        .keep_alive = dap_http_test_reply_header(&l_reply, "Connection", l_value, sizeof(l_value)) && !strcasecmp(l_value, "Keep-Alive")
+    };
+    if (l_reply.body)
+        snprintf(a_reply->body, sizeof(a_reply->body), "%s", (char *)l_reply.body);
+    dap_http_test_reply_free(&l_reply);
+    return l_ret;
+}
+
+static bool s_is_closed(dap_http_test_conn_t *a_conn)
+{
+    char l_byte;
+    return !a_conn->size && !recv(a_conn->sock, &l_byte, 1, 0);
+}
+
+static int s_request_make(char *a_buf, size_t a_size, int a_num, bool a_keep_alive)
+{
+    const char *l_connection = a_keep_alive ? "Connection: Keep-Alive\r\n" : "";
+    switch (a_num % 3) {
+    case 0:
+        return snprintf(a_buf, a_size, "GET /ka/echo?n=%d HTTP/1.1\r\nHost: localhost\r\n%s\r\n", a_num, l_connection);
+    case 1:
+        // Extra CRLF after the body is allowed between requests
+        return snprintf(a_buf, a_size, "POST /ka/echo?n=%d HTTP/1.1\r\nHost: localhost\r\n%sContent-Length: %d\r\n\r\nbody%03d\r\n",
+                        a_num, l_connection, 7, a_num);
+    default:
+        return snprintf(a_buf, a_size, "GET /kafiles/ka.txt HTTP/1.1\r\nHost: localhost\r\n%s\r\n", l_connection);
+    }
+}
+
+static bool s_reply_check(test_reply_t *a_reply, int a_num)
+{
+    char l_expected[128];
+    switch (a_num % 3) {
+    case 0: snprintf(l_expected, sizeof(l_expected), "GET:n=%d:", a_num); break;
+    case 1: snprintf(l_expected, sizeof(l_expected), "POST:n=%d:body%03d", a_num, a_num); break;
+    default: snprintf(l_expected, sizeof(l_expected), "%s", TEST_FILE_DATA); break;
+    }
+    return a_reply->code == Http_Status_OK && !strcmp(a_reply->body, l_expected);
+}
+
+static void s_sequential_test()
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    char l_request[256];
+    dap_assert_PIF((l_conn->sock = dap_http_test_connect()) >= 0, "Connect");
+    bool l_ok = true;
+    for (int i = 0; i < 9 && l_ok; i++) {
+        test_reply_t l_reply;
+        l_ok = !dap_http_test_send(l_conn->sock, l_request, s_request_make(l_request, sizeof(l_request), i, true))
+                && !s_reply_read(l_conn, &l_reply) && l_reply.keep_alive && s_reply_check(&l_reply, i);
+    }
+    dap_assert_PIF(l_ok, "Sequential requests over one connection");
+    close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    dap_pass_msg("Keep-alive connection");
+}
+
+static void s_pipelining_test()
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    char *l_requests = DAP_NEW_Z_SIZE(char, TEST_PIPELINED_COUNT * 256);
+    size_t l_size = 0;
+    for (int i = 0; i < TEST_PIPELINED_COUNT; i++)
+        l_size += s_request_make(l_requests + l_size, 256, i, true);
+    dap_assert_PIF((l_conn->sock = dap_http_test_connect()) >= 0 && !dap_http_test_send(l_conn->sock, l_requests, l_size), "Send pipelined requests");
+    int l_replies = 0;
+    test_reply_t l_reply;
+    while (l_replies < TEST_PIPELINED_COUNT && !s_reply_read(l_conn, &l_reply) && s_reply_check(&l_reply, l_replies))
+        l_replies++;
+    dap_assert_PIF(l_replies == TEST_PIPELINED_COUNT, "Pipelined replies are in order");
+
+    // Request split between TCP segments
+    l_size = s_request_make(l_requests, 256, 0, true);
+    dap_http_test_send(l_conn->sock, l_requests, 5);
+    usleep(50000);
+    dap_http_test_send(l_conn->sock, l_requests + 5, l_size - 5);
+    dap_assert_PIF(!s_reply_read(l_conn, &l_reply) && s_reply_check(&l_reply, 0), "Request in parts");
+    close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    DAP_DELETE(l_requests);
+    dap_pass_msg("Pipelining");
+}
+
+static void s_close_test()
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    char l_request[256];
+    test_reply_t l_reply;
+    dap_assert_PIF((l_conn->sock = dap_http_test_connect()) >= 0, "Connect");
+    dap_assert_PIF(!dap_http_test_send(l_conn->sock, l_request, s_request_make(l_request, sizeof(l_request), 0, false))
+                   && !s_reply_read(l_conn, &l_reply) && !l_reply.keep_alive && s_reply_check(&l_reply, 0)
+                   && s_is_closed(l_conn), "Connection without keep-alive is closed");
+    close(l_conn->sock);
+
+    // Only the whole token asks for keep-alive
+    static const char *s_not_keep_alive[] = { "", "K", "Keep", "Keep-Alive-Not" };
+    bool l_closed = true;
+    for (size_t i = 0; i < sizeof(s_not_keep_alive) / sizeof(*s_not_keep_alive) && l_closed; i++) {
+        *l_conn = (dap_http_test_conn_t) { .sock = dap_http_test_connect() };
+        int l_len = snprintf(l_request, sizeof(l_request), "GET /ka/echo?n=0 HTTP/1.1\r\nHost: localhost\r\nConnection: %s\r\n\r\n",
+                             s_not_keep_alive[i]);
+        l_closed = !dap_http_test_send(l_conn->sock, l_request, l_len) && !s_reply_read(l_conn, &l_reply) && !l_reply.keep_alive
+                && s_reply_check(&l_reply, 0) && s_is_closed(l_conn);
+        close(l_conn->sock);
+    }
+    dap_assert_PIF(l_closed, "Partial Connection token is not keep-alive");
+
+    // Limit of requests per connection
+    char *l_requests = DAP_NEW_Z_SIZE(char, (TEST_REQUESTS_MAX + 1) * 256);
+    size_t l_size = 0;
+    for (int i = 0; i <= TEST_REQUESTS_MAX; i++)
+        l_size += s_request_make(l_requests + l_size, 256, i, true);
+    *l_conn = (dap_http_test_conn_t) { .sock = dap_http_test_connect() };
+    dap_assert_PIF(l_conn->sock >= 0 && !dap_http_test_send(l_conn->sock, l_requests, l_size), "Send requests over the limit");
+    int l_keep_alive = 0;
+    bool l_ok = true;
+    for (int i = 0; i < TEST_REQUESTS_MAX && l_ok; i++) {
+        l_ok = !s_reply_read(l_conn, &l_reply) && s_reply_check(&l_reply, i);
+        l_keep_alive += l_reply.keep_alive;
+    }
+    dap_assert_PIF(l_ok && l_keep_alive == TEST_REQUESTS_MAX - 1 && s_is_closed(l_conn), "Connection is closed at requests limit");
+    close(l_conn->sock);
+    DAP_DELETE(l_requests);
+
+    // Idle timeout
+    *l_conn = (dap_http_test_conn_t) { .sock = dap_http_test_connect() };
+    dap_assert_PIF(!dap_http_test_send(l_conn->sock, l_request, s_request_make(l_request, sizeof(l_request), 0, true))
+                   && !s_reply_read(l_conn, &l_reply) && l_reply.keep_alive, "Keep-alive request");
+    int l_start = get_cur_time_msec();
+    dap_assert_PIF(s_is_closed(l_conn), "Idle connection is closed");
+    int l_idle = get_cur_time_msec() - l_start;
+    dap_assert_PIF(l_idle >= 500 && l_idle < 5000, "Idle timeout");
+    close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    dap_pass_msg("Connection close, requests limit and idle timeout");
+}
+
+static void s_benchmark()
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    char l_request[256];
+    test_reply_t l_reply;
+    int l_connections = 0;
+    bool l_ok = true;
+    int l_start = get_cur_time_msec();
+    l_conn->sock = -1;
+    for (int i = 0; i < TEST_BENCH_REQUESTS && l_ok; i++) {
+        if (l_conn->sock < 0) {
+            *l_conn = (dap_http_test_conn_t) { .sock = dap_http_test_connect() };
+            l_connections++;
+        }
+        l_ok = !dap_http_test_send(l_conn->sock, l_request, s_request_make(l_request, sizeof(l_request), 0, true))
+                && !s_reply_read(l_conn, &l_reply) && s_reply_check(&l_reply, 0);
+        if (!l_reply.keep_alive) {
+            close(l_conn->sock);
+            l_conn->sock = -1;
+        }
+    }
+    int l_keep_alive_time = get_cur_time_msec() - l_start;
+    if (l_conn->sock >= 0)
+        close(l_conn->sock);
+    dap_assert_PIF(l_ok, "Keep-alive benchmark");
+
+    l_start = get_cur_time_msec();
+    for (int i = 0; i < TEST_BENCH_REQUESTS && l_ok; i++) {
+        *l_conn = (dap_http_test_conn_t) { .sock = dap_http_test_connect() };
+        l_ok = !dap_http_test_send(l_conn->sock, l_request, s_request_make(l_request, sizeof(l_request), 0, false))
+                && !s_reply_read(l_conn, &l_reply) && s_reply_check(&l_reply, 0);
+        close(l_conn->sock);
+    }
+    int l_fresh_time = get_cur_time_msec() - l_start;
+    dap_assert_PIF(l_ok, "Fresh connections benchmark");
+    DAP_DELETE(l_conn);
+
+    double l_keep_alive_rate = TEST_BENCH_REQUESTS * 1000.0 / dap_max(l_keep_alive_time, 1),
+           l_fresh_rate = TEST_BENCH_REQUESTS * 1000.0 / dap_max(l_fresh_time, 1);
+    dap_test_msg("%d requests: keep-alive %.0f req/s (%d connections), fresh connections %.0f req/s, x%.2f",
+                 TEST_BENCH_REQUESTS, l_keep_alive_rate, l_connections, l_fresh_rate, l_keep_alive_rate / l_fresh_rate);
+}
+
+void dap_http_keep_alive_test_run(void)
+{
+    dap_print_module_name("dap_http_keep_alive");
+    const char *l_dir = dap_http_test_server_dir();
+    char l_path[128];
+    snprintf(l_path, sizeof(l_path), "%s/ka.txt", l_dir);
+    FILE *l_file = fopen(l_path, "w");
+    fputs(TEST_FILE_DATA, l_file);
+    fclose(l_file);
+    dap_assert_PIF(dap_http_simple_proc_add(dap_http_test_server(), "/ka", 1024, s_echo_callback)
+                   && !dap_http_folder_add(dap_http_test_server(), "/kafiles", l_dir), "Procs are added");
+
+    s_sequential_test();
+    s_pipelining_test();
+    s_close_test();
+    s_benchmark();
+    unlink(l_path);
+}
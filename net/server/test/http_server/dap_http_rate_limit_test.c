@@ -0,0 +1,205 @@
+#include <unistd.h>
+#include <pthread.h>
+#include "dap_http_rate_limit_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_server.h"
+#include "dap_http_simple.h"
+#include "http_status_code.h"
+
+#define TEST_ABUSER             "127.0.0.2"
+#define TEST_VICTIM             "127.0.0.3"
+#define TEST_NEWCOMER           "127.0.0.4"
+#define TEST_CONN_MAX           4
+#define TEST_REQUEST_RATE       50
+#define TEST_REQUEST_BURST      20
+#define TEST_VICTIM_REQUESTS    40
+#define TEST_VICTIM_PERIOD_US   25000                                       /* 40 requests/s, below the limit */
+
+typedef struct flood_state {
+    volatile bool stop;
+    int ok, throttled, failed;
+} flood_state_t;
+
+static void s_reply_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    dap_strncpy(a_http_simple->reply_mime, "text/plain", sizeof(a_http_simple->reply_mime));
+    dap_http_simple_reply(a_http_simple, "ok", 2);
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+// Sends a request over the connection, returns reply status code or 0 if connection is closed without reply
+static int s_request(dap_http_test_conn_t *a_conn)
+{
+    const char l_request[] = "GET /limits HTTP/1.1\r\nHost: localhost\r\nConnection: Keep-Alive\r\n\r\n";
+    dap_http_test_reply_t l_reply = { };
+    int l_code = !dap_http_test_send(a_conn->sock, l_request, sizeof(l_request) - 1) && !dap_http_test_reply_read(a_conn, &l_reply)
+            ? l_reply.code : 0;
+    dap_http_test_reply_free(&l_reply);
+    return l_code;
+}
+
+static int s_request_from(const char *a_src_addr)
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    if (!l_conn)
+        return 0;
+    int l_code = (l_conn->sock = dap_http_test_connect_from(a_src_addr)) >= 0 ? s_request(l_conn) : 0;
+    if (l_conn->sock >= 0)
+        close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    return l_code;
+}
+
+static void s_connection_quota_test(dap_server_t *a_server)
+{
+    dap_server_limits_t l_limits = { .conn_per_addr_max = TEST_CONN_MAX };
+    dap_assert_PIF(!dap_server_limits_set(a_server, &l_limits), "Connection quota is set");
+    dap_http_test_conn_t *l_conns = DAP_NEW_Z_COUNT(dap_http_test_conn_t, TEST_CONN_MAX + 1);
+    dap_assert_PIF(l_conns, "Connections allocation");
+    bool l_ok = true;
+    for (int i = 0; i < TEST_CONN_MAX; i++)
+        l_ok &= (l_conns[i].sock = dap_http_test_connect_from(TEST_ABUSER)) >= 0 && s_request(l_conns + i) == Http_Status_OK;
+    dap_assert_PIF(l_ok, "Connections within the quota are served");
+    l_conns[TEST_CONN_MAX].sock = dap_http_test_connect_from(TEST_ABUSER);
+    dap_assert_PIF(!s_request(l_conns + TEST_CONN_MAX), "Connection over the quota is dropped");
+    dap_assert_PIF(s_request_from(TEST_VICTIM) == Http_Status_OK, "Other client is served");
+    for (int i = 0; i <= TEST_CONN_MAX; i++)
+        close(l_conns[i].sock);
+    DAP_DELETE(l_conns);
+    // Server notices closed connections asynchronously
+    int l_code = 0;
+    for (int i = 0; i < 100 && (l_code = s_request_from(TEST_ABUSER)) != Http_Status_OK; i++)
+        usleep(10000);
+    dap_assert_PIF(l_code == Http_Status_OK, "Closed connections are released");
+
+    // Connection rate, the burst is accepted at once
+    l_limits = (dap_server_limits_t){ .conn_rate = 1, .conn_burst = TEST_CONN_MAX };
+    dap_assert_PIF(!dap_server_limits_set(a_server, &l_limits), "Connection rate is set");
+    int l_served = 0;
+    for (int i = 0; i < TEST_CONN_MAX * 3; i++)
+        l_served += s_request_from(TEST_ABUSER) == Http_Status_OK;
+    dap_assert_PIF(l_served >= TEST_CONN_MAX && l_served <= TEST_CONN_MAX + 1, "Connections over the rate are dropped");
+    dap_assert_PIF(s_request_from(TEST_VICTIM) == Http_Status_OK, "Other client is not limited");
+    dap_pass_msg("Connection quota and rate");
+}
+
+static void *s_flood_thread(void *a_arg)
+{
+    flood_state_t *l_state = a_arg;
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    if (!l_conn) {
+        l_state->failed++;
+        return NULL;
+    }
+    l_conn->sock = -1;
+    while (!l_state->stop) {
+        if (l_conn->sock < 0 && (l_conn->sock = dap_http_test_connect_from(TEST_ABUSER)) < 0) {
+            l_state->failed++;
+            continue;
+        }
+        switch (s_request(l_conn)) {
+        case Http_Status_OK:
+            l_state->ok++;
+            continue;
+        case Http_Status_TooManyRequests:
+            l_state->throttled++;
+            break;
+        default:
+            l_state->failed++;
+        }
+        // Connection is closed after error reply
+        close(l_conn->sock);
+        *l_conn = (dap_http_test_conn_t) { .sock = -1 };
+    }
+    if (l_conn->sock >= 0)
+        close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    return NULL;
+}
+
+// Sequential requests of the well-behaved client over keep-alive connection
+static bool s_victim_run(double *a_avg_ms, double *a_max_ms)
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    bool l_ok = l_conn && (l_conn->sock = dap_http_test_connect_from(TEST_VICTIM)) >= 0;
+    double l_sum = 0, l_max = 0;
+    for (int i = 0; l_ok && i < TEST_VICTIM_REQUESTS; i++) {
+        double l_start = dap_http_test_time_sec(CLOCK_MONOTONIC);
+        l_ok = s_request(l_conn) == Http_Status_OK;
+        double l_time = (dap_http_test_time_sec(CLOCK_MONOTONIC) - l_start) * 1000;
+        l_sum += l_time;
+        l_max = dap_max(l_max, l_time);
+        usleep(TEST_VICTIM_PERIOD_US);
+    }
+    if (l_conn && l_conn->sock >= 0)
+        close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    *a_avg_ms = l_sum / TEST_VICTIM_REQUESTS;
+    *a_max_ms = l_max;
+    return l_ok;
+}
+
+static void s_request_rate_test(dap_server_t *a_server)
+{
+    dap_server_limits_t l_limits = { .request_rate = TEST_REQUEST_RATE, .request_burst = TEST_REQUEST_BURST };
+    dap_assert_PIF(!dap_server_limits_set(a_server, &l_limits), "Request rate is set");
+    dap_server_limits_stats_t l_stats_start, l_stats;
+    dap_server_limits_stats_get(a_server, &l_stats_start);
+
+    double l_base_avg, l_base_max, l_flood_avg, l_flood_max;
+    dap_assert_PIF(s_victim_run(&l_base_avg, &l_base_max), "Client within the rate is served");
+
+    flood_state_t l_state = { };
+    pthread_t l_thread;
+    pthread_create(&l_thread, NULL, s_flood_thread, &l_state);
+    double l_start = dap_http_test_time_sec(CLOCK_MONOTONIC);
+    bool l_victim_ok = s_victim_run(&l_flood_avg, &l_flood_max);
+    l_state.stop = true;
+    pthread_join(l_thread, NULL);
+    double l_time = dap_http_test_time_sec(CLOCK_MONOTONIC) - l_start;
+
+    dap_assert_PIF(l_victim_ok, "Client within the rate is served during the flood");
+    dap_assert_PIF(l_state.throttled > l_state.ok && l_state.ok <= TEST_REQUEST_BURST + TEST_REQUEST_RATE * (l_time + 1),
+                   "Excess requests are rejected");
+    dap_assert_PIF(!l_state.failed, "Rejected requests get 429 reply");
+    dap_server_limits_stats_get(a_server, &l_stats);
+    dap_assert_PIF(l_stats.requests_throttled - l_stats_start.requests_throttled == (uint64_t)l_state.throttled
+                   && l_stats.clients_throttled > l_stats_start.clients_throttled && l_stats.conn_rejected >= 1
+                   && l_stats.clients_tracked >= 2, "Counters");
+    dap_test_msg("Flood %.1f s: %d served, %d rejected; other client latency %.2f ms avg, %.2f ms max (%.2f / %.2f ms without flood)",
+                 l_time, l_state.ok, l_state.throttled, l_flood_avg, l_flood_max, l_base_avg, l_base_max);
+    // Latency of the victim is not affected by the rejected flood much
+    dap_assert_PIF(l_flood_max < 100, "Other client latency is kept");
+    dap_pass_msg("Request rate limit");
+}
+
+// Addresses over the table size are served with no limits
+static void s_clients_max_test(dap_server_t *a_server)
+{
+    dap_server_limits_t l_limits = { .request_rate = 1, .request_burst = 1, .clients_max = 1 };
+    dap_assert_PIF(!dap_server_limits_set(a_server, &l_limits), "Tracked addresses cap is set");
+    dap_server_limits_stats_t l_stats_start, l_stats;
+    dap_server_limits_stats_get(a_server, &l_stats_start);
+    s_request_from(TEST_ABUSER);
+    int l_served = 0;
+    for (int i = 0; i < 3; i++)
+        l_served += s_request_from(TEST_NEWCOMER) == Http_Status_OK;
+    dap_server_limits_stats_get(a_server, &l_stats);
+    dap_assert_PIF(l_served == 3 && l_stats.clients_overflow - l_stats_start.clients_overflow == 3
+                   && l_stats.clients_tracked <= dap_max(l_stats_start.clients_tracked, 1U), "New address over the cap is not tracked");
+    dap_pass_msg("Tracked addresses cap");
+}
+
+void dap_http_rate_limit_test_run(void)
+{
+    dap_print_module_name("dap_server_limits");
+    dap_server_t *l_server = dap_http_test_server()->server;
+    dap_assert_PIF(dap_http_simple_proc_add(dap_http_test_server(), "/limits", 1024, s_reply_callback), "URL proc is added");
+    s_connection_quota_test(l_server);
+    s_request_rate_test(l_server);
+    s_clients_max_test(l_server);
+    dap_server_limits_set(l_server, NULL);
+    dap_assert_PIF(s_request_from(TEST_ABUSER) == Http_Status_OK, "Limits are removed");
+}
@@ -0,0 +1,162 @@
+#include "dap_http_router_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_http_simple.h"
+#include "http_status_code.h"
+
+#define TEST_ROUTES_GROUPS      200                                         /* Four routes in each */
+#define TEST_LOOKUPS            2000000
+
+static dap_http_url_proc_t *s_add(dap_http_server_t *a_http, const char *a_pattern)
+{
+    return dap_http_add_proc(a_http, a_pattern, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+}
+
+// Finds the route and checks processor and its url_path
+static bool s_find(dap_http_server_t *a_http, const char *a_method, const char *a_path, dap_http_url_proc_t *a_proc, const char *a_url_path,
+                   dap_http_route_match_t *a_match)
+{
+    return dap_http_route_find(a_http, a_method, a_path, strlen(a_path), a_match) == DAP_HTTP_ROUTE_FOUND && a_match->proc == a_proc
+            && a_match->path_len == strlen(a_url_path) && !strncmp(a_match->path, a_url_path, a_match->path_len);
+}
+
+static bool s_param(dap_http_route_match_t *a_match, uint8_t a_idx, const char *a_name, const char *a_value)
+{
+    return a_idx < a_match->params_count && !strcmp(a_match->params[a_idx].name, a_name)
+            && a_match->params[a_idx].value_len == strlen(a_value) && !strncmp(a_match->params[a_idx].value, a_value, strlen(a_value));
+}
+
+static void s_http_free(dap_http_server_t *a_http)
+{
+    dap_http_url_proc_t *l_proc, *l_tmp;
+    HASH_ITER(hh, a_http->url_proc, l_proc, l_tmp) {
+        HASH_DEL(a_http->url_proc, l_proc);
+        DAP_DELETE(l_proc);
+    }
+    dap_http_routes_delete(a_http);
+}
+
+static void s_match_test()
+{
+    dap_http_server_t l_http = { };
+    dap_http_route_match_t l_match;
+    dap_http_url_proc_t *l_legacy = s_add(&l_http, "/enc_init"), *l_root = s_add(&l_http, "/"),
+                        *l_user_get = s_add(&l_http, "GET,HEAD /users/:id"), *l_user_post = s_add(&l_http, "POST /users/:id"),
+                        *l_me = s_add(&l_http, "/users/me"), *l_posts = s_add(&l_http, "GET /users/:id/posts/:post"),
+                        *l_static = s_add(&l_http, "/static/*"), *l_img = s_add(&l_http, "GET /static/img/*");
+    dap_assert_PIF(l_legacy && l_root && l_user_get && l_user_post && l_me && l_posts && l_static && l_img, "Routes are added");
+
+    dap_assert_PIF(s_find(&l_http, "GET", "/enc_init", l_legacy, "enc_init", &l_match)
+                   && s_find(&l_http, "POST", "/enc_init/gd4y5yh78w42aaagh", l_legacy, "gd4y5yh78w42aaagh", &l_match)
+                   && s_find(&l_http, "GET", "/enc_init/", l_legacy, "", &l_match)
+                   && dap_http_route_find(&l_http, "GET", "/enc_init/a/b", 12, &l_match) == DAP_HTTP_ROUTE_NOT_FOUND,
+                   "Plain path gets its last segment and single segment below");
+    dap_assert_PIF(s_find(&l_http, "GET", "/", l_root, "/", &l_match)
+                   && dap_http_route_find(&l_http, "GET", "/other", 6, &l_match) == DAP_HTTP_ROUTE_NOT_FOUND, "Root path");
+
+    dap_assert_PIF(s_find(&l_http, "GET", "/users/42", l_user_get, "/users/42", &l_match) && l_match.params_count == 1
+                   && s_param(&l_match, 0, "id", "42") && s_find(&l_http, "HEAD", "/users/42", l_user_get, "/users/42", &l_match)
+                   && s_find(&l_http, "POST", "/users/42", l_user_post, "/users/42", &l_match), "Per-method handlers");
+    dap_assert_PIF(dap_http_route_find(&l_http, "DELETE", "/users/42", 9, &l_match) == DAP_HTTP_ROUTE_METHOD_NOT_ALLOWED, "Method not allowed");
+    char l_allow[64];
+    dap_http_route_methods_str(l_match.methods_allowed, l_allow, sizeof(l_allow));
+    dap_assert_PIF(!strcmp(l_allow, "GET, HEAD, POST"), "Allowed methods");
+    dap_assert_PIF(dap_http_route_find(&l_http, "GET", "/users/", 7, &l_match) == DAP_HTTP_ROUTE_NOT_FOUND, "Parameter is not empty");
+
+    dap_assert_PIF(s_find(&l_http, "DELETE", "/users/me", l_me, "me", &l_match) && !l_match.params_count, "Static segment wins");
+    dap_assert_PIF(s_find(&l_http, "GET", "/users/me/posts/7", l_posts, "/users/me/posts/7", &l_match) && l_match.params_count == 2
+                   && s_param(&l_match, 0, "id", "me") && s_param(&l_match, 1, "post", "7"), "Parameter after static dead end");
+
+    dap_assert_PIF(s_find(&l_http, "GET", "/static/css/site.css", l_static, "css/site.css", &l_match)
+                   && s_find(&l_http, "GET", "/static", l_static, "", &l_match)
+                   && s_find(&l_http, "GET", "/static/img/a/b.png", l_img, "a/b.png", &l_match)
+                   && s_find(&l_http, "POST", "/static/img/a/b.png", l_static, "img/a/b.png", &l_match), "Longest prefix wins");
+    dap_assert_PIF(dap_http_route_find(&l_http, "GET", "/static/../etc/passwd", 21, &l_match) == DAP_HTTP_ROUTE_NOT_FOUND
+                   && dap_http_route_find(&l_http, "GET", "/enc_init/..", 12, &l_match) == DAP_HTTP_ROUTE_NOT_FOUND, "Parent directory");
+
+    dap_assert_PIF(!s_add(&l_http, "/users/me") && !s_add(&l_http, "GET /users/:id") && !s_add(&l_http, "/users/:uid/x")
+                   && !s_add(&l_http, "/a/*/b") && !s_add(&l_http, "FOO /x") && !s_add(&l_http, "GET") && !s_add(&l_http, "/a/:"),
+                   "Conflicting and invalid routes are rejected");
+    dap_assert_PIF(s_find(&l_http, "GET", "/users/42", l_user_get, "/users/42", &l_match), "Routes are kept after rejects");
+    s_http_free(&l_http);
+    dap_pass_msg("Route matching");
+}
+
+static void s_lookup_benchmark()
+{
+    dap_http_server_t l_http = { };
+    char l_path[128];
+    bool l_ok = true;
+    for (int i = 0; i < TEST_ROUTES_GROUPS; i++) {
+        snprintf(l_path, sizeof(l_path), "/legacy%d", i);
+        l_ok &= !!s_add(&l_http, l_path);
+        snprintf(l_path, sizeof(l_path), "GET /api/v1/res%d/:id", i);
+        l_ok &= !!s_add(&l_http, l_path);
+        snprintf(l_path, sizeof(l_path), "GET,POST /api/v1/res%d/:id/items/:item", i);
+        l_ok &= !!s_add(&l_http, l_path);
+        snprintf(l_path, sizeof(l_path), "/files%d/*", i);
+        l_ok &= !!s_add(&l_http, l_path);
+    }
+    dap_assert_PIF(l_ok && HASH_COUNT(l_http.url_proc) == TEST_ROUTES_GROUPS * 4, "Routes are added");
+
+    static const char *s_formats[] = { "/legacy%d/target", "/api/v1/res%d/12345", "/api/v1/res%d/12345/items/678", "/files%d/a/b/c/file.txt" };
+    dap_http_route_match_t l_match;
+    int l_found = 0, l_start = get_cur_time_msec();
+    for (int i = 0; i < TEST_LOOKUPS; i++) {
+        int l_len = snprintf(l_path, sizeof(l_path), s_formats[i % 4], (i / 4) % TEST_ROUTES_GROUPS);
+        l_found += dap_http_route_find(&l_http, "GET", l_path, l_len, &l_match) == DAP_HTTP_ROUTE_FOUND;
+    }
+    int l_time = get_cur_time_msec() - l_start;
+    dap_assert_PIF(l_found == TEST_LOOKUPS, "All paths are routed");
+    dap_test_msg("%d routes, %.0f lookups/s (path formatting included)", TEST_ROUTES_GROUPS * 4,
+                 TEST_LOOKUPS / (dap_max(l_time, 1) / 1000.0));
+    s_http_free(&l_http);
+}
+
+static void s_user_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    dap_http_client_t *l_client = a_http_simple->http_client;
+    dap_strncpy(a_http_simple->reply_mime, "text/plain", sizeof(a_http_simple->reply_mime));
+    const char *l_id = dap_http_client_route_param(l_client, "id");
+    dap_http_simple_reply_f(a_http_simple, "user=%s path=%s", l_id ? l_id : "-", l_client->url_path);
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+// One request over a new connection, returns status code and the body
+static int s_request(const char *a_method, const char *a_path, char *a_body, size_t a_body_size)
+{
+    char l_request[1024];
+    snprintf(l_request, sizeof(l_request), "%s %s HTTP/1.1\r\nHost: localhost\r\nContent-Length: 0\r\n\r\n", a_method, a_path);
+    dap_http_test_reply_t l_reply;
+    if (dap_http_test_request(l_request, &l_reply))
+        return dap_http_test_reply_free(&l_reply), -2;
+    // Headers are returned for error replies
+    dap_strncpy(a_body, l_reply.code == Http_Status_OK ? (char *)l_reply.body : l_reply.headers, a_body_size);
+    dap_http_test_reply_free(&l_reply);
+    return l_reply.code;
+}
+
+static void s_server_test()
+{
+    dap_http_server_t *l_http = dap_http_test_server();
+    dap_assert_PIF(dap_http_simple_proc_add(l_http, "GET /rt/users/:id", 1024, s_user_callback)
+                   && dap_http_simple_proc_add(l_http, "/rt/static/*", 1024, s_user_callback), "Routes are added to the server");
+    char l_body[1024];
+    dap_assert_PIF(s_request("GET", "/rt/users/42?x=1", l_body, sizeof(l_body)) == Http_Status_OK
+                   && !strcmp(l_body, "user=42 path=/rt/users/42"), "Parameter route");
+    dap_assert_PIF(s_request("GET", "/rt/static/css/site.css", l_body, sizeof(l_body)) == Http_Status_OK
+                   && !strcmp(l_body, "user=- path=css/site.css"), "Prefix route");
+    dap_assert_PIF(s_request("POST", "/rt/users/42", l_body, sizeof(l_body)) == Http_Status_MethodNotAllowed
+                   && strstr(l_body, "Allow: GET"), "405 with Allow header");
+    dap_assert_PIF(s_request("GET", "/rt/none", l_body, sizeof(l_body)) == Http_Status_NotFound, "Not found");
+    dap_pass_msg("Routed requests");
+}
+
+void dap_http_router_test_run(void)
+{
+    dap_print_module_name("dap_http_router");
+    s_match_test();
+    s_lookup_benchmark();
+    s_server_test();
+}
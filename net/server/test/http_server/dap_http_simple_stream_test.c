@@ -0,0 +1,159 @@
+#include <sys/socket.h>
+#include <unistd.h>
+#include "dap_http_simple_stream_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_http_simple.h"
+#include "http_status_code.h"
+
+#define TEST_REPLY_SIZE         (48 * 1024 * 1024)
+#define TEST_SLOW_READ          (1024 * 1024)
+#define TEST_AHEAD_MAX          (16 * 1024 * 1024)                          /* Kernel socket buffers and output buffer */
+
+typedef struct stream_state {
+    size_t position, size;
+} stream_state_t;
+
+typedef struct test_conn {
+    int sock;
+    size_t size;
+    byte_t buf[65536];
+} test_conn_t;
+
+static volatile size_t s_produced;
+
+static inline byte_t s_byte(size_t a_pos)
+{
+    return (byte_t)((a_pos * 2654435761u) >> 7);
+}
+
+static ssize_t s_stream_callback(dap_http_simple_t *a_http_simple, void *a_buf, size_t a_buf_size)
+{
+    stream_state_t *l_state = a_http_simple->_inheritor;
+    size_t l_size = dap_min(a_buf_size, l_state->size - l_state->position);
+    for (size_t i = 0; i < l_size; i++)
+        ((byte_t *)a_buf)[i] = s_byte(l_state->position + i);
+    l_state->position += l_size;
+    s_produced = l_state->position;
+    return l_size;
+}
+
+static void s_stream_proc_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    stream_state_t *l_state = a_http_simple->_inheritor = DAP_NEW_Z(stream_state_t);
+    l_state->size = strtoull(a_http_simple->http_client->in_query_string, NULL, 10);
+    dap_strncpy(a_http_simple->reply_mime, "application/octet-stream", sizeof(a_http_simple->reply_mime));
+    dap_http_simple_reply_stream(a_http_simple, s_stream_callback);
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+static int s_read_more(test_conn_t *a_conn)
+{
+    if (a_conn->size == sizeof(a_conn->buf))
+        return -1;
+    ssize_t l_read = recv(a_conn->sock, a_conn->buf + a_conn->size, sizeof(a_conn->buf) - a_conn->size, 0);
+    if (l_read <= 0)
+        return -1;
+    a_conn->size += l_read;
+    return 0;
+}
+
+static void s_consume(test_conn_t *a_conn, size_t a_size)
+{
+    a_conn->size -= a_size;
+    memmove(a_conn->buf, a_conn->buf + a_size, a_conn->size);
+}
+
+static byte_t *s_line(test_conn_t *a_conn)
+{
+    byte_t *l_eol;
+    while (!(l_eol = memmem(a_conn->buf, a_conn->size, "\r\n", 2)))
+        if (s_read_more(a_conn))
+            return NULL;
+    *l_eol = '\0';
+    return l_eol + 2;
+}
+
+// Reads chunked reply and checks its body, slow reader stops for a while after a_pause_at bytes
+static int s_stream_read(test_conn_t *a_conn, size_t a_size, size_t a_pause_at, size_t *a_ahead)
+{
+    byte_t *l_end;
+    while (!(l_end = memmem(a_conn->buf, a_conn->size, "\r\n\r\n", 4)))
+        if (s_read_more(a_conn))
+            return -1;
+    *l_end = '\0';
+    int l_code = 0;
+    if (sscanf((char *)a_conn->buf, "HTTP/1.1 %d", &l_code) != 1 || l_code != Http_Status_OK
+            || !strcasestr((char *)a_conn->buf, "Transfer-Encoding: chunked") || strcasestr((char *)a_conn->buf, "Content-Length"))
+        return -2;
+    s_consume(a_conn, l_end + 4 - a_conn->buf);
+    size_t l_received = 0;
+    for (;;) {
+        byte_t *l_data = s_line(a_conn);
+        if (!l_data)
+            return -3;
+        size_t l_chunk = strtoull((char *)a_conn->buf, NULL, 16);
+        s_consume(a_conn, l_data - a_conn->buf);
+        if (!l_chunk)
+            break;
+        while (l_chunk) {
+            if (!a_conn->size && s_read_more(a_conn))
+                return -4;
+            size_t l_part = dap_min(l_chunk, a_conn->size);
+            for (size_t i = 0; i < l_part; i++)
+                if (a_conn->buf[i] != s_byte(l_received + i))
+                    return -5;
+            if (l_received < a_pause_at && l_received + l_part >= a_pause_at) {
+                usleep(300000);
+                *a_ahead = s_produced - (l_received + l_part);
+            }
+            l_received += l_part;
+            l_chunk -= l_part;
+            s_consume(a_conn, l_part);
+        }
+        if (!s_line(a_conn) || a_conn->buf[0])
+            return -6;
+        s_consume(a_conn, 2);
+    }
+    // Empty trailer
+    byte_t *l_next = s_line(a_conn);
+    if (!l_next || a_conn->buf[0])
+        return -7;
+    s_consume(a_conn, 2);
+    return l_received == a_size ? 0 : -8;
+}
+
+void dap_http_simple_stream_test_run(void)
+{
+    dap_print_module_name("dap_http_simple_stream");
+    // Reply buffer is tiny, body is produced by the stream callback
+    dap_assert_PIF(dap_http_simple_proc_add(dap_http_test_server(), "/stream", 16, s_stream_proc_callback), "URL proc is added");
+
+    test_conn_t *l_conn = DAP_NEW_Z(test_conn_t);
+    dap_assert_PIF((l_conn->sock = dap_http_test_connect()) >= 0, "Connect");
+    char l_request[256];
+    int l_len = snprintf(l_request, sizeof(l_request), "GET /stream?%d HTTP/1.1\r\nHost: localhost\r\nConnection: Keep-Alive\r\n\r\n",
+                         TEST_REPLY_SIZE);
+    size_t l_ahead = 0;
+    int l_start = get_cur_time_msec();
+    dap_assert_PIF(send(l_conn->sock, l_request, l_len, MSG_NOSIGNAL) == l_len
+                   && !s_stream_read(l_conn, TEST_REPLY_SIZE, TEST_SLOW_READ, &l_ahead), "Streamed reply is received");
+    int l_time = get_cur_time_msec() - l_start - 300;
+    // Producer waits for the client instead of buffering the whole reply
+    dap_assert_PIF(l_ahead < TEST_AHEAD_MAX, "Reply is produced as the client reads it");
+    dap_test_msg("48 MB streamed reply %7.1f MB/s, producer was %zu KB ahead of slow reader",
+                 (double)TEST_REPLY_SIZE / (1024 * 1024) / (dap_max(l_time, 1) / 1000.0), l_ahead / 1024);
+
+    // Connection is kept after chunked reply, empty body is the last chunk only
+    l_len = snprintf(l_request, sizeof(l_request), "GET /stream?%d HTTP/1.1\r\nHost: localhost\r\nConnection: Keep-Alive\r\n\r\n"
+                                                   "GET /stream?0 HTTP/1.1\r\nHost: localhost\r\n\r\n", 100000);
+    dap_assert_PIF(send(l_conn->sock, l_request, l_len, MSG_NOSIGNAL) == l_len
+                   && !s_stream_read(l_conn, 100000, 0, &l_ahead) && !s_stream_read(l_conn, 0, 0, &l_ahead),
+                   "Pipelined streamed replies");
+    char l_byte;
+    dap_assert_PIF(!l_conn->size && !recv(l_conn->sock, &l_byte, 1, 0), "Connection is closed after the last reply");
+    close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    dap_pass_msg("Streamed reply");
+}
@@ -0,0 +1,287 @@
+#include <unistd.h>
+#include "dap_http_simple_upload_test.h"
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_events_socket.h"
+#include "dap_http_simple.h"
+#include "http_status_code.h"
+
+#define TEST_UPLOAD_SIZE        ((size_t)64 * 1024 * 1024)
+#define TEST_SEND_PART          ((size_t)1024 * 1024)
+#define TEST_LIMIT              ((size_t)1024 * 1024)
+#define TEST_BUFFERED_SIZE      ((size_t)3 * 1024 * 1024 + 17)
+
+typedef struct upload_state {
+    uint64_t hash;
+    size_t size, chunks, chunk_max;
+} upload_state_t;
+
+typedef struct test_reply {
+    int code;
+    bool continue_sent;
+    char body[256];
+} test_reply_t;
+
+static byte_t *s_data;
+
+static uint64_t s_fnv1a(uint64_t a_hash, const byte_t *a_data, size_t a_size)
+{
+    for (size_t i = 0; i < a_size; i++)
+        a_hash = (a_hash ^ a_data[i]) * 0x100000001b3ULL;
+    return a_hash;
+}
+
+static http_status_code_t s_chunk_callback(dap_http_simple_t *a_http_simple, const void *a_data, size_t a_data_size)
+{
+    upload_state_t *l_state = a_http_simple->_inheritor;
+    if (!l_state) {
+        if (a_data_size >= 6 && !memcmp(a_data, "REJECT", 6))
+            return Http_Status_Forbidden;
+        l_state = a_http_simple->_inheritor = DAP_NEW_Z(upload_state_t);
+        l_state->hash = 0xcbf29ce484222325ULL;
+    }
+    l_state->hash = s_fnv1a(l_state->hash, a_data, a_data_size);
+    l_state->size += a_data_size;
+    l_state->chunks++;
+    l_state->chunk_max = dap_max(l_state->chunk_max, a_data_size);
+    return Http_Status_OK;
+}
+
+static void s_upload_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    upload_state_t *l_state = a_http_simple->_inheritor, l_empty = { .hash = 0xcbf29ce484222325ULL };
+    if (!l_state)
+        l_state = &l_empty;
+    dap_http_simple_reply_f(a_http_simple, "%zu:%016"DAP_UINT64_FORMAT_x":%zu:%zu:%d", l_state->size, l_state->hash,
+                            l_state->chunks, l_state->chunk_max, a_http_simple->request != NULL);
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+static void s_buffered_callback(dap_http_simple_t *a_http_simple, void *a_arg)
+{
+    dap_http_simple_reply_f(a_http_simple, "%zu:%016"DAP_UINT64_FORMAT_x, a_http_simple->request_size,
+                            s_fnv1a(0xcbf29ce484222325ULL, a_http_simple->request_byte, a_http_simple->request_size));
+    *(http_status_code_t *)a_arg = Http_Status_OK;
+}
+
+static int s_send_chunk(int a_sock, const byte_t *a_data, size_t a_size, const char *a_ext)
+{
+    char l_line[64];
+    int l_len = snprintf(l_line, sizeof(l_line), "%zx%s\r\n", a_size, a_ext);
+    return dap_http_test_send(a_sock, l_line, l_len) || dap_http_test_send(a_sock, a_data, a_size)
+            || dap_http_test_send(a_sock, "\r\n", 2);
+}
+
+// Reads one final reply with its body, interim 100 Continue is skipped
+static int s_reply_read(int a_sock, test_reply_t *a_reply)
+{
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    if (!l_conn)
+        return -1;
+    l_conn->sock = a_sock;
+    dap_http_test_reply_t l_reply;
+    int l_ret = dap_http_test_reply_read(l_conn, &l_reply);
+    *a_reply = (test_reply_t) { .code = l_reply.code, .continue_sent = l_reply.interim_code == Http_Status_Continue };
+    if (l_reply.body)
+        snprintf(a_reply->body, sizeof(a_reply->body), "%s", (char *)l_reply.body);
+    dap_http_test_reply_free(&l_reply);
+    DAP_DELETE(l_conn);
+    return l_ret;
+}
+
+static double s_upload(const char *a_url, bool a_chunked, test_reply_t *a_reply)
+{
+    int l_sock = dap_http_test_connect();
+    dap_assert_PIF(l_sock >= 0, "Connect");
+    char l_request[256];
+    int l_len = a_chunked
+            ? snprintf(l_request, sizeof(l_request), "POST %s HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n", a_url)
+            : snprintf(l_request, sizeof(l_request), "POST %s HTTP/1.1\r\nHost: localhost\r\nContent-Length: %zu\r\n\r\n",
+                       a_url, TEST_UPLOAD_SIZE);
+    int l_start = get_cur_time_msec();
+    bool l_ok = !dap_http_test_send(l_sock, l_request, l_len);
+    if (a_chunked) {
+        // Chunk sizes don't match socket buffer boundaries, some have extensions
+        static const size_t s_sizes[] = { 1, 100, 4095, 70001, 1000000 };
+        size_t l_sent = 0;
+        for (int i = 0; l_ok && l_sent < TEST_UPLOAD_SIZE; i++) {
+            size_t l_chunk = dap_min(s_sizes[i % 5], TEST_UPLOAD_SIZE - l_sent);
+            l_ok = !s_send_chunk(l_sock, s_data + l_sent, l_chunk, i % 2 ? ";ext=1" : "");
+            l_sent += l_chunk;
+        }
+        l_ok = l_ok && !dap_http_test_send(l_sock, "0\r\nX-Trailer: 1\r\n\r\n", 20);
+    } else
+        for (size_t l_sent = 0; l_ok && l_sent < TEST_UPLOAD_SIZE; l_sent += TEST_SEND_PART)
+            l_ok = !dap_http_test_send(l_sock, s_data + l_sent, TEST_SEND_PART);
+    l_ok = l_ok && !s_reply_read(l_sock, a_reply);
+    int l_time = get_cur_time_msec() - l_start;
+    close(l_sock);
+    dap_assert_PIF(l_ok, "Upload");
+    return (double)TEST_UPLOAD_SIZE / (1024 * 1024) / (dap_max(l_time, 1) / 1000.0);
+}
+
+static void s_streaming_test()
+{
+    char l_expected[128];
+    snprintf(l_expected, sizeof(l_expected), "%zu:%016"DAP_UINT64_FORMAT_x":", TEST_UPLOAD_SIZE,
+             s_fnv1a(0xcbf29ce484222325ULL, s_data, TEST_UPLOAD_SIZE));
+    const char *l_mode[] = { "Content-Length", "chunked" };
+    for (int i = 0; i < 2; i++) {
+        test_reply_t l_reply;
+        double l_speed = s_upload("/upload/put", i, &l_reply);
+        size_t l_chunks = 0, l_chunk_max = 0;
+        int l_buffered = 1;
+        sscanf(l_reply.body + strlen(l_expected), "%zu:%zu:%d", &l_chunks, &l_chunk_max, &l_buffered);
+        dap_assert_PIF(l_reply.code == Http_Status_OK && !strncmp(l_reply.body, l_expected, strlen(l_expected)), l_mode[i]);
+        // Body is never collected whole, server gets it by input buffer pieces
+        dap_assert_PIF(!l_buffered && l_chunks > 1 && l_chunk_max <= DAP_EVENTS_SOCKET_BUF_SIZE, "Body is streamed");
+        dap_test_msg("%-14s 64 MB upload %7.1f MB/s, %zu pieces up to %zu bytes", l_mode[i], l_speed, l_chunks, l_chunk_max);
+    }
+    dap_pass_msg("Streaming upload");
+}
+
+static void s_buffered_test()
+{
+    int l_sock = dap_http_test_connect();
+    dap_assert_PIF(l_sock >= 0, "Connect");
+    const char l_request[] = "POST /upbuf/put HTTP/1.1\r\nHost: localhost\r\nConnection: Keep-Alive\r\nTransfer-Encoding: chunked\r\n\r\n";
+    bool l_ok = !dap_http_test_send(l_sock, l_request, sizeof(l_request) - 1);
+    for (size_t l_sent = 0, l_chunk; l_ok && l_sent < TEST_BUFFERED_SIZE; l_sent += l_chunk) {
+        l_chunk = dap_min(l_sent % 3 ? (size_t)65536 + 3 : 1000, TEST_BUFFERED_SIZE - l_sent);
+        l_ok = !s_send_chunk(l_sock, s_data + l_sent, l_chunk, "");
+    }
+    test_reply_t l_reply;
+    char l_expected[128];
+    snprintf(l_expected, sizeof(l_expected), "%zu:%016"DAP_UINT64_FORMAT_x, TEST_BUFFERED_SIZE,
+             s_fnv1a(0xcbf29ce484222325ULL, s_data, TEST_BUFFERED_SIZE));
+    dap_assert_PIF(l_ok && !dap_http_test_send(l_sock, "0\r\n\r\n", 5) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_OK && !strcmp(l_reply.body, l_expected), "Chunked body is collected");
+
+    // Connection is kept after chunked body
+    const char l_next[] = "POST /upbuf/put HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nabcde";
+    snprintf(l_expected, sizeof(l_expected), "5:%016"DAP_UINT64_FORMAT_x, s_fnv1a(0xcbf29ce484222325ULL, (const byte_t *)"abcde", 5));
+    dap_assert_PIF(!dap_http_test_send(l_sock, l_next, sizeof(l_next) - 1) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_OK && !strcmp(l_reply.body, l_expected), "Next request after chunked body");
+    close(l_sock);
+    dap_pass_msg("Buffered chunked body");
+}
+
+static void s_limit_test()
+{
+    // Content-Length over the limit is rejected before the body is sent
+    int l_sock = dap_http_test_connect();
+    char l_request[256];
+    int l_len = snprintf(l_request, sizeof(l_request), "POST /upsmall/put HTTP/1.1\r\nHost: localhost\r\n"
+                                                       "Content-Length: %zu\r\nExpect: 100-continue\r\n\r\n", TEST_LIMIT + 1);
+    test_reply_t l_reply;
+    dap_assert_PIF(l_sock >= 0 && !dap_http_test_send(l_sock, l_request, l_len) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_PayloadTooLarge && !l_reply.continue_sent, "Content-Length over the limit");
+    close(l_sock);
+
+    // Body under the limit gets 100 Continue
+    l_sock = dap_http_test_connect();
+    l_len = snprintf(l_request, sizeof(l_request), "POST /upsmall/put HTTP/1.1\r\nHost: localhost\r\n"
+                                                   "Content-Length: %zu\r\nExpect: 100-continue\r\n\r\n", TEST_LIMIT);
+    dap_assert_PIF(l_sock >= 0 && !dap_http_test_send(l_sock, l_request, l_len) && !dap_http_test_send(l_sock, s_data, TEST_LIMIT)
+                   && !s_reply_read(l_sock, &l_reply) && l_reply.code == Http_Status_OK && l_reply.continue_sent, "Body at the limit");
+    close(l_sock);
+
+    // Chunked body is cut as soon as it grows over the limit
+    l_sock = dap_http_test_connect();
+    l_len = snprintf(l_request, sizeof(l_request), "POST /upsmall/put HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n");
+    dap_http_test_send(l_sock, l_request, l_len);
+    for (size_t l_sent = 0; l_sent <= TEST_LIMIT && !s_send_chunk(l_sock, s_data + l_sent, 65536, ""); l_sent += 65536)
+        ;
+    dap_assert_PIF(!s_reply_read(l_sock, &l_reply) && l_reply.code == Http_Status_PayloadTooLarge, "Chunked body over the limit");
+    close(l_sock);
+
+    // Chunk callback rejects the body
+    l_sock = dap_http_test_connect();
+    const char l_reject[] = "POST /upsmall/put HTTP/1.1\r\nHost: localhost\r\nContent-Length: 10\r\n\r\nREJECT....";
+    dap_assert_PIF(!dap_http_test_send(l_sock, l_reject, sizeof(l_reject) - 1) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_Forbidden, "Body is rejected by chunk callback");
+    close(l_sock);
+
+    // Broken chunked framing
+    l_sock = dap_http_test_connect();
+    const char l_broken[] = "POST /upload/put HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n";
+    dap_assert_PIF(!dap_http_test_send(l_sock, l_broken, sizeof(l_broken) - 1) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_BadRequest, "Broken chunk size");
+    close(l_sock);
+    dap_pass_msg("Request body limits");
+}
+
+static void s_framing_test()
+{
+    // Body length is unknown unless "chunked" is the last transfer coding or Content-Length is a single number,
+    // both lengths given is a smuggling attempt
+    static const char *s_rejected[] = {
+        "Transfer-Encoding: gzip\r\n",
+        "Transfer-Encoding: chunked, gzip\r\n",
+        "Transfer-Encoding: chunked\r\nContent-Length: 5\r\n",
+        "Content-Length: 0\r\nTransfer-Encoding: chunked\r\n",
+        "Content-Length: -1\r\n",
+        "Content-Length: 5, 10\r\n",
+        "Content-Length: 5x\r\n",
+        "Content-Length: 99999999999999999999999\r\n",
+        "Content-Length: 5\r\nContent-Length: 6\r\n"
+    };
+    char l_request[256];
+    test_reply_t l_reply;
+    bool l_ok = true;
+    for (size_t i = 0; i < sizeof(s_rejected) / sizeof(*s_rejected) && l_ok; i++) {
+        int l_sock = dap_http_test_connect();
+        int l_len = snprintf(l_request, sizeof(l_request), "POST /upbuf/put HTTP/1.1\r\nHost: localhost\r\n%s\r\n"
+                                                           "5\r\nabcde\r\n0\r\n\r\n", s_rejected[i]);
+        l_ok = l_sock >= 0 && !dap_http_test_send(l_sock, l_request, l_len) && !s_reply_read(l_sock, &l_reply)
+                && l_reply.code == Http_Status_BadRequest;
+        close(l_sock);
+    }
+    dap_assert_PIF(l_ok, "Ambiguous body length is rejected");
+
+    // Field names are case-insensitive, the last of several codings is the transfer one
+    int l_sock = dap_http_test_connect();
+    const char l_chunked[] = "POST /upbuf/put HTTP/1.1\r\nHost: localhost\r\ntransfer-encoding: identity, Chunked\r\n\r\n"
+                             "5\r\nabcde\r\n0\r\n\r\n";
+    char l_expected[128];
+    snprintf(l_expected, sizeof(l_expected), "5:%016"DAP_UINT64_FORMAT_x, s_fnv1a(0xcbf29ce484222325ULL, (const byte_t *)"abcde", 5));
+    dap_assert_PIF(l_sock >= 0 && !dap_http_test_send(l_sock, l_chunked, sizeof(l_chunked) - 1) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_OK && !strcmp(l_reply.body, l_expected), "Chunked is the last coding");
+    close(l_sock);
+
+    // Repeated Content-Length with the same value is the same length
+    l_sock = dap_http_test_connect();
+    const char l_repeated[] = "POST /upbuf/put HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\nContent-Length: 5 \r\n\r\nabcde";
+    dap_assert_PIF(l_sock >= 0 && !dap_http_test_send(l_sock, l_repeated, sizeof(l_repeated) - 1) && !s_reply_read(l_sock, &l_reply)
+                   && l_reply.code == Http_Status_OK && !strcmp(l_reply.body, l_expected), "Repeated Content-Length");
+    close(l_sock);
+
+    // Buffered chunked body is capped even if the processor has no limit
+    l_sock = dap_http_test_connect();
+    const char l_unlimited[] = "POST /upbuf/put HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n";
+    dap_http_test_send(l_sock, l_unlimited, sizeof(l_unlimited) - 1);
+    for (size_t l_sent = 0; l_sent <= DAP_HTTP_SIMPLE_CHUNKED_REQUEST_LIMIT && l_sent < TEST_UPLOAD_SIZE
+                            && !s_send_chunk(l_sock, s_data + l_sent, TEST_SEND_PART, ""); l_sent += TEST_SEND_PART)
+        ;
+    dap_assert_PIF(!s_reply_read(l_sock, &l_reply) && l_reply.code == Http_Status_PayloadTooLarge, "Default chunked body limit");
+    close(l_sock);
+    dap_pass_msg("Request body framing");
+}
+
+void dap_http_simple_upload_test_run(void)
+{
+    dap_print_module_name("dap_http_simple_upload");
+    s_data = DAP_NEW_Z_SIZE(byte_t, TEST_UPLOAD_SIZE);
+    for (size_t i = 0; i < TEST_UPLOAD_SIZE; i++)
+        s_data[i] = (byte_t)((i * 2654435761u) >> 11);
+    dap_http_server_t *l_server = dap_http_test_server();
+    dap_assert_PIF(dap_http_simple_proc_add_streaming(l_server, "/upload", 256, 0, s_chunk_callback, s_upload_callback)
+                   && dap_http_simple_proc_add_streaming(l_server, "/upsmall", 256, TEST_LIMIT, s_chunk_callback, s_upload_callback)
+                   && dap_http_simple_proc_add(l_server, "/upbuf", 256, s_buffered_callback), "URL procs are added");
+
+    s_streaming_test();
+    s_buffered_test();
+    s_limit_test();
+    s_framing_test();
+    DAP_DELETE(s_data);
+}
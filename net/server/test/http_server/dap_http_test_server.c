@@ -0,0 +1,267 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "dap_http_test_server.h"
+#include "dap_common.h"
+#include "dap_strfuncs.h"
+#include "dap_config.h"
+#include "http_status_code.h"
+#include "dap_events.h"
+#include "dap_server.h"
+
+static char s_dir[] = "/tmp/dap_http_test_XXXXXX";
+static dap_server_t *s_server;
+static uint16_t s_port;
+
+int dap_http_test_server_start(void)
+{
+    char l_path[128];
+    if (!mkdtemp(s_dir))
+        return -1;
+    snprintf(l_path, sizeof(l_path), "%s/test.cfg", s_dir);
+    FILE *l_file = fopen(l_path, "w");
+    if (!l_file)
+        return -2;
+    fputs("[http_test]\n"
+          "listen-address=[127.0.0.1:0]\n"
+          "[http]\n"
+          "keep_alive_timeout=1\n"
+          "keep_alive_requests_max=200\n", l_file);
+    fclose(l_file);
+    dap_config_init(s_dir);
+    g_config = dap_config_open("test");
+
+    if (dap_events_init(1, 60) || dap_events_start())
+        return -3;
+    dap_http_init();
+    s_server = dap_http_server_new("http_test", "test");
+    if (!s_server || !s_server->es_listeners)
+        return -4;
+    struct sockaddr_in l_addr;
+    socklen_t l_addr_len = sizeof(l_addr);
+    getsockname(((dap_events_socket_t *)s_server->es_listeners->data)->socket, (struct sockaddr *)&l_addr, &l_addr_len);
+    s_port = ntohs(l_addr.sin_port);
+    return 0;
+}
+
+void dap_http_test_server_stop(void)
+{
+    // Worker contexts free themselves on exit, so events are only stopped here
+    dap_events_stop_all();
+    dap_config_close(g_config);
+    g_config = NULL;
+    char l_path[128];
+    snprintf(l_path, sizeof(l_path), "%s/test.cfg", s_dir);
+    unlink(l_path);
+    rmdir(s_dir);
+}
+
+dap_http_server_t *dap_http_test_server(void)
+{
+    return s_server ? DAP_HTTP_SERVER(s_server) : NULL;
+}
+
+uint16_t dap_http_test_server_port(void)
+{
+    return s_port;
+}
+
+const char *dap_http_test_server_dir(void)
+{
+    return s_dir;
+}
+
+int dap_http_test_connect(void)
+{
+    return dap_http_test_connect_from(NULL);
+}
+
+int dap_http_test_connect_from(const char *a_src_addr)
+{
+    int l_sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in l_addr = { .sin_family = AF_INET, .sin_port = htons(s_port), .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    struct timeval l_timeout = { .tv_sec = 10 };
+    setsockopt(l_sock, SOL_SOCKET, SO_RCVTIMEO, &l_timeout, sizeof(l_timeout));
+    if (a_src_addr) {
+        struct sockaddr_in l_src = { .sin_family = AF_INET };
+        inet_pton(AF_INET, a_src_addr, &l_src.sin_addr);
+        if (bind(l_sock, (struct sockaddr *)&l_src, sizeof(l_src))) {
+            close(l_sock);
+            return -1;
+        }
+    }
+    if (connect(l_sock, (struct sockaddr *)&l_addr, sizeof(l_addr))) {
+        close(l_sock);
+        return -1;
+    }
+    return l_sock;
+}
+
+int dap_http_test_send(int a_sock, const void *a_data, size_t a_size)
+{
+    for (size_t l_sent = 0; l_sent < a_size; ) {
+        ssize_t l_ret = send(a_sock, (const byte_t *)a_data + l_sent, a_size - l_sent, MSG_NOSIGNAL);
+        if (l_ret <= 0)
+            return -1;
+        l_sent += l_ret;
+    }
+    return 0;
+}
+
+static ssize_t s_conn_recv(dap_http_test_conn_t *a_conn)
+{
+    if (a_conn->size >= sizeof(a_conn->buf) - 1)
+        return -1;
+    ssize_t l_read = recv(a_conn->sock, a_conn->buf + a_conn->size, sizeof(a_conn->buf) - 1 - a_conn->size, 0);
+    if (l_read > 0)
+        a_conn->buf[a_conn->size += l_read] = '\0';
+    return l_read;
+}
+
+static void s_conn_consume(dap_http_test_conn_t *a_conn, dap_http_test_reply_t *a_reply, size_t a_size)
+{
+    a_conn->size -= a_size;
+    memmove(a_conn->buf, a_conn->buf + a_size, a_conn->size);
+    a_conn->buf[a_conn->size] = '\0';
+    a_reply->wire_size += a_size;
+}
+
+// Reads a line, returns its length with CRLF or 0 if connection is closed before
+static size_t s_conn_line(dap_http_test_conn_t *a_conn)
+{
+    char *l_eol;
+    while (!(l_eol = memmem(a_conn->buf, a_conn->size, "\r\n", 2)))
+        if (s_conn_recv(a_conn) <= 0)
+            return 0;
+    return l_eol + 2 - a_conn->buf;
+}
+
+// Appends body piece of known size, or everything till connection close if a_size is SIZE_MAX
+static int s_body_read(dap_http_test_conn_t *a_conn, dap_http_test_reply_t *a_reply, size_t a_size)
+{
+    size_t l_capacity = a_reply->body_size + (a_size == SIZE_MAX ? dap_max(a_conn->size, sizeof(a_conn->buf)) : a_size);
+    if (!(a_reply->body = DAP_REALLOC(a_reply->body, l_capacity + 1)))
+        return -1;
+    size_t l_left = a_size, l_part = dap_min(a_conn->size, l_left);
+    memcpy(a_reply->body + a_reply->body_size, a_conn->buf, l_part);
+    a_reply->body_size += l_part;
+    l_left -= l_part;
+    s_conn_consume(a_conn, a_reply, l_part);
+    while (l_left) {
+        if (a_reply->body_size == l_capacity) {
+            l_capacity *= 2;
+            if (!(a_reply->body = DAP_REALLOC(a_reply->body, l_capacity + 1)))
+                return -1;
+        }
+        ssize_t l_read = recv(a_conn->sock, a_reply->body + a_reply->body_size, dap_min(l_left, l_capacity - a_reply->body_size), 0);
+        if (l_read <= 0)
+            break;
+        a_reply->body_size += l_read;
+        a_reply->wire_size += l_read;
+        if (a_size != SIZE_MAX)
+            l_left -= l_read;
+    }
+    a_reply->body[a_reply->body_size] = '\0';
+    return a_size == SIZE_MAX || !l_left ? 0 : -1;
+}
+
+static int s_chunked_body_read(dap_http_test_conn_t *a_conn, dap_http_test_reply_t *a_reply)
+{
+    for (;;) {
+        size_t l_len = s_conn_line(a_conn);
+        if (!l_len)
+            return -1;
+        char *l_end = NULL;
+        size_t l_chunk = strtoul(a_conn->buf, &l_end, 16);
+        if (l_end == a_conn->buf)
+            return -1;
+        s_conn_consume(a_conn, a_reply, l_len);
+        if (!l_chunk)
+            break;
+        if (s_body_read(a_conn, a_reply, l_chunk) || s_conn_line(a_conn) != 2)
+            return -1;
+        s_conn_consume(a_conn, a_reply, 2);
+    }
+    // Trailer fields up to the empty line
+    for (size_t l_len; (l_len = s_conn_line(a_conn)); ) {
+        s_conn_consume(a_conn, a_reply, l_len);
+        if (l_len == 2)
+            return 0;
+    }
+    return -1;
+}
+
+int dap_http_test_reply_read(dap_http_test_conn_t *a_conn, dap_http_test_reply_t *a_reply)
+{
+    *a_reply = (dap_http_test_reply_t) { };
+    for (;;) {
+        char *l_end;
+        while (!(l_end = memmem(a_conn->buf, a_conn->size, "\r\n\r\n", 4)))
+            if (s_conn_recv(a_conn) <= 0)
+                return -1;
+        size_t l_headers_size = l_end + 4 - a_conn->buf;
+        if (sscanf(a_conn->buf, "HTTP/1.1 %d", &a_reply->code) != 1 || l_headers_size - 2 > sizeof(a_reply->headers))
+            return -2;
+        if (a_reply->code >= 100 && a_reply->code < 200) {
+            a_reply->interim_code = a_reply->code;
+            s_conn_consume(a_conn, a_reply, l_headers_size);
+            continue;
+        }
+        memcpy(a_reply->headers, a_conn->buf, l_headers_size - 2);
+        a_reply->headers[l_headers_size - 2] = '\0';
+        s_conn_consume(a_conn, a_reply, l_headers_size);
+        break;
+    }
+    char l_value[64];
+    if (a_reply->code == Http_Status_NoContent || a_reply->code == Http_Status_NotModified)
+        return s_body_read(a_conn, a_reply, 0);
+    if (dap_http_test_reply_header(a_reply, "Transfer-Encoding", l_value, sizeof(l_value)))
+        return s_chunked_body_read(a_conn, a_reply) ? -3 : 0;
+    if (dap_http_test_reply_header(a_reply, "Content-Length", l_value, sizeof(l_value)))
+        return s_body_read(a_conn, a_reply, strtoull(l_value, NULL, 10)) ? -3 : 0;
+    return s_body_read(a_conn, a_reply, SIZE_MAX);
+}
+
+void dap_http_test_reply_free(dap_http_test_reply_t *a_reply)
+{
+    DAP_DEL_Z(a_reply->body);
+}
+
+const char *dap_http_test_reply_header(dap_http_test_reply_t *a_reply, const char *a_name, char *a_value, size_t a_value_size)
+{
+    const char *l_cp = a_reply->headers;
+    size_t l_name_len = strlen(a_name);
+    while ((l_cp = strstr(l_cp, "\r\n"))) {
+        l_cp += 2;
+        if (!strncasecmp(l_cp, a_name, l_name_len) && l_cp[l_name_len] == ':') {
+            l_cp += l_name_len + 1;
+            l_cp += strspn(l_cp, " \t");
+            snprintf(a_value, a_value_size, "%.*s", (int)strcspn(l_cp, "\r"), l_cp);
+            return a_value;
+        }
+    }
+    return NULL;
+}
+
+int dap_http_test_request(const char *a_request, dap_http_test_reply_t *a_reply)
+{
+    *a_reply = (dap_http_test_reply_t) { };
+    dap_http_test_conn_t *l_conn = DAP_NEW_Z(dap_http_test_conn_t);
+    if (!l_conn)
+        return -1;
+    int l_ret = (l_conn->sock = dap_http_test_connect()) < 0 ? -1
+              : dap_http_test_send(l_conn->sock, a_request, strlen(a_request)) ? -1
+              : dap_http_test_reply_read(l_conn, a_reply);
+    if (l_conn->sock >= 0)
+        close(l_conn->sock);
+    DAP_DELETE(l_conn);
+    return l_ret;
+}
+
+double dap_http_test_time_sec(clockid_t a_clock)
+{
+    struct timespec l_ts;
+    clock_gettime(a_clock, &l_ts);
+    return l_ts.tv_sec + l_ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <time.h>
+#include "dap_test.h"
+#include "dap_http_server.h"
+
+// HTTP server on loopback with ephemeral port, shared by the tests which need real connections
+int dap_http_test_server_start(void);
+void dap_http_test_server_stop(void);
+
+dap_http_server_t *dap_http_test_server(void);
+uint16_t dap_http_test_server_port(void);
+const char *dap_http_test_server_dir(void);
+
+// Blocking connection to the test server with receive timeout
+int dap_http_test_connect(void);
+// The same from the given loopback source address, e.g. "127.0.0.2", to act as another client
+int dap_http_test_connect_from(const char *a_src_addr);
+
+// Blocking connection with input buffer, rest of input is kept for the next reply
+typedef struct dap_http_test_conn {
+    int sock;
+    size_t size;
+    char buf[65536];
+} dap_http_test_conn_t;
+
+typedef struct dap_http_test_reply {
+    int code;
+    int interim_code;                                                       /* Last 1xx reply before the final one */
+    size_t wire_size;                                                       /* Headers and body as they came */
+    char headers[4096];                                                     /* Status line and headers */
+    byte_t *body;                                                           /* Dechunked, null-terminated */
+    size_t body_size;
+} dap_http_test_reply_t;
+
+// Sends all the data, returns 0 if ok
+int dap_http_test_send(int a_sock, const void *a_data, size_t a_size);
+// Reads one final reply, its body is delimited by Content-Length, chunked encoding or connection close
+int dap_http_test_reply_read(dap_http_test_conn_t *a_conn, dap_http_test_reply_t *a_reply);
+void dap_http_test_reply_free(dap_http_test_reply_t *a_reply);
+// Header value of the reply or NULL if there is no such header
+const char *dap_http_test_reply_header(dap_http_test_reply_t *a_reply, const char *a_name, char *a_value, size_t a_value_size);
+// Sends raw request over a new connection and reads the reply
+int dap_http_test_request(const char *a_request, dap_http_test_reply_t *a_reply);
+
+// Clock value in seconds, e.g. CLOCK_MONOTONIC for wall time or CLOCK_PROCESS_CPUTIME_ID for CPU time
+double dap_http_test_time_sec(clockid_t a_clock);
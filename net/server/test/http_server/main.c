@@ -1,11 +1,34 @@
 #include "dap_common.h"
 #include "dap_http_user_agent_test.h"
 #include "dap_http_simple_test.h"
+#include "dap_http_folder_test.h"
+#include "dap_http_cache_test.h"
+#include "dap_http_keep_alive_test.h"
+#include "dap_http_simple_upload_test.h"
+#include "dap_http_simple_stream_test.h"
+#include "dap_http_ban_list_test.h"
+#include "dap_http_rate_limit_test.h"
+#include "dap_http_router_test.h"
+#include "dap_http_header_write_test.h"
+#include "dap_http_compress_test.h"
+#include "dap_http_test_server.h"
 
 int main(void) {
     // switch off debug info from library
     dap_log_level_set(L_CRITICAL);
     dap_http_user_agent_test_run();
     dap_http_http_simple_test_run();
+    dap_http_cache_test_run();
+    dap_assert_PIF(!dap_http_test_server_start(), "Test HTTP server start");
+    dap_http_folder_test_run();
+    dap_http_keep_alive_test_run();
+    dap_http_simple_upload_test_run();
+    dap_http_simple_stream_test_run();
+    dap_http_ban_list_test_run();
+    dap_http_rate_limit_test_run();
+    dap_http_router_test_run();
+    dap_http_header_write_test_run();
+    dap_http_compress_test_run();
+    dap_http_test_server_stop();
     return 0;
 }
@@ -244,7 +244,6 @@ size_t dap_stream_ch_pkt_write_unsafe(dap_stream_ch_t * a_ch,  uint8_t a_type, c
 
     size_t  l_ret = 0, l_data_size,
             l_max_size = l_data_size = a_data_size + sizeof(dap_stream_ch_pkt_hdr_t);
-    byte_t *l_buf = DAP_NEW_Z_SIZE(byte_t, l_max_size); /* a_ch->buf; */
 
     dap_stream_ch_pkt_hdr_t l_hdr = {
         .id         = a_ch->proc->id,
@@ -260,9 +259,8 @@ size_t dap_stream_ch_pkt_write_unsafe(dap_stream_ch_t * a_ch,  uint8_t a_type, c
 
     static const size_t l_max_fragm_size = DAP_STREAM_PKT_FRAGMENT_SIZE - DAP_STREAM_PKT_ENCRYPTION_OVERHEAD - sizeof(dap_stream_fragment_pkt_t);
     if (l_data_size > 0 && l_data_size <= l_max_fragm_size) {
-        *(dap_stream_ch_pkt_hdr_t*)l_buf = l_hdr;
-        memcpy(l_buf + sizeof(dap_stream_ch_pkt_hdr_t), a_data, a_data_size);
-        l_ret = dap_stream_pkt_write_unsafe(a_ch->stream, STREAM_PKT_TYPE_DATA_PACKET, l_buf, l_data_size);
+        // Header and data are gathered right in the stream packet buffer
+        l_ret = dap_stream_pkt_write_parts_unsafe(a_ch->stream, STREAM_PKT_TYPE_DATA_PACKET, &l_hdr, sizeof(l_hdr), a_data, a_data_size);
 #ifndef DAP_EVENTS_CAPS_IOCP
         dap_stream_ch_set_ready_to_write_unsafe(a_ch, true);
 #endif
@@ -270,18 +268,16 @@ size_t dap_stream_ch_pkt_write_unsafe(dap_stream_ch_t * a_ch,  uint8_t a_type, c
         /* The first fragment (has no memory shift) is the channel header
          The rest fragments just concatenate as-is */
         size_t l_fragment_size;
-        dap_stream_fragment_pkt_t *l_fragment;
-        for (l_fragment = (dap_stream_fragment_pkt_t*)l_buf, l_fragment_size = sizeof(dap_stream_ch_pkt_hdr_t);
+        dap_stream_fragment_pkt_t l_fragment = { .full_size = l_max_size };
+        for (l_fragment_size = sizeof(dap_stream_ch_pkt_hdr_t);
              l_data_size > 0;
              l_data_size -= l_fragment_size, l_fragment_size = dap_min(l_data_size, l_max_fragm_size))
         {
-            l_fragment->size        = l_fragment_size;
-            l_fragment->full_size   = l_max_size;
-            l_fragment->mem_shift   = l_max_size - l_data_size;
-            memcpy(l_fragment->data, l_fragment->mem_shift ? a_data + l_fragment->mem_shift - sizeof(dap_stream_ch_pkt_hdr_t) : &l_hdr,
-                   l_fragment_size);
-            l_ret += dap_stream_pkt_write_unsafe(a_ch->stream, STREAM_PKT_TYPE_FRAGMENT_PACKET, l_fragment,
-                                                  l_fragment_size + sizeof(dap_stream_fragment_pkt_t));
+            l_fragment.size         = l_fragment_size;
+            l_fragment.mem_shift    = l_max_size - l_data_size;
+            l_ret += dap_stream_pkt_write_parts_unsafe(a_ch->stream, STREAM_PKT_TYPE_FRAGMENT_PACKET, &l_fragment, sizeof(l_fragment),
+                                                       l_fragment.mem_shift ? a_data + l_fragment.mem_shift - sizeof(dap_stream_ch_pkt_hdr_t) : (const void*)&l_hdr,
+                                                       l_fragment_size);
 #ifndef DAP_EVENTS_CAPS_IOCP
             dap_stream_ch_set_ready_to_write_unsafe(a_ch, true);
 #endif
@@ -289,12 +285,10 @@ size_t dap_stream_ch_pkt_write_unsafe(dap_stream_ch_t * a_ch,  uint8_t a_type, c
     } else {
         a_ch->stat.bytes_write = 0;
         log_it(L_WARNING, "Empty pkt, seq_id %"DAP_UINT64_FORMAT_U, l_hdr.seq_id);
-        DAP_DELETE(l_buf);
         return 0;
     }
     // Statistics without header sizes
     a_ch->stat.bytes_write += a_data_size;
-    DAP_DELETE(l_buf);
     for (dap_list_t *it = a_ch->packet_out_notifiers; it; it = it->next) {
         dap_stream_ch_notifier_t *l_notifier = it->data;
         assert(l_notifier);
@@ -108,10 +108,11 @@ static bool s_callback_client_keepalive(void *a_arg);
 
 static bool s_dump_packet_headers = false;
 static bool s_debug = false;
+static dap_http_header_tpl_t *s_http_headers = NULL;                        /* Same for every stream reply */
 
 bool dap_stream_get_dump_packet_headers(){ return  s_dump_packet_headers; }
 
-static bool s_detect_loose_packet(dap_stream_t * a_stream);
+static bool s_detect_loose_packet(dap_stream_t *a_stream, dap_stream_ch_pkt_t *a_ch_pkt);
 static int s_stream_add_stream_info(dap_stream_t *a_stream, uint64_t a_id);
 
 
@@ -187,6 +188,9 @@ int dap_stream_init(dap_config_t * a_config)
 #endif
 
     s_global_links_cluster = dap_cluster_new(DAP_STREAM_CLUSTER_GLOBAL, *(dap_guuid_t *)&uint128_0, DAP_CLUSTER_TYPE_SYSTEM);
+    s_http_headers = dap_http_header_tpl_new("Content-Type", "application/octet-stream",
+                                             "Connection", "keep-alive",
+                                             "Cache-Control", "no-cache", NULL);
 
     log_it(L_NOTICE,"Init streaming module");
 
@@ -199,6 +203,8 @@ int dap_stream_init(dap_config_t * a_config)
 void dap_stream_deinit()
 {
     dap_stream_ch_deinit( );
+    dap_http_header_tpl_delete(s_http_headers);
+    s_http_headers = NULL;
 }
 
 /**
@@ -522,9 +528,7 @@ static bool s_http_client_headers_write(dap_http_client_t * a_http_client, void
     if(a_http_client->reply_status_code == Http_Status_OK){
         dap_stream_t *l_stream=DAP_STREAM(a_http_client);
 
-        dap_http_out_header_add(a_http_client,"Content-Type","application/octet-stream");
-        dap_http_out_header_add(a_http_client,"Connection","keep-alive");
-        dap_http_out_header_add(a_http_client,"Cache-Control","no-cache");
+        a_http_client->out_headers_tpl = s_http_headers;
 
         if(l_stream->stream_size>0)
             dap_http_out_header_add_f(a_http_client,"Content-Length","%u", (unsigned int) l_stream->stream_size );
@@ -700,6 +704,27 @@ size_t dap_stream_data_proc_read (dap_stream_t *a_stream)
     return l_processed_size;
 }
 
+/**
+ * @brief s_stream_pkt_decode decrypt packet payload. If session cipher works in-place, payload is decrypted
+ * right in the input buffer, otherwise it's decrypted to the packet cache
+ * @param a_stream stream
+ * @param a_pkt encrypted packet
+ * @param a_dec_size decrypted size, 0 on error
+ * @return decrypted payload
+ */
+static void *s_stream_pkt_decode(dap_stream_t *a_stream, dap_stream_pkt_t *a_pkt, size_t *a_dec_size)
+{
+    dap_enc_key_t *l_key = a_stream->session->key;
+    if ( dap_enc_key_get_inplace_headroom(l_key->type) ) {
+        *a_dec_size = dap_enc_decode_inplace(l_key, a_pkt->data, a_pkt->hdr.size);
+        return a_pkt->data;
+    }
+    size_t l_dec_size = dap_enc_decode_out_size(l_key, a_pkt->hdr.size, DAP_ENC_DATA_TYPE_RAW);
+    a_stream->pkt_cache = DAP_NEW_Z_SIZE(byte_t, l_dec_size);
+    *a_dec_size = a_stream->pkt_cache ? dap_stream_pkt_read_unsafe(a_stream, a_pkt, a_stream->pkt_cache, l_dec_size) : 0;
+    return a_stream->pkt_cache;
+}
+
 /**
  * @brief stream_proc_pkt_in
  * @param sid
@@ -712,12 +737,8 @@ static void s_stream_proc_pkt_in(dap_stream_t * a_stream, dap_stream_pkt_t *a_pk
 
     switch (a_pkt->hdr.type) {
     case STREAM_PKT_TYPE_FRAGMENT_PACKET: {
-
-        size_t l_fragm_dec_size = dap_enc_decode_out_size(a_stream->session->key, a_pkt->hdr.size, DAP_ENC_DATA_TYPE_RAW);
-        a_stream->pkt_cache = DAP_NEW_Z_SIZE(byte_t, l_fragm_dec_size);
-        dap_stream_fragment_pkt_t *l_fragm_pkt = (dap_stream_fragment_pkt_t*)a_stream->pkt_cache;
-        size_t l_dec_pkt_size = dap_stream_pkt_read_unsafe(a_stream, a_pkt, l_fragm_pkt, l_fragm_dec_size);
-
+        size_t l_dec_pkt_size;
+        dap_stream_fragment_pkt_t *l_fragm_pkt = s_stream_pkt_decode(a_stream, a_pkt, &l_dec_pkt_size);
 
         if(l_dec_pkt_size == 0) {
             debug_if(s_dump_packet_headers, L_WARNING, "Input: can't decode packet size = %zu", a_pkt_size);
@@ -759,12 +780,8 @@ static void s_stream_proc_pkt_in(dap_stream_t * a_stream, dap_stream_pkt_t *a_pk
         if (a_pkt->hdr.type == STREAM_PKT_TYPE_FRAGMENT_PACKET) {
             l_ch_pkt = (dap_stream_ch_pkt_t*)a_stream->buf_fragments;
             l_dec_pkt_size = a_stream->buf_fragments_size_total;
-        } else {
-            size_t l_pkt_dec_size = dap_enc_decode_out_size(a_stream->session->key, a_pkt->hdr.size, DAP_ENC_DATA_TYPE_RAW);
-            a_stream->pkt_cache = DAP_NEW_Z_SIZE(byte_t, l_pkt_dec_size);
-            l_ch_pkt = (dap_stream_ch_pkt_t*)a_stream->pkt_cache;
-            l_dec_pkt_size = dap_stream_pkt_read_unsafe(a_stream, a_pkt, l_ch_pkt, l_pkt_dec_size);
-        }
+        } else
+            l_ch_pkt = s_stream_pkt_decode(a_stream, a_pkt, &l_dec_pkt_size);
 
         if (l_dec_pkt_size < sizeof(l_ch_pkt->hdr)) {
             log_it(L_WARNING, "Input: decoded size %zu is lesser than size of packet header %zu", l_dec_pkt_size, sizeof(l_ch_pkt->hdr));
@@ -779,7 +796,7 @@ static void s_stream_proc_pkt_in(dap_stream_t * a_stream, dap_stream_pkt_t *a_pk
         }
 
         // If seq_id is less than previous - doomp eet
-        if (!s_detect_loose_packet(a_stream)) {
+        if (!s_detect_loose_packet(a_stream, l_ch_pkt)) {
             dap_stream_ch_t * l_ch = NULL;
             for(size_t i=0;i<a_stream->channel_count;i++){
                 if(a_stream->channel[i]->proc){
@@ -850,26 +867,23 @@ static void s_stream_proc_pkt_in(dap_stream_t * a_stream, dap_stream_pkt_t *a_pk
 /**
  * @brief _detect_loose_packet
  * @param a_stream
+ * @param a_ch_pkt decrypted channel packet
  * @return
  */
-static bool s_detect_loose_packet(dap_stream_t * a_stream) {
-    dap_stream_ch_pkt_t *l_ch_pkt = a_stream->buf_fragments_size_filled
-            ? (dap_stream_ch_pkt_t*)a_stream->buf_fragments
-            : (dap_stream_ch_pkt_t*)a_stream->pkt_cache;
-
+static bool s_detect_loose_packet(dap_stream_t *a_stream, dap_stream_ch_pkt_t *a_ch_pkt) {
     long long l_count_lost_packets =
-            l_ch_pkt->hdr.seq_id || a_stream->client_last_seq_id_packet
-            ? (long long) l_ch_pkt->hdr.seq_id - (long long) (a_stream->client_last_seq_id_packet + 1)
+            a_ch_pkt->hdr.seq_id || a_stream->client_last_seq_id_packet
+            ? (long long) a_ch_pkt->hdr.seq_id - (long long) (a_stream->client_last_seq_id_packet + 1)
             : 0;
 
     if (l_count_lost_packets) {
         log_it(L_WARNING, l_count_lost_packets > 0
                ? "Packet loss detected. Current seq_id: %"DAP_UINT64_FORMAT_U", last seq_id: %zu"
-               : "Packet replay detected, seq_id: %"DAP_UINT64_FORMAT_U, l_ch_pkt->hdr.seq_id, a_stream->client_last_seq_id_packet);
+               : "Packet replay detected, seq_id: %"DAP_UINT64_FORMAT_U, a_ch_pkt->hdr.seq_id, a_stream->client_last_seq_id_packet);
     }
     debug_if(s_debug, L_DEBUG, "Current seq_id: %"DAP_UINT64_FORMAT_U", last: %zu",
-                                l_ch_pkt->hdr.seq_id, a_stream->client_last_seq_id_packet);
-    a_stream->client_last_seq_id_packet = l_ch_pkt->hdr.seq_id;
+                                a_ch_pkt->hdr.seq_id, a_stream->client_last_seq_id_packet);
+    a_stream->client_last_seq_id_packet = a_ch_pkt->hdr.seq_id;
     return l_count_lost_packets < 0;
 }
 
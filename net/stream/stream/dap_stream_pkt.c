@@ -52,19 +52,56 @@ size_t dap_stream_pkt_read_unsafe( dap_stream_t * a_stream, dap_stream_pkt_t * a
  * @return
  */
 
-size_t dap_stream_pkt_write_unsafe(dap_stream_t *a_stream, uint8_t a_type, const void *a_data, size_t a_data_size)
+/**
+ * @brief dap_stream_pkt_write_parts_unsafe write packet made of two parts, e.g. channel header and its payload.
+ * If session cipher works in-place, the parts are put right into packet buffer and encrypted there
+ * @param a_stream stream
+ * @param a_type packet type
+ * @param a_head first part
+ * @param a_head_size first part size
+ * @param a_data second part
+ * @param a_data_size second part size
+ * @return bytes written to esocket
+ */
+size_t dap_stream_pkt_write_parts_unsafe(dap_stream_t *a_stream, uint8_t a_type, const void *a_head, size_t a_head_size,
+                                         const void *a_data, size_t a_data_size)
 {
-    if (a_data_size > DAP_STREAM_PKT_FRAGMENT_SIZE)
-        return log_it(L_ERROR, "Too big fragment size %zu", a_data_size), 0;
+    size_t l_data_size = a_head_size + a_data_size;
+    if (l_data_size > DAP_STREAM_PKT_FRAGMENT_SIZE)
+        return log_it(L_ERROR, "Too big fragment size %zu", l_data_size), 0;
     static _Thread_local char s_pkt_buf[DAP_STREAM_PKT_FRAGMENT_SIZE + sizeof(dap_stream_pkt_hdr_t) + 0x40] = { 0 };
     a_stream->is_active = true;
     dap_enc_key_t *l_key = a_stream->session->key;
-    size_t l_full_size = dap_enc_key_get_enc_size(l_key->type, a_data_size) + sizeof(dap_stream_pkt_hdr_t);
+    size_t l_full_size = dap_enc_key_get_enc_size(l_key->type, l_data_size) + sizeof(dap_stream_pkt_hdr_t),
+           l_headroom = dap_enc_key_get_inplace_headroom(l_key->type), l_enc_size = 0;
+    char *l_enc_buf = s_pkt_buf + sizeof(dap_stream_pkt_hdr_t);
+    if ( l_headroom ) {
+        if (a_head_size)
+            memcpy(l_enc_buf + l_headroom, a_head, a_head_size);
+        if (a_data_size)
+            memcpy(l_enc_buf + l_headroom + a_head_size, a_data, a_data_size);
+        l_enc_size = dap_enc_code_inplace(l_key, l_enc_buf, l_data_size, l_full_size - sizeof(dap_stream_pkt_hdr_t));
+    } else if ( !a_data_size || !a_head_size ) {
+        l_enc_size = dap_enc_code(l_key, a_head_size ? a_head : a_data, l_data_size, l_enc_buf,
+                                  l_full_size - sizeof(dap_stream_pkt_hdr_t), DAP_ENC_DATA_TYPE_RAW);
+    } else {
+        char *l_buf = DAP_NEW_Z_SIZE(char, l_data_size);
+        if (!l_buf)
+            return log_it(L_CRITICAL, "%s", c_error_memory_alloc), 0;
+        memcpy(l_buf, a_head, a_head_size);
+        memcpy(l_buf + a_head_size, a_data, a_data_size);
+        l_enc_size = dap_enc_code(l_key, l_buf, l_data_size, l_enc_buf, l_full_size - sizeof(dap_stream_pkt_hdr_t), DAP_ENC_DATA_TYPE_RAW);
+        DAP_DELETE(l_buf);
+    }
     dap_stream_pkt_hdr_t *l_pkt_hdr = (dap_stream_pkt_hdr_t*)s_pkt_buf;
-    *l_pkt_hdr = (dap_stream_pkt_hdr_t) { .size = dap_enc_code( l_key, a_data, a_data_size, s_pkt_buf + sizeof(*l_pkt_hdr),
-                                                                l_full_size - sizeof(*l_pkt_hdr), DAP_ENC_DATA_TYPE_RAW ),
+    *l_pkt_hdr = (dap_stream_pkt_hdr_t) { .size = l_enc_size,
                                           .timestamp = dap_time_now(), .type = a_type,
                                           .src_addr = g_node_addr.uint64, .dst_addr = a_stream->node.uint64 };
     memcpy(l_pkt_hdr->sig, c_dap_stream_sig, sizeof(l_pkt_hdr->sig));
     return dap_events_socket_write_unsafe(a_stream->esocket, s_pkt_buf, l_full_size);
 }
+
+size_t dap_stream_pkt_write_unsafe(dap_stream_t *a_stream, uint8_t a_type, const void *a_data, size_t a_data_size)
+{
+    return dap_stream_pkt_write_parts_unsafe(a_stream, a_type, a_data, a_data_size, NULL, 0);
+}
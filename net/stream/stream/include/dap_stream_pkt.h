@@ -68,6 +68,8 @@ dap_stream_pkt_t * dap_stream_pkt_detect(void * a_data, size_t data_size);
 size_t dap_stream_pkt_read_unsafe(dap_stream_t * a_stream, dap_stream_pkt_t * a_pkt, void * a_buf_out, size_t a_buf_out_size);
 
 size_t dap_stream_pkt_write_unsafe(dap_stream_t * a_stream, uint8_t a_type, const void * data, size_t a_data_size);
+size_t dap_stream_pkt_write_parts_unsafe(dap_stream_t *a_stream, uint8_t a_type, const void *a_head, size_t a_head_size,
+                                         const void *a_data, size_t a_data_size);
 
 void dap_stream_send_keepalive( dap_stream_t * a_stream);
 